@@ -9,6 +9,7 @@ build_root=$(cd "${script_dir}/../.." && pwd)
 log_dir=$build_root
 run_e2e_tests=OFF
 run_longhaul_tests=OFF
+run_perf_tests=OFF
 build_amqp=ON
 build_http=ON
 build_mqtt=ON
@@ -22,6 +23,7 @@ make=true
 toolchainfile=" "
 cmake_install_prefix=" "
 no_logging=OFF
+use_message_compression=OFF
 wip_use_c2d_amqp_methods=OFF
 
 usage ()
@@ -33,6 +35,7 @@ usage ()
     echo " --run-e2e-tests               run the end-to-end tests (e2e tests are skipped by default)"
     echo " --run-unittests               run the unit tests"
     echo " --run-longhaul-tests          run long haul tests (long haul tests are not run by default)"
+    echo " --run-perf-tests              build and run the loopback performance benchmarks (results in perf_results.jsonl)"
     echo ""
     echo " --no-amqp                     do no build AMQP transport and samples"
     echo " --no-http                     do no build HTTP transport and samples"
@@ -45,6 +48,7 @@ usage ()
     echo " --build-javawrapper           build java C wrapper module"
     echo " -rv, --run_valgrind           will execute ctest with valgrind"
     echo " --no-logging                  Disable logging"
+    echo " --use-message-compression     build the event payload compression (OPTION_MESSAGE_COMPRESSION, requires zlib)"
     echo " --wip-use-c2d-amqp-methods    Builds with work in progress feature for amqp methods"
     exit 1
 }
@@ -87,10 +91,12 @@ process_args ()
               "--run-e2e-tests" ) run_e2e_tests=ON;;
               "--run-unittests" ) run_unittests=ON;;
               "--run-longhaul-tests" ) run_longhaul_tests=ON;;
+              "--run-perf-tests" ) run_perf_tests=ON;;
               "--no-amqp" ) build_amqp=OFF;;
               "--no-http" ) build_http=OFF;;
               "--no-mqtt" ) build_mqtt=OFF;;
               "--no_uploadtoblob" ) no_blob=ON;;
+              "--use-message-compression" ) use_message_compression=ON;;
               "--no-make" ) make=false;;
               "--build-python" ) save_next_arg=3;;
               "--build-javawrapper" ) build_javawrapper=ON;;
@@ -121,7 +127,7 @@ process_args $*
 rm -r -f $build_folder
 mkdir -p $build_folder
 pushd $build_folder
-cmake $toolchainfile $cmake_install_prefix -Drun_valgrind:BOOL=$run_valgrind -DcompileOption_C:STRING="$extracloptions" -Drun_e2e_tests:BOOL=$run_e2e_tests -Drun_longhaul_tests=$run_longhaul_tests -Duse_amqp:BOOL=$build_amqp -Duse_http:BOOL=$build_http -Duse_mqtt:BOOL=$build_mqtt -Ddont_use_uploadtoblob:BOOL=$no_blob -Drun_unittests:BOOL=$run_unittests -Dbuild_python:STRING=$build_python -Dbuild_javawrapper:BOOL=$build_javawrapper -Dno_logging:BOOL=$no_logging $build_root -Dwip_use_c2d_amqp_methods:BOOL=$wip_use_c2d_amqp_methods
+cmake $toolchainfile $cmake_install_prefix -Drun_valgrind:BOOL=$run_valgrind -DcompileOption_C:STRING="$extracloptions" -Drun_e2e_tests:BOOL=$run_e2e_tests -Drun_longhaul_tests=$run_longhaul_tests -Drun_perf_tests:BOOL=$run_perf_tests -Duse_amqp:BOOL=$build_amqp -Duse_http:BOOL=$build_http -Duse_mqtt:BOOL=$build_mqtt -Ddont_use_uploadtoblob:BOOL=$no_blob -Drun_unittests:BOOL=$run_unittests -Dbuild_python:STRING=$build_python -Dbuild_javawrapper:BOOL=$build_javawrapper -Dno_logging:BOOL=$no_logging -Duse_message_compression:BOOL=$use_message_compression $build_root -Dwip_use_c2d_amqp_methods:BOOL=$wip_use_c2d_amqp_methods
 
 if [ "$make" = true ]
 then
@@ -156,6 +162,12 @@ then
   else
     ctest -j $CORES -C "Debug" --output-on-failure
   fi
+
+  if [ "$run_perf_tests" == "ON" ]
+  then
+    # Benchmarks run one at a time so they do not compete for CPU
+    make perf
+  fi
 fi
 
 popd
@@ -49,6 +49,49 @@ DEFINE_ENUM(BLOB_RESULT, BLOB_RESULT_VALUES)
 */
 MOCKABLE_FUNCTION(, BLOB_RESULT, Blob_UploadFromSasUri,const char*, SASURI, const unsigned char*, source, size_t, size, unsigned int*, httpStatus, BUFFER_HANDLE, httpResponse, const char*, certificates)
 
+#define BLOB_BLOCK_MD5_SIZE 16
+
+typedef struct BLOB_BLOCK_TAG
+{
+    int isUploaded;
+    unsigned char md5[BLOB_BLOCK_MD5_SIZE];
+} BLOB_BLOCK;
+
+/**
+* @brief    Blocks of a blob already uploaded (Put Block) but not yet committed (Put Block List), kept by the caller of
+*           Blob_UploadResumableFromSasUri between attempts. A BLOB_UPLOAD_PROGRESS set to 0 holds no upload.
+*/
+typedef struct BLOB_UPLOAD_PROGRESS_TAG
+{
+    char* SASURI;       /*the URI of the last attempt; the blob is identified by the URI without its query (the SAS token)*/
+    size_t size;
+    size_t blockCount;
+    BLOB_BLOCK* blocks;
+} BLOB_UPLOAD_PROGRESS;
+
+/**
+* @brief	Synchronously uploads a byte array to blob storage in blocks of 4MB, sending the MD5 of every block as its
+*           Content-MD5, and resumes the upload recorded in @p progress if it is for the same blob and size: a block
+*           uploaded by a previous attempt is not uploaded again if its content still has the same MD5.
+*
+* @param	SASURI	        The URI to use to upload data
+* @param	source		    A pointer to the byte array to be uploaded (can be NULL, but then size needs to be zero)
+* @param	size		    The size of the data to be uploaded (can be 0)
+* @param    httpStatus      A pointer to an out argument receiving the HTTP status (available only when the return value is BLOB_OK)
+* @param    httpResponse    A BUFFER_HANDLE that receives the HTTP response from the server (available only when the return value is BLOB_OK)
+* @param    certificates    A null terminated string containing CA certificates to be used
+* @param    progress        The blocks uploaded by the previous attempts; updated as blocks are uploaded, and cleared
+*                           once the block list is committed
+*
+* @return	A @c BLOB_RESULT. BLOB_OK means the blob has been uploaded, or that the storage answered with @p httpStatus. Any other value indicates an error
+*/
+MOCKABLE_FUNCTION(, BLOB_RESULT, Blob_UploadResumableFromSasUri, const char*, SASURI, const unsigned char*, source, size_t, size, unsigned int*, httpStatus, BUFFER_HANDLE, httpResponse, const char*, certificates, BLOB_UPLOAD_PROGRESS*, progress)
+
+/**
+* @brief	Frees what @p progress holds and sets it to 0, so that the next upload starts from the first block
+*/
+MOCKABLE_FUNCTION(, void, Blob_ClearUploadProgress, BLOB_UPLOAD_PROGRESS*, progress)
+
 #ifdef __cplusplus
 }
 #endif
@@ -112,6 +112,12 @@ extern "C"
     *			@b NOTE: The application behavior is undefined if the user calls
     *			the ::IoTHubClient_Destroy function from within any callback.
     *
+    *			@b NOTE: Unless the client was created with a shared transport,
+    *			the message is cloned and queued for the worker thread, so
+    *			IOTHUB_CLIENT_OK means it was accepted for submission. Failing
+    *			to submit it later is reported to @p eventConfirmationCallback
+    *			with IOTHUB_CLIENT_CONFIRMATION_ERROR.
+    *
     * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_SendEventAsync, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
@@ -210,6 +216,18 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_GetLastMessageReceiveTime, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, time_t*, lastMessageReceiveTime);
 
+    /**
+    * @brief	This function copies in the out parameter @p statistics the counters,
+    * 			gauges and send latency percentiles of the client. See
+    * 			::IoTHubClient_LL_GetStatistics.
+    *
+    * @param	iotHubClientHandle				The handle created by a call to the create function.
+    * @param	statistics              		Out parameter receiving the snapshot.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_GetStatistics, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATISTICS*, statistics);
+
     /**
     * @brief	This API sets a runtime option identified by parameter @p optionName
     * 			to a value pointed to by @p value. @p optionName and the data type
@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_CALLBACK_EXECUTOR_H
+#define IOTHUB_CLIENT_CALLBACK_EXECUTOR_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Pool of threads running the user callbacks of IoTHubClient instances (see OPTION_CALLBACK_EXECUTOR), so that a slow
+// callback does not hold up the worker thread of its client.
+// Tasks are submitted to a lane, identified by an owner (the client) and a lane number (the callback category). Tasks
+// of one lane run one at a time, in the order they were submitted; tasks of different lanes run concurrently.
+// callback_executor_submit() blocks while `max_pending_tasks` tasks are queued or running, which slows down the
+// clients producing callbacks faster than the application consumes them.
+
+typedef struct CALLBACK_EXECUTOR_INSTANCE_TAG* CALLBACK_EXECUTOR_HANDLE;
+
+typedef void(*CALLBACK_EXECUTOR_TASK_FUNCTION)(void* context);
+
+MOCKABLE_FUNCTION(, CALLBACK_EXECUTOR_HANDLE, callback_executor_create, size_t, thread_count, size_t, max_pending_tasks);
+// Runs the tasks still queued, then stops and joins the threads.
+MOCKABLE_FUNCTION(, void, callback_executor_destroy, CALLBACK_EXECUTOR_HANDLE, executor);
+MOCKABLE_FUNCTION(, int, callback_executor_submit, CALLBACK_EXECUTOR_HANDLE, executor, const void*, owner, size_t, lane, CALLBACK_EXECUTOR_TASK_FUNCTION, task_function, void*, task_context);
+// Waits until no task of `owner` is queued or running. Must not be called from a task of `owner`.
+MOCKABLE_FUNCTION(, void, callback_executor_drain, CALLBACK_EXECUTOR_HANDLE, executor, const void*, owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_CALLBACK_EXECUTOR_H
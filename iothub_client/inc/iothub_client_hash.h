@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_HASH_H
+#define IOTHUB_CLIENT_HASH_H
+
+#include <stdint.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 32 bit FNV-1a of a string, used by the transports to spread the work of different devices (SAS token refresh times,
+// poll schedules) and to index the pending TWIN operations. It is cheap and well distributed, not a cryptographic hash.
+
+// Returns the FNV-1a of the characters of `text` before its terminating '\0'; a NULL `text` hashes as "".
+MOCKABLE_FUNCTION(, uint32_t, hash_fnv1a, const char*, text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_HASH_H
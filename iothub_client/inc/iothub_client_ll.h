@@ -45,7 +45,8 @@ DEFINE_ENUM(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
     IOTHUB_CLIENT_RETRY_LINEAR_BACKOFF,      \
     IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF,                 \
     IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER,                 \
-    IOTHUB_CLIENT_RETRY_RANDOM
+    IOTHUB_CLIENT_RETRY_RANDOM,                 \
+    IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER
 
 /** @brief Enumeration passed in by the IoT Hub when the event confirmation
 *		   callback is invoked to indicate status of the event processing in
@@ -56,6 +57,9 @@ DEFINE_ENUM(IOTHUB_CLIENT_RETRY_POLICY, IOTHUB_CLIENT_RETRY_POLICY_VALUES);
 struct IOTHUBTRANSPORT_CONFIG_TAG;
 typedef struct IOTHUBTRANSPORT_CONFIG_TAG IOTHUBTRANSPORT_CONFIG;
 
+struct IOTHUB_CLIENT_STATISTICS_TAG;
+typedef struct IOTHUB_CLIENT_STATISTICS_TAG IOTHUB_CLIENT_STATISTICS;
+
 typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG* IOTHUB_CLIENT_LL_HANDLE;
 
 #define IOTHUB_CLIENT_STATUS_VALUES       \
@@ -225,6 +229,72 @@ extern "C"
         const char* deviceSasToken;
     } IOTHUB_CLIENT_DEVICE_CONFIG;
 
+    /** @brief	This struct is a snapshot of the runtime statistics of an IoTHubClient_LL
+    *			instance, filled in by ::IoTHubClient_LL_GetStatistics. Counters start at 0
+    *			when the handle is created and only grow. Latencies are in milliseconds,
+    *			measured from ::IoTHubClient_LL_SendEventAsync until the transport
+    *			confirms the event with @c IOTHUB_CLIENT_CONFIRMATION_OK. */
+    struct IOTHUB_CLIENT_STATISTICS_TAG
+    {
+        /** @brief	Events accepted by ::IoTHubClient_LL_SendEventAsync. */
+        uint64_t events_enqueued;
+
+        /** @brief	Events confirmed with @c IOTHUB_CLIENT_CONFIRMATION_OK. */
+        uint64_t events_confirmed;
+
+        /** @brief	Events completed with @c IOTHUB_CLIENT_CONFIRMATION_ERROR. */
+        uint64_t events_failed;
+
+        /** @brief	Events completed with @c IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT. */
+        uint64_t events_timed_out;
+
+        /** @brief	Events completed by the transport with @c IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY. */
+        uint64_t events_destroyed;
+
+        /** @brief	Gauge: events that no transport has picked up yet. */
+        size_t events_waiting_to_send;
+
+        /** @brief	Gauge: events picked up by the transport and not yet completed. */
+        size_t events_in_flight;
+
+        /** @brief	Cloud-to-device messages handed to the client by the transport. */
+        uint64_t messages_received;
+
+        /** @brief	Device method invocations handed to the client by the transport. */
+        uint64_t methods_invoked;
+
+        /** @brief	Reported states accepted by ::IoTHubClient_LL_SendReportedState. */
+        uint64_t reported_states_sent;
+
+        /** @brief	Reported states acknowledged by the service. */
+        uint64_t reported_states_completed;
+
+        /** @brief	Transitions to @c IOTHUB_CLIENT_CONNECTION_AUTHENTICATED. Every transition after the first one is a reconnect. */
+        uint64_t connections_established;
+
+        /** @brief	Transitions from @c IOTHUB_CLIENT_CONNECTION_AUTHENTICATED to @c IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED. */
+        uint64_t connections_lost;
+
+        /** @brief	Number of send latencies recorded. The fields below are 0 while this is 0. */
+        uint64_t send_latency_count;
+        uint64_t send_latency_min_ms;
+        uint64_t send_latency_max_ms;
+        uint64_t send_latency_mean_ms;
+
+        /** @brief	Percentiles of the send latency. They are read from a log-linear histogram
+        *			with 4 buckets per power of two, so each value is an upper bound that is
+        *			at most 25% above the exact percentile. */
+        uint64_t send_latency_p50_ms;
+        uint64_t send_latency_p90_ms;
+        uint64_t send_latency_p99_ms;
+        uint64_t send_latency_p999_ms;
+
+        /** @brief	TLS handshakes of the transport that resumed a cached TLS session (hits) or found none to resume (misses).
+        *			The counters are shared by all the clients of a shared transport, and stay 0 on transports without a TLS session cache. */
+        uint64_t tls_session_cache_hits;
+        uint64_t tls_session_cache_misses;
+    };
+
     /** @brief	This struct captures IoTHub transport configuration. */
     struct IOTHUBTRANSPORT_CONFIG_TAG
     {
@@ -404,6 +474,18 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetLastMessageReceiveTime, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, time_t*, lastMessageReceiveTime);
 
+    /**
+    * @brief	This function copies in the out parameter @p statistics the counters,
+    * 			gauges and send latency percentiles of the client. The statistics are
+    * 			always collected; reading them does not allocate and does not reset them.
+    *
+    * @param	iotHubClientHandle				The handle created by a call to the create function.
+    * @param	statistics              		Out parameter receiving the snapshot.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetStatistics, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATISTICS*, statistics);
+
     /**
     * @brief	This function is meant to be called by the user when work
     * 			(sending/receiving) can be done by the IoTHubClient.
@@ -0,0 +1,28 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_MD5_H
+#define IOTHUB_CLIENT_MD5_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// MD5 (RFC 1321) of the blocks uploaded to Azure Storage, sent as their Content-MD5 so that the service rejects a block
+// corrupted on the way, and kept to check that a block uploaded before an interruption still has the same content.
+// It is an integrity check against transmission errors only, not a cryptographic hash.
+
+#define IOTHUB_CLIENT_MD5_SIZE 16
+
+// Writes the IOTHUB_CLIENT_MD5_SIZE bytes of the digest of `data` to `digest`. Returns 0 on success.
+MOCKABLE_FUNCTION(, int, md5_compute, const unsigned char*, data, size_t, size, unsigned char*, digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_MD5_H
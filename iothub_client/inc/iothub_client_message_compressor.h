@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_MESSAGE_COMPRESSOR_H
+#define IOTHUB_CLIENT_MESSAGE_COMPRESSOR_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "iothub_message.h"
+#include "iothub_client_options.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Compresses the payload of the events sent by IoTHubClient_LL with zlib (see OPTION_MESSAGE_COMPRESSION), before
+// any transport encodes them, and sets their content encoding so that the receiver knows how to inflate them.
+// The compressor keeps its deflate state and output buffer from one message to the next. It is not thread-safe: the
+// client serializes the calls.
+
+typedef struct MESSAGE_COMPRESSOR_TAG* MESSAGE_COMPRESSOR_HANDLE;
+
+// Copies `options`; fails if the content encoding is neither "gzip" nor "deflate", the level is out of range, or a
+// dictionary is given for "gzip".
+MOCKABLE_FUNCTION(, MESSAGE_COMPRESSOR_HANDLE, message_compressor_create, const IOTHUB_MESSAGE_COMPRESSION_OPTIONS*, options);
+MOCKABLE_FUNCTION(, void, message_compressor_destroy, MESSAGE_COMPRESSOR_HANDLE, compressor);
+// Returns a new message with the compressed payload and the system and application properties of `message`, or NULL
+// if `message` is to be sent as it is (already encoded, below the size threshold, not made smaller, or on failure).
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, message_compressor_compress, MESSAGE_COMPRESSOR_HANDLE, compressor, IOTHUB_MESSAGE_HANDLE, message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_MESSAGE_COMPRESSOR_H
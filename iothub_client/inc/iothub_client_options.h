@@ -31,8 +31,70 @@ extern "C"
 
     static const char* OPTION_MIN_POLLING_TIME = "MinimumPollingTime";
     static const char* OPTION_BATCHING = "Batching";
+    /*
+    * @brief Shortest time in milliseconds (unsigned int) between 2 C2D polls of a device on the HTTP transport, enabling adaptive polling.
+    *        A device polls again right after receiving a message, and doubles its interval after every empty poll up to
+    *        OPTION_MIN_POLLING_TIME. The default, 0, polls at most once every OPTION_MIN_POLLING_TIME.
+    */
+    static const char* OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS = "c2d_adaptive_polling_min_interval_ms";
+    /*
+    * @brief Number of keep-alive connections (size_t) the HTTP transport uses to send events of all its devices concurrently.
+    *        The default, 0, sends every request on the single blocking HTTPAPIEX connection, one after the other.
+    */
+    static const char* OPTION_HTTP_CONNECTION_POOL_SIZE = "http_connection_pool_size";
+
+    /*
+    * @brief CALLBACK_EXECUTOR_HANDLE (see iothub_client_callback_executor.h) whose threads run the user callbacks of an
+    *        IoTHubClient (not IoTHubClient_LL) instance, instead of its worker thread. Callbacks of one category (e.g. all the
+    *        device method callbacks) still run one at a time and in order. The executor can be shared by several clients, can
+    *        be set only once and must be destroyed after them.
+    */
+    static const char* OPTION_CALLBACK_EXECUTOR = "callback_executor";
 
     static const char* OPTION_MESSAGE_TIMEOUT = "messageTimeout";
+
+    typedef struct IOTHUB_RECONNECT_ADMISSION_OPTIONS_TAG
+    {
+        /* Reconnections admitted per second; 0 admits every reconnection (the default). */
+        unsigned int reconnects_per_sec;
+        /* Reconnections admitted at once, e.g. when many clients lose their connection together; must not be 0. */
+        unsigned int burst_size;
+    } IOTHUB_RECONNECT_ADMISSION_OPTIONS;
+
+    /*
+    * @brief IOTHUB_RECONNECT_ADMISSION_OPTIONS limiting how fast the AMQP and MQTT clients of the process reconnect, so that
+    *        an outage does not make all of them reconnect at once. The rate is shared by all the clients, whichever client
+    *        it is set on. Set it before the clients start connecting.
+    */
+    static const char* OPTION_RECONNECT_ADMISSION = "reconnect_admission";
+    /*
+    * @brief Number of released per-message structures (size_t) the client and its transport each keep for reuse (see
+    *        iothub_client_slab.h), so that sending events at a steady rate does not call malloc and free for them. Set it to
+    *        the number of events expected in flight. The default, 0, allocates and frees them for every event.
+    */
+    static const char* OPTION_MESSAGE_POOL_SIZE = "message_pool_size";
+
+    typedef struct IOTHUB_MESSAGE_COMPRESSION_OPTIONS_TAG
+    {
+        /* "gzip" or "deflate" (zlib format), also set as the content encoding of the compressed events; NULL stops compressing. */
+        const char* content_encoding;
+        /* Events with a smaller payload are sent as they are. */
+        size_t min_payload_size;
+        /* 1 (fastest) to 9 (smallest); 0 uses the zlib default. */
+        int level;
+        /* Optional preset dictionary, "deflate" only; the receiver must inflate with the same dictionary. */
+        const unsigned char* dictionary;
+        size_t dictionary_size;
+    } IOTHUB_MESSAGE_COMPRESSION_OPTIONS;
+
+    /*
+    * @brief IOTHUB_MESSAGE_COMPRESSION_OPTIONS with which IoTHubClient_LL_SendEventAsync compresses the payload of the events
+    *        before any transport encodes them, setting their content encoding. Events that already have a content encoding,
+    *        or that compression would not make smaller, are sent as they are. The options are copied. Available only when
+    *        the SDK is built with use_message_compression (zlib). The batches of the HTTP transport (OPTION_BATCHING) carry
+    *        no system property, so events are not compressed while batching is on.
+    */
+    static const char* OPTION_MESSAGE_COMPRESSION = "message_compression";
     static const char* OPTION_PRODUCT_INFO = "product_info";
     /*
     * @brief Informs the service of what is the maximum period the client will wait for a keep-alive message from the service.
@@ -36,6 +36,10 @@ MOCKABLE_FUNCTION(, int, retry_control_set_option, RETRY_CONTROL_HANDLE, retry_c
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, retry_control_retrieve_options, RETRY_CONTROL_HANDLE, retry_control_handle);
 MOCKABLE_FUNCTION(, void, retry_control_destroy, RETRY_CONTROL_HANDLE, retry_control_handle);
 
+/* Process-wide reconnect admission control, shared by every retry control instance.
+   Must be configured while no retry control is being evaluated (e.g. before clients are created). */
+MOCKABLE_FUNCTION(, int, retry_control_set_reconnect_admission_rate, unsigned int, reconnects_per_sec, unsigned int, burst_size);
+
 MOCKABLE_FUNCTION(, int, is_timeout_reached, time_t, start_time, unsigned int, timeout_in_secs, bool*, is_timed_out);
 
 #ifdef __cplusplus
@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_SLAB_H
+#define IOTHUB_CLIENT_SLAB_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Free list of fixed-size elements, for the bookkeeping structures allocated for every message (IOTHUB_MESSAGE_LIST,
+// the MQTT and AMQP per-event records, ...), so that a client sending at a steady rate reuses them instead of calling
+// malloc and free for each message (see OPTION_MESSAGE_POOL_SIZE).
+// A SLAB is embedded in the structure of its owner and needs no allocation to be initialized. It is not thread-safe:
+// the owner serializes the calls, as it does for the lists the elements are kept in.
+// Up to `max_free_elements` released elements are kept for reuse; with 0 (the default of the owners), slab_alloc and
+// slab_free are plain malloc and free.
+
+typedef struct SLAB_TAG
+{
+	size_t element_size;
+	size_t max_free_elements;
+	size_t free_element_count;
+	void* free_elements;
+	// Elements obtained from malloc, and elements taken from the free list, since slab_init.
+	size_t allocation_count;
+	size_t reuse_count;
+} SLAB;
+
+MOCKABLE_FUNCTION(, void, slab_init, SLAB*, slab, size_t, element_size, size_t, max_free_elements);
+// Frees the elements kept for reuse. Elements still in use can be released afterwards; slab_free then frees them.
+MOCKABLE_FUNCTION(, void, slab_deinit, SLAB*, slab);
+// Returns an uninitialized element, or NULL if malloc fails.
+MOCKABLE_FUNCTION(, void*, slab_alloc, SLAB*, slab);
+MOCKABLE_FUNCTION(, void, slab_free, SLAB*, slab, void*, element);
+// Frees the elements kept for reuse beyond `max_free_elements`.
+MOCKABLE_FUNCTION(, void, slab_set_max_free_elements, SLAB*, slab, size_t, max_free_elements);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_SLAB_H
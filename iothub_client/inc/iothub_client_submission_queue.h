@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_SUBMISSION_QUEUE
+#define IOTHUB_CLIENT_SUBMISSION_QUEUE
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Bounded multi-producer/single-consumer queue of fixed-size elements.
+// submission_queue_push() may be called concurrently from any number of threads without a lock;
+// submission_queue_pop() must only be called by one thread at a time (the owner serializes consumers).
+// On compilers without atomic builtins the queue falls back to an internal lock, which is still separate from any lock held by the consumer.
+
+struct SUBMISSION_QUEUE_INSTANCE_TAG;
+typedef struct SUBMISSION_QUEUE_INSTANCE_TAG* SUBMISSION_QUEUE_HANDLE;
+
+MOCKABLE_FUNCTION(, SUBMISSION_QUEUE_HANDLE, submission_queue_create, size_t, element_size, size_t, capacity);
+MOCKABLE_FUNCTION(, int, submission_queue_push, SUBMISSION_QUEUE_HANDLE, submission_queue_handle, const void*, element);
+MOCKABLE_FUNCTION(, int, submission_queue_pop, SUBMISSION_QUEUE_HANDLE, submission_queue_handle, void*, element);
+MOCKABLE_FUNCTION(, void, submission_queue_destroy, SUBMISSION_QUEUE_HANDLE, submission_queue_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_SUBMISSION_QUEUE
@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_TLS_SESSION_CACHE
+#define IOTHUB_CLIENT_TLS_SESSION_CACHE
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Option passed down to the TLS I/O adapter (xio_setoption/HTTPAPIEX_SetOption); its value is a `const TLS_SESSION_STORE*`.
+// Adapters that support session resumption keep the pointer (it is valid until the cache is destroyed),
+// call get_session() before each handshake and save_session() once a handshake completes.
+// Adapters that do not support it are expected to reject the option.
+static const char* OPTION_TLS_SESSION_STORE = "tls_session_store";
+
+// Returns 0 and sets `session`/`session_size` if a serialized session (ticket or session ID) is cached; non-zero otherwise.
+// The session remains valid until the next call to save_session() or until the cache is destroyed.
+typedef int(*TLS_SESSION_STORE_GET_SESSION)(void* context, const unsigned char** session, size_t* session_size);
+// Replaces the cached session with a copy of `session`; `session` NULL (or `session_size` 0) discards the cached session.
+typedef void(*TLS_SESSION_STORE_SAVE_SESSION)(void* context, const unsigned char* session, size_t session_size);
+
+typedef struct TLS_SESSION_STORE_TAG
+{
+	TLS_SESSION_STORE_GET_SESSION get_session;
+	TLS_SESSION_STORE_SAVE_SESSION save_session;
+	void* context;
+} TLS_SESSION_STORE;
+
+typedef struct TLS_SESSION_CACHE_STATISTICS_TAG
+{
+	size_t hits;
+	size_t misses;
+	size_t sessions_saved;
+} TLS_SESSION_CACHE_STATISTICS;
+
+struct TLS_SESSION_CACHE_INSTANCE_TAG;
+typedef struct TLS_SESSION_CACHE_INSTANCE_TAG* TLS_SESSION_CACHE_HANDLE;
+
+MOCKABLE_FUNCTION(, TLS_SESSION_CACHE_HANDLE, tls_session_cache_create);
+MOCKABLE_FUNCTION(, const TLS_SESSION_STORE*, tls_session_cache_get_store, TLS_SESSION_CACHE_HANDLE, tls_session_cache_handle, const char*, hostname);
+MOCKABLE_FUNCTION(, int, tls_session_cache_get_statistics, TLS_SESSION_CACHE_HANDLE, tls_session_cache_handle, TLS_SESSION_CACHE_STATISTICS*, statistics);
+MOCKABLE_FUNCTION(, void, tls_session_cache_destroy, TLS_SESSION_CACHE_HANDLE, tls_session_cache_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_CLIENT_TLS_SESSION_CACHE
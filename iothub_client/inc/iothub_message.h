@@ -44,6 +44,15 @@ DEFINE_ENUM(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT_TYPE_VALUES);
 
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG* IOTHUB_MESSAGE_HANDLE;
 
+/** @brief Function that fills the properties map of a message the first time
+  * the properties are accessed. It shall return 0 on success.
+  */
+typedef int(*IOTHUB_MESSAGE_PROPERTIES_LOADER)(void* context, MAP_HANDLE properties);
+
+/** @brief Function that releases the context of an @c IOTHUB_MESSAGE_PROPERTIES_LOADER.
+  */
+typedef void(*IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY)(void* context);
+
 /**
  * @brief   Creates a new IoT hub message from a byte array. The type of the
  *          message will be set to @c IOTHUBMESSAGE_BYTEARRAY.
@@ -169,6 +178,24 @@ MOCKABLE_FUNCTION(, const char*, IoTHubMessage_GetContentEncodingSystemProperty,
  */
 MOCKABLE_FUNCTION(, MAP_HANDLE, IoTHubMessage_Properties, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
 
+/**
+ * @brief   Defers filling the message's properties map until it is first
+ *          accessed. This allows transports to hand over the properties
+ *          as received on the wire and only decode them if they are used.
+ *
+ * @param   iotHubMessageHandle Handle to the message.
+ * @param   propertiesLoader    Function called with @p context and the
+ *                              properties map on the first access.
+ * @param   contextDestroy      Function called to release @p context once
+ *                              the properties are loaded or the message is
+ *                              destroyed. It can be @c NULL.
+ * @param   context             Context owned by the message on success.
+ *
+ * @return  Returns IOTHUB_MESSAGE_OK if the loader was set successfully
+ *          or an error code otherwise.
+ */
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetPropertiesLoader, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, IOTHUB_MESSAGE_PROPERTIES_LOADER, propertiesLoader, IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY, contextDestroy, void*, context);
+
 /**
 * @brief   Gets the MessageId from the IOTHUB_MESSAGE_HANDLE.
 *
@@ -9,6 +9,7 @@
 #include "azure_uamqp_c/cbs.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
 
 static const char* AUTHENTICATION_OPTION_SAVED_OPTIONS = "saved_authentication_options";
 static const char* AUTHENTICATION_OPTION_CBS_REQUEST_TIMEOUT_SECS = "cbs_request_timeout_secs";
@@ -52,6 +53,9 @@ extern "C"
 
         IOTHUB_AUTHORIZATION_HANDLE authorization_module;                   // with either SAS Token, x509 Certs, and Device SAS Token
 
+        // Millisecond clock shared by all devices of the same connection
+        TICK_COUNTER_HANDLE tick_counter;
+
     } AUTHENTICATION_CONFIG;
 
     typedef struct AUTHENTICATION_INSTANCE* AUTHENTICATION_HANDLE;
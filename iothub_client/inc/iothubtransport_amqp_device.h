@@ -6,6 +6,7 @@
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/session.h"
 #include "azure_uamqp_c/cbs.h"
 #include "iothub_message.h"
@@ -23,6 +24,7 @@ static const char* DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS = "event_send_timeout_s
 static const char* DEVICE_OPTION_CBS_REQUEST_TIMEOUT_SECS = "cbs_request_timeout_secs";
 static const char* DEVICE_OPTION_SAS_TOKEN_REFRESH_TIME_SECS = "sas_token_refresh_time_secs";
 static const char* DEVICE_OPTION_SAS_TOKEN_LIFETIME_SECS = "sas_token_lifetime_secs";
+static const char* DEVICE_OPTION_MESSAGE_POOL_SIZE = "message_pool_size";
 
 #define DEVICE_STATE_VALUES \
     DEVICE_STATE_STOPPED, \
@@ -101,6 +103,9 @@ typedef struct DEVICE_CONFIG_TAG
     // Auth module used to generating handle authorization
     // with either SAS Token, x509 Certs, and Device SAS Token
     IOTHUB_AUTHORIZATION_HANDLE authorization_module;
+
+    // Millisecond clock shared by all devices of the same connection
+    TICK_COUNTER_HANDLE tick_counter;
 } DEVICE_CONFIG;
 
 typedef struct DEVICE_INSTANCE* DEVICE_HANDLE;
@@ -6,6 +6,7 @@
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/session.h"
 #include "iothub_client_private.h"
 
@@ -17,6 +18,7 @@ extern "C"
 
 static const char* MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS = "telemetry_event_send_timeout_secs";
 static const char* MESSENGER_OPTION_SAVED_OPTIONS = "saved_telemetry_messenger_options";
+static const char* MESSENGER_OPTION_MESSAGE_POOL_SIZE = "telemetry_message_pool_size";
 
 typedef struct TELEMETRY_MESSENGER_INSTANCE* TELEMETRY_MESSENGER_HANDLE;
 
@@ -68,6 +70,7 @@ typedef struct TELEMETRY_MESSENGER_CONFIG_TAG
 	char* iothub_host_fqdn;
 	ON_TELEMETRY_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
 	void* on_state_changed_context;
+	TICK_COUNTER_HANDLE tick_counter;
 } TELEMETRY_MESSENGER_CONFIG;
 
 MOCKABLE_FUNCTION(, TELEMETRY_MESSENGER_HANDLE, telemetry_messenger_create, const TELEMETRY_MESSENGER_CONFIG*, messenger_config, const char*, product_info);
@@ -7,6 +7,7 @@
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/session.h"
 #include "iothub_client_private.h"
 
@@ -66,6 +67,7 @@ extern "C"
 		char* iothub_host_fqdn;
 		TWIN_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
 		void* on_state_changed_context;
+		TICK_COUNTER_HANDLE tick_counter;
 	} TWIN_MESSENGER_CONFIG;
 
 	MOCKABLE_FUNCTION(, TWIN_MESSENGER_HANDLE, twin_messenger_create, const TWIN_MESSENGER_CONFIG*, messenger_config);
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUBTRANSPORT_HTTP_ENGINE_H
+#define IOTHUBTRANSPORT_HTTP_ENGINE_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Non-blocking HTTP/1.1 client for one host. Requests are queued by http_engine_execute_request_async() and
+// driven by http_engine_dowork() over a pool of keep-alive connections, so up to `max_connections` requests
+// are in flight at the same time and a slow response only holds up its own connection.
+// All functions, and the response callbacks, run on the thread calling http_engine_dowork().
+
+#define HTTP_ENGINE_RESULT_VALUES \
+	HTTP_ENGINE_OK,               \
+	HTTP_ENGINE_ERROR,            \
+	HTTP_ENGINE_TIMEOUT,          \
+	HTTP_ENGINE_CANCELLED
+
+DEFINE_ENUM(HTTP_ENGINE_RESULT, HTTP_ENGINE_RESULT_VALUES);
+
+// Creates the I/O for one connection; NULL in HTTP_ENGINE_CONFIG means TLS to `fully_qualified_name`:443.
+typedef XIO_HANDLE(*HTTP_ENGINE_GET_IO_TRANSPORT)(const char* fully_qualified_name);
+
+// `status_code`, `response_headers` and `content` are only meaningful when `result` is HTTP_ENGINE_OK,
+// and only valid during the call.
+typedef void(*ON_HTTP_ENGINE_RESPONSE)(void* context, HTTP_ENGINE_RESULT result, unsigned int status_code, HTTP_HEADERS_HANDLE response_headers, const unsigned char* content, size_t content_size);
+
+typedef struct HTTP_ENGINE_CONFIG_TAG
+{
+	const char* host_name;
+	HTTP_ENGINE_GET_IO_TRANSPORT get_io_transport;
+	// Time allowed from queuing a request to receiving its whole response; 0 selects the default (60 seconds).
+	size_t request_timeout_ms;
+} HTTP_ENGINE_CONFIG;
+
+typedef struct HTTP_ENGINE_INSTANCE_TAG* HTTP_ENGINE_HANDLE;
+
+MOCKABLE_FUNCTION(, HTTP_ENGINE_HANDLE, http_engine_create, const HTTP_ENGINE_CONFIG*, config);
+MOCKABLE_FUNCTION(, void, http_engine_destroy, HTTP_ENGINE_HANDLE, http_engine_handle);
+MOCKABLE_FUNCTION(, int, http_engine_set_max_connections, HTTP_ENGINE_HANDLE, http_engine_handle, size_t, max_connections);
+MOCKABLE_FUNCTION(, int, http_engine_set_option, HTTP_ENGINE_HANDLE, http_engine_handle, const char*, name, const void*, value);
+MOCKABLE_FUNCTION(, int, http_engine_execute_request_async, HTTP_ENGINE_HANDLE, http_engine_handle, HTTPAPI_REQUEST_TYPE, request_type, const char*, relative_path, HTTP_HEADERS_HANDLE, request_headers, const unsigned char*, content, size_t, content_size, ON_HTTP_ENGINE_RESPONSE, on_response, void*, context);
+MOCKABLE_FUNCTION(, void, http_engine_cancel_requests, HTTP_ENGINE_HANDLE, http_engine_handle, void*, context);
+MOCKABLE_FUNCTION(, void, http_engine_dowork, HTTP_ENGINE_HANDLE, http_engine_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*IOTHUBTRANSPORT_HTTP_ENGINE_H*/
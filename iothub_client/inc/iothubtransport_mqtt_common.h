@@ -22,6 +22,18 @@ typedef struct MQTT_TRANSPORT_PROXY_OPTIONS_TAG
 
 typedef XIO_HANDLE(*MQTT_GET_IO_TRANSPORT)(const char* fully_qualified_name, const MQTT_TRANSPORT_PROXY_OPTIONS* mqtt_transport_proxy_options);
 
+// Creates the I/O of the connections a transport opens instead of its get_io_transport, e.g. to run them on
+// the sockets of an MQTT reactor. Set it with OPTION_MQTT_IO_FACTORY before the I/O is created.
+typedef XIO_HANDLE(*MQTT_CREATE_IO_TRANSPORT)(void* context, const char* fully_qualified_name);
+
+typedef struct MQTT_TRANSPORT_IO_FACTORY_TAG
+{
+    MQTT_CREATE_IO_TRANSPORT create_io_transport;
+    void* context;
+} MQTT_TRANSPORT_IO_FACTORY;
+
+static const char* OPTION_MQTT_IO_FACTORY = "mqtt_io_factory";
+
 MOCKABLE_FUNCTION(, TRANSPORT_LL_HANDLE, IoTHubTransport_MQTT_Common_Create, const IOTHUBTRANSPORT_CONFIG*,  config, MQTT_GET_IO_TRANSPORT, get_io_transport);
 MOCKABLE_FUNCTION(, void, IoTHubTransport_MQTT_Common_Destroy, TRANSPORT_LL_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, IoTHubTransport_MQTT_Common_Subscribe, IOTHUB_DEVICE_HANDLE, handle);
@@ -39,6 +51,7 @@ MOCKABLE_FUNCTION(, IOTHUB_DEVICE_HANDLE, IoTHubTransport_MQTT_Common_Register,
 MOCKABLE_FUNCTION(, void, IoTHubTransport_MQTT_Common_Unregister, IOTHUB_DEVICE_HANDLE, deviceHandle);
 MOCKABLE_FUNCTION(, int, IoTHubTransport_MQTT_Common_SetRetryPolicy, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
 MOCKABLE_FUNCTION(, STRING_HANDLE, IoTHubTransport_MQTT_Common_GetHostname, TRANSPORT_LL_HANDLE, handle);
+MOCKABLE_FUNCTION(, void, IoTHubTransport_MQTT_Common_GetStatistics, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_STATISTICS*, statistics);
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubTransport_MQTT_Common_SendMessageDisposition, MESSAGE_CALLBACK_INFO*, message_data, IOTHUBMESSAGE_DISPOSITION_RESULT, disposition)
 
 
@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUBTRANSPORT_MQTT_REACTOR_H
+#define IOTHUBTRANSPORT_MQTT_REACTOR_H
+
+#include <stddef.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/lock.h"
+#include "iothub_client_ll.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Linux only. Drives the MQTT connections of many IoTHubClient_LL instances from one epoll loop, run by a few
+// threads or by the caller through mqtt_reactor_dowork(), instead of one thread per device calling
+// IoTHubClient_LL_DoWork every millisecond. The reactor owns the sockets of the clients added to it: a client is
+// serviced (IoTHubClient_LL_DoWork) when one of its sockets is ready, when mqtt_reactor_wake_client() is called,
+// and at least every `idle_interval_ms` so that keep-alives, retries and timeouts still run.
+// Each client uses two file descriptors (its socket and a timerfd); raise RLIMIT_NOFILE accordingly.
+
+typedef struct MQTT_REACTOR_INSTANCE_TAG* MQTT_REACTOR_HANDLE;
+typedef struct MQTT_REACTOR_CLIENT_TAG* MQTT_REACTOR_CLIENT_HANDLE;
+
+// Parameters of the socket I/O returned by mqtt_reactor_get_socketio_interface().
+typedef struct MQTT_REACTOR_SOCKET_CONFIG_TAG
+{
+    const char* hostname;
+    int port;
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client;
+} MQTT_REACTOR_SOCKET_CONFIG;
+
+// Creates the I/O of one connection on top of `socket_io_interface` and `socket_config`, whose `hostname` and `port`
+// may be changed; NULL in MQTT_REACTOR_CONFIG means TLS to `fully_qualified_name`:8883.
+typedef XIO_HANDLE(*MQTT_REACTOR_GET_IO_TRANSPORT)(const char* fully_qualified_name, const IO_INTERFACE_DESCRIPTION* socket_io_interface, MQTT_REACTOR_SOCKET_CONFIG* socket_config);
+
+typedef struct MQTT_REACTOR_CONFIG_TAG
+{
+    // Threads running the loop; 0 starts none and leaves it to mqtt_reactor_dowork().
+    size_t thread_count;
+    // Longest time a client goes without being serviced; 0 selects the default (1000 ms).
+    size_t idle_interval_ms;
+    MQTT_REACTOR_GET_IO_TRANSPORT get_io_transport;
+} MQTT_REACTOR_CONFIG;
+
+MOCKABLE_FUNCTION(, MQTT_REACTOR_HANDLE, mqtt_reactor_create, const MQTT_REACTOR_CONFIG*, config);
+// The clients must have been removed and destroyed first.
+MOCKABLE_FUNCTION(, void, mqtt_reactor_destroy, MQTT_REACTOR_HANDLE, reactor);
+// Must be called before the client connects or is given certificates. `lock`, if not NULL, is held while the
+// reactor calls IoTHubClient_LL_DoWork, and must be held by the application around its own calls on `client`.
+MOCKABLE_FUNCTION(, MQTT_REACTOR_CLIENT_HANDLE, mqtt_reactor_add_client, MQTT_REACTOR_HANDLE, reactor, IOTHUB_CLIENT_LL_HANDLE, client, LOCK_HANDLE, lock);
+// Once it returns, the reactor no longer calls IoTHubClient_LL_DoWork for the client, which shall then be destroyed.
+// Must not be called from the callbacks of the client.
+MOCKABLE_FUNCTION(, void, mqtt_reactor_remove_client, MQTT_REACTOR_CLIENT_HANDLE, reactor_client);
+// Services the client as soon as possible, e.g. after IoTHubClient_LL_SendEventAsync. Can be called from any thread.
+MOCKABLE_FUNCTION(, int, mqtt_reactor_wake_client, MQTT_REACTOR_CLIENT_HANDLE, reactor_client);
+// Waits up to `timeout_ms` for clients to service and services them; for reactors created with no thread.
+MOCKABLE_FUNCTION(, int, mqtt_reactor_dowork, MQTT_REACTOR_HANDLE, reactor, size_t, timeout_ms);
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, mqtt_reactor_get_socketio_interface);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUBTRANSPORT_MQTT_REACTOR_H
@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUBTRANSPORT_MQTT_TOPIC_H
+#define IOTHUBTRANSPORT_MQTT_TOPIC_H
+
+#include <stddef.h>
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// A piece of a topic name; `value` points into the topic and is not NUL-terminated.
+typedef struct MQTT_TOPIC_SLICE_TAG
+{
+    const char* value;
+    size_t length;
+} MQTT_TOPIC_SLICE;
+
+#define MQTT_TOPIC_TYPE_VALUES                 \
+    MQTT_TOPIC_TYPE_C2D_MESSAGE,               \
+    MQTT_TOPIC_TYPE_TWIN_RESPONSE,             \
+    MQTT_TOPIC_TYPE_TWIN_DESIRED_PATCH,        \
+    MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST
+
+DEFINE_ENUM(MQTT_TOPIC_TYPE, MQTT_TOPIC_TYPE_VALUES);
+
+// Everything the transport needs from an incoming topic, found in a single pass and without allocating.
+// The slices point into the topic passed to mqtt_topic_parse and are only valid as long as it is.
+typedef struct MQTT_TOPIC_INFO_TAG
+{
+    MQTT_TOPIC_TYPE type;
+    // MQTT_TOPIC_TYPE_TWIN_RESPONSE only ($iothub/twin/res/{status_code}/?$rid={request_id}).
+    int status_code;
+    size_t twin_request_id;
+    // MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST only ($iothub/methods/POST/{method_name}/?$rid={request_id}).
+    MQTT_TOPIC_SLICE method_name;
+    MQTT_TOPIC_SLICE request_id;
+    // URL-encoded name=value pairs separated by '&': the property bag of a cloud-to-device message,
+    // or what follows the '?' of a twin or device method topic.
+    MQTT_TOPIC_SLICE properties;
+} MQTT_TOPIC_INFO;
+
+MOCKABLE_FUNCTION(, int, mqtt_topic_parse, const char*, topic, MQTT_TOPIC_INFO*, topic_info);
+// Takes the next name=value pair off the front of `properties`; returns non-zero once there is none left.
+// `value->value` is NULL for a pair without '='.
+MOCKABLE_FUNCTION(, int, mqtt_topic_get_next_property, MQTT_TOPIC_SLICE*, properties, MQTT_TOPIC_SLICE*, name, MQTT_TOPIC_SLICE*, value);
+// URL-decodes `encoded` into `buffer` and NUL-terminates it. The decoded text is never longer than `encoded`,
+// so a buffer of encoded->length + 1 bytes is always large enough.
+MOCKABLE_FUNCTION(, int, mqtt_topic_url_decode, const MQTT_TOPIC_SLICE*, encoded, char*, buffer, size_t, buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUBTRANSPORT_MQTT_TOPIC_H
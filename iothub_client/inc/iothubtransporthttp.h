@@ -5,6 +5,7 @@
 #define IOTHUBTRANSPORTHTTP_H
 
 #include "iothub_transport_ll.h"
+#include "iothubtransport_http_engine.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -13,6 +14,10 @@ extern "C"
 
 	extern const TRANSPORT_PROVIDER* HTTP_Protocol(void);
 
+	/* Same as HTTP_Protocol()->IoTHubTransport_Create, except that the connections of the pool (OPTION_HTTP_CONNECTION_POOL_SIZE)
+	   are created by get_io_transport instead of being TLS connections to the hub. */
+	extern TRANSPORT_LL_HANDLE IoTHubTransportHttp_CreateWithIoTransport(const IOTHUBTRANSPORT_CONFIG* config, HTTP_ENGINE_GET_IO_TRANSPORT get_io_transport);
+
 #ifdef __cplusplus
 }
 #endif
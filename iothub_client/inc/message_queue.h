@@ -166,6 +166,17 @@ MOCKABLE_FUNCTION(, int, message_queue_set_max_message_processing_time_secs, MES
 */
 MOCKABLE_FUNCTION(, int, message_queue_set_max_retry_count, MESSAGE_QUEUE_HANDLE, message_queue, size_t, max_retry_count);
 
+/**
+* @brief	Sets how many released item records MESSAGE_QUEUE keeps for reuse, so that adding messages at a steady rate does not allocate them.
+*
+* @param	message_queue	A @c MESSAGE_QUEUE_HANDLE obtained using message_queue_create.
+*
+* @param	max_free_items	Number of item records to keep. The default, zero, allocates and frees one record per message.
+*
+* @returns	Zero if the no errors occur, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, message_queue_set_max_free_items, MESSAGE_QUEUE_HANDLE, message_queue, size_t, max_free_items);
+
 /**
 * @brief	Retrieves a blob with all the options currently set in the instance of MESSAGE_QUEUE.
 *
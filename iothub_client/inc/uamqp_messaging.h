@@ -16,6 +16,14 @@ extern "C"
 	MOCKABLE_FUNCTION(, int, IoTHubMessage_CreateFromUamqpMessage, MESSAGE_HANDLE, uamqp_message, IOTHUB_MESSAGE_HANDLE*, iothubclient_message);
 	MOCKABLE_FUNCTION(, int, message_create_from_iothub_message, IOTHUB_MESSAGE_HANDLE, iothub_message, MESSAGE_HANDLE*, uamqp_message);
 
+	/* A template keeps the encoded parts of the last message sent by a device that are likely to repeat (currently the application properties),
+	   so consecutive messages with the same properties do not encode them again. A template must not be shared by concurrent callers. */
+	typedef struct UAMQP_MESSAGE_TEMPLATE_TAG* UAMQP_MESSAGE_TEMPLATE_HANDLE;
+
+	MOCKABLE_FUNCTION(, UAMQP_MESSAGE_TEMPLATE_HANDLE, uamqp_message_template_create);
+	MOCKABLE_FUNCTION(, void, uamqp_message_template_destroy, UAMQP_MESSAGE_TEMPLATE_HANDLE, message_template);
+	MOCKABLE_FUNCTION(, int, message_create_from_iothub_message_with_template, UAMQP_MESSAGE_TEMPLATE_HANDLE, message_template, IOTHUB_MESSAGE_HANDLE, iothub_message, MESSAGE_HANDLE*, uamqp_message);
+
 #ifdef __cplusplus
 }
 #endif
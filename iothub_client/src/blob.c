@@ -9,9 +9,16 @@
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "iothub_client_md5.h"
 
 /*a block has 4MB*/
 #define BLOCK_SIZE (4*1024*1024)
+/*a block blob can include a maximum of 50000 blocks*/
+#define MAX_BLOCK_COUNT 50000
+/*the block IDs are 000000... 049999 before being BASE64 encoded*/
+#define BLOCK_ID_SIZE 6
+#define CONTENT_MD5_HEADER "Content-MD5"
 
 BLOB_RESULT Blob_UploadFromSasUri(const char* SASURI, const unsigned char* source, size_t size, unsigned int* httpStatus, BUFFER_HANDLE httpResponse, const char* certificates)
 {
@@ -371,3 +378,427 @@ BLOB_RESULT Blob_UploadFromSasUri(const char* SASURI, const unsigned char* sourc
     }
     return result;
 }
+
+static void clear_upload_progress(BLOB_UPLOAD_PROGRESS* progress)
+{
+    free(progress->SASURI);
+    free(progress->blocks);
+    memset(progress, 0, sizeof(BLOB_UPLOAD_PROGRESS));
+}
+
+/*the blob is identified by the SAS URI without its query, which carries the SAS token and changes from one attempt to the next*/
+static size_t get_blob_uri_length(const char* SASURI)
+{
+    const char* query = strchr(SASURI, '?');
+    return (query == NULL) ? strlen(SASURI) : (size_t)(query - SASURI);
+}
+
+static int is_same_upload(const BLOB_UPLOAD_PROGRESS* progress, const char* SASURI, size_t size)
+{
+    size_t blobUriLength = get_blob_uri_length(SASURI);
+    return
+        (progress->SASURI != NULL) &&
+        (progress->size == size) &&
+        (get_blob_uri_length(progress->SASURI) == blobUriLength) &&
+        (strncmp(progress->SASURI, SASURI, blobUriLength) == 0);
+}
+
+/*returns 0 when progress records the upload of size bytes to SASURI, keeping the blocks uploaded by the previous attempts of the same upload*/
+static int start_upload_progress(BLOB_UPLOAD_PROGRESS* progress, const char* SASURI, size_t size)
+{
+    int result;
+    size_t SASURIsize = strlen(SASURI) + 1;
+    char* SASURIcopy = (char*)malloc(SASURIsize);
+
+    if (SASURIcopy == NULL)
+    {
+        LogError("unable to malloc the copy of the SAS URI");
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(SASURIcopy, SASURI, SASURIsize);
+
+        if (is_same_upload(progress, SASURI, size))
+        {
+            free(progress->SASURI);
+            progress->SASURI = SASURIcopy;
+            result = 0;
+        }
+        else
+        {
+            size_t blockCount = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            BLOB_BLOCK* blocks = NULL;
+
+            if ((blockCount > 0) && ((blocks = (BLOB_BLOCK*)malloc(blockCount * sizeof(BLOB_BLOCK))) == NULL))
+            {
+                LogError("unable to malloc the state of %lu blocks", (unsigned long)blockCount);
+                free(SASURIcopy);
+                result = __FAILURE__;
+            }
+            else
+            {
+                clear_upload_progress(progress);
+                if (blocks != NULL)
+                {
+                    memset(blocks, 0, blockCount * sizeof(BLOB_BLOCK));
+                }
+                progress->SASURI = SASURIcopy;
+                progress->size = size;
+                progress->blockCount = blockCount;
+                progress->blocks = blocks;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static STRING_HANDLE create_block_id(size_t blockIndex)
+{
+    STRING_HANDLE result;
+    char blockId[BLOCK_ID_SIZE + 1];
+
+    if (sprintf(blockId, "%06u", (unsigned int)blockIndex) != BLOCK_ID_SIZE)
+    {
+        LogError("failed to sprintf");
+        result = NULL;
+    }
+    else if ((result = Base64_Encode_Bytes((const unsigned char*)blockId, BLOCK_ID_SIZE)) == NULL)
+    {
+        LogError("unable to Base64_Encode_Bytes");
+    }
+
+    return result;
+}
+
+/*returns the relative path of the request: base relativePath + suffix + blockId (if any)*/
+static STRING_HANDLE create_request_path(const char* relativePath, const char* suffix, STRING_HANDLE blockId)
+{
+    STRING_HANDLE result = STRING_construct(relativePath);
+    if (result == NULL)
+    {
+        LogError("unable to STRING_construct");
+    }
+    else if (
+        (STRING_concat(result, suffix) != 0) ||
+        ((blockId != NULL) && (STRING_concat_with_STRING(result, blockId) != 0))
+        )
+    {
+        LogError("unable to STRING concatenate");
+        STRING_delete(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+static BLOB_RESULT put_block(HTTPAPIEX_HANDLE httpApiExHandle, const char* relativePath, size_t blockIndex, const unsigned char* block, size_t blockSize, const unsigned char* md5, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
+{
+    BLOB_RESULT result;
+    STRING_HANDLE blockId;
+
+    if ((blockId = create_block_id(blockIndex)) == NULL)
+    {
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        STRING_HANDLE requestPath;
+        STRING_HANDLE md5String;
+
+        if ((requestPath = create_request_path(relativePath, "&comp=block&blockid=", blockId)) == NULL)
+        {
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            if ((md5String = Base64_Encode_Bytes(md5, BLOB_BLOCK_MD5_SIZE)) == NULL)
+            {
+                LogError("unable to Base64_Encode_Bytes");
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                HTTP_HEADERS_HANDLE requestHttpHeaders = HTTPHeaders_Alloc();
+                if (requestHttpHeaders == NULL)
+                {
+                    LogError("unable to HTTPHeaders_Alloc");
+                    result = BLOB_ERROR;
+                }
+                else
+                {
+                    BUFFER_HANDLE requestContent;
+
+                    if (HTTPHeaders_AddHeaderNameValuePair(requestHttpHeaders, CONTENT_MD5_HEADER, STRING_c_str(md5String)) != HTTP_HEADERS_OK)
+                    {
+                        LogError("unable to HTTPHeaders_AddHeaderNameValuePair");
+                        result = BLOB_ERROR;
+                    }
+                    else if ((requestContent = BUFFER_create(block, blockSize)) == NULL)
+                    {
+                        LogError("unable to BUFFER_create");
+                        result = BLOB_ERROR;
+                    }
+                    else
+                    {
+                        /*Codes_SRS_BLOB_09_008: [ If HTTPAPIEX_ExecuteRequest fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_HTTP_ERROR, keeping in progress the blocks uploaded so far. ]*/
+                        if (HTTPAPIEX_ExecuteRequest(httpApiExHandle, HTTPAPI_REQUEST_PUT, STRING_c_str(requestPath), requestHttpHeaders, requestContent, httpStatus, NULL, httpResponse) != HTTPAPIEX_OK)
+                        {
+                            LogError("unable to HTTPAPIEX_ExecuteRequest (block %lu)", (unsigned long)blockIndex);
+                            result = BLOB_HTTP_ERROR;
+                        }
+                        else
+                        {
+                            result = BLOB_OK;
+                        }
+                        BUFFER_delete(requestContent);
+                    }
+                    HTTPHeaders_Free(requestHttpHeaders);
+                }
+                STRING_delete(md5String);
+            }
+            STRING_delete(requestPath);
+        }
+        STRING_delete(blockId);
+    }
+
+    return result;
+}
+
+static BLOB_RESULT put_block_list(HTTPAPIEX_HANDLE httpApiExHandle, const char* relativePath, size_t blockCount, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
+{
+    BLOB_RESULT result;
+    STRING_HANDLE xml = STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>");
+
+    if (xml == NULL)
+    {
+        LogError("failed to STRING_construct");
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        size_t blockIndex;
+
+        result = BLOB_OK;
+        for (blockIndex = 0; (blockIndex < blockCount) && (result == BLOB_OK); blockIndex++)
+        {
+            STRING_HANDLE blockId = create_block_id(blockIndex);
+            if (blockId == NULL)
+            {
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                if (!(
+                    (STRING_concat(xml, "<Latest>") == 0) &&
+                    (STRING_concat_with_STRING(xml, blockId) == 0) &&
+                    (STRING_concat(xml, "</Latest>") == 0)
+                    ))
+                {
+                    LogError("unable to STRING_concat");
+                    result = BLOB_ERROR;
+                }
+                STRING_delete(blockId);
+            }
+        }
+
+        if (result != BLOB_OK)
+        {
+            /*do nothing, it will be reported "as is"*/
+        }
+        else if (STRING_concat(xml, "</BlockList>") != 0)
+        {
+            LogError("failed to STRING_concat");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            STRING_HANDLE requestPath = create_request_path(relativePath, "&comp=blocklist", NULL);
+            if (requestPath == NULL)
+            {
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                const char* s = STRING_c_str(xml);
+                BUFFER_HANDLE xmlAsBuffer = BUFFER_create((const unsigned char*)s, strlen(s));
+                if (xmlAsBuffer == NULL)
+                {
+                    LogError("failed to BUFFER_create");
+                    result = BLOB_ERROR;
+                }
+                else
+                {
+                    /*Codes_SRS_BLOB_09_012: [ If HTTPAPIEX_ExecuteRequest fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_HTTP_ERROR, keeping progress. ]*/
+                    if (HTTPAPIEX_ExecuteRequest(httpApiExHandle, HTTPAPI_REQUEST_PUT, STRING_c_str(requestPath), NULL, xmlAsBuffer, httpStatus, NULL, httpResponse) != HTTPAPIEX_OK)
+                    {
+                        LogError("unable to HTTPAPIEX_ExecuteRequest (block list)");
+                        result = BLOB_HTTP_ERROR;
+                    }
+                    BUFFER_delete(xmlAsBuffer);
+                }
+                STRING_delete(requestPath);
+            }
+        }
+        STRING_delete(xml);
+    }
+
+    return result;
+}
+
+BLOB_RESULT Blob_UploadResumableFromSasUri(const char* SASURI, const unsigned char* source, size_t size, unsigned int* httpStatus, BUFFER_HANDLE httpResponse, const char* certificates, BLOB_UPLOAD_PROGRESS* progress)
+{
+    BLOB_RESULT result;
+    const char* hostnameBegin;
+    const char* hostnameEnd;
+
+    /*Codes_SRS_BLOB_09_001: [ If SASURI or progress are NULL, or source is NULL and size is not zero, then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    if ((SASURI == NULL) || (progress == NULL) || ((size > 0) && (source == NULL)))
+    {
+        LogError("invalid argument SASURI=%p source=%p size=%lu progress=%p", SASURI, source, (unsigned long)size, progress);
+        result = BLOB_INVALID_ARG;
+    }
+    /*Codes_SRS_BLOB_09_002: [ If size is bigger than 50000 blocks of 4MB then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    else if ((size > 0) && ((size - 1) / BLOCK_SIZE >= MAX_BLOCK_COUNT))
+    {
+        LogError("size too big (%lu)", (unsigned long)size);
+        result = BLOB_INVALID_ARG;
+    }
+    /*Codes_SRS_BLOB_09_003: [ If the hostname cannot be determined from SASURI, then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    else if (
+        ((hostnameBegin = strstr(SASURI, "://")) == NULL) ||
+        ((hostnameEnd = strchr(hostnameBegin + 3, '/')) == NULL)
+        )
+    {
+        LogError("hostname cannot be determined");
+        result = BLOB_INVALID_ARG;
+    }
+    else
+    {
+        size_t hostnameSize;
+        char* hostname;
+
+        hostnameBegin += 3; /*have to skip 3 characters which are "://"*/
+        hostnameSize = hostnameEnd - hostnameBegin;
+        if ((hostname = (char*)malloc(hostnameSize + 1)) == NULL)
+        {
+            /*Codes_SRS_BLOB_09_014: [ If any other operation fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_ERROR. ]*/
+            LogError("oom - out of memory");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            HTTPAPIEX_HANDLE httpApiExHandle;
+            (void)memcpy(hostname, hostnameBegin, hostnameSize);
+            hostname[hostnameSize] = '\0';
+
+            /*Codes_SRS_BLOB_09_004: [ Blob_UploadResumableFromSasUri shall create a HTTPAPIEX_HANDLE to the hostname, passing certificates (if any) with the option "TrustedCerts". ]*/
+            if ((httpApiExHandle = HTTPAPIEX_Create(hostname)) == NULL)
+            {
+                LogError("unable to create a HTTPAPIEX_HANDLE");
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                const char* relativePath = hostnameEnd; /*this is where the relative path begins in the SasUri*/
+
+                if ((certificates != NULL) && (HTTPAPIEX_SetOption(httpApiExHandle, "TrustedCerts", certificates) != HTTPAPIEX_OK))
+                {
+                    LogError("failure in setting trusted certificates");
+                    result = BLOB_ERROR;
+                }
+                /*Codes_SRS_BLOB_09_005: [ If progress records an upload of the same blob (SASURI without its query) and size, Blob_UploadResumableFromSasUri shall resume it and save SASURI; otherwise it shall clear progress and record the upload of size bytes in blocks of 4MB. ]*/
+                else if (start_upload_progress(progress, SASURI, size) != 0)
+                {
+                    result = BLOB_ERROR;
+                }
+                else
+                {
+                    size_t blockIndex;
+                    size_t skippedBlockCount = 0;
+                    int isStatusError = 0; /*the storage answered a Put Block with a status >= 300*/
+
+                    result = BLOB_OK;
+                    for (blockIndex = 0; (blockIndex < progress->blockCount) && (result == BLOB_OK) && !isStatusError; blockIndex++)
+                    {
+                        BLOB_BLOCK* block = &progress->blocks[blockIndex];
+                        const unsigned char* blockContent = source + blockIndex * BLOCK_SIZE;
+                        size_t blockSize = (blockIndex + 1 < progress->blockCount) ? BLOCK_SIZE : size - blockIndex * BLOCK_SIZE;
+                        unsigned char md5[BLOB_BLOCK_MD5_SIZE];
+
+                        /*Codes_SRS_BLOB_09_006: [ For every block Blob_UploadResumableFromSasUri shall compute the MD5 of its content, and skip it if progress records it as uploaded with the same MD5. ]*/
+                        if (md5_compute(blockContent, blockSize, md5) != 0)
+                        {
+                            LogError("unable to compute the MD5 of block %lu", (unsigned long)blockIndex);
+                            result = BLOB_ERROR;
+                        }
+                        else if (block->isUploaded && (memcmp(block->md5, md5, BLOB_BLOCK_MD5_SIZE) == 0))
+                        {
+                            skippedBlockCount++;
+                        }
+                        else
+                        {
+                            block->isUploaded = 0;
+
+                            /*Codes_SRS_BLOB_09_007: [ Otherwise Blob_UploadResumableFromSasUri shall PUT the block to base relativePath + "&comp=block&blockid=BASE64 encoded block ID (000000... 049999)", with the header Content-MD5 set to the BASE64 encoded MD5 of the block. ]*/
+                            result = put_block(httpApiExHandle, relativePath, blockIndex, blockContent, blockSize, md5, httpStatus, httpResponse);
+                            if (result != BLOB_OK)
+                            {
+                                /*do nothing, it will be reported "as is"*/
+                            }
+                            else if (*httpStatus >= 300)
+                            {
+                                /*Codes_SRS_BLOB_09_009: [ If the HTTP status of a block is >= 300, then Blob_UploadResumableFromSasUri shall stop, keep progress and return BLOB_OK. ]*/
+                                LogError("HTTP status from storage does not indicate success (%d) for block %lu", (int)*httpStatus, (unsigned long)blockIndex);
+                                isStatusError = 1;
+                            }
+                            else
+                            {
+                                /*Codes_SRS_BLOB_09_010: [ Otherwise Blob_UploadResumableFromSasUri shall record in progress the block as uploaded, with its MD5. ]*/
+                                (void)memcpy(block->md5, md5, BLOB_BLOCK_MD5_SIZE);
+                                block->isUploaded = 1;
+                            }
+                        }
+                    }
+
+                    if (skippedBlockCount > 0)
+                    {
+                        LogInfo("resumed the upload, %lu of %lu blocks were already uploaded", (unsigned long)skippedBlockCount, (unsigned long)progress->blockCount);
+                    }
+
+                    if ((result == BLOB_OK) && !isStatusError)
+                    {
+                        /*Codes_SRS_BLOB_09_011: [ Once all the blocks are uploaded, Blob_UploadResumableFromSasUri shall PUT to base relativePath + "&comp=blocklist" the XML list of all the block IDs. ]*/
+                        result = put_block_list(httpApiExHandle, relativePath, progress->blockCount, httpStatus, httpResponse);
+                        if ((result == BLOB_OK) && ((*httpStatus < 300) || (*httpStatus == 400)))
+                        {
+                            /*Codes_SRS_BLOB_09_013: [ Otherwise Blob_UploadResumableFromSasUri shall return BLOB_OK, clearing progress if the HTTP status of the block list is < 300 or 400 (the block list is rejected). ]*/
+                            /*a rejected block list (400 InvalidBlockList) would be rejected again when resumed, so the next upload starts over; an expired SAS (401, 403) keeps the blocks*/
+                            clear_upload_progress(progress);
+                        }
+                    }
+                }
+                HTTPAPIEX_Destroy(httpApiExHandle);
+            }
+            free(hostname);
+        }
+    }
+
+    return result;
+}
+
+void Blob_ClearUploadProgress(BLOB_UPLOAD_PROGRESS* progress)
+{
+    /*Codes_SRS_BLOB_09_015: [ If progress is NULL, Blob_ClearUploadProgress shall return. ]*/
+    if (progress == NULL)
+    {
+        LogError("parameter progress is NULL");
+    }
+    else
+    {
+        /*Codes_SRS_BLOB_09_016: [ Blob_ClearUploadProgress shall free the SASURI and the blocks saved in progress, and set it to 0. ]*/
+        clear_upload_progress(progress);
+    }
+}
@@ -7,18 +7,28 @@
 
 #include <signal.h>
 #include <stddef.h>
+#include <string.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "iothub_client.h"
 #include "iothub_client_ll.h"
 #include "iothub_client_private.h"
+#include "iothub_client_submission_queue.h"
+#include "iothub_client_callback_executor.h"
+#include "iothub_client_options.h"
 #include "iothubtransport.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
 
+#ifndef IOTHUB_CLIENT_SUBMISSION_QUEUE_CAPACITY
+/*events IoTHubClient_SendEventAsync can hand to the worker thread without taking the lock; beyond that it falls back to locking*/
+#define IOTHUB_CLIENT_SUBMISSION_QUEUE_CAPACITY 1024
+#endif
+
 struct IOTHUB_QUEUE_CONTEXT_TAG;
 
 typedef struct IOTHUB_CLIENT_INSTANCE_TAG
@@ -28,6 +38,9 @@ typedef struct IOTHUB_CLIENT_INSTANCE_TAG
     THREAD_HANDLE ThreadHandle;
     LOCK_HANDLE LockHandle;
     sig_atomic_t StopThread;
+    SUBMISSION_QUEUE_HANDLE submission_queue; /*holds SUBMITTED_EVENTs, NULL when the transport is shared*/
+    TICK_COUNTER_HANDLE submission_tick_counter; /*stamps the SUBMITTED_EVENTs, NULL when the transport is shared*/
+    CALLBACK_EXECUTOR_HANDLE callback_executor; /*set with OPTION_CALLBACK_EXECUTOR, NULL when the callbacks run on the worker thread*/
 #ifndef DONT_USE_UPLOADTOBLOB
     SINGLYLINKEDLIST_HANDLE savedDataToBeCleaned; /*list containing UPLOADTOBLOB_SAVED_DATA*/
 #endif
@@ -124,6 +137,21 @@ typedef struct IOTHUB_QUEUE_CONTEXT_TAG
     void* userContextCallback;
 } IOTHUB_QUEUE_CONTEXT;
 
+typedef struct DISPATCHED_USER_CALLBACK_TAG
+{
+    IOTHUB_CLIENT_INSTANCE* iotHubClientInstance;
+    USER_CALLBACK_INFO callback_info;
+} DISPATCHED_USER_CALLBACK;
+
+typedef struct SUBMITTED_EVENT_TAG
+{
+    IOTHUB_MESSAGE_HANDLE message; /*clone owned by the submission queue until the worker thread hands it to IoTHubClient_LL_SendQueuedEventAsync*/
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback;
+    void* userContextCallback;
+    bool has_submitted_ms;
+    tickcounter_ms_t submitted_ms;
+} SUBMITTED_EVENT;
+
 /*used by unittests only*/
 const size_t IoTHubClient_ThreadTerminationOffset = offsetof(IOTHUB_CLIENT_INSTANCE, StopThread);
 
@@ -398,7 +426,139 @@ static void iothub_ll_device_twin_callback(DEVICE_TWIN_UPDATE_STATE update_state
     }
 }
 
-static void dispatch_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, VECTOR_HANDLE call_backs)
+static void dispatch_user_callback(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, USER_CALLBACK_INFO* queued_cb)
+{
+    switch (queued_cb->type)
+    {
+        case CALLBACK_TYPE_DEVICE_TWIN:
+        {
+            IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK desired_state_callback;
+
+            if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+            {
+                LogError("failed locking for dispatch_user_callbacks");
+                desired_state_callback = NULL;
+            }
+            else
+            {
+                desired_state_callback = iotHubClientInstance->desired_state_callback;
+                (void)Unlock(iotHubClientInstance->LockHandle);
+            }
+
+            if (desired_state_callback)
+            {
+                desired_state_callback(queued_cb->iothub_callback.dev_twin_cb_info.update_state, queued_cb->iothub_callback.dev_twin_cb_info.payLoad, queued_cb->iothub_callback.dev_twin_cb_info.size, queued_cb->userContextCallback);
+            }
+
+            if (queued_cb->iothub_callback.dev_twin_cb_info.payLoad)
+            {
+                free(queued_cb->iothub_callback.dev_twin_cb_info.payLoad);
+            }
+            break;
+        }
+        case CALLBACK_TYPE_EVENT_CONFIRM:
+            if (iotHubClientInstance->event_confirm_callback)
+            {
+                iotHubClientInstance->event_confirm_callback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
+            }
+            break;
+        case CALLBACK_TYPE_REPORTED_STATE:
+            if (iotHubClientInstance->reported_state_callback)
+            {
+                iotHubClientInstance->reported_state_callback(queued_cb->iothub_callback.reported_state_cb_info.status_code, queued_cb->userContextCallback);
+            }
+            break;
+        case CALLBACK_TYPE_CONNECTION_STATUS:
+            if (iotHubClientInstance->connection_status_callback)
+            {
+                iotHubClientInstance->connection_status_callback(queued_cb->iothub_callback.connection_status_cb_info.connection_status, queued_cb->iothub_callback.connection_status_cb_info.status_reason, queued_cb->userContextCallback);
+            }
+            break;
+        case CALLBACK_TYPE_DEVICE_METHOD:
+            if (iotHubClientInstance->device_method_callback)
+            {
+                const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
+                const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
+                size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+
+                unsigned char* payload_resp = NULL;
+                size_t response_size = 0;
+                int status = iotHubClientInstance->device_method_callback(method_name, payload, payload_len, &payload_resp, &response_size, queued_cb->userContextCallback);
+
+                if (payload_resp && (response_size > 0))
+                {
+                    IOTHUB_CLIENT_HANDLE handle = iotHubClientInstance->method_user_context->iotHubClientHandle;
+                    IOTHUB_CLIENT_RESULT result = IoTHubClient_DeviceMethodResponse(handle, queued_cb->iothub_callback.method_cb_info.method_id, (const unsigned char*)payload_resp, response_size, status);
+                    if (result != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("IoTHubClient_LL_DeviceMethodResponse failed");
+                    }
+                }
+
+                BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
+                STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
+                
+                if (payload_resp)
+                {
+                    free(payload_resp);
+                }
+            }
+            break;
+        case CALLBACK_TYPE_INBOUD_DEVICE_METHOD:
+            if (iotHubClientInstance->inbound_device_method_callback)
+            {
+                const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
+                const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
+                size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+
+                iotHubClientInstance->inbound_device_method_callback(method_name, payload, payload_len, queued_cb->iothub_callback.method_cb_info.method_id, queued_cb->userContextCallback);
+
+                BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
+                STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
+            }
+            break;
+        case CALLBACK_TYPE_MESSAGE:
+            if (iotHubClientInstance->message_callback)
+            {
+                IOTHUBMESSAGE_DISPOSITION_RESULT disposition = iotHubClientInstance->message_callback(queued_cb->iothub_callback.message_cb_info->messageHandle, queued_cb->userContextCallback);
+                IOTHUB_CLIENT_HANDLE handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
+
+                if (Lock(handle->LockHandle) == LOCK_OK)
+                {
+                    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendMessageDisposition(handle->IoTHubClientLLHandle, queued_cb->iothub_callback.message_cb_info, disposition);
+                    (void)Unlock(handle->LockHandle);
+                    if (result != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("IoTHubClient_LL_SendMessageDisposition failed");
+                    }
+                }
+                else
+                {
+                    LogError("Lock failed");
+                }
+            }
+            break;
+        default:
+            LogError("Invalid callback type '%s'", ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
+            break;
+    }
+}
+
+static void dispatched_user_callback_task(void* context)
+{
+    DISPATCHED_USER_CALLBACK* dispatched_callback = (DISPATCHED_USER_CALLBACK*)context;
+
+    dispatch_user_callback(dispatched_callback->iotHubClientInstance, &dispatched_callback->callback_info);
+    free(dispatched_callback);
+}
+
+/*callbacks of the same category share a lane of the executor, so they still run one at a time and in order*/
+static size_t get_callback_executor_lane(USER_CALLBACK_TYPE type)
+{
+    return (type == CALLBACK_TYPE_INBOUD_DEVICE_METHOD) ? (size_t)CALLBACK_TYPE_DEVICE_METHOD : (size_t)type;
+}
+
+static void dispatch_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, CALLBACK_EXECUTOR_HANDLE callback_executor, VECTOR_HANDLE call_backs)
 {
     size_t callbacks_length = VECTOR_size(call_backs);
     size_t index;
@@ -409,125 +569,129 @@ static void dispatch_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance
         {
             LogError("VECTOR_element at index %zd is NULL.", index);
         }
+        else if (callback_executor == NULL)
+        {
+            dispatch_user_callback(iotHubClientInstance, queued_cb);
+        }
         else
         {
-            switch (queued_cb->type)
+            DISPATCHED_USER_CALLBACK* dispatched_callback = (DISPATCHED_USER_CALLBACK*)malloc(sizeof(DISPATCHED_USER_CALLBACK));
+            if (dispatched_callback == NULL)
+            {
+                /* Codes_SRS_IOTHUBCLIENT_09_018: [ If the callback cannot be submitted to the executor, it shall be invoked on the worker thread. ] */
+                LogError("Failed allocating the dispatched callback; invoking it on the worker thread");
+                dispatch_user_callback(iotHubClientInstance, queued_cb);
+            }
+            else
             {
-                case CALLBACK_TYPE_DEVICE_TWIN:
+                dispatched_callback->iotHubClientInstance = iotHubClientInstance;
+                dispatched_callback->callback_info = *queued_cb;
+
+                /* Codes_SRS_IOTHUBCLIENT_09_017: [ If a callback executor is set, the worker thread shall submit each user callback to it with the client as owner and the callback category as lane, the device method and inbound device method callbacks sharing one lane. ] */
+                if (callback_executor_submit(callback_executor, iotHubClientInstance, get_callback_executor_lane(queued_cb->type), dispatched_user_callback_task, dispatched_callback) != 0)
                 {
-                    IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK desired_state_callback;
+                    LogError("callback_executor_submit failed; invoking the callback on the worker thread");
+                    free(dispatched_callback);
+                    dispatch_user_callback(iotHubClientInstance, queued_cb);
+                }
+            }
+        }
+    }
+    VECTOR_destroy(call_backs);
+}
 
-                    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
-                    {
-                        LogError("failed locking for dispatch_user_callbacks");
-                        desired_state_callback = NULL;
-                    }
-                    else
-                    {
-                        desired_state_callback = iotHubClientInstance->desired_state_callback;
-                        (void)Unlock(iotHubClientInstance->LockHandle);
-                    }
+/*submitted_event is NULL when eventMessageHandle does not come from the submission queue*/
+static IOTHUB_CLIENT_RESULT ll_send_event_async(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, const SUBMITTED_EVENT* submitted_event, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
 
-                    if (desired_state_callback)
-                    {
-                        desired_state_callback(queued_cb->iothub_callback.dev_twin_cb_info.update_state, queued_cb->iothub_callback.dev_twin_cb_info.payLoad, queued_cb->iothub_callback.dev_twin_cb_info.size, queued_cb->userContextCallback);
-                    }
+    if (submitted_event == NULL)
+    {
+        result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+    else
+    {
+        tickcounter_ms_t now_ms;
+        tickcounter_ms_t queued_ms = 0;
 
-                    if (queued_cb->iothub_callback.dev_twin_cb_info.payLoad)
-                    {
-                        free(queued_cb->iothub_callback.dev_twin_cb_info.payLoad);
-                    }
-                    break;
-                }
-                case CALLBACK_TYPE_EVENT_CONFIRM:
-                    if (iotHubClientInstance->event_confirm_callback)
-                    {
-                        iotHubClientInstance->event_confirm_callback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
-                    }
-                    break;
-                case CALLBACK_TYPE_REPORTED_STATE:
-                    if (iotHubClientInstance->reported_state_callback)
-                    {
-                        iotHubClientInstance->reported_state_callback(queued_cb->iothub_callback.reported_state_cb_info.status_code, queued_cb->userContextCallback);
-                    }
-                    break;
-                case CALLBACK_TYPE_CONNECTION_STATUS:
-                    if (iotHubClientInstance->connection_status_callback)
-                    {
-                        iotHubClientInstance->connection_status_callback(queued_cb->iothub_callback.connection_status_cb_info.connection_status, queued_cb->iothub_callback.connection_status_cb_info.status_reason, queued_cb->userContextCallback);
-                    }
-                    break;
-                case CALLBACK_TYPE_DEVICE_METHOD:
-                    if (iotHubClientInstance->device_method_callback)
-                    {
-                        const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
-                        const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
-                        size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+        /* Codes_SRS_IOTHUBCLIENT_09_022: [ The worker thread shall pass to IoTHubClient_LL_SendQueuedEventAsync the time elapsed since the event was submitted, so that its send latency and messageTimeout start when IoTHubClient_SendEventAsync was called. ] */
+        if (submitted_event->has_submitted_ms &&
+            tickcounter_get_current_ms(iotHubClientInstance->submission_tick_counter, &now_ms) == 0 &&
+            now_ms > submitted_event->submitted_ms)
+        {
+            queued_ms = now_ms - submitted_event->submitted_ms;
+        }
 
-                        unsigned char* payload_resp = NULL;
-                        size_t response_size = 0;
-                        int status = iotHubClientInstance->device_method_callback(method_name, payload, payload_len, &payload_resp, &response_size, queued_cb->userContextCallback);
+        result = IoTHubClient_LL_SendQueuedEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, queued_ms, eventConfirmationCallback, userContextCallback);
+    }
 
-                        if (payload_resp && (response_size > 0))
-                        {
-                            IOTHUB_CLIENT_HANDLE handle = iotHubClientInstance->method_user_context->iotHubClientHandle;
-                            IOTHUB_CLIENT_RESULT result = IoTHubClient_DeviceMethodResponse(handle, queued_cb->iothub_callback.method_cb_info.method_id, (const unsigned char*)payload_resp, response_size, status);
-                            if (result != IOTHUB_CLIENT_OK)
-                            {
-                                LogError("IoTHubClient_LL_DeviceMethodResponse failed");
-                            }
-                        }
+    return result;
+}
 
-                        BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
-                        STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
-                        
-                        if (payload_resp)
-                        {
-                            free(payload_resp);
-                        }
-                    }
-                    break;
-                case CALLBACK_TYPE_INBOUD_DEVICE_METHOD:
-                    if (iotHubClientInstance->inbound_device_method_callback)
-                    {
-                        const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
-                        const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
-                        size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+/*must be called with the LockHandle taken*/
+static IOTHUB_CLIENT_RESULT send_event_async_locked(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, const SUBMITTED_EVENT* submitted_event, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
 
-                        iotHubClientInstance->inbound_device_method_callback(method_name, payload, payload_len, queued_cb->iothub_callback.method_cb_info.method_id, queued_cb->userContextCallback);
+    if (iotHubClientInstance->created_with_transport_handle != 0 || eventConfirmationCallback == NULL)
+    {
+        result = ll_send_event_async(iotHubClientInstance, submitted_event, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUBCLIENT_07_001: [ IoTHubClient_SendEventAsync shall allocate a IOTHUB_QUEUE_CONTEXT object to be sent to the IoTHubClient_LL_SendEventAsync function as a user context. ] */
+        IOTHUB_QUEUE_CONTEXT* queue_context = (IOTHUB_QUEUE_CONTEXT*)malloc(sizeof(IOTHUB_QUEUE_CONTEXT));
+        if (queue_context == NULL)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Failed allocating QUEUE_CONTEXT");
+        }
+        else
+        {
+            queue_context->iotHubClientHandle = iotHubClientInstance;
+            queue_context->userContextCallback = userContextCallback;
+            /* Codes_SRS_IOTHUBCLIENT_01_012: [IoTHubClient_SendEventAsync shall call IoTHubClient_LL_SendEventAsync, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters eventMessageHandle, eventConfirmationCallback and userContextCallback.] */
+            /* Codes_SRS_IOTHUBCLIENT_01_013: [When IoTHubClient_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClient_LL_SendEventAsync.] */
+            result = ll_send_event_async(iotHubClientInstance, submitted_event, eventMessageHandle, iothub_ll_event_confirm_callback, queue_context);
+            if (result != IOTHUB_CLIENT_OK)
+            {
+                LogError("IoTHubClient_LL_SendEventAsync failed");
+                free(queue_context);
+            }
+        }
+    }
 
-                        BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
-                        STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
-                    }
-                    break;
-                case CALLBACK_TYPE_MESSAGE:
-                    if (iotHubClientInstance->message_callback)
-                    {
-                        IOTHUBMESSAGE_DISPOSITION_RESULT disposition = iotHubClientInstance->message_callback(queued_cb->iothub_callback.message_cb_info->messageHandle, queued_cb->userContextCallback);
-                        IOTHUB_CLIENT_HANDLE handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
+    return result;
+}
 
-                        if (Lock(handle->LockHandle) == LOCK_OK)
-                        {
-                            IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendMessageDisposition(handle->IoTHubClientLLHandle, queued_cb->iothub_callback.message_cb_info, disposition);
-                            (void)Unlock(handle->LockHandle);
-                            if (result != IOTHUB_CLIENT_OK)
-                            {
-                                LogError("IoTHubClient_LL_SendMessageDisposition failed");
-                            }
-                        }
-                        else
-                        {
-                            LogError("Lock failed");
-                        }
-                    }
-                    break;
-                default:
-                    LogError("Invalid callback type '%s'", ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
-                    break;
+/*must be called with the LockHandle taken, which also makes the worker thread the only consumer of the submission queue*/
+static void send_submitted_events(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    SUBMITTED_EVENT submitted_event;
+
+    while (submission_queue_pop(iotHubClientInstance->submission_queue, &submitted_event) == 0)
+    {
+        /* Codes_SRS_IOTHUBCLIENT_09_008: [ Each event taken from the submission queue shall be passed to IoTHubClient_LL_SendQueuedEventAsync in the order it was submitted, which takes ownership of its message clone on success. ] */
+        if (send_event_async_locked(iotHubClientInstance, &submitted_event, submitted_event.message, submitted_event.eventConfirmationCallback, submitted_event.userContextCallback) != IOTHUB_CLIENT_OK)
+        {
+            LogError("Failed sending a submitted event");
+
+            if (submitted_event.eventConfirmationCallback != NULL)
+            {
+                /* Codes_SRS_IOTHUBCLIENT_09_009: [ If IoTHubClient_LL_SendQueuedEventAsync fails for a submitted event, its message clone shall be destroyed and the event confirmation callback shall be queued with IOTHUB_CLIENT_CONFIRMATION_ERROR. ] */
+                USER_CALLBACK_INFO queue_cb_info;
+                queue_cb_info.type = CALLBACK_TYPE_EVENT_CONFIRM;
+                queue_cb_info.userContextCallback = submitted_event.userContextCallback;
+                queue_cb_info.iothub_callback.event_confirm_cb_info.confirm_result = IOTHUB_CLIENT_CONFIRMATION_ERROR;
+                if (VECTOR_push_back(iotHubClientInstance->saved_user_callback_list, &queue_cb_info, 1) != 0)
+                {
+                    LogError("event confirm callback vector push failed.");
+                }
             }
+
+            IoTHubMessage_Destroy(submitted_event.message);
         }
     }
-    VECTOR_destroy(call_backs);
 }
 
 static void ScheduleWork_Thread_ForMultiplexing(void* iotHubClientHandle)
@@ -540,6 +704,7 @@ static void ScheduleWork_Thread_ForMultiplexing(void* iotHubClientHandle)
     if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
     {
         VECTOR_HANDLE call_backs = VECTOR_move(iotHubClientInstance->saved_user_callback_list);
+        CALLBACK_EXECUTOR_HANDLE callback_executor = iotHubClientInstance->callback_executor;
         (void)Unlock(iotHubClientInstance->LockHandle);
 
         if (call_backs == NULL)
@@ -548,7 +713,7 @@ static void ScheduleWork_Thread_ForMultiplexing(void* iotHubClientHandle)
         }
         else
         {
-            dispatch_user_callbacks(iotHubClientInstance, call_backs);
+            dispatch_user_callbacks(iotHubClientInstance, callback_executor, call_backs);
         }
     }
     else
@@ -573,6 +738,9 @@ static int ScheduleWork_Thread(void* threadArgument)
             }
             else
             {
+                /* Codes_SRS_IOTHUBCLIENT_09_007: [ Before calling IoTHubClient_LL_DoWork, the thread shall pass every event in the submission queue to IoTHubClient_LL_SendQueuedEventAsync. ] */
+                send_submitted_events(iotHubClientInstance);
+
                 /* Codes_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every 1 ms.] */
                 /* Codes_SRS_IOTHUBCLIENT_01_039: [All calls to IoTHubClient_LL_DoWork shall be protected by the lock created in IotHubClient_Create.] */
                 IoTHubClient_LL_DoWork(iotHubClientInstance->IoTHubClientLLHandle);
@@ -581,6 +749,7 @@ static int ScheduleWork_Thread(void* threadArgument)
                 garbageCollectorImpl(iotHubClientInstance);
 #endif
                 VECTOR_HANDLE call_backs = VECTOR_move(iotHubClientInstance->saved_user_callback_list);
+                CALLBACK_EXECUTOR_HANDLE callback_executor = iotHubClientInstance->callback_executor;
                 (void)Unlock(iotHubClientInstance->LockHandle);
                 if (call_backs == NULL)
                 {
@@ -588,7 +757,7 @@ static int ScheduleWork_Thread(void* threadArgument)
                 }
                 else
                 {
-                    dispatch_user_callbacks(iotHubClientInstance, call_backs);
+                    dispatch_user_callbacks(iotHubClientInstance, callback_executor, call_backs);
                 }
             }
         }
@@ -668,6 +837,9 @@ static IOTHUB_CLIENT_INSTANCE* create_iothub_instance(const IOTHUB_CLIENT_CONFIG
             {
                 result->TransportHandle = transportHandle;
                 result->created_with_transport_handle = 0;
+                result->submission_queue = NULL;
+                result->submission_tick_counter = NULL;
+                result->callback_executor = NULL;
                 if (config != NULL)
                 {
                     if (transportHandle != NULL)
@@ -766,6 +938,26 @@ static IOTHUB_CLIENT_INSTANCE* create_iothub_instance(const IOTHUB_CLIENT_CONFIG
                     free(result);
                     result = NULL;
                 }
+                /* Codes_SRS_IOTHUBCLIENT_09_005: [ If the transport is not shared, IoTHubClient_Create shall create a submission queue for events sent with IoTHubClient_SendEventAsync. ] */
+                else if (transportHandle == NULL &&
+                    ((result->submission_queue = submission_queue_create(sizeof(SUBMITTED_EVENT), IOTHUB_CLIENT_SUBMISSION_QUEUE_CAPACITY)) == NULL ||
+                    (result->submission_tick_counter = tickcounter_create()) == NULL))
+                {
+                    /* Codes_SRS_IOTHUBCLIENT_09_006: [ If creating the submission queue or its tick counter fails, IoTHubClient_Create shall free all resources it allocated and return NULL. ] */
+                    LogError("Failure creating submission queue");
+                    if (result->submission_queue != NULL)
+                    {
+                        submission_queue_destroy(result->submission_queue);
+                    }
+                    IoTHubClient_LL_Destroy(result->IoTHubClientLLHandle);
+                    Lock_Deinit(result->LockHandle);
+#ifndef DONT_USE_UPLOADTOBLOB
+                    singlylinkedlist_destroy(result->savedDataToBeCleaned);
+#endif
+                    VECTOR_destroy(result->saved_user_callback_list);
+                    free(result);
+                    result = NULL;
+                }
                 else
                 {
                     result->ThreadHandle = NULL;
@@ -880,16 +1072,6 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
             okToJoin = false;
         }
 
-        /* Codes_SRS_IOTHUBCLIENT_01_006: [That includes destroying the IoTHubClient_LL instance by calling IoTHubClient_LL_Destroy.] */
-        IoTHubClient_LL_Destroy(iotHubClientInstance->IoTHubClientLLHandle);
-
-#ifndef DONT_USE_UPLOADTOBLOB
-        if (iotHubClientInstance->savedDataToBeCleaned != NULL)
-        {
-            singlylinkedlist_destroy(iotHubClientInstance->savedDataToBeCleaned);
-        }
-#endif
-
         /*Codes_SRS_IOTHUBCLIENT_02_045: [ IoTHubClient_Destroy shall unlock the serializing lock. ]*/
         if (Unlock(iotHubClientInstance->LockHandle) != LOCK_OK)
         {
@@ -915,6 +1097,33 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
             }
         }
 
+        if (iotHubClientInstance->callback_executor != NULL)
+        {
+            /* Codes_SRS_IOTHUBCLIENT_09_019: [ Once the worker thread is joined, IoTHubClient_Destroy shall wait for the callbacks of the client submitted to the callback executor to complete by calling callback_executor_drain. ] */
+            callback_executor_drain(iotHubClientInstance->callback_executor, iotHubClientInstance);
+        }
+
+        /* Codes_SRS_IOTHUBCLIENT_09_020: [ IoTHubClient_Destroy shall destroy the IoTHubClient_LL instance only after the worker thread is joined and the callback executor is drained, since the callbacks still queued may call into it. ] */
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            LogError("unable to Lock - - will still proceed to destroy the LL instance without locking");
+        }
+
+        /* Codes_SRS_IOTHUBCLIENT_01_006: [That includes destroying the IoTHubClient_LL instance by calling IoTHubClient_LL_Destroy.] */
+        IoTHubClient_LL_Destroy(iotHubClientInstance->IoTHubClientLLHandle);
+
+#ifndef DONT_USE_UPLOADTOBLOB
+        if (iotHubClientInstance->savedDataToBeCleaned != NULL)
+        {
+            singlylinkedlist_destroy(iotHubClientInstance->savedDataToBeCleaned);
+        }
+#endif
+
+        if (Unlock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            LogError("unable to Unlock");
+        }
+
         vector_size = VECTOR_size(iotHubClientInstance->saved_user_callback_list);
         size_t index = 0;
         for (index = 0; index < vector_size; index++)
@@ -945,6 +1154,23 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
         }
         VECTOR_destroy(iotHubClientInstance->saved_user_callback_list);
 
+        if (iotHubClientInstance->submission_queue != NULL)
+        {
+            SUBMITTED_EVENT submitted_event;
+
+            /* Codes_SRS_IOTHUBCLIENT_09_013: [ IoTHubClient_Destroy shall call the event confirmation callback of each event still in the submission queue with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, destroy its message clone and then destroy the submission queue. ] */
+            while (submission_queue_pop(iotHubClientInstance->submission_queue, &submitted_event) == 0)
+            {
+                if (submitted_event.eventConfirmationCallback != NULL)
+                {
+                    submitted_event.eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, submitted_event.userContextCallback);
+                }
+                IoTHubMessage_Destroy(submitted_event.message);
+            }
+            submission_queue_destroy(iotHubClientInstance->submission_queue);
+            tickcounter_destroy(iotHubClientInstance->submission_tick_counter);
+        }
+
         if (iotHubClientInstance->TransportHandle == NULL)
         {
             /* Codes_SRS_IOTHUBCLIENT_01_032: [If the lock was allocated in IoTHubClient_Create, it shall be also freed..] */
@@ -980,6 +1206,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
         result = IOTHUB_CLIENT_INVALID_ARG;
         LogError("NULL iothubClientHandle");
     }
+    else if (eventMessageHandle == NULL || (eventConfirmationCallback == NULL && userContextCallback != NULL))
+    {
+        /* Codes_SRS_IOTHUBCLIENT_09_010: [ If eventMessageHandle is NULL, or eventConfirmationCallback is NULL and userContextCallback is not NULL, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_INVALID_ARG. ] */
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("invalid parameter IOTHUB_MESSAGE_HANDLE eventMessageHandle=%p, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback=%p, void* userContextCallback=%p", eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
     else
     {
         IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
@@ -993,50 +1225,60 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
         }
         else
         {
+            bool send_under_lock = (iotHubClientInstance->submission_queue == NULL);
+
             if (iotHubClientInstance->created_with_transport_handle == 0)
             {
                 iotHubClientInstance->event_confirm_callback = eventConfirmationCallback;
             }
 
-            /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
-            if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+            if (iotHubClientInstance->submission_queue != NULL)
             {
-                /* Codes_SRS_IOTHUBCLIENT_01_026: [If acquiring the lock fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
-                result = IOTHUB_CLIENT_ERROR;
-                LogError("Could not acquire lock");
+                SUBMITTED_EVENT submitted_event;
+                submitted_event.eventConfirmationCallback = eventConfirmationCallback;
+                submitted_event.userContextCallback = userContextCallback;
+                /* Codes_SRS_IOTHUBCLIENT_09_021: [ IoTHubClient_SendEventAsync shall stamp the submitted event with the current time of the tick counter of the submission queue. ] */
+                submitted_event.has_submitted_ms = (tickcounter_get_current_ms(iotHubClientInstance->submission_tick_counter, &submitted_event.submitted_ms) == 0);
+
+                /* Codes_SRS_IOTHUBCLIENT_09_011: [ If the client has a submission queue, IoTHubClient_SendEventAsync shall clone eventMessageHandle and push the clone, eventConfirmationCallback and userContextCallback to the submission queue without taking the lock, and return IOTHUB_CLIENT_OK. ] */
+                if ((submitted_event.message = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("Failed cloning the event message");
+                }
+                else if (submission_queue_push(iotHubClientInstance->submission_queue, &submitted_event) != 0)
+                {
+                    /* Codes_SRS_IOTHUBCLIENT_09_012: [ If the submission queue is full, IoTHubClient_SendEventAsync shall destroy the clone, take the lock, pass the events already in the submission queue to IoTHubClient_LL_SendQueuedEventAsync and then send eventMessageHandle as if there was no submission queue. ] */
+                    IoTHubMessage_Destroy(submitted_event.message);
+                    send_under_lock = true;
+                }
+                else
+                {
+                    result = IOTHUB_CLIENT_OK;
+                }
             }
-            else
+
+            if (send_under_lock)
             {
-                if (iotHubClientInstance->created_with_transport_handle != 0 || eventConfirmationCallback == NULL)
+                /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
+                if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
                 {
-                    result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+                    /* Codes_SRS_IOTHUBCLIENT_01_026: [If acquiring the lock fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("Could not acquire lock");
                 }
                 else
                 {
-                    /* Codes_SRS_IOTHUBCLIENT_07_001: [ IoTHubClient_SendEventAsync shall allocate a IOTHUB_QUEUE_CONTEXT object to be sent to the IoTHubClient_LL_SendEventAsync function as a user context. ] */
-                    IOTHUB_QUEUE_CONTEXT* queue_context = (IOTHUB_QUEUE_CONTEXT*)malloc(sizeof(IOTHUB_QUEUE_CONTEXT));
-                    if (queue_context == NULL)
+                    if (iotHubClientInstance->submission_queue != NULL)
                     {
-                        result = IOTHUB_CLIENT_ERROR;
-                        LogError("Failed allocating QUEUE_CONTEXT");
+                        send_submitted_events(iotHubClientInstance);
                     }
-                    else
-                    {
-                        queue_context->iotHubClientHandle = iotHubClientInstance;
-                        queue_context->userContextCallback = userContextCallback;
-                        /* Codes_SRS_IOTHUBCLIENT_01_012: [IoTHubClient_SendEventAsync shall call IoTHubClient_LL_SendEventAsync, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters eventMessageHandle, eventConfirmationCallback and userContextCallback.] */
-                        /* Codes_SRS_IOTHUBCLIENT_01_013: [When IoTHubClient_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClient_LL_SendEventAsync.] */
-                        result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, iothub_ll_event_confirm_callback, queue_context);
-                        if (result != IOTHUB_CLIENT_OK)
-                        {
-                            LogError("IoTHubClient_LL_SendEventAsync failed");
-                            free(queue_context);
-                        }
-                    }
-                }
 
-                /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
-                (void)Unlock(iotHubClientInstance->LockHandle);
+                    result = send_event_async_locked(iotHubClientInstance, NULL, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+
+                    /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
+                    (void)Unlock(iotHubClientInstance->LockHandle);
+                }
             }
         }
     }
@@ -1067,6 +1309,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClien
         }
         else
         {
+            /* Codes_SRS_IOTHUBCLIENT_09_014: [ IoTHubClient_GetSendStatus shall first pass the events in the submission queue to IoTHubClient_LL_SendQueuedEventAsync, so that they are accounted for in the status. ] */
+            if (iotHubClientInstance->submission_queue != NULL)
+            {
+                send_submitted_events(iotHubClientInstance);
+            }
+
             /* Codes_SRS_IOTHUBCLIENT_01_022: [IoTHubClient_GetSendStatus shall call IoTHubClient_LL_GetSendStatus, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameter iotHubClientStatus.] */
             /* Codes_SRS_IOTHUBCLIENT_01_024: [Otherwise, IoTHubClient_GetSendStatus shall return the result of IoTHubClient_LL_GetSendStatus.] */
             result = IoTHubClient_LL_GetSendStatus(iotHubClientInstance->IoTHubClientLLHandle, iotHubClientStatus);
@@ -1359,6 +1607,39 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetLastMessageReceiveTime(IOTHUB_CLIENT_HANDLE
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_GetStatistics(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        /* Codes_SRS_IOTHUBCLIENT_09_001: [If iotHubClientHandle is NULL, IoTHubClient_GetStatistics shall return IOTHUB_CLIENT_INVALID_ARG.] */
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        /* Codes_SRS_IOTHUBCLIENT_09_002: [IoTHubClient_GetStatistics shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /* Codes_SRS_IOTHUBCLIENT_09_003: [If acquiring the lock fails, IoTHubClient_GetStatistics shall return IOTHUB_CLIENT_ERROR.] */
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUBCLIENT_09_004: [Otherwise IoTHubClient_GetStatistics shall call IoTHubClient_LL_GetStatistics, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameter statistics, and return its result.] */
+            result = IoTHubClient_LL_GetStatistics(iotHubClientInstance->IoTHubClientLLHandle, statistics);
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1387,11 +1668,29 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHan
         }
         else
         {
-            /*Codes_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.] */
-            result = IoTHubClient_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, value);
-            if (result != IOTHUB_CLIENT_OK)
+            if (strcmp(optionName, OPTION_CALLBACK_EXECUTOR) == 0)
             {
-                LogError("IoTHubClient_LL_SetOption failed");
+                if (iotHubClientInstance->callback_executor != NULL)
+                {
+                    /* Codes_SRS_IOTHUBCLIENT_09_016: [ If a callback executor is already set, IoTHubClient_SetOption shall return IOTHUB_CLIENT_ERROR. ] */
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("A callback executor is already set");
+                }
+                else
+                {
+                    /* Codes_SRS_IOTHUBCLIENT_09_015: [ If optionName is OPTION_CALLBACK_EXECUTOR, IoTHubClient_SetOption shall save `value` as the CALLBACK_EXECUTOR_HANDLE running the user callbacks of the client and return IOTHUB_CLIENT_OK. ] */
+                    iotHubClientInstance->callback_executor = (CALLBACK_EXECUTOR_HANDLE)value;
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.] */
+                result = IoTHubClient_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, value);
+                if (result != IOTHUB_CLIENT_OK)
+                {
+                    LogError("IoTHubClient_LL_SetOption failed");
+                }
             }
 
             (void)Unlock(iotHubClientInstance->LockHandle);
@@ -1760,8 +2059,7 @@ static int uploadingThread(void *data)
     if (Lock(savedData->iotHubClientHandle->LockHandle) == LOCK_OK)
     {
         IOTHUB_CLIENT_FILE_UPLOAD_RESULT upload_result;
-        /*it so happens that IoTHubClient_LL_UploadToBlob is thread-safe because there's no saved state in the handle and there are no globals, so no need to protect it*/
-        /*not having it protected means multiple simultaneous uploads can happen*/
+        /*IoTHubClient_LL_UploadToBlob saves in the handle the progress of an interrupted upload, so the uploads are serialized*/
         /*Codes_SRS_IOTHUBCLIENT_02_054: [ The thread shall call IoTHubClient_LL_UploadToBlob passing the information packed in the structure. ]*/
         if (IoTHubClient_LL_UploadToBlob(savedData->iotHubClientHandle->IoTHubClientLLHandle, savedData->destinationFileName, savedData->source, savedData->size) == IOTHUB_CLIENT_OK)
         {
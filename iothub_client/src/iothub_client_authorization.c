@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
@@ -15,6 +16,8 @@
 
 #define DEFAULT_SAS_TOKEN_EXPIRY_TIME_SECS          3600
 #define INDEFINITE_TIME                             ((time_t)(-1))
+/*a cached sas token is handed out again while it still has at least (100 - SAS_TOKEN_REUSE_PERCENT)% of the requested lifetime left*/
+#define SAS_TOKEN_REUSE_PERCENT                     10
 
 typedef struct IOTHUB_AUTHORIZATION_DATA_TAG
 {
@@ -23,6 +26,9 @@ typedef struct IOTHUB_AUTHORIZATION_DATA_TAG
     char* device_id;
     size_t token_expiry_time_sec;
     IOTHUB_CREDENTIAL_TYPE cred_type;
+    STRING_HANDLE cached_sas_token; /*the last sas token created from device_key*/
+    char* cached_scope;
+    size_t cached_expiry_time;
 } IOTHUB_AUTHORIZATION_DATA;
 
 static int get_seconds_since_epoch(size_t* seconds)
@@ -42,6 +48,44 @@ static int get_seconds_since_epoch(size_t* seconds)
     return result;
 }
 
+static bool is_cached_sas_token_usable(const IOTHUB_AUTHORIZATION_DATA* handle, const char* scope, size_t expire_time, size_t expiry_time)
+{
+    return (handle->cached_sas_token != NULL) &&
+        (strcmp(handle->cached_scope, scope) == 0) &&
+        (handle->cached_expiry_time + (expire_time / 100) * SAS_TOKEN_REUSE_PERCENT >= expiry_time);
+}
+
+/*takes ownership of sas_token*/
+static void cache_sas_token(IOTHUB_AUTHORIZATION_DATA* handle, const char* scope, STRING_HANDLE sas_token, size_t expiry_time)
+{
+    if ((handle->cached_scope == NULL) || (strcmp(handle->cached_scope, scope) != 0))
+    {
+        free(handle->cached_scope);
+        if (mallocAndStrcpy_s(&handle->cached_scope, scope) != 0)
+        {
+            /*not caching is not an error, the next call creates a new token*/
+            LogError("Failed copying scope, sas token will not be cached");
+            handle->cached_scope = NULL;
+        }
+    }
+
+    if (handle->cached_sas_token != NULL)
+    {
+        STRING_delete(handle->cached_sas_token);
+    }
+
+    if (handle->cached_scope == NULL)
+    {
+        STRING_delete(sas_token);
+        handle->cached_sas_token = NULL;
+    }
+    else
+    {
+        handle->cached_sas_token = sas_token;
+        handle->cached_expiry_time = expiry_time;
+    }
+}
+
 IOTHUB_AUTHORIZATION_HANDLE IoTHubClient_Auth_Create(const char* device_key, const char* device_id, const char* device_sas_token)
 {
     IOTHUB_AUTHORIZATION_DATA* result;
@@ -124,6 +168,11 @@ void IoTHubClient_Auth_Destroy(IOTHUB_AUTHORIZATION_HANDLE handle)
         free(handle->device_key);
         free(handle->device_id);
         free(handle->device_sas_token);
+        if (handle->cached_sas_token != NULL)
+        {
+            STRING_delete(handle->cached_sas_token);
+            free(handle->cached_scope);
+        }
         free(handle);
     }
 }
@@ -218,9 +267,19 @@ char* IoTHubClient_Auth_Get_SasToken(IOTHUB_AUTHORIZATION_HANDLE handle, const c
             }
             else 
             {
-                /* Codes_SRS_IoTHub_Authorization_07_011: [ IoTHubClient_Auth_Get_ConnString shall call SASToken_CreateString to construct the sas token. ] */
                 size_t expiry_time = sec_since_epoch+expire_time;
-                if ( (sas_token = SASToken_CreateString(handle->device_key, scope, key_name, expiry_time)) == NULL)
+                /* Codes_SRS_IoTHub_Authorization_07_025: [ If a sas token was previously created for the same scope and it expires no more than 10% of expire_time before the requested expiration time, IoTHubClient_Auth_Get_SasToken shall return a copy of that sas token without calling SASToken_CreateString. ] */
+                if (is_cached_sas_token_usable(handle, scope, expire_time, expiry_time))
+                {
+                    if (mallocAndStrcpy_s(&result, STRING_c_str(handle->cached_sas_token)) != 0)
+                    {
+                        /* Codes_SRS_IoTHub_Authorization_07_020: [ If any error is encountered IoTHubClient_Auth_Get_ConnString shall return NULL. ] */
+                        LogError("Failed copying result");
+                        result = NULL;
+                    }
+                }
+                /* Codes_SRS_IoTHub_Authorization_07_011: [ IoTHubClient_Auth_Get_ConnString shall call SASToken_CreateString to construct the sas token. ] */
+                else if ( (sas_token = SASToken_CreateString(handle->device_key, scope, key_name, expiry_time)) == NULL)
                 {
                     /* Codes_SRS_IoTHub_Authorization_07_020: [ If any error is encountered IoTHubClient_Auth_Get_ConnString shall return NULL. ] */
                     LogError("Failed creating sas_token");
@@ -234,8 +293,13 @@ char* IoTHubClient_Auth_Get_SasToken(IOTHUB_AUTHORIZATION_HANDLE handle, const c
                         /* Codes_SRS_IoTHub_Authorization_07_020: [ If any error is encountered IoTHubClient_Auth_Get_ConnString shall return NULL. ] */
                         LogError("Failed copying result");
                         result = NULL;
+                        STRING_delete(sas_token);
+                    }
+                    else
+                    {
+                        /* Codes_SRS_IoTHub_Authorization_07_026: [ IoTHubClient_Auth_Get_SasToken shall keep the sas token it created, its scope and its expiration time, replacing the previously kept sas token. ] */
+                        cache_sas_token(handle, scope, sas_token, expiry_time);
                     }
-                    STRING_delete(sas_token);
                 }
             }
         }
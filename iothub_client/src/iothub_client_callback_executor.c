@@ -0,0 +1,459 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "iothub_client_callback_executor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#define RESULT_OK           0
+// Submitters and drainers share one condition, whose post wakes a single waiter; they wait at most this long, so a
+// post consumed by another waiter only delays them.
+#define WAIT_INTERVAL_MS    10
+
+typedef struct EXECUTOR_TASK_TAG
+{
+	CALLBACK_EXECUTOR_TASK_FUNCTION function;
+	void* context;
+	struct EXECUTOR_TASK_TAG* next;
+} EXECUTOR_TASK;
+
+// A lane exists while it has a task queued or running.
+typedef struct EXECUTOR_LANE_TAG
+{
+	const void* owner;
+	size_t lane;
+	EXECUTOR_TASK* head;
+	EXECUTOR_TASK* tail;
+	bool is_running;
+	struct EXECUTOR_LANE_TAG* next;
+	// Link in the ready list, which holds the lanes with a queued task and none running
+	struct EXECUTOR_LANE_TAG* next_ready;
+} EXECUTOR_LANE;
+
+typedef struct CALLBACK_EXECUTOR_INSTANCE_TAG
+{
+	LOCK_HANDLE lock;
+	COND_HANDLE task_available;
+	COND_HANDLE task_completed;
+	// Guarded by lock
+	EXECUTOR_LANE* lanes;
+	EXECUTOR_LANE* ready_head;
+	EXECUTOR_LANE* ready_tail;
+	size_t pending_task_count;
+	size_t max_pending_tasks;
+	bool is_stopping;
+	THREAD_HANDLE* threads;
+	size_t thread_count;
+} CALLBACK_EXECUTOR_INSTANCE;
+
+static void push_ready_lane(CALLBACK_EXECUTOR_INSTANCE* executor, EXECUTOR_LANE* lane)
+{
+	lane->next_ready = NULL;
+
+	if (executor->ready_tail == NULL)
+	{
+		executor->ready_head = lane;
+	}
+	else
+	{
+		executor->ready_tail->next_ready = lane;
+	}
+
+	executor->ready_tail = lane;
+}
+
+static EXECUTOR_LANE* pop_ready_lane(CALLBACK_EXECUTOR_INSTANCE* executor)
+{
+	EXECUTOR_LANE* lane = executor->ready_head;
+
+	executor->ready_head = lane->next_ready;
+	if (executor->ready_head == NULL)
+	{
+		executor->ready_tail = NULL;
+	}
+
+	return lane;
+}
+
+static EXECUTOR_LANE* find_lane(CALLBACK_EXECUTOR_INSTANCE* executor, const void* owner, size_t lane_number, bool any_lane)
+{
+	EXECUTOR_LANE* lane = executor->lanes;
+
+	while ((lane != NULL) && ((lane->owner != owner) || (!any_lane && (lane->lane != lane_number))))
+	{
+		lane = lane->next;
+	}
+
+	return lane;
+}
+
+static void remove_lane(CALLBACK_EXECUTOR_INSTANCE* executor, EXECUTOR_LANE* lane)
+{
+	EXECUTOR_LANE** link = &executor->lanes;
+
+	while (*link != lane)
+	{
+		link = &(*link)->next;
+	}
+
+	*link = lane->next;
+	free(lane);
+}
+
+static int executor_thread(void* argument)
+{
+	CALLBACK_EXECUTOR_INSTANCE* executor = (CALLBACK_EXECUTOR_INSTANCE*)argument;
+
+	if (Lock(executor->lock) != LOCK_OK)
+	{
+		LogError("Failed locking the callback executor; the thread exits");
+	}
+	else
+	{
+		bool is_locked = true;
+
+		while (is_locked)
+		{
+			if (executor->ready_head == NULL)
+			{
+				/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_011: [ When stopping, the threads shall exit once no task is queued. ] */
+				if (executor->is_stopping)
+				{
+					break;
+				}
+
+				(void)Condition_Wait(executor->task_available, executor->lock, 0);
+			}
+			else
+			{
+				EXECUTOR_LANE* lane = pop_ready_lane(executor);
+				EXECUTOR_TASK* task = lane->head;
+
+				lane->head = task->next;
+				if (lane->head == NULL)
+				{
+					lane->tail = NULL;
+				}
+				lane->is_running = true;
+				(void)Unlock(executor->lock);
+
+				/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_009: [ The threads shall run the tasks of a lane one at a time, in the order they were submitted, and the tasks of different lanes concurrently, without holding the lock of the executor. ] */
+				task->function(task->context);
+				free(task);
+
+				if (Lock(executor->lock) != LOCK_OK)
+				{
+					// The lane stays busy: draining its owner would hang, which is better than running its tasks out of order
+					LogError("Failed locking the callback executor; the thread exits");
+					is_locked = false;
+				}
+				else
+				{
+					lane->is_running = false;
+					executor->pending_task_count--;
+
+					if (lane->head != NULL)
+					{
+						// Behind the lanes already waiting, so that a busy lane does not starve the others
+						push_ready_lane(executor, lane);
+					}
+					else
+					{
+						remove_lane(executor, lane);
+					}
+
+					(void)Condition_Post(executor->task_completed);
+				}
+			}
+		}
+
+		if (is_locked)
+		{
+			(void)Unlock(executor->lock);
+		}
+	}
+
+	ThreadAPI_Exit(0);
+	return 0;
+}
+
+static void stop_threads(CALLBACK_EXECUTOR_INSTANCE* executor)
+{
+	size_t i;
+
+	if (Lock(executor->lock) != LOCK_OK)
+	{
+		LogError("Failed locking the callback executor");
+	}
+	else
+	{
+		executor->is_stopping = true;
+		(void)Unlock(executor->lock);
+	}
+
+	// Each post wakes up one waiting thread; the others see is_stopping before waiting
+	for (i = 0; i < executor->thread_count; i++)
+	{
+		(void)Condition_Post(executor->task_available);
+	}
+
+	for (i = 0; i < executor->thread_count; i++)
+	{
+		int thread_result;
+
+		if (ThreadAPI_Join(executor->threads[i], &thread_result) != THREADAPI_OK)
+		{
+			LogError("ThreadAPI_Join failed");
+		}
+	}
+
+	executor->thread_count = 0;
+}
+
+static void destroy_executor(CALLBACK_EXECUTOR_INSTANCE* executor)
+{
+	if (executor->thread_count > 0)
+	{
+		stop_threads(executor);
+	}
+
+	while (executor->lanes != NULL)
+	{
+		EXECUTOR_LANE* lane = executor->lanes;
+
+		LogError("Tasks of owner %p were not run", lane->owner);
+		while (lane->head != NULL)
+		{
+			EXECUTOR_TASK* task = lane->head;
+			lane->head = task->next;
+			free(task);
+		}
+
+		executor->lanes = lane->next;
+		free(lane);
+	}
+
+	if (executor->task_completed != NULL)
+	{
+		Condition_Deinit(executor->task_completed);
+	}
+
+	if (executor->task_available != NULL)
+	{
+		Condition_Deinit(executor->task_available);
+	}
+
+	if (executor->lock != NULL)
+	{
+		(void)Lock_Deinit(executor->lock);
+	}
+
+	free(executor->threads);
+	free(executor);
+}
+
+CALLBACK_EXECUTOR_HANDLE callback_executor_create(size_t thread_count, size_t max_pending_tasks)
+{
+	CALLBACK_EXECUTOR_INSTANCE* result;
+
+	if ((thread_count == 0) || (max_pending_tasks == 0))
+	{
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_001: [ If `thread_count` or `max_pending_tasks` is zero, callback_executor_create shall fail and return NULL. ] */
+		LogError("Invalid argument (thread_count=%lu, max_pending_tasks=%lu)", (unsigned long)thread_count, (unsigned long)max_pending_tasks);
+		result = NULL;
+	}
+	else if ((result = (CALLBACK_EXECUTOR_INSTANCE*)malloc(sizeof(CALLBACK_EXECUTOR_INSTANCE))) == NULL)
+	{
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_003: [ If any resource fails to be created, callback_executor_create shall release the ones already created and return NULL. ] */
+		LogError("Failed allocating the callback executor");
+	}
+	else
+	{
+		(void)memset(result, 0, sizeof(CALLBACK_EXECUTOR_INSTANCE));
+		result->max_pending_tasks = max_pending_tasks;
+
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_002: [ callback_executor_create shall create a lock, two conditions and `thread_count` threads running the tasks. ] */
+		if ((result->lock = Lock_Init()) == NULL)
+		{
+			LogError("Lock_Init failed");
+			destroy_executor(result);
+			result = NULL;
+		}
+		else if (((result->task_available = Condition_Init()) == NULL) ||
+			((result->task_completed = Condition_Init()) == NULL))
+		{
+			LogError("Condition_Init failed");
+			destroy_executor(result);
+			result = NULL;
+		}
+		else if ((result->threads = (THREAD_HANDLE*)malloc(thread_count * sizeof(THREAD_HANDLE))) == NULL)
+		{
+			LogError("Failed allocating the callback executor threads");
+			destroy_executor(result);
+			result = NULL;
+		}
+		else
+		{
+			while (result->thread_count < thread_count)
+			{
+				if (ThreadAPI_Create(&result->threads[result->thread_count], executor_thread, result) != THREADAPI_OK)
+				{
+					LogError("ThreadAPI_Create failed");
+					break;
+				}
+
+				result->thread_count++;
+			}
+
+			if (result->thread_count < thread_count)
+			{
+				destroy_executor(result);
+				result = NULL;
+			}
+		}
+	}
+
+	return result;
+}
+
+void callback_executor_destroy(CALLBACK_EXECUTOR_HANDLE executor)
+{
+	if (executor == NULL)
+	{
+		LogError("Invalid argument (executor is NULL)");
+	}
+	else
+	{
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_004: [ callback_executor_destroy shall let the threads run the queued tasks, join them and release all the resources of the executor. ] */
+		destroy_executor(executor);
+	}
+}
+
+int callback_executor_submit(CALLBACK_EXECUTOR_HANDLE executor, const void* owner, size_t lane_number, CALLBACK_EXECUTOR_TASK_FUNCTION task_function, void* task_context)
+{
+	int result;
+	EXECUTOR_TASK* task;
+
+	if ((executor == NULL) || (task_function == NULL))
+	{
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_005: [ If `executor` or `task_function` is NULL, callback_executor_submit shall fail and return a non-zero value. ] */
+		LogError("Invalid argument (executor=%p)", executor);
+		result = __FAILURE__;
+	}
+	else if ((task = (EXECUTOR_TASK*)malloc(sizeof(EXECUTOR_TASK))) == NULL)
+	{
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_008: [ If any step fails, callback_executor_submit shall return a non-zero value and the task shall not be run. ] */
+		LogError("Failed allocating the task");
+		result = __FAILURE__;
+	}
+	else if (Lock(executor->lock) != LOCK_OK)
+	{
+		LogError("Failed locking the callback executor");
+		free(task);
+		result = __FAILURE__;
+	}
+	else
+	{
+		EXECUTOR_LANE* lane;
+
+		task->function = task_function;
+		task->context = task_context;
+		task->next = NULL;
+
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_006: [ While `max_pending_tasks` tasks are queued or running, callback_executor_submit shall wait for one of them to complete. ] */
+		while ((executor->pending_task_count >= executor->max_pending_tasks) && !executor->is_stopping)
+		{
+			(void)Condition_Wait(executor->task_completed, executor->lock, WAIT_INTERVAL_MS);
+		}
+
+		if (executor->is_stopping)
+		{
+			LogError("The callback executor is being destroyed");
+			lane = NULL;
+		}
+		else if ((lane = find_lane(executor, owner, lane_number, false)) == NULL)
+		{
+			if ((lane = (EXECUTOR_LANE*)malloc(sizeof(EXECUTOR_LANE))) == NULL)
+			{
+				LogError("Failed allocating the lane");
+			}
+			else
+			{
+				lane->owner = owner;
+				lane->lane = lane_number;
+				lane->head = NULL;
+				lane->tail = NULL;
+				lane->is_running = false;
+				lane->next_ready = NULL;
+				lane->next = executor->lanes;
+				executor->lanes = lane;
+			}
+		}
+
+		if (lane == NULL)
+		{
+			free(task);
+			result = __FAILURE__;
+		}
+		else
+		{
+			/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_007: [ callback_executor_submit shall queue the task at the end of the lane identified by `owner` and `lane`, and wake up a thread if the lane was idle. ] */
+			if (lane->tail == NULL)
+			{
+				lane->head = task;
+				if (!lane->is_running)
+				{
+					push_ready_lane(executor, lane);
+				}
+			}
+			else
+			{
+				lane->tail->next = task;
+			}
+			lane->tail = task;
+			executor->pending_task_count++;
+
+			result = RESULT_OK;
+		}
+
+		(void)Unlock(executor->lock);
+
+		if (result == RESULT_OK)
+		{
+			(void)Condition_Post(executor->task_available);
+		}
+	}
+
+	return result;
+}
+
+void callback_executor_drain(CALLBACK_EXECUTOR_HANDLE executor, const void* owner)
+{
+	if (executor == NULL)
+	{
+		LogError("Invalid argument (executor is NULL)");
+	}
+	else if (Lock(executor->lock) != LOCK_OK)
+	{
+		LogError("Failed locking the callback executor");
+	}
+	else
+	{
+		/* Codes_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_010: [ callback_executor_drain shall return once no task of `owner` is queued or running. ] */
+		while (find_lane(executor, owner, 0, true) != NULL)
+		{
+			(void)Condition_Wait(executor->task_completed, executor->lock, WAIT_INTERVAL_MS);
+		}
+
+		(void)Unlock(executor->lock);
+	}
+}
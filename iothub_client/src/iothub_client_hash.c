@@ -0,0 +1,26 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdint.h>
+#include "iothub_client_hash.h"
+
+#define FNV1A_32_OFFSET_BASIS 2166136261u
+#define FNV1A_32_PRIME 16777619u
+
+uint32_t hash_fnv1a(const char* text)
+{
+	// Codes_SRS_IOTHUB_CLIENT_HASH_09_001: [hash_fnv1a shall return the 32 bit FNV-1a hash of the characters of `text` before its terminating '\0']
+	uint32_t result = FNV1A_32_OFFSET_BASIS;
+
+	// Codes_SRS_IOTHUB_CLIENT_HASH_09_002: [If `text` is NULL, hash_fnv1a shall return the hash of an empty string]
+	if (text != NULL)
+	{
+		while (*text != '\0')
+		{
+			result = (result ^ (uint8_t)*text) * FNV1A_32_PRIME;
+			text++;
+		}
+	}
+
+	return result;
+}
@@ -17,6 +17,8 @@
 #include "iothub_transport_ll.h"
 #include "iothub_client_private.h"
 #include "iothub_client_options.h"
+#include "iothub_client_slab.h"
+#include "iothub_client_retry_control.h"
 #include "iothub_client_version.h"
 #include <stdint.h>
 
@@ -24,9 +26,19 @@
 #include "iothub_client_ll_uploadtoblob.h"
 #endif
 
+#ifdef USE_MESSAGE_COMPRESSION
+#include "iothub_client_message_compressor.h"
+#endif
+
 #define LOG_ERROR_RESULT LogError("result = %s", ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, result));
 #define INDEFINITE_TIME ((time_t)(-1))
 
+/*send latencies are kept in a log-linear histogram: values below LATENCY_SUB_BUCKET_COUNT ms have a bucket each, after that
+every power of two is split in LATENCY_SUB_BUCKET_COUNT buckets. Latencies above ~2^32 ms land in the last bucket*/
+#define LATENCY_SUB_BUCKET_COUNT 4
+#define LATENCY_MAX_EXPONENT 29
+#define LATENCY_BUCKET_COUNT (LATENCY_SUB_BUCKET_COUNT * (LATENCY_MAX_EXPONENT + 2))
+
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_CONFIRMATION_RESULT, IOTHUB_CLIENT_CONFIRMATION_RESULT_VALUES);
 
@@ -82,6 +94,15 @@ typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
     bool complete_twin_update_encountered;
     IOTHUB_AUTHORIZATION_HANDLE authorization_module;
     STRING_HANDLE product_info;
+    IOTHUB_CLIENT_STATISTICS statistics; /*counters only, gauges and percentiles are computed by IoTHubClient_LL_GetStatistics*/
+    uint64_t send_latency_total_ms;
+    uint32_t send_latency_histogram[LATENCY_BUCKET_COUNT];
+    bool is_authenticated;
+    SLAB message_list_slab; /*records of waitingToSend, kept for reuse up to OPTION_MESSAGE_POOL_SIZE*/
+#ifdef USE_MESSAGE_COMPRESSION
+    MESSAGE_COMPRESSOR_HANDLE message_compressor; /*NULL until OPTION_MESSAGE_COMPRESSION is set*/
+    bool is_batching; /*OPTION_BATCHING accepted by the transport*/
+#endif
 }IOTHUB_CLIENT_LL_HANDLE_DATA;
 
 static const char HOSTNAME_TOKEN[] = "HostName";
@@ -106,6 +127,7 @@ static void setTransportProtocol(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, TRANS
     handleData->IoTHubTransport_DoWork = protocol->IoTHubTransport_DoWork;
     handleData->IoTHubTransport_SetRetryPolicy = protocol->IoTHubTransport_SetRetryPolicy;
     handleData->IoTHubTransport_GetSendStatus = protocol->IoTHubTransport_GetSendStatus;
+    handleData->IoTHubTransport_GetStatistics = protocol->IoTHubTransport_GetStatistics;
     handleData->IoTHubTransport_ProcessItem = protocol->IoTHubTransport_ProcessItem;
     handleData->IoTHubTransport_Subscribe_DeviceTwin = protocol->IoTHubTransport_Subscribe_DeviceTwin;
     handleData->IoTHubTransport_Unsubscribe_DeviceTwin = protocol->IoTHubTransport_Unsubscribe_DeviceTwin;
@@ -114,6 +136,138 @@ static void setTransportProtocol(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, TRANS
     handleData->IoTHubTransport_DeviceMethod_Response = protocol->IoTHubTransport_DeviceMethod_Response;
 }
 
+static size_t get_latency_bucket_index(tickcounter_ms_t latency)
+{
+    size_t result;
+    if (latency < LATENCY_SUB_BUCKET_COUNT)
+    {
+        result = (size_t)latency;
+    }
+    else
+    {
+        size_t exponent = 0;
+        while ((latency >= (2 * LATENCY_SUB_BUCKET_COUNT)) && (exponent < LATENCY_MAX_EXPONENT))
+        {
+            latency >>= 1;
+            exponent++;
+        }
+
+        if (latency >= (2 * LATENCY_SUB_BUCKET_COUNT))
+        {
+            result = LATENCY_BUCKET_COUNT - 1;
+        }
+        else
+        {
+            result = (LATENCY_SUB_BUCKET_COUNT * (exponent + 1)) + (size_t)(latency - LATENCY_SUB_BUCKET_COUNT);
+        }
+    }
+    return result;
+}
+
+/*returns the highest latency that falls in the bucket*/
+static uint64_t get_latency_bucket_upper_bound(size_t index)
+{
+    uint64_t result;
+    if (index < LATENCY_SUB_BUCKET_COUNT)
+    {
+        result = index;
+    }
+    else
+    {
+        size_t exponent = (index / LATENCY_SUB_BUCKET_COUNT) - 1;
+        uint64_t lower = (uint64_t)(LATENCY_SUB_BUCKET_COUNT + (index % LATENCY_SUB_BUCKET_COUNT)) << exponent;
+        result = lower + ((uint64_t)1 << exponent) - 1;
+    }
+    return result;
+}
+
+static void record_send_latency(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, tickcounter_ms_t latency)
+{
+    size_t index = get_latency_bucket_index(latency);
+
+    if (handleData->send_latency_histogram[index] == UINT32_MAX)
+    {
+        /*halve all the buckets, percentiles only depend on the ratios between them*/
+        size_t i;
+        for (i = 0; i < LATENCY_BUCKET_COUNT; i++)
+        {
+            handleData->send_latency_histogram[i] /= 2;
+        }
+    }
+    handleData->send_latency_histogram[index]++;
+
+    if ((handleData->statistics.send_latency_count == 0) || (latency < handleData->statistics.send_latency_min_ms))
+    {
+        handleData->statistics.send_latency_min_ms = latency;
+    }
+    if (latency > handleData->statistics.send_latency_max_ms)
+    {
+        handleData->statistics.send_latency_max_ms = latency;
+    }
+    handleData->send_latency_total_ms += latency;
+    handleData->statistics.send_latency_count++;
+}
+
+static uint64_t get_send_latency_percentile(const IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, uint64_t per_mille)
+{
+    uint64_t result = 0;
+    uint64_t samples = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    size_t i;
+
+    for (i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        samples += handleData->send_latency_histogram[i];
+    }
+
+    rank = ((samples * per_mille) + 999) / 1000;
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    for (i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        seen += handleData->send_latency_histogram[i];
+        if (seen >= rank)
+        {
+            result = get_latency_bucket_upper_bound(i);
+            break;
+        }
+    }
+
+    /*the bucket bound can overshoot the largest value seen*/
+    if (result > handleData->statistics.send_latency_max_ms)
+    {
+        result = handleData->statistics.send_latency_max_ms;
+    }
+    return result;
+}
+
+static void record_event_completion(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, const IOTHUB_MESSAGE_LIST* message, IOTHUB_CLIENT_CONFIRMATION_RESULT result, bool hasNowTick, tickcounter_ms_t nowTick)
+{
+    switch (result)
+    {
+        case IOTHUB_CLIENT_CONFIRMATION_OK:
+            handleData->statistics.events_confirmed++;
+            if (hasNowTick && message->has_enqueue_time && (nowTick >= message->ms_enqueued))
+            {
+                record_send_latency(handleData, nowTick - message->ms_enqueued);
+            }
+            break;
+        case IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT:
+            handleData->statistics.events_timed_out++;
+            break;
+        case IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY:
+            handleData->statistics.events_destroyed++;
+            break;
+        default:
+            handleData->statistics.events_failed++;
+            break;
+    }
+}
+
 static void device_twin_data_destroy(IOTHUB_DEVICE_TWIN* client_item)
 {
     CONSTBUFFER_Destroy(client_item->report_data_handle);
@@ -357,6 +511,8 @@ static IOTHUB_CLIENT_LL_HANDLE_DATA* initialize_iothub_client(const IOTHUB_CLIEN
                         DList_InitializeListHead(&(result->waitingToSend));
                         DList_InitializeListHead(&(result->iot_msg_queue));
                         DList_InitializeListHead(&(result->iot_ack_queue));
+                        /*Codes_SRS_IOTHUBCLIENT_LL_09_022: [ IoTHubClient_LL_Create shall initialize the slab of the IOTHUB_MESSAGE_LIST records with no record kept for reuse. ]*/
+                        slab_init(&(result->message_list_slab), sizeof(IOTHUB_MESSAGE_LIST), 0);
                         result->messageCallback.type = CALLBACK_TYPE_NONE;
                         result->lastMessageReceiveTime = INDEFINITE_TIME;
                         result->data_msg_id = 1;
@@ -817,7 +973,7 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
                 temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
             }
             IoTHubMessage_Destroy(temp->messageHandle);
-            free(temp);
+            slab_free(&(handleData->message_list_slab), temp);
         }
 
         /* Codes_SRS_IOTHUBCLIENT_LL_07_007: [ IoTHubClient_LL_Destroy shall iterate the device twin queues and destroy any remaining items. ] */
@@ -839,39 +995,84 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
         IoTHubClient_LL_UploadToBlob_Destroy(handleData->uploadToBlobHandle);
 #endif
         STRING_delete(handleData->product_info);
+#ifdef USE_MESSAGE_COMPRESSION
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_028: [ IoTHubClient_LL_Destroy shall destroy the message compressor, if any, using message_compressor_destroy. ]*/
+        if (handleData->message_compressor != NULL)
+        {
+            message_compressor_destroy(handleData->message_compressor);
+        }
+#endif
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_025: [ IoTHubClient_LL_Destroy shall free the IOTHUB_MESSAGE_LIST records kept for reuse using slab_deinit. ]*/
+        slab_deinit(&(handleData->message_list_slab));
         free(handleData);
     }
 }
 
 /*Codes_SRS_IOTHUBCLIENT_LL_02_044: [ Messages already delivered to IoTHubClient_LL shall not have their timeouts modified by a new call to IoTHubClient_LL_SetOption. ]*/
 /*returns 0 on success, any other value is error*/
-static int attach_ms_timesOutAfter(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST *newEntry)
+static int attach_ms_timesOutAfter(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST *newEntry, tickcounter_ms_t queued_ms)
 {
     int result;
+    /*Codes_SRS_IOTHUBCLIENT_LL_09_011: [ IoTHubClient_LL_SendEventAsync shall get the current time from the tickcounter and store it in the new record as the time the event was enqueued. ]*/
+    newEntry->has_enqueue_time = (tickcounter_get_current_ms(handleData->tickCounter, &newEntry->ms_enqueued) == 0);
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_09_032: [ IoTHubClient_LL_SendQueuedEventAsync shall store in the new record the current time minus queued_ms as the time the event was enqueued, so that the send latency and messageTimeout of the event include the time it was queued. ]*/
+    if (newEntry->has_enqueue_time)
+    {
+        newEntry->ms_enqueued = (newEntry->ms_enqueued > queued_ms) ? (newEntry->ms_enqueued - queued_ms) : 0;
+    }
+
     /*Codes_SRS_IOTHUBCLIENT_LL_02_043: [ Calling IoTHubClient_LL_SetOption with value set to "0" shall disable the timeout mechanism for all new messages. ]*/
     if (handleData->currentMessageTimeout == 0)
     {
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_012: [ If getting the current time fails and messages do not timeout, IoTHubClient_LL_SendEventAsync shall still enqueue the event, and no send latency shall be recorded for it. ]*/
         newEntry->ms_timesOutAfter = 0; /*do not timeout*/
         result = 0;
     }
     else
     {
         /*Codes_SRS_IOTHUBCLIENT_LL_02_039: [ "messageTimeout" - once IoTHubClient_LL_SendEventAsync is called the message shall timeout after value miliseconds. Value is a pointer to a uint64. ]*/
-        if (tickcounter_get_current_ms(handleData->tickCounter, &newEntry->ms_timesOutAfter) != 0)
+        if (!newEntry->has_enqueue_time)
         {
             result = __FAILURE__;
             LogError("unable to get the current relative tickcount");
         }
         else
         {
-            newEntry->ms_timesOutAfter += handleData->currentMessageTimeout;
+            newEntry->ms_timesOutAfter = newEntry->ms_enqueued + handleData->currentMessageTimeout;
             result = 0;
         }
     }
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+/*when is_owned is true eventMessageHandle is kept (or destroyed once compressed) instead of being cloned*/
+static IOTHUB_MESSAGE_HANDLE clone_event_message(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE eventMessageHandle, bool is_owned)
+{
+    IOTHUB_MESSAGE_HANDLE result = NULL;
+#ifdef USE_MESSAGE_COMPRESSION
+    /*Codes_SRS_IOTHUBCLIENT_LL_09_033: [ If the transport accepted OPTION_BATCHING set to true, IoTHubClient_LL_SendEventAsync shall not compress the events, because the batches carry no content encoding. ]*/
+    if ((handleData->message_compressor != NULL) && !handleData->is_batching)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_026: [ If OPTION_MESSAGE_COMPRESSION is set, IoTHubClient_LL_SendEventAsync shall get the message to send from message_compressor_compress, and clone eventMessageHandle only if it returns NULL. ]*/
+        result = message_compressor_compress(handleData->message_compressor, eventMessageHandle);
+    }
+#else
+    (void)handleData;
+#endif
+    if (result == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_031: [ IoTHubClient_LL_SendQueuedEventAsync shall behave as IoTHubClient_LL_SendEventAsync, except that on success it shall take ownership of eventMessageHandle instead of cloning it; on failure eventMessageHandle shall be left to the caller. ]*/
+        result = is_owned ? eventMessageHandle : IoTHubMessage_Clone(eventMessageHandle);
+    }
+    else if (is_owned)
+    {
+        IoTHubMessage_Destroy(eventMessageHandle);
+    }
+    return result;
+}
+
+static IOTHUB_CLIENT_RESULT send_event_async(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, bool is_owned, tickcounter_ms_t queued_ms, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
     /*Codes_SRS_IOTHUBCLIENT_LL_02_011: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle or eventMessageHandle is NULL.]*/
@@ -887,7 +1088,9 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
     }
     else
     {
-        IOTHUB_MESSAGE_LIST *newEntry = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_023: [ IoTHubClient_LL_SendEventAsync shall get the new IOTHUB_MESSAGE_LIST record using slab_alloc, and every IOTHUB_MESSAGE_LIST record released by IoTHubClient_LL shall be returned using slab_free. ]*/
+        IOTHUB_MESSAGE_LIST *newEntry = (IOTHUB_MESSAGE_LIST*)slab_alloc(&(handleData->message_list_slab));
         if (newEntry == NULL)
         {
             result = IOTHUB_CLIENT_ERROR;
@@ -895,22 +1098,20 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
         }
         else
         {
-            IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-
-            if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
+            if (attach_ms_timesOutAfter(handleData, newEntry, queued_ms) != 0)
             {
                 result = IOTHUB_CLIENT_ERROR;
                 LOG_ERROR_RESULT;
-                free(newEntry);
+                slab_free(&(handleData->message_list_slab), newEntry);
             }
             else
             {
                 /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_LL_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-                if ((newEntry->messageHandle = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
+                if ((newEntry->messageHandle = clone_event_message(handleData, eventMessageHandle, is_owned)) == NULL)
                 {
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
                     result = IOTHUB_CLIENT_ERROR;
-                    free(newEntry);
+                    slab_free(&(handleData->message_list_slab), newEntry);
                     LOG_ERROR_RESULT;
                 }
                 else
@@ -919,6 +1120,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
                     newEntry->callback = eventConfirmationCallback;
                     newEntry->context = userContextCallback;
                     DList_InsertTailList(&(iotHubClientHandle->waitingToSend), &(newEntry->entry));
+                    handleData->statistics.events_enqueued++;
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
                     result = IOTHUB_CLIENT_OK;
                 }
@@ -928,6 +1130,16 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, false, 0, eventConfirmationCallback, userContextCallback);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendQueuedEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, tickcounter_ms_t queued_ms, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, true, queued_ms, eventConfirmationCallback, userContextCallback);
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1106,12 +1318,13 @@ static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
             {
                 PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
                 DList_RemoveEntryList(currentItemInWaitingToSend);
+                record_event_completion(handleData, fullEntry, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, false, nowTick);
                 if (fullEntry->callback != NULL)
                 {
                     fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
                 }
                 IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
-                free(fullEntry);
+                slab_free(&(handleData->message_list_slab), fullEntry);
                 currentItemInWaitingToSend = theNext;
             }
             else
@@ -1206,17 +1419,29 @@ void IoTHubClient_LL_SendComplete(IOTHUB_CLIENT_LL_HANDLE handle, PDLIST_ENTRY c
     {
         /*Codes_SRS_IOTHUBCLIENT_LL_02_027: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_ERROR then IoTHubClient_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_ERROR and the context set to the context passed originally in the SendEventAsync call.] */
         /*Codes_SRS_IOTHUBCLIENT_LL_02_025: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_OK then IoTHubClient_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_OK and the context set to the context passed originally in the SendEventAsync call.]*/
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
         PDLIST_ENTRY oldest;
+        tickcounter_ms_t nowTick = 0;
+        bool hasNowTick = false;
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_013: [ If result is IOTHUB_CLIENT_CONFIRMATION_OK and completed is not empty, IoTHubClient_LL_SendComplete shall get the current time from the tickcounter once and record the send latency of every completed event. ]*/
+        if ((result == IOTHUB_CLIENT_CONFIRMATION_OK) && (completed->Flink != completed))
+        {
+            hasNowTick = (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) == 0);
+        }
+
         while ((oldest = DList_RemoveHeadList(completed)) != completed)
         {
             IOTHUB_MESSAGE_LIST* messageList = (IOTHUB_MESSAGE_LIST*)containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
+            /*Codes_SRS_IOTHUBCLIENT_LL_09_014: [ IoTHubClient_LL_SendComplete shall count every completed event under the counter matching result. ]*/
+            record_event_completion(handleData, messageList, result, hasNowTick, nowTick);
             /*Codes_SRS_IOTHUBCLIENT_LL_02_026: [If any callback is NULL then there shall not be a callback call.]*/
             if (messageList->callback != NULL)
             {
                 messageList->callback(result, messageList->context);
             }
             IoTHubMessage_Destroy(messageList->messageHandle);
-            free(messageList);
+            slab_free(&(handleData->message_list_slab), messageList);
         }
     }
 }
@@ -1234,6 +1459,7 @@ int IoTHubClient_LL_DeviceMethodComplete(IOTHUB_CLIENT_LL_HANDLE handle, const c
     {
         /* Codes_SRS_IOTHUBCLIENT_LL_07_018: [ If deviceMethodCallback is not NULL IoTHubClient_LL_DeviceMethodComplete shall execute deviceMethodCallback and return the status. ] */
         IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
+        handleData->statistics.methods_invoked++;
         switch (handleData->methodCallback.type)
         {
             case CALLBACK_TYPE_SYNC:
@@ -1315,6 +1541,7 @@ void IoTHubClient_LL_ReportedStateComplete(IOTHUB_CLIENT_LL_HANDLE handle, uint3
             IOTHUB_DEVICE_TWIN* queue_data = containingRecord(client_item, IOTHUB_DEVICE_TWIN, entry);
             if (queue_data->item_id == item_id)
             {
+                handleData->statistics.reported_states_completed++;
                 if (queue_data->reported_state_callback != NULL)
                 {
                     queue_data->reported_state_callback(status_code, queue_data->context);
@@ -1350,6 +1577,7 @@ bool IoTHubClient_LL_MessageCallback(IOTHUB_CLIENT_LL_HANDLE handle, MESSAGE_CAL
 
         /* Codes_SRS_IOTHUBCLIENT_LL_09_004: [IoTHubClient_LL_GetLastMessageReceiveTime shall return lastMessageReceiveTime in localtime] */
         handleData->lastMessageReceiveTime = get_time(NULL);
+        handleData->statistics.messages_received++;
         switch (handleData->messageCallback.type)
         {
             case CALLBACK_TYPE_NONE:
@@ -1405,6 +1633,18 @@ void IoTHubClient_LL_ConnectionStatusCallBack(IOTHUB_CLIENT_LL_HANDLE handle, IO
     {
         IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
 
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_015: [ IoTHubClient_LL_ConnectionStatusCallBack shall count the transitions to IOTHUB_CLIENT_CONNECTION_AUTHENTICATED and the transitions from IOTHUB_CLIENT_CONNECTION_AUTHENTICATED to IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED. ]*/
+        if ((status == IOTHUB_CLIENT_CONNECTION_AUTHENTICATED) && !handleData->is_authenticated)
+        {
+            handleData->statistics.connections_established++;
+            handleData->is_authenticated = true;
+        }
+        else if ((status == IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED) && handleData->is_authenticated)
+        {
+            handleData->statistics.connections_lost++;
+            handleData->is_authenticated = false;
+        }
+
         /*Codes_SRS_IOTHUBCLIENT_LL_25_114: [IoTHubClient_LL_ConnectionStatusCallBack shall call non-callback set by the user from IoTHubClient_LL_SetConnectionStatusCallback passing the status, reason and the passed userContextCallback.]*/
         if (handleData->conStatusCallback != NULL)
         {
@@ -1526,6 +1766,67 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetLastMessageReceiveTime(IOTHUB_CLIENT_LL_
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetStatistics(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+
+    /* Codes_SRS_IOTHUBCLIENT_LL_09_016: [ IoTHubClient_LL_GetStatistics shall return IOTHUB_CLIENT_INVALID_ARG if any of the arguments is NULL. ] */
+    if (handleData == NULL || statistics == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        DLIST_ENTRY* currentItemInWaitingToSend;
+        uint64_t events_completed;
+        size_t events_waiting_to_send = 0;
+
+        /* Codes_SRS_IOTHUBCLIENT_LL_09_017: [ IoTHubClient_LL_GetStatistics shall copy all the counters of the client in statistics. ] */
+        *statistics = handleData->statistics;
+
+        /* Codes_SRS_IOTHUBCLIENT_LL_09_018: [ IoTHubClient_LL_GetStatistics shall set events_waiting_to_send to the number of records in the waitingToSend list. ] */
+        for (currentItemInWaitingToSend = handleData->waitingToSend.Flink; currentItemInWaitingToSend != &(handleData->waitingToSend); currentItemInWaitingToSend = currentItemInWaitingToSend->Flink)
+        {
+            events_waiting_to_send++;
+        }
+        statistics->events_waiting_to_send = events_waiting_to_send;
+
+        /* Codes_SRS_IOTHUBCLIENT_LL_09_019: [ IoTHubClient_LL_GetStatistics shall set events_in_flight to the number of enqueued events that are neither completed nor in the waitingToSend list. ] */
+        events_completed = statistics->events_confirmed + statistics->events_failed + statistics->events_timed_out + statistics->events_destroyed;
+        if (statistics->events_enqueued > events_completed + events_waiting_to_send)
+        {
+            statistics->events_in_flight = (size_t)(statistics->events_enqueued - events_completed - events_waiting_to_send);
+        }
+        else
+        {
+            statistics->events_in_flight = 0;
+        }
+
+        /* Codes_SRS_IOTHUBCLIENT_LL_09_020: [ If at least one send latency was recorded, IoTHubClient_LL_GetStatistics shall set the mean and the 50th, 90th, 99th and 99.9th percentiles of the send latency. ] */
+        if (statistics->send_latency_count > 0)
+        {
+            statistics->send_latency_mean_ms = handleData->send_latency_total_ms / statistics->send_latency_count;
+            statistics->send_latency_p50_ms = get_send_latency_percentile(handleData, 500);
+            statistics->send_latency_p90_ms = get_send_latency_percentile(handleData, 900);
+            statistics->send_latency_p99_ms = get_send_latency_percentile(handleData, 990);
+            statistics->send_latency_p999_ms = get_send_latency_percentile(handleData, 999);
+        }
+
+        /* Codes_SRS_IOTHUBCLIENT_LL_09_035: [ If the transport provides IoTHubTransport_GetStatistics, IoTHubClient_LL_GetStatistics shall call it to set the statistics kept by the transport. ] */
+        if (handleData->IoTHubTransport_GetStatistics != NULL)
+        {
+            handleData->IoTHubTransport_GetStatistics(handleData->transportHandle, statistics);
+        }
+
+        /* Codes_SRS_IOTHUBCLIENT_LL_09_021: [ Otherwise IoTHubClient_LL_GetStatistics shall succeed and return IOTHUB_CLIENT_OK. ] */
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
 
@@ -1575,6 +1876,62 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubCli
                 result = IOTHUB_CLIENT_OK;
             }
         }
+        else if (strcmp(optionName, OPTION_MESSAGE_POOL_SIZE) == 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_09_024: [ "message_pool_size" - IoTHubClient_LL_SetOption shall set the number of IOTHUB_MESSAGE_LIST records kept for reuse using slab_set_max_free_elements, then pass the option to the transport and return IOTHUB_CLIENT_ERROR only if IoTHubTransport_SetOption returns IOTHUB_CLIENT_ERROR. Value is a pointer to a size_t. ]*/
+            slab_set_max_free_elements(&(handleData->message_list_slab), *(const size_t*)value);
+
+            if (handleData->IoTHubTransport_SetOption(handleData->transportHandle, optionName, value) == IOTHUB_CLIENT_ERROR)
+            {
+                LogError("underlying transport failed setting option %s", optionName);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                /*transports without per-message structures reject the option, which is not an error*/
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_RECONNECT_ADMISSION) == 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_09_034: [ "reconnect_admission" - IoTHubClient_LL_SetOption shall set the process-wide reconnect admission rate using retry_control_set_reconnect_admission_rate and return IOTHUB_CLIENT_ERROR if it fails. Value is a pointer to an IOTHUB_RECONNECT_ADMISSION_OPTIONS. ]*/
+            const IOTHUB_RECONNECT_ADMISSION_OPTIONS* admission_options = (const IOTHUB_RECONNECT_ADMISSION_OPTIONS*)value;
+
+            if (retry_control_set_reconnect_admission_rate(admission_options->reconnects_per_sec, admission_options->burst_size) != 0)
+            {
+                LogError("unable to set the reconnect admission rate");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+#ifdef USE_MESSAGE_COMPRESSION
+        else if (strcmp(optionName, OPTION_MESSAGE_COMPRESSION) == 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_09_027: [ "message_compression" - IoTHubClient_LL_SetOption shall replace the message compressor by one created with message_compressor_create, or by none if the content_encoding of the options is NULL, and return IOTHUB_CLIENT_ERROR if creating it fails. Value is a pointer to an IOTHUB_MESSAGE_COMPRESSION_OPTIONS. ]*/
+            const IOTHUB_MESSAGE_COMPRESSION_OPTIONS* compression_options = (const IOTHUB_MESSAGE_COMPRESSION_OPTIONS*)value;
+            MESSAGE_COMPRESSOR_HANDLE message_compressor = NULL;
+
+            if (compression_options->content_encoding != NULL &&
+                (message_compressor = message_compressor_create(compression_options)) == NULL)
+            {
+                LogError("unable to create the message compressor");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                /*messages already queued keep the payload they were queued with*/
+                if (handleData->message_compressor != NULL)
+                {
+                    message_compressor_destroy(handleData->message_compressor);
+                }
+                handleData->message_compressor = message_compressor;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+#endif
         else
         {
 
@@ -1608,6 +1965,13 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubCli
             {
                 LogError("underlying transport failed, returned = %s", ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, result));
             }
+#ifdef USE_MESSAGE_COMPRESSION
+            /*Codes_SRS_IOTHUBCLIENT_LL_09_033: [ If the transport accepted OPTION_BATCHING set to true, IoTHubClient_LL_SendEventAsync shall not compress the events, because the batches carry no content encoding. ]*/
+            else if (strcmp(optionName, OPTION_BATCHING) == 0)
+            {
+                handleData->is_batching = *(const bool*)value;
+            }
+#endif
         }
     }
     return result;
@@ -1708,6 +2072,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendReportedState(IOTHUB_CLIENT_LL_HANDLE i
             {
                 /* Codes_SRS_IOTHUBCLIENT_LL_07_001: [ IoTHubClient_LL_SendReportedState shall queue the constructed reportedState data to be consumed by the targeted transport. ] */
                 DList_InsertTailList(&(iotHubClientHandle->iot_msg_queue), &(client_data->entry));
+                handleData->statistics.reported_states_sent++;
 
                 /* Codes_SRS_IOTHUBCLIENT_LL_10_016: [ Otherwise IoTHubClient_LL_SendReportedState shall succeed and return IOTHUB_CLIENT_OK.] */
                 result = IOTHUB_CLIENT_OK;
@@ -68,6 +68,7 @@ typedef struct IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA_TAG
     } credentials;                              /*needed for file upload*/
     char* certificates; /*if there are any certificates used*/
     HTTP_PROXY_OPTIONS http_proxy_options;
+    BLOB_UPLOAD_PROGRESS uploadProgress; /*blocks uploaded by the last interrupted upload, so that retrying it resumes it*/
 }IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA;
 
 IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const IOTHUB_CLIENT_CONFIG* config)
@@ -106,6 +107,7 @@ IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const I
                 (void)memcpy((char*)handleData->hostname + iotHubNameLength + 1, config->iotHubSuffix, iotHubSuffixLength + 1); /*+1 will copy the \0 too*/
                 handleData->certificates = NULL;
                 memset(&(handleData->http_proxy_options), 0, sizeof(HTTP_PROXY_OPTIONS));
+                memset(&(handleData->uploadProgress), 0, sizeof(BLOB_UPLOAD_PROGRESS));
 
                 if ((config->deviceSasToken != NULL) && (config->deviceKey == NULL))
                 {
@@ -866,7 +868,8 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTO
                                         {
                                             int step2success;
                                             /*Codes_SRS_IOTHUBCLIENT_LL_02_083: [ IoTHubClient_LL_UploadToBlob shall call Blob_UploadFromSasUri and capture the HTTP return code and HTTP body. ]*/
-                                            step2success = (Blob_UploadFromSasUri(STRING_c_str(sasUri), source, size, &httpResponse, responseToIoTHub, handleData->certificates) == BLOB_OK);
+                                            /*Codes_SRS_IOTHUBCLIENT_LL_09_029: [ IoTHubClient_LL_UploadToBlob shall upload the blob using Blob_UploadResumableFromSasUri with the upload progress saved in the handle, so that retrying an interrupted upload of the same file does not upload again its blocks already uploaded. ]*/
+                                            step2success = (Blob_UploadResumableFromSasUri(STRING_c_str(sasUri), source, size, &httpResponse, responseToIoTHub, handleData->certificates, &handleData->uploadProgress) == BLOB_OK);
                                             if (!step2success)
                                             {
                                                 /*Codes_SRS_IOTHUBCLIENT_LL_02_084: [ If Blob_UploadFromSasUri fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
@@ -978,6 +981,8 @@ void IoTHubClient_LL_UploadToBlob_Destroy(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE h
                 break;
             }
         }
+        /*Codes_SRS_IOTHUBCLIENT_LL_09_030: [ IoTHubClient_LL_UploadToBlob_Destroy shall free the saved upload progress using Blob_ClearUploadProgress. ]*/
+        Blob_ClearUploadProgress(&handleData->uploadProgress);
         free((void*)handleData->hostname);
         STRING_delete(handleData->deviceId);
         if (handleData->certificates != NULL)
@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdint.h>
+#include <string.h>
+#include "iothub_client_md5.h"
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define MD5_BLOCK_SIZE 64
+#define MD5_LENGTH_OFFSET 56
+
+#define MD5_F(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define MD5_G(x, y, z) (((x) & (z)) | ((y) & ~(z)))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+#define MD5_ROTATE_LEFT(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+// Per-step shift amounts and additive constants (floor(abs(sin(i + 1)) * 2^32)) of RFC 1321.
+static const uint8_t MD5_SHIFTS[MD5_BLOCK_SIZE] =
+{
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static const uint32_t MD5_CONSTANTS[MD5_BLOCK_SIZE] =
+{
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+
+// ========== Helper Functions ========== //
+
+static void process_block(uint32_t state[4], const unsigned char* block)
+{
+	uint32_t words[16];
+	uint32_t a = state[0];
+	uint32_t b = state[1];
+	uint32_t c = state[2];
+	uint32_t d = state[3];
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		words[i] = (uint32_t)block[i * 4] |
+			((uint32_t)block[i * 4 + 1] << 8) |
+			((uint32_t)block[i * 4 + 2] << 16) |
+			((uint32_t)block[i * 4 + 3] << 24);
+	}
+
+	for (i = 0; i < MD5_BLOCK_SIZE; i++)
+	{
+		uint32_t f;
+		int word_index;
+		uint32_t temp;
+
+		if (i < 16)
+		{
+			f = MD5_F(b, c, d);
+			word_index = i;
+		}
+		else if (i < 32)
+		{
+			f = MD5_G(b, c, d);
+			word_index = (5 * i + 1) % 16;
+		}
+		else if (i < 48)
+		{
+			f = MD5_H(b, c, d);
+			word_index = (3 * i + 5) % 16;
+		}
+		else
+		{
+			f = MD5_I(b, c, d);
+			word_index = (7 * i) % 16;
+		}
+
+		temp = d;
+		d = c;
+		c = b;
+		f = f + a + MD5_CONSTANTS[i] + words[word_index];
+		b = b + MD5_ROTATE_LEFT(f, MD5_SHIFTS[i]);
+		a = temp;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+}
+
+
+// ========== Public API ========== //
+
+int md5_compute(const unsigned char* data, size_t size, unsigned char* digest)
+{
+	int result;
+
+	// Codes_SRS_IOTHUB_CLIENT_MD5_09_001: [If `digest` is NULL, or `data` is NULL while `size` is not 0, md5_compute shall fail and return a non-zero value]
+	if (digest == NULL || (data == NULL && size > 0))
+	{
+		LogError("Invalid argument (data=%p, size=%lu, digest=%p)", data, (unsigned long)size, digest);
+		result = __FAILURE__;
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_MD5_09_002: [md5_compute shall write the MD5 digest of the `size` bytes of `data`, as defined by RFC 1321, to the 16 bytes of `digest` and return 0]
+		uint32_t state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+		unsigned char last_blocks[MD5_BLOCK_SIZE * 2];
+		size_t remaining = size;
+		size_t last_blocks_size;
+		uint64_t bit_count = (uint64_t)size * 8;
+		int i;
+
+		while (remaining >= MD5_BLOCK_SIZE)
+		{
+			process_block(state, data);
+			data += MD5_BLOCK_SIZE;
+			remaining -= MD5_BLOCK_SIZE;
+		}
+
+		// Padding: 0x80, zeroes up to 56 bytes modulo 64, then the length in bits, little-endian.
+		memset(last_blocks, 0, sizeof(last_blocks));
+		if (remaining > 0)
+		{
+			(void)memcpy(last_blocks, data, remaining);
+		}
+		last_blocks[remaining] = 0x80;
+		last_blocks_size = (remaining < MD5_LENGTH_OFFSET) ? MD5_BLOCK_SIZE : MD5_BLOCK_SIZE * 2;
+
+		for (i = 0; i < 8; i++)
+		{
+			last_blocks[last_blocks_size - 8 + i] = (unsigned char)(bit_count >> (i * 8));
+		}
+
+		process_block(state, last_blocks);
+		if (last_blocks_size > MD5_BLOCK_SIZE)
+		{
+			process_block(state, last_blocks + MD5_BLOCK_SIZE);
+		}
+
+		for (i = 0; i < 16; i++)
+		{
+			digest[i] = (unsigned char)(state[i / 4] >> ((i % 4) * 8));
+		}
+
+		result = 0;
+	}
+
+	return result;
+}
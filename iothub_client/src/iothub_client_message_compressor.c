@@ -0,0 +1,332 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "iothub_client_message_compressor.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/map.h"
+
+#define CONTENT_ENCODING_GZIP           "gzip"
+#define CONTENT_ENCODING_DEFLATE        "deflate"
+#define DEFLATE_WINDOW_BITS             15
+// Added to the window bits, makes zlib write a gzip header and trailer instead of the zlib ones.
+#define DEFLATE_GZIP_WRAPPER            16
+#define DEFLATE_MEMORY_LEVEL            8
+
+typedef struct MESSAGE_COMPRESSOR_TAG
+{
+	const char* content_encoding;
+	size_t min_payload_size;
+	unsigned char* dictionary;
+	size_t dictionary_size;
+	// Kept from one message to the next, so that zlib allocates its state once.
+	z_stream stream;
+	unsigned char* output;
+	size_t output_size;
+} MESSAGE_COMPRESSOR;
+
+
+// ========== Helper Functions ========== //
+
+static int get_payload(IOTHUB_MESSAGE_HANDLE message, const unsigned char** payload, size_t* payload_size)
+{
+	int result;
+
+	if (IoTHubMessage_GetContentType(message) == IOTHUBMESSAGE_BYTEARRAY)
+	{
+		if (IoTHubMessage_GetByteArray(message, payload, payload_size) != IOTHUB_MESSAGE_OK)
+		{
+			LogError("Failed getting the payload of the message (IoTHubMessage_GetByteArray failed)");
+			result = __FAILURE__;
+		}
+		else
+		{
+			result = 0;
+		}
+	}
+	else
+	{
+		const char* string = IoTHubMessage_GetString(message);
+
+		if (string == NULL)
+		{
+			LogError("Failed getting the payload of the message (IoTHubMessage_GetString failed)");
+			result = __FAILURE__;
+		}
+		else
+		{
+			*payload = (const unsigned char*)string;
+			*payload_size = strlen(string);
+			result = 0;
+		}
+	}
+
+	return result;
+}
+
+static int deflate_payload(MESSAGE_COMPRESSOR* compressor, const unsigned char* payload, size_t payload_size, size_t* compressed_size)
+{
+	int result;
+	size_t bound = deflateBound(&compressor->stream, (uLong)payload_size);
+
+	if (bound > compressor->output_size)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_013: [message_compressor_compress shall grow its output buffer to the size returned by deflateBound using realloc, and return NULL if it fails]
+		unsigned char* output = (unsigned char*)realloc(compressor->output, bound);
+
+		if (output == NULL)
+		{
+			LogError("Failed growing the compression buffer to %lu bytes", (unsigned long)bound);
+			result = __FAILURE__;
+		}
+		else
+		{
+			compressor->output = output;
+			compressor->output_size = bound;
+			result = 0;
+		}
+	}
+	else
+	{
+		result = 0;
+	}
+
+	if (result == 0)
+	{
+		int deflate_result;
+
+		// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_014: [message_compressor_compress shall compress the payload in one call to deflate with Z_FINISH, after deflateReset and, if a dictionary was given, deflateSetDictionary, and return NULL if any of them fails]
+		if (deflateReset(&compressor->stream) != Z_OK)
+		{
+			LogError("deflateReset failed");
+			result = __FAILURE__;
+		}
+		else if (compressor->dictionary != NULL &&
+			deflateSetDictionary(&compressor->stream, compressor->dictionary, (uInt)compressor->dictionary_size) != Z_OK)
+		{
+			LogError("deflateSetDictionary failed");
+			result = __FAILURE__;
+		}
+		else
+		{
+			compressor->stream.next_in = (Bytef*)payload;
+			compressor->stream.avail_in = (uInt)payload_size;
+			compressor->stream.next_out = compressor->output;
+			compressor->stream.avail_out = (uInt)compressor->output_size;
+
+			if ((deflate_result = deflate(&compressor->stream, Z_FINISH)) != Z_STREAM_END)
+			{
+				LogError("deflate failed (%d)", deflate_result);
+				result = __FAILURE__;
+			}
+			else
+			{
+				*compressed_size = compressor->output_size - compressor->stream.avail_out;
+				result = 0;
+			}
+		}
+	}
+
+	return result;
+}
+
+static int copy_properties(IOTHUB_MESSAGE_HANDLE source, IOTHUB_MESSAGE_HANDLE destination, const char* content_encoding)
+{
+	int result;
+	const char* message_id = IoTHubMessage_GetMessageId(source);
+	const char* correlation_id = IoTHubMessage_GetCorrelationId(source);
+	const char* content_type = IoTHubMessage_GetContentTypeSystemProperty(source);
+	MAP_HANDLE source_properties;
+	MAP_HANDLE destination_properties;
+	const char* const* keys;
+	const char* const* values;
+	size_t count;
+
+	if ((message_id != NULL && IoTHubMessage_SetMessageId(destination, message_id) != IOTHUB_MESSAGE_OK) ||
+		(correlation_id != NULL && IoTHubMessage_SetCorrelationId(destination, correlation_id) != IOTHUB_MESSAGE_OK) ||
+		(content_type != NULL && IoTHubMessage_SetContentTypeSystemProperty(destination, content_type) != IOTHUB_MESSAGE_OK) ||
+		IoTHubMessage_SetContentEncodingSystemProperty(destination, content_encoding) != IOTHUB_MESSAGE_OK)
+	{
+		LogError("Failed copying the system properties of the message");
+		result = __FAILURE__;
+	}
+	else if ((source_properties = IoTHubMessage_Properties(source)) == NULL ||
+		(destination_properties = IoTHubMessage_Properties(destination)) == NULL ||
+		Map_GetInternals(source_properties, &keys, &values, &count) != MAP_OK)
+	{
+		LogError("Failed getting the application properties of the message");
+		result = __FAILURE__;
+	}
+	else
+	{
+		size_t i;
+
+		result = 0;
+
+		for (i = 0; i < count; i++)
+		{
+			if (Map_AddOrUpdate(destination_properties, keys[i], values[i]) != MAP_OK)
+			{
+				LogError("Failed copying the application property %s of the message", keys[i]);
+				result = __FAILURE__;
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+
+// ========== Public API ========== //
+
+MESSAGE_COMPRESSOR_HANDLE message_compressor_create(const IOTHUB_MESSAGE_COMPRESSION_OPTIONS* options)
+{
+	MESSAGE_COMPRESSOR* result;
+	bool is_gzip;
+
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_001: [If `options` or its `content_encoding` are NULL, message_compressor_create shall fail and return NULL]
+	if (options == NULL || options->content_encoding == NULL)
+	{
+		LogError("Invalid argument (options=%p)", options);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_002: [If `content_encoding` is neither "gzip" nor "deflate", message_compressor_create shall fail and return NULL]
+	else if (!(is_gzip = (strcmp(options->content_encoding, CONTENT_ENCODING_GZIP) == 0)) &&
+		strcmp(options->content_encoding, CONTENT_ENCODING_DEFLATE) != 0)
+	{
+		LogError("Invalid argument (unsupported content encoding %s)", options->content_encoding);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_003: [If `level` is not between 0 and 9, message_compressor_create shall fail and return NULL]
+	else if (options->level < 0 || options->level > Z_BEST_COMPRESSION)
+	{
+		LogError("Invalid argument (level %d is not between 0 and %d)", options->level, Z_BEST_COMPRESSION);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_004: [If a dictionary is given with "gzip", or `dictionary` is NULL while `dictionary_size` is not 0, message_compressor_create shall fail and return NULL]
+	else if ((options->dictionary == NULL) != (options->dictionary_size == 0) ||
+		(is_gzip && options->dictionary != NULL) ||
+		options->dictionary_size > UINT_MAX)
+	{
+		LogError("Invalid argument (dictionary=%p, dictionary_size=%lu, content encoding %s)", options->dictionary, (unsigned long)options->dictionary_size, options->content_encoding);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_005: [message_compressor_create shall allocate the compressor using malloc(), and return NULL if it fails]
+	else if ((result = (MESSAGE_COMPRESSOR*)malloc(sizeof(MESSAGE_COMPRESSOR))) == NULL)
+	{
+		LogError("Failed allocating the message compressor (malloc failed)");
+	}
+	else
+	{
+		memset(result, 0, sizeof(MESSAGE_COMPRESSOR));
+		result->content_encoding = is_gzip ? CONTENT_ENCODING_GZIP : CONTENT_ENCODING_DEFLATE;
+		result->min_payload_size = options->min_payload_size;
+		result->dictionary_size = options->dictionary_size;
+
+		// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_006: [message_compressor_create shall copy the dictionary using malloc(), and return NULL if it fails]
+		if (options->dictionary != NULL && (result->dictionary = (unsigned char*)malloc(options->dictionary_size)) == NULL)
+		{
+			LogError("Failed copying the compression dictionary (malloc failed)");
+			free(result);
+			result = NULL;
+		}
+		else
+		{
+			int init_result;
+
+			if (result->dictionary != NULL)
+			{
+				(void)memcpy(result->dictionary, options->dictionary, options->dictionary_size);
+			}
+
+			// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_007: [message_compressor_create shall initialize the deflate stream using deflateInit2 with `level` (Z_DEFAULT_COMPRESSION for 0) and a gzip or zlib wrapper according to `content_encoding`, and return NULL if it fails]
+			if ((init_result = deflateInit2(&result->stream,
+				options->level == 0 ? Z_DEFAULT_COMPRESSION : options->level,
+				Z_DEFLATED,
+				is_gzip ? DEFLATE_WINDOW_BITS + DEFLATE_GZIP_WRAPPER : DEFLATE_WINDOW_BITS,
+				DEFLATE_MEMORY_LEVEL,
+				Z_DEFAULT_STRATEGY)) != Z_OK)
+			{
+				LogError("deflateInit2 failed (%d)", init_result);
+				free(result->dictionary);
+				free(result);
+				result = NULL;
+			}
+		}
+	}
+
+	return result;
+}
+
+void message_compressor_destroy(MESSAGE_COMPRESSOR_HANDLE compressor)
+{
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_008: [If `compressor` is NULL, message_compressor_destroy shall return]
+	if (compressor != NULL)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_009: [message_compressor_destroy shall release the deflate stream using deflateEnd, and free the dictionary, the output buffer and the compressor]
+		(void)deflateEnd(&compressor->stream);
+		free(compressor->dictionary);
+		free(compressor->output);
+		free(compressor);
+	}
+}
+
+IOTHUB_MESSAGE_HANDLE message_compressor_compress(MESSAGE_COMPRESSOR_HANDLE compressor, IOTHUB_MESSAGE_HANDLE message)
+{
+	IOTHUB_MESSAGE_HANDLE result;
+	const unsigned char* payload;
+	size_t payload_size;
+	size_t compressed_size;
+
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_010: [If `compressor` or `message` are NULL, message_compressor_compress shall fail and return NULL]
+	if (compressor == NULL || message == NULL)
+	{
+		LogError("Invalid argument (compressor=%p, message=%p)", compressor, message);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_011: [If `message` has a content encoding, message_compressor_compress shall return NULL]
+	else if (IoTHubMessage_GetContentEncodingSystemProperty(message) != NULL)
+	{
+		result = NULL;
+	}
+	else if (get_payload(message, &payload, &payload_size) != 0)
+	{
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_012: [If the payload of `message` is smaller than `min_payload_size`, message_compressor_compress shall return NULL]
+	else if (payload_size < compressor->min_payload_size || payload_size > UINT_MAX)
+	{
+		result = NULL;
+	}
+	else if (deflate_payload(compressor, payload, payload_size, &compressed_size) != 0)
+	{
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_015: [If the compressed payload is not smaller than the payload, message_compressor_compress shall return NULL]
+	else if (compressed_size >= payload_size)
+	{
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_016: [message_compressor_compress shall create the new message using IoTHubMessage_CreateFromByteArray with the compressed payload, and return NULL if it fails]
+	else if ((result = IoTHubMessage_CreateFromByteArray(compressor->output, compressed_size)) == NULL)
+	{
+		LogError("Failed creating the compressed message (IoTHubMessage_CreateFromByteArray failed)");
+	}
+	// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_017: [message_compressor_compress shall copy the message id, correlation id, content type and application properties of `message` to the new message, and set its content encoding]
+	else if (copy_properties(message, result, compressor->content_encoding) != 0)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_018: [If copying the properties fails, message_compressor_compress shall destroy the new message and return NULL]
+		IoTHubMessage_Destroy(result);
+		result = NULL;
+	}
+
+	return result;
+}
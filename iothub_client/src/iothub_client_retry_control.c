@@ -7,12 +7,15 @@
 
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 
 #define RESULT_OK           0
 #define INDEFINITE_TIME     ((time_t)-1)
 
+#define DECORRELATED_JITTER_MAX_WAIT_TIME_IN_SECS   60
+
 typedef struct RETRY_CONTROL_INSTANCE_TAG
 {
 	IOTHUB_CLIENT_RETRY_POLICY policy;
@@ -27,6 +30,19 @@ typedef struct RETRY_CONTROL_INSTANCE_TAG
 	unsigned int current_wait_time_in_secs;
 } RETRY_CONTROL_INSTANCE;
 
+typedef struct RECONNECT_ADMISSION_CONTROL_TAG
+{
+	LOCK_HANDLE lock;
+	unsigned int reconnects_per_sec;
+	unsigned int burst_size;
+	unsigned int available_tokens;
+	time_t last_refill_time;
+} RECONNECT_ADMISSION_CONTROL;
+
+// Shared by all retry control instances in the process, so a connectivity flap does not
+// turn into every client starting a TLS handshake within the same second.
+static RECONNECT_ADMISSION_CONTROL g_reconnect_admission = { NULL, 0, 0, 0, INDEFINITE_TIME };
+
 typedef int (*RETRY_ACTION_EVALUATION_FUNCTION)(RETRY_CONTROL_INSTANCE* retry_state, RETRY_ACTION* retry_action);
 
 
@@ -192,6 +208,71 @@ static int evaluate_retry_action(RETRY_CONTROL_INSTANCE* retry_control, RETRY_AC
 	return result;
 }
 
+static bool acquire_reconnect_admission(void)
+{
+	bool result;
+
+	// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_074: [If the reconnect admission control is disabled, the reconnection shall be admitted]
+	if (g_reconnect_admission.lock == NULL)
+	{
+		result = true;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_075: [The admission state shall be accessed under `Lock`; if `Lock` fails the reconnection shall be admitted]
+	else if (Lock(g_reconnect_admission.lock) != LOCK_OK)
+	{
+		LogError("Failed to evaluate reconnect admission (Lock failed); admitting reconnection");
+		result = true;
+	}
+	else
+	{
+		time_t current_time;
+
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_076: [`current_time` shall be obtained using get_time()]
+		if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
+		{
+			// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_077: [If get_time() fails, the reconnection shall be admitted]
+			LogError("Failed to evaluate reconnect admission (get_time failed); admitting reconnection");
+			result = true;
+		}
+		else
+		{
+			// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_078: [For every full second elapsed since the last refill, `reconnects_per_sec` tokens shall be added, up to `burst_size`]
+			if (g_reconnect_admission.last_refill_time == INDEFINITE_TIME)
+			{
+				g_reconnect_admission.last_refill_time = current_time;
+			}
+			else
+			{
+				double elapsed_secs = get_difftime(current_time, g_reconnect_admission.last_refill_time);
+
+				if (elapsed_secs >= 1)
+				{
+					double tokens = g_reconnect_admission.available_tokens + (unsigned int)elapsed_secs * (double)g_reconnect_admission.reconnects_per_sec;
+
+					g_reconnect_admission.available_tokens = (tokens >= g_reconnect_admission.burst_size ? g_reconnect_admission.burst_size : (unsigned int)tokens);
+					g_reconnect_admission.last_refill_time = current_time;
+				}
+			}
+
+			// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_079: [If a token is available it shall be consumed and the reconnection admitted, otherwise the reconnection shall be denied]
+			if (g_reconnect_admission.available_tokens > 0)
+			{
+				g_reconnect_admission.available_tokens--;
+				result = true;
+			}
+			else
+			{
+				result = false;
+			}
+		}
+
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_080: [The admission state shall be released using `Unlock`]
+		(void)Unlock(g_reconnect_admission.lock);
+	}
+
+	return result;
+}
+
 static unsigned int calculate_next_wait_time(RETRY_CONTROL_INSTANCE* retry_control)
 {
 	unsigned int result;
@@ -224,6 +305,16 @@ static unsigned int calculate_next_wait_time(RETRY_CONTROL_INSTANCE* retry_contr
 		double random_percent = ((double)rand() / (double)RAND_MAX);
 		result = (unsigned int)(retry_control->initial_wait_time_in_secs * random_percent);
 	}
+	// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_065: [If `retry_control->policy` is IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER, `calculate_next_wait_time` shall return a random value between `retry_control->initial_wait_time_in_secs` and 3 times the previous wait time (or `initial_wait_time_in_secs` if there is none)]
+	else if (retry_control->policy == IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER)
+	{
+		double lower_bound = retry_control->initial_wait_time_in_secs;
+		double upper_bound = 3.0 * (retry_control->current_wait_time_in_secs > retry_control->initial_wait_time_in_secs ? retry_control->current_wait_time_in_secs : retry_control->initial_wait_time_in_secs);
+		double wait_time = lower_bound + (upper_bound - lower_bound) * (rand() / ((double)RAND_MAX)) + 0.5;
+
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_066: [The IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER wait time shall not exceed DECORRELATED_JITTER_MAX_WAIT_TIME_IN_SECS (60 seconds)]
+		result = (wait_time > DECORRELATED_JITTER_MAX_WAIT_TIME_IN_SECS ? DECORRELATED_JITTER_MAX_WAIT_TIME_IN_SECS : (unsigned int)wait_time);
+	}
 	else
 	{
 		LogError("Failed to calculate the next wait time (policy %d is not expected)", retry_control->policy);
@@ -322,8 +413,10 @@ RETRY_CONTROL_HANDLE retry_control_create(IOTHUB_CLIENT_RETRY_POLICY policy, uns
 		retry_control->max_retry_time_in_secs = max_retry_time_in_secs;
 
 		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_005: [If `policy` is IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF or IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, `retry_control->initial_wait_time_in_secs` shall be set to 1]
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_064: [If `policy` is IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER, `retry_control->initial_wait_time_in_secs` shall be set to 1]
 		if (retry_control->policy == IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF ||
-			retry_control->policy == IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER)
+			retry_control->policy == IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER ||
+			retry_control->policy == IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER)
 		{
 			retry_control->initial_wait_time_in_secs = 1;
 		}
@@ -394,6 +487,12 @@ int retry_control_should_retry(RETRY_CONTROL_HANDLE retry_control_handle, RETRY_
 		}
 		else
 		{
+			// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_067: [If `retry_action` is set to RETRY_ACTION_RETRY_NOW and the reconnect admission control denies the reconnection, `retry_action` shall be set to RETRY_ACTION_RETRY_LATER and `retry_control` shall not be updated]
+			if (*retry_action == RETRY_ACTION_RETRY_NOW && !acquire_reconnect_admission())
+			{
+				*retry_action = RETRY_ACTION_RETRY_LATER;
+			}
+
 			if (*retry_action == RETRY_ACTION_RETRY_NOW)
 			{
 				// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_015: [If `retry_action` is set to RETRY_ACTION_RETRY_NOW, `retry_control->retry_count` shall be incremented by 1]
@@ -417,6 +516,61 @@ int retry_control_should_retry(RETRY_CONTROL_HANDLE retry_control_handle, RETRY_
 	return result;
 }
 
+int retry_control_set_reconnect_admission_rate(unsigned int reconnects_per_sec, unsigned int burst_size)
+{
+	int result;
+
+	// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_068: [If `reconnects_per_sec` is 0, the reconnect admission control shall be disabled, its lock destroyed using `Lock_Deinit`, and `retry_control_set_reconnect_admission_rate` shall return 0]
+	if (reconnects_per_sec == 0)
+	{
+		if (g_reconnect_admission.lock != NULL)
+		{
+			(void)Lock_Deinit(g_reconnect_admission.lock);
+			g_reconnect_admission.lock = NULL;
+		}
+
+		g_reconnect_admission.reconnects_per_sec = 0;
+		g_reconnect_admission.burst_size = 0;
+		g_reconnect_admission.available_tokens = 0;
+		g_reconnect_admission.last_refill_time = INDEFINITE_TIME;
+
+		result = RESULT_OK;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_069: [If `burst_size` is 0, `retry_control_set_reconnect_admission_rate` shall fail and return non-zero]
+	else if (burst_size == 0)
+	{
+		LogError("Failed to set reconnect admission rate (burst_size must be greater than zero)");
+		result = __FAILURE__;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_070: [If the reconnect admission control is not enabled, its lock shall be created using `Lock_Init`]
+	else if (g_reconnect_admission.lock == NULL && (g_reconnect_admission.lock = Lock_Init()) == NULL)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_071: [If `Lock_Init` fails, `retry_control_set_reconnect_admission_rate` shall fail and return non-zero]
+		LogError("Failed to set reconnect admission rate (Lock_Init failed)");
+		result = __FAILURE__;
+	}
+	else if (Lock(g_reconnect_admission.lock) != LOCK_OK)
+	{
+		LogError("Failed to set reconnect admission rate (Lock failed)");
+		result = __FAILURE__;
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_072: [`reconnects_per_sec` and `burst_size` shall be saved, and the available tokens set to `burst_size`]
+		g_reconnect_admission.reconnects_per_sec = reconnects_per_sec;
+		g_reconnect_admission.burst_size = burst_size;
+		g_reconnect_admission.available_tokens = burst_size;
+		g_reconnect_admission.last_refill_time = INDEFINITE_TIME;
+
+		(void)Unlock(g_reconnect_admission.lock);
+
+		// Codes_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_073: [If no errors occur, `retry_control_set_reconnect_admission_rate` shall return 0]
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
 int retry_control_set_option(RETRY_CONTROL_HANDLE retry_control_handle, const char* name, const void* value)
 {
 	int result;
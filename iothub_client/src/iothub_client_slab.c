@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "iothub_client_slab.h"
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+// Released elements are chained through their first bytes, hence the minimum element size.
+typedef struct SLAB_FREE_ELEMENT_TAG
+{
+	struct SLAB_FREE_ELEMENT_TAG* next;
+} SLAB_FREE_ELEMENT;
+
+
+// ========== Helper Functions ========== //
+
+static void trim_free_elements(SLAB* slab)
+{
+	while (slab->free_element_count > slab->max_free_elements)
+	{
+		SLAB_FREE_ELEMENT* element = (SLAB_FREE_ELEMENT*)slab->free_elements;
+
+		slab->free_elements = element->next;
+		slab->free_element_count--;
+		free(element);
+	}
+}
+
+
+// ========== Public API ========== //
+
+void slab_init(SLAB* slab, size_t element_size, size_t max_free_elements)
+{
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_001: [If `slab` is NULL, slab_init shall return]
+	if (slab == NULL)
+	{
+		LogError("Invalid argument (slab is NULL)");
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SLAB_09_002: [slab_init shall save `element_size`, raised to the size of a pointer if smaller, and `max_free_elements`, with no element kept for reuse and the counters set to 0]
+		slab->element_size = (element_size < sizeof(SLAB_FREE_ELEMENT)) ? sizeof(SLAB_FREE_ELEMENT) : element_size;
+		slab->max_free_elements = max_free_elements;
+		slab->free_element_count = 0;
+		slab->free_elements = NULL;
+		slab->allocation_count = 0;
+		slab->reuse_count = 0;
+	}
+}
+
+void slab_deinit(SLAB* slab)
+{
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_003: [If `slab` is NULL, slab_deinit shall return]
+	if (slab != NULL)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SLAB_09_004: [slab_deinit shall free all the elements kept for reuse]
+		slab->max_free_elements = 0;
+		trim_free_elements(slab);
+	}
+}
+
+void* slab_alloc(SLAB* slab)
+{
+	void* result;
+
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_005: [If `slab` is NULL, slab_alloc shall fail and return NULL]
+	if (slab == NULL)
+	{
+		LogError("Invalid argument (slab is NULL)");
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_006: [If elements are kept for reuse, slab_alloc shall remove the one released last and return it, counting a reuse]
+	else if (slab->free_elements != NULL)
+	{
+		SLAB_FREE_ELEMENT* element = (SLAB_FREE_ELEMENT*)slab->free_elements;
+
+		slab->free_elements = element->next;
+		slab->free_element_count--;
+		slab->reuse_count++;
+		result = element;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_007: [Otherwise slab_alloc shall allocate `element_size` bytes using malloc() and return them, counting an allocation]
+	else if ((result = malloc(slab->element_size)) == NULL)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SLAB_09_008: [If malloc() fails, slab_alloc shall fail and return NULL]
+		LogError("Failed allocating slab element (malloc failed)");
+	}
+	else
+	{
+		slab->allocation_count++;
+	}
+
+	return result;
+}
+
+void slab_free(SLAB* slab, void* element)
+{
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_009: [If `slab` or `element` are NULL, slab_free shall return]
+	if ((slab == NULL) || (element == NULL))
+	{
+		LogError("Invalid argument (slab=%p, element=%p)", slab, element);
+	}
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_010: [If fewer than `max_free_elements` elements are kept for reuse, slab_free shall keep `element`]
+	else if (slab->free_element_count < slab->max_free_elements)
+	{
+		SLAB_FREE_ELEMENT* free_element = (SLAB_FREE_ELEMENT*)element;
+
+		free_element->next = (SLAB_FREE_ELEMENT*)slab->free_elements;
+		slab->free_elements = free_element;
+		slab->free_element_count++;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_011: [Otherwise slab_free shall release `element` using free()]
+	else
+	{
+		free(element);
+	}
+}
+
+void slab_set_max_free_elements(SLAB* slab, size_t max_free_elements)
+{
+	// Codes_SRS_IOTHUB_CLIENT_SLAB_09_012: [If `slab` is NULL, slab_set_max_free_elements shall return]
+	if (slab == NULL)
+	{
+		LogError("Invalid argument (slab is NULL)");
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SLAB_09_013: [slab_set_max_free_elements shall save `max_free_elements` and free the elements kept for reuse beyond it]
+		slab->max_free_elements = max_free_elements;
+		trim_free_elements(slab);
+	}
+}
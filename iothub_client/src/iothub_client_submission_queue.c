@@ -0,0 +1,349 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "iothub_client_submission_queue.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define RESULT_OK           0
+#define CACHE_LINE_SIZE     64
+
+// Each slot carries a sequence number (Vyukov's bounded queue): a slot at `position` is free for the producer
+// that claims `position` when its sequence equals `position`, and holds an element for the consumer when its
+// sequence equals `position + 1`. Producers claim positions with a compare-and-swap on enqueue_position.
+#if defined(__GNUC__) || defined(__clang__)
+
+static size_t load_relaxed(volatile size_t* value)
+{
+	return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static size_t load_acquire(volatile size_t* value)
+{
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static void store_release(volatile size_t* value, size_t new_value)
+{
+	__atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+
+static bool compare_exchange(volatile size_t* value, size_t* expected, size_t desired)
+{
+	return __atomic_compare_exchange_n(value, expected, desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+#elif defined(_MSC_VER)
+
+#include <windows.h>
+
+static size_t load_relaxed(volatile size_t* value)
+{
+	return *value;
+}
+
+static size_t load_acquire(volatile size_t* value)
+{
+	size_t result = *value;
+	MemoryBarrier();
+	return result;
+}
+
+static void store_release(volatile size_t* value, size_t new_value)
+{
+	MemoryBarrier();
+	*value = new_value;
+}
+
+static bool compare_exchange(volatile size_t* value, size_t* expected, size_t desired)
+{
+	size_t previous;
+#ifdef _WIN64
+	previous = (size_t)InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)desired, (LONG64)*expected);
+#else
+	previous = (size_t)InterlockedCompareExchange((volatile LONG*)value, (LONG)desired, (LONG)*expected);
+#endif
+	bool result = (previous == *expected);
+	*expected = previous;
+	return result;
+}
+
+#else
+
+// No atomic builtins: push and pop are serialized by a lock owned by the queue.
+#define SUBMISSION_QUEUE_USE_LOCK
+#include "azure_c_shared_utility/lock.h"
+
+static size_t load_relaxed(volatile size_t* value)
+{
+	return *value;
+}
+
+static size_t load_acquire(volatile size_t* value)
+{
+	return *value;
+}
+
+static void store_release(volatile size_t* value, size_t new_value)
+{
+	*value = new_value;
+}
+
+static bool compare_exchange(volatile size_t* value, size_t* expected, size_t desired)
+{
+	bool result;
+
+	if (*value == *expected)
+	{
+		*value = desired;
+		result = true;
+	}
+	else
+	{
+		*expected = *value;
+		result = false;
+	}
+
+	return result;
+}
+
+#endif
+
+typedef struct SUBMISSION_QUEUE_INSTANCE_TAG
+{
+	// Producers and the consumer write different positions; keep them on separate cache lines.
+	volatile size_t enqueue_position;
+	unsigned char enqueue_position_padding[CACHE_LINE_SIZE - sizeof(size_t)];
+	size_t dequeue_position;
+	unsigned char dequeue_position_padding[CACHE_LINE_SIZE - sizeof(size_t)];
+	size_t mask;
+	size_t element_size;
+	volatile size_t* sequences;
+	unsigned char* elements;
+#ifdef SUBMISSION_QUEUE_USE_LOCK
+	LOCK_HANDLE lock;
+#endif
+} SUBMISSION_QUEUE_INSTANCE;
+
+
+// ========== Helper Functions ========== //
+
+static size_t round_up_to_power_of_two(size_t value)
+{
+	size_t result = 1;
+
+	while (result < value && result <= (SIZE_MAX >> 1))
+	{
+		result <<= 1;
+	}
+
+	return (result < value) ? 0 : result;
+}
+
+static int push_element(SUBMISSION_QUEUE_INSTANCE* submission_queue, const void* element)
+{
+	int result;
+	size_t position = load_relaxed(&submission_queue->enqueue_position);
+	bool is_claimed = false;
+	bool is_full = false;
+
+	while (!is_claimed && !is_full)
+	{
+		size_t sequence = load_acquire(&submission_queue->sequences[position & submission_queue->mask]);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+		if (difference == 0)
+		{
+			// On failure compare_exchange reloads `position` with the current enqueue position.
+			is_claimed = compare_exchange(&submission_queue->enqueue_position, &position, position + 1);
+		}
+		else if (difference < 0)
+		{
+			// The slot still holds the element pushed one lap ago.
+			is_full = true;
+		}
+		else
+		{
+			position = load_relaxed(&submission_queue->enqueue_position);
+		}
+	}
+
+	if (is_full)
+	{
+		result = __FAILURE__;
+	}
+	else
+	{
+		size_t index = position & submission_queue->mask;
+
+		(void)memcpy(submission_queue->elements + (index * submission_queue->element_size), element, submission_queue->element_size);
+		store_release(&submission_queue->sequences[index], position + 1);
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+static int pop_element(SUBMISSION_QUEUE_INSTANCE* submission_queue, void* element)
+{
+	int result;
+	size_t position = submission_queue->dequeue_position;
+	size_t index = position & submission_queue->mask;
+	size_t sequence = load_acquire(&submission_queue->sequences[index]);
+
+	if ((intptr_t)sequence - (intptr_t)(position + 1) < 0)
+	{
+		// Empty, or a producer claimed the slot but has not finished copying its element yet.
+		result = __FAILURE__;
+	}
+	else
+	{
+		(void)memcpy(element, submission_queue->elements + (index * submission_queue->element_size), submission_queue->element_size);
+		store_release(&submission_queue->sequences[index], position + submission_queue->mask + 1);
+		submission_queue->dequeue_position = position + 1;
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+
+// ========== Public API ========== //
+
+SUBMISSION_QUEUE_HANDLE submission_queue_create(size_t element_size, size_t capacity)
+{
+	SUBMISSION_QUEUE_INSTANCE* result;
+	size_t slot_count;
+
+	// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_001: [If `element_size` or `capacity` are zero, or `capacity` cannot be rounded up to a power of two, `submission_queue_create` shall fail and return NULL]
+	if (element_size == 0 || capacity == 0 || (slot_count = round_up_to_power_of_two(capacity)) == 0)
+	{
+		LogError("Invalid argument (element_size=%lu, capacity=%lu)", (unsigned long)element_size, (unsigned long)capacity);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_002: [If the memory required for the slots overflows size_t, `submission_queue_create` shall fail and return NULL]
+	else if (element_size > SIZE_MAX - sizeof(size_t) ||
+		slot_count > (SIZE_MAX - sizeof(SUBMISSION_QUEUE_INSTANCE)) / (sizeof(size_t) + element_size))
+	{
+		LogError("Queue too large (element_size=%lu, capacity=%lu)", (unsigned long)element_size, (unsigned long)capacity);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_003: [`submission_queue_create` shall allocate the queue instance, its sequence numbers and its slots in a single block of memory]
+	else if ((result = (SUBMISSION_QUEUE_INSTANCE*)malloc(sizeof(SUBMISSION_QUEUE_INSTANCE) + slot_count * (sizeof(size_t) + element_size))) == NULL)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_004: [If malloc fails, `submission_queue_create` shall fail and return NULL]
+		LogError("Failed allocating submission queue");
+	}
+	else
+	{
+		size_t index;
+
+		(void)memset(result, 0, sizeof(SUBMISSION_QUEUE_INSTANCE));
+		result->mask = slot_count - 1;
+		result->element_size = element_size;
+		result->sequences = (volatile size_t*)(result + 1);
+		result->elements = (unsigned char*)(result->sequences + slot_count);
+
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_005: [The capacity shall be rounded up to the next power of two and the sequence number of each slot shall be initialized with its index]
+		for (index = 0; index < slot_count; index++)
+		{
+			result->sequences[index] = index;
+		}
+
+#ifdef SUBMISSION_QUEUE_USE_LOCK
+		if ((result->lock = Lock_Init()) == NULL)
+		{
+			LogError("Failed creating submission queue lock");
+			free(result);
+			result = NULL;
+		}
+#endif
+	}
+
+	return result;
+}
+
+int submission_queue_push(SUBMISSION_QUEUE_HANDLE submission_queue_handle, const void* element)
+{
+	int result;
+
+	// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_006: [If `submission_queue_handle` or `element` are NULL, `submission_queue_push` shall fail and return non-zero]
+	if (submission_queue_handle == NULL || element == NULL)
+	{
+		LogError("Invalid argument (submission_queue_handle=%p, element=%p)", submission_queue_handle, element);
+		result = __FAILURE__;
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_007: [`submission_queue_push` shall claim the next free slot without taking any lock, copy `element_size` bytes of `element` into it and return 0]
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_008: [If all slots hold elements not yet popped, `submission_queue_push` shall fail and return non-zero]
+#ifdef SUBMISSION_QUEUE_USE_LOCK
+		if (Lock(submission_queue_handle->lock) != LOCK_OK)
+		{
+			LogError("Failed locking submission queue");
+			result = __FAILURE__;
+		}
+		else
+		{
+			result = push_element(submission_queue_handle, element);
+			(void)Unlock(submission_queue_handle->lock);
+		}
+#else
+		result = push_element(submission_queue_handle, element);
+#endif
+	}
+
+	return result;
+}
+
+int submission_queue_pop(SUBMISSION_QUEUE_HANDLE submission_queue_handle, void* element)
+{
+	int result;
+
+	// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_009: [If `submission_queue_handle` or `element` are NULL, `submission_queue_pop` shall fail and return non-zero]
+	if (submission_queue_handle == NULL || element == NULL)
+	{
+		LogError("Invalid argument (submission_queue_handle=%p, element=%p)", submission_queue_handle, element);
+		result = __FAILURE__;
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_010: [`submission_queue_pop` shall copy the oldest element into `element`, release its slot to producers and return 0]
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_011: [If no element is ready, `submission_queue_pop` shall return non-zero]
+#ifdef SUBMISSION_QUEUE_USE_LOCK
+		if (Lock(submission_queue_handle->lock) != LOCK_OK)
+		{
+			LogError("Failed locking submission queue");
+			result = __FAILURE__;
+		}
+		else
+		{
+			result = pop_element(submission_queue_handle, element);
+			(void)Unlock(submission_queue_handle->lock);
+		}
+#else
+		result = pop_element(submission_queue_handle, element);
+#endif
+	}
+
+	return result;
+}
+
+void submission_queue_destroy(SUBMISSION_QUEUE_HANDLE submission_queue_handle)
+{
+	// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_012: [If `submission_queue_handle` is NULL, `submission_queue_destroy` shall return]
+	if (submission_queue_handle != NULL)
+	{
+#ifdef SUBMISSION_QUEUE_USE_LOCK
+		Lock_Deinit(submission_queue_handle->lock);
+#endif
+		// Codes_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_013: [`submission_queue_destroy` shall free the memory allocated for the queue; elements still queued are discarded]
+		free(submission_queue_handle);
+	}
+}
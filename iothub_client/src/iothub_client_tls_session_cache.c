@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "iothub_client_tls_session_cache.h"
+
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define RESULT_OK           0
+
+typedef struct TLS_SESSION_CACHE_INSTANCE_TAG
+{
+	SINGLYLINKEDLIST_HANDLE entries;
+	TLS_SESSION_CACHE_STATISTICS statistics;
+} TLS_SESSION_CACHE_INSTANCE;
+
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+	TLS_SESSION_STORE store;
+	TLS_SESSION_CACHE_INSTANCE* tls_session_cache;
+	char* hostname;
+	unsigned char* session;
+	size_t session_size;
+} TLS_SESSION_CACHE_ENTRY;
+
+
+// ========== Helper Functions ========== //
+
+static void discard_session(TLS_SESSION_CACHE_ENTRY* entry)
+{
+	if (entry->session != NULL)
+	{
+		free(entry->session);
+		entry->session = NULL;
+	}
+
+	entry->session_size = 0;
+}
+
+static void destroy_entry(TLS_SESSION_CACHE_ENTRY* entry)
+{
+	discard_session(entry);
+	free(entry->hostname);
+	free(entry);
+}
+
+static bool find_entry_by_hostname(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+	const TLS_SESSION_CACHE_ENTRY* entry = (const TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+
+	return (entry != NULL && strcmp(entry->hostname, (const char*)match_context) == 0);
+}
+
+// ========== TLS_SESSION_STORE Callbacks ========== //
+
+static int on_get_session(void* context, const unsigned char** session, size_t* session_size)
+{
+	int result;
+
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_016: [If `context`, `session` or `session_size` are NULL, get_session shall fail and return non-zero]
+	if (context == NULL || session == NULL || session_size == NULL)
+	{
+		LogError("Failed getting TLS session (either context (%p), session (%p) or session_size (%p) are NULL)", context, session, session_size);
+		result = __FAILURE__;
+	}
+	else
+	{
+		TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)context;
+
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_017: [If a session is cached for the entry, get_session shall set `session` and `session_size`, increment the `hits` counter and return 0]
+		if (entry->session != NULL)
+		{
+			*session = entry->session;
+			*session_size = entry->session_size;
+			entry->tls_session_cache->statistics.hits++;
+			result = RESULT_OK;
+		}
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_018: [Otherwise get_session shall set `session` to NULL and `session_size` to 0, increment the `misses` counter and return non-zero]
+		else
+		{
+			*session = NULL;
+			*session_size = 0;
+			entry->tls_session_cache->statistics.misses++;
+			result = __FAILURE__;
+		}
+	}
+
+	return result;
+}
+
+static void on_save_session(void* context, const unsigned char* session, size_t session_size)
+{
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_019: [If `context` is NULL, save_session shall return]
+	if (context == NULL)
+	{
+		LogError("Failed saving TLS session (context is NULL)");
+	}
+	else
+	{
+		TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)context;
+
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_020: [Any session previously cached for the entry shall be discarded]
+		discard_session(entry);
+
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_021: [If `session` is NULL or `session_size` is 0, save_session shall return]
+		if (session != NULL && session_size > 0)
+		{
+			// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_022: [A copy of `session` shall be saved in the entry and the `sessions_saved` counter incremented]
+			if ((entry->session = (unsigned char*)malloc(session_size)) == NULL)
+			{
+				// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_023: [If malloc fails, save_session shall return without caching the session]
+				LogError("Failed saving TLS session for '%s' (malloc failed)", entry->hostname);
+			}
+			else
+			{
+				(void)memcpy(entry->session, session, session_size);
+				entry->session_size = session_size;
+				entry->tls_session_cache->statistics.sessions_saved++;
+			}
+		}
+	}
+}
+
+
+// ========== Public API ========== //
+
+TLS_SESSION_CACHE_HANDLE tls_session_cache_create(void)
+{
+	TLS_SESSION_CACHE_INSTANCE* result;
+
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_001: [`tls_session_cache_create` shall allocate memory for the cache instance structure (a.k.a. `tls_session_cache`)]
+	if ((result = (TLS_SESSION_CACHE_INSTANCE*)malloc(sizeof(TLS_SESSION_CACHE_INSTANCE))) == NULL)
+	{
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_002: [If malloc fails, `tls_session_cache_create` shall fail and return NULL]
+		LogError("Failed creating the TLS session cache (malloc failed)");
+	}
+	else
+	{
+		memset(result, 0, sizeof(TLS_SESSION_CACHE_INSTANCE));
+
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_003: [`tls_session_cache->entries` shall be created using singlylinkedlist_create()]
+		if ((result->entries = singlylinkedlist_create()) == NULL)
+		{
+			// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_004: [If singlylinkedlist_create() fails, `tls_session_cache_create` shall free any memory it allocated and return NULL]
+			LogError("Failed creating the TLS session cache (singlylinkedlist_create failed)");
+			free(result);
+			result = NULL;
+		}
+	}
+
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_005: [If no errors occur, `tls_session_cache_create` shall return a handle to `tls_session_cache`]
+	return result;
+}
+
+const TLS_SESSION_STORE* tls_session_cache_get_store(TLS_SESSION_CACHE_HANDLE tls_session_cache_handle, const char* hostname)
+{
+	const TLS_SESSION_STORE* result;
+
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_006: [If `tls_session_cache_handle` or `hostname` are NULL, `tls_session_cache_get_store` shall fail and return NULL]
+	if (tls_session_cache_handle == NULL || hostname == NULL)
+	{
+		LogError("Failed getting TLS session store (either tls_session_cache_handle (%p) or hostname (%p) are NULL)", tls_session_cache_handle, hostname);
+		result = NULL;
+	}
+	else
+	{
+		LIST_ITEM_HANDLE list_item;
+
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_007: [If an entry for `hostname` exists in `tls_session_cache->entries`, `tls_session_cache_get_store` shall return its TLS_SESSION_STORE]
+		if ((list_item = singlylinkedlist_find(tls_session_cache_handle->entries, find_entry_by_hostname, hostname)) != NULL)
+		{
+			result = &((const TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item))->store;
+		}
+		else
+		{
+			TLS_SESSION_CACHE_ENTRY* entry;
+
+			// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_008: [Otherwise a new entry shall be allocated, with a copy of `hostname` and no session]
+			if ((entry = (TLS_SESSION_CACHE_ENTRY*)malloc(sizeof(TLS_SESSION_CACHE_ENTRY))) == NULL)
+			{
+				// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_009: [If any failure occurs, `tls_session_cache_get_store` shall free any memory it allocated and return NULL]
+				LogError("Failed getting TLS session store for '%s' (malloc failed)", hostname);
+				result = NULL;
+			}
+			else
+			{
+				memset(entry, 0, sizeof(TLS_SESSION_CACHE_ENTRY));
+
+				if (mallocAndStrcpy_s(&entry->hostname, hostname) != 0)
+				{
+					// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_009: [If any failure occurs, `tls_session_cache_get_store` shall free any memory it allocated and return NULL]
+					LogError("Failed getting TLS session store for '%s' (mallocAndStrcpy_s failed)", hostname);
+					free(entry);
+					result = NULL;
+				}
+				// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_010: [The new entry shall be added to `tls_session_cache->entries` using singlylinkedlist_add()]
+				else if (singlylinkedlist_add(tls_session_cache_handle->entries, entry) == NULL)
+				{
+					// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_009: [If any failure occurs, `tls_session_cache_get_store` shall free any memory it allocated and return NULL]
+					LogError("Failed getting TLS session store for '%s' (singlylinkedlist_add failed)", hostname);
+					destroy_entry(entry);
+					result = NULL;
+				}
+				else
+				{
+					// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_011: [The TLS_SESSION_STORE of the new entry shall be set with the get_session and save_session callbacks, with the entry as context, and returned]
+					entry->tls_session_cache = tls_session_cache_handle;
+					entry->store.get_session = on_get_session;
+					entry->store.save_session = on_save_session;
+					entry->store.context = entry;
+
+					result = &entry->store;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+int tls_session_cache_get_statistics(TLS_SESSION_CACHE_HANDLE tls_session_cache_handle, TLS_SESSION_CACHE_STATISTICS* statistics)
+{
+	int result;
+
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_012: [If `tls_session_cache_handle` or `statistics` are NULL, `tls_session_cache_get_statistics` shall fail and return non-zero]
+	if (tls_session_cache_handle == NULL || statistics == NULL)
+	{
+		LogError("Failed getting TLS session cache statistics (either tls_session_cache_handle (%p) or statistics (%p) are NULL)", tls_session_cache_handle, statistics);
+		result = __FAILURE__;
+	}
+	else
+	{
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_013: [`statistics` shall be set with the `hits`, `misses` and `sessions_saved` counters of `tls_session_cache` and the function shall return 0]
+		*statistics = tls_session_cache_handle->statistics;
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+void tls_session_cache_destroy(TLS_SESSION_CACHE_HANDLE tls_session_cache_handle)
+{
+	// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_014: [If `tls_session_cache_handle` is NULL, `tls_session_cache_destroy` shall return]
+	if (tls_session_cache_handle == NULL)
+	{
+		LogError("Failed destroying the TLS session cache (tls_session_cache_handle is NULL)");
+	}
+	else
+	{
+		LIST_ITEM_HANDLE list_item;
+
+		// Codes_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_015: [Every entry (with its cached session) shall be removed and freed, then `tls_session_cache->entries` destroyed and `tls_session_cache` freed]
+		while ((list_item = singlylinkedlist_get_head_item(tls_session_cache_handle->entries)) != NULL)
+		{
+			TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+
+			if (singlylinkedlist_remove(tls_session_cache_handle->entries, list_item) != 0)
+			{
+				LogError("Failed removing TLS session cache entry from list");
+				break;
+			}
+
+			destroy_entry(entry);
+		}
+
+		singlylinkedlist_destroy(tls_session_cache_handle->entries);
+		free(tls_session_cache_handle);
+	}
+}
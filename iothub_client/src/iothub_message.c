@@ -28,6 +28,9 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
     char* correlationId;
     char* userDefinedContentType;
     char* contentEncoding;
+    IOTHUB_MESSAGE_PROPERTIES_LOADER propertiesLoader;
+    IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY propertiesLoaderContextDestroy;
+    void* propertiesLoaderContext;
 }IOTHUB_MESSAGE_HANDLE_DATA;
 
 static bool ContainsOnlyUsAscii(const char* asciiValue)
@@ -62,6 +65,35 @@ static int ValidateAsciiCharactersFilter(const char* mapKey, const char* mapValu
     return result;
 }
 
+static int LoadPendingProperties(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
+{
+    int result;
+    if (handleData->propertiesLoader == NULL)
+    {
+        result = 0;
+    }
+    /*Codes_SRS_IOTHUBMESSAGE_09_015: [If a properties loader is pending, it shall be called passing its context and the properties map before the properties map is used.]*/
+    else if (handleData->propertiesLoader(handleData->propertiesLoaderContext, handleData->properties) != 0)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_09_016: [If the properties loader fails it shall be kept, so that the next access to the properties retries loading them.]*/
+        LogError("failed loading the message properties");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_09_017: [Once the properties loader succeeds its context shall be released by calling `contextDestroy` (if not NULL) and the loader shall not be called again.]*/
+        if (handleData->propertiesLoaderContextDestroy != NULL)
+        {
+            handleData->propertiesLoaderContextDestroy(handleData->propertiesLoaderContext);
+        }
+        handleData->propertiesLoader = NULL;
+        handleData->propertiesLoaderContextDestroy = NULL;
+        handleData->propertiesLoaderContext = NULL;
+        result = 0;
+    }
+    return result;
+}
+
 IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
 {
     IOTHUB_MESSAGE_HANDLE_DATA* result;
@@ -131,6 +163,9 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byt
                     result->correlationId = NULL;
                     result->userDefinedContentType = NULL;
                     result->contentEncoding = NULL;
+                    result->propertiesLoader = NULL;
+                    result->propertiesLoaderContextDestroy = NULL;
+                    result->propertiesLoaderContext = NULL;
                     /*all is fine, return result*/
                 }
             }
@@ -184,6 +219,9 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
                 result->correlationId = NULL;
                 result->userDefinedContentType = NULL;
                 result->contentEncoding = NULL;
+                result->propertiesLoader = NULL;
+                result->propertiesLoaderContextDestroy = NULL;
+                result->propertiesLoaderContext = NULL;
             }
         }
     }
@@ -201,6 +239,12 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         result = NULL;
         LogError("iotHubMessageHandle parameter cannot be NULL for IoTHubMessage_Clone");
     }
+    /*Codes_SRS_IOTHUBMESSAGE_09_018: [IoTHubMessage_Clone shall load the pending properties of iotHubMessageHandle before cloning its properties map; if loading them fails IoTHubMessage_Clone shall return NULL.]*/
+    else if (LoadPendingProperties(iotHubMessageHandle) != 0)
+    {
+        result = NULL;
+        LogError("unable to load the properties of the message being cloned");
+    }
     else
     {
         result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
@@ -217,6 +261,9 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
             result->correlationId = NULL;
             result->userDefinedContentType = NULL;
             result->contentEncoding = NULL;
+            result->propertiesLoader = NULL;
+            result->propertiesLoaderContextDestroy = NULL;
+            result->propertiesLoaderContext = NULL;
 
             if (source->messageId != NULL && mallocAndStrcpy_s(&result->messageId, source->messageId) != 0)
             {
@@ -449,9 +496,47 @@ MAP_HANDLE IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
     }
     else
     {
-        /*Codes_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle it shall return a non-NULL MAP_HANDLE.]*/
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = (IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
-        result = handleData->properties;
+        if (LoadPendingProperties(handleData) != 0)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_09_020: [If loading the pending properties fails, IoTHubMessage_Properties shall return NULL.]*/
+            result = NULL;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle it shall return a non-NULL MAP_HANDLE.]*/
+            result = handleData->properties;
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetPropertiesLoader(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, IOTHUB_MESSAGE_PROPERTIES_LOADER propertiesLoader, IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY contextDestroy, void* context)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    if (iotHubMessageHandle == NULL || propertiesLoader == NULL)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_09_012: [If iotHubMessageHandle or propertiesLoader is NULL then IoTHubMessage_SetPropertiesLoader shall return IOTHUB_MESSAGE_INVALID_ARG.]*/
+        LogError("invalid arg (NULL) passed to IoTHubMessage_SetPropertiesLoader: iotHubMessageHandle=%p, propertiesLoader=%p", iotHubMessageHandle, propertiesLoader);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_HANDLE_DATA* handleData = (IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
+        if (handleData->propertiesLoader != NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_09_013: [If the message already has a pending properties loader then IoTHubMessage_SetPropertiesLoader shall return IOTHUB_MESSAGE_ERROR.]*/
+            LogError("the message already has a pending properties loader");
+            result = IOTHUB_MESSAGE_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_09_014: [Otherwise IoTHubMessage_SetPropertiesLoader shall store propertiesLoader, contextDestroy and context (which is then owned by the message) and return IOTHUB_MESSAGE_OK.]*/
+            handleData->propertiesLoader = propertiesLoader;
+            handleData->propertiesLoaderContextDestroy = contextDestroy;
+            handleData->propertiesLoaderContext = context;
+            result = IOTHUB_MESSAGE_OK;
+        }
     }
     return result;
 }
@@ -692,6 +777,11 @@ void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
         {
             LogError("Unknown contentType in IoTHubMessage");
         }
+        /*Codes_SRS_IOTHUBMESSAGE_09_019: [IoTHubMessage_Destroy shall release the context of a pending properties loader by calling `contextDestroy` (if not NULL).]*/
+        if (handleData->propertiesLoader != NULL && handleData->propertiesLoaderContextDestroy != NULL)
+        {
+            handleData->propertiesLoaderContextDestroy(handleData->propertiesLoaderContext);
+        }
         Map_Destroy(handleData->properties);
         free(handleData->messageId);
         handleData->messageId = NULL;
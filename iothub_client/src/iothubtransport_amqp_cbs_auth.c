@@ -6,11 +6,13 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/agenttime.h" 
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/sastoken.h"
 
 #define RESULT_OK                                 0
 #define INDEFINITE_TIME                           ((time_t)(-1))
+#define INDEFINITE_TIME_MS                        ((tickcounter_ms_t)(-1))
 #define SAS_TOKEN_TYPE                            "servicebus.windows.net:sastoken"
 #define IOTHUB_DEVICES_PATH_FMT                   "%s/devices/%s"
 #define DEFAULT_CBS_REQUEST_TIMEOUT_SECS          UINT32_MAX
@@ -38,7 +40,11 @@ typedef struct AUTHENTICATION_INSTANCE_TAG
     bool is_cbs_put_token_in_progress;
     bool is_sas_token_refresh_in_progress;
 
-    time_t current_sas_token_put_time;
+    tickcounter_ms_t current_sas_token_put_time;
+
+    // Millisecond clock shared by the connection, sampled once per authentication_do_work()
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t current_time_ms;
 
     // Auth module used to generating handle authorization
     // with either SAS Token, x509 Certs, and Device SAS Token
@@ -90,35 +96,36 @@ static void notify_error(AUTHENTICATION_INSTANCE* instance, AUTHENTICATION_ERROR
     }
 }
 
+// Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_135: [Timeouts shall be verified in milliseconds as the unsigned difference between the current and start tick counts, so a tick counter wraparound does not cause a spurious or missed timeout]
+static bool is_timeout_reached(tickcounter_ms_t current_time_ms, tickcounter_ms_t start_time_ms, size_t timeout_secs)
+{
+    return (tickcounter_ms_t)(current_time_ms - start_time_ms) >= (tickcounter_ms_t)timeout_secs * 1000;
+}
+
 static int verify_cbs_put_token_timeout(AUTHENTICATION_INSTANCE* instance, bool* is_timed_out)
 {
     int result;
 
-    if (instance->current_sas_token_put_time == INDEFINITE_TIME)
+    if (instance->current_sas_token_put_time == INDEFINITE_TIME_MS)
     {
         result = __FAILURE__;
         LogError("Failed verifying if cbs_put_token has timed out (current_sas_token_put_time is not set)");
     }
+    else if (instance->current_time_ms == INDEFINITE_TIME_MS)
+    {
+        result = __FAILURE__;
+        LogError("Failed verifying if cbs_put_token has timed out (current time is not set)");
+    }
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_083: [authentication_do_work() shall check for authentication timeout comparing the current time since `instance->current_sas_token_put_time` to `instance->cbs_request_timeout_secs`]
+    else if (is_timeout_reached(instance->current_time_ms, instance->current_sas_token_put_time, instance->cbs_request_timeout_secs))
+    {
+        *is_timed_out = true;
+        result = RESULT_OK;
+    }
     else
     {
-        time_t current_time;
-
-        if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
-        {
-            result = __FAILURE__;
-            LogError("Failed verifying if cbs_put_token has timed out (get_time failed)");
-        }
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_083: [authentication_do_work() shall check for authentication timeout comparing the current time since `instance->current_sas_token_put_time` to `instance->cbs_request_timeout_secs`]
-        else if ((uint32_t)get_difftime(current_time, instance->current_sas_token_put_time) >= instance->cbs_request_timeout_secs)
-        {
-            *is_timed_out = true;
-            result = RESULT_OK;
-        }
-        else
-        {
-            *is_timed_out = false;
-            result = RESULT_OK;
-        }
+        *is_timed_out = false;
+        result = RESULT_OK;
     }
 
     return result;
@@ -128,30 +135,25 @@ static int verify_sas_token_refresh_timeout(AUTHENTICATION_INSTANCE* instance, b
 {
     int result;
 
-    if (instance->current_sas_token_put_time == INDEFINITE_TIME)
+    if (instance->current_sas_token_put_time == INDEFINITE_TIME_MS)
     {
         result = __FAILURE__;
         LogError("Failed verifying if SAS token refresh timed out (current_sas_token_put_time is not set)");
     }
+    else if (instance->current_time_ms == INDEFINITE_TIME_MS)
+    {
+        result = __FAILURE__;
+        LogError("Failed verifying if SAS token refresh timed out (current time is not set)");
+    }
+    else if (is_timeout_reached(instance->current_time_ms, instance->current_sas_token_put_time, instance->sas_token_refresh_time_secs))
+    {
+        *is_timed_out = true;
+        result = RESULT_OK;
+    }
     else
     {
-        time_t current_time;
-
-        if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
-        {
-            result = __FAILURE__;
-            LogError("Failed verifying if SAS token refresh timed out (get_time failed)");
-        }
-        else if ((uint32_t)get_difftime(current_time, instance->current_sas_token_put_time) >= instance->sas_token_refresh_time_secs)
-        {
-            *is_timed_out = true;
-            result = RESULT_OK;
-        }
-        else
-        {
-            *is_timed_out = false;
-            result = RESULT_OK;
-        }
+        *is_timed_out = false;
+        result = RESULT_OK;
     }
 
     return result;
@@ -232,14 +234,7 @@ static int put_SAS_token_to_cbs(AUTHENTICATION_INSTANCE* instance, STRING_HANDLE
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_047: [If cbs_put_token() succeeds, authentication_do_work() shall set `instance->current_sas_token_put_time` with current time]
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_059: [If cbs_put_token() succeeds, authentication_do_work() shall set `instance->current_sas_token_put_time` with current time]
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_077: [If cbs_put_token() succeeds, authentication_do_work() shall set `instance->current_sas_token_put_time` with the current time]
-        time_t current_time;
-
-        if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
-        {
-            LogError("Failed setting current_sas_token_put_time for device '%s' (get_time() failed)", instance->device_id);
-        }
-
-        instance->current_sas_token_put_time = current_time; // If it failed, fear not. `current_sas_token_put_time` shall be checked for INDEFINITE_TIME wherever it is used.
+        instance->current_sas_token_put_time = instance->current_time_ms; // If the clock read failed, fear not. `current_sas_token_put_time` shall be checked for INDEFINITE_TIME_MS wherever it is used.
 
         result = RESULT_OK;
     }
@@ -531,6 +526,12 @@ AUTHENTICATION_HANDLE authentication_create(const AUTHENTICATION_CONFIG* config)
         result = NULL;
         LogError("authentication_create failed (config->authorization_module is NULL)");
     }
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_131: [If `config->tick_counter` is NULL, authentication_create() shall fail and return NULL.]
+    else if (config->tick_counter == NULL)
+    {
+        result = NULL;
+        LogError("authentication_create failed (config->tick_counter is NULL)");
+    }
     // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_004: [If `config->iothub_host_fqdn` is NULL, authentication_create() shall fail and return NULL.]
     else if (config->iothub_host_fqdn == NULL)
     {
@@ -594,6 +595,9 @@ AUTHENTICATION_HANDLE authentication_create(const AUTHENTICATION_CONFIG* config)
 
                 instance->authorization_module = config->authorization_module;
 
+                // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_132: [authentication_create() shall save `config->tick_counter` into `instance->tick_counter`, without taking ownership of it]
+                instance->tick_counter = config->tick_counter;
+
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_024: [If no failure occurs, authentication_create() shall return a reference to the AUTHENTICATION_INSTANCE handle]
                 result = (AUTHENTICATION_HANDLE)instance;
             }
@@ -619,7 +623,15 @@ void authentication_do_work(AUTHENTICATION_HANDLE authentication_handle)
     else
     {
         AUTHENTICATION_INSTANCE* instance = (AUTHENTICATION_INSTANCE*)authentication_handle;
-        
+
+        // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_133: [authentication_do_work() shall read the current time once from `instance->tick_counter` using tickcounter_get_current_ms()]
+        if (tickcounter_get_current_ms(instance->tick_counter, &instance->current_time_ms) != 0)
+        {
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_134: [If tickcounter_get_current_ms() fails, the current time shall be considered unknown and no timeout shall be triggered on this call]
+            LogError("Failed reading the current time for device '%s' (tickcounter_get_current_ms failed)", instance->device_id);
+            instance->current_time_ms = INDEFINITE_TIME_MS;
+        }
+
         // Codes_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_038: [If `instance->is_cbs_put_token_in_progress` is TRUE, authentication_do_work() shall only verify the authentication timeout]
         if (instance->is_cbs_put_token_in_progress)
         {
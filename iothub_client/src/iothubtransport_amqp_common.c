@@ -20,6 +20,7 @@
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/tickcounter.h"
 
 #include "azure_uamqp_c/cbs.h"
 #include "azure_uamqp_c/session.h"
@@ -33,6 +34,7 @@
 #include "iothubtransportamqp_methods.h"
 #endif
 #include "iothub_client_retry_control.h"
+#include "iothub_client_tls_session_cache.h"
 #include "iothubtransport_amqp_common.h"
 #include "iothubtransport_amqp_connection.h"
 #include "iothubtransport_amqp_device.h"
@@ -86,6 +88,9 @@ typedef struct AMQP_TRANSPORT_INSTANCE_TAG
     AMQP_TRANSPORT_STATE state;                                         // Current state of the transport.
     RETRY_CONTROL_HANDLE connection_retry_control;                      // Controls when the re-connection attempt should occur.
     size_t c2d_keep_alive_freq_secs;                                    // Service to device keep alive frequency
+    TICK_COUNTER_HANDLE tick_counter;                                   // Millisecond clock shared by all devices of this connection.
+    TLS_SESSION_CACHE_HANDLE tls_session_cache;                         // TLS sessions offered to new TLS I/O instances, so reconnections can skip the full handshake.
+    bool is_tls_session_resumption_unsupported;                         // Set once the TLS I/O rejects OPTION_TLS_SESSION_STORE.
 
     char* http_proxy_hostname;
     int http_proxy_port;
@@ -96,6 +101,7 @@ typedef struct AMQP_TRANSPORT_INSTANCE_TAG
     size_t option_sas_token_refresh_time_secs;                          // Device-specific option.
     size_t option_cbs_request_timeout_secs;                             // Device-specific option.
     size_t option_send_event_timeout_secs;                              // Device-specific option.
+    size_t option_message_pool_size;                                    // Device-specific option.
 
                                                                         // Auth module used to generating handle authorization
     IOTHUB_AUTHORIZATION_HANDLE authorization_module;                   // with either SAS Token, x509 Certs, and Device SAS Token
@@ -624,6 +630,30 @@ static int restore_underlying_io_transport_options(AMQP_TRANSPORT_INSTANCE* tran
     return result;
 }
 
+// @brief    Hands the cached TLS session store for the IoT Hub host to a new TLS I/O instance.
+//           Session resumption is an optimization only; any failure here is logged and ignored.
+static void set_underlying_io_transport_tls_session_store(AMQP_TRANSPORT_INSTANCE* transport_instance, XIO_HANDLE xio_handle)
+{
+    if (!transport_instance->is_tls_session_resumption_unsupported)
+    {
+        const TLS_SESSION_STORE* tls_session_store;
+
+        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_159: [When a new `instance->tls_io` is created, the TLS session store for `instance->iothub_host_fqdn` shall be obtained using tls_session_cache_get_store() and set on it using xio_setoption() with OPTION_TLS_SESSION_STORE]
+        if ((tls_session_store = tls_session_cache_get_store(transport_instance->tls_session_cache, STRING_c_str(transport_instance->iothub_host_fqdn))) == NULL)
+        {
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_160: [If tls_session_cache_get_store() or xio_setoption() fail, it shall be ignored]
+            LogError("Failed obtaining the TLS session store; the TLS handshake will not be resumed.");
+        }
+        else if (xio_setoption(xio_handle, OPTION_TLS_SESSION_STORE, tls_session_store) != RESULT_OK)
+        {
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_160: [If tls_session_cache_get_store() or xio_setoption() fail, it shall be ignored]
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_161: [If xio_setoption() fails, the TLS session store shall not be set on subsequent TLS I/O instances]
+            LogInfo("TLS I/O does not support session resumption; reconnections will use full TLS handshakes.");
+            transport_instance->is_tls_session_resumption_unsupported = true;
+        }
+    }
+}
+
 // @brief    Destroys the XIO_HANDLE obtained with underlying_io_transport_provider(), saving its options beforehand.
 static void destroy_underlying_io_transport(AMQP_TRANSPORT_INSTANCE* transport_instance)
 {
@@ -662,6 +692,8 @@ static int get_new_underlying_io_transport(AMQP_TRANSPORT_INSTANCE* transport_in
             LogError("Failed to apply options previous saved to new underlying I/O transport instance.");
         }
 
+        set_underlying_io_transport_tls_session_store(transport_instance, *xio_handle);
+
         result = RESULT_OK;
     }
 
@@ -925,6 +957,8 @@ static IOTHUB_CLIENT_CONFIRMATION_RESULT get_iothub_client_confirmation_result_f
 static void on_event_send_complete(IOTHUB_MESSAGE_LIST* message, D2C_EVENT_SEND_RESULT result, void* context)
 {
     AMQP_TRANSPORT_DEVICE_INSTANCE* registered_device = (AMQP_TRANSPORT_DEVICE_INSTANCE*)context;
+    IOTHUB_CLIENT_CONFIRMATION_RESULT iothub_send_result;
+    DLIST_ENTRY messageCompleted;
 
     if (result != D2C_EVENT_SEND_COMPLETE_RESULT_OK && result != D2C_EVENT_SEND_COMPLETE_RESULT_DEVICE_DESTROYED)
     {
@@ -935,24 +969,19 @@ static void on_event_send_complete(IOTHUB_MESSAGE_LIST* message, D2C_EVENT_SEND_
         registered_device->number_of_send_event_complete_failures = 0;
     }
 
-    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_056: [If `message->callback` is not NULL, it shall invoked with the `iothub_send_result`]
-    if (message->callback != NULL)
-    {
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_050: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_OK, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_OK]
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_051: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_052: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_053: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT]
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_054: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_DEVICE_DESTROYED, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY]
-        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_055: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_UNKNOWN, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
-        IOTHUB_CLIENT_CONFIRMATION_RESULT iothub_send_result = get_iothub_client_confirmation_result_from(result);
-
-        message->callback(iothub_send_result, message->context);
-    }
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_050: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_OK, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_OK]
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_051: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_052: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_053: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT]
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_054: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_DEVICE_DESTROYED, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY]
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_055: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_UNKNOWN, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
+    iothub_send_result = get_iothub_client_confirmation_result_from(result);
 
-    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_057: [`message->messageHandle` shall be destroyed using IoTHubMessage_Destroy]
-    IoTHubMessage_Destroy(message->messageHandle);
-    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_058: [`message` shall be destroyed using free]
-    free(message);
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_056: [`message` shall be completed by invoking IoTHubClient_LL_SendComplete passing `registered_device->iothub_client_handle`, a list containing only `message` and `iothub_send_result`]
+    // The IOTHUB_MESSAGE_LIST belongs to the LL client, which invokes `message->callback`, destroys `message->messageHandle` and releases `message`.
+    DList_InitializeListHead(&messageCompleted);
+    DList_InsertTailList(&messageCompleted, &(message->entry));
+    IoTHubClient_LL_SendComplete(registered_device->iothub_client_handle, &messageCompleted, iothub_send_result);
 }
 
 // @brief
@@ -1127,6 +1156,16 @@ static int replicate_device_options_to(AMQP_TRANSPORT_DEVICE_INSTANCE* dev_insta
         LogError("Failed to apply option DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS to device '%s' (device_set_option failed)", STRING_c_str(dev_instance->device_id));
         result = __FAILURE__;
     }
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_162: [If OPTION_MESSAGE_POOL_SIZE has been set to a non-zero value, it shall be applied to each new registered device using device_set_option()]
+    else if (dev_instance->transport_instance->option_message_pool_size != 0 &&
+        device_set_option(
+            dev_instance->device_handle,
+            DEVICE_OPTION_MESSAGE_POOL_SIZE,
+            &dev_instance->transport_instance->option_message_pool_size) != RESULT_OK)
+    {
+        LogError("Failed to apply option DEVICE_OPTION_MESSAGE_POOL_SIZE to device '%s' (device_set_option failed)", STRING_c_str(dev_instance->device_id));
+        result = __FAILURE__;
+    }
     else if (auth_mode == DEVICE_AUTH_MODE_CBS)
     {
         if (device_set_option(
@@ -1188,6 +1227,10 @@ static const char* get_device_option_name_from(const char* iothubclient_option_n
     {
         device_option_name = DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS;
     }
+    else if (strcmp(OPTION_MESSAGE_POOL_SIZE, iothubclient_option_name) == 0)
+    {
+        device_option_name = DEVICE_OPTION_MESSAGE_POOL_SIZE;
+    }
     else
     {
         device_option_name = NULL;
@@ -1271,6 +1314,16 @@ static void internal_destroy_instance(AMQP_TRANSPORT_INSTANCE* instance)
         destroy_underlying_io_transport_options(instance);
         retry_control_destroy(instance->connection_retry_control);
 
+        if (instance->tick_counter != NULL)
+        {
+            tickcounter_destroy(instance->tick_counter);
+        }
+
+        if (instance->tls_session_cache != NULL)
+        {
+            tls_session_cache_destroy(instance->tls_session_cache);
+        }
+
         STRING_delete(instance->iothub_host_fqdn);
 
         /* SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_043: [ `IoTHubTransport_AMQP_Common_Destroy` shall free the stored proxy options. ]*/
@@ -1371,6 +1424,20 @@ TRANSPORT_LL_HANDLE IoTHubTransport_AMQP_Common_Create(const IOTHUBTRANSPORT_CON
                 LogError("Failed to initialize the internal list of registered devices (singlylinkedlist_create failed)");
                 result = NULL;
             }
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_154: [`instance->tick_counter` shall be set using tickcounter_create()]
+            else if ((instance->tick_counter = tickcounter_create()) == NULL)
+            {
+                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_155: [If tickcounter_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
+                LogError("Failed to create the transport tick counter (tickcounter_create failed)");
+                result = NULL;
+            }
+            // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_157: [`instance->tls_session_cache` shall be set using tls_session_cache_create()]
+            else if ((instance->tls_session_cache = tls_session_cache_create()) == NULL)
+            {
+                // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_158: [If tls_session_cache_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
+                LogError("Failed to create the TLS session cache (tls_session_cache_create failed)");
+                result = NULL;
+            }
             else
             {
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_010: [`get_io_transport` shall be saved on `instance->underlying_io_transport_provider`]
@@ -1380,6 +1447,7 @@ TRANSPORT_LL_HANDLE IoTHubTransport_AMQP_Common_Create(const IOTHUBTRANSPORT_CON
                 instance->option_sas_token_refresh_time_secs = DEFAULT_SAS_TOKEN_REFRESH_TIME_SECS;
                 instance->option_cbs_request_timeout_secs = DEFAULT_CBS_REQUEST_TIMEOUT_SECS;
                 instance->option_send_event_timeout_secs = DEFAULT_EVENT_SEND_TIMEOUT_SECS;
+                instance->option_message_pool_size = 0;
                 // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_12_002: [The connection idle timeout parameter default value shall be set to 240000 milliseconds using connection_set_idle_timeout()]
                 instance->c2d_keep_alive_freq_secs = DEFAULT_C2D_KEEP_ALIVE_FREQ_SECS;
 
@@ -1865,6 +1933,11 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_AMQP_Common_SetOption(TRANSPORT_LL_HANDLE h
             is_device_specific_option = true;
             transport_instance->option_send_event_timeout_secs = *(size_t*)value;
         }
+        else if (strcmp(OPTION_MESSAGE_POOL_SIZE, option) == 0)
+        {
+            is_device_specific_option = true;
+            transport_instance->option_message_pool_size = *(size_t*)value;
+        }
         else
         {
             is_device_specific_option = false;
@@ -2128,6 +2201,8 @@ IOTHUB_DEVICE_HANDLE IoTHubTransport_AMQP_Common_Register(TRANSPORT_LL_HANDLE ha
                     device_config.on_state_changed_callback = on_device_state_changed_callback;
                     device_config.on_state_changed_context = amqp_device_instance;
                     device_config.product_info = local_product_info;
+                    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_156: [The configuration for device_create shall use `instance->tick_counter` as the device's tick counter]
+                    device_config.tick_counter = transport_instance->tick_counter;
 
                     // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_071: [`amqp_device_instance->device_handle` shall be set using device_create()]
                     if ((amqp_device_instance->device_handle = device_create(&device_config)) == NULL)
@@ -2317,6 +2392,28 @@ STRING_HANDLE IoTHubTransport_AMQP_Common_GetHostname(TRANSPORT_LL_HANDLE handle
     return result;
 }
 
+void IoTHubTransport_AMQP_Common_GetStatistics(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    TLS_SESSION_CACHE_STATISTICS tls_session_cache_statistics;
+
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_163: [If `handle` or `statistics` are NULL, IoTHubTransport_AMQP_Common_GetStatistics shall return without changes]
+    if (handle == NULL || statistics == NULL)
+    {
+        LogError("Cannot provide the transport statistics (either handle (%p) or statistics (%p) are NULL)", handle, statistics);
+    }
+    // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_164: [IoTHubTransport_AMQP_Common_GetStatistics shall set `statistics->tls_session_cache_hits` and `statistics->tls_session_cache_misses` from tls_session_cache_get_statistics() on `instance->tls_session_cache`]
+    else if (tls_session_cache_get_statistics(((AMQP_TRANSPORT_INSTANCE*)handle)->tls_session_cache, &tls_session_cache_statistics) != 0)
+    {
+        // Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_165: [If tls_session_cache_get_statistics() fails, IoTHubTransport_AMQP_Common_GetStatistics shall leave `statistics` unchanged]
+        LogError("Cannot provide the TLS session cache statistics (tls_session_cache_get_statistics failed)");
+    }
+    else
+    {
+        statistics->tls_session_cache_hits = tls_session_cache_statistics.hits;
+        statistics->tls_session_cache_misses = tls_session_cache_statistics.misses;
+    }
+}
+
 IOTHUB_CLIENT_RESULT IoTHubTransport_AMQP_Common_SendMessageDisposition(MESSAGE_CALLBACK_INFO* message_data, IOTHUBMESSAGE_DISPOSITION_RESULT disposition)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -4,7 +4,7 @@
 #include <stdlib.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/agenttime.h" 
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/strings.h"
 #include "iothubtransport_amqp_cbs_auth.h"
@@ -21,7 +21,7 @@ DEFINE_ENUM_STRINGS(DEVICE_TWIN_UPDATE_RESULT, DEVICE_TWIN_UPDATE_RESULT_STRINGS
 DEFINE_ENUM_STRINGS(DEVICE_TWIN_UPDATE_TYPE, DEVICE_TWIN_UPDATE_TYPE_STRINGS)
 
 #define RESULT_OK                                  0
-#define INDEFINITE_TIME                            ((time_t)-1)
+#define INDEFINITE_TIME                            ((tickcounter_ms_t)-1)
 #define DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS    60
 #define DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS    60
 
@@ -32,6 +32,7 @@ typedef struct DEVICE_INSTANCE_TAG
 {
     DEVICE_CONFIG* config;
     DEVICE_STATE state;
+    tickcounter_ms_t current_time_ms;
 
     SESSION_HANDLE session_handle;
     CBS_HANDLE cbs_handle;
@@ -39,12 +40,12 @@ typedef struct DEVICE_INSTANCE_TAG
     AUTHENTICATION_HANDLE authentication_handle;
     AUTHENTICATION_STATE auth_state;
     AUTHENTICATION_ERROR_CODE auth_error_code;
-    time_t auth_state_last_changed_time;
+    tickcounter_ms_t auth_state_last_changed_time;
     size_t auth_state_change_timeout_secs;
 
     TELEMETRY_MESSENGER_HANDLE messenger_handle;
     TELEMETRY_MESSENGER_STATE msgr_state;
-    time_t msgr_state_last_changed_time;
+    tickcounter_ms_t msgr_state_last_changed_time;
     size_t msgr_state_change_timeout_secs;
 
     ON_DEVICE_C2D_MESSAGE_RECEIVED on_message_received_callback;
@@ -52,7 +53,7 @@ typedef struct DEVICE_INSTANCE_TAG
 
 	TWIN_MESSENGER_HANDLE twin_messenger_handle;
 	TWIN_MESSENGER_STATE twin_msgr_state;
-	time_t twin_msgr_state_last_changed_time;
+	tickcounter_ms_t twin_msgr_state_last_changed_time;
 	size_t twin_msgr_state_change_timeout_secs;
 	DEVICE_TWIN_UPDATE_RECEIVED_CALLBACK on_device_twin_update_received_callback;
 	void* on_device_twin_update_received_context;
@@ -85,7 +86,7 @@ static void update_state(DEVICE_INSTANCE* instance, DEVICE_STATE new_state)
     }
 }
 
-static int is_timeout_reached(time_t start_time, size_t timeout_in_secs, int *is_timed_out)
+static int is_timeout_reached(tickcounter_ms_t current_time, tickcounter_ms_t start_time, size_t timeout_in_secs, int *is_timed_out)
 {
     int result;
 
@@ -94,33 +95,43 @@ static int is_timeout_reached(time_t start_time, size_t timeout_in_secs, int *is
         LogError("Failed to verify timeout (start_time is INDEFINITE)");
         result = __FAILURE__;
     }
+    else if (current_time == INDEFINITE_TIME)
+    {
+        LogError("Failed to verify timeout (current time is INDEFINITE)");
+        result = __FAILURE__;
+    }
     else
     {
-        time_t current_time;
-
-        if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
+        // Codes_SRS_DEVICE_09_155: [Timeouts shall be verified using the unsigned difference between the current time and the time of the last state change, so the verification is not affected by the tick counter wrapping around]
+        if ((tickcounter_ms_t)(current_time - start_time) >= (tickcounter_ms_t)timeout_in_secs * 1000)
         {
-            LogError("Failed to verify timeout (get_time failed)");
-            result = __FAILURE__;
+            *is_timed_out = 1;
         }
         else
         {
-            if (get_difftime(current_time, start_time) >= timeout_in_secs)
-            {
-                *is_timed_out = 1;
-            }
-            else
-            {
-                *is_timed_out = 0;
-            }
-
-            result = RESULT_OK;
+            *is_timed_out = 0;
         }
+
+        result = RESULT_OK;
     }
 
     return result;
 }
 
+static tickcounter_ms_t get_state_change_time(DEVICE_INSTANCE* instance)
+{
+    tickcounter_ms_t current_time;
+
+    // Codes_SRS_DEVICE_09_154: [The time of each authentication, messenger or TWIN messenger state change shall be obtained using tickcounter_get_current_ms() on `config->tick_counter`]
+    if (tickcounter_get_current_ms(instance->config->tick_counter, &current_time) != 0)
+    {
+        LogError("Device '%s' failed to get the time of the state change (tickcounter_get_current_ms failed)", instance->config->device_id);
+        current_time = INDEFINITE_TIME;
+    }
+
+    return current_time;
+}
+
 
 //---------- Callback Handlers ----------//
 
@@ -205,11 +216,7 @@ static void on_authentication_state_changed_callback(void* context, AUTHENTICATI
     {
         DEVICE_INSTANCE* instance = (DEVICE_INSTANCE*)context;
         instance->auth_state = new_state;
-
-        if ((instance->auth_state_last_changed_time = get_time(NULL)) == INDEFINITE_TIME)
-        {
-            LogError("Device '%s' failed to set time of last authentication state change (get_time failed)", instance->config->device_id);
-        }
+        instance->auth_state_last_changed_time = get_state_change_time(instance);
     }
 }
 
@@ -223,11 +230,7 @@ static void on_messenger_state_changed_callback(void* context, TELEMETRY_MESSENG
     {
         DEVICE_INSTANCE* instance = (DEVICE_INSTANCE*)context;
         instance->msgr_state = new_state;
-
-        if ((instance->msgr_state_last_changed_time = get_time(NULL)) == INDEFINITE_TIME)
-        {
-            LogError("Device '%s' failed to set time of last messenger state change (get_time failed)", instance->config->device_id);
-        }
+        instance->msgr_state_last_changed_time = get_state_change_time(instance);
     }
 }
 
@@ -309,11 +312,7 @@ static void on_twin_messenger_state_changed_callback(void* context, TWIN_MESSENG
 	{
 		DEVICE_INSTANCE* instance = (DEVICE_INSTANCE*)context;
 		instance->twin_msgr_state = new_state;
-
-		if ((instance->twin_msgr_state_last_changed_time = get_time(NULL)) == INDEFINITE_TIME)
-		{
-			LogError("Failed setting time of last twin messenger state changed event");
-		}
+		instance->twin_msgr_state_last_changed_time = get_state_change_time(instance);
 	}
 }
 
@@ -495,6 +494,7 @@ static DEVICE_CONFIG* clone_device_config(DEVICE_CONFIG *config)
             new_config->authentication_mode = config->authentication_mode;
             new_config->on_state_changed_callback = config->on_state_changed_callback;
             new_config->on_state_changed_context = config->on_state_changed_context;
+            new_config->tick_counter = config->tick_counter;
             new_config->device_id = IoTHubClient_Auth_Get_DeviceId(config->authorization_module);
             result = RESULT_OK;
         }
@@ -520,6 +520,7 @@ static void set_authentication_config(DEVICE_INSTANCE* device_instance, AUTHENTI
     auth_config->on_state_changed_callback = on_authentication_state_changed_callback;
     auth_config->on_state_changed_callback_context = device_instance;
     auth_config->authorization_module = device_config->authorization_module;
+    auth_config->tick_counter = device_config->tick_counter;
 }
 
 // Create and Destroy Helpers
@@ -576,6 +577,7 @@ static int create_telemetry_messenger_instance(DEVICE_INSTANCE* instance, const
     messenger_config.iothub_host_fqdn = instance->config->iothub_host_fqdn;
     messenger_config.on_state_changed_callback = on_messenger_state_changed_callback;
     messenger_config.on_state_changed_context = instance;
+    messenger_config.tick_counter = instance->config->tick_counter;
 
     if ((instance->messenger_handle = telemetry_messenger_create(&messenger_config, pi)) == NULL)
     {
@@ -600,6 +602,7 @@ static int create_twin_messenger(DEVICE_INSTANCE* instance)
 	twin_msgr_config.iothub_host_fqdn = instance->config->iothub_host_fqdn;
 	twin_msgr_config.on_state_changed_callback = on_twin_messenger_state_changed_callback;
 	twin_msgr_config.on_state_changed_context = (void*)instance;
+	twin_msgr_config.tick_counter = instance->config->tick_counter;
 
 	if ((instance->twin_messenger_handle = twin_messenger_create(&twin_msgr_config)) == NULL)
 	{
@@ -673,6 +676,7 @@ DEVICE_HANDLE device_create(DEVICE_CONFIG *config)
     DEVICE_INSTANCE *instance;
 
     // Codes_SRS_DEVICE_09_001: [If config, authorization_module or iothub_host_fqdn or on_state_changed_callback are NULL then device_create shall fail and return NULL]
+    // Codes_SRS_DEVICE_09_152: [If `config->tick_counter` is NULL then device_create shall fail and return NULL]
     if (config == NULL)
     {
         LogError("Failed creating the device instance (config is NULL)");
@@ -693,6 +697,11 @@ DEVICE_HANDLE device_create(DEVICE_CONFIG *config)
         LogError("Failed creating the device instance (config->authorization_module is NULL)");
         instance = NULL;
     }
+    else if (config->tick_counter == NULL)
+    {
+        LogError("Failed creating the device instance (config->tick_counter is NULL)");
+        instance = NULL;
+    }
     // Codes_SRS_DEVICE_09_002: [device_create shall allocate memory for the device instance structure]
     else if ((instance = (DEVICE_INSTANCE*)malloc(sizeof(DEVICE_INSTANCE))) == NULL)
     {
@@ -898,6 +907,13 @@ void device_do_work(DEVICE_HANDLE handle)
 
         if (instance->state == DEVICE_STATE_STARTING)
         {
+            // Codes_SRS_DEVICE_09_153: [If the device state is DEVICE_STATE_STARTING, the current time shall be obtained once using tickcounter_get_current_ms() and used for all timeout verifications in this call]
+            if (tickcounter_get_current_ms(instance->config->tick_counter, &instance->current_time_ms) != 0)
+            {
+                LogError("Device '%s' failed to get the current time (tickcounter_get_current_ms failed)", instance->config->device_id);
+                instance->current_time_ms = INDEFINITE_TIME;
+            }
+
             // Codes_SRS_DEVICE_09_034: [If CBS authentication is used and authentication state is AUTHENTICATION_STATE_STOPPED, authentication_start shall be invoked]
             if (instance->config->authentication_mode == DEVICE_AUTH_MODE_CBS)
             {
@@ -915,7 +931,7 @@ void device_do_work(DEVICE_HANDLE handle)
                 else if (instance->auth_state == AUTHENTICATION_STATE_STARTING)
                 {
                     int is_timed_out;
-                    if (is_timeout_reached(instance->auth_state_last_changed_time, instance->auth_state_change_timeout_secs, &is_timed_out) != RESULT_OK)
+                    if (is_timeout_reached(instance->current_time_ms, instance->auth_state_last_changed_time, instance->auth_state_change_timeout_secs, &is_timed_out) != RESULT_OK)
                     {
                         LogError("Device '%s' failed verifying the timeout for authentication start (is_timeout_reached failed)", instance->config->device_id);
                         update_state(instance, DEVICE_STATE_ERROR_AUTH);
@@ -965,7 +981,7 @@ void device_do_work(DEVICE_HANDLE handle)
                 else if (instance->msgr_state == TELEMETRY_MESSENGER_STATE_STARTING)
                 {
                     int is_timed_out;
-                    if (is_timeout_reached(instance->msgr_state_last_changed_time, instance->msgr_state_change_timeout_secs, &is_timed_out) != RESULT_OK)
+                    if (is_timeout_reached(instance->current_time_ms, instance->msgr_state_last_changed_time, instance->msgr_state_change_timeout_secs, &is_timed_out) != RESULT_OK)
                     {
                         LogError("Device '%s' failed verifying the timeout for messenger start (is_timeout_reached failed)", instance->config->device_id);
 
@@ -1006,7 +1022,7 @@ void device_do_work(DEVICE_HANDLE handle)
 				else if (instance->twin_msgr_state == TWIN_MESSENGER_STATE_STARTING)
 				{
 					int is_timed_out;
-					if (is_timeout_reached(instance->twin_msgr_state_last_changed_time, instance->twin_msgr_state_change_timeout_secs, &is_timed_out) != RESULT_OK)
+					if (is_timeout_reached(instance->current_time_ms, instance->twin_msgr_state_last_changed_time, instance->twin_msgr_state_change_timeout_secs, &is_timed_out) != RESULT_OK)
 					{
 						LogError("Device '%s' failed verifying the timeout for twin messenger start (is_timeout_reached failed)", instance->config->device_id);
 
@@ -1414,6 +1430,20 @@ int device_set_option(DEVICE_HANDLE handle, const char* name, void* value)
                 result = RESULT_OK;
             }
         }
+        else if (strcmp(DEVICE_OPTION_MESSAGE_POOL_SIZE, name) == 0)
+        {
+            // Codes_SRS_DEVICE_09_156: [If `name` is DEVICE_OPTION_MESSAGE_POOL_SIZE, `value` shall be passed to telemetry_messenger_set_option as MESSENGER_OPTION_MESSAGE_POOL_SIZE]
+            if (telemetry_messenger_set_option(instance->messenger_handle, MESSENGER_OPTION_MESSAGE_POOL_SIZE, value) != RESULT_OK)
+            {
+                // Codes_SRS_DEVICE_09_087: [If telemetry_messenger_set_option fails, device_set_option shall return a non-zero result]
+                LogError("failed setting option for device '%s' (failed setting messenger option '%s')", instance->config->device_id, name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = RESULT_OK;
+            }
+        }
         else if (strcmp(DEVICE_OPTION_SAVED_AUTH_OPTIONS, name) == 0)
         {
             // Codes_SRS_DEVICE_09_088: [If `name` is DEVICE_OPTION_SAVED_AUTH_OPTIONS but CBS authentication is not being used, device_set_option shall return a non-zero result]
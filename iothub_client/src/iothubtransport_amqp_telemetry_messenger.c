@@ -6,7 +6,7 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/agenttime.h" 
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/uniqueid.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
@@ -17,10 +17,10 @@
 #include "uamqp_messaging.h"
 #include "iothub_client_private.h"
 #include "iothub_client_version.h"
+#include "iothub_client_slab.h"
 #include "iothubtransport_amqp_telemetry_messenger.h"
 
 #define RESULT_OK 0
-#define INDEFINITE_TIME ((time_t)(-1))
 
 #define IOTHUB_DEVICES_PATH_FMT                         "%s/devices/%s"
 #define IOTHUB_EVENT_SEND_ADDRESS_FMT                   "amqps://%s/messages/events"
@@ -43,6 +43,7 @@ typedef struct TELEMETRY_MESSENGER_INSTANCE_TAG
 	STRING_HANDLE iothub_host_fqdn;
 	SINGLYLINKEDLIST_HANDLE waiting_to_send;
 	SINGLYLINKEDLIST_HANDLE in_progress_list;
+	UAMQP_MESSAGE_TEMPLATE_HANDLE message_template;
 	TELEMETRY_MESSENGER_STATE state;
 	
 	ON_TELEMETRY_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
@@ -65,8 +66,12 @@ typedef struct TELEMETRY_MESSENGER_INSTANCE_TAG
 	size_t event_send_retry_limit;
 	size_t event_send_error_count;
 	size_t event_send_timeout_secs;
-	time_t last_message_sender_state_change_time;
-	time_t last_message_receiver_state_change_time;
+	TICK_COUNTER_HANDLE tick_counter;
+	tickcounter_ms_t current_time_ms;
+	tickcounter_ms_t last_message_sender_state_change_time;
+	tickcounter_ms_t last_message_receiver_state_change_time;
+	// MESSENGER_SEND_EVENT_TASK records kept for reuse (MESSENGER_OPTION_MESSAGE_POOL_SIZE)
+	SLAB event_task_slab;
 } TELEMETRY_MESSENGER_INSTANCE;
 
 typedef struct MESSENGER_SEND_EVENT_TASK_TAG
@@ -74,51 +79,20 @@ typedef struct MESSENGER_SEND_EVENT_TASK_TAG
 	IOTHUB_MESSAGE_LIST* message;
 	ON_TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE on_event_send_complete_callback;
 	void* context;
-	time_t send_time;
+	tickcounter_ms_t send_time;
 	TELEMETRY_MESSENGER_INSTANCE *messenger;
 	bool is_timed_out;
 } MESSENGER_SEND_EVENT_TASK;
 
 // @brief
-//     Evaluates if the ammount of time since start_time is greater or lesser than timeout_in_secs.
-// @param is_timed_out
-//     Set to 1 if a timeout has been reached, 0 otherwise. Not set if any failure occurs.
+//     Evaluates if the ammount of time elapsed between start_time and current_time is equal or greater than timeout_in_ms.
+// @remarks
+//     The elapsed time is computed with unsigned arithmetic, so it stays correct if the tick counter wraps around between the two readings.
 // @returns
-//     0 if no failures occur, non-zero otherwise.
-static int is_timeout_reached(time_t start_time, size_t timeout_in_secs, int *is_timed_out)
+//     true if the timeout has been reached, false otherwise.
+static bool is_timeout_reached(tickcounter_ms_t current_time, tickcounter_ms_t start_time, tickcounter_ms_t timeout_in_ms)
 {
-	int result;
-
-	if (start_time == INDEFINITE_TIME)
-	{
-		LogError("Failed to verify timeout (start_time is INDEFINITE)");
-		result = __FAILURE__;
-	}
-	else
-	{
-		time_t current_time;
-
-		if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
-		{
-			LogError("Failed to verify timeout (get_time failed)");
-			result = __FAILURE__;
-		}
-		else
-		{
-			if (get_difftime(current_time, start_time) >= timeout_in_secs)
-			{
-				*is_timed_out = 1;
-			}
-			else
-			{
-				*is_timed_out = 0;
-			}
-
-			result = RESULT_OK;
-		}
-	}
-
-	return result;
+	return ((tickcounter_ms_t)(current_time - start_time) >= timeout_in_ms);
 }
 
 static STRING_HANDLE create_devices_path(STRING_HANDLE iothub_host_fqdn, STRING_HANDLE device_id)
@@ -333,7 +307,7 @@ static void destroy_event_sender(TELEMETRY_MESSENGER_INSTANCE* instance)
 		instance->message_sender = NULL;
 		instance->message_sender_current_state = MESSAGE_SENDER_STATE_IDLE;
 		instance->message_sender_previous_state = MESSAGE_SENDER_STATE_IDLE;
-		instance->last_message_sender_state_change_time = INDEFINITE_TIME;
+		instance->last_message_sender_state_change_time = 0;
 	}
 
 	if (instance->sender_link != NULL)
@@ -357,7 +331,7 @@ static void on_event_sender_state_changed_callback(void* context, MESSAGE_SENDER
 			TELEMETRY_MESSENGER_INSTANCE* instance = (TELEMETRY_MESSENGER_INSTANCE*)context;
 			instance->message_sender_current_state = new_state;
 			instance->message_sender_previous_state = previous_state;
-			instance->last_message_sender_state_change_time = get_time(NULL);
+			instance->last_message_sender_state_change_time = instance->current_time_ms;
 		}
 	}
 }
@@ -499,7 +473,7 @@ static void destroy_message_receiver(TELEMETRY_MESSENGER_INSTANCE* instance)
 		instance->message_receiver = NULL;
 		instance->message_receiver_current_state = MESSAGE_RECEIVER_STATE_IDLE;
 		instance->message_receiver_previous_state = MESSAGE_RECEIVER_STATE_IDLE;
-		instance->last_message_receiver_state_change_time = INDEFINITE_TIME;
+		instance->last_message_receiver_state_change_time = 0;
 	}
 
 	if (instance->receiver_link != NULL)
@@ -525,7 +499,7 @@ static void on_message_receiver_state_changed_callback(const void* context, MESS
 			TELEMETRY_MESSENGER_INSTANCE* instance = (TELEMETRY_MESSENGER_INSTANCE*)context;
 			instance->message_receiver_current_state = new_state;
 			instance->message_receiver_previous_state = previous_state;
-			instance->last_message_receiver_state_change_time = get_time(NULL);
+			instance->last_message_receiver_state_change_time = instance->current_time_ms;
 		}
 	}
 }
@@ -944,7 +918,8 @@ static void internal_on_event_send_complete_callback(void* context, MESSAGE_SEND
 			remove_event_from_in_progress_list(task);
 
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be destroyed using free()]  
-			free(task);
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_200: [Every `task` destroyed by the messenger shall be released using slab_free(), which shall keep it for reuse if `instance->event_task_slab` has room for it]
+			slab_free(&task->messenger->event_task_slab, task);
 		}
 	}
 }
@@ -991,8 +966,8 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
 			int uamqp_result;
 			MESSAGE_HANDLE amqp_message = NULL;
 
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_154: [A MESSAGE_HANDLE shall be obtained out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message()]  
-			if ((uamqp_result = message_create_from_iothub_message(task->message->messageHandle, &amqp_message)) != RESULT_OK)
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_154: [A MESSAGE_HANDLE shall be obtained out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message_with_template(), passing `instance->message_template`]  
+			if ((uamqp_result = message_create_from_iothub_message_with_template(instance->message_template, task->message->messageHandle, &amqp_message)) != RESULT_OK)
 			{
 				LogError("Failed sending event message (failed creating AMQP message; error: %d).", uamqp_result);
 
@@ -1001,7 +976,7 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
 
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_160: [If any failure occurs the event shall be removed from `instance->in_progress_list` and destroyed]  
 				remove_event_from_in_progress_list(task);
-				free(task);
+				slab_free(&instance->event_task_slab, task);
 				
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_156: [If message_create_from_iothub_message() fails, telemetry_messenger_do_work() shall skip to the next event to be sent]  
 			}
@@ -1009,7 +984,7 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
 			{
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_157: [The MESSAGE_HANDLE shall be submitted for sending using messagesender_send(), passing `internal_on_event_send_complete_callback`]  
 				uamqp_result = messagesender_send(instance->message_sender, amqp_message, internal_on_event_send_complete_callback, task);
-				task->send_time = get_time(NULL);
+				task->send_time = instance->current_time_ms;
 
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_159: [The MESSAGE_HANDLE shall be destroyed using message_destroy().]
 				message_destroy(amqp_message);
@@ -1025,7 +1000,7 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
 
 					// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_160: [If any failure occurs the event shall be removed from `instance->in_progress_list` and destroyed]  
 					remove_event_from_in_progress_list(task);
-					free(task);
+					slab_free(&instance->event_task_slab, task);
 
 					break;
 				}
@@ -1040,48 +1015,33 @@ static int send_pending_events(TELEMETRY_MESSENGER_INSTANCE* instance)
 //     Goes through each task in in_progress_list and checks if the events timed out to be sent.
 // @remarks
 //     If an event is timed out, it is marked as such but not removed, and the upper layer callback is invoked.
-// @returns
-//     0 if no failures occur, non-zero otherwise.
-static int process_event_send_timeouts(TELEMETRY_MESSENGER_INSTANCE* instance)
+static void process_event_send_timeouts(TELEMETRY_MESSENGER_INSTANCE* instance)
 {
-	int result = RESULT_OK;
-
 	if (instance->event_send_timeout_secs > 0)
 	{
+		tickcounter_ms_t event_send_timeout_ms = (tickcounter_ms_t)instance->event_send_timeout_secs * 1000;
 		LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(instance->in_progress_list);
 
 		while (list_item != NULL)
 		{
 			MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_item);
 
-			if (task->is_timed_out == false)
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_197: [An event in `instance->in_progress_list` shall time out once the milliseconds elapsed since it was sent reach `instance->event_send_timeout_secs` times 1000, even if the tick counter wrapped around in between]
+			if (task->is_timed_out == false &&
+				is_timeout_reached(instance->current_time_ms, task->send_time, event_send_timeout_ms))
 			{
-				int is_timed_out;
+				task->is_timed_out = true;
 
-				if (is_timeout_reached(task->send_time, instance->event_send_timeout_secs, &is_timed_out) == RESULT_OK)
-				{
-					if (is_timed_out)
-					{
-						task->is_timed_out = true;
-
-						if (task->on_event_send_complete_callback != NULL)
-						{
-							task->on_event_send_complete_callback(task->message, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, task->context);
-						}
-					}
-				}
-				else
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_198: [When an event times out, `task->on_event_send_complete_callback` shall be invoked with result TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT]
+				if (task->on_event_send_complete_callback != NULL)
 				{
-					LogError("messenger failed to evaluate event send timeout of event %d", task->message);
-					result = __FAILURE__;
+					task->on_event_send_complete_callback(task->message, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, task->context);
 				}
 			}
 
 			list_item = singlylinkedlist_get_next_item(list_item);
 		}
 	}
-
-	return result;
 }
 
 // @brief
@@ -1098,7 +1058,7 @@ static void remove_timed_out_events(TELEMETRY_MESSENGER_INSTANCE* instance)
 		{
 			remove_event_from_in_progress_list(task);
 
-			free(task);
+			slab_free(&instance->event_task_slab, task);
 		}
 
 		list_item = singlylinkedlist_get_next_item(list_item);
@@ -1330,7 +1290,8 @@ int telemetry_messenger_send_async(TELEMETRY_MESSENGER_HANDLE messenger_handle,
 		TELEMETRY_MESSENGER_INSTANCE *instance = (TELEMETRY_MESSENGER_INSTANCE*)messenger_handle;
 
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_137: [telemetry_messenger_send_async() shall allocate memory for a MESSENGER_SEND_EVENT_TASK structure (aka `task`)]  
-		if ((task = (MESSENGER_SEND_EVENT_TASK*)malloc(sizeof(MESSENGER_SEND_EVENT_TASK))) == NULL)
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_200: [`task` shall be obtained from `instance->event_task_slab` using slab_alloc()]
+		if ((task = (MESSENGER_SEND_EVENT_TASK*)slab_alloc(&instance->event_task_slab)) == NULL)
 		{
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_138: [If malloc() fails, telemetry_messenger_send_async() shall fail and return a non-zero value]
 			LogError("Failed sending event (failed to create struct for task; malloc failed)");
@@ -1345,7 +1306,7 @@ int telemetry_messenger_send_async(TELEMETRY_MESSENGER_HANDLE messenger_handle,
 			result = __FAILURE__;
 
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_142: [If any failure occurs, telemetry_messenger_send_async() shall free any memory it has allocated]
-			free(task);
+			slab_free(&instance->event_task_slab, task);
 		}
 		else
 		{
@@ -1353,7 +1314,6 @@ int telemetry_messenger_send_async(TELEMETRY_MESSENGER_HANDLE messenger_handle,
 			task->message = message;
 			task->on_event_send_complete_callback = on_messenger_event_send_complete_callback;
 			task->context = context;
-			task->send_time = INDEFINITE_TIME;
 			task->messenger = instance;
 			task->is_timed_out = false;
 			
@@ -1516,13 +1476,7 @@ static void process_state_changes(TELEMETRY_MESSENGER_INSTANCE* instance)
 		{
 			if (instance->message_receiver_current_state == MESSAGE_RECEIVER_STATE_OPENING)
 			{
-				int is_timed_out;
-				if (is_timeout_reached(instance->last_message_receiver_state_change_time, MAX_MESSAGE_RECEIVER_STATE_CHANGE_TIMEOUT_SECS, &is_timed_out) != RESULT_OK)
-				{
-					LogError("messenger got an error (failed to verify messagereceiver start timeout)");
-					update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
-				}
-				else if (is_timed_out == 1)
+				if (is_timeout_reached(instance->current_time_ms, instance->last_message_receiver_state_change_time, MAX_MESSAGE_RECEIVER_STATE_CHANGE_TIMEOUT_SECS * 1000))
 				{
 					LogError("messenger got an error (messagereceiver failed to start within expected timeout (%d secs))", MAX_MESSAGE_RECEIVER_STATE_CHANGE_TIMEOUT_SECS);
 					update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
@@ -1546,13 +1500,7 @@ static void process_state_changes(TELEMETRY_MESSENGER_INSTANCE* instance)
 			}
 			else if (instance->message_sender_current_state == MESSAGE_SENDER_STATE_OPENING)
 			{
-				int is_timed_out;
-				if (is_timeout_reached(instance->last_message_sender_state_change_time, MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS, &is_timed_out) != RESULT_OK)
-				{
-					LogError("messenger failed to start (failed to verify messagesender start timeout)");
-					update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
-				}
-				else if (is_timed_out == 1)
+				if (is_timeout_reached(instance->current_time_ms, instance->last_message_sender_state_change_time, MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS * 1000))
 				{
 					LogError("messenger failed to start (messagesender failed to start within expected timeout (%d secs))", MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS);
 					update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
@@ -1583,53 +1531,62 @@ void telemetry_messenger_do_work(TELEMETRY_MESSENGER_HANDLE messenger_handle)
 	{
 		TELEMETRY_MESSENGER_INSTANCE* instance = (TELEMETRY_MESSENGER_INSTANCE*)messenger_handle;
 
-		process_state_changes(instance);
-
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_151: [If `instance->state` is TELEMETRY_MESSENGER_STATE_STARTING, telemetry_messenger_do_work() shall create and open `instance->message_sender`]
-		if (instance->state == TELEMETRY_MESSENGER_STATE_STARTING)
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_195: [If `instance->state` is TELEMETRY_MESSENGER_STATE_STARTING or TELEMETRY_MESSENGER_STATE_STARTED, telemetry_messenger_do_work() shall read the current time once from `instance->tick_counter` using tickcounter_get_current_ms()]
+		if ((instance->state == TELEMETRY_MESSENGER_STATE_STARTING || instance->state == TELEMETRY_MESSENGER_STATE_STARTED) &&
+			tickcounter_get_current_ms(instance->tick_counter, &instance->current_time_ms) != 0)
 		{
-			if (instance->message_sender == NULL)
-			{
-				if (create_event_sender(instance) != RESULT_OK)
-				{
-					update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
-				}
-			}
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_196: [If tickcounter_get_current_ms() fails, `instance->state` shall be set to TELEMETRY_MESSENGER_STATE_ERROR and telemetry_messenger_do_work() shall return]
+			LogError("telemetry_messenger_do_work failed (tickcounter_get_current_ms failed)");
+			update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
 		}
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_066: [If `instance->state` is not TELEMETRY_MESSENGER_STATE_STARTED, telemetry_messenger_do_work() shall return]
-		else if (instance->state == TELEMETRY_MESSENGER_STATE_STARTED)
+		else
 		{
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_067: [If `instance->receive_messages` is true and `instance->message_receiver` is NULL, a message_receiver shall be created]
-			if (instance->receive_messages == true &&
-				instance->message_receiver == NULL &&
-				create_message_receiver(instance) != RESULT_OK)
-			{
-				LogError("telemetry_messenger_do_work warning (failed creating the message receiver [%s])", STRING_c_str(instance->device_id));
-			}
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_092: [If `instance->receive_messages` is false and `instance->message_receiver` is not NULL, it shall be destroyed]
-			else if (instance->receive_messages == false && instance->message_receiver != NULL)
-			{
-				destroy_message_receiver(instance);
-			}
+			process_state_changes(instance);
 
-			if (process_event_send_timeouts(instance) != RESULT_OK)
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_151: [If `instance->state` is TELEMETRY_MESSENGER_STATE_STARTING, telemetry_messenger_do_work() shall create and open `instance->message_sender`]
+			if (instance->state == TELEMETRY_MESSENGER_STATE_STARTING)
 			{
-				update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
+				if (instance->message_sender == NULL)
+				{
+					if (create_event_sender(instance) != RESULT_OK)
+					{
+						update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
+					}
+				}
 			}
-			else if (send_pending_events(instance) != RESULT_OK && instance->event_send_retry_limit > 0)
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_066: [If `instance->state` is not TELEMETRY_MESSENGER_STATE_STARTED, telemetry_messenger_do_work() shall return]
+			else if (instance->state == TELEMETRY_MESSENGER_STATE_STARTED)
 			{
-				instance->event_send_error_count++;
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_067: [If `instance->receive_messages` is true and `instance->message_receiver` is NULL, a message_receiver shall be created]
+				if (instance->receive_messages == true &&
+					instance->message_receiver == NULL &&
+					create_message_receiver(instance) != RESULT_OK)
+				{
+					LogError("telemetry_messenger_do_work warning (failed creating the message receiver [%s])", STRING_c_str(instance->device_id));
+				}
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_092: [If `instance->receive_messages` is false and `instance->message_receiver` is not NULL, it shall be destroyed]
+				else if (instance->receive_messages == false && instance->message_receiver != NULL)
+				{
+					destroy_message_receiver(instance);
+				}
+
+				process_event_send_timeouts(instance);
 
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_161: [If telemetry_messenger_do_work() fail sending events for `instance->event_send_retry_limit` times in a row, it shall invoke `instance->on_state_changed_callback`, if provided, with error code TELEMETRY_MESSENGER_STATE_ERROR]
-				if (instance->event_send_error_count >= instance->event_send_retry_limit)
+				if (send_pending_events(instance) != RESULT_OK && instance->event_send_retry_limit > 0)
 				{
-					LogError("telemetry_messenger_do_work failed (failed sending events; reached max number of consecutive attempts)");
-					update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
+					instance->event_send_error_count++;
+
+					// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_161: [If telemetry_messenger_do_work() fail sending events for `instance->event_send_retry_limit` times in a row, it shall invoke `instance->on_state_changed_callback`, if provided, with error code TELEMETRY_MESSENGER_STATE_ERROR]
+					if (instance->event_send_error_count >= instance->event_send_retry_limit)
+					{
+						LogError("telemetry_messenger_do_work failed (failed sending events; reached max number of consecutive attempts)");
+						update_messenger_state(instance, TELEMETRY_MESSENGER_STATE_ERROR);
+					}
+				}
+				else
+				{
+					instance->event_send_error_count = 0;
 				}
-			}
-			else
-			{
-				instance->event_send_error_count = 0;
 			}
 		}
 	}
@@ -1666,7 +1623,7 @@ void telemetry_messenger_destroy(TELEMETRY_MESSENGER_HANDLE messenger_handle)
 			if (task != NULL)
 			{
 				task->on_event_send_complete_callback(task->message, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED, (void*)task->context);
-				free(task);
+				slab_free(&instance->event_task_slab, task);
 			}
 		}
 
@@ -1679,7 +1636,7 @@ void telemetry_messenger_destroy(TELEMETRY_MESSENGER_HANDLE messenger_handle)
 			if (task != NULL)
 			{
 				task->on_event_send_complete_callback(task->message, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED, (void*)task->context);
-				free(task);
+				slab_free(&instance->event_task_slab, task);
 			}
 		}
 
@@ -1687,6 +1644,9 @@ void telemetry_messenger_destroy(TELEMETRY_MESSENGER_HANDLE messenger_handle)
 		singlylinkedlist_destroy(instance->waiting_to_send);
 		singlylinkedlist_destroy(instance->in_progress_list);
 
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_192: [`instance->message_template` shall be destroyed using uamqp_message_template_destroy()]
+		uamqp_message_template_destroy(instance->message_template);
+
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_112: [`instance->iothub_host_fqdn` shall be destroyed using STRING_delete()]
 		STRING_delete(instance->iothub_host_fqdn);
 		
@@ -1695,6 +1655,9 @@ void telemetry_messenger_destroy(TELEMETRY_MESSENGER_HANDLE messenger_handle)
 
         STRING_delete(instance->product_info);
 
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_202: [telemetry_messenger_destroy() shall free the tasks kept for reuse using slab_deinit()]
+		slab_deinit(&instance->event_task_slab);
+
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_114: [telemetry_messenger_destroy() shall destroy `instance` with free()]
 		(void)free(instance);
 	}
@@ -1722,6 +1685,12 @@ TELEMETRY_MESSENGER_HANDLE telemetry_messenger_create(const TELEMETRY_MESSENGER_
 		handle = NULL;
 		LogError("telemetry_messenger_create failed (messenger_config->iothub_host_fqdn is NULL)");
 	}
+	// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_193: [If `messenger_config->tick_counter` is NULL, telemetry_messenger_create() shall return NULL]
+	else if (messenger_config->tick_counter == NULL)
+	{
+		handle = NULL;
+		LogError("telemetry_messenger_create failed (messenger_config->tick_counter is NULL)");
+	}
 	else
 	{
 		TELEMETRY_MESSENGER_INSTANCE* instance;
@@ -1743,8 +1712,11 @@ TELEMETRY_MESSENGER_HANDLE telemetry_messenger_create(const TELEMETRY_MESSENGER_
 			instance->message_receiver_previous_state = MESSAGE_RECEIVER_STATE_IDLE;
 			instance->event_send_retry_limit = DEFAULT_EVENT_SEND_RETRY_LIMIT;
 			instance->event_send_timeout_secs = DEFAULT_EVENT_SEND_TIMEOUT_SECS;
-			instance->last_message_sender_state_change_time = INDEFINITE_TIME;
-			instance->last_message_receiver_state_change_time = INDEFINITE_TIME;
+			instance->last_message_sender_state_change_time = 0;
+			instance->last_message_receiver_state_change_time = 0;
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_199: [telemetry_messenger_create() shall initialize `instance->event_task_slab` using slab_init() with no task kept for reuse]
+			slab_init(&instance->event_task_slab, sizeof(MESSENGER_SEND_EVENT_TASK), 0);
 
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_008: [telemetry_messenger_create() shall save a copy of `messenger_config->device_id` into `instance->device_id`]
 			if ((instance->device_id = STRING_construct(messenger_config->device_id)) == NULL)
@@ -1779,6 +1751,13 @@ TELEMETRY_MESSENGER_HANDLE telemetry_messenger_create(const TELEMETRY_MESSENGER_
 				handle = NULL;
 				LogError("telemetry_messenger_create failed (singlylinkedlist_create failed to create in_progress_list)");
 			}
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_190: [`instance->message_template` shall be set using uamqp_message_template_create()]
+			else if ((instance->message_template = uamqp_message_template_create()) == NULL)
+			{
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_191: [If uamqp_message_template_create() fails, telemetry_messenger_create() shall fail and return NULL]
+				handle = NULL;
+				LogError("telemetry_messenger_create failed (uamqp_message_template_create failed)");
+			}
 			else
 			{
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_013: [`messenger_config->on_state_changed_callback` shall be saved into `instance->on_state_changed_callback`]
@@ -1822,6 +1801,12 @@ int telemetry_messenger_set_option(TELEMETRY_MESSENGER_HANDLE messenger_handle,
 			instance->event_send_timeout_secs = *((size_t*)value);
 			result = RESULT_OK;
 		}
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_201: [If name matches MESSENGER_OPTION_MESSAGE_POOL_SIZE, `value` shall be set as the number of tasks kept for reuse using slab_set_max_free_elements()]
+		else if (strcmp(MESSENGER_OPTION_MESSAGE_POOL_SIZE, name) == 0)
+		{
+			slab_set_max_free_elements(&instance->event_task_slab, *((size_t*)value));
+			result = RESULT_OK;
+		}
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_169: [If name matches MESSENGER_OPTION_SAVED_OPTIONS, `value` shall be applied using OptionHandler_FeedOptions]
 		else if (strcmp(MESSENGER_OPTION_SAVED_OPTIONS, name) == 0)
 		{
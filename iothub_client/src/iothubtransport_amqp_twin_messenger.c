@@ -7,12 +7,13 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/agenttime.h" 
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/uniqueid.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_uamqp_c/messaging.h"
 #include "iothub_client_private.h"
+#include "iothub_client_hash.h"
 #include "iothubtransport_amqp_messenger.h"
 #include "iothubtransport_amqp_twin_messenger.h"
 
@@ -24,7 +25,6 @@ DEFINE_ENUM_STRINGS(TWIN_UPDATE_TYPE, TWIN_UPDATE_TYPE_VALUES);
 
 
 #define RESULT_OK 0
-#define INDEFINITE_TIME ((time_t)(-1))
 
 #define CLIENT_VERSION_PROPERTY_NAME					"com.microsoft:client-version"
 #define UNIQUE_ID_BUFFER_SIZE                           37
@@ -43,10 +43,15 @@ DEFINE_ENUM_STRINGS(TWIN_UPDATE_TYPE, TWIN_UPDATE_TYPE_VALUES);
 #define TWIN_CORRELATION_ID_PROPERTY_NAME				"com.microsoft:channel-correlation-id"
 #define TWIN_API_VERSION_PROPERTY_NAME					"com.microsoft:api-version"
 #define TWIN_CORRELATION_ID_PROPERTY_FORMAT				"twin:%s"
+#define TWIN_CORRELATION_ID_PREFIX_LENGTH				8
+#define TWIN_CORRELATION_ID_FORMAT						"%s:%lx"
+#define TWIN_CORRELATION_ID_BUFFER_SIZE					(TWIN_CORRELATION_ID_PREFIX_LENGTH + 1 + sizeof(unsigned long) * 2 + 1)
+#define TWIN_LINK_CORRELATION_ID_BUFFER_SIZE			(sizeof(TWIN_CORRELATION_ID_PROPERTY_FORMAT) + TWIN_CORRELATION_ID_BUFFER_SIZE)
 #define TWIN_API_VERSION_NUMBER							"2016-11-14"
 
 #define DEFAULT_MAX_TWIN_SUBSCRIPTION_ERROR_COUNT		3
-#define DEFAULT_TWIN_OPERATION_TIMEOUT_SECS				300.0
+#define DEFAULT_TWIN_OPERATION_TIMEOUT_MS				300000
+#define DEFAULT_TWIN_OPERATIONS_INDEX_SIZE				16
 
 static char* DEFAULT_DEVICES_PATH_FORMAT =				"%s/devices/%s";
 static char* DEFAULT_TWIN_SEND_LINK_SOURCE_NAME =		"twin";
@@ -83,11 +88,19 @@ typedef struct TWIN_MESSENGER_INSTANCE_TAG
 	char* client_version;
 	char* device_id;
 	char* iothub_host_fqdn;
+	TICK_COUNTER_HANDLE tick_counter;
+	tickcounter_ms_t current_time_ms;
 
 	TWIN_MESSENGER_STATE state;
 
 	SINGLYLINKEDLIST_HANDLE pending_patches;
 	SINGLYLINKEDLIST_HANDLE operations;
+	struct TWIN_OPERATION_CONTEXT_TAG** operations_index;
+	size_t operations_index_size;
+	size_t operations_index_count;
+
+	char correlation_id_prefix[TWIN_CORRELATION_ID_PREFIX_LENGTH + 1];
+	unsigned long next_correlation_id;
 	
 	TWIN_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
 	void* on_state_changed_context;
@@ -107,17 +120,20 @@ typedef struct TWIN_PATCH_OPERATION_CONTEXT_TAG
 	CONSTBUFFER_HANDLE data;
 	TWIN_MESSENGER_REPORT_STATE_COMPLETE_CALLBACK on_report_state_complete_callback;
 	const void* on_report_state_complete_context;
-	time_t time_enqueued;
+	tickcounter_ms_t time_enqueued;
 } TWIN_PATCH_OPERATION_CONTEXT;
 
 typedef struct TWIN_OPERATION_CONTEXT_TAG
 {
 	TWIN_OPERATION_TYPE type;
 	TWIN_MESSENGER_INSTANCE* msgr;
-	char* correlation_id;
+	char correlation_id[TWIN_CORRELATION_ID_BUFFER_SIZE];
+	size_t correlation_id_hash;
+	LIST_ITEM_HANDLE list_item;
+	struct TWIN_OPERATION_CONTEXT_TAG* next_in_index;
 	TWIN_MESSENGER_REPORT_STATE_COMPLETE_CALLBACK on_report_state_complete_callback;
 	const void* on_report_state_complete_context;
-	time_t time_sent;
+	tickcounter_ms_t time_sent;
 } TWIN_OPERATION_CONTEXT;
 
 
@@ -315,52 +331,135 @@ static int add_amqp_message_annotation(MESSAGE_HANDLE message, AMQP_VALUE msg_an
 
 //---------- TWIN Helpers ----------//
 
-static char* generate_unique_id()
+static int set_correlation_id_prefix(TWIN_MESSENGER_INSTANCE* twin_msgr)
 {
-	char* result;
+	int result;
+	char unique_id[UNIQUE_ID_BUFFER_SIZE + 1];
+
+	memset(unique_id, 0, sizeof(unique_id));
 
-	if ((result = (char*)malloc(sizeof(char) * UNIQUE_ID_BUFFER_SIZE + 1)) == NULL)
+	if (UniqueId_Generate(unique_id, UNIQUE_ID_BUFFER_SIZE) != UNIQUEID_OK)
 	{
-		LogError("Failed generating an unique tag (malloc failed)");
+		LogError("Failed generating an unique tag (UniqueId_Generate failed)");
+		result = __FAILURE__;
 	}
 	else
 	{
-		memset(result, 0, sizeof(char) * UNIQUE_ID_BUFFER_SIZE + 1);
+		(void)memcpy(twin_msgr->correlation_id_prefix, unique_id, TWIN_CORRELATION_ID_PREFIX_LENGTH);
+		twin_msgr->correlation_id_prefix[TWIN_CORRELATION_ID_PREFIX_LENGTH] = '\0';
+		result = RESULT_OK;
+	}
 
-		if (UniqueId_Generate(result, UNIQUE_ID_BUFFER_SIZE) != UNIQUEID_OK)
-		{
-			LogError("Failed generating an unique tag (UniqueId_Generate failed)");
-			free(result);
-			result = NULL;
-		}
+	return result;
+}
+
+// The correlation-id only needs to be unique within the TWIN links of this messenger,
+// so a random prefix and a counter are enough (and much cheaper than a new UUID per request).
+static void generate_twin_correlation_id(TWIN_MESSENGER_INSTANCE* twin_msgr, char* correlation_id)
+{
+	(void)sprintf(correlation_id, TWIN_CORRELATION_ID_FORMAT, twin_msgr->correlation_id_prefix, twin_msgr->next_correlation_id++);
+}
+
+static int create_operations_index(TWIN_MESSENGER_INSTANCE* twin_msgr)
+{
+	int result;
+
+	if ((twin_msgr->operations_index = (TWIN_OPERATION_CONTEXT**)malloc(sizeof(TWIN_OPERATION_CONTEXT*) * DEFAULT_TWIN_OPERATIONS_INDEX_SIZE)) == NULL)
+	{
+		LogError("Failed allocating index of TWIN operations (%s)", twin_msgr->device_id);
+		result = __FAILURE__;
+	}
+	else
+	{
+		memset(twin_msgr->operations_index, 0, sizeof(TWIN_OPERATION_CONTEXT*) * DEFAULT_TWIN_OPERATIONS_INDEX_SIZE);
+		twin_msgr->operations_index_size = DEFAULT_TWIN_OPERATIONS_INDEX_SIZE;
+		twin_msgr->operations_index_count = 0;
+		result = RESULT_OK;
 	}
 
 	return result;
 }
 
-static char* generate_twin_correlation_id()
+static void grow_operations_index(TWIN_MESSENGER_INSTANCE* twin_msgr)
 {
-	char* result;
-	char* unique_id;
+	size_t new_size = twin_msgr->operations_index_size * 2;
+	TWIN_OPERATION_CONTEXT** new_index;
 
-	if ((unique_id = generate_unique_id()) == NULL)
+	if ((new_index = (TWIN_OPERATION_CONTEXT**)malloc(sizeof(TWIN_OPERATION_CONTEXT*) * new_size)) == NULL)
 	{
-		LogError("Failed generating unique ID for correlation-id");
-		result = NULL;
+		// Not fatal, the current index is still valid (just with longer chains).
+		LogError("Failed growing index of TWIN operations (%s, %lu)", twin_msgr->device_id, (unsigned long)new_size);
 	}
 	else
 	{
-		if ((result = (char*)malloc(strlen(TWIN_CORRELATION_ID_PROPERTY_FORMAT) + strlen(unique_id) + 1)) == NULL)
+		size_t i;
+
+		memset(new_index, 0, sizeof(TWIN_OPERATION_CONTEXT*) * new_size);
+
+		for (i = 0; i < twin_msgr->operations_index_size; i++)
 		{
-			LogError("Failed allocating correlation-id");
-			result = NULL;
+			TWIN_OPERATION_CONTEXT* twin_op_ctx = twin_msgr->operations_index[i];
+
+			while (twin_op_ctx != NULL)
+			{
+				TWIN_OPERATION_CONTEXT* next = twin_op_ctx->next_in_index;
+				size_t bucket = twin_op_ctx->correlation_id_hash & (new_size - 1);
+
+				twin_op_ctx->next_in_index = new_index[bucket];
+				new_index[bucket] = twin_op_ctx;
+				twin_op_ctx = next;
+			}
 		}
-		else
+
+		free(twin_msgr->operations_index);
+		twin_msgr->operations_index = new_index;
+		twin_msgr->operations_index_size = new_size;
+	}
+}
+
+static void add_twin_operation_to_index(TWIN_OPERATION_CONTEXT* twin_op_ctx)
+{
+	TWIN_MESSENGER_INSTANCE* twin_msgr = twin_op_ctx->msgr;
+	size_t bucket;
+
+	if (twin_msgr->operations_index_count >= twin_msgr->operations_index_size)
+	{
+		grow_operations_index(twin_msgr);
+	}
+
+	bucket = twin_op_ctx->correlation_id_hash & (twin_msgr->operations_index_size - 1);
+	twin_op_ctx->next_in_index = twin_msgr->operations_index[bucket];
+	twin_msgr->operations_index[bucket] = twin_op_ctx;
+	twin_msgr->operations_index_count++;
+}
+
+static void remove_twin_operation_from_index(TWIN_OPERATION_CONTEXT* twin_op_ctx)
+{
+	TWIN_MESSENGER_INSTANCE* twin_msgr = twin_op_ctx->msgr;
+	TWIN_OPERATION_CONTEXT** entry = &twin_msgr->operations_index[twin_op_ctx->correlation_id_hash & (twin_msgr->operations_index_size - 1)];
+
+	while (*entry != NULL)
+	{
+		if (*entry == twin_op_ctx)
 		{
-			(void)sprintf(result, TWIN_CORRELATION_ID_PROPERTY_FORMAT, unique_id);
+			*entry = twin_op_ctx->next_in_index;
+			twin_op_ctx->next_in_index = NULL;
+			twin_msgr->operations_index_count--;
+			break;
 		}
 
-		free(unique_id);
+		entry = &(*entry)->next_in_index;
+	}
+}
+
+static TWIN_OPERATION_CONTEXT* find_twin_operation_by_correlation_id(TWIN_MESSENGER_INSTANCE* twin_msgr, const char* correlation_id)
+{
+	size_t hash = hash_fnv1a(correlation_id);
+	TWIN_OPERATION_CONTEXT* result = twin_msgr->operations_index[hash & (twin_msgr->operations_index_size - 1)];
+
+	while (result != NULL && (result->correlation_id_hash != hash || strcmp(result->correlation_id, correlation_id) != 0))
+	{
+		result = result->next_in_index;
 	}
 
 	return result;
@@ -378,28 +477,16 @@ static TWIN_OPERATION_CONTEXT* create_twin_operation_context(TWIN_MESSENGER_INST
 	{
 		memset(result, 0, sizeof(TWIN_OPERATION_CONTEXT));
 
-		if ((result->correlation_id = generate_unique_id()) == NULL)
-		{
-			LogError("Failed setting context correlation-id (%s, %s)", ENUM_TO_STRING(TWIN_OPERATION_TYPE, type), twin_msgr->device_id);
-			free(result);
-			result = NULL;
-		}
-		else
-		{
-			result->type = type;
-			result->msgr = twin_msgr;
-		}
+		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_111: [Each TWIN request shall have a correlation-id made of `twin_msgr`'s prefix and a per-messenger counter, formatted as `<prefix>:<counter in hex>`]
+		generate_twin_correlation_id(twin_msgr, result->correlation_id);
+		result->correlation_id_hash = hash_fnv1a(result->correlation_id);
+		result->type = type;
+		result->msgr = twin_msgr;
 	}
 
 	return result;
 }
 
-static bool find_twin_operation_by_correlation_id(LIST_ITEM_HANDLE list_item, const void* match_context)
-{
-	TWIN_OPERATION_CONTEXT* twin_op_ctx = (TWIN_OPERATION_CONTEXT*)singlylinkedlist_item_get_value(list_item);
-	return (strcmp(twin_op_ctx->correlation_id, (const char*)match_context) == 0);
-}
-
 static bool find_twin_operation_by_type(LIST_ITEM_HANDLE list_item, const void* match_context)
 {
 	TWIN_OPERATION_CONTEXT* twin_op_ctx = (TWIN_OPERATION_CONTEXT*)singlylinkedlist_item_get_value(list_item);
@@ -408,7 +495,6 @@ static bool find_twin_operation_by_type(LIST_ITEM_HANDLE list_item, const void*
 
 static void destroy_twin_operation_context(TWIN_OPERATION_CONTEXT* op_ctx)
 {
-	free(op_ctx->correlation_id);
 	free(op_ctx);
 }
 
@@ -416,13 +502,15 @@ static int add_twin_operation_context_to_queue(TWIN_OPERATION_CONTEXT* twin_op_c
 {
 	int result;
 
-	if (singlylinkedlist_add(twin_op_ctx->msgr->operations, (const void*)twin_op_ctx) == NULL)
+	if ((twin_op_ctx->list_item = singlylinkedlist_add(twin_op_ctx->msgr->operations, (const void*)twin_op_ctx)) == NULL)
 	{
 		LogError("Failed adding TWIN operation context to queue (%s, %s)", ENUM_TO_STRING(TWIN_OPERATION_TYPE, twin_op_ctx->type), twin_op_ctx->correlation_id);
 		result = __FAILURE__;
 	}
 	else
 	{
+		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_112: [Each TWIN request queued into `twin_msgr->operations` shall also be indexed by its correlation-id]
+		add_twin_operation_to_index(twin_op_ctx);
 		result = RESULT_OK;
 	}
 
@@ -432,13 +520,12 @@ static int add_twin_operation_context_to_queue(TWIN_OPERATION_CONTEXT* twin_op_c
 static int remove_twin_operation_context_from_queue(TWIN_OPERATION_CONTEXT* twin_op_ctx)
 {
 	int result;
-	LIST_ITEM_HANDLE list_item;
 
-	if ((list_item = singlylinkedlist_find(twin_op_ctx->msgr->operations, find_twin_operation_by_correlation_id, (const void*)twin_op_ctx->correlation_id)) == NULL)
+	if (twin_op_ctx->list_item == NULL)
 	{
 		result = RESULT_OK;
 	}
-	else if (singlylinkedlist_remove(twin_op_ctx->msgr->operations, list_item) != 0)
+	else if (singlylinkedlist_remove(twin_op_ctx->msgr->operations, twin_op_ctx->list_item) != 0)
 	{
 		LogError("Failed removing TWIN operation context from queue (%s, %s, %s)", 
 			twin_op_ctx->msgr->device_id, ENUM_TO_STRING(TWIN_OPERATION_TYPE, twin_op_ctx->type), twin_op_ctx->correlation_id);
@@ -446,6 +533,8 @@ static int remove_twin_operation_context_from_queue(TWIN_OPERATION_CONTEXT* twin
 	}
 	else
 	{
+		remove_twin_operation_from_index(twin_op_ctx);
+		twin_op_ctx->list_item = NULL;
 		result = RESULT_OK;
 	}
 
@@ -647,36 +736,29 @@ static MAP_HANDLE create_link_attach_properties(TWIN_MESSENGER_INSTANCE* twin_ms
 	}
 	else
 	{
-		char* correlation_id;
+		char correlation_id[TWIN_CORRELATION_ID_BUFFER_SIZE];
+		char link_correlation_id[TWIN_LINK_CORRELATION_ID_BUFFER_SIZE];
+
+		generate_twin_correlation_id(twin_msgr, correlation_id);
+		(void)sprintf(link_correlation_id, TWIN_CORRELATION_ID_PROPERTY_FORMAT, correlation_id);
 
-		if ((correlation_id = generate_twin_correlation_id()) == NULL)
+		if (Map_Add(result, CLIENT_VERSION_PROPERTY_NAME, twin_msgr->client_version) != MAP_OK)
 		{
-			LogError("Failed adding AMQP link property ");
+			LogError("Failed adding AMQP link property 'client version' (%s)", twin_msgr->device_id);
 			destroy_link_attach_properties(result);
 			result = NULL;
 		}
-		else
+		else if (Map_Add(result, TWIN_CORRELATION_ID_PROPERTY_NAME, link_correlation_id) != MAP_OK)
 		{
-			if (Map_Add(result, CLIENT_VERSION_PROPERTY_NAME, twin_msgr->client_version) != MAP_OK)
-			{
-				LogError("Failed adding AMQP link property 'client version' (%s)", twin_msgr->device_id);
-				destroy_link_attach_properties(result);
-				result = NULL;
-			}
-			else if (Map_Add(result, TWIN_CORRELATION_ID_PROPERTY_NAME, correlation_id) != MAP_OK)
-			{
-				LogError("Failed adding AMQP link property 'correlation-id' (%s)", twin_msgr->device_id);
-				destroy_link_attach_properties(result);
-				result = NULL;
-			}
-			else if (Map_Add(result, TWIN_API_VERSION_PROPERTY_NAME, TWIN_API_VERSION_NUMBER) != MAP_OK)
-			{
-				LogError("Failed adding AMQP link property 'api-version' (%s)", twin_msgr->device_id);
-				destroy_link_attach_properties(result);
-				result = NULL;
-			}
-
-			free(correlation_id);
+			LogError("Failed adding AMQP link property 'correlation-id' (%s)", twin_msgr->device_id);
+			destroy_link_attach_properties(result);
+			result = NULL;
+		}
+		else if (Map_Add(result, TWIN_API_VERSION_PROPERTY_NAME, TWIN_API_VERSION_NUMBER) != MAP_OK)
+		{
+			LogError("Failed adding AMQP link property 'api-version' (%s)", twin_msgr->device_id);
+			destroy_link_attach_properties(result);
+			result = NULL;
 		}
 	}
 
@@ -771,7 +853,7 @@ static MESSAGE_HANDLE create_amqp_message_for_twin_operation(TWIN_OPERATION_TYPE
 				message_destroy(result);
 				result = NULL;
 			}
-			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_068: [The `correlation-id` property of `amqp_message` shall be set with an UUID string]  
+			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_068: [The `correlation-id` property of `amqp_message` shall be set with the correlation-id of the TWIN request]  
 			else if (set_message_correlation_id(result, correlation_id) != RESULT_OK)
 			{
 				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_069: [If setting `correlation-id` fails, message_create_for_twin_operation shall fail and return NULL]  
@@ -946,12 +1028,9 @@ static int send_twin_operation_request(TWIN_MESSENGER_INSTANCE* twin_msgr, TWIN_
 	}
 	else
 	{
-		if ((op_ctx->time_sent = get_time(NULL)) == INDEFINITE_TIME)
-		{
-			LogError("Failed setting TWIN operation sent time (%s, %s, %s)", twin_msgr->device_id, ENUM_TO_STRING(TWIN_OPERATION_TYPE, op_ctx->type), op_ctx->correlation_id);
-			result = __FAILURE__;
-		}
-		else if (amqp_messenger_send_async(twin_msgr->amqp_msgr, amqp_message, on_amqp_send_complete_callback, (void*)op_ctx) != 0)
+		op_ctx->time_sent = twin_msgr->current_time_ms;
+
+		if (amqp_messenger_send_async(twin_msgr->amqp_msgr, amqp_message, on_amqp_send_complete_callback, (void*)op_ctx) != 0)
 		{
 			LogError("Failed sending request message for (%s, %s, %s)", twin_msgr->device_id, ENUM_TO_STRING(TWIN_OPERATION_TYPE, op_ctx->type), op_ctx->correlation_id);
 			result = __FAILURE__;
@@ -970,6 +1049,12 @@ static int send_twin_operation_request(TWIN_MESSENGER_INSTANCE* twin_msgr, TWIN_
 
 //---------- Internal Helpers----------//
 
+// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_120: [Timeouts shall be verified using the unsigned difference between the current time and the item time stamp, so the verification is not affected by the tick counter wrapping around]
+static bool is_timeout_reached(tickcounter_ms_t current_time, tickcounter_ms_t start_time, tickcounter_ms_t timeout_in_ms)
+{
+	return ((tickcounter_ms_t)(current_time - start_time) >= timeout_in_ms);
+}
+
 static bool remove_expired_twin_patch_request(const void* item, const void* match_context, bool* continue_processing)
 {
 	bool remove_item;
@@ -983,10 +1068,10 @@ static bool remove_expired_twin_patch_request(const void* item, const void* matc
 	else
 	{
 
-		time_t current_time = *(time_t*)match_context;
+		tickcounter_ms_t current_time = *(const tickcounter_ms_t*)match_context;
 		TWIN_PATCH_OPERATION_CONTEXT* twin_patch_ctx = (TWIN_PATCH_OPERATION_CONTEXT*)item;
 
-		if (get_difftime(current_time, twin_patch_ctx->time_enqueued) >= DEFAULT_TWIN_OPERATION_TIMEOUT_SECS)
+		if (is_timeout_reached(current_time, twin_patch_ctx->time_enqueued, DEFAULT_TWIN_OPERATION_TIMEOUT_MS))
 		{
 			remove_item = true;
 			*continue_processing = true;
@@ -1023,9 +1108,9 @@ static bool remove_expired_twin_operation_request(const void* item, const void*
 	{
 		TWIN_OPERATION_CONTEXT* twin_op_ctx = (TWIN_OPERATION_CONTEXT*)item;
 		TWIN_MESSENGER_INSTANCE* twin_msgr = twin_op_ctx->msgr;
-		time_t current_time = *(time_t*)match_context;
+		tickcounter_ms_t current_time = *(const tickcounter_ms_t*)match_context;
 
-		if (get_difftime(current_time, twin_op_ctx->time_sent) < DEFAULT_TWIN_OPERATION_TIMEOUT_SECS)
+		if (!is_timeout_reached(current_time, twin_op_ctx->time_sent, DEFAULT_TWIN_OPERATION_TIMEOUT_MS))
 		{
 			result = false;
 			// All next elements in the list have a later time_sent, so they won't be expired, and don't need to be removed.
@@ -1070,6 +1155,7 @@ static bool remove_expired_twin_operation_request(const void* item, const void*
 				}
 			}
 
+			remove_twin_operation_from_index(twin_op_ctx);
 			destroy_twin_operation_context(twin_op_ctx);
 		}
 	}
@@ -1079,20 +1165,10 @@ static bool remove_expired_twin_operation_request(const void* item, const void*
 
 static void process_timeouts(TWIN_MESSENGER_INSTANCE* twin_msgr)
 {
-	time_t current_time;
-
-	if ((current_time = get_time(NULL)) == INDEFINITE_TIME)
-	{
-		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_082: [If any failure occurs while verifying/removing timed-out items `twin_msgr->state` shall be set to TWIN_MESSENGER_STATE_ERROR and user informed]  
-		LogError("Failed obtaining current time (%s)", twin_msgr->device_id);
-		update_state(twin_msgr, TWIN_MESSENGER_STATE_ERROR);
-	}
-	else
-	{
-		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_080: [twin_messenger_do_work() shall remove and destroy any timed out items from `twin_msgr->pending_patches` and `twin_msgr->operations`]  
-		(void)singlylinkedlist_remove_if(twin_msgr->pending_patches, remove_expired_twin_patch_request, (const void*)&current_time);
-		(void)singlylinkedlist_remove_if(twin_msgr->operations, remove_expired_twin_operation_request, (const void*)&current_time);
-	}
+	// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_080: [twin_messenger_do_work() shall remove and destroy any timed out items from `twin_msgr->pending_patches` and `twin_msgr->operations`]  
+	// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_116: [Since all items share the same timeout and are queued in the order they were sent, verification shall stop at the first item that has not timed out]
+	(void)singlylinkedlist_remove_if(twin_msgr->pending_patches, remove_expired_twin_patch_request, (const void*)&twin_msgr->current_time_ms);
+	(void)singlylinkedlist_remove_if(twin_msgr->operations, remove_expired_twin_operation_request, (const void*)&twin_msgr->current_time_ms);
 }
 
 static bool send_pending_twin_patch(const void* item, const void* match_context, bool* continue_processing)
@@ -1319,6 +1395,11 @@ static void internal_twin_messenger_destroy(TWIN_MESSENGER_INSTANCE* twin_msgr)
 		singlylinkedlist_destroy(twin_msgr->operations);
 	}
 
+	if (twin_msgr->operations_index != NULL)
+	{
+		free(twin_msgr->operations_index);
+	}
+
 	// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_102: [twin_messenger_destroy() shall release all memory allocated for and within `twin_msgr`]  
 	if (twin_msgr->client_version != NULL)
 	{
@@ -1380,156 +1461,147 @@ static AMQP_MESSENGER_DISPOSITION_RESULT on_amqp_message_received_callback(MESSA
 			{
 				// It is supposed to be a request sent previously (reported properties PATCH, GET, PUT or DELETE).
 
-				LIST_ITEM_HANDLE list_item;
-				if ((list_item = singlylinkedlist_find(twin_msgr->operations, find_twin_operation_by_correlation_id, (const void*)correlation_id)) == NULL)
+				TWIN_OPERATION_CONTEXT* twin_op_ctx;
+
+				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_115: [The TWIN request corresponding to `message` shall be looked up by correlation-id in the index of `twin_msgr->operations`]
+				if ((twin_op_ctx = find_twin_operation_by_correlation_id(twin_msgr, correlation_id)) == NULL)
 				{
 					LogError("Could not find context of TWIN incoming message (%s, %s)", twin_msgr->device_id, correlation_id);
 				}
 				else
 				{
-					TWIN_OPERATION_CONTEXT* twin_op_ctx;
+					if (twin_op_ctx->type == TWIN_OPERATION_TYPE_PATCH)
+					{							
+						if (!has_status_code)
+						{
+							// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_086: [If `message` is a failed response for a PATCH request, the `on_report_state_complete_callback` shall be invoked if provided passing RESULT_ERROR and the status_code zero]  
+							LogError("Received an incoming TWIN message for a PATCH operation, but with no status code (%s, %s)", twin_msgr->device_id, correlation_id);
 
-					if ((twin_op_ctx = (TWIN_OPERATION_CONTEXT*)singlylinkedlist_item_get_value(list_item)) == NULL)
-					{
-						LogError("Could not get context for incoming TWIN message (%s, %s)", twin_msgr->device_id, correlation_id);
-					}
-					else
-					{	
-						if (twin_op_ctx->type == TWIN_OPERATION_TYPE_PATCH)
-						{							
-							if (!has_status_code)
+							disposition_result = AMQP_MESSENGER_DISPOSITION_RESULT_REJECTED;
+							
+							if (twin_op_ctx->on_report_state_complete_callback != NULL)
 							{
-								// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_086: [If `message` is a failed response for a PATCH request, the `on_report_state_complete_callback` shall be invoked if provided passing RESULT_ERROR and the status_code zero]  
-								LogError("Received an incoming TWIN message for a PATCH operation, but with no status code (%s, %s)", twin_msgr->device_id, correlation_id);
-
-								disposition_result = AMQP_MESSENGER_DISPOSITION_RESULT_REJECTED;
-								
-								if (twin_op_ctx->on_report_state_complete_callback != NULL)
-								{
-									twin_op_ctx->on_report_state_complete_callback(TWIN_REPORT_STATE_RESULT_ERROR, TWIN_REPORT_STATE_REASON_INVALID_RESPONSE, 0, twin_op_ctx->on_report_state_complete_context);
-								}
+								twin_op_ctx->on_report_state_complete_callback(TWIN_REPORT_STATE_RESULT_ERROR, TWIN_REPORT_STATE_REASON_INVALID_RESPONSE, 0, twin_op_ctx->on_report_state_complete_context);
 							}
-							else
+						}
+						else
+						{
+							// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_085: [If `message` is a success response for a PATCH request, the `on_report_state_complete_callback` shall be invoked if provided passing RESULT_SUCCESS and the status_code received]  
+							if (twin_op_ctx->on_report_state_complete_callback != NULL)
 							{
-								// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_085: [If `message` is a success response for a PATCH request, the `on_report_state_complete_callback` shall be invoked if provided passing RESULT_SUCCESS and the status_code received]  
-								if (twin_op_ctx->on_report_state_complete_callback != NULL)
-								{
-									twin_op_ctx->on_report_state_complete_callback(TWIN_REPORT_STATE_RESULT_SUCCESS, TWIN_REPORT_STATE_REASON_NONE, status_code, twin_op_ctx->on_report_state_complete_context);
-								}
+								twin_op_ctx->on_report_state_complete_callback(TWIN_REPORT_STATE_RESULT_SUCCESS, TWIN_REPORT_STATE_REASON_NONE, status_code, twin_op_ctx->on_report_state_complete_context);
 							}
 						}
-						else if (twin_op_ctx->type == TWIN_OPERATION_TYPE_GET)
+					}
+					else if (twin_op_ctx->type == TWIN_OPERATION_TYPE_GET)
+					{
+						if (!has_twin_report)
 						{
-							if (!has_twin_report)
-							{
-								// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_089: [If `message` is a failed response for a GET request, the TWIN messenger shall attempt to send another GET request]  
-								LogError("Received an incoming TWIN message for a GET operation, but with no report (%s, %s)", twin_msgr->device_id, correlation_id);
+							// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_089: [If `message` is a failed response for a GET request, the TWIN messenger shall attempt to send another GET request]  
+							LogError("Received an incoming TWIN message for a GET operation, but with no report (%s, %s)", twin_msgr->device_id, correlation_id);
 
-								disposition_result = AMQP_MESSENGER_DISPOSITION_RESULT_REJECTED;
+							disposition_result = AMQP_MESSENGER_DISPOSITION_RESULT_REJECTED;
 
-								if (twin_op_ctx->msgr->on_message_received_callback != NULL)
-								{
-									twin_op_ctx->msgr->on_message_received_callback(TWIN_UPDATE_TYPE_COMPLETE, NULL, 0, twin_op_ctx->msgr->on_message_received_context);
-								}
+							if (twin_op_ctx->msgr->on_message_received_callback != NULL)
+							{
+								twin_op_ctx->msgr->on_message_received_callback(TWIN_UPDATE_TYPE_COMPLETE, NULL, 0, twin_op_ctx->msgr->on_message_received_context);
+							}
 
-								if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_GETTING_COMPLETE_PROPERTIES)
-								{
-									twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_GET_COMPLETE_PROPERTIES;
-									twin_msgr->subscription_error_count++;
-								}
+							if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_GETTING_COMPLETE_PROPERTIES)
+							{
+								twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_GET_COMPLETE_PROPERTIES;
+								twin_msgr->subscription_error_count++;
 							}
-							else
+						}
+						else
+						{
+							// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_087: [If `message` is a success response for a GET request, `on_message_received_callback` shall be invoked with TWIN_UPDATE_TYPE_COMPLETE and the message body received]  
+							if (twin_op_ctx->msgr->on_message_received_callback != NULL)
 							{
-								// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_087: [If `message` is a success response for a GET request, `on_message_received_callback` shall be invoked with TWIN_UPDATE_TYPE_COMPLETE and the message body received]  
-								if (twin_op_ctx->msgr->on_message_received_callback != NULL)
-								{
-									twin_op_ctx->msgr->on_message_received_callback(TWIN_UPDATE_TYPE_COMPLETE, (const char*)twin_report.bytes, twin_report.length, twin_op_ctx->msgr->on_message_received_context);
-								}
+								twin_op_ctx->msgr->on_message_received_callback(TWIN_UPDATE_TYPE_COMPLETE, (const char*)twin_report.bytes, twin_report.length, twin_op_ctx->msgr->on_message_received_context);
+							}
 
-								// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_088: [If `message` is a success response for a GET request, the TWIN messenger shall trigger the subscription for partial updates]  
-								if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_GETTING_COMPLETE_PROPERTIES)
-								{
-									twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_SUBSCRIBE_FOR_UPDATES;
-									twin_msgr->subscription_error_count = 0;
-								}
+							// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_088: [If `message` is a success response for a GET request, the TWIN messenger shall trigger the subscription for partial updates]  
+							if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_GETTING_COMPLETE_PROPERTIES)
+							{
+								twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_SUBSCRIBE_FOR_UPDATES;
+								twin_msgr->subscription_error_count = 0;
 							}
 						}
-						else if (twin_op_ctx->type == TWIN_OPERATION_TYPE_PUT)
+					}
+					else if (twin_op_ctx->type == TWIN_OPERATION_TYPE_PUT)
+					{
+						if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_SUBSCRIBED)
 						{
-							if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_SUBSCRIBED)
+							bool subscription_succeeded = true;
+
+							if (!has_status_code)
+							{
+								LogError("Received an incoming TWIN message for a PUT operation, but with no status code (%s, %s)", twin_msgr->device_id, correlation_id);
+								
+								subscription_succeeded = false;
+							}
+							else if (status_code < 200 || status_code >= 300)
 							{
-								bool subscription_succeeded = true;
+								LogError("Received status code %d for TWIN subscription request (%s, %s)", status_code, twin_msgr->device_id, correlation_id);
+								
+								subscription_succeeded = false;
+							}
 
-								if (!has_status_code)
-								{
-									LogError("Received an incoming TWIN message for a PUT operation, but with no status code (%s, %s)", twin_msgr->device_id, correlation_id);
-									
-									subscription_succeeded = false;
-								}
-								else if (status_code < 200 || status_code >= 300)
+							if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_SUBSCRIBING)
+							{
+								if (subscription_succeeded)
 								{
-									LogError("Received status code %d for TWIN subscription request (%s, %s)", status_code, twin_msgr->device_id, correlation_id);
-									
-									subscription_succeeded = false;
+									twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_SUBSCRIBED;
+									twin_msgr->subscription_error_count = 0;
 								}
-
-								if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_SUBSCRIBING)
+								else
 								{
-									if (subscription_succeeded)
-									{
-										twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_SUBSCRIBED;
-										twin_msgr->subscription_error_count = 0;
-									}
-									else
-									{
-										// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_090: [If `message` is a failed response for a PUT request, the TWIN messenger shall attempt to send another PUT request]  
-										twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_SUBSCRIBE_FOR_UPDATES;
-										twin_msgr->subscription_error_count++;
-									}
+									// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_090: [If `message` is a failed response for a PUT request, the TWIN messenger shall attempt to send another PUT request]  
+									twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_SUBSCRIBE_FOR_UPDATES;
+									twin_msgr->subscription_error_count++;
 								}
 							}
 						}
-						else if (twin_op_ctx->type == TWIN_OPERATION_TYPE_DELETE)
+					}
+					else if (twin_op_ctx->type == TWIN_OPERATION_TYPE_DELETE)
+					{
+						if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_NOT_SUBSCRIBED)
 						{
-							if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_NOT_SUBSCRIBED)
+							bool unsubscription_succeeded = true;
+
+							if (!has_status_code)
+							{
+								LogError("Received an incoming TWIN message for a DELETE operation, but with no status code (%s, %s)", twin_msgr->device_id, correlation_id);
+								
+								unsubscription_succeeded = false;
+							}
+							else if (status_code < 200 || status_code >= 300)
 							{
-								bool unsubscription_succeeded = true;
+								LogError("Received status code %d for TWIN unsubscription request (%s, %s)", status_code, twin_msgr->device_id, correlation_id);
+								
+								unsubscription_succeeded = false;
+							}
 
-								if (!has_status_code)
-								{
-									LogError("Received an incoming TWIN message for a DELETE operation, but with no status code (%s, %s)", twin_msgr->device_id, correlation_id);
-									
-									unsubscription_succeeded = false;
-								}
-								else if (status_code < 200 || status_code >= 300)
+							if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_UNSUBSCRIBING)
+							{
+								if (unsubscription_succeeded)
 								{
-									LogError("Received status code %d for TWIN unsubscription request (%s, %s)", status_code, twin_msgr->device_id, correlation_id);
-									
-									unsubscription_succeeded = false;
+									twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_NOT_SUBSCRIBED;
+									twin_msgr->subscription_error_count = 0;
 								}
-
-								if (twin_msgr->subscription_state == TWIN_SUBSCRIPTION_STATE_UNSUBSCRIBING)
+								else
 								{
-									if (unsubscription_succeeded)
-									{
-										twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_NOT_SUBSCRIBED;
-										twin_msgr->subscription_error_count = 0;
-									}
-									else
-									{
-										// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_091: [If `message` is a failed response for a DELETE request, the TWIN messenger shall attempt to send another DELETE request]  
-										twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_UNSUBSCRIBE;
-										twin_msgr->subscription_error_count++;
-									}
+									// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_091: [If `message` is a failed response for a DELETE request, the TWIN messenger shall attempt to send another DELETE request]  
+									twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_UNSUBSCRIBE;
+									twin_msgr->subscription_error_count++;
 								}
 							}
 						}
-
-						destroy_twin_operation_context(twin_op_ctx);
 					}
 
 					// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_092: [The corresponding TWIN request shall be removed from `twin_msgr->operations` and destroyed]  
-					if (singlylinkedlist_remove(twin_msgr->operations, list_item) != 0)
+					if (remove_twin_operation_context_from_queue(twin_op_ctx) != RESULT_OK)
 					{
 						// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_093: [The corresponding TWIN request failed to be removed from `twin_msgr->operations`, `twin_msgr->state` shall be set to TWIN_MESSENGER_STATE_ERROR and informed to the user]  
 						LogError("Failed removing context for incoming TWIN message (%s, %s, %s)",
@@ -1537,6 +1609,10 @@ static AMQP_MESSENGER_DISPOSITION_RESULT on_amqp_message_received_callback(MESSA
 						
 						update_state(twin_msgr, TWIN_MESSENGER_STATE_ERROR);
 					}
+					else
+					{
+						destroy_twin_operation_context(twin_op_ctx);
+					}
 				}
 
 				free(correlation_id);
@@ -1689,6 +1765,12 @@ TWIN_MESSENGER_HANDLE twin_messenger_create(const TWIN_MESSENGER_CONFIG* messeng
 			messenger_config->device_id, messenger_config->iothub_host_fqdn, messenger_config->client_version);
 		twin_msgr = NULL;
 	}
+	// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_117: [If `messenger_config->tick_counter` is NULL, twin_messenger_create() shall return NULL]  
+	else if (messenger_config->tick_counter == NULL)
+	{
+		LogError("Invalid argument (tick_counter is NULL)");
+		twin_msgr = NULL;
+	}
 	else
 	{
 		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_003: [twin_messenger_create() shall allocate memory for the messenger instance structure (aka `twin_msgr`)]  
@@ -1705,6 +1787,8 @@ TWIN_MESSENGER_HANDLE twin_messenger_create(const TWIN_MESSENGER_CONFIG* messeng
 			twin_msgr->state = TWIN_MESSENGER_STATE_STOPPED;
 			twin_msgr->subscription_state = TWIN_SUBSCRIPTION_STATE_NOT_SUBSCRIBED;
 			twin_msgr->amqp_msgr_state = AMQP_MESSENGER_STATE_STOPPED;
+			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_118: [twin_messenger_create() shall save `messenger_config->tick_counter` into `twin_msgr->tick_counter`, without taking ownership of it]  
+			twin_msgr->tick_counter = messenger_config->tick_counter;
 
 			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_005: [twin_messenger_create() shall save a copy of `messenger_config` info into `twin_msgr`]  
 			if (mallocAndStrcpy_s(&twin_msgr->client_version, messenger_config->client_version) != 0)
@@ -1728,6 +1812,14 @@ TWIN_MESSENGER_HANDLE twin_messenger_create(const TWIN_MESSENGER_CONFIG* messeng
 				internal_twin_messenger_destroy(twin_msgr);
 				twin_msgr = NULL;
 			}
+			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_109: [twin_messenger_create() shall generate a random prefix for the correlation-id of TWIN requests using UniqueId_Generate()]
+			else if (set_correlation_id_prefix(twin_msgr) != RESULT_OK)
+			{
+				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_110: [If UniqueId_Generate() fails, twin_messenger_create() shall fail and return NULL]
+				LogError("Failed generating correlation-id prefix (%s)", messenger_config->device_id);
+				internal_twin_messenger_destroy(twin_msgr);
+				twin_msgr = NULL;
+			}
 			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_007: [`twin_msgr->pending_patches` shall be set using singlylinkedlist_create()]  
 			else if ((twin_msgr->pending_patches = singlylinkedlist_create()) == NULL)
 			{
@@ -1744,6 +1836,14 @@ TWIN_MESSENGER_HANDLE twin_messenger_create(const TWIN_MESSENGER_CONFIG* messeng
 				internal_twin_messenger_destroy(twin_msgr);
 				twin_msgr = NULL;
 			}
+			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_113: [`twin_msgr->operations_index` shall be allocated with DEFAULT_TWIN_OPERATIONS_INDEX_SIZE empty buckets]
+			else if (create_operations_index(twin_msgr) != RESULT_OK)
+			{
+				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_114: [If `twin_msgr->operations_index` fails to be allocated, twin_messenger_create() shall fail and return NULL]
+				LogError("Failed creating index for operations (%s)", messenger_config->device_id);
+				internal_twin_messenger_destroy(twin_msgr);
+				twin_msgr = NULL;
+			}
 			else if ((link_attach_properties = create_link_attach_properties(twin_msgr)) == NULL)
 			{
 				LogError("Failed creating link attach properties (%s)", messenger_config->device_id);
@@ -1757,7 +1857,7 @@ TWIN_MESSENGER_HANDLE twin_messenger_create(const TWIN_MESSENGER_CONFIG* messeng
 				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_013: [`amqp_msgr_config->device_id` shall be set with `twin_msgr->device_id`]
 				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_014: [`amqp_msgr_config->iothub_host_fqdn` shall be set with `twin_msgr->iothub_host_fqdn`]
 				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_015: [`amqp_msgr_config` shall have "twin/" as send link target suffix and receive link source suffix]
-				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_016: [`amqp_msgr_config` shall have send and receive link attach properties set as "com.microsoft:client-version" = `twin_msgr->client_version`, "com.microsoft:channel-correlation-id" = `twin:<UUID>`, "com.microsoft:api-version" = "2016-11-14"]
+				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_016: [`amqp_msgr_config` shall have send and receive link attach properties set as "com.microsoft:client-version" = `twin_msgr->client_version`, "com.microsoft:channel-correlation-id" = `twin:<correlation-id>`, "com.microsoft:api-version" = "2016-11-14"]
 				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_017: [`amqp_msgr_config` shall be set with `on_amqp_messenger_state_changed_callback` and `on_amqp_messenger_subscription_changed_callback` callbacks]
 				AMQP_MESSENGER_CONFIG amqp_msgr_config;
 				amqp_msgr_config.client_version = twin_msgr->client_version;
@@ -1841,8 +1941,8 @@ int twin_messenger_report_state_async(TWIN_MESSENGER_HANDLE twin_msgr_handle, CO
 			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_026: [If `data` fails to be copied, twin_messenger_report_state_async() shall fail and return a non-zero value]    
 			result = __FAILURE__;
 		}
-		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_027: [`twin_op_ctx->time_enqueued` shall be set using get_time]    
-		else if ((twin_patch_ctx->time_enqueued = get_time(NULL)) == INDEFINITE_TIME)
+		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_027: [`twin_op_ctx->time_enqueued` shall be set using tickcounter_get_current_ms() on `twin_msgr->tick_counter`]    
+		else if (tickcounter_get_current_ms(twin_msgr->tick_counter, &twin_patch_ctx->time_enqueued) != 0)
 		{
 			LogError("Failed setting reported state enqueue time (%s)", twin_msgr->device_id);
 			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_031: [If any failure occurs, twin_messenger_report_state_async() shall free any memory it has allocated]  
@@ -2048,15 +2148,25 @@ void twin_messenger_do_work(TWIN_MESSENGER_HANDLE twin_msgr_handle)
 	{
 		TWIN_MESSENGER_INSTANCE* twin_msgr = (TWIN_MESSENGER_INSTANCE*)twin_msgr_handle;
 
-		if (twin_msgr->state == TWIN_MESSENGER_STATE_STARTED)
+		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_119: [twin_messenger_do_work() shall read the current time once using tickcounter_get_current_ms() on `twin_msgr->tick_counter`, and use it for all time stamps and timeout verifications in this call]  
+		if (tickcounter_get_current_ms(twin_msgr->tick_counter, &twin_msgr->current_time_ms) != 0)
 		{
-			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_058: [If `twin_msgr->state` is TWIN_MESSENGER_STATE_STARTED, twin_messenger_do_work() shall send the PATCHES in `twin_msgr->pending_patches`, removing them from the list]
-			(void)singlylinkedlist_remove_if(twin_msgr->pending_patches, send_pending_twin_patch, (const void*)twin_msgr);
-
-			process_twin_subscription(twin_msgr);
+			// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_082: [If any failure occurs while verifying/removing timed-out items `twin_msgr->state` shall be set to TWIN_MESSENGER_STATE_ERROR and user informed]  
+			LogError("Failed obtaining current time (%s)", twin_msgr->device_id);
+			update_state(twin_msgr, TWIN_MESSENGER_STATE_ERROR);
 		}
+		else
+		{
+			if (twin_msgr->state == TWIN_MESSENGER_STATE_STARTED)
+			{
+				// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_058: [If `twin_msgr->state` is TWIN_MESSENGER_STATE_STARTED, twin_messenger_do_work() shall send the PATCHES in `twin_msgr->pending_patches`, removing them from the list]
+				(void)singlylinkedlist_remove_if(twin_msgr->pending_patches, send_pending_twin_patch, (const void*)twin_msgr);
 
-		process_timeouts(twin_msgr);
+				process_twin_subscription(twin_msgr);
+			}
+
+			process_timeouts(twin_msgr);
+		}
 
 		// Codes_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_083: [twin_messenger_do_work() shall invoke amqp_messenger_do_work() passing `twin_msgr->amqp_msgr`]  
 		amqp_messenger_do_work(twin_msgr->amqp_msgr);
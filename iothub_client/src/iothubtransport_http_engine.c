@@ -0,0 +1,1444 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include "iothubtransport_http_engine.h"
+#include "iothub_client_tls_session_cache.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/tlsio.h"
+
+#define RESULT_OK                           0
+#define DEFAULT_HTTPS_PORT                  443
+#define DEFAULT_REQUEST_TIMEOUT_MS          (60 * 1000)
+#define MAX_RESPONSE_LINE_LENGTH            4096
+#define MAX_RESPONSE_CONTENT_SIZE           (1024 * 1024)
+#define INDEFINITE_CONTENT_LENGTH           SIZE_MAX
+
+typedef enum HTTP_CONNECTION_STATE_TAG
+{
+	HTTP_CONNECTION_STATE_CLOSED,
+	HTTP_CONNECTION_STATE_OPENING,
+	HTTP_CONNECTION_STATE_IDLE,
+	HTTP_CONNECTION_STATE_BUSY,
+	HTTP_CONNECTION_STATE_CLOSING
+} HTTP_CONNECTION_STATE;
+
+typedef enum RESPONSE_PARSER_STATE_TAG
+{
+	RESPONSE_PARSER_STATE_STATUS_LINE,
+	RESPONSE_PARSER_STATE_HEADERS,
+	RESPONSE_PARSER_STATE_CONTENT,
+	RESPONSE_PARSER_STATE_CONTENT_UNTIL_CLOSE,
+	RESPONSE_PARSER_STATE_CHUNK_SIZE,
+	RESPONSE_PARSER_STATE_CHUNK_DATA,
+	RESPONSE_PARSER_STATE_CHUNK_DATA_END,
+	RESPONSE_PARSER_STATE_TRAILERS
+} RESPONSE_PARSER_STATE;
+
+typedef struct HTTP_ENGINE_REQUEST_TAG
+{
+	struct HTTP_ENGINE_REQUEST_TAG* next;
+	ON_HTTP_ENGINE_RESPONSE on_response;
+	void* context;
+	tickcounter_ms_t submitted_ms;
+	size_t id;
+	bool is_head;
+	bool is_idempotent;
+	bool is_retry;
+	// Size of the serialized request (request line, headers and content), stored right after this structure.
+	size_t size;
+} HTTP_ENGINE_REQUEST;
+
+typedef struct HTTP_CONNECTION_TAG
+{
+	struct HTTP_ENGINE_INSTANCE_TAG* engine;
+	XIO_HANDLE xio;
+	HTTP_CONNECTION_STATE state;
+	HTTP_ENGINE_REQUEST* request;
+	// Request whose arrival made http_engine_dowork() open this connection; only it is failed if the open fails.
+	size_t opening_request_id;
+	size_t completed_request_count;
+	bool is_response_started;
+	bool is_keep_alive;
+	bool is_chunked;
+	RESPONSE_PARSER_STATE parser_state;
+	char line[MAX_RESPONSE_LINE_LENGTH];
+	size_t line_length;
+	unsigned int status_code;
+	HTTP_HEADERS_HANDLE response_headers;
+	size_t content_length;
+	size_t remaining;
+	unsigned char* content;
+	size_t content_size;
+	size_t content_capacity;
+} HTTP_CONNECTION;
+
+typedef struct HTTP_ENGINE_INSTANCE_TAG
+{
+	char* host_name;
+	HTTP_ENGINE_GET_IO_TRANSPORT get_io_transport;
+	tickcounter_ms_t request_timeout_ms;
+	TICK_COUNTER_HANDLE tick_counter;
+	OPTIONHANDLER_HANDLE options;
+	HTTP_CONNECTION* connections;
+	size_t max_connections;
+	HTTP_ENGINE_REQUEST* pending_head;
+	HTTP_ENGINE_REQUEST* pending_tail;
+	size_t pending_count;
+	size_t next_request_id;
+	bool is_in_dowork;
+} HTTP_ENGINE_INSTANCE;
+
+
+// ========== Helper Functions ========== //
+
+static XIO_HANDLE get_tls_io(const char* fully_qualified_name)
+{
+	XIO_HANDLE result;
+	const IO_INTERFACE_DESCRIPTION* io_interface_description;
+
+	if ((io_interface_description = platform_get_default_tlsio()) == NULL)
+	{
+		LogError("Failed obtaining default TLS IO interface");
+		result = NULL;
+	}
+	else
+	{
+		TLSIO_CONFIG tls_io_config;
+		tls_io_config.hostname = fully_qualified_name;
+		tls_io_config.port = DEFAULT_HTTPS_PORT;
+		tls_io_config.underlying_io_interface = NULL;
+		tls_io_config.underlying_io_parameters = NULL;
+
+		if ((result = xio_create(io_interface_description, &tls_io_config)) == NULL)
+		{
+			LogError("Failed creating the TLS I/O (xio_create failed)");
+		}
+	}
+
+	return result;
+}
+
+static bool is_string_option(const char* name)
+{
+	return (strcmp(OPTION_TRUSTED_CERT, name) == 0 || strcmp(OPTION_X509_CERT, name) == 0 || strcmp(OPTION_X509_PRIVATE_KEY, name) == 0);
+}
+
+static void* http_engine_clone_option(const char* name, const void* value)
+{
+	void* result;
+
+	if (is_string_option(name))
+	{
+		char* clone;
+
+		if (mallocAndStrcpy_s(&clone, (const char*)value) != RESULT_OK)
+		{
+			LogError("Failed cloning option '%s'", name);
+			result = NULL;
+		}
+		else
+		{
+			result = clone;
+		}
+	}
+	else
+	{
+		// The TLS session store is owned by the caller and outlives the engine.
+		result = (void*)value;
+	}
+
+	return result;
+}
+
+static void http_engine_destroy_option(const char* name, const void* value)
+{
+	if (is_string_option(name))
+	{
+		free((void*)value);
+	}
+}
+
+static int http_engine_feed_option(void* handle, const char* name, const void* value)
+{
+	return xio_setoption((XIO_HANDLE)handle, name, value);
+}
+
+static bool is_header_name(const char* name, size_t name_length, const char* expected)
+{
+	bool result = (strlen(expected) == name_length);
+	size_t i;
+
+	for (i = 0; result && i < name_length; i++)
+	{
+		char c = name[i];
+		char e = expected[i];
+
+		if (c >= 'A' && c <= 'Z')
+		{
+			c = (char)(c - 'A' + 'a');
+		}
+
+		if (e >= 'A' && e <= 'Z')
+		{
+			e = (char)(e - 'A' + 'a');
+		}
+
+		result = (c == e);
+	}
+
+	return result;
+}
+
+static bool contains_token(const char* value, const char* token)
+{
+	bool result = false;
+
+	while (!result && *value != '\0')
+	{
+		size_t length;
+
+		while (*value == ' ' || *value == '\t' || *value == ',')
+		{
+			value++;
+		}
+
+		length = 0;
+		while (value[length] != '\0' && value[length] != ',' && value[length] != ' ' && value[length] != '\t')
+		{
+			length++;
+		}
+
+		result = (length > 0 && is_header_name(value, length, token));
+		value += length;
+	}
+
+	return result;
+}
+
+static const char* get_method_name(HTTPAPI_REQUEST_TYPE request_type)
+{
+	const char* result;
+
+	switch (request_type)
+	{
+	case HTTPAPI_REQUEST_GET:
+		result = "GET";
+		break;
+	case HTTPAPI_REQUEST_POST:
+		result = "POST";
+		break;
+	case HTTPAPI_REQUEST_PUT:
+		result = "PUT";
+		break;
+	case HTTPAPI_REQUEST_DELETE:
+		result = "DELETE";
+		break;
+	case HTTPAPI_REQUEST_PATCH:
+		result = "PATCH";
+		break;
+	case HTTPAPI_REQUEST_HEAD:
+		result = "HEAD";
+		break;
+	default:
+		result = NULL;
+		break;
+	}
+
+	return result;
+}
+
+static int add_request_headers(STRING_HANDLE request_head, HTTP_HEADERS_HANDLE request_headers)
+{
+	int result;
+	size_t header_count;
+
+	if (request_headers == NULL)
+	{
+		result = RESULT_OK;
+	}
+	else if (HTTPHeaders_GetHeaderCount(request_headers, &header_count) != HTTP_HEADERS_OK)
+	{
+		LogError("Failed getting the request header count");
+		result = __FAILURE__;
+	}
+	else
+	{
+		size_t i;
+
+		result = RESULT_OK;
+
+		for (i = 0; result == RESULT_OK && i < header_count; i++)
+		{
+			char* header;
+
+			if (HTTPHeaders_GetHeader(request_headers, i, &header) != HTTP_HEADERS_OK)
+			{
+				LogError("Failed getting request header %lu", (unsigned long)i);
+				result = __FAILURE__;
+			}
+			else
+			{
+				const char* separator = strchr(header, ':');
+				size_t name_length = (separator == NULL) ? 0 : (size_t)(separator - header);
+
+				// Host and Content-Length are always written by the engine.
+				if (!is_header_name(header, name_length, "Host") && !is_header_name(header, name_length, "Content-Length") &&
+					(STRING_concat(request_head, header) != RESULT_OK || STRING_concat(request_head, "\r\n") != RESULT_OK))
+				{
+					LogError("Failed serializing request header %lu", (unsigned long)i);
+					result = __FAILURE__;
+				}
+
+				free(header);
+			}
+		}
+	}
+
+	return result;
+}
+
+static HTTP_ENGINE_REQUEST* create_request(HTTP_ENGINE_INSTANCE* engine, HTTPAPI_REQUEST_TYPE request_type, const char* method, const char* relative_path, HTTP_HEADERS_HANDLE request_headers, const unsigned char* content, size_t content_size)
+{
+	HTTP_ENGINE_REQUEST* result;
+	STRING_HANDLE request_head;
+
+	if ((request_head = STRING_construct_sprintf("%s %s HTTP/1.1\r\nHost: %s\r\n", method, relative_path, engine->host_name)) == NULL)
+	{
+		LogError("Failed serializing the request line");
+		result = NULL;
+	}
+	else
+	{
+		if (add_request_headers(request_head, request_headers) != RESULT_OK)
+		{
+			result = NULL;
+		}
+		else if (((content_size > 0 || request_type == HTTPAPI_REQUEST_POST || request_type == HTTPAPI_REQUEST_PUT || request_type == HTTPAPI_REQUEST_PATCH) &&
+			STRING_sprintf(request_head, "Content-Length: %lu\r\n", (unsigned long)content_size) != RESULT_OK) ||
+			STRING_concat(request_head, "\r\n") != RESULT_OK)
+		{
+			LogError("Failed serializing the request headers");
+			result = NULL;
+		}
+		else
+		{
+			size_t head_size = STRING_length(request_head);
+
+			if (content_size > SIZE_MAX - sizeof(HTTP_ENGINE_REQUEST) - head_size)
+			{
+				LogError("Request too large (%lu bytes)", (unsigned long)content_size);
+				result = NULL;
+			}
+			else if ((result = (HTTP_ENGINE_REQUEST*)malloc(sizeof(HTTP_ENGINE_REQUEST) + head_size + content_size)) == NULL)
+			{
+				LogError("Failed allocating request");
+			}
+			else
+			{
+				unsigned char* bytes = (unsigned char*)(result + 1);
+
+				(void)memcpy(bytes, STRING_c_str(request_head), head_size);
+
+				if (content_size > 0)
+				{
+					(void)memcpy(bytes + head_size, content, content_size);
+				}
+
+				result->next = NULL;
+				result->size = head_size + content_size;
+				result->id = engine->next_request_id++;
+				result->is_head = (request_type == HTTPAPI_REQUEST_HEAD);
+				result->is_idempotent = (request_type != HTTPAPI_REQUEST_POST && request_type != HTTPAPI_REQUEST_PATCH);
+				result->is_retry = false;
+			}
+		}
+
+		STRING_delete(request_head);
+	}
+
+	return result;
+}
+
+static void complete_request(HTTP_ENGINE_REQUEST* request, HTTP_ENGINE_RESULT result, unsigned int status_code, HTTP_HEADERS_HANDLE response_headers, const unsigned char* content, size_t content_size)
+{
+	request->on_response(request->context, result, status_code, response_headers, content, content_size);
+	free(request);
+}
+
+static void push_pending_request(HTTP_ENGINE_INSTANCE* engine, HTTP_ENGINE_REQUEST* request)
+{
+	request->next = NULL;
+
+	if (engine->pending_tail == NULL)
+	{
+		engine->pending_head = request;
+	}
+	else
+	{
+		engine->pending_tail->next = request;
+	}
+
+	engine->pending_tail = request;
+	engine->pending_count++;
+}
+
+static void push_front_pending_request(HTTP_ENGINE_INSTANCE* engine, HTTP_ENGINE_REQUEST* request)
+{
+	request->next = engine->pending_head;
+	engine->pending_head = request;
+
+	if (engine->pending_tail == NULL)
+	{
+		engine->pending_tail = request;
+	}
+
+	engine->pending_count++;
+}
+
+static HTTP_ENGINE_REQUEST* pop_pending_request(HTTP_ENGINE_INSTANCE* engine)
+{
+	HTTP_ENGINE_REQUEST* result = engine->pending_head;
+
+	if (result != NULL)
+	{
+		engine->pending_head = result->next;
+
+		if (engine->pending_head == NULL)
+		{
+			engine->pending_tail = NULL;
+		}
+
+		engine->pending_count--;
+		result->next = NULL;
+	}
+
+	return result;
+}
+
+static HTTP_ENGINE_REQUEST* get_pending_request(HTTP_ENGINE_INSTANCE* engine, size_t index)
+{
+	HTTP_ENGINE_REQUEST* result = engine->pending_head;
+
+	while (index > 0)
+	{
+		result = result->next;
+		index--;
+	}
+
+	return result;
+}
+
+// Completes, with `result`, every pending request for which `should_complete` returns true.
+static void complete_pending_requests(HTTP_ENGINE_INSTANCE* engine, HTTP_ENGINE_RESULT result, bool(*should_complete)(HTTP_ENGINE_REQUEST* request, const void* argument), const void* argument)
+{
+	HTTP_ENGINE_REQUEST* completed = NULL;
+	HTTP_ENGINE_REQUEST** completed_tail = &completed;
+	HTTP_ENGINE_REQUEST** link = &engine->pending_head;
+
+	engine->pending_tail = NULL;
+
+	// Unlink first, so callbacks can safely queue new requests.
+	while (*link != NULL)
+	{
+		HTTP_ENGINE_REQUEST* request = *link;
+
+		if (should_complete(request, argument))
+		{
+			*link = request->next;
+			request->next = NULL;
+			*completed_tail = request;
+			completed_tail = &request->next;
+			engine->pending_count--;
+		}
+		else
+		{
+			engine->pending_tail = request;
+			link = &request->next;
+		}
+	}
+
+	while (completed != NULL)
+	{
+		HTTP_ENGINE_REQUEST* request = completed;
+		completed = request->next;
+		complete_request(request, result, 0, NULL, NULL, 0);
+	}
+}
+
+static bool matches_any(HTTP_ENGINE_REQUEST* request, const void* argument)
+{
+	(void)request;
+	(void)argument;
+	return true;
+}
+
+static bool matches_context(HTTP_ENGINE_REQUEST* request, const void* argument)
+{
+	return (request->context == argument);
+}
+
+static bool matches_id(HTTP_ENGINE_REQUEST* request, const void* argument)
+{
+	return (request->id == *(const size_t*)argument);
+}
+
+static bool is_expired(HTTP_ENGINE_REQUEST* request, const void* argument)
+{
+	const tickcounter_ms_t* expiry_cutoff_ms = (const tickcounter_ms_t*)argument;
+	return (request->submitted_ms <= *expiry_cutoff_ms);
+}
+
+static void reset_response_parser(HTTP_CONNECTION* connection)
+{
+	connection->parser_state = RESPONSE_PARSER_STATE_STATUS_LINE;
+	connection->line_length = 0;
+	connection->status_code = 0;
+	connection->is_keep_alive = true;
+	connection->is_chunked = false;
+	connection->content_length = INDEFINITE_CONTENT_LENGTH;
+	connection->remaining = 0;
+	connection->content_size = 0;
+
+	if (connection->response_headers != NULL)
+	{
+		HTTPHeaders_Free(connection->response_headers);
+		connection->response_headers = NULL;
+	}
+}
+
+static HTTP_ENGINE_REQUEST* detach_request(HTTP_CONNECTION* connection)
+{
+	HTTP_ENGINE_REQUEST* result = connection->request;
+	connection->request = NULL;
+	return result;
+}
+
+// Marks the connection for destruction; the I/O is only destroyed by http_engine_dowork, outside of its own callbacks.
+static void close_connection(HTTP_CONNECTION* connection)
+{
+	if (connection->xio != NULL)
+	{
+		connection->state = HTTP_CONNECTION_STATE_CLOSING;
+	}
+	else
+	{
+		connection->state = HTTP_CONNECTION_STATE_CLOSED;
+	}
+}
+
+static void destroy_connection_io(HTTP_CONNECTION* connection)
+{
+	if (connection->xio != NULL)
+	{
+		xio_destroy(connection->xio);
+		connection->xio = NULL;
+	}
+
+	reset_response_parser(connection);
+	connection->state = HTTP_CONNECTION_STATE_CLOSED;
+}
+
+// The request may meanwhile have been sent on another connection, completed or cancelled; then nothing is failed.
+static void fail_opening_request(HTTP_CONNECTION* connection)
+{
+	complete_pending_requests(connection->engine, HTTP_ENGINE_ERROR, matches_id, &connection->opening_request_id);
+}
+
+static void complete_response(HTTP_CONNECTION* connection)
+{
+	HTTP_ENGINE_REQUEST* request = detach_request(connection);
+	HTTP_HEADERS_HANDLE response_headers = connection->response_headers;
+
+	connection->response_headers = NULL;
+	connection->completed_request_count++;
+
+	if (connection->is_keep_alive)
+	{
+		connection->state = HTTP_CONNECTION_STATE_IDLE;
+	}
+	else
+	{
+		close_connection(connection);
+	}
+
+	complete_request(request, HTTP_ENGINE_OK, connection->status_code, response_headers, connection->content, connection->content_size);
+
+	if (response_headers != NULL)
+	{
+		HTTPHeaders_Free(response_headers);
+	}
+
+	connection->parser_state = RESPONSE_PARSER_STATE_STATUS_LINE;
+	connection->content_size = 0;
+}
+
+static void on_connection_failed(HTTP_CONNECTION* connection)
+{
+	if (connection->state == HTTP_CONNECTION_STATE_BUSY && connection->request != NULL)
+	{
+		if (connection->parser_state == RESPONSE_PARSER_STATE_CONTENT_UNTIL_CLOSE)
+		{
+			// The response had neither Content-Length nor chunked encoding, so the close marks its end.
+			complete_response(connection);
+		}
+		else
+		{
+			HTTP_ENGINE_REQUEST* request = detach_request(connection);
+
+			// A keep-alive connection can be closed by the server at any time while idle; a request that got no
+			// response byte on a reused connection is sent once more, ahead of everything else. Its bytes may
+			// still have reached the server, so POST and PATCH requests are not sent twice.
+			if (!connection->is_response_started && connection->completed_request_count > 0 && request->is_idempotent && !request->is_retry)
+			{
+				request->is_retry = true;
+				push_front_pending_request(connection->engine, request);
+			}
+			else
+			{
+				complete_request(request, HTTP_ENGINE_ERROR, 0, NULL, NULL, 0);
+			}
+		}
+	}
+	else if (connection->state == HTTP_CONNECTION_STATE_OPENING)
+	{
+		LogError("Failed opening connection to %s", connection->engine->host_name);
+		fail_opening_request(connection);
+	}
+
+	close_connection(connection);
+}
+
+static int append_content(HTTP_CONNECTION* connection, const unsigned char* bytes, size_t size)
+{
+	int result;
+
+	if (size > MAX_RESPONSE_CONTENT_SIZE - connection->content_size)
+	{
+		LogError("Response content exceeds %lu bytes", (unsigned long)MAX_RESPONSE_CONTENT_SIZE);
+		result = __FAILURE__;
+	}
+	else if (connection->content_size + size > connection->content_capacity)
+	{
+		size_t new_capacity = (connection->content_capacity == 0) ? 256 : connection->content_capacity;
+		unsigned char* new_content;
+
+		while (new_capacity < connection->content_size + size)
+		{
+			new_capacity *= 2;
+		}
+
+		if ((new_content = (unsigned char*)realloc(connection->content, new_capacity)) == NULL)
+		{
+			LogError("Failed allocating response content");
+			result = __FAILURE__;
+		}
+		else
+		{
+			connection->content = new_content;
+			connection->content_capacity = new_capacity;
+			result = RESULT_OK;
+		}
+	}
+	else
+	{
+		result = RESULT_OK;
+	}
+
+	if (result == RESULT_OK && size > 0)
+	{
+		(void)memcpy(connection->content + connection->content_size, bytes, size);
+		connection->content_size += size;
+	}
+
+	return result;
+}
+
+static int parse_status_line(HTTP_CONNECTION* connection)
+{
+	int result;
+	const char* line = connection->line;
+
+	// "HTTP/1.x SSS Reason"
+	if (strncmp(line, "HTTP/1.", 7) != 0 || line[7] < '0' || line[7] > '9' || line[8] != ' ' ||
+		line[9] < '1' || line[9] > '5' || line[10] < '0' || line[10] > '9' || line[11] < '0' || line[11] > '9')
+	{
+		LogError("Invalid HTTP status line");
+		result = __FAILURE__;
+	}
+	else if ((connection->response_headers = HTTPHeaders_Alloc()) == NULL)
+	{
+		LogError("Failed allocating response headers");
+		result = __FAILURE__;
+	}
+	else
+	{
+		connection->status_code = (unsigned int)((line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0'));
+		connection->is_keep_alive = (line[7] != '0');
+		connection->parser_state = RESPONSE_PARSER_STATE_HEADERS;
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+static int parse_header_line(HTTP_CONNECTION* connection)
+{
+	int result;
+	char* separator = strchr(connection->line, ':');
+
+	if (separator == NULL || separator == connection->line)
+	{
+		LogError("Invalid HTTP header line");
+		result = __FAILURE__;
+	}
+	else
+	{
+		size_t name_length = (size_t)(separator - connection->line);
+		char* value = separator + 1;
+
+		while (*value == ' ' || *value == '\t')
+		{
+			value++;
+		}
+
+		*separator = '\0';
+
+		if (is_header_name(connection->line, name_length, "Content-Length"))
+		{
+			char* end;
+			unsigned long content_length = strtoul(value, &end, 10);
+
+			if (end == value || content_length > MAX_RESPONSE_CONTENT_SIZE)
+			{
+				LogError("Invalid or too large Content-Length '%s'", value);
+				result = __FAILURE__;
+			}
+			else
+			{
+				connection->content_length = (size_t)content_length;
+				result = RESULT_OK;
+			}
+		}
+		else
+		{
+			if (is_header_name(connection->line, name_length, "Transfer-Encoding"))
+			{
+				connection->is_chunked = contains_token(value, "chunked");
+			}
+			else if (is_header_name(connection->line, name_length, "Connection"))
+			{
+				if (contains_token(value, "close"))
+				{
+					connection->is_keep_alive = false;
+				}
+				else if (contains_token(value, "keep-alive"))
+				{
+					connection->is_keep_alive = true;
+				}
+			}
+
+			result = RESULT_OK;
+		}
+
+		if (result == RESULT_OK && HTTPHeaders_AddHeaderNameValuePair(connection->response_headers, connection->line, value) != HTTP_HEADERS_OK)
+		{
+			LogError("Failed adding response header '%s'", connection->line);
+			result = __FAILURE__;
+		}
+	}
+
+	return result;
+}
+
+static int on_end_of_headers(HTTP_CONNECTION* connection)
+{
+	if (connection->status_code < 200)
+	{
+		// Interim (1xx) response; the final one follows on the same connection.
+		HTTPHeaders_Free(connection->response_headers);
+		connection->response_headers = NULL;
+		connection->is_chunked = false;
+		connection->content_length = INDEFINITE_CONTENT_LENGTH;
+		connection->parser_state = RESPONSE_PARSER_STATE_STATUS_LINE;
+	}
+	else if (connection->request->is_head || connection->status_code == 204 || connection->status_code == 304)
+	{
+		complete_response(connection);
+	}
+	else if (connection->is_chunked)
+	{
+		connection->parser_state = RESPONSE_PARSER_STATE_CHUNK_SIZE;
+	}
+	else if (connection->content_length == INDEFINITE_CONTENT_LENGTH)
+	{
+		connection->is_keep_alive = false;
+		connection->parser_state = RESPONSE_PARSER_STATE_CONTENT_UNTIL_CLOSE;
+	}
+	else if (connection->content_length == 0)
+	{
+		complete_response(connection);
+	}
+	else
+	{
+		connection->remaining = connection->content_length;
+		connection->parser_state = RESPONSE_PARSER_STATE_CONTENT;
+	}
+
+	return RESULT_OK;
+}
+
+static int on_response_line(HTTP_CONNECTION* connection)
+{
+	int result;
+
+	switch (connection->parser_state)
+	{
+	case RESPONSE_PARSER_STATE_STATUS_LINE:
+		// Tolerate empty lines ahead of the status line.
+		result = (connection->line_length == 0) ? RESULT_OK : parse_status_line(connection);
+		break;
+	case RESPONSE_PARSER_STATE_HEADERS:
+		result = (connection->line_length == 0) ? on_end_of_headers(connection) : parse_header_line(connection);
+		break;
+	case RESPONSE_PARSER_STATE_CHUNK_SIZE:
+	{
+		char* end;
+		unsigned long chunk_size = strtoul(connection->line, &end, 16);
+
+		if (end == connection->line || chunk_size > MAX_RESPONSE_CONTENT_SIZE - connection->content_size)
+		{
+			LogError("Invalid or too large chunk size '%s'", connection->line);
+			result = __FAILURE__;
+		}
+		else
+		{
+			connection->remaining = (size_t)chunk_size;
+			connection->parser_state = (chunk_size == 0) ? RESPONSE_PARSER_STATE_TRAILERS : RESPONSE_PARSER_STATE_CHUNK_DATA;
+			result = RESULT_OK;
+		}
+		break;
+	}
+	case RESPONSE_PARSER_STATE_CHUNK_DATA_END:
+		if (connection->line_length != 0)
+		{
+			LogError("Missing CRLF after chunk data");
+			result = __FAILURE__;
+		}
+		else
+		{
+			connection->parser_state = RESPONSE_PARSER_STATE_CHUNK_SIZE;
+			result = RESULT_OK;
+		}
+		break;
+	case RESPONSE_PARSER_STATE_TRAILERS:
+		if (connection->line_length == 0)
+		{
+			complete_response(connection);
+		}
+		result = RESULT_OK;
+		break;
+	default:
+		result = __FAILURE__;
+		break;
+	}
+
+	return result;
+}
+
+// Returns the number of bytes consumed, or 0 if the response is invalid.
+static size_t parse_response_bytes(HTTP_CONNECTION* connection, const unsigned char* buffer, size_t size)
+{
+	size_t result;
+
+	if (connection->parser_state == RESPONSE_PARSER_STATE_CONTENT || connection->parser_state == RESPONSE_PARSER_STATE_CHUNK_DATA)
+	{
+		size_t length = (size < connection->remaining) ? size : connection->remaining;
+
+		if (append_content(connection, buffer, length) != RESULT_OK)
+		{
+			result = 0;
+		}
+		else
+		{
+			connection->remaining -= length;
+			result = length;
+
+			if (connection->remaining == 0)
+			{
+				if (connection->parser_state == RESPONSE_PARSER_STATE_CONTENT)
+				{
+					complete_response(connection);
+				}
+				else
+				{
+					connection->parser_state = RESPONSE_PARSER_STATE_CHUNK_DATA_END;
+				}
+			}
+		}
+	}
+	else if (connection->parser_state == RESPONSE_PARSER_STATE_CONTENT_UNTIL_CLOSE)
+	{
+		result = (append_content(connection, buffer, size) == RESULT_OK) ? size : 0;
+	}
+	else
+	{
+		const unsigned char* line_end = (const unsigned char*)memchr(buffer, '\n', size);
+		size_t length = (line_end == NULL) ? size : (size_t)(line_end - buffer);
+
+		if (length >= MAX_RESPONSE_LINE_LENGTH - connection->line_length)
+		{
+			LogError("Response line exceeds %lu bytes", (unsigned long)MAX_RESPONSE_LINE_LENGTH);
+			result = 0;
+		}
+		else
+		{
+			(void)memcpy(connection->line + connection->line_length, buffer, length);
+			connection->line_length += length;
+
+			if (line_end == NULL)
+			{
+				result = length;
+			}
+			else
+			{
+				if (connection->line_length > 0 && connection->line[connection->line_length - 1] == '\r')
+				{
+					connection->line_length--;
+				}
+
+				connection->line[connection->line_length] = '\0';
+				result = (on_response_line(connection) == RESULT_OK) ? length + 1 : 0;
+				connection->line_length = 0;
+			}
+		}
+	}
+
+	return result;
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+	HTTP_CONNECTION* connection = (HTTP_CONNECTION*)context;
+
+	if (connection->state == HTTP_CONNECTION_STATE_BUSY)
+	{
+		size_t position = 0;
+
+		connection->is_response_started = true;
+
+		// A response may end in the middle of `buffer`; any further bytes without a request are unexpected.
+		while (position < size && connection->state == HTTP_CONNECTION_STATE_BUSY)
+		{
+			size_t consumed = parse_response_bytes(connection, buffer + position, size - position);
+
+			if (consumed == 0)
+			{
+				on_connection_failed(connection);
+			}
+
+			position += consumed;
+		}
+
+		if (position < size && connection->state == HTTP_CONNECTION_STATE_IDLE)
+		{
+			LogError("Unexpected bytes received after the response");
+			close_connection(connection);
+		}
+	}
+	else if (connection->state == HTTP_CONNECTION_STATE_IDLE)
+	{
+		// E.g. a 408 sent by the server before it closes an idle connection.
+		close_connection(connection);
+	}
+}
+
+static void on_io_error(void* context)
+{
+	on_connection_failed((HTTP_CONNECTION*)context);
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+	HTTP_CONNECTION* connection = (HTTP_CONNECTION*)context;
+
+	if (connection->state == HTTP_CONNECTION_STATE_OPENING)
+	{
+		if (open_result == IO_OPEN_OK)
+		{
+			connection->state = HTTP_CONNECTION_STATE_IDLE;
+		}
+		else
+		{
+			on_connection_failed(connection);
+		}
+	}
+}
+
+static void on_io_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+	HTTP_CONNECTION* connection = (HTTP_CONNECTION*)context;
+
+	if (send_result != IO_SEND_OK && connection->state == HTTP_CONNECTION_STATE_BUSY)
+	{
+		on_connection_failed(connection);
+	}
+}
+
+static void open_connection(HTTP_ENGINE_INSTANCE* engine, HTTP_CONNECTION* connection, HTTP_ENGINE_REQUEST* opening_request)
+{
+	connection->opening_request_id = opening_request->id;
+
+	if ((connection->xio = engine->get_io_transport(engine->host_name)) == NULL)
+	{
+		LogError("Failed creating the I/O for %s", engine->host_name);
+		fail_opening_request(connection);
+	}
+	else if (OptionHandler_FeedOptions(engine->options, connection->xio) != OPTIONHANDLER_OK)
+	{
+		LogError("Failed setting the options of the I/O for %s", engine->host_name);
+		destroy_connection_io(connection);
+		fail_opening_request(connection);
+	}
+	else
+	{
+		connection->state = HTTP_CONNECTION_STATE_OPENING;
+		connection->completed_request_count = 0;
+
+		if (xio_open(connection->xio, on_io_open_complete, connection, on_io_bytes_received, connection, on_io_error, connection) != RESULT_OK &&
+			connection->state == HTTP_CONNECTION_STATE_OPENING)
+		{
+			on_connection_failed(connection);
+		}
+	}
+}
+
+static void send_request(HTTP_CONNECTION* connection, HTTP_ENGINE_REQUEST* request)
+{
+	reset_response_parser(connection);
+	connection->request = request;
+	connection->is_response_started = false;
+	connection->state = HTTP_CONNECTION_STATE_BUSY;
+
+	if (xio_send(connection->xio, request + 1, request->size, on_io_send_complete, connection) != RESULT_OK &&
+		connection->state == HTTP_CONNECTION_STATE_BUSY)
+	{
+		LogError("Failed sending request to %s (xio_send failed)", connection->engine->host_name);
+		on_connection_failed(connection);
+	}
+}
+
+static void expire_requests(HTTP_ENGINE_INSTANCE* engine, tickcounter_ms_t current_ms)
+{
+	if (current_ms >= engine->request_timeout_ms)
+	{
+		tickcounter_ms_t expiry_cutoff_ms = current_ms - engine->request_timeout_ms;
+		size_t i;
+
+		for (i = 0; i < engine->max_connections; i++)
+		{
+			HTTP_CONNECTION* connection = &engine->connections[i];
+
+			if (connection->state == HTTP_CONNECTION_STATE_BUSY && is_expired(connection->request, &expiry_cutoff_ms))
+			{
+				HTTP_ENGINE_REQUEST* request = detach_request(connection);
+
+				// The connection is mid-response and cannot be reused.
+				close_connection(connection);
+				complete_request(request, HTTP_ENGINE_TIMEOUT, 0, NULL, NULL, 0);
+			}
+		}
+
+		complete_pending_requests(engine, HTTP_ENGINE_TIMEOUT, is_expired, &expiry_cutoff_ms);
+	}
+}
+
+// Completes in-flight requests with HTTP_ENGINE_CANCELLED and destroys every connection.
+static void destroy_connections(HTTP_ENGINE_INSTANCE* engine)
+{
+	if (engine->connections != NULL)
+	{
+		size_t i;
+
+		for (i = 0; i < engine->max_connections; i++)
+		{
+			HTTP_CONNECTION* connection = &engine->connections[i];
+
+			if (connection->request != NULL)
+			{
+				complete_request(detach_request(connection), HTTP_ENGINE_CANCELLED, 0, NULL, NULL, 0);
+			}
+
+			destroy_connection_io(connection);
+
+			if (connection->content != NULL)
+			{
+				free(connection->content);
+			}
+		}
+
+		free(engine->connections);
+		engine->connections = NULL;
+		engine->max_connections = 0;
+	}
+}
+
+
+// ========== Public API ========== //
+
+HTTP_ENGINE_HANDLE http_engine_create(const HTTP_ENGINE_CONFIG* config)
+{
+	HTTP_ENGINE_INSTANCE* result;
+
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_001: [If `config` or `config->host_name` are NULL, http_engine_create() shall fail and return NULL]
+	if (config == NULL || config->host_name == NULL)
+	{
+		LogError("Invalid argument (config=%p)", config);
+		result = NULL;
+	}
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_002: [http_engine_create() shall allocate memory for the engine instance]
+	else if ((result = (HTTP_ENGINE_INSTANCE*)malloc(sizeof(HTTP_ENGINE_INSTANCE))) == NULL)
+	{
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_003: [If any failure occurs, http_engine_create() shall free any memory it allocated and return NULL]
+		LogError("Failed allocating HTTP engine");
+	}
+	else
+	{
+		(void)memset(result, 0, sizeof(HTTP_ENGINE_INSTANCE));
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_004: [If `config->get_io_transport` is NULL, connections shall use a TLS I/O to `config->host_name` on port 443 created with platform_get_default_tlsio()]
+		result->get_io_transport = (config->get_io_transport != NULL) ? config->get_io_transport : get_tls_io;
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_005: [If `config->request_timeout_ms` is zero, the request timeout shall be 60 seconds]
+		result->request_timeout_ms = (config->request_timeout_ms != 0) ? (tickcounter_ms_t)config->request_timeout_ms : DEFAULT_REQUEST_TIMEOUT_MS;
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_006: [http_engine_create() shall copy `config->host_name` using mallocAndStrcpy_s]
+		if (mallocAndStrcpy_s(&result->host_name, config->host_name) != RESULT_OK)
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_003: [If any failure occurs, http_engine_create() shall free any memory it allocated and return NULL]
+			LogError("Failed copying the host name");
+			free(result);
+			result = NULL;
+		}
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_007: [http_engine_create() shall create a tick counter using tickcounter_create()]
+		else if ((result->tick_counter = tickcounter_create()) == NULL)
+		{
+			LogError("Failed creating tick counter");
+			free(result->host_name);
+			free(result);
+			result = NULL;
+		}
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_008: [http_engine_create() shall create an option handler using OptionHandler_Create() to hold the options of the connections]
+		else if ((result->options = OptionHandler_Create(http_engine_clone_option, http_engine_destroy_option, http_engine_feed_option)) == NULL)
+		{
+			LogError("Failed creating option handler");
+			tickcounter_destroy(result->tick_counter);
+			free(result->host_name);
+			free(result);
+			result = NULL;
+		}
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_009: [The engine shall be created with no connections]
+	}
+
+	return result;
+}
+
+void http_engine_destroy(HTTP_ENGINE_HANDLE http_engine_handle)
+{
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_010: [If `http_engine_handle` is NULL, http_engine_destroy() shall return]
+	if (http_engine_handle != NULL)
+	{
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_011: [http_engine_destroy() shall complete every in-flight and pending request with HTTP_ENGINE_CANCELLED]
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_012: [http_engine_destroy() shall destroy the I/O of each connection using xio_destroy()]
+		destroy_connections(http_engine_handle);
+		complete_pending_requests(http_engine_handle, HTTP_ENGINE_CANCELLED, matches_any, NULL);
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_013: [http_engine_destroy() shall destroy the option handler, the tick counter and free the engine]
+		OptionHandler_Destroy(http_engine_handle->options);
+		tickcounter_destroy(http_engine_handle->tick_counter);
+		free(http_engine_handle->host_name);
+		free(http_engine_handle);
+	}
+}
+
+int http_engine_set_max_connections(HTTP_ENGINE_HANDLE http_engine_handle, size_t max_connections)
+{
+	int result;
+
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_014: [If `http_engine_handle` is NULL, http_engine_set_max_connections() shall fail and return non-zero]
+	if (http_engine_handle == NULL)
+	{
+		LogError("Invalid argument (http_engine_handle is NULL)");
+		result = __FAILURE__;
+	}
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_015: [If called from a response callback, http_engine_set_max_connections() shall fail and return non-zero]
+	else if (http_engine_handle->is_in_dowork)
+	{
+		LogError("Cannot resize the connection pool from a response callback");
+		result = __FAILURE__;
+	}
+	else
+	{
+		size_t i;
+
+		result = RESULT_OK;
+
+		for (i = 0; i < http_engine_handle->max_connections; i++)
+		{
+			if (http_engine_handle->connections[i].state == HTTP_CONNECTION_STATE_BUSY)
+			{
+				result = __FAILURE__;
+			}
+		}
+
+		if (result != RESULT_OK)
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_016: [If any request is in flight, http_engine_set_max_connections() shall fail and return non-zero]
+			LogError("Cannot resize the connection pool while requests are in flight");
+		}
+		else
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_017: [http_engine_set_max_connections() shall destroy all existing connections]
+			destroy_connections(http_engine_handle);
+
+			if (max_connections == 0)
+			{
+				// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_018: [If `max_connections` is zero, pending requests shall be completed with HTTP_ENGINE_CANCELLED]
+				complete_pending_requests(http_engine_handle, HTTP_ENGINE_CANCELLED, matches_any, NULL);
+			}
+			// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_019: [http_engine_set_max_connections() shall allocate `max_connections` closed connections]
+			else if (max_connections > SIZE_MAX / sizeof(HTTP_CONNECTION) ||
+				(http_engine_handle->connections = (HTTP_CONNECTION*)malloc(max_connections * sizeof(HTTP_CONNECTION))) == NULL)
+			{
+				// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_020: [If the allocation fails, http_engine_set_max_connections() shall fail, leave the engine with no connections and return non-zero]
+				LogError("Failed allocating %lu connections", (unsigned long)max_connections);
+				complete_pending_requests(http_engine_handle, HTTP_ENGINE_CANCELLED, matches_any, NULL);
+				result = __FAILURE__;
+			}
+			else
+			{
+				(void)memset(http_engine_handle->connections, 0, max_connections * sizeof(HTTP_CONNECTION));
+
+				for (i = 0; i < max_connections; i++)
+				{
+					http_engine_handle->connections[i].engine = http_engine_handle;
+					reset_response_parser(&http_engine_handle->connections[i]);
+				}
+
+				http_engine_handle->max_connections = max_connections;
+			}
+		}
+	}
+
+	return result;
+}
+
+int http_engine_set_option(HTTP_ENGINE_HANDLE http_engine_handle, const char* name, const void* value)
+{
+	int result;
+
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_021: [If `http_engine_handle`, `name` or `value` are NULL, http_engine_set_option() shall fail and return non-zero]
+	if (http_engine_handle == NULL || name == NULL || value == NULL)
+	{
+		LogError("Invalid argument (http_engine_handle=%p, name=%p, value=%p)", http_engine_handle, name, value);
+		result = __FAILURE__;
+	}
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_022: [Only OPTION_TRUSTED_CERT, OPTION_X509_CERT, OPTION_X509_PRIVATE_KEY and OPTION_TLS_SESSION_STORE shall be supported; for any other `name` http_engine_set_option() shall fail and return non-zero]
+	else if (!is_string_option(name) && strcmp(OPTION_TLS_SESSION_STORE, name) != 0)
+	{
+		result = __FAILURE__;
+	}
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_023: [The option shall be saved using OptionHandler_AddOption() and applied to every connection opened afterwards]
+	else if (OptionHandler_AddOption(http_engine_handle->options, name, value) != OPTIONHANDLER_OK)
+	{
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_024: [If OptionHandler_AddOption() fails, http_engine_set_option() shall fail and return non-zero]
+		LogError("Failed saving option '%s'", name);
+		result = __FAILURE__;
+	}
+	else
+	{
+		size_t i;
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_025: [The option shall also be set on the I/O of each existing connection using xio_setoption()]
+		for (i = 0; i < http_engine_handle->max_connections; i++)
+		{
+			if (http_engine_handle->connections[i].xio != NULL &&
+				xio_setoption(http_engine_handle->connections[i].xio, name, value) != RESULT_OK)
+			{
+				LogError("Failed setting option '%s' on an open connection", name);
+			}
+		}
+
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+int http_engine_execute_request_async(HTTP_ENGINE_HANDLE http_engine_handle, HTTPAPI_REQUEST_TYPE request_type, const char* relative_path, HTTP_HEADERS_HANDLE request_headers, const unsigned char* content, size_t content_size, ON_HTTP_ENGINE_RESPONSE on_response, void* context)
+{
+	int result;
+	const char* method;
+
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_026: [If `http_engine_handle`, `relative_path` or `on_response` are NULL, or `content` is NULL and `content_size` is not zero, http_engine_execute_request_async() shall fail and return non-zero]
+	if (http_engine_handle == NULL || relative_path == NULL || on_response == NULL || (content == NULL && content_size > 0))
+	{
+		LogError("Invalid argument (http_engine_handle=%p, relative_path=%p, on_response=%p, content=%p, content_size=%lu)",
+			http_engine_handle, relative_path, on_response, content, (unsigned long)content_size);
+		result = __FAILURE__;
+	}
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_027: [If `request_type` is not a valid HTTPAPI_REQUEST_TYPE, http_engine_execute_request_async() shall fail and return non-zero]
+	else if ((method = get_method_name(request_type)) == NULL)
+	{
+		LogError("Invalid request type %d", (int)request_type);
+		result = __FAILURE__;
+	}
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_028: [If the engine has no connections, http_engine_execute_request_async() shall fail and return non-zero]
+	else if (http_engine_handle->max_connections == 0)
+	{
+		LogError("The HTTP engine has no connections");
+		result = __FAILURE__;
+	}
+	else
+	{
+		HTTP_ENGINE_REQUEST* request;
+		tickcounter_ms_t current_ms;
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_029: [The request shall be serialized at once into its request line, a Host header, the headers in `request_headers` except Host and Content-Length, a Content-Length header and `content`]
+		if ((request = create_request(http_engine_handle, request_type, method, relative_path, request_headers, content, content_size)) == NULL)
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_030: [If the serialization fails, http_engine_execute_request_async() shall fail and return non-zero]
+			result = __FAILURE__;
+		}
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_031: [The time of submission shall be read using tickcounter_get_current_ms()]
+		else if (tickcounter_get_current_ms(http_engine_handle->tick_counter, &current_ms) != RESULT_OK)
+		{
+			LogError("Failed reading the current time");
+			free(request);
+			result = __FAILURE__;
+		}
+		else
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_032: [The request shall be queued behind the pending requests and http_engine_execute_request_async() shall return 0; it is only sent by http_engine_dowork()]
+			request->on_response = on_response;
+			request->context = context;
+			request->submitted_ms = current_ms;
+			push_pending_request(http_engine_handle, request);
+			result = RESULT_OK;
+		}
+	}
+
+	return result;
+}
+
+void http_engine_cancel_requests(HTTP_ENGINE_HANDLE http_engine_handle, void* context)
+{
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_033: [If `http_engine_handle` is NULL, http_engine_cancel_requests() shall return]
+	if (http_engine_handle != NULL)
+	{
+		size_t i;
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_034: [Each in-flight request submitted with `context` shall be completed with HTTP_ENGINE_CANCELLED and its connection closed]
+		for (i = 0; i < http_engine_handle->max_connections; i++)
+		{
+			HTTP_CONNECTION* connection = &http_engine_handle->connections[i];
+
+			if (connection->state == HTTP_CONNECTION_STATE_BUSY && connection->request->context == context)
+			{
+				HTTP_ENGINE_REQUEST* request = detach_request(connection);
+				close_connection(connection);
+				complete_request(request, HTTP_ENGINE_CANCELLED, 0, NULL, NULL, 0);
+			}
+		}
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_035: [Each pending request submitted with `context` shall be completed with HTTP_ENGINE_CANCELLED]
+		complete_pending_requests(http_engine_handle, HTTP_ENGINE_CANCELLED, matches_context, context);
+	}
+}
+
+void http_engine_dowork(HTTP_ENGINE_HANDLE http_engine_handle)
+{
+	// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_036: [If `http_engine_handle` is NULL, http_engine_dowork() shall return]
+	if (http_engine_handle != NULL)
+	{
+		tickcounter_ms_t current_ms;
+		size_t opening_count = 0;
+		size_t i;
+
+		http_engine_handle->is_in_dowork = true;
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_037: [http_engine_dowork() shall call xio_dowork() on the I/O of each open connection]
+		for (i = 0; i < http_engine_handle->max_connections; i++)
+		{
+			HTTP_CONNECTION* connection = &http_engine_handle->connections[i];
+
+			if (connection->xio != NULL && connection->state != HTTP_CONNECTION_STATE_CLOSING)
+			{
+				xio_dowork(connection->xio);
+			}
+		}
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_038: [Connections that failed, were closed by the server or were cancelled shall have their I/O destroyed using xio_destroy()]
+		for (i = 0; i < http_engine_handle->max_connections; i++)
+		{
+			if (http_engine_handle->connections[i].state == HTTP_CONNECTION_STATE_CLOSING)
+			{
+				destroy_connection_io(&http_engine_handle->connections[i]);
+			}
+		}
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_039: [Requests queued or in flight for longer than the request timeout shall be completed with HTTP_ENGINE_TIMEOUT]
+		if (tickcounter_get_current_ms(http_engine_handle->tick_counter, &current_ms) != RESULT_OK)
+		{
+			LogError("Failed reading the current time; request timeouts not checked");
+		}
+		else
+		{
+			expire_requests(http_engine_handle, current_ms);
+		}
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_040: [Pending requests shall be sent, oldest first, on idle connections using xio_send()]
+		for (i = 0; i < http_engine_handle->max_connections && http_engine_handle->pending_head != NULL; i++)
+		{
+			HTTP_CONNECTION* connection = &http_engine_handle->connections[i];
+
+			if (connection->state == HTTP_CONNECTION_STATE_IDLE)
+			{
+				send_request(connection, pop_pending_request(http_engine_handle));
+			}
+			else if (connection->state == HTTP_CONNECTION_STATE_OPENING)
+			{
+				opening_count++;
+			}
+		}
+
+		// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_041: [If requests remain pending, closed connections shall be opened, no more than the number of requests not yet covered by connections being opened]
+		for (i = 0; i < http_engine_handle->max_connections && http_engine_handle->pending_count > opening_count; i++)
+		{
+			HTTP_CONNECTION* connection = &http_engine_handle->connections[i];
+
+			if (connection->state == HTTP_CONNECTION_STATE_CLOSED)
+			{
+				// Codes_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_042: [If the I/O cannot be created, configured or opened, the first pending request not covered by the other connections being opened when the connection was opened shall be completed with HTTP_ENGINE_ERROR, if it is still pending]
+				open_connection(http_engine_handle, connection, get_pending_request(http_engine_handle, opening_count));
+
+				if (connection->state == HTTP_CONNECTION_STATE_OPENING)
+				{
+					opening_count++;
+				}
+			}
+		}
+
+		http_engine_handle->is_in_dowork = false;
+	}
+}
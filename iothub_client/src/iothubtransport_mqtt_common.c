@@ -21,13 +21,17 @@
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/platform.h"
 
-#include "azure_c_shared_utility/string_tokenizer.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/urlencode.h"
+#include "azure_c_shared_utility/optionhandler.h"
 #include "iothub_client_version.h"
 #include "iothub_client_retry_control.h"
+#include "iothub_client_tls_session_cache.h"
+#include "iothub_client_hash.h"
+#include "iothub_client_slab.h"
 
 #include "iothubtransport_mqtt_common.h"
+#include "iothubtransport_mqtt_topic.h"
 
 #include <stdarg.h>
 #include <stdio.h>
@@ -37,6 +41,9 @@
 
 #define SAS_TOKEN_DEFAULT_LIFETIME          3600
 #define SAS_REFRESH_MULTIPLIER              .8
+// Each connection refreshes its token at a random point of the last SAS_REFRESH_JITTER_MULTIPLIER of the
+// refresh period, so that devices connected at the same time do not all reconnect at the same time.
+#define SAS_REFRESH_JITTER_MULTIPLIER       .2
 #define EPOCH_TIME_T_VALUE                  0
 #define DEFAULT_MQTT_KEEPALIVE              4*60 // 4 min
 #define BUILD_CONFIG_USERNAME               24
@@ -51,9 +58,6 @@
 #define DEFAULT_RETRY_POLICY                IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER
 #define DEFAULT_RETRY_TIMEOUT_IN_SECONDS    0
 
-static const char TOPIC_DEVICE_TWIN_PREFIX[] = "$iothub/twin";
-static const char TOPIC_DEVICE_METHOD_PREFIX[] = "$iothub/methods";
-
 static const char* TOPIC_GET_DESIRED_STATE = "$iothub/twin/res/#";
 static const char* TOPIC_NOTIFICATION_STATE = "$iothub/twin/PATCH/properties/desired/#";
 
@@ -70,10 +74,6 @@ static const char* REPORTED_PROPERTIES_TOPIC = "$iothub/twin/PATCH/properties/re
 static const char* GET_PROPERTIES_TOPIC = "$iothub/twin/GET/?$rid=%"PRIu16;
 static const char* DEVICE_METHOD_RESPONSE_TOPIC = "$iothub/methods/res/%d/?$rid=%s";
 
-static const char* REQUEST_ID_PROPERTY = "?$rid=";
-
-static const char* MESSAGE_ID_PROPERTY = "mid";
-static const char* CORRELATION_ID_PROPERTY = "cid";
 static const char* CONTENT_TYPE_PROPERTY = "ct";
 static const char* CONTENT_ENCODING_PROPERTY = "ce";
 
@@ -87,23 +87,29 @@ static const char* CONTENT_ENCODING_PROPERTY = "ce";
 
 DEFINE_ENUM_STRINGS(MQTT_CLIENT_EVENT_ERROR, MQTT_CLIENT_EVENT_ERROR_VALUES)
 
+// Most topic property names and values fit; longer ones are decoded into a heap buffer instead.
+#define TOPIC_PROPERTY_BUFFER_SIZE          128
+
+typedef IOTHUB_MESSAGE_RESULT(*SYSTEM_PROPERTY_SETTER)(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* value);
+
 typedef struct SYSTEM_PROPERTY_INFO_TAG
 {
     const char* propName;
-    size_t propLength;
+    // NULL for the system properties that are not exposed on the IOTHUB_MESSAGE_HANDLE.
+    SYSTEM_PROPERTY_SETTER setProperty;
 } SYSTEM_PROPERTY_INFO;
 
-static SYSTEM_PROPERTY_INFO sysPropList[] = {
-    { "%24.exp", 7 },
-    { "%24.mid", 7 },
-    { "%24.uid", 7 },
-    { "%24.to", 6 },
-    { "%24.cid", 7 },
-    { "%24.ct", 6 },
-    { "%24.ce", 6 },
-    { "devices/", 8 },
-    { "iothub-operation", 16 },
-    { "iothub-ack", 10 }
+// Names as they are once URL-decoded.
+static const SYSTEM_PROPERTY_INFO sysPropList[] = {
+    { "$.exp", NULL },
+    { "$.mid", IoTHubMessage_SetMessageId },
+    { "$.uid", NULL },
+    { "$.to", NULL },
+    { "$.cid", IoTHubMessage_SetCorrelationId },
+    { "$.ct", IoTHubMessage_SetContentTypeSystemProperty },
+    { "$.ce", IoTHubMessage_SetContentEncodingSystemProperty },
+    { "iothub-operation", NULL },
+    { "iothub-ack", NULL }
 };
 
 typedef enum DEVICE_TWIN_MSG_TYPE_TAG
@@ -127,6 +133,14 @@ typedef enum MQTT_CLIENT_STATUS_TAG
     MQTT_CLIENT_STATUS_CONNECTED
 } MQTT_CLIENT_STATUS;
 
+typedef enum SAS_ROLLOVER_STATE_TAG
+{
+    SAS_ROLLOVER_IDLE,
+    SAS_ROLLOVER_CONNECTING,
+    SAS_ROLLOVER_CONNECTED,
+    SAS_ROLLOVER_FAILED
+} SAS_ROLLOVER_STATE;
+
 typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 {
     // Topic control
@@ -146,6 +160,8 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
     int portNum;
 
     MQTT_GET_IO_TRANSPORT get_io_transport;
+    // Replaces get_io_transport when create_io_transport is set (OPTION_MQTT_IO_FACTORY)
+    MQTT_TRANSPORT_IO_FACTORY io_factory;
 
     // The current mqtt iothub implementation requires that the hub name and the domain suffix be passed as the first of a series of segments
     // passed through the username portion of the connection frame.
@@ -162,6 +178,23 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
     MQTT_CLIENT_HANDLE mqttClient;
     XIO_HANDLE xioTransport;
 
+    // TLS sessions offered to each new xioTransport so reconnections can skip the full handshake
+    TLS_SESSION_CACHE_HANDLE tls_session_cache;
+    bool isTlsSessionStoreRejected;
+
+    // SAS token rollover: a second connection opened with a fresh token replaces mqttClient once it is accepted
+    MQTT_CLIENT_HANDLE rolloverMqttClient;
+    XIO_HANDLE rolloverXioTransport;
+    SAS_ROLLOVER_STATE sasRolloverState;
+    bool isSasRolloverSessionPresent;
+    tickcounter_ms_t sasRolloverConnectTime;
+    // Client being closed after a rollover; the events it raises while closing are ignored
+    MQTT_CLIENT_HANDLE retiringMqttClient;
+    // True when the connection uses a token created by the transport from the device key
+    bool isSasTokenRenewable;
+    size_t sasTokenRefreshSecs;
+    uint32_t sasTokenRefreshSeed;
+
     // Session - connection
     uint16_t packetId;
 
@@ -188,6 +221,10 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 
     // Telemetry specific
     DLIST_ENTRY telemetry_waitingForAck;
+    // Device method responses held while a SAS token rollover is in progress
+    DLIST_ENTRY heldMethodResponses;
+    // MQTT_MESSAGE_DETAILS_LIST records kept for reuse (OPTION_MESSAGE_POOL_SIZE)
+    SLAB message_details_slab;
 
     // Controls frequency of reconnection logic.
     RETRY_CONTROL_HANDLE retry_control_handle;
@@ -215,6 +252,12 @@ typedef struct MQTT_DEVICE_TWIN_ITEM_TAG
     DLIST_ENTRY entry;
 } MQTT_DEVICE_TWIN_ITEM;
 
+typedef struct MQTT_METHOD_RESPONSE_TAG
+{
+    MQTT_MESSAGE_HANDLE mqtt_msg;
+    DLIST_ENTRY entry;
+} MQTT_METHOD_RESPONSE;
+
 typedef struct MQTT_MESSAGE_DETAILS_LIST_TAG
 {
     tickcounter_ms_t msgPublishTime;
@@ -323,205 +366,6 @@ static const char* retrieve_mqtt_return_codes(CONNECT_RETURN_CODE rtn_code)
     }
 }
 
-static int retrieve_device_method_rid_info(const char* resp_topic, STRING_HANDLE method_name, STRING_HANDLE request_id)
-{
-    int result;
-    STRING_TOKENIZER_HANDLE token_handle = STRING_TOKENIZER_create_from_char(resp_topic);
-    if (token_handle == NULL)
-    {
-        LogError("Failed creating token from device twin topic.");
-        result = __FAILURE__;
-    }
-    else
-    {
-        STRING_HANDLE token_value;
-        if ((token_value = STRING_new()) == NULL)
-        {
-            LogError("Failed allocating new string .");
-            result = __FAILURE__;
-        }
-        else
-        {
-            size_t token_index = 0;
-            size_t request_id_length = strlen(REQUEST_ID_PROPERTY);
-            result = __FAILURE__;
-            while (STRING_TOKENIZER_get_next_token(token_handle, token_value, "/") == 0)
-            {
-                if (token_index == 3)
-                {
-                    if (STRING_concat_with_STRING(method_name, token_value) != 0)
-                    {
-                        LogError("Failed STRING_concat_with_STRING.");
-                        result = __FAILURE__;
-                        break;
-                    }
-                }
-                else if (token_index == 4)
-                {
-                    if (STRING_length(token_value) >= request_id_length)
-                    {
-                        const char* request_id_value = STRING_c_str(token_value);
-                        if (memcmp(request_id_value, REQUEST_ID_PROPERTY, request_id_length) == 0)
-                        {
-                            if (STRING_concat(request_id, request_id_value+request_id_length) != 0)
-                            {
-                                LogError("Failed STRING_concat failed.");
-                                result = __FAILURE__;
-                            }
-                            else
-                            {
-                                result = 0;
-                            }
-                            break;
-                        }
-                    }
-                }
-                token_index++;
-            }
-            STRING_delete(token_value);
-        }
-        STRING_TOKENIZER_destroy(token_handle);
-    }
-    return result;
-}
-
-static int parse_device_twin_topic_info(const char* resp_topic, bool* patch_msg, size_t* request_id, int* status_code)
-{
-    int result;
-    STRING_TOKENIZER_HANDLE token_handle = STRING_TOKENIZER_create_from_char(resp_topic);
-    if (token_handle == NULL)
-    {
-        LogError("Failed creating token from device twin topic.");
-        result = __FAILURE__;
-        *status_code = 0;
-        *request_id = 0;
-        *patch_msg = false;
-    }
-    else
-    {
-        STRING_HANDLE token_value;
-        if ((token_value = STRING_new()) == NULL)
-        {
-            LogError("Failed allocating new string .");
-            result = __FAILURE__;
-            *status_code = 0;
-            *request_id = 0;
-            *patch_msg = false;
-        }
-        else
-        {
-            result = __FAILURE__;
-            size_t token_count = 0;
-            while (STRING_TOKENIZER_get_next_token(token_handle, token_value, "/") == 0)
-            {
-                if (token_count == 2)
-                {
-                    if (strcmp(STRING_c_str(token_value), "PATCH") == 0)
-                    {
-                        *patch_msg = true;
-                        *status_code = 0;
-                        *request_id = 0;
-                        result = 0;
-                        break;
-                    }
-                    else
-                    {
-                        *patch_msg = false;
-                    }
-                }
-                else if (token_count == 3)
-                {
-                    *status_code = atol(STRING_c_str(token_value));
-                    if (STRING_TOKENIZER_get_next_token(token_handle, token_value, "/?$rid=") == 0)
-                    {
-                        *request_id = (size_t)atol(STRING_c_str(token_value));
-                    }
-                    *patch_msg = false;
-                    result = 0;
-                    break;
-                }
-                token_count++;
-            }
-            STRING_delete(token_value);
-        }
-        STRING_TOKENIZER_destroy(token_handle);
-    }
-    return result;
-}
-
-static IOTHUB_IDENTITY_TYPE retrieve_topic_type(const char* topic_resp)
-{
-    IOTHUB_IDENTITY_TYPE type;
-    size_t dev_twin_topic_len = sizeof(TOPIC_DEVICE_TWIN_PREFIX)-1;
-    size_t dev_method_topic_len = sizeof(TOPIC_DEVICE_METHOD_PREFIX)-1;
-    size_t topic_len = strlen(topic_resp);
-    size_t len_to_use = (dev_twin_topic_len > dev_method_topic_len) ? dev_twin_topic_len : dev_method_topic_len;
-
-    bool search_device_twin = true;
-    bool search_device_method = true;
-    if (topic_len < len_to_use)
-    {
-        search_device_twin = false;
-        search_device_method = false;
-    }
-    else
-    {
-        size_t index = 0;
-        for (index = 0; index < len_to_use && (search_device_twin || search_device_method); index++)
-        {
-            if (search_device_twin)
-            {
-                if (index > dev_twin_topic_len)
-                {
-                    search_device_twin = false;
-                }
-                else
-                {
-                    if (index == dev_twin_topic_len)
-                    {
-                        break;
-                    }
-                    else if (TOUPPER(TOPIC_DEVICE_TWIN_PREFIX[index]) != TOUPPER(topic_resp[index]))
-                    {
-                        search_device_twin = false;
-                    }
-                }
-            }
-            if (search_device_method)
-            {
-                if (index > dev_method_topic_len)
-                {
-                    search_device_method = false;
-                }
-                else
-                {
-                    if (index == dev_method_topic_len)
-                    {
-                        break;
-                    }
-                    else if (TOUPPER(TOPIC_DEVICE_METHOD_PREFIX[index]) != TOUPPER(topic_resp[index]))
-                    {
-                        search_device_method = false;
-                    }
-                }
-            }
-        }
-    }
-    if (search_device_twin)
-    {
-        type = IOTHUB_TYPE_DEVICE_TWIN;
-    }
-    else if (search_device_method)
-    {
-        type = IOTHUB_TYPE_DEVICE_METHODS;
-    }
-    else
-    {
-        type = IOTHUB_TYPE_TELEMETRY;
-    }
-    return type;
-}
-
 static void sendMsgComplete(IOTHUB_MESSAGE_LIST* iothubMsgList, PMQTTTRANSPORT_HANDLE_DATA transport_data, IOTHUB_CLIENT_CONFIRMATION_RESULT confirmResult)
 {
     DLIST_ENTRY messageCompleted;
@@ -695,6 +539,23 @@ static int publish_device_method_message(MQTTTRANSPORT_HANDLE_DATA* transport_da
             LogError("Failed constructing mqtt message.");
             result = __FAILURE__;
         }
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_037: [ While a SAS token rollover is in progress, device method responses shall be held and published by IoTHubTransport_MQTT_Common_DoWork once the connection in use is ready to publish again. ] */
+        else if (transport_data->sasRolloverState != SAS_ROLLOVER_IDLE)
+        {
+            MQTT_METHOD_RESPONSE* method_response = (MQTT_METHOD_RESPONSE*)malloc(sizeof(MQTT_METHOD_RESPONSE));
+            if (method_response == NULL)
+            {
+                LogError("Failed allocating the held device method response.");
+                mqttmessage_destroy(mqtt_get_msg);
+                result = __FAILURE__;
+            }
+            else
+            {
+                method_response->mqtt_msg = mqtt_get_msg;
+                DList_InsertTailList(&transport_data->heldMethodResponses, &method_response->entry);
+                result = 0;
+            }
+        }
         else
         {
             if (mqtt_client_publish(transport_data->mqttClient, mqtt_get_msg) != 0)
@@ -713,6 +574,25 @@ static int publish_device_method_message(MQTTTRANSPORT_HANDLE_DATA* transport_da
     return result;
 }
 
+// Publishes the device method responses held during a SAS token rollover, or only drops them when `publish` is false.
+static void release_held_device_method_messages(MQTTTRANSPORT_HANDLE_DATA* transport_data, bool publish)
+{
+    PDLIST_ENTRY currentListEntry = transport_data->heldMethodResponses.Flink;
+    while (currentListEntry != &transport_data->heldMethodResponses)
+    {
+        MQTT_METHOD_RESPONSE* method_response = containingRecord(currentListEntry, MQTT_METHOD_RESPONSE, entry);
+        currentListEntry = currentListEntry->Flink;
+
+        (void)DList_RemoveEntryList(&method_response->entry);
+        if (publish && mqtt_client_publish(transport_data->mqttClient, method_response->mqtt_msg) != 0)
+        {
+            LogError("Failed publishing a held device method response.");
+        }
+        mqttmessage_destroy(method_response->mqtt_msg);
+        free(method_response);
+    }
+}
+
 static int publish_device_twin_get_message(MQTTTRANSPORT_HANDLE_DATA* transport_data)
 {
     int result;
@@ -815,192 +695,130 @@ static int publish_device_twin_message(MQTTTRANSPORT_HANDLE_DATA* transport_data
     return result;
 }
 
-static bool isSystemProperty(const char* tokenData)
+static const SYSTEM_PROPERTY_INFO* findSystemProperty(const char* propName)
 {
-    bool result = false;
+    const SYSTEM_PROPERTY_INFO* result = NULL;
     size_t propCount = sizeof(sysPropList)/sizeof(sysPropList[0]);
     size_t index = 0;
     for (index = 0; index < propCount; index++)
     {
-        if (memcmp(tokenData, sysPropList[index].propName, sysPropList[index].propLength) == 0)
+        if (strcmp(propName, sysPropList[index].propName) == 0)
         {
-            result = true;
+            result = &sysPropList[index];
             break;
         }
     }
     return result;
 }
 
-static int extractMqttProperties(IOTHUB_MESSAGE_HANDLE IoTHubMessage, const char* topic_name)
+// Copies a topic slice, URL-decoded or as is, into `stackBuffer` if it fits and into a heap buffer otherwise.
+// The result must be released with releaseTopicSlice.
+static char* copyTopicSlice(const MQTT_TOPIC_SLICE* slice, bool urlDecode, char* stackBuffer, size_t stackBufferSize)
+{
+    char* result;
+    size_t bufferSize = slice->length + 1;
+
+    if (bufferSize <= stackBufferSize)
+    {
+        result = stackBuffer;
+    }
+    else if ((result = (char*)malloc(bufferSize)) == NULL)
+    {
+        LogError("Failed allocating %lu bytes for a topic property.", (unsigned long)bufferSize);
+    }
+
+    if (result != NULL)
+    {
+        if (!urlDecode)
+        {
+            (void)memcpy(result, slice->value, slice->length);
+            result[slice->length] = '\0';
+        }
+        else if (mqtt_topic_url_decode(slice, result, bufferSize) != 0)
+        {
+            LogError("Failed URL-decoding a topic property.");
+            if (result != stackBuffer)
+            {
+                free(result);
+            }
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void releaseTopicSlice(char* copy, char* stackBuffer)
+{
+    if (copy != stackBuffer)
+    {
+        free(copy);
+    }
+}
+
+static int extractMqttProperties(IOTHUB_MESSAGE_HANDLE IoTHubMessage, MQTT_TOPIC_SLICE properties)
 {
     int result;
-    STRING_HANDLE mqttTopic = STRING_construct(topic_name);
-    if (mqttTopic == NULL)
+    MAP_HANDLE propertyMap = IoTHubMessage_Properties(IoTHubMessage);
+    if (propertyMap == NULL)
     {
-        LogError("Failure constructing string topic name.");
+        LogError("Failure to retrieve IoTHubMessage_properties.");
         result = __FAILURE__;
     }
     else
     {
-        STRING_TOKENIZER_HANDLE token = STRING_TOKENIZER_create(mqttTopic);
-        if (token != NULL)
+        MQTT_TOPIC_SLICE name;
+        MQTT_TOPIC_SLICE value;
+        char nameBuffer[TOPIC_PROPERTY_BUFFER_SIZE];
+        char valueBuffer[TOPIC_PROPERTY_BUFFER_SIZE];
+
+        result = 0;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_029: [ The properties of a cloud-to-device message shall be read from the topic with mqtt_topic_get_next_property() and URL-decoded with mqtt_topic_url_decode() into stack buffers, or into heap buffers if they are longer than TOPIC_PROPERTY_BUFFER_SIZE - 1 characters. ] */
+        while (result == 0 && mqtt_topic_get_next_property(&properties, &name, &value) == 0)
         {
-            MAP_HANDLE propertyMap = IoTHubMessage_Properties(IoTHubMessage);
-            if (propertyMap == NULL)
-            {
-                LogError("Failure to retrieve IoTHubMessage_properties.");
-                result = __FAILURE__;
-            }
-            else
+            char* propName = NULL;
+            char* propValue = NULL;
+
+            // A name without '=' carries no value (e.g. "%24.cid" when the message has no correlation id), so there is nothing to set.
+            if (value.value != NULL)
             {
-                STRING_HANDLE output = STRING_new();
-                if (output == NULL)
+                if ((propName = copyTopicSlice(&name, true, nameBuffer, sizeof(nameBuffer))) == NULL ||
+                    (propValue = copyTopicSlice(&value, true, valueBuffer, sizeof(valueBuffer))) == NULL)
                 {
-                    LogError("Failure to allocate STRING_new.");
+                    LogError("Failed decoding property name (%p) and/or value (%p)", propName, propValue);
                     result = __FAILURE__;
                 }
                 else
                 {
-                    result = 0;
-
-                    while (STRING_TOKENIZER_get_next_token(token, output, PROPERTY_SEPARATOR) == 0 && result == 0)
+                    const SYSTEM_PROPERTY_INFO* sysProp = findSystemProperty(propName);
+                    if (sysProp != NULL)
                     {
-                        const char* tokenData = STRING_c_str(output);
-                        size_t tokenLen = strlen(tokenData);
-                        if (tokenData == NULL || tokenLen == 0)
+                        // Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_012: [ If type is IOTHUB_TYPE_TELEMETRY and the system property `$.ct` is defined, its value shall be set on the IOTHUB_MESSAGE_HANDLE's ContentType property ]
+                        // Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_013: [ If type is IOTHUB_TYPE_TELEMETRY and the system property `$.ce` is defined, its value shall be set on the IOTHUB_MESSAGE_HANDLE's ContentEncoding property ]
+                        if (sysProp->setProperty != NULL && sysProp->setProperty(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
                         {
-                            break;
-                        }
-                        else
-                        {
-                            if (isSystemProperty(tokenData))
-                            {
-                                const char* iterator = tokenData;
-                                while (iterator != NULL && *iterator != '\0' && result == 0)
-                                {
-                                    if (*iterator == '=')
-                                    {
-                                        size_t nameLen = iterator - tokenData;
-                                        char* propName = malloc(nameLen + 1);
-
-                                        size_t valLen = tokenLen - (nameLen + 1) + 1;
-                                        char* propValue = malloc(valLen + 1);
-
-                                        if (propName == NULL || propValue == NULL)
-                                        {
-                                            LogError("Failed allocating property name (%p) and/or value (%p)", propName, propValue);
-                                            result = __FAILURE__;
-                                        }
-                                        else
-                                        {
-                                            strncpy(propName, tokenData, nameLen);
-                                            propName[nameLen] = '\0';
-
-                                            strncpy(propValue, iterator + 1, valLen);
-                                            propValue[valLen] = '\0';
-
-                                            if (nameLen > 2)
-                                            {
-                                                if (nameLen > 3)
-                                                {
-                                                    if (strcmp((const char*)&propName[nameLen - 3], MESSAGE_ID_PROPERTY) == 0)
-                                                    {
-                                                        if (IoTHubMessage_SetMessageId(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
-                                                        {
-                                                            LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'messageId' property.");
-                                                            result = __FAILURE__;
-                                                        }
-                                                    }
-                                                    else if (strcmp((const char*)&propName[nameLen - 3], CORRELATION_ID_PROPERTY) == 0)
-                                                    {
-                                                        if (IoTHubMessage_SetCorrelationId(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
-                                                        {
-                                                            LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'correlationId' property.");
-                                                            result = __FAILURE__;
-                                                        }
-                                                    }
-                                                }
-
-                                                // Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_012: [ If type is IOTHUB_TYPE_TELEMETRY and the system property `$.ct` is defined, its value shall be set on the IOTHUB_MESSAGE_HANDLE's ContentType property ]
-                                                if (strcmp((const char*)&propName[nameLen - 2], CONTENT_TYPE_PROPERTY) == 0)
-                                                {
-                                                    if (IoTHubMessage_SetContentTypeSystemProperty(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
-                                                    {
-                                                        LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'customContentType' property.");
-                                                        result = __FAILURE__;
-                                                    }
-                                                }
-                                                // Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_013: [ If type is IOTHUB_TYPE_TELEMETRY and the system property `$.ce` is defined, its value shall be set on the IOTHUB_MESSAGE_HANDLE's ContentEncoding property ]
-                                                else if (strcmp((const char*)&propName[nameLen - 2], CONTENT_ENCODING_PROPERTY) == 0)
-                                                {
-                                                    if (IoTHubMessage_SetContentEncodingSystemProperty(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
-                                                    {
-                                                        LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'contentEncoding' property.");
-                                                        result = __FAILURE__;
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        free(propName);
-                                        free(propValue);
-
-                                        break;
-                                    }
-                                    iterator++;
-                                }
-                            }
-                            else
-                            {
-                                const char* iterator = tokenData;
-                                while (iterator != NULL && *iterator != '\0' && result == 0)
-                                {
-                                    if (*iterator == '=')
-                                    {
-                                        size_t nameLen = iterator - tokenData;
-                                        char* propName = malloc(nameLen + 1);
-
-                                        size_t valLen = tokenLen - (nameLen + 1) + 1;
-                                        char* propValue = malloc(valLen + 1);
-
-                                        if (propName == NULL || propValue == NULL)
-                                        {
-                                            result = __FAILURE__;
-                                        }
-                                        else
-                                        {
-                                            strncpy(propName, tokenData, nameLen);
-                                            propName[nameLen] = '\0';
-
-                                            strncpy(propValue, iterator + 1, valLen);
-                                            propValue[valLen] = '\0';
-
-                                            if (Map_AddOrUpdate(propertyMap, propName, propValue) != MAP_OK)
-                                            {
-                                                LogError("Map_AddOrUpdate failed.");
-                                                result = __FAILURE__;
-                                            }
-                                        }
-                                        free(propName);
-                                        free(propValue);
-
-                                        break;
-                                    }
-                                    iterator++;
-                                }
-                            }
+                            LogError("Failed to set IOTHUB_MESSAGE_HANDLE '%s' property.", propName);
+                            result = __FAILURE__;
                         }
                     }
-                    STRING_delete(output);
+                    else if (Map_AddOrUpdate(propertyMap, propName, propValue) != MAP_OK)
+                    {
+                        LogError("Map_AddOrUpdate failed.");
+                        result = __FAILURE__;
+                    }
+                }
+
+                if (propName != NULL)
+                {
+                    releaseTopicSlice(propName, nameBuffer);
+                }
+                if (propValue != NULL)
+                {
+                    releaseTopicSlice(propValue, valueBuffer);
                 }
             }
-            STRING_TOKENIZER_destroy(token);
-        }
-        else
-        {
-            LogError("Unable to create Tokenizer object.");
-            result = __FAILURE__;
         }
-        STRING_delete(mqttTopic);
     }
     return result;
 }
@@ -1019,94 +837,79 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
         else
         {
             PMQTTTRANSPORT_HANDLE_DATA transportData = (PMQTTTRANSPORT_HANDLE_DATA)callbackCtx;
+            MQTT_TOPIC_INFO topic_info;
 
-            IOTHUB_IDENTITY_TYPE type = retrieve_topic_type(topic_resp);
-            if (type == IOTHUB_TYPE_DEVICE_TWIN)
+            if (mqtt_topic_parse(topic_resp, &topic_info) != 0)
             {
-                size_t request_id;
-                int status_code;
-                bool notification_msg;
-                if (parse_device_twin_topic_info(topic_resp, &notification_msg, &request_id, &status_code) != 0)
-                {
-                    LogError("Failure: parsing device topic info");
-                }
-                else
+                LogError("Failure: parsing topic %s", topic_resp);
+            }
+            else if (topic_info.type == MQTT_TOPIC_TYPE_TWIN_DESIRED_PATCH)
+            {
+                const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
+                IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_PARTIAL, payload->message, payload->length);
+            }
+            else if (topic_info.type == MQTT_TOPIC_TYPE_TWIN_RESPONSE)
+            {
+                const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
+                PDLIST_ENTRY dev_twin_item = transportData->ack_waiting_queue.Flink;
+                while (dev_twin_item != &transportData->ack_waiting_queue)
                 {
-                    const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
-                    if (notification_msg)
-                    {
-                        IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_PARTIAL, payload->message, payload->length);
-                    }
-                    else
+                    DLIST_ENTRY saveListEntry;
+                    saveListEntry.Flink = dev_twin_item->Flink;
+                    MQTT_DEVICE_TWIN_ITEM* msg_entry = containingRecord(dev_twin_item, MQTT_DEVICE_TWIN_ITEM, entry);
+                    if (topic_info.twin_request_id == msg_entry->packet_id)
                     {
-                        PDLIST_ENTRY dev_twin_item = transportData->ack_waiting_queue.Flink;
-                        while (dev_twin_item != &transportData->ack_waiting_queue)
+                        (void)DList_RemoveEntryList(dev_twin_item);
+                        if (msg_entry->device_twin_msg_type == RETRIEVE_PROPERTIES)
                         {
-                            DLIST_ENTRY saveListEntry;
-                            saveListEntry.Flink = dev_twin_item->Flink;
-                            MQTT_DEVICE_TWIN_ITEM* msg_entry = containingRecord(dev_twin_item, MQTT_DEVICE_TWIN_ITEM, entry);
-                            if (request_id == msg_entry->packet_id)
-                            {
-                                (void)DList_RemoveEntryList(dev_twin_item);
-                                if (msg_entry->device_twin_msg_type == RETRIEVE_PROPERTIES)
-                                {
-                                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_054: [ If type is IOTHUB_TYPE_DEVICE_TWIN, then on success if msg_type is RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_RetrievePropertyComplete... ] */
-                                    IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_COMPLETE, payload->message, payload->length);
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_055: [ if device_twin_msg_type is not RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_ReportedStateComplete ] */
-                                    IoTHubClient_LL_ReportedStateComplete(transportData->llClientHandle, msg_entry->iothub_msg_id, status_code);
-                                }
-                                free(msg_entry);
-                                break;
-                            }
-                            dev_twin_item = saveListEntry.Flink;
+                            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_054: [ If type is IOTHUB_TYPE_DEVICE_TWIN, then on success if msg_type is RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_RetrievePropertyComplete... ] */
+                            IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_COMPLETE, payload->message, payload->length);
+                        }
+                        else
+                        {
+                            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_055: [ if device_twin_msg_type is not RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_ReportedStateComplete ] */
+                            IoTHubClient_LL_ReportedStateComplete(transportData->llClientHandle, msg_entry->iothub_msg_id, topic_info.status_code);
                         }
+                        free(msg_entry);
+                        break;
                     }
+                    dev_twin_item = saveListEntry.Flink;
                 }
             }
-            else if (type == IOTHUB_TYPE_DEVICE_METHODS)
+            else if (topic_info.type == MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST)
             {
-                STRING_HANDLE method_name = STRING_new();
-                if (method_name == NULL)
+                DEVICE_METHOD_INFO* dev_method_info = malloc(sizeof(DEVICE_METHOD_INFO));
+                if (dev_method_info == NULL)
                 {
-                    LogError("Failure: allocating method_name string value");
+                    LogError("Failure: allocating DEVICE_METHOD_INFO object");
+                }
+                else if ((dev_method_info->request_id = STRING_construct_n(topic_info.request_id.value, topic_info.request_id.length)) == NULL)
+                {
+                    LogError("Failure constructing request_id string");
+                    free(dev_method_info);
                 }
                 else
                 {
-                    DEVICE_METHOD_INFO* dev_method_info = malloc(sizeof(DEVICE_METHOD_INFO) );
-                    if (dev_method_info == NULL)
+                    char methodNameBuffer[TOPIC_PROPERTY_BUFFER_SIZE];
+                    char* method_name = copyTopicSlice(&topic_info.method_name, false, methodNameBuffer, sizeof(methodNameBuffer));
+                    if (method_name == NULL)
                     {
-                        LogError("Failure: allocating DEVICE_METHOD_INFO object");
+                        LogError("Failure: copying method name");
+                        STRING_delete(dev_method_info->request_id);
+                        free(dev_method_info);
                     }
                     else
                     {
-                        dev_method_info->request_id = STRING_new();
-                        if (dev_method_info->request_id == NULL)
+                        /* CodesSRS_IOTHUB_MQTT_TRANSPORT_07_053: [ If type is IOTHUB_TYPE_DEVICE_METHODS, then on success mqtt_notification_callback shall call IoTHubClient_LL_DeviceMethodComplete. ] */
+                        const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
+                        if (IoTHubClient_LL_DeviceMethodComplete(transportData->llClientHandle, method_name, payload->message, payload->length, (void*)dev_method_info) != 0)
                         {
-                            LogError("Failure constructing request_id string");
-                            free(dev_method_info);
-                        }
-                        else if (retrieve_device_method_rid_info(topic_resp, method_name, dev_method_info->request_id) != 0)
-                        {
-                            LogError("Failure: retrieve device topic info");
+                            LogError("Failure: IoTHubClient_LL_DeviceMethodComplete");
                             STRING_delete(dev_method_info->request_id);
                             free(dev_method_info);
                         }
-                        else
-                        {
-                            /* CodesSRS_IOTHUB_MQTT_TRANSPORT_07_053: [ If type is IOTHUB_TYPE_DEVICE_METHODS, then on success mqtt_notification_callback shall call IoTHubClient_LL_DeviceMethodComplete. ] */
-                            const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
-                            if (IoTHubClient_LL_DeviceMethodComplete(transportData->llClientHandle, STRING_c_str(method_name), payload->message, payload->length, (void*)dev_method_info) != 0)
-                            {
-                                LogError("Failure: IoTHubClient_LL_DeviceMethodComplete");
-                                STRING_delete(dev_method_info->request_id);
-                                free(dev_method_info);
-                            }
-                        }
+                        releaseTopicSlice(method_name, methodNameBuffer);
                     }
-                    STRING_delete(method_name);
                 }
             }
             else
@@ -1120,7 +923,7 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
                 else
                 {
                     // Will need to update this when the service has messages that can be rejected
-                    if (extractMqttProperties(IoTHubMessage, topic_resp) != 0)
+                    if (extractMqttProperties(IoTHubMessage, topic_info.properties) != 0)
                     {
                         LogError("failure extracting mqtt properties.");
                     }
@@ -1152,10 +955,68 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
     }
 }
 
+static bool IsSasTokenRolloverEvent(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_CLIENT_HANDLE handle, bool isConnectionLost)
+{
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_025: [ While a rollover is in progress, the loss of the current connection shall not be reported and shall not trigger a reconnection. ] */
+    return (handle != NULL && (handle == transport_data->rolloverMqttClient || handle == transport_data->retiringMqttClient)) ||
+        (isConnectionLost && transport_data->sasRolloverState != SAS_ROLLOVER_IDLE);
+}
+
+static void OnSasTokenRolloverConnack(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_CLIENT_HANDLE handle, const CONNECT_ACK* connack)
+{
+    if (handle == transport_data->rolloverMqttClient && transport_data->sasRolloverState == SAS_ROLLOVER_CONNECTING)
+    {
+        if (connack == NULL)
+        {
+            LogError("MQTT_CLIENT_ON_CONNACK CONNACK parameter is NULL.");
+            transport_data->sasRolloverState = SAS_ROLLOVER_FAILED;
+        }
+        else if (connack->returnCode == CONNECTION_ACCEPTED)
+        {
+            transport_data->sasRolloverState = SAS_ROLLOVER_CONNECTED;
+            transport_data->isSasRolloverSessionPresent = connack->isSessionPresent;
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_023: [ If the new connection is refused, fails or is not accepted within `keepalive` seconds, it shall be closed and IoTHubTransport_MQTT_Common_DoWork shall disconnect and reconnect as described in SRS_IOTHUB_TRANSPORT_MQTT_COMMON_07_058. ] */
+            LogError("SAS token rollover connection not accepted: 0x%x: %s", connack->returnCode, retrieve_mqtt_return_codes(connack->returnCode));
+            transport_data->sasRolloverState = SAS_ROLLOVER_FAILED;
+        }
+    }
+}
+
+static void OnSasTokenRolloverConnectionLost(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_CLIENT_HANDLE handle)
+{
+    if (handle != NULL && handle == transport_data->rolloverMqttClient)
+    {
+        if (transport_data->sasRolloverState != SAS_ROLLOVER_IDLE)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_023: [ If the new connection is refused, fails or is not accepted within `keepalive` seconds, it shall be closed and IoTHubTransport_MQTT_Common_DoWork shall disconnect and reconnect as described in SRS_IOTHUB_TRANSPORT_MQTT_COMMON_07_058. ] */
+            LogError("SAS token rollover connection failed.");
+            transport_data->sasRolloverState = SAS_ROLLOVER_FAILED;
+        }
+    }
+    else if (handle == NULL || handle != transport_data->retiringMqttClient)
+    {
+        // IoT Hub closes the current connection as soon as the one with the new token is open
+        LogInfo("Connection closed during the SAS token rollover.");
+    }
+}
+
 static void mqtt_operation_complete_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT_EVENT_RESULT actionResult, const void* msgInfo, void* callbackCtx)
 {
-    (void)handle;
-    if (callbackCtx != NULL)
+    if (callbackCtx != NULL && IsSasTokenRolloverEvent((PMQTTTRANSPORT_HANDLE_DATA)callbackCtx, handle, actionResult == MQTT_CLIENT_ON_DISCONNECT))
+    {
+        if (actionResult == MQTT_CLIENT_ON_CONNACK)
+        {
+            OnSasTokenRolloverConnack((PMQTTTRANSPORT_HANDLE_DATA)callbackCtx, handle, (const CONNECT_ACK*)msgInfo);
+        }
+        else if (actionResult == MQTT_CLIENT_ON_DISCONNECT)
+        {
+            OnSasTokenRolloverConnectionLost((PMQTTTRANSPORT_HANDLE_DATA)callbackCtx, handle);
+        }
+    }
+    else if (callbackCtx != NULL)
     {
         PMQTTTRANSPORT_HANDLE_DATA transport_data = (PMQTTTRANSPORT_HANDLE_DATA)callbackCtx;
 
@@ -1178,7 +1039,7 @@ static void mqtt_operation_complete_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLI
                         {
                             (void)DList_RemoveEntryList(currentListEntry); //First remove the item from Waiting for Ack List.
                             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
-                            free(mqttMsgEntry);
+                            slab_free(&(transport_data->message_details_slab), mqttMsgEntry);
                         }
                         currentListEntry = saveListEntry.Flink;
                     }
@@ -1278,8 +1139,23 @@ static void mqtt_operation_complete_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLI
     }
 }
 
+static void AbortSasTokenRollover(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    transport_data->sasRolloverState = SAS_ROLLOVER_IDLE;
+    if (transport_data->rolloverMqttClient != NULL)
+    {
+        (void)mqtt_client_disconnect(transport_data->rolloverMqttClient);
+        xio_destroy(transport_data->rolloverXioTransport);
+        mqtt_client_deinit(transport_data->rolloverMqttClient);
+        transport_data->rolloverMqttClient = NULL;
+        transport_data->rolloverXioTransport = NULL;
+    }
+}
+
 static void DisconnectFromClient(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 {
+    AbortSasTokenRollover(transport_data);
+
     (void)mqtt_client_disconnect(transport_data->mqttClient);
     xio_destroy(transport_data->xioTransport);
     transport_data->xioTransport = NULL;
@@ -1290,8 +1166,12 @@ static void DisconnectFromClient(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 
 static void mqtt_error_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT_EVENT_ERROR error, void* callbackCtx)
 {
-    (void)handle;
-    if (callbackCtx != NULL)
+    if (callbackCtx != NULL && IsSasTokenRolloverEvent((PMQTTTRANSPORT_HANDLE_DATA)callbackCtx, handle, true))
+    {
+        LogInfo("MQTT error %s ignored during the SAS token rollover", ENUM_TO_STRING(MQTT_CLIENT_EVENT_ERROR, error));
+        OnSasTokenRolloverConnectionLost((PMQTTTRANSPORT_HANDLE_DATA)callbackCtx, handle);
+    }
+    else if (callbackCtx != NULL)
     {
         PMQTTTRANSPORT_HANDLE_DATA transport_data = (PMQTTTRANSPORT_HANDLE_DATA)callbackCtx;
         switch (error)
@@ -1446,27 +1326,77 @@ static const unsigned char* RetrieveMessagePayload(IOTHUB_MESSAGE_HANDLE message
     return result;
 }
 
+static void SetTlsSessionStore(PMQTTTRANSPORT_HANDLE_DATA transport_data, XIO_HANDLE xioTransport, const char* hostAddress)
+{
+    if (!transport_data->isTlsSessionStoreRejected)
+    {
+        const TLS_SESSION_STORE* tls_session_store;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_014: [ If the TLS session cache has not been created, it shall be created using tls_session_cache_create(). ] */
+        if (transport_data->tls_session_cache == NULL &&
+            (transport_data->tls_session_cache = tls_session_cache_create()) == NULL)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_016: [ If tls_session_cache_create(), tls_session_cache_get_store() or xio_setoption() fail, the failure shall be ignored. ] */
+            LogError("Failed creating the TLS session cache; the TLS handshake will not be resumed.");
+        }
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_015: [ Each new xioTransport shall be given the TLS session store for the host address, obtained with tls_session_cache_get_store(), using xio_setoption() with OPTION_TLS_SESSION_STORE. ] */
+        else if ((tls_session_store = tls_session_cache_get_store(transport_data->tls_session_cache, hostAddress)) == NULL)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_016: [ If tls_session_cache_create(), tls_session_cache_get_store() or xio_setoption() fail, the failure shall be ignored. ] */
+            LogError("Failed obtaining the TLS session store; the TLS handshake will not be resumed.");
+        }
+        else if (xio_setoption(xioTransport, OPTION_TLS_SESSION_STORE, tls_session_store) != 0)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_016: [ If tls_session_cache_create(), tls_session_cache_get_store() or xio_setoption() fail, the failure shall be ignored. ] */
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_017: [ If xio_setoption() fails, the TLS session store shall not be set on subsequent xioTransport instances. ] */
+            LogInfo("TLS I/O does not support session resumption; reconnections will use full TLS handshakes.");
+            transport_data->isTlsSessionStoreRejected = true;
+        }
+    }
+}
+
+static XIO_HANDLE CreateXioTransport(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    XIO_HANDLE result;
+    // construct address
+    const char* hostAddress = STRING_c_str(transport_data->hostAddress);
+    MQTT_TRANSPORT_PROXY_OPTIONS mqtt_proxy_options;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_01_011: [ If no `proxy_data` option has been set, NULL shall be passed as the argument `mqtt_transport_proxy_options` when calling the function `get_io_transport` passed in `IoTHubTransport_MQTT_Common__Create`. ]*/
+    mqtt_proxy_options.host_address = transport_data->http_proxy_hostname;
+    mqtt_proxy_options.port = transport_data->http_proxy_port;
+    mqtt_proxy_options.username = transport_data->http_proxy_username;
+    mqtt_proxy_options.password = transport_data->http_proxy_password;
+
+    if (transport_data->io_factory.create_io_transport != NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_032: [ Once `mqtt_io_factory` has been set, every new xioTransport shall be created by calling its `create_io_transport` with its `context` and the host address, instead of `get_io_transport`. ] */
+        result = transport_data->io_factory.create_io_transport(transport_data->io_factory.context, hostAddress);
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_01_010: [ If the `proxy_data` option has been set, the proxy options shall be filled in the argument `mqtt_transport_proxy_options` when calling the function `get_io_transport` passed in `IoTHubTransport_MQTT_Common__Create` to obtain the underlying IO handle. ]*/
+        result = transport_data->get_io_transport(hostAddress, (transport_data->http_proxy_hostname == NULL) ? NULL : &mqtt_proxy_options);
+    }
+    if (result == NULL)
+    {
+        LogError("Unable to create the lower level TLS layer.");
+    }
+    else
+    {
+        SetTlsSessionStore(transport_data, result, hostAddress);
+    }
+    return result;
+}
+
 static int GetTransportProviderIfNecessary(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 {
     int result;
 
     if (transport_data->xioTransport == NULL)
     {
-        // construct address
-        const char* hostAddress = STRING_c_str(transport_data->hostAddress);
-        MQTT_TRANSPORT_PROXY_OPTIONS mqtt_proxy_options;
-
-        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_01_011: [ If no `proxy_data` option has been set, NULL shall be passed as the argument `mqtt_transport_proxy_options` when calling the function `get_io_transport` passed in `IoTHubTransport_MQTT_Common__Create`. ]*/
-        mqtt_proxy_options.host_address = transport_data->http_proxy_hostname;
-        mqtt_proxy_options.port = transport_data->http_proxy_port;
-        mqtt_proxy_options.username = transport_data->http_proxy_username;
-        mqtt_proxy_options.password = transport_data->http_proxy_password;
-
-        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_01_010: [ If the `proxy_data` option has been set, the proxy options shall be filled in the argument `mqtt_transport_proxy_options` when calling the function `get_io_transport` passed in `IoTHubTransport_MQTT_Common__Create` to obtain the underlying IO handle. ]*/
-        transport_data->xioTransport = transport_data->get_io_transport(hostAddress, (transport_data->http_proxy_hostname == NULL) ? NULL : &mqtt_proxy_options);
-        if (transport_data->xioTransport == NULL)
+        if ((transport_data->xioTransport = CreateXioTransport(transport_data)) == NULL)
         {
-            LogError("Unable to create the lower level TLS layer.");
             result = __FAILURE__;
         }
         else
@@ -1481,7 +1411,17 @@ static int GetTransportProviderIfNecessary(PMQTTTRANSPORT_HANDLE_DATA transport_
     return result;
 }
 
-static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+static void ScheduleSasTokenRefresh(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_018: [ The SAS token of each connection shall be refreshed after a random number of seconds between SAS_TOKEN_DEFAULT_LIFETIME * (SAS_REFRESH_MULTIPLIER - SAS_REFRESH_JITTER_MULTIPLIER) and SAS_TOKEN_DEFAULT_LIFETIME * SAS_REFRESH_MULTIPLIER, derived from rand() and the device id. ] */
+    // rand() alone is not enough: devices powered up in the same second seed it with the same time.
+    size_t jitter_range = (size_t)(SAS_TOKEN_DEFAULT_LIFETIME * SAS_REFRESH_JITTER_MULTIPLIER);
+    size_t jitter = (size_t)(((uint32_t)rand() ^ transport_data->sasTokenRefreshSeed) % jitter_range);
+
+    transport_data->sasTokenRefreshSecs = (size_t)(SAS_TOKEN_DEFAULT_LIFETIME * SAS_REFRESH_MULTIPLIER) - jitter;
+}
+
+static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, bool isSasTokenRollover)
 {
     int result;
 
@@ -1575,7 +1515,21 @@ static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
         options.useCleanSession = false;
         options.qualityOfServiceValue = DELIVER_AT_LEAST_ONCE;
 
-        if (GetTransportProviderIfNecessary(transport_data) == 0)
+        if (isSasTokenRollover)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_021: [ The new connection shall be opened with mqtt_client_connect() and a SAS token created from the device key, while the current connection keeps running. ] */
+            if (mqtt_client_connect(transport_data->rolloverMqttClient, transport_data->rolloverXioTransport, &options) != 0)
+            {
+                LogError("failure connecting to address %s.", STRING_c_str(transport_data->hostAddress));
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)tickcounter_get_current_ms(transport_data->msgTickCounter, &transport_data->sasRolloverConnectTime);
+                result = 0;
+            }
+        }
+        else if (GetTransportProviderIfNecessary(transport_data) == 0)
         {
             if (mqtt_client_connect(transport_data->mqttClient, transport_data->xioTransport, &options) != 0)
             {
@@ -1585,6 +1539,8 @@ static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
             else
             {
                 (void)tickcounter_get_current_ms(transport_data->msgTickCounter, &transport_data->mqtt_connect_time);
+                transport_data->isSasTokenRenewable = (cred_type == IOTHUB_CREDENTIAL_TYPE_DEVICE_KEY);
+                ScheduleSasTokenRefresh(transport_data);
                 result = 0;
             }
         }
@@ -1601,6 +1557,125 @@ static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data)
     return result;
 }
 
+static int StartSasTokenRollover(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    int result;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_020: [ The SAS token rollover shall create a new xioTransport with get_io_transport, with the TLS session store and the options retrieved from the current xioTransport with xio_retrieveoptions, and a new mqtt client with mqtt_client_init. ] */
+    if ((transport_data->rolloverXioTransport = CreateXioTransport(transport_data)) == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        OPTIONHANDLER_HANDLE xio_options = xio_retrieveoptions(transport_data->xioTransport);
+        if (xio_options != NULL && OptionHandler_FeedOptions(xio_options, transport_data->rolloverXioTransport) != OPTIONHANDLER_OK)
+        {
+            LogError("Failed copying the TLS options to the SAS token rollover connection.");
+            xio_destroy(transport_data->rolloverXioTransport);
+            transport_data->rolloverXioTransport = NULL;
+            result = __FAILURE__;
+        }
+        else if ((transport_data->rolloverMqttClient = mqtt_client_init(mqtt_notification_callback, mqtt_operation_complete_callback, transport_data, mqtt_error_callback, transport_data)) == NULL)
+        {
+            LogError("failure initializing the SAS token rollover mqtt client.");
+            xio_destroy(transport_data->rolloverXioTransport);
+            transport_data->rolloverXioTransport = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            mqtt_client_set_trace(transport_data->rolloverMqttClient, transport_data->log_trace, transport_data->raw_trace);
+            transport_data->sasRolloverState = SAS_ROLLOVER_CONNECTING;
+
+            if (SendMqttConnectMsg(transport_data, true) != 0)
+            {
+                AbortSasTokenRollover(transport_data);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+
+        if (xio_options != NULL)
+        {
+            OptionHandler_Destroy(xio_options);
+        }
+    }
+    return result;
+}
+
+static void CompleteSasTokenRollover(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    MQTT_CLIENT_HANDLE previousMqttClient = transport_data->mqttClient;
+    XIO_HANDLE previousXioTransport = transport_data->xioTransport;
+    PDLIST_ENTRY currentListEntry;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_022: [ Once the new connection is accepted, it shall replace the current connection, which shall then be closed with mqtt_client_disconnect(), xio_destroy() and mqtt_client_deinit(). ] */
+    transport_data->mqttClient = transport_data->rolloverMqttClient;
+    transport_data->xioTransport = transport_data->rolloverXioTransport;
+    transport_data->mqtt_connect_time = transport_data->sasRolloverConnectTime;
+    transport_data->rolloverMqttClient = NULL;
+    transport_data->rolloverXioTransport = NULL;
+    transport_data->sasRolloverState = SAS_ROLLOVER_IDLE;
+    ScheduleSasTokenRefresh(transport_data);
+
+    transport_data->retiringMqttClient = previousMqttClient;
+    (void)mqtt_client_disconnect(previousMqttClient);
+    xio_destroy(previousXioTransport);
+    mqtt_client_deinit(previousMqttClient);
+    transport_data->retiringMqttClient = NULL;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_024: [ If IoT Hub did not keep the session of the device, the topics shall be subscribed to again and the device twin shall be retrieved again; otherwise the subscriptions shall be kept. ] */
+    if (!transport_data->isSasRolloverSessionPresent)
+    {
+        transport_data->device_twin_get_sent = false;
+        if (transport_data->topic_MqttMessage != NULL)
+        {
+            transport_data->topics_ToSubscribe |= SUBSCRIBE_TELEMETRY_TOPIC;
+        }
+        if (transport_data->topic_GetState != NULL)
+        {
+            transport_data->topics_ToSubscribe |= SUBSCRIBE_GET_REPORTED_STATE_TOPIC;
+        }
+        if (transport_data->topic_NotifyState != NULL)
+        {
+            transport_data->topics_ToSubscribe |= SUBSCRIBE_NOTIFICATION_STATE_TOPIC;
+        }
+        if (transport_data->topic_DeviceMethods != NULL)
+        {
+            transport_data->topics_ToSubscribe |= SUBSCRIBE_DEVICE_METHOD_TOPIC;
+        }
+        transport_data->currPacketState = CONNACK_TYPE;
+    }
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_026: [ The telemetry messages waiting for acknowledgement shall be published again on the new connection right away, with their retry count reset. ] */
+    currentListEntry = transport_data->telemetry_waitingForAck.Flink;
+    while (currentListEntry != &transport_data->telemetry_waitingForAck)
+    {
+        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentListEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
+        DLIST_ENTRY nextListEntry;
+        size_t messageLength;
+        const unsigned char* messagePayload = RetrieveMessagePayload(mqttMsgEntry->iotHubMessageEntry->messageHandle, &messageLength);
+        nextListEntry.Flink = currentListEntry->Flink;
+
+        mqttMsgEntry->retryCount = 0;
+        if (messageLength == 0 || messagePayload == NULL)
+        {
+            LogError("Failure from creating Message IoTHubMessage_GetData");
+        }
+        else if (publish_mqtt_telemetry_msg(transport_data, mqttMsgEntry, messagePayload, messageLength) != 0)
+        {
+            (void)DList_RemoveEntryList(currentListEntry);
+            sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+            slab_free(&(transport_data->message_details_slab), mqttMsgEntry);
+        }
+        currentListEntry = nextListEntry.Flink;
+    }
+}
+
 static int InitializeConnection(PMQTTTRANSPORT_HANDLE_DATA transport_data)
 {
     int result = 0;
@@ -1623,7 +1698,7 @@ static int InitializeConnection(PMQTTTRANSPORT_HANDLE_DATA transport_data)
             }
             else
             {
-                if (SendMqttConnectMsg(transport_data) != 0)
+                if (SendMqttConnectMsg(transport_data, false) != 0)
                 {
                     transport_data->connectFailCount++;
                     result = __FAILURE__;
@@ -1663,7 +1738,38 @@ static int InitializeConnection(PMQTTTRANSPORT_HANDLE_DATA transport_data)
             }
             else
             {
-                if ((current_time - transport_data->mqtt_connect_time) / 1000 > (SAS_TOKEN_DEFAULT_LIFETIME*SAS_REFRESH_MULTIPLIER))
+                tickcounter_ms_t connected_secs = (current_time - transport_data->mqtt_connect_time) / 1000;
+                bool isReconnectNeeded = false;
+
+                if (transport_data->sasRolloverState == SAS_ROLLOVER_CONNECTED)
+                {
+                    CompleteSasTokenRollover(transport_data);
+                }
+                else if (transport_data->sasRolloverState == SAS_ROLLOVER_FAILED ||
+                    (transport_data->sasRolloverState == SAS_ROLLOVER_CONNECTING &&
+                    ((current_time - transport_data->sasRolloverConnectTime) / 1000 > transport_data->keepAliveValue || connected_secs >= SAS_TOKEN_DEFAULT_LIFETIME)))
+                {
+                    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_023: [ If the new connection is refused, fails or is not accepted within `keepalive` seconds, it shall be closed and IoTHubTransport_MQTT_Common_DoWork shall disconnect and reconnect as described in SRS_IOTHUB_TRANSPORT_MQTT_COMMON_07_058. ] */
+                    LogError("SAS token rollover failed; reconnecting.");
+                    AbortSasTokenRollover(transport_data);
+                    isReconnectNeeded = true;
+                }
+                else if (transport_data->sasRolloverState == SAS_ROLLOVER_IDLE && connected_secs > transport_data->sasTokenRefreshSecs)
+                {
+                    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_019: [ When the refresh time is reached, if the SAS token was created from the device key and has not expired yet, IoTHubTransport_MQTT_Common_DoWork shall refresh it without dropping the connection, once no subscription is pending, by opening a second connection with a new SAS token before closing the current one; otherwise it shall disconnect as described in SRS_IOTHUB_TRANSPORT_MQTT_COMMON_07_058. ] */
+                    if (!transport_data->isSasTokenRenewable || connected_secs >= SAS_TOKEN_DEFAULT_LIFETIME)
+                    {
+                        isReconnectNeeded = true;
+                    }
+                    // The rollover waits for pending subscriptions to complete
+                    else if (transport_data->currPacketState == PUBLISH_TYPE && StartSasTokenRollover(transport_data) != 0)
+                    {
+                        LogError("Failed starting the SAS token rollover; reconnecting.");
+                        isReconnectNeeded = true;
+                    }
+                }
+
+                if (isReconnectNeeded)
                 {
                     /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_07_058: [ If the sas token has timed out IoTHubTransport_MQTT_Common_DoWork shall disconnect from the mqtt client and destroy the transport information and wait for reconnect. ] */
                     (void)mqtt_client_disconnect(transport_data->mqttClient);
@@ -1809,6 +1915,9 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_010: [IoTHubTransport_MQTT_Common_Create shall allocate memory to save its internal state where all topics, hostname, device_id, device_key, sasTokenSr and client handle shall be saved.] */
                         DList_InitializeListHead(&(state->telemetry_waitingForAck));
                         DList_InitializeListHead(&(state->ack_waiting_queue));
+                        DList_InitializeListHead(&(state->heldMethodResponses));
+                        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_033: [ IoTHubTransport_MQTT_Common_Create shall initialize the slab of the MQTT_MESSAGE_DETAILS_LIST records with no record kept for reuse. ] */
+                        slab_init(&(state->message_details_slab), sizeof(MQTT_MESSAGE_DETAILS_LIST), 0);
                         state->isDestroyCalled = false;
                         state->isRegistered = false;
                         state->mqttClientStatus = MQTT_CLIENT_STATUS_NOT_CONNECTED;
@@ -1817,6 +1926,17 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                         state->packetId = 1;
                         state->llClientHandle = NULL;
                         state->xioTransport = NULL;
+                        state->tls_session_cache = NULL;
+                        state->isTlsSessionStoreRejected = false;
+                        state->rolloverMqttClient = NULL;
+                        state->rolloverXioTransport = NULL;
+                        state->io_factory.create_io_transport = NULL;
+                        state->io_factory.context = NULL;
+                        state->sasRolloverState = SAS_ROLLOVER_IDLE;
+                        state->retiringMqttClient = NULL;
+                        state->isSasTokenRenewable = false;
+                        state->sasTokenRefreshSecs = (size_t)(SAS_TOKEN_DEFAULT_LIFETIME * SAS_REFRESH_MULTIPLIER);
+                        state->sasTokenRefreshSeed = hash_fnv1a(upperConfig->deviceId);
                         state->portNum = 0;
                         state->waitingToSend = waitingToSend;
                         state->currPacketState = CONNECT_TYPE;
@@ -1933,7 +2053,7 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
             PDLIST_ENTRY currentEntry = DList_RemoveHeadList(&transport_data->telemetry_waitingForAck);
             MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
-            free(mqttMsgEntry);
+            slab_free(&(transport_data->message_details_slab), mqttMsgEntry);
         }
         while (!DList_IsListEmpty(&transport_data->ack_waiting_queue))
         {
@@ -1942,6 +2062,7 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
             IoTHubClient_LL_ReportedStateComplete(transport_data->llClientHandle, mqtt_device_twin->iothub_msg_id, STATUS_CODE_TIMEOUT_VALUE);
             free(mqtt_device_twin);
         }
+        release_held_device_method_messages(transport_data, false);
 
         STRING_delete(transport_data->devicesPath);
 
@@ -1958,6 +2079,15 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
         STRING_delete(transport_data->topic_DeviceMethods);
 
         tickcounter_destroy(transport_data->msgTickCounter);
+
+        if (transport_data->tls_session_cache != NULL)
+        {
+            tls_session_cache_destroy(transport_data->tls_session_cache);
+        }
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_036: [ IoTHubTransport_MQTT_Common_Destroy shall free the MQTT_MESSAGE_DETAILS_LIST records kept for reuse using slab_deinit. ] */
+        slab_deinit(&(transport_data->message_details_slab));
+
         /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_01_012: [ `IoTHubTransport_MQTT_Common_Destroy` shall free the stored proxy options. ]*/
         free_proxy_data(transport_data);
         free(transport_data);
@@ -2247,7 +2377,8 @@ IOTHUB_PROCESS_ITEM_RESULT IoTHubTransport_MQTT_Common_ProcessItem(TRANSPORT_LL_
     {
         PMQTTTRANSPORT_HANDLE_DATA transport_data = (PMQTTTRANSPORT_HANDLE_DATA)handle;
 
-        if (transport_data->currPacketState == PUBLISH_TYPE)
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_038: [ While a SAS token rollover is in progress, IoTHubTransport_MQTT_Common_ProcessItem shall return IOTHUB_PROCESS_NOT_CONNECTED, so the device twin items stay queued until the new connection replaced the current one. ] */
+        if (transport_data->currPacketState == PUBLISH_TYPE && transport_data->sasRolloverState == SAS_ROLLOVER_IDLE)
         {
             if (item_type == IOTHUB_TYPE_DEVICE_TWIN)
             {
@@ -2333,9 +2464,15 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                 // Publish can be called now
                 transport_data->currPacketState = PUBLISH_TYPE;
             }
-            else if (transport_data->currPacketState == PUBLISH_TYPE)
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_027: [ While the new connection is being opened, IoTHubTransport_MQTT_Common_DoWork shall not publish telemetry messages. ] */
+            else if (transport_data->currPacketState == PUBLISH_TYPE && transport_data->sasRolloverState == SAS_ROLLOVER_IDLE)
             {
-                PDLIST_ENTRY currentListEntry = transport_data->telemetry_waitingForAck.Flink;
+                PDLIST_ENTRY currentListEntry;
+
+                /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_037: [ While a SAS token rollover is in progress, device method responses shall be held and published by IoTHubTransport_MQTT_Common_DoWork once the connection in use is ready to publish again. ] */
+                release_held_device_method_messages(transport_data, true);
+
+                currentListEntry = transport_data->telemetry_waitingForAck.Flink;
                 while (currentListEntry != &transport_data->telemetry_waitingForAck)
                 {
                     tickcounter_ms_t current_ms;
@@ -2353,7 +2490,7 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                             PDLIST_ENTRY current_entry;
                             (void)DList_RemoveEntryList(currentListEntry);
                             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
-                            free(mqttMsgEntry);
+                            slab_free(&(transport_data->message_details_slab), mqttMsgEntry);
 
                             transport_data->currPacketState = PACKET_TYPE_ERROR;
                             transport_data->device_twin_get_sent = false;
@@ -2383,7 +2520,7 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                                 {
                                     (void)DList_RemoveEntryList(currentListEntry);
                                     sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                                    free(mqttMsgEntry);
+                                    slab_free(&(transport_data->message_details_slab), mqttMsgEntry);
                                 }
                             }
                         }
@@ -2409,7 +2546,8 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                     else
                     {
                         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_029: [IoTHubTransport_MQTT_Common_DoWork shall create a MQTT_MESSAGE_HANDLE and pass this to a call to mqtt_client_publish.] */
-                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = (MQTT_MESSAGE_DETAILS_LIST*)malloc(sizeof(MQTT_MESSAGE_DETAILS_LIST));
+                        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_034: [ IoTHubTransport_MQTT_Common_DoWork shall get the MQTT_MESSAGE_DETAILS_LIST record of each telemetry message using slab_alloc, and every record released by the transport shall be returned using slab_free. ] */
+                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = (MQTT_MESSAGE_DETAILS_LIST*)slab_alloc(&(transport_data->message_details_slab));
                         if (mqttMsgEntry == NULL)
                         {
                             LogError("Allocation Error: Failure allocating MQTT Message Detail List.");
@@ -2423,7 +2561,7 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                             {
                                 (void)(DList_RemoveEntryList(currentListEntry));
                                 sendMsgComplete(iothubMsgList, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                                free(mqttMsgEntry);
+                                slab_free(&(transport_data->message_details_slab), mqttMsgEntry);
                             }
                             else
                             {
@@ -2437,6 +2575,11 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
             }
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_030: [IoTHubTransport_MQTT_Common_DoWork shall call mqtt_client_dowork everytime it is called if it is connected.] */
             mqtt_client_dowork(transport_data->mqttClient);
+            if (transport_data->rolloverMqttClient != NULL)
+            {
+                /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_028: [ IoTHubTransport_MQTT_Common_DoWork shall also call mqtt_client_dowork on the new connection while the SAS token rollover is in progress. ] */
+                mqtt_client_dowork(transport_data->rolloverMqttClient);
+            }
         }
     }
 }
@@ -2601,6 +2744,27 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SetOption(TRANSPORT_LL_HANDLE h
                 }
             }
         }
+        else if (strcmp(OPTION_MQTT_IO_FACTORY, option) == 0)
+        {
+            if ((transport_data->xioTransport != NULL) || (transport_data->http_proxy_hostname != NULL))
+            {
+                /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_031: [ If the underlying IO has already been created, or the `proxy_data` option has been set, then `IoTHubTransport_MQTT_Common_SetOption` shall fail and return `IOTHUB_CLIENT_ERROR`. ] */
+                LogError("Cannot set the I/O factory once the underlying IO is created or together with a proxy");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_030: [ If `option` is `mqtt_io_factory`, `value` shall be used as a `MQTT_TRANSPORT_IO_FACTORY*` and copied; a NULL `create_io_transport` shall restore `get_io_transport`. ] */
+                transport_data->io_factory = *((const MQTT_TRANSPORT_IO_FACTORY*)value);
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(OPTION_MESSAGE_POOL_SIZE, option) == 0)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_035: [ If `option` is `message_pool_size`, `value` shall be used as a `size_t*` and set as the number of MQTT_MESSAGE_DETAILS_LIST records kept for reuse using slab_set_max_free_elements. ] */
+            slab_set_max_free_elements(&(transport_data->message_details_slab), *((const size_t*)value));
+            result = IOTHUB_CLIENT_OK;
+        }
         else
         {
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_039: [If the option parameter is set to "x509certificate" then the value shall be a const char of the certificate to be used for x509.] */
@@ -2721,6 +2885,28 @@ STRING_HANDLE IoTHubTransport_MQTT_Common_GetHostname(TRANSPORT_LL_HANDLE handle
     return result;
 }
 
+void IoTHubTransport_MQTT_Common_GetStatistics(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_039: [ If handle or statistics are NULL, IoTHubTransport_MQTT_Common_GetStatistics shall return without changes. ] */
+    if (handle == NULL || statistics == NULL)
+    {
+        LogError("invalid parameter handle=%p, statistics=%p", handle, statistics);
+    }
+    else
+    {
+        MQTTTRANSPORT_HANDLE_DATA* transport_data = (MQTTTRANSPORT_HANDLE_DATA*)handle;
+        TLS_SESSION_CACHE_STATISTICS tls_session_cache_statistics;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_COMMON_09_040: [ If the TLS session cache has been created, IoTHubTransport_MQTT_Common_GetStatistics shall set statistics->tls_session_cache_hits and statistics->tls_session_cache_misses from tls_session_cache_get_statistics; otherwise it shall leave them unchanged. ] */
+        if (transport_data->tls_session_cache != NULL &&
+            tls_session_cache_get_statistics(transport_data->tls_session_cache, &tls_session_cache_statistics) == 0)
+        {
+            statistics->tls_session_cache_hits = tls_session_cache_statistics.hits;
+            statistics->tls_session_cache_misses = tls_session_cache_statistics.misses;
+        }
+    }
+}
+
 IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SendMessageDisposition(MESSAGE_CALLBACK_INFO* message_data, IOTHUBMESSAGE_DISPOSITION_RESULT disposition)
 {
     (void)disposition;
@@ -0,0 +1,1249 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "iothubtransport_mqtt_reactor.h"
+#include "iothubtransport_mqtt_common.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/tlsio.h"
+
+#define RESULT_OK                           0
+#define DEFAULT_MQTT_TLS_PORT               8883
+#define DEFAULT_IDLE_INTERVAL_MS            1000
+// A client that has just done some I/O is serviced again this soon, so that what the transport queues in
+// response (e.g. its subscriptions once CONNACK is received) does not wait for the idle interval.
+#define FOLLOW_UP_INTERVAL_MS               1
+#define MAX_EVENTS_PER_WAIT                 64
+#define RECEIVE_BUFFER_SIZE                 4096
+// What one service reads at most from a socket, so that a busy connection cannot starve the others.
+#define MAX_RECEIVE_PER_SERVICE             (16 * RECEIVE_BUFFER_SIZE)
+#define INITIAL_CLIENT_SLOT_COUNT           16
+#define STOP_EVENT_ID                       UINT64_MAX
+#define EVENT_ID_SLOT_MASK                  0xFFFFFFFF
+
+typedef struct MQTT_REACTOR_INSTANCE_TAG
+{
+    int epoll_fd;
+    int stop_event_fd;
+    size_t idle_interval_ms;
+    MQTT_REACTOR_GET_IO_TRANSPORT get_io_transport;
+    // Guards the fields below and the reference counts and service flags of the clients
+    LOCK_HANDLE lock;
+    // Registered clients, indexed by the low 32 bits of their event id; the high 32 bits are a generation
+    // number, so that the events of a removed client are not delivered to the client reusing its slot
+    struct MQTT_REACTOR_CLIENT_TAG** clients;
+    size_t client_slot_count;
+    uint32_t generation;
+    THREAD_HANDLE* threads;
+    size_t thread_count;
+} MQTT_REACTOR_INSTANCE;
+
+typedef struct MQTT_REACTOR_CLIENT_TAG
+{
+    MQTT_REACTOR_INSTANCE* reactor;
+    IOTHUB_CLIENT_LL_HANDLE client_handle;
+    LOCK_HANDLE client_lock;
+    uint64_t event_id;
+    int timer_fd;
+    // Held by the application until mqtt_reactor_remove_client and by each socket I/O of the client
+    size_t ref_count;
+    bool is_in_service;
+    bool needs_service;
+    // Set by the socket I/Os when they connect, send or receive during a service
+    bool had_io;
+    DLIST_ENTRY socket_ios;
+} MQTT_REACTOR_CLIENT;
+
+typedef enum SOCKET_IO_STATE_TAG
+{
+    SOCKET_IO_STATE_CLOSED,
+    SOCKET_IO_STATE_CONNECTING,
+    SOCKET_IO_STATE_OPEN,
+    SOCKET_IO_STATE_ERROR
+} SOCKET_IO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    size_t sent_size;
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+    struct PENDING_SEND_TAG* next;
+} PENDING_SEND;
+
+typedef struct SOCKET_IO_INSTANCE_TAG
+{
+    MQTT_REACTOR_CLIENT* owner;
+    char* hostname;
+    int port;
+    int socket;
+    SOCKET_IO_STATE state;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    PENDING_SEND* pending_sends_head;
+    PENDING_SEND* pending_sends_tail;
+    DLIST_ENTRY entry;
+} SOCKET_IO_INSTANCE;
+
+static const IO_INTERFACE_DESCRIPTION socket_io_interface_description;
+
+static int set_timer(int timer_fd, size_t timeout_ms)
+{
+    int result;
+    struct itimerspec timer_spec;
+
+    (void)memset(&timer_spec, 0, sizeof(timer_spec));
+    timer_spec.it_value.tv_sec = (time_t)(timeout_ms / 1000);
+    // A zero it_value would disarm the timer
+    timer_spec.it_value.tv_nsec = (timeout_ms == 0) ? 1 : (long)((timeout_ms % 1000) * 1000000);
+
+    if (timerfd_settime(timer_fd, 0, &timer_spec, NULL) != 0)
+    {
+        LogError("timerfd_settime failed (errno %d)", errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = RESULT_OK;
+    }
+
+    return result;
+}
+
+static void release_client(MQTT_REACTOR_CLIENT* reactor_client)
+{
+    bool is_last_reference;
+
+    if (Lock(reactor_client->reactor->lock) != LOCK_OK)
+    {
+        // Leaking the client is safer than freeing it while it may still be in use
+        LogError("Failed locking the reactor; the client is not released");
+        is_last_reference = false;
+    }
+    else
+    {
+        reactor_client->ref_count--;
+        is_last_reference = (reactor_client->ref_count == 0);
+        (void)Unlock(reactor_client->reactor->lock);
+    }
+
+    if (is_last_reference)
+    {
+        free(reactor_client);
+    }
+}
+
+static void arm_socket_io(SOCKET_IO_INSTANCE* socket_io, int operation)
+{
+    struct epoll_event event;
+
+    // One-shot, so that a socket wakes up a single thread and stays quiet until its client has been serviced
+    event.events = EPOLLIN | EPOLLONESHOT;
+    if ((socket_io->state == SOCKET_IO_STATE_CONNECTING) || (socket_io->pending_sends_head != NULL))
+    {
+        event.events |= EPOLLOUT;
+    }
+    event.data.u64 = socket_io->owner->event_id;
+
+    if (epoll_ctl(socket_io->owner->reactor->epoll_fd, operation, socket_io->socket, &event) != 0)
+    {
+        LogError("epoll_ctl failed for socket to %s:%d (errno %d)", socket_io->hostname, socket_io->port, errno);
+    }
+}
+
+static void arm_client(MQTT_REACTOR_CLIENT* reactor_client)
+{
+    PDLIST_ENTRY entry = reactor_client->socket_ios.Flink;
+
+    while (entry != &reactor_client->socket_ios)
+    {
+        SOCKET_IO_INSTANCE* socket_io = containingRecord(entry, SOCKET_IO_INSTANCE, entry);
+
+        if ((socket_io->state == SOCKET_IO_STATE_CONNECTING) || (socket_io->state == SOCKET_IO_STATE_OPEN))
+        {
+            arm_socket_io(socket_io, EPOLL_CTL_MOD);
+        }
+
+        entry = entry->Flink;
+    }
+
+    (void)set_timer(reactor_client->timer_fd, reactor_client->had_io ? FOLLOW_UP_INTERVAL_MS : reactor_client->reactor->idle_interval_ms);
+}
+
+static void service_client(MQTT_REACTOR_CLIENT* reactor_client)
+{
+    MQTT_REACTOR_INSTANCE* reactor = reactor_client->reactor;
+    bool is_serviced_again;
+
+    do
+    {
+        if ((reactor_client->client_lock != NULL) && (Lock(reactor_client->client_lock) != LOCK_OK))
+        {
+            LogError("Failed locking the client; it will be serviced after the idle interval");
+            (void)set_timer(reactor_client->timer_fd, reactor->idle_interval_ms);
+        }
+        else
+        {
+            reactor_client->had_io = false;
+            IoTHubClient_LL_DoWork(reactor_client->client_handle);
+            arm_client(reactor_client);
+
+            if (reactor_client->client_lock != NULL)
+            {
+                (void)Unlock(reactor_client->client_lock);
+            }
+        }
+
+        // The service state is shared with dispatch_event and mqtt_reactor_remove_client, so it is only released under the reactor lock
+        while (Lock(reactor->lock) != LOCK_OK)
+        {
+            LogError("Failed locking the reactor; retrying");
+            ThreadAPI_Sleep(1);
+        }
+
+        // An event that arrived during the service was not delivered to another thread; handle it here
+        is_serviced_again = reactor_client->needs_service;
+        reactor_client->needs_service = false;
+        reactor_client->is_in_service = is_serviced_again;
+        (void)Unlock(reactor->lock);
+    } while (is_serviced_again);
+}
+
+static void dispatch_event(MQTT_REACTOR_INSTANCE* reactor, uint64_t event_id)
+{
+    MQTT_REACTOR_CLIENT* reactor_client = NULL;
+
+    if (Lock(reactor->lock) != LOCK_OK)
+    {
+        LogError("Failed locking the reactor");
+    }
+    else
+    {
+        size_t slot = (size_t)(event_id & EVENT_ID_SLOT_MASK);
+
+        if ((slot < reactor->client_slot_count) &&
+            (reactor->clients[slot] != NULL) &&
+            (reactor->clients[slot]->event_id == event_id))
+        {
+            if (reactor->clients[slot]->is_in_service)
+            {
+                reactor->clients[slot]->needs_service = true;
+            }
+            else
+            {
+                reactor->clients[slot]->is_in_service = true;
+                reactor_client = reactor->clients[slot];
+            }
+        }
+
+        (void)Unlock(reactor->lock);
+    }
+
+    if (reactor_client != NULL)
+    {
+        service_client(reactor_client);
+    }
+}
+
+static int wait_and_dispatch(MQTT_REACTOR_INSTANCE* reactor, int timeout_ms, bool* is_stopped)
+{
+    int result;
+    struct epoll_event events[MAX_EVENTS_PER_WAIT];
+    int event_count = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS_PER_WAIT, timeout_ms);
+
+    if (event_count < 0)
+    {
+        if (errno == EINTR)
+        {
+            result = RESULT_OK;
+        }
+        else
+        {
+            LogError("epoll_wait failed (errno %d)", errno);
+            result = __FAILURE__;
+        }
+    }
+    else
+    {
+        int i;
+
+        for (i = 0; i < event_count; i++)
+        {
+            if (events[i].data.u64 == STOP_EVENT_ID)
+            {
+                *is_stopped = true;
+            }
+            else
+            {
+                dispatch_event(reactor, events[i].data.u64);
+            }
+        }
+
+        result = RESULT_OK;
+    }
+
+    return result;
+}
+
+static int reactor_thread(void* argument)
+{
+    MQTT_REACTOR_INSTANCE* reactor = (MQTT_REACTOR_INSTANCE*)argument;
+    bool is_stopped = false;
+
+    while (!is_stopped)
+    {
+        if (wait_and_dispatch(reactor, -1, &is_stopped) != RESULT_OK)
+        {
+            ThreadAPI_Sleep(1);
+        }
+    }
+
+    ThreadAPI_Exit(0);
+    return 0;
+}
+
+static void stop_threads(MQTT_REACTOR_INSTANCE* reactor)
+{
+    size_t i;
+    uint64_t stop = 1;
+
+    // The stop event is level-triggered and never read, so it wakes up every thread
+    if (write(reactor->stop_event_fd, &stop, sizeof(stop)) != (ssize_t)sizeof(stop))
+    {
+        LogError("Failed signaling the reactor threads to stop (errno %d)", errno);
+    }
+
+    for (i = 0; i < reactor->thread_count; i++)
+    {
+        int thread_result;
+
+        if (ThreadAPI_Join(reactor->threads[i], &thread_result) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Join failed");
+        }
+    }
+
+    reactor->thread_count = 0;
+}
+
+static void destroy_reactor(MQTT_REACTOR_INSTANCE* reactor)
+{
+    if (reactor->thread_count > 0)
+    {
+        stop_threads(reactor);
+    }
+
+    if (reactor->clients != NULL)
+    {
+        size_t i;
+
+        for (i = 0; i < reactor->client_slot_count; i++)
+        {
+            if (reactor->clients[i] != NULL)
+            {
+                LogError("Client %p was not removed from the reactor", reactor->clients[i]->client_handle);
+                (void)close(reactor->clients[i]->timer_fd);
+                reactor->clients[i]->timer_fd = -1;
+            }
+        }
+
+        free(reactor->clients);
+    }
+
+    if (reactor->stop_event_fd >= 0)
+    {
+        (void)close(reactor->stop_event_fd);
+    }
+
+    if (reactor->epoll_fd >= 0)
+    {
+        (void)close(reactor->epoll_fd);
+    }
+
+    if (reactor->lock != NULL)
+    {
+        (void)Lock_Deinit(reactor->lock);
+    }
+
+    free(reactor->threads);
+    free(reactor);
+}
+
+static XIO_HANDLE create_client_io(void* context, const char* fully_qualified_name)
+{
+    XIO_HANDLE result;
+    MQTT_REACTOR_CLIENT* reactor_client = (MQTT_REACTOR_CLIENT*)context;
+    MQTT_REACTOR_SOCKET_CONFIG socket_config;
+
+    socket_config.hostname = fully_qualified_name;
+    socket_config.port = DEFAULT_MQTT_TLS_PORT;
+    socket_config.reactor_client = reactor_client;
+
+    if (reactor_client->reactor->get_io_transport != NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_014: [ If the reactor was created with `get_io_transport`, the I/O of each new connection shall be the one it returns for the host name, the socket I/O interface and a MQTT_REACTOR_SOCKET_CONFIG with port 8883 and the client. ] */
+        result = reactor_client->reactor->get_io_transport(fully_qualified_name, &socket_io_interface_description, &socket_config);
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_015: [ Otherwise it shall be a TLS I/O (platform_get_default_tlsio) to the host name on port 8883 over the socket I/O of the reactor. ] */
+        const IO_INTERFACE_DESCRIPTION* tlsio_interface = platform_get_default_tlsio();
+
+        if (tlsio_interface == NULL)
+        {
+            LogError("platform_get_default_tlsio failed");
+            result = NULL;
+        }
+        else
+        {
+            TLSIO_CONFIG tls_io_config;
+
+            tls_io_config.hostname = fully_qualified_name;
+            tls_io_config.port = DEFAULT_MQTT_TLS_PORT;
+            tls_io_config.underlying_io_interface = &socket_io_interface_description;
+            tls_io_config.underlying_io_parameters = &socket_config;
+
+            result = xio_create(tlsio_interface, &tls_io_config);
+        }
+    }
+
+    if (result == NULL)
+    {
+        LogError("Failed creating the I/O of a connection to %s", fully_qualified_name);
+    }
+
+    return result;
+}
+
+MQTT_REACTOR_HANDLE mqtt_reactor_create(const MQTT_REACTOR_CONFIG* config)
+{
+    MQTT_REACTOR_INSTANCE* result;
+
+    if (config == NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_001: [ If `config` is NULL, mqtt_reactor_create shall fail and return NULL. ] */
+        LogError("Invalid argument (config is NULL)");
+        result = NULL;
+    }
+    else if ((result = (MQTT_REACTOR_INSTANCE*)malloc(sizeof(MQTT_REACTOR_INSTANCE))) == NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_003: [ If any resource fails to be created, mqtt_reactor_create shall release the ones already created and return NULL. ] */
+        LogError("Failed allocating the MQTT reactor");
+    }
+    else
+    {
+        struct epoll_event stop_event;
+
+        (void)memset(result, 0, sizeof(MQTT_REACTOR_INSTANCE));
+        result->idle_interval_ms = (config->idle_interval_ms == 0) ? DEFAULT_IDLE_INTERVAL_MS : config->idle_interval_ms;
+        result->get_io_transport = config->get_io_transport;
+        result->stop_event_fd = -1;
+
+        stop_event.events = EPOLLIN;
+        stop_event.data.u64 = STOP_EVENT_ID;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_002: [ mqtt_reactor_create shall create an epoll instance, an eventfd used to stop the threads and a lock. ] */
+        if ((result->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        {
+            LogError("epoll_create1 failed (errno %d)", errno);
+            destroy_reactor(result);
+            result = NULL;
+        }
+        else if ((result->stop_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0 ||
+            epoll_ctl(result->epoll_fd, EPOLL_CTL_ADD, result->stop_event_fd, &stop_event) != 0)
+        {
+            LogError("Failed creating the stop event (errno %d)", errno);
+            destroy_reactor(result);
+            result = NULL;
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed");
+            destroy_reactor(result);
+            result = NULL;
+        }
+        else if ((config->thread_count > 0) &&
+            ((result->threads = (THREAD_HANDLE*)malloc(config->thread_count * sizeof(THREAD_HANDLE))) == NULL))
+        {
+            LogError("Failed allocating the reactor threads");
+            destroy_reactor(result);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_004: [ mqtt_reactor_create shall start `thread_count` threads, each waiting for events and servicing the clients they concern. ] */
+            while (result->thread_count < config->thread_count)
+            {
+                if (ThreadAPI_Create(&result->threads[result->thread_count], reactor_thread, result) != THREADAPI_OK)
+                {
+                    LogError("ThreadAPI_Create failed");
+                    break;
+                }
+
+                result->thread_count++;
+            }
+
+            if (result->thread_count < config->thread_count)
+            {
+                destroy_reactor(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void mqtt_reactor_destroy(MQTT_REACTOR_HANDLE reactor)
+{
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument (reactor is NULL)");
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_005: [ mqtt_reactor_destroy shall stop and join the threads, then release all the resources of the reactor. ] */
+        destroy_reactor(reactor);
+    }
+}
+
+MQTT_REACTOR_CLIENT_HANDLE mqtt_reactor_add_client(MQTT_REACTOR_HANDLE reactor, IOTHUB_CLIENT_LL_HANDLE client, LOCK_HANDLE lock)
+{
+    MQTT_REACTOR_CLIENT* result;
+
+    if ((reactor == NULL) || (client == NULL))
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_006: [ If `reactor` or `client` is NULL, mqtt_reactor_add_client shall fail and return NULL. ] */
+        LogError("Invalid argument (reactor=%p, client=%p)", reactor, client);
+        result = NULL;
+    }
+    else if ((result = (MQTT_REACTOR_CLIENT*)malloc(sizeof(MQTT_REACTOR_CLIENT))) == NULL)
+    {
+        LogError("Failed allocating the reactor client");
+    }
+    else
+    {
+        result->reactor = reactor;
+        result->client_handle = client;
+        result->client_lock = lock;
+        result->event_id = 0;
+        result->ref_count = 1;
+        result->is_in_service = false;
+        result->needs_service = false;
+        result->had_io = false;
+        DList_InitializeListHead(&result->socket_ios);
+
+        if ((result->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_009: [ If any step fails, mqtt_reactor_add_client shall undo the previous ones and return NULL. ] */
+            LogError("timerfd_create failed (errno %d)", errno);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            MQTT_TRANSPORT_IO_FACTORY io_factory;
+            IOTHUB_CLIENT_RESULT set_option_result;
+
+            io_factory.create_io_transport = create_client_io;
+            io_factory.context = result;
+
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_007: [ mqtt_reactor_add_client shall set the `mqtt_io_factory` option of `client`, holding `lock` if it is not NULL, so that the transport opens its connections on the socket I/O of the reactor. ] */
+            if ((lock != NULL) && (Lock(lock) != LOCK_OK))
+            {
+                LogError("Failed locking the client");
+                set_option_result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                set_option_result = IoTHubClient_LL_SetOption(client, OPTION_MQTT_IO_FACTORY, &io_factory);
+
+                if (lock != NULL)
+                {
+                    (void)Unlock(lock);
+                }
+            }
+
+            if (set_option_result != IOTHUB_CLIENT_OK)
+            {
+                LogError("Failed setting the I/O factory of the client (%s)", ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, set_option_result));
+                (void)close(result->timer_fd);
+                free(result);
+                result = NULL;
+            }
+            else if (Lock(reactor->lock) != LOCK_OK)
+            {
+                LogError("Failed locking the reactor");
+                (void)close(result->timer_fd);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                size_t slot = 0;
+
+                while ((slot < reactor->client_slot_count) && (reactor->clients[slot] != NULL))
+                {
+                    slot++;
+                }
+
+                if (slot == reactor->client_slot_count)
+                {
+                    size_t new_slot_count = (reactor->client_slot_count == 0) ? INITIAL_CLIENT_SLOT_COUNT : (reactor->client_slot_count * 2);
+                    MQTT_REACTOR_CLIENT** new_clients = (new_slot_count > EVENT_ID_SLOT_MASK) ? NULL :
+                        (MQTT_REACTOR_CLIENT**)realloc(reactor->clients, new_slot_count * sizeof(MQTT_REACTOR_CLIENT*));
+
+                    if (new_clients != NULL)
+                    {
+                        (void)memset(new_clients + reactor->client_slot_count, 0, (new_slot_count - reactor->client_slot_count) * sizeof(MQTT_REACTOR_CLIENT*));
+                        reactor->clients = new_clients;
+                        reactor->client_slot_count = new_slot_count;
+                    }
+                }
+
+                if (slot == reactor->client_slot_count)
+                {
+                    (void)Unlock(reactor->lock);
+                    LogError("Failed growing the reactor client table");
+                    (void)close(result->timer_fd);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    struct epoll_event timer_event;
+
+                    reactor->generation++;
+                    result->event_id = (((uint64_t)reactor->generation) << 32) | (uint64_t)slot;
+                    reactor->clients[slot] = result;
+                    (void)Unlock(reactor->lock);
+
+                    // Edge-triggered: re-arming the timer resets it, so it does not need to be read
+                    timer_event.events = EPOLLIN | EPOLLET;
+                    timer_event.data.u64 = result->event_id;
+
+                    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_008: [ mqtt_reactor_add_client shall register a timerfd of the client with the epoll instance and arm it to expire at once, so that the client connects. ] */
+                    if ((epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, result->timer_fd, &timer_event) != 0) ||
+                        (set_timer(result->timer_fd, 0) != RESULT_OK))
+                    {
+                        LogError("Failed registering the client timer (errno %d)", errno);
+                        mqtt_reactor_remove_client(result);
+                        result = NULL;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void mqtt_reactor_remove_client(MQTT_REACTOR_CLIENT_HANDLE reactor_client)
+{
+    if (reactor_client == NULL)
+    {
+        LogError("Invalid argument (reactor_client is NULL)");
+    }
+    else
+    {
+        MQTT_REACTOR_INSTANCE* reactor = reactor_client->reactor;
+        bool is_in_service = true;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_010: [ mqtt_reactor_remove_client shall unregister the client so that its pending and future events are ignored. ] */
+        if (Lock(reactor->lock) != LOCK_OK)
+        {
+            LogError("Failed locking the reactor; the client is not removed");
+        }
+        else
+        {
+            reactor->clients[reactor_client->event_id & EVENT_ID_SLOT_MASK] = NULL;
+            (void)Unlock(reactor->lock);
+
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_011: [ mqtt_reactor_remove_client shall wait for any ongoing service of the client to complete, then close its timerfd and release it. ] */
+            while (is_in_service)
+            {
+                if (Lock(reactor->lock) == LOCK_OK)
+                {
+                    is_in_service = reactor_client->is_in_service;
+                    (void)Unlock(reactor->lock);
+                }
+
+                if (is_in_service)
+                {
+                    ThreadAPI_Sleep(1);
+                }
+            }
+
+            (void)epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, reactor_client->timer_fd, NULL);
+            (void)close(reactor_client->timer_fd);
+            reactor_client->timer_fd = -1;
+
+            // The socket I/Os still open keep the client until the transport destroys them
+            release_client(reactor_client);
+        }
+    }
+}
+
+int mqtt_reactor_wake_client(MQTT_REACTOR_CLIENT_HANDLE reactor_client)
+{
+    int result;
+
+    if (reactor_client == NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_012: [ If `reactor_client` is NULL, mqtt_reactor_wake_client shall fail and return a non-zero value. ] */
+        LogError("Invalid argument (reactor_client is NULL)");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_013: [ mqtt_reactor_wake_client shall arm the timerfd of the client to expire at once. ] */
+        result = set_timer(reactor_client->timer_fd, 0);
+    }
+
+    return result;
+}
+
+int mqtt_reactor_dowork(MQTT_REACTOR_HANDLE reactor, size_t timeout_ms)
+{
+    int result;
+
+    if (reactor == NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_016: [ If `reactor` is NULL, mqtt_reactor_dowork shall fail and return a non-zero value. ] */
+        LogError("Invalid argument (reactor is NULL)");
+        result = __FAILURE__;
+    }
+    else
+    {
+        bool is_stopped = false;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_017: [ mqtt_reactor_dowork shall wait up to `timeout_ms` for events and, for each, call IoTHubClient_LL_DoWork of the client it concerns, holding the lock of the client, unless it is being serviced by another thread, which shall then service it again. ] */
+        result = wait_and_dispatch(reactor, (timeout_ms > INT_MAX) ? INT_MAX : (int)timeout_ms, &is_stopped);
+    }
+
+    return result;
+}
+
+static void complete_pending_sends(SOCKET_IO_INSTANCE* socket_io, IO_SEND_RESULT send_result)
+{
+    while (socket_io->pending_sends_head != NULL)
+    {
+        PENDING_SEND* pending_send = socket_io->pending_sends_head;
+
+        socket_io->pending_sends_head = pending_send->next;
+        if (socket_io->pending_sends_head == NULL)
+        {
+            socket_io->pending_sends_tail = NULL;
+        }
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->on_send_complete_context, send_result);
+        }
+
+        free(pending_send);
+    }
+}
+
+static void close_socket(SOCKET_IO_INSTANCE* socket_io)
+{
+    if (socket_io->socket >= 0)
+    {
+        (void)epoll_ctl(socket_io->owner->reactor->epoll_fd, EPOLL_CTL_DEL, socket_io->socket, NULL);
+        (void)close(socket_io->socket);
+        socket_io->socket = -1;
+    }
+}
+
+static void indicate_error(SOCKET_IO_INSTANCE* socket_io)
+{
+    socket_io->state = SOCKET_IO_STATE_ERROR;
+
+    if (socket_io->on_io_error != NULL)
+    {
+        socket_io->on_io_error(socket_io->on_io_error_context);
+    }
+}
+
+static int connect_socket(SOCKET_IO_INSTANCE* socket_io)
+{
+    int result;
+    struct addrinfo hints;
+    struct addrinfo* address_info;
+    char port_string[16];
+    int address_result;
+
+    (void)memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    (void)snprintf(port_string, sizeof(port_string), "%d", socket_io->port);
+
+    // The name is resolved synchronously, on the thread servicing the client
+    if ((address_result = getaddrinfo(socket_io->hostname, port_string, &hints, &address_info)) != 0)
+    {
+        LogError("Failed resolving %s (%s)", socket_io->hostname, gai_strerror(address_result));
+        result = __FAILURE__;
+    }
+    else
+    {
+        struct addrinfo* candidate;
+
+        result = __FAILURE__;
+
+        for (candidate = address_info; (candidate != NULL) && (result != RESULT_OK); candidate = candidate->ai_next)
+        {
+            int socket_fd = socket(candidate->ai_family, candidate->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, candidate->ai_protocol);
+
+            if (socket_fd >= 0)
+            {
+                int no_delay = 1;
+
+                (void)setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+                if ((connect(socket_fd, candidate->ai_addr, candidate->ai_addrlen) == 0) || (errno == EINPROGRESS))
+                {
+                    socket_io->socket = socket_fd;
+                    result = RESULT_OK;
+                }
+                else
+                {
+                    (void)close(socket_fd);
+                }
+            }
+        }
+
+        freeaddrinfo(address_info);
+
+        if (result != RESULT_OK)
+        {
+            LogError("Failed connecting to %s:%d (errno %d)", socket_io->hostname, socket_io->port, errno);
+        }
+        else
+        {
+            // Connecting until the socket becomes writable, even if connect() already succeeded
+            socket_io->state = SOCKET_IO_STATE_CONNECTING;
+            arm_socket_io(socket_io, EPOLL_CTL_ADD);
+        }
+    }
+
+    return result;
+}
+
+static void complete_connect(SOCKET_IO_INSTANCE* socket_io)
+{
+    struct pollfd poll_fd;
+    int poll_result;
+
+    poll_fd.fd = socket_io->socket;
+    poll_fd.events = POLLOUT;
+    poll_fd.revents = 0;
+
+    if ((poll_result = poll(&poll_fd, 1, 0)) != 0)
+    {
+        int socket_error = 0;
+        socklen_t socket_error_size = sizeof(socket_error);
+
+        if ((poll_result < 0) ||
+            (getsockopt(socket_io->socket, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_size) != 0) ||
+            (socket_error != 0))
+        {
+            LogError("Failed connecting to %s:%d (error %d)", socket_io->hostname, socket_io->port, socket_error);
+            close_socket(socket_io);
+            socket_io->state = SOCKET_IO_STATE_ERROR;
+            socket_io->on_io_open_complete(socket_io->on_io_open_complete_context, IO_OPEN_ERROR);
+        }
+        else
+        {
+            socket_io->state = SOCKET_IO_STATE_OPEN;
+            socket_io->owner->had_io = true;
+            socket_io->on_io_open_complete(socket_io->on_io_open_complete_context, IO_OPEN_OK);
+        }
+    }
+}
+
+static void send_pending_bytes(SOCKET_IO_INSTANCE* socket_io)
+{
+    while ((socket_io->state == SOCKET_IO_STATE_OPEN) && (socket_io->pending_sends_head != NULL))
+    {
+        PENDING_SEND* pending_send = socket_io->pending_sends_head;
+        ssize_t sent = send(socket_io->socket, pending_send->bytes + pending_send->sent_size, pending_send->size - pending_send->sent_size, MSG_NOSIGNAL);
+
+        if (sent < 0)
+        {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            {
+                LogError("Failed sending to %s:%d (errno %d)", socket_io->hostname, socket_io->port, errno);
+                indicate_error(socket_io);
+            }
+            break;
+        }
+        else
+        {
+            socket_io->owner->had_io = true;
+            pending_send->sent_size += (size_t)sent;
+
+            if (pending_send->sent_size == pending_send->size)
+            {
+                socket_io->pending_sends_head = pending_send->next;
+                if (socket_io->pending_sends_head == NULL)
+                {
+                    socket_io->pending_sends_tail = NULL;
+                }
+
+                if (pending_send->on_send_complete != NULL)
+                {
+                    pending_send->on_send_complete(pending_send->on_send_complete_context, IO_SEND_OK);
+                }
+
+                free(pending_send);
+            }
+        }
+    }
+}
+
+static void receive_bytes(SOCKET_IO_INSTANCE* socket_io)
+{
+    unsigned char buffer[RECEIVE_BUFFER_SIZE];
+    size_t received_size = 0;
+
+    while ((socket_io->state == SOCKET_IO_STATE_OPEN) && (received_size < MAX_RECEIVE_PER_SERVICE))
+    {
+        ssize_t received = recv(socket_io->socket, buffer, sizeof(buffer), 0);
+
+        if (received > 0)
+        {
+            received_size += (size_t)received;
+            socket_io->owner->had_io = true;
+            socket_io->on_bytes_received(socket_io->on_bytes_received_context, buffer, (size_t)received);
+        }
+        else if (received == 0)
+        {
+            LogError("Connection to %s:%d closed by the peer", socket_io->hostname, socket_io->port);
+            indicate_error(socket_io);
+        }
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            LogError("Failed receiving from %s:%d (errno %d)", socket_io->hostname, socket_io->port, errno);
+            indicate_error(socket_io);
+        }
+    }
+}
+
+static CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
+{
+    SOCKET_IO_INSTANCE* result;
+    MQTT_REACTOR_SOCKET_CONFIG* socket_config = (MQTT_REACTOR_SOCKET_CONFIG*)io_create_parameters;
+
+    if ((socket_config == NULL) || (socket_config->hostname == NULL) || (socket_config->reactor_client == NULL))
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_018: [ If `io_create_parameters`, its `hostname` or its `reactor_client` is NULL, socketio_create shall fail and return NULL. ] */
+        LogError("Invalid socket I/O configuration");
+        result = NULL;
+    }
+    else if ((result = (SOCKET_IO_INSTANCE*)malloc(sizeof(SOCKET_IO_INSTANCE))) == NULL)
+    {
+        LogError("Failed allocating the socket I/O");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(SOCKET_IO_INSTANCE));
+        result->socket = -1;
+        result->state = SOCKET_IO_STATE_CLOSED;
+        result->port = socket_config->port;
+        result->owner = socket_config->reactor_client;
+
+        if (mallocAndStrcpy_s(&result->hostname, socket_config->hostname) != 0)
+        {
+            LogError("Failed copying the host name");
+            free(result);
+            result = NULL;
+        }
+        else if (Lock(result->owner->reactor->lock) != LOCK_OK)
+        {
+            LogError("Failed locking the reactor");
+            free(result->hostname);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_019: [ socketio_create shall add the socket I/O to the client, which it shall keep until it is destroyed. ] */
+            result->owner->ref_count++;
+            (void)Unlock(result->owner->reactor->lock);
+            DList_InsertTailList(&result->owner->socket_ios, &result->entry);
+        }
+    }
+
+    return result;
+}
+
+static void socketio_destroy(CONCRETE_IO_HANDLE socket_io_handle)
+{
+    if (socket_io_handle == NULL)
+    {
+        LogError("Invalid argument (socket_io_handle is NULL)");
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io = (SOCKET_IO_INSTANCE*)socket_io_handle;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_020: [ socketio_destroy shall close the socket, cancel the pending sends, remove the socket I/O from its client and release the client. ] */
+        close_socket(socket_io);
+        complete_pending_sends(socket_io, IO_SEND_CANCELLED);
+        (void)DList_RemoveEntryList(&socket_io->entry);
+        release_client(socket_io->owner);
+        free(socket_io->hostname);
+        free(socket_io);
+    }
+}
+
+static int socketio_open(CONCRETE_IO_HANDLE socket_io_handle, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    SOCKET_IO_INSTANCE* socket_io = (SOCKET_IO_INSTANCE*)socket_io_handle;
+
+    if ((socket_io == NULL) || (on_io_open_complete == NULL) || (on_bytes_received == NULL) || (on_io_error == NULL))
+    {
+        LogError("Invalid argument");
+        result = __FAILURE__;
+    }
+    else if (socket_io->state != SOCKET_IO_STATE_CLOSED)
+    {
+        LogError("Socket I/O to %s:%d is already open", socket_io->hostname, socket_io->port);
+        result = __FAILURE__;
+    }
+    else
+    {
+        socket_io->on_io_open_complete = on_io_open_complete;
+        socket_io->on_io_open_complete_context = on_io_open_complete_context;
+        socket_io->on_bytes_received = on_bytes_received;
+        socket_io->on_bytes_received_context = on_bytes_received_context;
+        socket_io->on_io_error = on_io_error;
+        socket_io->on_io_error_context = on_io_error_context;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_021: [ socketio_open shall start a non-blocking connection and register the socket with the epoll instance; the open completes when the socket becomes writable. ] */
+        result = connect_socket(socket_io);
+    }
+
+    return result;
+}
+
+static int socketio_close(CONCRETE_IO_HANDLE socket_io_handle, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    SOCKET_IO_INSTANCE* socket_io = (SOCKET_IO_INSTANCE*)socket_io_handle;
+
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument (socket_io_handle is NULL)");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_022: [ socketio_close shall close the socket, cancel the pending sends and call `on_io_close_complete`. ] */
+        close_socket(socket_io);
+        socket_io->state = SOCKET_IO_STATE_CLOSED;
+        complete_pending_sends(socket_io, IO_SEND_CANCELLED);
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = RESULT_OK;
+    }
+
+    return result;
+}
+
+static int socketio_send(CONCRETE_IO_HANDLE socket_io_handle, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    SOCKET_IO_INSTANCE* socket_io = (SOCKET_IO_INSTANCE*)socket_io_handle;
+
+    if ((socket_io == NULL) || (buffer == NULL) || (size == 0))
+    {
+        LogError("Invalid argument");
+        result = __FAILURE__;
+    }
+    else if (socket_io->state != SOCKET_IO_STATE_OPEN)
+    {
+        LogError("Socket I/O to %s:%d is not open", socket_io->hostname, socket_io->port);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t sent_size = 0;
+
+        result = RESULT_OK;
+
+        // Bytes are only sent right away when nothing is queued before them
+        if (socket_io->pending_sends_head == NULL)
+        {
+            ssize_t sent = send(socket_io->socket, buffer, size, MSG_NOSIGNAL);
+
+            if (sent >= 0)
+            {
+                sent_size = (size_t)sent;
+                socket_io->owner->had_io = true;
+            }
+            else if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            {
+                LogError("Failed sending to %s:%d (errno %d)", socket_io->hostname, socket_io->port, errno);
+                result = __FAILURE__;
+            }
+        }
+
+        if (result != RESULT_OK)
+        {
+            // error already logged
+        }
+        else if (sent_size == size)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_023: [ socketio_send shall send the bytes at once if it can, and otherwise queue what is left to be sent when the socket becomes writable; `on_send_complete` shall be called once all the bytes are sent. ] */
+            if (on_send_complete != NULL)
+            {
+                on_send_complete(callback_context, IO_SEND_OK);
+            }
+        }
+        else
+        {
+            PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + (size - sent_size));
+
+            if (pending_send == NULL)
+            {
+                LogError("Failed queuing %lu bytes", (unsigned long)(size - sent_size));
+                result = __FAILURE__;
+            }
+            else
+            {
+                pending_send->bytes = (unsigned char*)(pending_send + 1);
+                (void)memcpy(pending_send->bytes, (const unsigned char*)buffer + sent_size, size - sent_size);
+                pending_send->size = size - sent_size;
+                pending_send->sent_size = 0;
+                pending_send->on_send_complete = on_send_complete;
+                pending_send->on_send_complete_context = callback_context;
+                pending_send->next = NULL;
+
+                if (socket_io->pending_sends_tail == NULL)
+                {
+                    socket_io->pending_sends_head = pending_send;
+                }
+                else
+                {
+                    socket_io->pending_sends_tail->next = pending_send;
+                }
+                socket_io->pending_sends_tail = pending_send;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void socketio_dowork(CONCRETE_IO_HANDLE socket_io_handle)
+{
+    SOCKET_IO_INSTANCE* socket_io = (SOCKET_IO_INSTANCE*)socket_io_handle;
+
+    if (socket_io != NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_024: [ socketio_dowork shall complete a pending connection, send the queued bytes and pass the received bytes to `on_bytes_received` without blocking; if the peer closes the connection or an error occurs, it shall call `on_io_error`. ] */
+        if (socket_io->state == SOCKET_IO_STATE_CONNECTING)
+        {
+            complete_connect(socket_io);
+        }
+
+        send_pending_bytes(socket_io);
+        receive_bytes(socket_io);
+    }
+}
+
+static int socketio_setoption(CONCRETE_IO_HANDLE socket_io_handle, const char* option_name, const void* value)
+{
+    (void)socket_io_handle;
+    (void)value;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_025: [ socketio_setoption shall fail and return a non-zero value, since the socket I/O has no option. ] */
+    LogError("Option %s is not supported by the reactor socket I/O", (option_name == NULL) ? "NULL" : option_name);
+    return __FAILURE__;
+}
+
+static void* socketio_clone_option(const char* name, const void* value)
+{
+    (void)value;
+    LogError("Option %s is not supported by the reactor socket I/O", name);
+    return NULL;
+}
+
+static void socketio_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE socket_io_handle)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (socket_io_handle == NULL)
+    {
+        LogError("Invalid argument (socket_io_handle is NULL)");
+        result = NULL;
+    }
+    else if ((result = OptionHandler_Create(socketio_clone_option, socketio_destroy_option, socketio_setoption)) == NULL)
+    {
+        LogError("OptionHandler_Create failed");
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
+{
+    socketio_retrieveoptions,
+    socketio_create,
+    socketio_destroy,
+    socketio_open,
+    socketio_close,
+    socketio_send,
+    socketio_dowork,
+    socketio_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* mqtt_reactor_get_socketio_interface(void)
+{
+    return &socket_io_interface_description;
+}
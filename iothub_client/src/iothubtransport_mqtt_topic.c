@@ -0,0 +1,403 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothubtransport_mqtt_topic.h"
+
+static const char TOPIC_DEVICE_TWIN_PREFIX[] = "$iothub/twin/";
+static const char TOPIC_DEVICE_METHOD_PREFIX[] = "$iothub/methods/";
+static const char TOPIC_C2D_DEVICES_PREFIX[] = "devices/";
+static const char TOPIC_C2D_DEVICEBOUND_PREFIX[] = "messages/devicebound/";
+static const char TOPIC_TWIN_PATCH[] = "PATCH";
+static const char REQUEST_ID_PROPERTY[] = "$rid";
+
+#define TOPIC_SEGMENT_SEPARATOR     '/'
+#define TOPIC_QUERY_SEPARATOR       '?'
+#define PROPERTY_SEPARATOR          '&'
+#define PROPERTY_VALUE_SEPARATOR    '='
+#define URL_ESCAPE                  '%'
+
+static int to_upper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? (c - 'a' + 'A') : c;
+}
+
+// Returns the number of characters of `prefix` matched at the start of `topic`, or 0 if it does not match.
+static size_t match_prefix(const char* topic, const char* prefix, size_t prefix_length, bool ignore_case)
+{
+    size_t index;
+
+    for (index = 0; index < prefix_length; index++)
+    {
+        // The NUL terminator of a shorter topic never matches, so the topic is not read past its end.
+        if (ignore_case ? (to_upper(topic[index]) != to_upper(prefix[index])) : (topic[index] != prefix[index]))
+        {
+            break;
+        }
+    }
+
+    return (index == prefix_length) ? prefix_length : 0;
+}
+
+// Returns the end of the segment starting at `position`: the next '/' or '?', or the end of the topic.
+static const char* find_segment_end(const char* position)
+{
+    while (*position != '\0' && *position != TOPIC_SEGMENT_SEPARATOR && *position != TOPIC_QUERY_SEPARATOR)
+    {
+        position++;
+    }
+    return position;
+}
+
+static MQTT_TOPIC_SLICE find_query(const char* position)
+{
+    MQTT_TOPIC_SLICE query;
+
+    while (*position != '\0' && *position != TOPIC_QUERY_SEPARATOR)
+    {
+        position++;
+    }
+
+    if (*position == TOPIC_QUERY_SEPARATOR)
+    {
+        position++;
+    }
+
+    query.value = position;
+    query.length = strlen(position);
+    return query;
+}
+
+static bool is_slice_equal(const MQTT_TOPIC_SLICE* slice, const char* text, size_t text_length)
+{
+    return slice->length == text_length && memcmp(slice->value, text, text_length) == 0;
+}
+
+static size_t slice_to_size_t(const MQTT_TOPIC_SLICE* slice)
+{
+    size_t result = 0;
+    size_t index;
+
+    for (index = 0; index < slice->length && slice->value[index] >= '0' && slice->value[index] <= '9'; index++)
+    {
+        result = (result * 10) + (size_t)(slice->value[index] - '0');
+    }
+    return result;
+}
+
+static bool find_request_id(MQTT_TOPIC_SLICE properties, MQTT_TOPIC_SLICE* request_id)
+{
+    bool result = false;
+    MQTT_TOPIC_SLICE name;
+    MQTT_TOPIC_SLICE value;
+
+    while (mqtt_topic_get_next_property(&properties, &name, &value) == 0)
+    {
+        if (value.value != NULL && is_slice_equal(&name, REQUEST_ID_PROPERTY, sizeof(REQUEST_ID_PROPERTY) - 1))
+        {
+            *request_id = value;
+            result = true;
+            break;
+        }
+    }
+    return result;
+}
+
+static int parse_device_twin_topic(const char* position, MQTT_TOPIC_INFO* topic_info)
+{
+    int result;
+    MQTT_TOPIC_SLICE operation;
+
+    operation.value = position;
+    operation.length = (size_t)(find_segment_end(position) - position);
+    position += operation.length;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_003: [ If `topic` starts with `$iothub/twin/` (case-insensitive) followed by the segment `PATCH`, mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_TWIN_DESIRED_PATCH. ] */
+    if (is_slice_equal(&operation, TOPIC_TWIN_PATCH, sizeof(TOPIC_TWIN_PATCH) - 1))
+    {
+        topic_info->type = MQTT_TOPIC_TYPE_TWIN_DESIRED_PATCH;
+        topic_info->properties = find_query(position);
+        result = 0;
+    }
+    else if (operation.length == 0 || *position != TOPIC_SEGMENT_SEPARATOR || position[1] == '\0')
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_004: [ ... If the status code segment is missing, mqtt_topic_parse shall fail and return a non-zero value. ] */
+        LogError("Device twin topic has no status code.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        MQTT_TOPIC_SLICE status_code;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_004: [ Otherwise, for a topic starting with `$iothub/twin/`, mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_TWIN_RESPONSE, `status_code` to the number in the segment following the operation and `twin_request_id` to the number in the `$rid` property, or 0 if there is none. ... ] */
+        position++;
+        status_code.value = position;
+        status_code.length = (size_t)(find_segment_end(position) - position);
+        position += status_code.length;
+
+        topic_info->type = MQTT_TOPIC_TYPE_TWIN_RESPONSE;
+        topic_info->status_code = (int)slice_to_size_t(&status_code);
+        topic_info->properties = find_query(position);
+        if (find_request_id(topic_info->properties, &topic_info->request_id))
+        {
+            topic_info->twin_request_id = slice_to_size_t(&topic_info->request_id);
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_device_method_topic(const char* position, MQTT_TOPIC_INFO* topic_info)
+{
+    int result;
+
+    // Skips the HTTP verb ("POST").
+    position = find_segment_end(position);
+    if (*position != TOPIC_SEGMENT_SEPARATOR)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_005: [ ... If the method name or the `$rid` property is missing or empty, mqtt_topic_parse shall fail and return a non-zero value. ] */
+        LogError("Device method topic has no method name.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_005: [ If `topic` starts with `$iothub/methods/` (case-insensitive), mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST, `method_name` to the segment following the HTTP verb and `request_id` to the value of the `$rid` property. ... ] */
+        position++;
+        topic_info->method_name.value = position;
+        topic_info->method_name.length = (size_t)(find_segment_end(position) - position);
+        position += topic_info->method_name.length;
+
+        topic_info->type = MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST;
+        topic_info->properties = find_query(position);
+
+        if (topic_info->method_name.length == 0 ||
+            !find_request_id(topic_info->properties, &topic_info->request_id) ||
+            topic_info->request_id.length == 0)
+        {
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_005: [ ... If the method name or the `$rid` property is missing or empty, mqtt_topic_parse shall fail and return a non-zero value. ] */
+            LogError("Device method topic has no method name or request id.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void parse_c2d_topic(const char* topic, MQTT_TOPIC_INFO* topic_info)
+{
+    const char* position = topic;
+    size_t matched;
+
+    topic_info->type = MQTT_TOPIC_TYPE_C2D_MESSAGE;
+
+    /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_006: [ Any other topic shall be a MQTT_TOPIC_TYPE_C2D_MESSAGE, whose `properties` are what follows `devices/{device id}/messages/devicebound/`, or what follows the last '/' of a topic of another form. ] */
+    if ((matched = match_prefix(position, TOPIC_C2D_DEVICES_PREFIX, sizeof(TOPIC_C2D_DEVICES_PREFIX) - 1, false)) != 0)
+    {
+        position += matched;
+        while (*position != '\0' && *position != TOPIC_SEGMENT_SEPARATOR)
+        {
+            position++;
+        }
+
+        if (*position == TOPIC_SEGMENT_SEPARATOR &&
+            (matched = match_prefix(position + 1, TOPIC_C2D_DEVICEBOUND_PREFIX, sizeof(TOPIC_C2D_DEVICEBOUND_PREFIX) - 1, false)) != 0)
+        {
+            position += 1 + matched;
+        }
+        else
+        {
+            matched = 0;
+        }
+    }
+
+    if (matched == 0)
+    {
+        const char* last_separator = strrchr(topic, TOPIC_SEGMENT_SEPARATOR);
+        position = (last_separator == NULL) ? topic : last_separator + 1;
+    }
+
+    topic_info->properties.value = position;
+    topic_info->properties.length = strlen(position);
+}
+
+int mqtt_topic_parse(const char* topic, MQTT_TOPIC_INFO* topic_info)
+{
+    int result;
+
+    if (topic == NULL || topic_info == NULL)
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_001: [ If `topic` or `topic_info` is NULL, mqtt_topic_parse shall fail and return a non-zero value. ] */
+        LogError("Invalid argument (topic=%p, topic_info=%p)", topic, topic_info);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t matched;
+
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_002: [ mqtt_topic_parse shall not allocate memory, and all the slices it returns shall point into `topic`. ] */
+        (void)memset(topic_info, 0, sizeof(MQTT_TOPIC_INFO));
+
+        if ((matched = match_prefix(topic, TOPIC_DEVICE_TWIN_PREFIX, sizeof(TOPIC_DEVICE_TWIN_PREFIX) - 1, true)) != 0)
+        {
+            result = parse_device_twin_topic(topic + matched, topic_info);
+        }
+        else if ((matched = match_prefix(topic, TOPIC_DEVICE_METHOD_PREFIX, sizeof(TOPIC_DEVICE_METHOD_PREFIX) - 1, true)) != 0)
+        {
+            result = parse_device_method_topic(topic + matched, topic_info);
+        }
+        else
+        {
+            parse_c2d_topic(topic, topic_info);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int mqtt_topic_get_next_property(MQTT_TOPIC_SLICE* properties, MQTT_TOPIC_SLICE* name, MQTT_TOPIC_SLICE* value)
+{
+    int result;
+
+    if (properties == NULL || name == NULL || value == NULL || (properties->value == NULL && properties->length > 0))
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_007: [ If `properties`, `name` or `value` is NULL, mqtt_topic_get_next_property shall fail and return a non-zero value. ] */
+        LogError("Invalid argument (properties=%p, name=%p, value=%p)", properties, name, value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_009: [ When `properties` has no pair left, mqtt_topic_get_next_property shall return a non-zero value. ] */
+        result = __FAILURE__;
+
+        while (properties->length > 0)
+        {
+            const char* pair = properties->value;
+            size_t pair_length = 0;
+            size_t name_length;
+
+            while (pair_length < properties->length && pair[pair_length] != PROPERTY_SEPARATOR)
+            {
+                pair_length++;
+            }
+
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_008: [ mqtt_topic_get_next_property shall remove the next '&'-separated pair from the front of `properties`, skipping empty pairs, and set `name` to the text before its first '=' and `value` to the text after it, or `value->value` to NULL if it has no '='. ] */
+            properties->value += pair_length;
+            properties->length -= pair_length;
+            if (properties->length > 0)
+            {
+                properties->value++;
+                properties->length--;
+            }
+
+            if (pair_length > 0)
+            {
+                for (name_length = 0; name_length < pair_length && pair[name_length] != PROPERTY_VALUE_SEPARATOR; name_length++)
+                {
+                }
+
+                name->value = pair;
+                name->length = name_length;
+                if (name_length < pair_length)
+                {
+                    value->value = pair + name_length + 1;
+                    value->length = pair_length - name_length - 1;
+                }
+                else
+                {
+                    value->value = NULL;
+                    value->length = 0;
+                }
+
+                result = 0;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int hex_digit_value(char c)
+{
+    int result;
+
+    if (c >= '0' && c <= '9')
+    {
+        result = c - '0';
+    }
+    else if (c >= 'a' && c <= 'f')
+    {
+        result = c - 'a' + 10;
+    }
+    else if (c >= 'A' && c <= 'F')
+    {
+        result = c - 'A' + 10;
+    }
+    else
+    {
+        result = -1;
+    }
+
+    return result;
+}
+
+int mqtt_topic_url_decode(const MQTT_TOPIC_SLICE* encoded, char* buffer, size_t buffer_size)
+{
+    int result;
+
+    if (encoded == NULL || buffer == NULL || buffer_size == 0 || (encoded->value == NULL && encoded->length > 0))
+    {
+        /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_010: [ If `encoded` or `buffer` is NULL, or `buffer_size` is 0, mqtt_topic_url_decode shall fail and return a non-zero value. ] */
+        LogError("Invalid argument (encoded=%p, buffer=%p, buffer_size=%lu)", encoded, buffer, (unsigned long)buffer_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t in = 0;
+        size_t out = 0;
+
+        result = 0;
+
+        while (in < encoded->length)
+        {
+            int high;
+            int low;
+
+            if (out + 1 >= buffer_size)
+            {
+                /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_012: [ If the decoded text and its NUL terminator do not fit in `buffer_size` bytes, mqtt_topic_url_decode shall fail and return a non-zero value. ] */
+                LogError("Buffer too small to URL-decode the topic property.");
+                result = __FAILURE__;
+                break;
+            }
+
+            /* Codes_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_011: [ mqtt_topic_url_decode shall replace each `%` followed by two hexadecimal digits by the character they encode, copy every other character as is, and NUL-terminate `buffer`. ] */
+            if (encoded->value[in] == URL_ESCAPE && in + 2 < encoded->length &&
+                (high = hex_digit_value(encoded->value[in + 1])) >= 0 &&
+                (low = hex_digit_value(encoded->value[in + 2])) >= 0)
+            {
+                buffer[out++] = (char)((high << 4) | low);
+                in += 3;
+            }
+            else
+            {
+                buffer[out++] = encoded->value[in++];
+            }
+        }
+
+        buffer[(result == 0) ? out : 0] = '\0';
+    }
+
+    return result;
+}
@@ -14,6 +14,9 @@
 #include "azure_uamqp_c/message_sender.h"
 #include "iothubtransportamqp_methods.h"
 
+/* Number of released method handles kept around for reuse, so that bursts of method requests do not hit the heap for every request */
+#define MAX_FREE_METHOD_REQUEST_HANDLES 16
+
 typedef enum SUBSCRIBE_STATE_TAG
 {
     SUBSCRIBE_STATE_NOT_SUBSCRIBED,
@@ -35,8 +38,9 @@ typedef struct IOTHUBTRANSPORT_AMQP_METHODS_TAG
     ON_METHODS_UNSUBSCRIBED on_methods_unsubscribed;
     void* on_methods_unsubscribed_context;
     SUBSCRIBE_STATE subscribe_state;
-    IOTHUBTRANSPORT_AMQP_METHOD_HANDLE* method_request_handles;
-    size_t method_request_handle_count;
+    struct IOTHUBTRANSPORT_AMQP_METHOD_TAG* method_request_handles;
+    struct IOTHUBTRANSPORT_AMQP_METHOD_TAG* free_method_request_handles;
+    size_t free_method_request_handle_count;
     bool receiver_link_disconnected;
     bool sender_link_disconnected;
 } IOTHUBTRANSPORT_AMQP_METHODS;
@@ -52,39 +56,83 @@ typedef struct IOTHUBTRANSPORT_AMQP_METHOD_TAG
 {
     IOTHUBTRANSPORT_AMQP_METHODS_HANDLE iothubtransport_amqp_methods_handle;
     uuid correlation_id;
+    /* links in the list of tracked handles, or in the free list (next only) once the handle has been released */
+    struct IOTHUBTRANSPORT_AMQP_METHOD_TAG* previous;
+    struct IOTHUBTRANSPORT_AMQP_METHOD_TAG* next;
 } IOTHUBTRANSPORT_AMQP_METHOD;
 
-static void remove_tracked_handle(IOTHUBTRANSPORT_AMQP_METHODS* amqp_methods_handle, IOTHUBTRANSPORT_AMQP_METHOD_HANDLE method_request_handle)
+static IOTHUBTRANSPORT_AMQP_METHOD* get_method_handle(IOTHUBTRANSPORT_AMQP_METHODS* amqp_methods_handle)
 {
-    size_t i;
+    IOTHUBTRANSPORT_AMQP_METHOD* result = amqp_methods_handle->free_method_request_handles;
 
-    for (i = 0; i < amqp_methods_handle->method_request_handle_count; i++)
+    if (result != NULL)
     {
-        if (amqp_methods_handle->method_request_handles[i] == method_request_handle)
-        {
-            if (amqp_methods_handle->method_request_handle_count - i > 1)
-            {
-                (void)memmove(&amqp_methods_handle->method_request_handles[i], &amqp_methods_handle->method_request_handles[i + 1],
-                    (amqp_methods_handle->method_request_handle_count - i - 1) * sizeof(IOTHUBTRANSPORT_AMQP_METHOD_HANDLE));
-            }
+        amqp_methods_handle->free_method_request_handles = result->next;
+        amqp_methods_handle->free_method_request_handle_count--;
+    }
+    else
+    {
+        result = (IOTHUBTRANSPORT_AMQP_METHOD*)malloc(sizeof(IOTHUBTRANSPORT_AMQP_METHOD));
+    }
 
-            amqp_methods_handle->method_request_handle_count--;
-            i--;
-        }
+    return result;
+}
+
+static void release_method_handle(IOTHUBTRANSPORT_AMQP_METHODS* amqp_methods_handle, IOTHUBTRANSPORT_AMQP_METHOD* method_request_handle)
+{
+    if (amqp_methods_handle->free_method_request_handle_count < MAX_FREE_METHOD_REQUEST_HANDLES)
+    {
+        method_request_handle->previous = NULL;
+        method_request_handle->next = amqp_methods_handle->free_method_request_handles;
+        amqp_methods_handle->free_method_request_handles = method_request_handle;
+        amqp_methods_handle->free_method_request_handle_count++;
     }
+    else
+    {
+        free(method_request_handle);
+    }
+}
+
+static void add_tracked_handle(IOTHUBTRANSPORT_AMQP_METHODS* amqp_methods_handle, IOTHUBTRANSPORT_AMQP_METHOD* method_request_handle)
+{
+    method_request_handle->previous = NULL;
+    method_request_handle->next = amqp_methods_handle->method_request_handles;
+
+    if (amqp_methods_handle->method_request_handles != NULL)
+    {
+        amqp_methods_handle->method_request_handles->previous = method_request_handle;
+    }
+
+    amqp_methods_handle->method_request_handles = method_request_handle;
+}
 
-    if (amqp_methods_handle->method_request_handle_count == 0)
+static void remove_tracked_handle(IOTHUBTRANSPORT_AMQP_METHODS* amqp_methods_handle, IOTHUBTRANSPORT_AMQP_METHOD* method_request_handle)
+{
+    if (method_request_handle->previous != NULL)
     {
-        free(amqp_methods_handle->method_request_handles);
-        amqp_methods_handle->method_request_handles = NULL;
+        method_request_handle->previous->next = method_request_handle->next;
     }
     else
     {
-        IOTHUBTRANSPORT_AMQP_METHOD_HANDLE* new_handles = (IOTHUBTRANSPORT_AMQP_METHOD_HANDLE*)realloc(amqp_methods_handle->method_request_handles, amqp_methods_handle->method_request_handle_count * sizeof(IOTHUBTRANSPORT_AMQP_METHOD_HANDLE));
-        if (new_handles != NULL)
-        {
-            amqp_methods_handle->method_request_handles = new_handles;
-        }
+        amqp_methods_handle->method_request_handles = method_request_handle->next;
+    }
+
+    if (method_request_handle->next != NULL)
+    {
+        method_request_handle->next->previous = method_request_handle->previous;
+    }
+
+    method_request_handle->previous = NULL;
+    method_request_handle->next = NULL;
+}
+
+static void free_method_handle_list(IOTHUBTRANSPORT_AMQP_METHOD* method_request_handle)
+{
+    while (method_request_handle != NULL)
+    {
+        IOTHUBTRANSPORT_AMQP_METHOD* next = method_request_handle->next;
+        free(method_request_handle);
+        method_request_handle = next;
     }
 }
 
@@ -134,7 +182,8 @@ IOTHUBTRANSPORT_AMQP_METHODS_HANDLE iothubtransportamqp_methods_create(const cha
                 {
                     result->subscribe_state = SUBSCRIBE_STATE_NOT_SUBSCRIBED;
                     result->method_request_handles = NULL;
-                    result->method_request_handle_count = 0;
+                    result->free_method_request_handles = NULL;
+                    result->free_method_request_handle_count = 0;
                     result->receiver_link_disconnected = false;
                     result->sender_link_disconnected = false;
                 }
@@ -154,23 +203,15 @@ void iothubtransportamqp_methods_destroy(IOTHUBTRANSPORT_AMQP_METHODS_HANDLE iot
     }
     else
     {
-        size_t i;
-
         /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_007: [ If the instance pointed to by `iothubtransport_amqp_methods_handle` is subscribed to receive C2D methods, `iothubtransportamqp_methods_destroy` shall free all resources allocated by the subscribe. ]*/
         if (iothubtransport_amqp_methods_handle->subscribe_state == SUBSCRIBE_STATE_SUBSCRIBED)
         {
             iothubtransportamqp_methods_unsubscribe(iothubtransport_amqp_methods_handle);
         }
 
-        for (i = 0; i < iothubtransport_amqp_methods_handle->method_request_handle_count; i++)
-        {
-            free(iothubtransport_amqp_methods_handle->method_request_handles[i]);
-        }
-
-        if (iothubtransport_amqp_methods_handle->method_request_handles != NULL)
-        {
-            free(iothubtransport_amqp_methods_handle->method_request_handles);
-        }
+        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_156: [ `iothubtransportamqp_methods_destroy` shall free all tracked method handles and all method handles kept in the free list. ]*/
+        free_method_handle_list(iothubtransport_amqp_methods_handle->method_request_handles);
+        free_method_handle_list(iothubtransport_amqp_methods_handle->free_method_request_handles);
 
         /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_005: [ `iothubtransportamqp_methods_destroy` shall free all resources allocated by `iothubtransportamqp_methods_create` for the handle `iothubtransport_amqp_methods_handle`. ]*/
         free(iothubtransport_amqp_methods_handle->hostname);
@@ -283,8 +324,8 @@ static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE messag
             }
             else
             {
-                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_112: [ Memory shall be allocated for the `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` to hold the correlation-id, so that it can be used in the `iothubtransportamqp_methods_respond` function. ]*/
-                IOTHUBTRANSPORT_AMQP_METHOD* method_handle = (IOTHUBTRANSPORT_AMQP_METHOD*)malloc(sizeof(IOTHUBTRANSPORT_AMQP_METHOD));
+                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_112: [ An `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` shall be taken from the free list of released handles, or allocated if the free list is empty, to hold the correlation-id, so that it can be used in the `iothubtransportamqp_methods_respond` function. ]*/
+                IOTHUBTRANSPORT_AMQP_METHOD* method_handle = get_method_handle(amqp_methods_handle);
                 if (method_handle == NULL)
                 {
                     /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_130: [ If allocating memory for the `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` handle fails, the RELEASED outcome shall be returned and an error shall be indicated. ]*/
@@ -293,154 +334,138 @@ static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE messag
                 }
                 else
                 {
-                    IOTHUBTRANSPORT_AMQP_METHOD_HANDLE* new_handles;
-                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_113: [ All `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` handles shall be tracked in an array of handles that shall be resized accordingly when a methopd handle is added to it. ]*/
-                    new_handles = (IOTHUBTRANSPORT_AMQP_METHOD_HANDLE*)realloc(amqp_methods_handle->method_request_handles, (amqp_methods_handle->method_request_handle_count + 1) * sizeof(IOTHUBTRANSPORT_AMQP_METHOD_HANDLE));
-                    if (new_handles == NULL)
+                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_121: [ The uuid value for the correlation ID shall be obtained by calling `amqpvalue_get_uuid`. ]*/
+                    if (amqpvalue_get_uuid(correlation_id, &method_handle->correlation_id) != 0)
                     {
-                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_138: [ If resizing the tracked method handles array fails, the RELEASED outcome shall be returned and an error shall be indicated. ]*/
-                        free(method_handle);
-                        LogError("Cannot grow method handles array");
-                        message_outcome = MESSAGE_OUTCOME_RELEASED;
+                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_122: [ If `amqpvalue_get_uuid` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
+                        release_method_handle(amqp_methods_handle, method_handle);
+                        LogError("Cannot get uuid value for correlation-id");
+                        message_outcome = MESSAGE_OUTCOME_REJECTED;
+                        result = messaging_delivery_rejected("amqp:decode-error", "Cannot get uuid value for correlation-id");
                     }
                     else
                     {
-                        amqp_methods_handle->method_request_handles = new_handles;
+                        BINARY_DATA binary_data;
 
-                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_121: [ The uuid value for the correlation ID shall be obtained by calling `amqpvalue_get_uuid`. ]*/
-                        if (amqpvalue_get_uuid(correlation_id, &method_handle->correlation_id) != 0)
+                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_048: [ - The message payload shall be obtained by calling `message_get_body_amqp_data_in_place` with the index argument being 0. ]*/
+                        if (message_get_body_amqp_data_in_place(message, 0, &binary_data) != 0)
                         {
-                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_122: [ If `amqpvalue_get_uuid` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
-                            free(method_handle);
-                            LogError("Cannot get uuid value for correlation-id");
+                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_049: [ If `message_get_body_amqp_data_in_place` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
+                            release_method_handle(amqp_methods_handle, method_handle);
+                            LogError("Cannot get method request message payload");
                             message_outcome = MESSAGE_OUTCOME_REJECTED;
-                            result = messaging_delivery_rejected("amqp:decode-error", "Cannot get uuid value for correlation-id");
+                            result = messaging_delivery_rejected("amqp:decode-error", "Cannot get method request message payload");
                         }
                         else
                         {
-                            BINARY_DATA binary_data;
+                            AMQP_VALUE application_properties;
 
-                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_048: [ - The message payload shall be obtained by calling `message_get_body_amqp_data_in_place` with the index argument being 0. ]*/
-                            if (message_get_body_amqp_data_in_place(message, 0, &binary_data) != 0)
+                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_099: [ The application properties for the received message shall be obtained by calling `message_get_application_properties`. ]*/
+                            if (message_get_application_properties(message, &application_properties) != 0)
                             {
-                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_049: [ If `message_get_body_amqp_data_in_place` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
-                                free(method_handle);
-                                LogError("Cannot get method request message payload");
+                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_133: [ If `message_get_application_properties` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
+                                LogError("Cannot get application properties");
+                                release_method_handle(amqp_methods_handle, method_handle);
                                 message_outcome = MESSAGE_OUTCOME_REJECTED;
-                                result = messaging_delivery_rejected("amqp:decode-error", "Cannot get method request message payload");
+                                result = messaging_delivery_rejected("amqp:decode-error", "Cannot get application properties");
                             }
                             else
                             {
-                                AMQP_VALUE application_properties;
-
-                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_099: [ The application properties for the received message shall be obtained by calling `message_get_application_properties`. ]*/
-                                if (message_get_application_properties(message, &application_properties) != 0)
+                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_123: [ The AMQP map shall be retrieve from the application properties by calling `amqpvalue_get_inplace_described_value`. ]*/
+                                AMQP_VALUE amqp_properties_map = amqpvalue_get_inplace_described_value(application_properties);
+                                if (amqp_properties_map == NULL)
                                 {
-                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_133: [ If `message_get_application_properties` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
-                                    LogError("Cannot get application properties");
-                                    free(method_handle);
-                                    message_outcome = MESSAGE_OUTCOME_REJECTED;
-                                    result = messaging_delivery_rejected("amqp:decode-error", "Cannot get application properties");
+                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_134: [ If `amqpvalue_get_inplace_described_value` fails the RELEASED outcome with `amqp:decode-error` shall be returned. ]*/
+                                    LogError("Cannot get application properties map");
+                                    release_method_handle(amqp_methods_handle, method_handle);
+                                    message_outcome = MESSAGE_OUTCOME_RELEASED;
                                 }
                                 else
                                 {
-                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_123: [ The AMQP map shall be retrieve from the application properties by calling `amqpvalue_get_inplace_described_value`. ]*/
-                                    AMQP_VALUE amqp_properties_map = amqpvalue_get_inplace_described_value(application_properties);
-                                    if (amqp_properties_map == NULL)
+                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_100: [ A property key `IoThub-methodname` shall be created by calling `amqpvalue_create_string`. ]*/
+                                    AMQP_VALUE property_key = amqpvalue_create_string("IoThub-methodname");
+                                    if (property_key == NULL)
                                     {
-                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_134: [ If `amqpvalue_get_inplace_described_value` fails the RELEASED outcome with `amqp:decode-error` shall be returned. ]*/
-                                        LogError("Cannot get application properties map");
-                                        free(method_handle);
+                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_132: [ If `amqpvalue_create_string` fails the RELEASED outcome shall be returned. ]*/
+                                        LogError("Cannot create the property key for method name");
+                                        release_method_handle(amqp_methods_handle, method_handle);
                                         message_outcome = MESSAGE_OUTCOME_RELEASED;
                                     }
                                     else
                                     {
-                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_100: [ A property key `IoThub-methodname` shall be created by calling `amqpvalue_create_string`. ]*/
-                                        AMQP_VALUE property_key = amqpvalue_create_string("IoThub-methodname");
-                                        if (property_key == NULL)
+                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_101: [ The method name property value shall be found in the map by calling `amqpvalue_get_map_value`. ]*/
+                                        AMQP_VALUE property_value = amqpvalue_get_map_value(amqp_properties_map, property_key);
+                                        if (property_value == NULL)
                                         {
-                                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_132: [ If `amqpvalue_create_string` fails the RELEASED outcome shall be returned. ]*/
-                                            LogError("Cannot create the property key for method name");
-                                            free(method_handle);
-                                            message_outcome = MESSAGE_OUTCOME_RELEASED;
+                                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_103: [ If `amqpvalue_get_map_value` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
+                                            LogError("Cannot find the IoThub-methodname property in the properties map");
+                                            release_method_handle(amqp_methods_handle, method_handle);
+                                            message_outcome = MESSAGE_OUTCOME_REJECTED;
+                                            result = messaging_delivery_rejected("amqp:decode-error", "Cannot find the IoThub-methodname property in the properties map");
                                         }
                                         else
                                         {
-                                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_101: [ The method name property value shall be found in the map by calling `amqpvalue_get_map_value`. ]*/
-                                            AMQP_VALUE property_value = amqpvalue_get_map_value(amqp_properties_map, property_key);
-                                            if (property_value == NULL)
+                                            const char* method_name;
+
+                                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_102: [ The string contained by the property value shall be obtained by calling `amqpvalue_get_string`. ]*/
+                                            if (amqpvalue_get_string(property_value, &method_name) != 0)
                                             {
-                                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_103: [ If `amqpvalue_get_map_value` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
-                                                LogError("Cannot find the IoThub-methodname property in the properties map");
-                                                free(method_handle);
+                                                /*Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_131: [ If `amqpvalue_get_string` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
+                                                LogError("Cannot read the method name from the property value");
+                                                release_method_handle(amqp_methods_handle, method_handle);
                                                 message_outcome = MESSAGE_OUTCOME_REJECTED;
-                                                result = messaging_delivery_rejected("amqp:decode-error", "Cannot find the IoThub-methodname property in the properties map");
+                                                result = messaging_delivery_rejected("amqp:decode-error", "Cannot read the method name from the property value");
                                             }
                                             else
                                             {
-                                                const char* method_name;
-
-                                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_102: [ The string contained by the property value shall be obtained by calling `amqpvalue_get_string`. ]*/
-                                                if (amqpvalue_get_string(property_value, &method_name) != 0)
+                                                /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_056: [ On success the `on_message_received` callback shall return a newly constructed delivery state obtained by calling `messaging_delivery_accepted`. ]*/
+                                                result = messaging_delivery_accepted();
+                                                if (result == NULL)
                                                 {
-                                                    /*Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_131: [ If `amqpvalue_get_string` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
-                                                    LogError("Cannot read the method name from the property value");
-                                                    free(method_handle);
-                                                    message_outcome = MESSAGE_OUTCOME_REJECTED;
-                                                    result = messaging_delivery_rejected("amqp:decode-error", "Cannot read the method name from the property value");
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_057: [ If `messaging_delivery_accepted` fails the RELEASED outcome with `amqp:decode-error` shall be returned. ]*/
+                                                    LogError("Cannot allocate memory for delivery state");
+                                                    release_method_handle(amqp_methods_handle, method_handle);
+                                                    message_outcome = MESSAGE_OUTCOME_RELEASED;
                                                 }
                                                 else
                                                 {
-                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_056: [ On success the `on_message_received` callback shall return a newly constructed delivery state obtained by calling `messaging_delivery_accepted`. ]*/
-                                                    result = messaging_delivery_accepted();
-                                                    if (result == NULL)
+                                                    method_handle->iothubtransport_amqp_methods_handle = amqp_methods_handle;
+
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_113: [ All `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` handles shall be tracked in an intrusive doubly linked list of outstanding handles. ]*/
+                                                    add_tracked_handle(amqp_methods_handle, method_handle);
+
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_050: [ The binary message payload shall be indicated by calling the `on_method_request_received` callback passed to `iothubtransportamqp_methods_subscribe` with the arguments: ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_051: [ - `context` shall be set to the `on_method_request_received_context` argument passed to `iothubtransportamqp_methods_subscribe`. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_098: [ - `method_name` shall be set to the application property value for `IoThub-methodname`. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_052: [ - `request` shall be set to the payload bytes obtained by calling `message_get_body_amqp_data_in_place`. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_053: [ - `request_size` shall be set to the payload size obtained by calling `message_get_body_amqp_data_in_place`. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_054: [ - `method_handle` shall be set to a newly created `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` that can be passed later as an argument to `iothubtransportamqp_methods_respond`. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_109: [ `iothubtransportamqp_methods_respond` shall be allowed to be called from the callback `on_method_request_received`. ]*/
+                                                    if (amqp_methods_handle->on_method_request_received(amqp_methods_handle->on_method_request_received_context, method_name, binary_data.bytes, binary_data.length, method_handle) != 0)
                                                     {
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_057: [ If `messaging_delivery_accepted` fails the RELEASED outcome with `amqp:decode-error` shall be returned. ]*/
-                                                        LogError("Cannot allocate memory for delivery state");
-                                                        free(method_handle);
-                                                        message_outcome = MESSAGE_OUTCOME_RELEASED;
+                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_147: [ If `on_method_request_received` fails, the REJECTED outcome shall be returned with `amqp:internal-error`. ]*/
+                                                        LogError("Cannot execute the callback with the given data");
+                                                        amqpvalue_destroy(result);
+                                                        remove_tracked_handle(amqp_methods_handle, method_handle);
+                                                        release_method_handle(amqp_methods_handle, method_handle);
+                                                        message_outcome = MESSAGE_OUTCOME_REJECTED;
+                                                        result = messaging_delivery_rejected("amqp:internal-error", "Cannot execute the callback with the given data");
                                                     }
                                                     else
                                                     {
-                                                        method_handle->iothubtransport_amqp_methods_handle = amqp_methods_handle;
-
-                                                        /* set the method request handle in the handle array */
-                                                        amqp_methods_handle->method_request_handles[amqp_methods_handle->method_request_handle_count] = method_handle;
-                                                        amqp_methods_handle->method_request_handle_count++;
-
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_050: [ The binary message payload shall be indicated by calling the `on_method_request_received` callback passed to `iothubtransportamqp_methods_subscribe` with the arguments: ]*/
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_051: [ - `context` shall be set to the `on_method_request_received_context` argument passed to `iothubtransportamqp_methods_subscribe`. ]*/
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_098: [ - `method_name` shall be set to the application property value for `IoThub-methodname`. ]*/
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_052: [ - `request` shall be set to the payload bytes obtained by calling `message_get_body_amqp_data_in_place`. ]*/
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_053: [ - `request_size` shall be set to the payload size obtained by calling `message_get_body_amqp_data_in_place`. ]*/
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_054: [ - `method_handle` shall be set to a newly created `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` that can be passed later as an argument to `iothubtransportamqp_methods_respond`. ]*/
-                                                        /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_109: [ `iothubtransportamqp_methods_respond` shall be allowed to be called from the callback `on_method_request_received`. ]*/
-                                                        if (amqp_methods_handle->on_method_request_received(amqp_methods_handle->on_method_request_received_context, method_name, binary_data.bytes, binary_data.length, method_handle) != 0)
-                                                        {
-                                                            /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_147: [ If `on_method_request_received` fails, the REJECTED outcome shall be returned with `amqp:internal-error`. ]*/
-                                                            LogError("Cannot execute the callback with the given data");
-                                                            amqpvalue_destroy(result);
-                                                            free(method_handle);
-                                                            amqp_methods_handle->method_request_handle_count--;
-                                                            message_outcome = MESSAGE_OUTCOME_REJECTED;
-                                                            result = messaging_delivery_rejected("amqp:internal-error", "Cannot execute the callback with the given data");
-                                                        }
-                                                        else
-                                                        {
-                                                            message_outcome = MESSAGE_OUTCOME_ACCEPTED;
-                                                        }
+                                                        message_outcome = MESSAGE_OUTCOME_ACCEPTED;
                                                     }
                                                 }
-
-                                                amqpvalue_destroy(property_value);
                                             }
 
-                                            amqpvalue_destroy(property_key);
+                                            amqpvalue_destroy(property_value);
                                         }
-                                    }
 
-                                    application_properties_destroy(application_properties);
+                                        amqpvalue_destroy(property_key);
+                                    }
                                 }
+
+                                application_properties_destroy(application_properties);
                             }
                         }
                     }
@@ -975,11 +1000,12 @@ int iothubtransportamqp_methods_respond(IOTHUBTRANSPORT_AMQP_METHOD_HANDLE metho
                                                 }
                                                 else
                                                 {
-                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the array used to track the method handles. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the list used to track the method handles. ]*/
                                                     remove_tracked_handle(method_handle->iothubtransport_amqp_methods_handle, method_handle);
 
-                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_111: [ The handle `method_handle` shall be freed (have no meaning) after `iothubtransportamqp_methods_respond` has been executed. ]*/
-                                                    free(method_handle);
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_111: [ The handle `method_handle` shall be released (have no meaning) after `iothubtransportamqp_methods_respond` has been executed. ]*/
+                                                    /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_155: [ A released handle shall be kept in a free list of at most 16 handles for reuse by the next method request; if the free list is full the handle shall be freed. ]*/
+                                                    release_method_handle(method_handle->iothubtransport_amqp_methods_handle, method_handle);
 
                                                     /* Codes_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_060: [ `iothubtransportamqp_methods_respond` shall construct a response message and on success it shall return 0. ]*/
                                                     result = 0;
@@ -4,12 +4,16 @@
 #include <stdlib.h>
 #include "azure_c_shared_utility/gballoc.h"
 
+#include <stdint.h>
 #include <time.h>
 #include "iothub_client_options.h"
 #include "iothub_client_version.h"
 #include "iothub_client_private.h"
 #include "iothub_transport_ll.h"
 #include "iothubtransporthttp.h"
+#include "iothub_client_tls_session_cache.h"
+#include "iothub_client_hash.h"
+#include "iothubtransport_http_engine.h"
 
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
@@ -23,6 +27,9 @@
 #include "azure_c_shared_utility/vector.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/sastoken.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
 
 #define IOTHUB_APP_PREFIX "iothub-app-"
 static const char* IOTHUB_MESSAGE_ID = "iothub-messageid";
@@ -44,6 +51,15 @@ static const char* IOTHUB_CONTENT_ENCODING_C2D = "ContentEncoding";
 #define MAXIMUM_PAYLOAD_OVERHEAD 384
 #define MAXIMUM_PROPERTY_OVERHEAD 16
 
+/*SAS tokens signed for the connection pool are valid for 1 hour and replaced when less than 10 minutes are left*/
+#define POOL_SAS_TOKEN_LIFETIME_SECS 3600
+#define POOL_SAS_TOKEN_REFRESH_SECS 600
+
+/*with adaptive polling the interval between 2 GETs doubles after each empty GET, up to getMinimumPollingTime*/
+/*each poll is moved by up to 25% of the interval so the devices of a transport do not poll at the same time*/
+#define ADAPTIVE_POLLING_BACKOFF_FACTOR 2
+#define ADAPTIVE_POLLING_JITTER_DIVISOR 4
+
 /*forward declaration*/
 static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, const char* const* values, size_t count);
 
@@ -54,6 +70,12 @@ typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
     bool doBatchedTransfers;
     unsigned int getMinimumPollingTime;
     VECTOR_HANDLE perDeviceList;
+    TLS_SESSION_CACHE_HANDLE tlsSessionCache;
+    HTTP_ENGINE_HANDLE httpEngine;
+    size_t connectionPoolSize; /*0 means events are sent on httpApiExHandle*/
+    bool isProxyConfigured; /*the connections of httpEngine do not go through the proxy, so events are sent on httpApiExHandle*/
+    unsigned int adaptivePollingMinIntervalMs; /*0 means GETs are only throttled by getMinimumPollingTime*/
+    TICK_COUNTER_HANDLE pollingTickCounter;
 }HTTPTRANSPORT_HANDLE_DATA;
 
 typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
@@ -76,6 +98,16 @@ typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
     IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle;
     PDLIST_ENTRY waitingToSend;
     DLIST_ENTRY eventConfirmations; /*holds items for event confirmations*/
+
+    bool isEventRequestInFlight; /*the items in eventConfirmations are being sent on the connection pool*/
+    STRING_HANDLE poolSasTokenScope;
+    STRING_HANDLE poolSasToken;
+    size_t poolSasTokenExpiry;
+
+    bool isPollScheduled; /*adaptive polling: nextPollTimeMs is valid*/
+    tickcounter_ms_t nextPollTimeMs;
+    tickcounter_ms_t pollIntervalMs; /*0 right after a message was received*/
+    uint32_t pollJitterState;
 } HTTPTRANSPORT_PERDEVICE_DATA;
 
 typedef struct MESSAGE_DISPOSITION_CONTEXT_TAG
@@ -611,6 +643,14 @@ static IOTHUB_DEVICE_HANDLE IoTHubTransportHttp_Register(TRANSPORT_LL_HANDLE han
                 result->waitingToSend = waitingToSend;
                 DList_InitializeListHead(&(result->eventConfirmations));
                 result->transportHandle = (HTTPTRANSPORT_HANDLE_DATA *) handle;
+                result->isEventRequestInFlight = false;
+                result->poolSasTokenScope = NULL;
+                result->poolSasToken = NULL;
+                result->poolSasTokenExpiry = 0;
+                result->isPollScheduled = false;
+                result->nextPollTimeMs = 0;
+                result->pollIntervalMs = 0;
+                result->pollJitterState = 0;
             }
             else
             {
@@ -635,6 +675,21 @@ static IOTHUB_DEVICE_HANDLE IoTHubTransportHttp_Register(TRANSPORT_LL_HANDLE han
 }
 
 
+static void destroy_poolSasToken(HTTPTRANSPORT_PERDEVICE_DATA* handleData)
+{
+    /*both are only created when the device sends on the connection pool*/
+    if (handleData->poolSasToken != NULL)
+    {
+        STRING_delete(handleData->poolSasToken);
+        handleData->poolSasToken = NULL;
+    }
+    if (handleData->poolSasTokenScope != NULL)
+    {
+        STRING_delete(handleData->poolSasTokenScope);
+        handleData->poolSasTokenScope = NULL;
+    }
+}
+
 static void destroy_perDeviceData(HTTPTRANSPORT_PERDEVICE_DATA * perDeviceItem)
 {
     destroy_deviceId(perDeviceItem);
@@ -646,6 +701,7 @@ static void destroy_perDeviceData(HTTPTRANSPORT_PERDEVICE_DATA * perDeviceItem)
     destroy_messageHTTPrequestHeaders(perDeviceItem);
     destroy_abandonHTTPrelativePathBegin(perDeviceItem);
     destroy_SASObject(perDeviceItem);
+    destroy_poolSasToken(perDeviceItem);
 }
 
 static IOTHUB_DEVICE_HANDLE* get_perDeviceDataItem(IOTHUB_DEVICE_HANDLE deviceHandle)
@@ -691,6 +747,12 @@ static void IoTHubTransportHttp_Unregister(IOTHUB_DEVICE_HANDLE deviceHandle)
         {
             HTTPTRANSPORT_PERDEVICE_DATA * perDeviceItem = (HTTPTRANSPORT_PERDEVICE_DATA *)(*listItem);
 
+            if (perDeviceItem->isEventRequestInFlight)
+            {
+                /*Codes_SRS_TRANSPORTMULTITHTTP_09_016: [ If an event request of the device is in flight on the connection pool, IoTHubTransportHttp_Unregister shall cancel it by calling `http_engine_cancel_requests` before freeing the device; its items are put back in waitingToSend. ]*/
+                http_engine_cancel_requests(handleData->httpEngine, perDeviceItem);
+            }
+
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_047: [ IoTHubTransportHttp_Unregister shall free all the resources used in the device structure. ]*/
             destroy_perDeviceData(perDeviceItem);
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_048: [ IoTHubTransportHttp_Unregister shall call singlylinkedlist_remove to remove device from devices list. ]*/
@@ -794,8 +856,78 @@ static bool create_perDeviceList(HTTPTRANSPORT_HANDLE_DATA* handleData)
     return result;
 }
 
+static void destroy_tlsSessionCache(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    if (handleData->tlsSessionCache != NULL)
+    {
+        tls_session_cache_destroy(handleData->tlsSessionCache);
+        handleData->tlsSessionCache = NULL;
+    }
+}
+
+static void destroy_pollingTickCounter(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    if (handleData->pollingTickCounter != NULL)
+    {
+        tickcounter_destroy(handleData->pollingTickCounter);
+        handleData->pollingTickCounter = NULL;
+    }
+}
 
-static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONFIG* config)
+static void destroy_httpEngine(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    if (handleData->httpEngine != NULL)
+    {
+        http_engine_destroy(handleData->httpEngine);
+        handleData->httpEngine = NULL;
+    }
+}
+
+/*Codes_SRS_TRANSPORTMULTITHTTP_09_007: [ `IoTHubTransportHttp_Create` shall create an HTTP engine for the hostname by calling `http_engine_create`; the engine has no connections until `OPTION_HTTP_CONNECTION_POOL_SIZE` is set. ]*/
+static void create_httpEngine(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTP_ENGINE_GET_IO_TRANSPORT get_io_transport)
+{
+    HTTP_ENGINE_CONFIG engineConfig;
+    engineConfig.host_name = STRING_c_str(handleData->hostName);
+    engineConfig.get_io_transport = get_io_transport;
+    engineConfig.request_timeout_ms = 0;
+
+    handleData->connectionPoolSize = 0;
+    handleData->isProxyConfigured = false;
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_008: [ If creating the HTTP engine fails, `IoTHubTransportHttp_Create` shall continue without a connection pool. ]*/
+    if ((handleData->httpEngine = http_engine_create(&engineConfig)) == NULL)
+    {
+        LogError("unable to create the HTTP engine; the connection pool will not be available");
+    }
+}
+
+/*Codes_SRS_TRANSPORTMULTITHTTP_09_005: [ `IoTHubTransportHttp_Create` shall create a TLS session cache by calling `tls_session_cache_create` and pass the TLS session store for the hostname, obtained with `tls_session_cache_get_store`, to `HTTPAPIEX_SetOption` as `OPTION_TLS_SESSION_STORE`. ]*/
+static void create_tlsSessionCache(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    const TLS_SESSION_STORE* tlsSessionStore;
+
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_006: [ If creating the TLS session cache or setting the TLS session store fails, `IoTHubTransportHttp_Create` shall continue without TLS session resumption. ]*/
+    if ((handleData->tlsSessionCache = tls_session_cache_create()) == NULL)
+    {
+        LogError("unable to create the TLS session cache; the TLS handshake will not be resumed");
+    }
+    else if ((tlsSessionStore = tls_session_cache_get_store(handleData->tlsSessionCache, STRING_c_str(handleData->hostName))) == NULL)
+    {
+        LogError("unable to get the TLS session store; the TLS handshake will not be resumed");
+        destroy_tlsSessionCache(handleData);
+    }
+    else if (HTTPAPIEX_SetOption(handleData->httpApiExHandle, OPTION_TLS_SESSION_STORE, tlsSessionStore) != HTTPAPIEX_OK)
+    {
+        LogInfo("the HTTP layer does not support TLS session resumption");
+        destroy_tlsSessionCache(handleData);
+    }
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_009: [ Once accepted by `HTTPAPIEX_SetOption`, the TLS session store shall also be passed to `http_engine_set_option`; a failure there shall only be logged. ]*/
+    else if ((handleData->httpEngine != NULL) && (http_engine_set_option(handleData->httpEngine, OPTION_TLS_SESSION_STORE, tlsSessionStore) != 0))
+    {
+        LogInfo("the connection pool does not support TLS session resumption");
+    }
+}
+
+static TRANSPORT_LL_HANDLE createTransport(const IOTHUBTRANSPORT_CONFIG* config, HTTP_ENGINE_GET_IO_TRANSPORT get_io_transport)
 {
     HTTPTRANSPORT_HANDLE_DATA* result;
     if (config == NULL)
@@ -849,6 +981,10 @@ static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONF
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_011: [ Otherwise, IoTHubTransportHttp_Create shall succeed and return a non-NULL value. ]*/
                 result->doBatchedTransfers = false;
                 result->getMinimumPollingTime = DEFAULT_GETMINIMUMPOLLINGTIME;
+                result->adaptivePollingMinIntervalMs = 0;
+                result->pollingTickCounter = NULL;
+                create_httpEngine(result, get_io_transport);
+                create_tlsSessionCache(result);
             }
             else
             {
@@ -863,6 +999,17 @@ static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONF
     return result;
 }
 
+static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONFIG* config)
+{
+    return createTransport(config, NULL);
+}
+
+TRANSPORT_LL_HANDLE IoTHubTransportHttp_CreateWithIoTransport(const IOTHUBTRANSPORT_CONFIG* config, HTTP_ENGINE_GET_IO_TRANSPORT get_io_transport)
+{
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_010: [ `IoTHubTransportHttp_CreateWithIoTransport` shall create the transport like `IoTHubTransportHttp_Create`, with the connections of the pool created by `get_io_transport`. ]*/
+    return createTransport(config, get_io_transport);
+}
+
 static void IoTHubTransportHttp_Destroy(TRANSPORT_LL_HANDLE handle)
 {
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_012: [ IoTHubTransportHttp_Destroy shall do nothing is handle is NULL. ]*/
@@ -873,6 +1020,9 @@ static void IoTHubTransportHttp_Destroy(TRANSPORT_LL_HANDLE handle)
 
         size_t deviceListSize = VECTOR_size(handleData->perDeviceList);
 
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_017: [ IoTHubTransportHttp_Destroy shall destroy the HTTP engine before the devices, so requests still in flight are completed while their devices exist. ]*/
+        destroy_httpEngine(handleData);
+
         /*Codes_SRS_TRANSPORTMULTITHTTP_17_013: [ Otherwise, IoTHubTransportHttp_Destroy shall free all the resources currently in use. ]*/
         for (size_t i = 0; i < deviceListSize; i++)
         {
@@ -885,6 +1035,9 @@ static void IoTHubTransportHttp_Destroy(TRANSPORT_LL_HANDLE handle)
         destroy_hostName((HTTPTRANSPORT_HANDLE_DATA *) handle);
         destroy_httpApiExHandle((HTTPTRANSPORT_HANDLE_DATA *) handle);
         destroy_perDeviceList((HTTPTRANSPORT_HANDLE_DATA *)handle);
+        destroy_tlsSessionCache((HTTPTRANSPORT_HANDLE_DATA *)handle);
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_033: [ IoTHubTransportHttp_Destroy shall destroy the tick counter used for adaptive polling, if any, with `tickcounter_destroy`. ]*/
+        destroy_pollingTickCounter((HTTPTRANSPORT_HANDLE_DATA *)handle);
         free(handle);
     }
 }
@@ -916,6 +1069,9 @@ static int IoTHubTransportHttp_Subscribe(IOTHUB_DEVICE_HANDLE handle)
             perDeviceItem = (HTTPTRANSPORT_PERDEVICE_DATA *)(*listItem);
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_106: [ Otherwise, IoTHubTransportHttp_Subscribe shall set the device so that subsequent calls to DoWork should execute HTTP requests. ]*/
             perDeviceItem->DoWork_PullMessage = true;
+            /*Codes_SRS_TRANSPORTMULTITHTTP_09_031: [ With adaptive polling, IoTHubTransportHttp_Subscribe shall restart the poll schedule of the device. ]*/
+            perDeviceItem->isPollScheduled = false;
+            perDeviceItem->pollIntervalMs = 0;
         }
         result = 0;
     }
@@ -1349,10 +1505,160 @@ static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
     DList_InitializeListHead(source);
 }
 
+static bool isConnectionPoolEnabled(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_034: [ Once `HTTPAPIEX_SetOption` accepted `OPTION_HTTP_PROXY` with a non-NULL `host_address`, events shall be sent with HTTPAPIEX whatever the value of `OPTION_HTTP_CONNECTION_POOL_SIZE`. ]*/
+    return handleData->connectionPoolSize > 0 && !handleData->isProxyConfigured;
+}
+
+static STRING_HANDLE createPoolSasTokenScope(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    /*same resource URI as the one of the device's HTTPAPIEX_SAS_HANDLE: hostname + "/devices/" + URL_ENCODED(deviceId)*/
+    STRING_HANDLE result;
+    STRING_HANDLE urlEncodedDeviceId = URL_Encode(deviceData->deviceId);
+    if (urlEncodedDeviceId == NULL)
+    {
+        LogError("URL_Encode failed");
+        result = NULL;
+    }
+    else
+    {
+        if ((result = STRING_clone(handleData->hostName)) == NULL)
+        {
+            LogError("STRING_clone failed");
+        }
+        else if ((STRING_concat(result, "/devices/") != 0) ||
+            (STRING_concat_with_STRING(result, urlEncodedDeviceId) != 0))
+        {
+            LogError("unable to build the SAS token scope");
+            STRING_delete(result);
+            result = NULL;
+        }
+        STRING_delete(urlEncodedDeviceId);
+    }
+    return result;
+}
+
+static int refreshPoolSasToken(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    int result;
+    time_t now = get_time(NULL);
+    if (now == INDEFINITE_TIME)
+    {
+        LogError("get_time failed");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t secondsSinceEpoch = (size_t)get_difftime(now, (time_t)0);
+        if ((deviceData->poolSasToken != NULL) && (deviceData->poolSasTokenExpiry > secondsSinceEpoch + POOL_SAS_TOKEN_REFRESH_SECS))
+        {
+            result = 0;
+        }
+        else if ((deviceData->poolSasTokenScope == NULL) && ((deviceData->poolSasTokenScope = createPoolSasTokenScope(handleData, deviceData)) == NULL))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t expiry = secondsSinceEpoch + POOL_SAS_TOKEN_LIFETIME_SECS;
+            STRING_HANDLE sasToken = SASToken_CreateString(STRING_c_str(deviceData->deviceKey), STRING_c_str(deviceData->poolSasTokenScope), "", expiry);
+            if (sasToken == NULL)
+            {
+                LogError("SASToken_CreateString failed");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (deviceData->poolSasToken != NULL)
+                {
+                    STRING_delete(deviceData->poolSasToken);
+                }
+                deviceData->poolSasToken = sasToken;
+                deviceData->poolSasTokenExpiry = expiry;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static void onEventResponse(void* context, HTTP_ENGINE_RESULT result, unsigned int statusCode, HTTP_HEADERS_HANDLE responseHeaders, const unsigned char* content, size_t contentSize)
+{
+    HTTPTRANSPORT_PERDEVICE_DATA* deviceData = (HTTPTRANSPORT_PERDEVICE_DATA*)context;
+    (void)responseHeaders;
+    (void)content;
+    (void)contentSize;
+
+    deviceData->isEventRequestInFlight = false;
+    if ((result == HTTP_ENGINE_OK) && (statusCode < 300))
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_014: [ When the response to a pooled event request has an http status code <300, IoTHubClient_LL_SendComplete shall be called with the items of the request and IOTHUB_CLIENT_CONFIRMATION_OK. ]*/
+        IoTHubClient_LL_SendComplete(deviceData->iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK);
+    }
+    else
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_015: [ If a pooled event request fails, times out, is cancelled or gets an http status code >=300, its items shall be put back in waitingToSend to be retried. ]*/
+        if (result == HTTP_ENGINE_OK)
+        {
+            LogError("unexpected HTTP status code (%u)", statusCode);
+        }
+        else
+        {
+            LogError("pooled event request did not complete (%d)", (int)result);
+        }
+        reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+    }
+}
+
+/*sends an event request on the connection pool; the items of the request must already be in eventConfirmations*/
+static int startEventRequest(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, HTTP_HEADERS_HANDLE requestHeaders, const unsigned char* content, size_t contentSize)
+{
+    int result;
+    bool isAuthorized;
+
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_012: [ The "Authorization" header of a pooled event request shall be the device SAS token if one exists; for a device key, a SAS token for hostname + "/devices/" + URL_ENCODED(deviceId) created with `SASToken_CreateString`, valid for 1 hour and reused until less than 10 minutes are left; for x509 no header is set. ]*/
+    if (deviceData->deviceSasToken != NULL)
+    {
+        isAuthorized = (HTTPHeaders_ReplaceHeaderNameValuePair(requestHeaders, "Authorization", STRING_c_str(deviceData->deviceSasToken)) == HTTP_HEADERS_OK);
+    }
+    else if (deviceData->deviceKey != NULL)
+    {
+        isAuthorized = (refreshPoolSasToken(handleData, deviceData) == 0) &&
+            (HTTPHeaders_ReplaceHeaderNameValuePair(requestHeaders, "Authorization", STRING_c_str(deviceData->poolSasToken)) == HTTP_HEADERS_OK);
+    }
+    else
+    {
+        isAuthorized = true;
+    }
+
+    if (!isAuthorized)
+    {
+        LogError("unable to set the Authorization header");
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_013: [ The request shall be queued with `http_engine_execute_request_async` and the device marked as having an event request in flight; if that fails the items shall be put back in waitingToSend. ]*/
+    else if (http_engine_execute_request_async(handleData->httpEngine, HTTPAPI_REQUEST_POST, STRING_c_str(deviceData->eventHTTPrelativePath), requestHeaders, content, contentSize, onEventResponse, deviceData) != 0)
+    {
+        LogError("unable to http_engine_execute_request_async");
+        result = __FAILURE__;
+    }
+    else
+    {
+        deviceData->isEventRequestInFlight = true;
+        result = 0;
+    }
+    return result;
+}
+
 static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
 
-    if (DList_IsListEmpty(deviceData->waitingToSend))
+    if (deviceData->isEventRequestInFlight)
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_018: [ While an event request of the device is in flight on the connection pool, IoTHubTransportHttp_DoWork shall not send another one for that device. ]*/
+    }
+    else if (DList_IsListEmpty(deviceData->waitingToSend))
     {
         /*Codes_SRS_TRANSPORTMULTITHTTP_17_060: [If the list is empty then IoTHubTransportHttp_DoWork shall proceed to the following action.] */
     }
@@ -1375,60 +1681,71 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                 {
                 case MAKE_PAYLOAD_OK:
                 {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_068: [Once a final payload has been obtained, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters:] */
-                    BUFFER_HANDLE temp = BUFFER_new();
-                    if (temp == NULL)
+                    if (isConnectionPoolEnabled(handleData))
                     {
-                        LogError("unable to BUFFER_new");
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                        reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_09_011: [ If `OPTION_HTTP_CONNECTION_POOL_SIZE` is not 0, the batched payload or the single message shall be sent with `http_engine_execute_request_async` instead of HTTPAPIEX, with the same relative path, headers and content. ]*/
+                        if (startEventRequest(handleData, deviceData, deviceData->eventHTTPrequestHeaders, (const unsigned char*)STRING_c_str(payload), STRING_length(payload)) != 0)
+                        {
+                            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                        }
                     }
                     else
                     {
-                        if (BUFFER_build(temp, (const unsigned char*)STRING_c_str(payload), STRING_length(payload)) != 0)
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_068: [Once a final payload has been obtained, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters:] */
+                        BUFFER_HANDLE temp = BUFFER_new();
+                        if (temp == NULL)
                         {
-                            LogError("unable to BUFFER_build");
-                            //items go back to waitingToSend
+                            LogError("unable to BUFFER_new");
                             /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
                             reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                         }
                         else
                         {
-                            unsigned int statusCode;
-                            if (HTTPAPIEX_SAS_ExecuteRequest(
-                                deviceData->sasObject,
-                                handleData->httpApiExHandle,
-                                HTTPAPI_REQUEST_POST,
-                                STRING_c_str(deviceData->eventHTTPrelativePath),
-                                deviceData->eventHTTPrequestHeaders,
-                                temp,
-                                &statusCode,
-                                NULL,
-                                NULL
-                                ) != HTTPAPIEX_OK)
+                            if (BUFFER_build(temp, (const unsigned char*)STRING_c_str(payload), STRING_length(payload)) != 0)
                             {
-                                LogError("unable to HTTPAPIEX_ExecuteRequest");
+                                LogError("unable to BUFFER_build");
                                 //items go back to waitingToSend
-                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
+                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
                                 reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                             }
                             else
                             {
-                                if (statusCode < 300)
-                                {
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
-                                    IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK);
-                                }
-                                else
+                                unsigned int statusCode;
+                                if (HTTPAPIEX_SAS_ExecuteRequest(
+                                    deviceData->sasObject,
+                                    handleData->httpApiExHandle,
+                                    HTTPAPI_REQUEST_POST,
+                                    STRING_c_str(deviceData->eventHTTPrelativePath),
+                                    deviceData->eventHTTPrequestHeaders,
+                                    temp,
+                                    &statusCode,
+                                    NULL,
+                                    NULL
+                                    ) != HTTPAPIEX_OK)
                                 {
+                                    LogError("unable to HTTPAPIEX_ExecuteRequest");
                                     //items go back to waitingToSend
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
-                                    LogError("unexpected HTTP status code (%u)", statusCode);
                                     reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                                 }
+                                else
+                                {
+                                    if (statusCode < 300)
+                                    {
+                                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
+                                        IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK);
+                                    }
+                                    else
+                                    {
+                                        //items go back to waitingToSend
+                                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
+                                        LogError("unexpected HTTP status code (%u)", statusCode);
+                                        reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                                    }
+                                }
                             }
+                            BUFFER_delete(temp);
                         }
-                        BUFFER_delete(temp);
                     }
                     STRING_delete(payload);
                     break;
@@ -1620,6 +1937,15 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                 {
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
                                 }
+                                else if (isConnectionPoolEnabled(handleData))
+                                {
+                                    /*Codes_SRS_TRANSPORTMULTITHTTP_09_011: [ If `OPTION_HTTP_CONNECTION_POOL_SIZE` is not 0, the batched payload or the single message shall be sent with `http_engine_execute_request_async` instead of HTTPAPIEX, with the same relative path, headers and content. ]*/
+                                    if (startEventRequest(handleData, deviceData, clonedEventHTTPrequestHeaders, messageContent, originalMessageSize) == 0)
+                                    {
+                                        PDLIST_ENTRY inFlight = DList_RemoveHeadList(deviceData->waitingToSend);
+                                        DList_InsertTailList(&(deviceData->eventConfirmations), inFlight);
+                                    }
+                                }
                                 else
                                 {
                                     BUFFER_HANDLE toBeSend = BUFFER_new();
@@ -1993,16 +2319,131 @@ static MESSAGE_CALLBACK_INFO* MESSAGE_CALLBACK_INFO_Create(IOTHUB_MESSAGE_HANDLE
     return result;
 }
 
+/*xorshift32 seeded from the hash of the device id, so devices registered together get different poll schedules*/
+static uint32_t nextPollJitter(HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    uint32_t state = deviceData->pollJitterState;
+
+    if (state == 0)
+    {
+        state = hash_fnv1a(STRING_c_str(deviceData->deviceId));
+
+        if (state == 0)
+        {
+            state = 1;
+        }
+    }
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    deviceData->pollJitterState = state;
+
+    return state;
+}
+
+static bool isAdaptivePollDue(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    bool result;
+    tickcounter_ms_t currentMs;
+
+    if (tickcounter_get_current_ms(handleData->pollingTickCounter, &currentMs) != 0)
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_027: [ With adaptive polling, if `tickcounter_get_current_ms` fails no GET shall be issued. ]*/
+        LogError("unable to tickcounter_get_current_ms");
+        result = false;
+    }
+    else
+    {
+        if (!deviceData->isPollScheduled)
+        {
+            /*Codes_SRS_TRANSPORTMULTITHTTP_09_028: [ With adaptive polling, the first GET of a subscribed device shall be scheduled at a per-device pseudo-random offset smaller than the minimum adaptive polling interval. ]*/
+            deviceData->nextPollTimeMs = currentMs + (nextPollJitter(deviceData) % handleData->adaptivePollingMinIntervalMs);
+            deviceData->isPollScheduled = true;
+        }
+
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_026: [ With adaptive polling, a GET shall only be issued once the current time given by `tickcounter_get_current_ms` reaches the time scheduled for the device. ]*/
+        result = (currentMs >= deviceData->nextPollTimeMs);
+    }
+
+    return result;
+}
+
+static void scheduleNextPoll(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, bool wasMessageReceived)
+{
+    tickcounter_ms_t currentMs;
+
+    if (tickcounter_get_current_ms(handleData->pollingTickCounter, &currentMs) != 0)
+    {
+        LogError("unable to tickcounter_get_current_ms; the poll schedule of the device restarts");
+        deviceData->isPollScheduled = false;
+    }
+    else if (wasMessageReceived)
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_029: [ With adaptive polling, after a GET that received a message the next GET shall be allowed on the next call to _DoWork and the polling interval shall restart from the minimum. ]*/
+        /*more messages are likely to be waiting*/
+        deviceData->pollIntervalMs = 0;
+        deviceData->nextPollTimeMs = currentMs;
+        deviceData->isPollScheduled = true;
+    }
+    else
+    {
+        tickcounter_ms_t minIntervalMs = (tickcounter_ms_t)handleData->adaptivePollingMinIntervalMs;
+        tickcounter_ms_t maxIntervalMs = (tickcounter_ms_t)handleData->getMinimumPollingTime * 1000;
+        tickcounter_ms_t jitterRangeMs;
+
+        if (maxIntervalMs < minIntervalMs)
+        {
+            maxIntervalMs = minIntervalMs;
+        }
+
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_030: [ With adaptive polling, after a GET that received no message, or failed, the polling interval shall be the minimum adaptive polling interval the first time and double every following time, up to GetMinimumPollingTime; the next GET shall be scheduled after that interval, moved by up to a quarter of it. ]*/
+        if (deviceData->pollIntervalMs == 0)
+        {
+            deviceData->pollIntervalMs = minIntervalMs;
+        }
+        else if (deviceData->pollIntervalMs > maxIntervalMs / ADAPTIVE_POLLING_BACKOFF_FACTOR)
+        {
+            deviceData->pollIntervalMs = maxIntervalMs;
+        }
+        else
+        {
+            deviceData->pollIntervalMs *= ADAPTIVE_POLLING_BACKOFF_FACTOR;
+        }
+
+        jitterRangeMs = 2 * (deviceData->pollIntervalMs / ADAPTIVE_POLLING_JITTER_DIVISOR);
+        deviceData->nextPollTimeMs = currentMs + deviceData->pollIntervalMs - (jitterRangeMs / 2);
+        if (jitterRangeMs != 0)
+        {
+            deviceData->nextPollTimeMs += nextPollJitter(deviceData) % jitterRangeMs;
+        }
+        deviceData->isPollScheduled = true;
+    }
+}
+
 static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_083: [ If device is not subscribed then _DoWork shall advance to the next action. ] */
     if (deviceData->DoWork_PullMessage)
     {
-        /*Codes_SRS_TRANSPORTMULTITHTTP_17_123: [After client creation, the first GET shall be allowed no matter what the value of GetMinimumPollingTime.] */
-        /*Codes_SRS_TRANSPORTMULTITHTTP_17_124: [If time is not available then all calls shall be treated as if they are the first one.] */
-        /*Codes_SRS_TRANSPORTMULTITHTTP_17_122: [A GET request that happens earlier than GetMinimumPollingTime shall be ignored.] */
-        time_t timeNow = get_time(NULL);
-        bool isPollingAllowed = deviceData->isFirstPoll || (timeNow == (time_t)(-1)) || (get_difftime(timeNow, deviceData->lastPollTime) > handleData->getMinimumPollingTime);
+        bool isAdaptivePolling = (handleData->adaptivePollingMinIntervalMs != 0);
+        bool wasMessageReceived = false;
+        time_t timeNow = (time_t)(-1);
+        bool isPollingAllowed;
+
+        if (isAdaptivePolling)
+        {
+            isPollingAllowed = isAdaptivePollDue(handleData, deviceData);
+        }
+        else
+        {
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_123: [After client creation, the first GET shall be allowed no matter what the value of GetMinimumPollingTime.] */
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_124: [If time is not available then all calls shall be treated as if they are the first one.] */
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_122: [A GET request that happens earlier than GetMinimumPollingTime shall be ignored.] */
+            timeNow = get_time(NULL);
+            isPollingAllowed = deviceData->isFirstPoll || (timeNow == (time_t)(-1)) || (get_difftime(timeNow, deviceData->lastPollTime) > handleData->getMinimumPollingTime);
+        }
+
         if (isPollingAllowed)
         {
             HTTP_HEADERS_HANDLE responseHTTPHeaders = HTTPHeaders_Alloc();
@@ -2098,6 +2539,8 @@ static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERD
                         }
                         else
                         {
+                            wasMessageReceived = true;
+
                             /*Codes_SRS_TRANSPORTMULTITHTTP_17_087: [If status code is 200, then _DoWork shall make a copy of the value of the "ETag" http header.]*/
                             const char* etagValue = HTTPHeaders_FindHeaderValue(responseHTTPHeaders, "ETag");
                             if (etagValue == NULL)
@@ -2285,6 +2728,11 @@ static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERD
                 }
                 HTTPHeaders_Free(responseHTTPHeaders);
             }
+
+            if (isAdaptivePolling)
+            {
+                scheduleNextPoll(handleData, deviceData, wasMessageReceived);
+            }
         }
         else
         {
@@ -2325,6 +2773,12 @@ static void IoTHubTransportHttp_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
             DoMessages(handleData, perDeviceItem, perDeviceItem->iotHubClientHandle);
 
         }
+
+        if (handleData->connectionPoolSize > 0)
+        {
+            /*Codes_SRS_TRANSPORTMULTITHTTP_09_019: [ If `OPTION_HTTP_CONNECTION_POOL_SIZE` is not 0, IoTHubTransportHttp_DoWork shall call `http_engine_dowork` after looping through the devices. ]*/
+            http_engine_dowork(handleData->httpEngine);
+        }
     }
     else
     {
@@ -2361,7 +2815,8 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_GetSendStatus(IOTHUB_DEVICE_HAND
         {
             HTTPTRANSPORT_PERDEVICE_DATA* deviceData = (HTTPTRANSPORT_PERDEVICE_DATA*)(*listItem);
             /* Codes_SRS_TRANSPORTMULTITHTTP_17_113: [ IoTHubTransportHttp_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently event items to be sent or being sent. ] */
-            if (!DList_IsListEmpty(deviceData->waitingToSend))
+            /*Codes_SRS_TRANSPORTMULTITHTTP_09_020: [ IoTHubTransportHttp_GetSendStatus shall also return IOTHUB_CLIENT_SEND_STATUS_BUSY while an event request of the device is in flight on the connection pool. ]*/
+            if (!DList_IsListEmpty(deviceData->waitingToSend) || deviceData->isEventRequestInFlight)
             {
                 *iotHubClientStatus = IOTHUB_CLIENT_SEND_STATUS_BUSY;
             }
@@ -2408,6 +2863,45 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_SetOption(TRANSPORT_LL_HANDLE ha
             handleData->getMinimumPollingTime = *(unsigned int*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_025: ["c2d_adaptive_polling_min_interval_ms"] */
+        else if (strcmp(OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, option) == 0)
+        {
+            unsigned int minIntervalMs = *(const unsigned int*)value;
+            /*Codes_SRS_TRANSPORTMULTITHTTP_09_032: [ Setting a non-zero "c2d_adaptive_polling_min_interval_ms" shall create the tick counter used for polling with `tickcounter_create` if it does not exist yet; if that fails IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+            if (minIntervalMs != 0 && handleData->pollingTickCounter == NULL &&
+                (handleData->pollingTickCounter = tickcounter_create()) == NULL)
+            {
+                LogError("unable to tickcounter_create");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                handleData->adaptivePollingMinIntervalMs = minIntervalMs;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_021: ["http_connection_pool_size"] */
+        else if (strcmp(OPTION_HTTP_CONNECTION_POOL_SIZE, option) == 0)
+        {
+            size_t connectionPoolSize = *(const size_t*)value;
+            if (handleData->httpEngine == NULL)
+            {
+                /*Codes_SRS_TRANSPORTMULTITHTTP_09_022: [ If the transport has no HTTP engine, setting "http_connection_pool_size" shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                LogError("the connection pool is not available");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            /*Codes_SRS_TRANSPORTMULTITHTTP_09_023: [ The pool size shall be set by calling `http_engine_set_max_connections`; if that fails (e.g. requests are in flight) IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_ERROR and keep the previous size. ]*/
+            else if (http_engine_set_max_connections(handleData->httpEngine, connectionPoolSize) != 0)
+            {
+                LogError("unable to http_engine_set_max_connections");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                handleData->connectionPoolSize = connectionPoolSize;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else
         {
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_126: [ "TrustedCerts"] */
@@ -2418,6 +2912,15 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_SetOption(TRANSPORT_LL_HANDLE ha
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_119: [The following table translates HTTPAPIEX return codes to IOTHUB_CLIENT_RESULT return codes:] */
             if (HTTPAPIEX_result == HTTPAPIEX_OK)
             {
+                /*Codes_SRS_TRANSPORTMULTITHTTP_09_024: [ Options accepted by HTTPAPIEX_SetOption shall also be passed to `http_engine_set_option`, which ignores the options it does not support. ]*/
+                if (handleData->httpEngine != NULL)
+                {
+                    (void)http_engine_set_option(handleData->httpEngine, option, value);
+                }
+                if (strcmp(OPTION_HTTP_PROXY, option) == 0)
+                {
+                    handleData->isProxyConfigured = (((const HTTP_PROXY_OPTIONS*)value)->host_address != NULL);
+                }
                 result = IOTHUB_CLIENT_OK;
             }
             else if (HTTPAPIEX_result == HTTPAPIEX_INVALID_ARG)
@@ -2453,6 +2956,28 @@ static STRING_HANDLE IoTHubTransportHttp_GetHostname(TRANSPORT_LL_HANDLE handle)
     return result;
 }
 
+static void IoTHubTransportHttp_GetStatistics(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_STATISTICS* statistics)
+{
+    /*Codes_SRS_TRANSPORTMULTITHTTP_09_035: [ If handle or statistics are NULL, IoTHubTransportHttp_GetStatistics shall return without changes. ]*/
+    if (handle == NULL || statistics == NULL)
+    {
+        LogError("invalid parameter handle=%p, statistics=%p", handle, statistics);
+    }
+    else
+    {
+        HTTPTRANSPORT_HANDLE_DATA* handleData = (HTTPTRANSPORT_HANDLE_DATA*)handle;
+        TLS_SESSION_CACHE_STATISTICS tlsSessionCacheStatistics;
+
+        /*Codes_SRS_TRANSPORTMULTITHTTP_09_036: [ If the transport has a TLS session cache, IoTHubTransportHttp_GetStatistics shall set statistics->tls_session_cache_hits and statistics->tls_session_cache_misses from tls_session_cache_get_statistics; otherwise it shall leave them unchanged. ]*/
+        if ((handleData->tlsSessionCache != NULL) &&
+            (tls_session_cache_get_statistics(handleData->tlsSessionCache, &tlsSessionCacheStatistics) == 0))
+        {
+            statistics->tls_session_cache_hits = tlsSessionCacheStatistics.hits;
+            statistics->tls_session_cache_misses = tlsSessionCacheStatistics.misses;
+        }
+    }
+}
+
 static int IoTHubTransportHttp_SetRetryPolicy(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT_RETRY_POLICY retryPolicy, size_t retryTimeoutLimitInSeconds)
 {
     int result;
@@ -2486,7 +3011,8 @@ static TRANSPORT_PROVIDER thisTransportProvider =
     IoTHubTransportHttp_Unsubscribe,                /*pfIoTHubTransport_Unsubscribe IoTHubTransport_Unsubscribe;*/
     IoTHubTransportHttp_DoWork,                     /*pfIoTHubTransport_DoWork IoTHubTransport_DoWork;*/
     IoTHubTransportHttp_SetRetryPolicy,             /*pfIoTHubTransport_DoWork IoTHubTransport_SetRetryPolicy;*/
-    IoTHubTransportHttp_GetSendStatus               /*pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus;*/
+    IoTHubTransportHttp_GetSendStatus,              /*pfIoTHubTransport_GetSendStatus IoTHubTransport_GetSendStatus;*/
+    IoTHubTransportHttp_GetStatistics               /*pfIoTHubTransport_GetStatistics IoTHubTransport_GetStatistics;*/
 };
 
 const TRANSPORT_PROVIDER* HTTP_Protocol(void)
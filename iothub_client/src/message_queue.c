@@ -9,6 +9,7 @@
 #include "azure_c_shared_utility/agenttime.h" 
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
+#include "iothub_client_slab.h"
 
 typedef struct MESSAGE_QUEUE_TAG MESSAGE_QUEUE;
 
@@ -33,6 +34,9 @@ struct MESSAGE_QUEUE_TAG
 
     SINGLYLINKEDLIST_HANDLE pending;
     SINGLYLINKEDLIST_HANDLE in_progress;
+
+    // MESSAGE_QUEUE_ITEM records kept for reuse (message_queue_set_max_free_items)
+    SLAB item_slab;
 };
 
 typedef struct MESSAGE_QUEUE_ITEM_TAG
@@ -100,7 +104,7 @@ static int retry_sending_message(MESSAGE_QUEUE_HANDLE message_queue, LIST_ITEM_H
     return result;
 }
 
-static void dequeue_message_and_fire_callback(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE list_item, MESSAGE_QUEUE_RESULT result, void* reason)
+static void dequeue_message_and_fire_callback(MESSAGE_QUEUE_HANDLE message_queue, SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE list_item, MESSAGE_QUEUE_RESULT result, void* reason)
 {
     MESSAGE_QUEUE_ITEM* mq_item = (MESSAGE_QUEUE_ITEM*)singlylinkedlist_item_get_value(list_item);
 
@@ -114,7 +118,8 @@ static void dequeue_message_and_fire_callback(SINGLYLINKEDLIST_HANDLE list, LIST
     fire_message_callback(mq_item, result, reason);
 
     // Codes_SRS_MESSAGE_QUEUE_09_050: [The `mq_item` related to `message` shall be freed]
-    free(mq_item);
+    // Codes_SRS_MESSAGE_QUEUE_09_073: [Every `mq_item` released by message_queue shall be returned to `message_queue->item_slab` using slab_free()]
+    slab_free(&message_queue->item_slab, mq_item);
 }
 
 static void on_process_message_completed_callback(MESSAGE_QUEUE_HANDLE message_queue, MQ_MESSAGE_HANDLE message, MESSAGE_QUEUE_RESULT result, USER_DEFINED_REASON reason)
@@ -141,7 +146,7 @@ static void on_process_message_completed_callback(MESSAGE_QUEUE_HANDLE message_q
             // Codes_SRS_MESSAGE_QUEUE_09_048: [If `result` is MESSAGE_QUEUE_RETRYABLE_ERROR and `mq_item->number_of_attempts` is greater than `message_queue->max_retry_count`, result shall be changed to MESSAGE_QUEUE_ERROR]
             if (!should_retry_sending(message_queue, mq_item, result) || retry_sending_message(message_queue, list_item) != RESULT_OK)
             {
-                dequeue_message_and_fire_callback(message_queue->in_progress, list_item, result, reason);
+                dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, list_item, result, reason);
             }
         }
     }
@@ -176,7 +181,7 @@ static void process_timeouts(MESSAGE_QUEUE_HANDLE message_queue)
                 else if (get_difftime(current_time, mq_item->enqueue_time) >= message_queue->max_message_enqueued_time_secs)
                 {
                     // Codes_SRS_MESSAGE_QUEUE_09_036: [If any items are in `message_queue` lists for `message_queue->max_message_enqueued_time_secs` or more, they shall be removed and `message_queue->on_message_processing_completed_callback` invoked with MESSAGE_QUEUE_TIMEOUT]
-                    dequeue_message_and_fire_callback(message_queue->pending, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
+                    dequeue_message_and_fire_callback(message_queue, message_queue->pending, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
                 }
                 else
                 {
@@ -201,7 +206,7 @@ static void process_timeouts(MESSAGE_QUEUE_HANDLE message_queue)
                 else if (get_difftime(current_time, mq_item->enqueue_time) >= message_queue->max_message_enqueued_time_secs)
                 {
                     // Codes_SRS_MESSAGE_QUEUE_09_038: [If any items are in `message_queue->in_progress` for `message_queue->max_message_processing_time_secs` or more, they shall be removed and `message_queue->on_message_processing_completed_callback` invoked with MESSAGE_QUEUE_TIMEOUT]
-                    dequeue_message_and_fire_callback(message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
+                    dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
                 }
             }
         }
@@ -224,7 +229,7 @@ static void process_timeouts(MESSAGE_QUEUE_HANDLE message_queue)
                 }
                 else if (get_difftime(current_time, mq_item->processing_start_time) >= message_queue->max_message_processing_time_secs)
                 {
-                    dequeue_message_and_fire_callback(message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
+                    dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, current_list_item, MESSAGE_QUEUE_TIMEOUT, NULL);
                 }
                 else
                 {
@@ -275,7 +280,7 @@ static void process_pending_messages(MESSAGE_QUEUE_HANDLE message_queue)
                 mq_item->on_message_processing_completed_callback(mq_item->message, MESSAGE_QUEUE_ERROR, NULL, mq_item->user_context);
             }
 
-            free(mq_item);
+            slab_free(&message_queue->item_slab, mq_item);
         }
         // Codes_SRS_MESSAGE_QUEUE_09_039: [Each `mq_item` in `message_queue->pending` shall be moved to `message_queue->in_progress`]
         else if (singlylinkedlist_add(message_queue->in_progress, (const void*)mq_item) == NULL)
@@ -288,7 +293,7 @@ static void process_pending_messages(MESSAGE_QUEUE_HANDLE message_queue)
                 mq_item->on_message_processing_completed_callback(mq_item->message, MESSAGE_QUEUE_ERROR, NULL, mq_item->user_context);
             }
 
-            free(mq_item);
+            slab_free(&message_queue->item_slab, mq_item);
         }
         else
         {
@@ -365,19 +370,19 @@ void message_queue_remove_all(MESSAGE_QUEUE_HANDLE message_queue)
         {
             // Codes_SRS_MESSAGE_QUEUE_09_028: [`message_queue->on_message_processing_completed_callback` shall be invoked with MESSAGE_QUEUE_CANCELLED for each `mq_item` removed]
             // Codes_SRS_MESSAGE_QUEUE_09_029: [Each `mq_item` shall be freed] 
-            dequeue_message_and_fire_callback(message_queue->in_progress, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
+            dequeue_message_and_fire_callback(message_queue, message_queue->in_progress, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
         }
 
         while ((list_item = singlylinkedlist_get_head_item(message_queue->pending)) != NULL)
         {
             // Codes_SRS_MESSAGE_QUEUE_09_028: [`message_queue->on_message_processing_completed_callback` shall be invoked with MESSAGE_QUEUE_CANCELLED for each `mq_item` removed]
             // Codes_SRS_MESSAGE_QUEUE_09_029: [Each `mq_item` shall be freed] 
-            dequeue_message_and_fire_callback(message_queue->pending, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
+            dequeue_message_and_fire_callback(message_queue, message_queue->pending, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
         }
     }
 }
 
-static int move_messages_between_lists(SINGLYLINKEDLIST_HANDLE from_list, SINGLYLINKEDLIST_HANDLE to_list)
+static int move_messages_between_lists(MESSAGE_QUEUE_HANDLE message_queue, SINGLYLINKEDLIST_HANDLE from_list, SINGLYLINKEDLIST_HANDLE to_list)
 {
     int result;
     LIST_ITEM_HANDLE list_item;
@@ -401,7 +406,7 @@ static int move_messages_between_lists(SINGLYLINKEDLIST_HANDLE from_list, SINGLY
 
                 fire_message_callback(mq_item, MESSAGE_QUEUE_CANCELLED, NULL);
 
-                free(mq_item);
+                slab_free(&message_queue->item_slab, mq_item);
 
                 result = __FAILURE__;
 
@@ -438,17 +443,17 @@ int message_queue_move_all_back_to_pending(MESSAGE_QUEUE_HANDLE message_queue)
         }
         else
         {
-            if (move_messages_between_lists(message_queue->in_progress, temp_list) != 0)
+            if (move_messages_between_lists(message_queue, message_queue->in_progress, temp_list) != 0)
             {
                 LogError("failed moving in-progress message to temporary list");
                 result = __FAILURE__;
             }
-            else if (move_messages_between_lists(message_queue->pending, temp_list) != 0)
+            else if (move_messages_between_lists(message_queue, message_queue->pending, temp_list) != 0)
             {
                 LogError("failed moving pending message to temporary list");
                 result = __FAILURE__;
             }
-            else if (move_messages_between_lists(temp_list, message_queue->pending) != 0)
+            else if (move_messages_between_lists(message_queue, temp_list, message_queue->pending) != 0)
             {
                 LogError("failed moving pending message to temporary list");
                 result = __FAILURE__;
@@ -464,7 +469,7 @@ int message_queue_move_all_back_to_pending(MESSAGE_QUEUE_HANDLE message_queue)
 
                 while ((list_item = singlylinkedlist_get_head_item(temp_list)) != NULL)
                 {
-                    dequeue_message_and_fire_callback(temp_list, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
+                    dequeue_message_and_fire_callback(message_queue, temp_list, list_item, MESSAGE_QUEUE_CANCELLED, NULL);
                 }
             }
 
@@ -493,6 +498,9 @@ void message_queue_destroy(MESSAGE_QUEUE_HANDLE message_queue)
         {
             singlylinkedlist_destroy(message_queue->in_progress);
         }
+
+        // Codes_SRS_MESSAGE_QUEUE_09_074: [message_queue_destroy shall free the items kept for reuse using slab_deinit()]
+        slab_deinit(&message_queue->item_slab);
         
         free(message_queue);
     }
@@ -525,6 +533,9 @@ MESSAGE_QUEUE_HANDLE message_queue_create(MESSAGE_QUEUE_CONFIG* config)
     {
         memset(result, 0, sizeof(MESSAGE_QUEUE));
 
+        // Codes_SRS_MESSAGE_QUEUE_09_070: [`message_queue->item_slab` shall be initialized using slab_init() with no item kept for reuse]
+        slab_init(&result->item_slab, sizeof(MESSAGE_QUEUE_ITEM), 0);
+
         // Codes_SRS_MESSAGE_QUEUE_09_006: [`message_queue->pending` shall be set using singlylinkedlist_create()]
         if ((result->pending = singlylinkedlist_create()) == NULL)
         {
@@ -573,7 +584,8 @@ int message_queue_add(MESSAGE_QUEUE_HANDLE message_queue, MQ_MESSAGE_HANDLE mess
         MESSAGE_QUEUE_ITEM* mq_item;
 
         // Codes_SRS_MESSAGE_QUEUE_09_017: [message_queue_add shall allocate a structure (aka `mq_item`) to save the `message`]
-        if ((mq_item = (MESSAGE_QUEUE_ITEM*)malloc(sizeof(MESSAGE_QUEUE_ITEM))) == NULL)
+        // Codes_SRS_MESSAGE_QUEUE_09_073: [`mq_item` shall be obtained from `message_queue->item_slab` using slab_alloc()]
+        if ((mq_item = (MESSAGE_QUEUE_ITEM*)slab_alloc(&message_queue->item_slab)) == NULL)
         {
             // Codes_SRS_MESSAGE_QUEUE_09_018: [If `mq_item` cannot be allocated, message_queue_add shall fail and return non-zero]
             LogError("failed creating container for message");
@@ -589,7 +601,7 @@ int message_queue_add(MESSAGE_QUEUE_HANDLE message_queue, MQ_MESSAGE_HANDLE mess
                 // Codes_SRS_MESSAGE_QUEUE_09_020: [If get_time fails, message_queue_add shall fail and return non-zero]
                 LogError("failed setting message enqueue time");
                 // Codes_SRS_MESSAGE_QUEUE_09_024: [If any failures occur, message_queue_add shall release all memory it has allocated]
-                free(mq_item);
+                slab_free(&message_queue->item_slab, mq_item);
                 result = __FAILURE__;
             }
             // Codes_SRS_MESSAGE_QUEUE_09_021: [`mq_item` shall be added to `message_queue->pending` list]
@@ -598,7 +610,7 @@ int message_queue_add(MESSAGE_QUEUE_HANDLE message_queue, MQ_MESSAGE_HANDLE mess
                 // Codes_SRS_MESSAGE_QUEUE_09_022: [`mq_item` fails to be added to `message_queue->pending`, message_queue_add shall fail and return non-zero]
                 LogError("failed enqueing message");
                 // Codes_SRS_MESSAGE_QUEUE_09_024: [If any failures occur, message_queue_add shall release all memory it has allocated]
-                free(mq_item);
+                slab_free(&message_queue->item_slab, mq_item);
                 result = __FAILURE__;
             }
             else
@@ -712,6 +724,26 @@ int message_queue_set_max_retry_count(MESSAGE_QUEUE_HANDLE message_queue, size_t
     return result;
 }
 
+int message_queue_set_max_free_items(MESSAGE_QUEUE_HANDLE message_queue, size_t max_free_items)
+{
+    int result;
+
+    // Codes_SRS_MESSAGE_QUEUE_09_071: [If `message_queue` is NULL, message_queue_set_max_free_items shall fail and return non-zero]
+    if (message_queue == NULL)
+    {
+        LogError("invalid argument (message_queue is NULL)");
+        result = __FAILURE__;
+    }
+    else
+    {
+        // Codes_SRS_MESSAGE_QUEUE_09_072: [`max_free_items` shall be set on `message_queue->item_slab` using slab_set_max_free_elements(), and message_queue_set_max_free_items shall return 0]
+        slab_set_max_free_elements(&message_queue->item_slab, max_free_items);
+        result = RESULT_OK;
+    }
+
+    return result;
+}
+
 static int setOption(void* handle, const char* name, const void* value)
 {
     int result;
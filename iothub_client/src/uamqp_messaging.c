@@ -1,8 +1,11 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 #include "uamqp_messaging.h"
 #include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/amqpvalue.h"
@@ -11,6 +14,69 @@
 #define RESULT_OK 0
 #endif
 
+typedef struct UAMQP_MESSAGE_TEMPLATE_TAG
+{
+	// Copy of the IOTHUB_MESSAGE_HANDLE properties `uamqp_application_properties` was encoded from.
+	MAP_HANDLE application_properties;
+	AMQP_VALUE uamqp_application_properties;
+} UAMQP_MESSAGE_TEMPLATE;
+
+static bool isTemplateApplicationPropertiesMatch(UAMQP_MESSAGE_TEMPLATE* message_template, const char* const* propertyKeys, const char* const* propertyValues, size_t propertyCount)
+{
+	bool result;
+	const char* const* templateKeys;
+	const char* const* templateValues;
+	size_t templateCount;
+
+	if (message_template->uamqp_application_properties == NULL ||
+		Map_GetInternals(message_template->application_properties, &templateKeys, &templateValues, &templateCount) != MAP_OK ||
+		templateCount != propertyCount)
+	{
+		result = false;
+	}
+	else
+	{
+		size_t i;
+
+		result = true;
+
+		for (i = 0; result && i < propertyCount; i++)
+		{
+			if (strcmp(templateKeys[i], propertyKeys[i]) != 0 ||
+				strcmp(templateValues[i], propertyValues[i]) != 0)
+			{
+				result = false;
+			}
+		}
+	}
+
+	return result;
+}
+
+static void updateTemplateApplicationProperties(UAMQP_MESSAGE_TEMPLATE* message_template, MAP_HANDLE properties_map, AMQP_VALUE uamqp_map)
+{
+	MAP_HANDLE properties_map_copy;
+
+	// Codes_SRS_UAMQP_MESSAGING_09_121: [After a uAMQP application properties map is encoded, it shall be stored in the template together with a copy of the IOTHUB_MESSAGE_HANDLE properties obtained with Map_Clone, replacing (and destroying) the previously stored ones.]
+	if ((properties_map_copy = Map_Clone(properties_map)) == NULL)
+	{
+		// Codes_SRS_UAMQP_MESSAGING_09_122: [If Map_Clone fails, the template shall be left unchanged, the encoded map shall be destroyed and message_create_from_iothub_message_with_template() shall not fail.]
+		LogError("Failed caching the application properties on the uAMQP message template (Map_Clone failed).");
+		amqpvalue_destroy(uamqp_map);
+	}
+	else
+	{
+		if (message_template->uamqp_application_properties != NULL)
+		{
+			amqpvalue_destroy(message_template->uamqp_application_properties);
+			Map_Destroy(message_template->application_properties);
+		}
+
+		message_template->application_properties = properties_map_copy;
+		message_template->uamqp_application_properties = uamqp_map;
+	}
+}
+
 static int addPropertiesTouAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MESSAGE_HANDLE uamqp_message)
 {
 	int result = RESULT_OK;
@@ -129,7 +195,7 @@ static int addPropertiesTouAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_hand
 	return result;
 }
 
-static int addApplicationPropertiesTouAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MESSAGE_HANDLE uamqp_message)
+static int addApplicationPropertiesTouAMQPMessage(UAMQP_MESSAGE_TEMPLATE* message_template, IOTHUB_MESSAGE_HANDLE iothub_message_handle, MESSAGE_HANDLE uamqp_message)
 {
 	int result = RESULT_OK;
 	MAP_HANDLE properties_map;
@@ -159,8 +225,19 @@ static int addApplicationPropertiesTouAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_m
 			size_t i;
 			AMQP_VALUE uamqp_map;
 
+			// Codes_SRS_UAMQP_MESSAGING_09_119: [If a template is used and the IOTHUB_MESSAGE_HANDLE properties have the same keys and values (in the same order) as the ones the template application properties map was encoded from, that map shall be set on the uAMQP message by calling message_set_application_properties() and no new uAMQP values shall be created.]
+			if (message_template != NULL &&
+				isTemplateApplicationPropertiesMatch(message_template, propertyKeys, propertyValues, propertyCount))
+			{
+				if (message_set_application_properties(uamqp_message, message_template->uamqp_application_properties) != 0)
+				{
+					// Codes_SRS_UAMQP_MESSAGING_09_120: [If message_set_application_properties() fails, message_create_from_iothub_message_with_template() shall fail and return immediately.]
+					LogError("Failed transferring the template message properties to the uAMQP message.");
+					result = __FAILURE__;
+				}
+			}
 			// Codes_SRS_UAMQP_MESSAGING_09_086: [A uAMQP property map shall be created by calling amqpvalue_create_map().]
-			if ((uamqp_map = amqpvalue_create_map()) == NULL)
+			else if ((uamqp_map = amqpvalue_create_map()) == NULL)
 			{
 				// Codes_SRS_UAMQP_MESSAGING_09_087: [If amqpvalue_create_map() fails, message_create_from_iothub_message() shall fail and return immediately.]
 				LogError("Failed to create uAMQP map for the properties.");
@@ -218,8 +295,15 @@ static int addApplicationPropertiesTouAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_m
 					}
 				}
 
-				// Codes_SRS_UAMQP_MESSAGING_09_097: [The uAMQP properties map shall be destroyed using amqpvalue_destroy().]
-				amqpvalue_destroy(uamqp_map);
+				if (result == RESULT_OK && message_template != NULL)
+				{
+					updateTemplateApplicationProperties(message_template, properties_map, uamqp_map);
+				}
+				else
+				{
+					// Codes_SRS_UAMQP_MESSAGING_09_097: [The uAMQP properties map shall be destroyed using amqpvalue_destroy().]
+					amqpvalue_destroy(uamqp_map);
+				}
 			}
 		}
 		else
@@ -336,108 +420,127 @@ static int readPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_h
 	return return_value;
 }
 
-static int readApplicationPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MESSAGE_HANDLE uamqp_message)
+static int loadApplicationPropertiesFromuAMQPValue(void* context, MAP_HANDLE iothub_message_properties_map)
 {
 	int result;
-	AMQP_VALUE uamqp_app_properties = NULL;
+	AMQP_VALUE uamqp_app_properties = (AMQP_VALUE)context;
 	AMQP_VALUE uamqp_app_properties_ipdv = NULL;
 	uint32_t property_count = 0;
-	MAP_HANDLE iothub_message_properties_map;
 
-	// Codes_SRS_UAMQP_MESSAGING_09_027: [The IOTHUB_MESSAGE_HANDLE properties shall be retrieved using IoTHubMessage_Properties.]
-	if ((iothub_message_properties_map = IoTHubMessage_Properties(iothub_message_handle)) == NULL)
+	// Codes_SRS_UAMQP_MESSAGING_09_032: [The actual uAMQP message application properties should be extracted from the result of message_get_application_properties using amqpvalue_get_inplace_described_value.]
+	if ((uamqp_app_properties_ipdv = amqpvalue_get_inplace_described_value(uamqp_app_properties)) == NULL)
 	{
-		// Codes_SRS_UAMQP_MESSAGING_09_028: [If IoTHubMessage_Properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-		LogError("Failed to get property map from IoTHub message.");
+		// Codes_SRS_UAMQP_MESSAGING_09_033: [If amqpvalue_get_inplace_described_value fails, loading the application properties shall fail.]
+		LogError("Failed getting the map of uAMQP message application properties.");
 		result = __FAILURE__;
 	}
-	// Codes_SRS_UAMQP_MESSAGING_09_029: [The uAMQP message application properties shall be retrieved using message_get_application_properties.]
-	else if ((result = message_get_application_properties(uamqp_message, &uamqp_app_properties)) != 0)
+	// Codes_SRS_UAMQP_MESSAGING_09_034: [The number of items in the uAMQP message application properties shall be obtained using amqpvalue_get_map_pair_count.]
+	else if ((result = amqpvalue_get_map_pair_count(uamqp_app_properties_ipdv, &property_count)) != 0)
 	{
-		// Codes_SRS_UAMQP_MESSAGING_09_030: [If message_get_application_properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-		LogError("Failed reading the incoming uAMQP message properties (return code %d).", result);
+		// Codes_SRS_UAMQP_MESSAGING_09_035: [If amqpvalue_get_map_pair_count fails, loading the application properties shall fail.]
+		LogError("Failed reading the number of values in the uAMQP property map (return code %d).", result);
 		result = __FAILURE__;
 	}
 	else
 	{
-		// Codes_SRS_UAMQP_MESSAGING_09_031: [If message_get_application_properties succeeds but returns a NULL application properties map (there are no properties), IoTHubMessage_CreateFromuAMQPMessage() shall skip processing the properties and continue normally.]
-		if (uamqp_app_properties == NULL)
+		// Codes_SRS_UAMQP_MESSAGING_09_036: [Loading the application properties shall iterate through each uAMQP application property and add it to IOTHUB_MESSAGE_HANDLE properties.]
+		uint32_t i;
+		for (i = 0; result == RESULT_OK && i < property_count; i++)
 		{
-			result = 0;
-		}
-		else
-		{
-			// Codes_SRS_UAMQP_MESSAGING_09_032: [The actual uAMQP message application properties should be extracted from the result of message_get_application_properties using amqpvalue_get_inplace_described_value.]
-			if ((uamqp_app_properties_ipdv = amqpvalue_get_inplace_described_value(uamqp_app_properties)) == NULL)
+			AMQP_VALUE map_key_name = NULL;
+			AMQP_VALUE map_key_value = NULL;
+			const char *key_name;
+			const char* key_value;
+
+			// Codes_SRS_UAMQP_MESSAGING_09_037: [The uAMQP application property name and value shall be obtained using amqpvalue_get_map_key_value_pair.]
+			if ((result = amqpvalue_get_map_key_value_pair(uamqp_app_properties_ipdv, i, &map_key_name, &map_key_value)) != 0)
 			{
-				// Codes_SRS_UAMQP_MESSAGING_09_033: [If amqpvalue_get_inplace_described_value fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-				LogError("Failed getting the map of uAMQP message application properties (return code %d).", result);
+				// Codes_SRS_UAMQP_MESSAGING_09_038: [If amqpvalue_get_map_key_value_pair fails, loading the application properties shall fail.]
+				LogError("Failed reading the key/value pair from the uAMQP property map (return code %d).", result);
 				result = __FAILURE__;
 			}
-			// Codes_SRS_UAMQP_MESSAGING_09_034: [The number of items in the uAMQP message application properties shall be obtained using amqpvalue_get_map_pair_count.]
-			else if ((result = amqpvalue_get_map_pair_count(uamqp_app_properties_ipdv, &property_count)) != 0)
+
+			// Codes_SRS_UAMQP_MESSAGING_09_039: [The uAMQP application property name shall be extracted as string using amqpvalue_get_string.]
+			else if ((result = amqpvalue_get_string(map_key_name, &key_name)) != 0)
 			{
-				// Codes_SRS_UAMQP_MESSAGING_09_035: [If amqpvalue_get_map_pair_count fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-				LogError("Failed reading the number of values in the uAMQP property map (return code %d).", result);
+				// Codes_SRS_UAMQP_MESSAGING_09_040: [If amqpvalue_get_string fails, loading the application properties shall fail.]
+				LogError("Failed parsing the uAMQP property name (return code %d).", result);
 				result = __FAILURE__;
 			}
-			else
+			// Codes_SRS_UAMQP_MESSAGING_09_041: [The uAMQP application property value shall be extracted as string using amqpvalue_get_string.]
+			else if ((result = amqpvalue_get_string(map_key_value, &key_value)) != 0)
 			{
-				// Codes_SRS_UAMQP_MESSAGING_09_036: [IoTHubMessage_CreateFromuAMQPMessage() shall iterate through each uAMQP application property and add it to IOTHUB_MESSAGE_HANDLE properties.]
-				uint32_t i;
-				for (i = 0; result == RESULT_OK && i < property_count; i++)
-				{
-					AMQP_VALUE map_key_name = NULL;
-					AMQP_VALUE map_key_value = NULL;
-					const char *key_name;
-					const char* key_value;
+				// Codes_SRS_UAMQP_MESSAGING_09_042: [If amqpvalue_get_string fails, loading the application properties shall fail.]
+				LogError("Failed parsing the uAMQP property value (return code %d).", result);
+				result = __FAILURE__;
+			}
+			// Codes_SRS_UAMQP_MESSAGING_09_043: [The application property name and value shall be added to IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate.]
+			else if (Map_AddOrUpdate(iothub_message_properties_map, key_name, key_value) != MAP_OK)
+			{
+				// Codes_SRS_UAMQP_MESSAGING_09_044: [If Map_AddOrUpdate fails, loading the application properties shall fail.]
+				LogError("Failed to add/update IoTHub message property map.");
+				result = __FAILURE__;
+			}
 
-					// Codes_SRS_UAMQP_MESSAGING_09_037: [The uAMQP application property name and value shall be obtained using amqpvalue_get_map_key_value_pair.]
-					if ((result = amqpvalue_get_map_key_value_pair(uamqp_app_properties_ipdv, i, &map_key_name, &map_key_value)) != 0)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_038: [If amqpvalue_get_map_key_value_pair fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed reading the key/value pair from the uAMQP property map (return code %d).", result);
-						result = __FAILURE__;
-					}
+			// Codes_SRS_UAMQP_MESSAGING_09_045: [The uAMQP message property name and value (obtained with amqpvalue_get_map_key_value_pair) shall be destroyed by calling amqpvalue_destroy().]
+			if (map_key_name != NULL)
+			{
+				amqpvalue_destroy(map_key_name);
+			}
 
-					// Codes_SRS_UAMQP_MESSAGING_09_039: [The uAMQP application property name shall be extracted as string using amqpvalue_get_string.]
-					else if ((result = amqpvalue_get_string(map_key_name, &key_name)) != 0)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_040: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed parsing the uAMQP property name (return code %d).", result);
-						result = __FAILURE__;
-					}
-					// Codes_SRS_UAMQP_MESSAGING_09_041: [The uAMQP application property value shall be extracted as string using amqpvalue_get_string.]
-					else if ((result = amqpvalue_get_string(map_key_value, &key_value)) != 0)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_042: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed parsing the uAMQP property value (return code %d).", result);
-						result = __FAILURE__;
-					}
-					// Codes_SRS_UAMQP_MESSAGING_09_043: [The application property name and value shall be added to IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate.]
-					else if (Map_AddOrUpdate(iothub_message_properties_map, key_name, key_value) != MAP_OK)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_044: [If Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed to add/update IoTHub message property map.");
-						result = __FAILURE__;
-					}
+			if (map_key_value != NULL)
+			{
+				amqpvalue_destroy(map_key_value);
+			}
+		}
+	}
 
-					// Codes_SRS_UAMQP_MESSAGING_09_045: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property name and value (obtained with amqpvalue_get_string) by calling amqpvalue_destroy().]
-					if (map_key_name != NULL)
-					{
-						amqpvalue_destroy(map_key_name);
-					}
+	return result;
+}
 
-					if (map_key_value != NULL)
-					{
-						amqpvalue_destroy(map_key_value);
-					}
-				}
-			}
+static void destroyApplicationPropertiesuAMQPValue(void* context)
+{
+	// Codes_SRS_UAMQP_MESSAGING_09_046: [The uAMQP message application properties (obtained with message_get_application_properties) shall be destroyed by calling amqpvalue_destroy() once they are loaded or the IOTHUB_MESSAGE_HANDLE is destroyed.]
+	amqpvalue_destroy((AMQP_VALUE)context);
+}
 
-			// Codes_SRS_UAMQP_MESSAGING_09_046: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property (obtained with message_get_application_properties) by calling amqpvalue_destroy().]
-			amqpvalue_destroy(uamqp_app_properties);
-		}
+static int readApplicationPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MESSAGE_HANDLE uamqp_message)
+{
+	int result;
+	AMQP_VALUE uamqp_app_properties = NULL;
+	AMQP_VALUE uamqp_app_properties_ipdv;
+
+	// Codes_SRS_UAMQP_MESSAGING_09_029: [The uAMQP message application properties shall be retrieved using message_get_application_properties.]
+	if ((result = message_get_application_properties(uamqp_message, &uamqp_app_properties)) != 0)
+	{
+		// Codes_SRS_UAMQP_MESSAGING_09_030: [If message_get_application_properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+		LogError("Failed reading the incoming uAMQP message properties (return code %d).", result);
+		result = __FAILURE__;
+	}
+	// Codes_SRS_UAMQP_MESSAGING_09_031: [If message_get_application_properties succeeds but returns a NULL application properties map (there are no properties), IoTHubMessage_CreateFromuAMQPMessage() shall skip processing the properties and continue normally.]
+	else if (uamqp_app_properties == NULL)
+	{
+		result = RESULT_OK;
+	}
+	// Codes_SRS_UAMQP_MESSAGING_09_123: [IoTHubMessage_CreateFromuAMQPMessage() shall check that the application properties (extracted using amqpvalue_get_inplace_described_value) are a map using amqpvalue_get_type, without decoding them; otherwise it shall destroy the application properties and fail.]
+	else if (((uamqp_app_properties_ipdv = amqpvalue_get_inplace_described_value(uamqp_app_properties)) == NULL) ||
+		(amqpvalue_get_type(uamqp_app_properties_ipdv) != AMQP_TYPE_MAP))
+	{
+		LogError("The incoming uAMQP message application properties are not a map.");
+		amqpvalue_destroy(uamqp_app_properties);
+		result = __FAILURE__;
+	}
+	// Codes_SRS_UAMQP_MESSAGING_09_112: [The application properties shall not be decoded by IoTHubMessage_CreateFromuAMQPMessage(); they shall be handed over to the IOTHUB_MESSAGE_HANDLE using IoTHubMessage_SetPropertiesLoader, so that they are only decoded when the IOTHUB_MESSAGE_HANDLE properties are first accessed.]
+	else if (IoTHubMessage_SetPropertiesLoader(iothub_message_handle, loadApplicationPropertiesFromuAMQPValue, destroyApplicationPropertiesuAMQPValue, uamqp_app_properties) != IOTHUB_MESSAGE_OK)
+	{
+		// Codes_SRS_UAMQP_MESSAGING_09_113: [If IoTHubMessage_SetPropertiesLoader fails, IoTHubMessage_CreateFromuAMQPMessage() shall destroy the application properties and fail.]
+		LogError("Failed setting the application properties loader on the IoTHub message.");
+		amqpvalue_destroy(uamqp_app_properties);
+		result = __FAILURE__;
+	}
+	else
+	{
+		result = RESULT_OK;
 	}
 
 	return result;
@@ -504,7 +607,7 @@ int IoTHubMessage_CreateFromUamqpMessage(MESSAGE_HANDLE uamqp_message, IOTHUB_ME
 	return result;
 }
 
-int message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
+static int createuAMQPMessage(UAMQP_MESSAGE_TEMPLATE* message_template, IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
 {
 	int result = __FAILURE__;
 	// Codes_SRS_UAMQP_MESSAGING_09_047: [The content type of the IOTHUB_MESSAGE_HANDLE instance shall be obtained using IoTHubMessage_GetContentType().]
@@ -567,7 +670,7 @@ int message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MES
 			LogError("Failed setting properties of the uAMQP message.");
 			result = __FAILURE__;
 		}
-		else if (addApplicationPropertiesTouAMQPMessage(iothub_message, uamqp_message_tmp) != RESULT_OK)
+		else if (addApplicationPropertiesTouAMQPMessage(message_template, iothub_message, uamqp_message_tmp) != RESULT_OK)
 		{
 			LogError("Failed setting application properties of the uAMQP message.");
 			result = __FAILURE__;
@@ -588,3 +691,61 @@ int message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MES
 
 	return result;
 }
+
+int message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
+{
+	return createuAMQPMessage(NULL, iothub_message, uamqp_message);
+}
+
+UAMQP_MESSAGE_TEMPLATE_HANDLE uamqp_message_template_create(void)
+{
+	UAMQP_MESSAGE_TEMPLATE* result;
+
+	// Codes_SRS_UAMQP_MESSAGING_09_114: [uamqp_message_template_create() shall allocate memory for the template and return its handle, with no application properties cached.]
+	if ((result = (UAMQP_MESSAGE_TEMPLATE*)malloc(sizeof(UAMQP_MESSAGE_TEMPLATE))) == NULL)
+	{
+		// Codes_SRS_UAMQP_MESSAGING_09_115: [If malloc() fails, uamqp_message_template_create() shall return NULL.]
+		LogError("Failed allocating the uAMQP message template.");
+	}
+	else
+	{
+		result->application_properties = NULL;
+		result->uamqp_application_properties = NULL;
+	}
+
+	return result;
+}
+
+void uamqp_message_template_destroy(UAMQP_MESSAGE_TEMPLATE_HANDLE message_template)
+{
+	// Codes_SRS_UAMQP_MESSAGING_09_116: [If message_template is NULL, uamqp_message_template_destroy() shall return.]
+	if (message_template != NULL)
+	{
+		// Codes_SRS_UAMQP_MESSAGING_09_117: [uamqp_message_template_destroy() shall destroy the cached application properties (using amqpvalue_destroy() and Map_Destroy()) and free the template.]
+		if (message_template->uamqp_application_properties != NULL)
+		{
+			amqpvalue_destroy(message_template->uamqp_application_properties);
+			Map_Destroy(message_template->application_properties);
+		}
+
+		free(message_template);
+	}
+}
+
+int message_create_from_iothub_message_with_template(UAMQP_MESSAGE_TEMPLATE_HANDLE message_template, IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
+{
+	int result;
+
+	// Codes_SRS_UAMQP_MESSAGING_09_118: [If message_template is NULL, message_create_from_iothub_message_with_template() shall fail and return.]
+	if (message_template == NULL)
+	{
+		LogError("Invalid argument (message_template is NULL).");
+		result = __FAILURE__;
+	}
+	else
+	{
+		result = createuAMQPMessage(message_template, iothub_message, uamqp_message);
+	}
+
+	return result;
+}
@@ -32,6 +32,7 @@ static void my_gballoc_free(void* s)
 #undef ENABLE_MOCKS
 
 #include "blob.h"
+#include "iothub_client_md5.h"
 #include "testrunnerswitcher.h"
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
@@ -62,10 +63,12 @@ static void my_HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
     my_gballoc_free(handle);
 }
 
+static const unsigned char* g_lastBufferSource; /*content of the last created BUFFER, seen by the storage stand-in*/
+static size_t g_lastBufferSize;
 static BUFFER_HANDLE my_BUFFER_create(const unsigned char* source, size_t size)
 {
-    (void)source;
-    (void)size;
+    g_lastBufferSource = source;
+    g_lastBufferSize = size;
     return (BUFFER_HANDLE)my_gballoc_malloc(1);
 }
 
@@ -97,10 +100,13 @@ static void my_STRING_delete(STRING_HANDLE h)
     my_gballoc_free((void*)h);
 }
 
+static unsigned char g_lastMd5[IOTHUB_CLIENT_MD5_SIZE]; /*last MD5 encoded in BASE64, that is the Content-MD5 of the last block*/
 static STRING_HANDLE my_Base64_Encode_Bytes(const unsigned char* source, size_t size)
 {
-    (void)source;
-    (void)size;
+    if (size == IOTHUB_CLIENT_MD5_SIZE)
+    {
+        (void)memcpy(g_lastMd5, source, size);
+    }
     return (STRING_HANDLE)my_gballoc_malloc(1);
 }
 
@@ -130,6 +136,95 @@ static unsigned int httpResponse; /*used as out parameter in every call to Blob_
 static const unsigned int TwoHundred = 200;
 static const unsigned int FourHundredFour = 404;
 
+#define TEST_BLOCK_SIZE (4 * 1024 * 1024)
+#define TEST_BLOCK_COUNT 3
+#define TEST_RESUMABLE_SIZE (2 * TEST_BLOCK_SIZE + 5) /*the last block is 5 bytes*/
+#define TEST_RESUMABLE_SASURI_1 "https://h.h/something?sig=1"
+#define TEST_RESUMABLE_SASURI_2 "https://h.h/something?sig=2" /*same blob, new SAS token*/
+#define TEST_RESUMABLE_SASURI_3 "https://h.h/somethingelse?sig=1"
+
+/*stand-in for the storage service at the end of a flaky link: it drops every dropEvery-th request, and counts the blocks it receives*/
+typedef struct STORAGE_STAND_IN_TAG
+{
+    const unsigned char* content;
+    size_t requestCount;
+    size_t dropEvery; /*0 means no request is dropped*/
+    unsigned int blockStatus;
+    unsigned int blockListStatus;
+    size_t blockUploads[TEST_BLOCK_COUNT];
+    size_t badMd5Count;
+    size_t blockListCount;
+} STORAGE_STAND_IN;
+
+static STORAGE_STAND_IN g_storage;
+
+static HTTPAPIEX_RESULT storage_HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPIEX_RESULT result;
+    (void)handle;
+    (void)requestType;
+    (void)relativePath;
+    (void)requestContent;
+    (void)responseHttpHeadersHandle;
+    (void)responseContent;
+
+    g_storage.requestCount++;
+    if ((g_storage.dropEvery != 0) && (g_storage.requestCount % g_storage.dropEvery == 0))
+    {
+        result = HTTPAPIEX_ERROR;
+    }
+    else
+    {
+        if (requestHttpHeadersHandle != NULL) /*only Put Block has request headers*/
+        {
+            unsigned char md5[IOTHUB_CLIENT_MD5_SIZE];
+            ASSERT_ARE_EQUAL(int, 0, md5_compute(g_lastBufferSource, g_lastBufferSize, md5));
+            if (memcmp(md5, g_lastMd5, IOTHUB_CLIENT_MD5_SIZE) != 0)
+            {
+                g_storage.badMd5Count++;
+            }
+            if (g_storage.blockStatus < 300)
+            {
+                g_storage.blockUploads[(g_lastBufferSource - g_storage.content) / TEST_BLOCK_SIZE]++;
+            }
+            *statusCode = g_storage.blockStatus;
+        }
+        else
+        {
+            g_storage.blockListCount++;
+            *statusCode = g_storage.blockListStatus;
+        }
+        result = HTTPAPIEX_OK;
+    }
+
+    return result;
+}
+
+static unsigned char* start_storage_stand_in(void)
+{
+    unsigned char* content = (unsigned char*)gballoc_malloc(TEST_RESUMABLE_SIZE);
+    ASSERT_IS_NOT_NULL(content);
+    memset(content, '3', TEST_RESUMABLE_SIZE);
+    content[TEST_BLOCK_SIZE] = '4';
+    content[TEST_RESUMABLE_SIZE - 1] = '5';
+
+    memset(&g_storage, 0, sizeof(g_storage));
+    g_storage.content = content;
+    g_storage.blockStatus = 201;
+    g_storage.blockListStatus = 201;
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_ExecuteRequest, storage_HTTPAPIEX_ExecuteRequest);
+    umock_c_reset_all_calls();
+
+    return content;
+}
+
+static void stop_storage_stand_in(unsigned char* content, BLOB_UPLOAD_PROGRESS* progress)
+{
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_ExecuteRequest, NULL);
+    Blob_ClearUploadProgress(progress);
+    gballoc_free(content);
+}
+
 
 BEGIN_TEST_SUITE(blob_ut)
 
@@ -1471,5 +1566,467 @@ TEST_FUNCTION(Blob_UploadFromSasUri_when_http_code_is_404_it_immediately_succeed
     
 }
 
+/*Tests_SRS_BLOB_09_001: [ If SASURI or progress are NULL, or source is NULL and size is not zero, then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_with_NULL_SasUri_fails)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char c = '3';
+    memset(&progress, 0, sizeof(progress));
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(NULL, &c, sizeof(c), &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+
+/*Tests_SRS_BLOB_09_001: [ If SASURI or progress are NULL, or source is NULL and size is not zero, then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_with_NULL_progress_fails)
+{
+    ///arrange
+    unsigned char c = '3';
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_VALID_SASURI_1, &c, sizeof(c), &httpResponse, testValidBufferHandle, NULL, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+
+/*Tests_SRS_BLOB_09_001: [ If SASURI or progress are NULL, or source is NULL and size is not zero, then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_with_NULL_source_and_non_zero_size_fails)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    memset(&progress, 0, sizeof(progress));
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_VALID_SASURI_1, NULL, 1, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+
+#if SIZE_MAX > 4294967295
+/*Tests_SRS_BLOB_09_002: [ If size is bigger than 50000 blocks of 4MB then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_fails_when_size_is_exceeded)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    size_t size = 50000ULL * 4 * 1024 * 1024 + 1;
+    unsigned char c = 3;
+    memset(&progress, 0, sizeof(progress));
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, &c, size, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+#endif
+
+/*Tests_SRS_BLOB_09_003: [ If the hostname cannot be determined from SASURI, then Blob_UploadResumableFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_when_SasUri_is_wrong_fails)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char c = '3';
+    memset(&progress, 0, sizeof(progress));
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri("https://h.h", &c, sizeof(c), &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+
+/*Tests_SRS_BLOB_09_004: [ Blob_UploadResumableFromSasUri shall create a HTTPAPIEX_HANDLE to the hostname, passing certificates (if any) with the option "TrustedCerts". ]*/
+/*Tests_SRS_BLOB_09_014: [ If any other operation fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_ERROR. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_fails_when_HTTPAPIEX_Create_fails)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char c = '3';
+    memset(&progress, 0, sizeof(progress));
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating a copy of the hostname */
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*this is freeing the copy of the hostname*/
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, &c, sizeof(c), &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(progress.SASURI);
+
+    ///cleanup
+}
+
+/*Tests_SRS_BLOB_09_005: [ If progress records an upload of the same blob (SASURI without its query) and size, Blob_UploadResumableFromSasUri shall resume it and save SASURI; otherwise it shall clear progress and record the upload of size bytes in blocks of 4MB. ]*/
+/*Tests_SRS_BLOB_09_007: [ Otherwise Blob_UploadResumableFromSasUri shall PUT the block to base relativePath + "&comp=block&blockid=BASE64 encoded block ID (000000... 049999)", with the header Content-MD5 set to the BASE64 encoded MD5 of the block. ]*/
+/*Tests_SRS_BLOB_09_010: [ Otherwise Blob_UploadResumableFromSasUri shall record in progress the block as uploaded, with its MD5. ]*/
+/*Tests_SRS_BLOB_09_011: [ Once all the blocks are uploaded, Blob_UploadResumableFromSasUri shall PUT to base relativePath + "&comp=blocklist" the XML list of all the block IDs. ]*/
+/*Tests_SRS_BLOB_09_013: [ Otherwise Blob_UploadResumableFromSasUri shall return BLOB_OK, clearing progress if the HTTP status of the block list is < 300 or 400 (the block list is rejected). ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_happy_path)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "Content-MD5", IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "Content-MD5", IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "Content-MD5", IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3);
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls()); /*every block was sent with a Content-MD5*/
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(int, 201, httpResponse);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[0]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_storage.badMd5Count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockListCount);
+    ASSERT_IS_NULL(progress.SASURI);
+    ASSERT_IS_NULL(progress.blocks);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_005: [ If progress records an upload of the same blob (SASURI without its query) and size, Blob_UploadResumableFromSasUri shall resume it and save SASURI; otherwise it shall clear progress and record the upload of size bytes in blocks of 4MB. ]*/
+/*Tests_SRS_BLOB_09_006: [ For every block Blob_UploadResumableFromSasUri shall compute the MD5 of its content, and skip it if progress records it as uploaded with the same MD5. ]*/
+/*Tests_SRS_BLOB_09_008: [ If HTTPAPIEX_ExecuteRequest fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_HTTP_ERROR, keeping in progress the blocks uploaded so far. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_resumes_after_the_connection_drops)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.dropEvery = 2; /*the connection drops while uploading the second block*/
+
+    BLOB_RESULT result1 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_HTTP_ERROR, result1);
+    ASSERT_IS_NOT_NULL(progress.SASURI);
+    ASSERT_ARE_EQUAL(size_t, TEST_BLOCK_COUNT, progress.blockCount);
+    ASSERT_IS_TRUE(progress.blocks[0].isUploaded);
+    ASSERT_IS_FALSE(progress.blocks[1].isUploaded);
+    g_storage.dropEvery = 0;
+
+    ///act
+    BLOB_RESULT result2 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_2, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result2);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[0]); /*not uploaded again*/
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_storage.badMd5Count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockListCount);
+    ASSERT_IS_NULL(progress.SASURI);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_006: [ For every block Blob_UploadResumableFromSasUri shall compute the MD5 of its content, and skip it if progress records it as uploaded with the same MD5. ]*/
+/*Tests_SRS_BLOB_09_008: [ If HTTPAPIEX_ExecuteRequest fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_HTTP_ERROR, keeping in progress the blocks uploaded so far. ]*/
+/*Tests_SRS_BLOB_09_012: [ If HTTPAPIEX_ExecuteRequest fails, then Blob_UploadResumableFromSasUri shall fail and return BLOB_HTTP_ERROR, keeping progress. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_uploads_every_block_once_over_a_flaky_link)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    BLOB_RESULT result = BLOB_HTTP_ERROR;
+    size_t attempts = 0;
+    memset(&progress, 0, sizeof(progress));
+    g_storage.dropEvery = 2; /*every other request is dropped, the block list included*/
+
+    ///act
+    while ((result == BLOB_HTTP_ERROR) && (attempts < 10))
+    {
+        result = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+        attempts++;
+    }
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 4, attempts); /*1 request dropped per attempt and 4 requests to send*/
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[0]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_storage.badMd5Count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockListCount);
+    ASSERT_IS_NULL(progress.SASURI);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_006: [ For every block Blob_UploadResumableFromSasUri shall compute the MD5 of its content, and skip it if progress records it as uploaded with the same MD5. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_uploads_again_a_block_whose_content_changed)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.dropEvery = 3; /*the connection drops while uploading the third block*/
+
+    BLOB_RESULT result1 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_HTTP_ERROR, result1);
+    g_storage.dropEvery = 0;
+    content[TEST_BLOCK_SIZE + 1] = '6';
+
+    ///act
+    BLOB_RESULT result2 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result2);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[0]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_storage.badMd5Count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockListCount);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_005: [ If progress records an upload of the same blob (SASURI without its query) and size, Blob_UploadResumableFromSasUri shall resume it and save SASURI; otherwise it shall clear progress and record the upload of size bytes in blocks of 4MB. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_starts_over_for_another_blob)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.dropEvery = 3;
+
+    BLOB_RESULT result1 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_HTTP_ERROR, result1);
+    g_storage.dropEvery = 0;
+
+    ///act
+    BLOB_RESULT result2 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_3, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result2);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockUploads[0]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockListCount);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_009: [ If the HTTP status of a block is >= 300, then Blob_UploadResumableFromSasUri shall stop, keep progress and return BLOB_OK. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_when_http_code_is_404_it_immediately_succeeds)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.blockStatus = 404;
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(int, 404, httpResponse);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.requestCount); /*no Put Block List*/
+    ASSERT_ARE_EQUAL(size_t, 0, g_storage.blockListCount);
+    ASSERT_IS_NOT_NULL(progress.SASURI);
+    ASSERT_IS_FALSE(progress.blocks[0].isUploaded);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_013: [ Otherwise Blob_UploadResumableFromSasUri shall return BLOB_OK, clearing progress if the HTTP status of the block list is < 300 or 400 (the block list is rejected). ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_when_the_block_list_is_rejected_starts_over)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.blockListStatus = 400; /*InvalidBlockList*/
+
+    BLOB_RESULT result1 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result1);
+    ASSERT_ARE_EQUAL(int, 400, httpResponse);
+    ASSERT_IS_NULL(progress.SASURI);
+    ASSERT_IS_NULL(progress.blocks);
+    g_storage.blockListStatus = 201;
+
+    ///act
+    BLOB_RESULT result2 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_2, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result2);
+    ASSERT_ARE_EQUAL(int, 201, httpResponse);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockUploads[0]); /*every block is uploaded again*/
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockListCount);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_013: [ Otherwise Blob_UploadResumableFromSasUri shall return BLOB_OK, clearing progress if the HTTP status of the block list is < 300 or 400 (the block list is rejected). ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_when_the_block_list_gets_a_server_error_keeps_progress)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.blockListStatus = 503;
+
+    BLOB_RESULT result1 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result1);
+    ASSERT_ARE_EQUAL(int, 503, httpResponse);
+    ASSERT_IS_NOT_NULL(progress.SASURI);
+    g_storage.blockListStatus = 201;
+
+    ///act
+    BLOB_RESULT result2 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_2, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result2);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[0]); /*only the block list is sent again*/
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockListCount);
+    ASSERT_IS_NULL(progress.SASURI);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_013: [ Otherwise Blob_UploadResumableFromSasUri shall return BLOB_OK, clearing progress if the HTTP status of the block list is < 300 or 400 (the block list is rejected). ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_when_the_block_list_gets_403_keeps_progress)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.blockListStatus = 403; /*the SAS expired*/
+
+    BLOB_RESULT result1 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result1);
+    ASSERT_ARE_EQUAL(int, 403, httpResponse);
+    ASSERT_IS_NOT_NULL(progress.SASURI);
+    g_storage.blockListStatus = 201;
+
+    ///act
+    BLOB_RESULT result2 = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_2, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result2);
+    ASSERT_ARE_EQUAL(int, 201, httpResponse);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[0]); /*only the block list is sent again, with the new SAS*/
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockUploads[2]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_storage.blockListCount);
+    ASSERT_IS_NULL(progress.SASURI);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_005: [ If progress records an upload of the same blob (SASURI without its query) and size, Blob_UploadResumableFromSasUri shall resume it and save SASURI; otherwise it shall clear progress and record the upload of size bytes in blocks of 4MB. ]*/
+/*Tests_SRS_BLOB_09_011: [ Once all the blocks are uploaded, Blob_UploadResumableFromSasUri shall PUT to base relativePath + "&comp=blocklist" the XML list of all the block IDs. ]*/
+TEST_FUNCTION(Blob_UploadResumableFromSasUri_with_0_size_puts_an_empty_block_list)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+
+    ///act
+    BLOB_RESULT result = Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, NULL, 0, &httpResponse, testValidBufferHandle, NULL, &progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.requestCount);
+    ASSERT_ARE_EQUAL(size_t, 1, g_storage.blockListCount);
+    ASSERT_IS_NULL(progress.SASURI);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
+
+/*Tests_SRS_BLOB_09_015: [ If progress is NULL, Blob_ClearUploadProgress shall return. ]*/
+TEST_FUNCTION(Blob_ClearUploadProgress_with_NULL_progress_returns)
+{
+    ///arrange
+
+    ///act
+    Blob_ClearUploadProgress(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+
+/*Tests_SRS_BLOB_09_016: [ Blob_ClearUploadProgress shall free the SASURI and the blocks saved in progress, and set it to 0. ]*/
+TEST_FUNCTION(Blob_ClearUploadProgress_frees_the_progress)
+{
+    ///arrange
+    BLOB_UPLOAD_PROGRESS progress;
+    unsigned char* content = start_storage_stand_in();
+    memset(&progress, 0, sizeof(progress));
+    g_storage.dropEvery = 2;
+    (void)Blob_UploadResumableFromSasUri(TEST_RESUMABLE_SASURI_1, content, TEST_RESUMABLE_SIZE, &httpResponse, testValidBufferHandle, NULL, &progress);
+    ASSERT_IS_NOT_NULL(progress.SASURI);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(progress.SASURI));
+    STRICT_EXPECTED_CALL(gballoc_free(progress.blocks));
+
+    ///act
+    Blob_ClearUploadProgress(&progress);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(progress.SASURI);
+    ASSERT_IS_NULL(progress.blocks);
+    ASSERT_ARE_EQUAL(size_t, 0, progress.blockCount);
+
+    ///cleanup
+    stop_storage_stand_in(content, &progress);
+}
 
 END_TEST_SUITE(blob_ut);
@@ -41,6 +41,8 @@ static const char* SCOPE_NAME = "Scope_name";
 static const char* TEST_SAS_TOKEN = "sas_token";
 static const char* TEST_STRING_VALUE = "Test_string_value";
 static size_t TEST_EXPIRY_TIME = 1;
+static const char* OTHER_SCOPE_NAME = "Other_scope_name";
+#define TEST_SAS_TOKEN_LIFETIME             3600
 
 #define TEST_TIME_VALUE                     (time_t)123456
 
@@ -169,7 +171,7 @@ static void setup_IoTHubClient_Auth_Get_ConnString_mocks()
     STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, SCOPE_NAME, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, SCOPE_NAME));
 }
 
 static int should_skip_index(size_t current_index, const size_t skip_array[], size_t length)
@@ -541,6 +543,94 @@ TEST_FUNCTION(IoTHubClient_Auth_Get_ConnString_fail)
     umock_c_negative_tests_deinit();
 }
 
+/* Codes_SRS_IoTHub_Authorization_07_025: [ If a sas token was previously created for the same scope and it expires no more than 10% of expire_time before the requested expiration time, IoTHubClient_Auth_Get_SasToken shall return a copy of that sas token without calling SASToken_CreateString. ] */
+/* Codes_SRS_IoTHub_Authorization_07_026: [ IoTHubClient_Auth_Get_SasToken shall keep the sas token it created, its scope and its expiration time, replacing the previously kept sas token. ] */
+TEST_FUNCTION(IoTHubClient_Auth_Get_SasToken_reuses_the_cached_sas_token)
+{
+    //arrange
+    IOTHUB_AUTHORIZATION_HANDLE handle = IoTHubClient_Auth_Create(DEVICE_KEY, DEVICE_ID, NULL);
+    char* first_token = IoTHubClient_Auth_Get_SasToken(handle, SCOPE_NAME, TEST_SAS_TOKEN_LIFETIME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+        .SetReturn(TEST_SAS_TOKEN_LIFETIME / 10); /*the cached token has exactly 90% of the lifetime left*/
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    //act
+    char* second_token = IoTHubClient_Auth_Get_SasToken(handle, SCOPE_NAME, TEST_SAS_TOKEN_LIFETIME);
+
+    //assert
+    ASSERT_IS_NOT_NULL(second_token);
+    ASSERT_ARE_EQUAL(char_ptr, first_token, second_token);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    free(first_token);
+    free(second_token);
+    IoTHubClient_Auth_Destroy(handle);
+}
+
+/* Codes_SRS_IoTHub_Authorization_07_025: [ If a sas token was previously created for the same scope and it expires no more than 10% of expire_time before the requested expiration time, IoTHubClient_Auth_Get_SasToken shall return a copy of that sas token without calling SASToken_CreateString. ] */
+TEST_FUNCTION(IoTHubClient_Auth_Get_SasToken_creates_a_new_sas_token_when_the_cached_one_is_too_old)
+{
+    //arrange
+    IOTHUB_AUTHORIZATION_HANDLE handle = IoTHubClient_Auth_Create(DEVICE_KEY, DEVICE_ID, NULL);
+    char* first_token = IoTHubClient_Auth_Get_SasToken(handle, SCOPE_NAME, TEST_SAS_TOKEN_LIFETIME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+        .SetReturn(TEST_SAS_TOKEN_LIFETIME / 10 + 1);
+    STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, SCOPE_NAME, IGNORED_PTR_ARG, TEST_SAS_TOKEN_LIFETIME + TEST_SAS_TOKEN_LIFETIME / 10 + 1));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*the previously cached token*/
+
+    //act
+    char* second_token = IoTHubClient_Auth_Get_SasToken(handle, SCOPE_NAME, TEST_SAS_TOKEN_LIFETIME);
+
+    //assert
+    ASSERT_IS_NOT_NULL(second_token);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    free(first_token);
+    free(second_token);
+    IoTHubClient_Auth_Destroy(handle);
+}
+
+/* Codes_SRS_IoTHub_Authorization_07_025: [ If a sas token was previously created for the same scope and it expires no more than 10% of expire_time before the requested expiration time, IoTHubClient_Auth_Get_SasToken shall return a copy of that sas token without calling SASToken_CreateString. ] */
+TEST_FUNCTION(IoTHubClient_Auth_Get_SasToken_creates_a_new_sas_token_for_a_different_scope)
+{
+    //arrange
+    IOTHUB_AUTHORIZATION_HANDLE handle = IoTHubClient_Auth_Create(DEVICE_KEY, DEVICE_ID, NULL);
+    char* first_token = IoTHubClient_Auth_Get_SasToken(handle, SCOPE_NAME, TEST_SAS_TOKEN_LIFETIME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, OTHER_SCOPE_NAME, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*the previously cached scope*/
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, OTHER_SCOPE_NAME));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*the previously cached token*/
+
+    //act
+    char* second_token = IoTHubClient_Auth_Get_SasToken(handle, OTHER_SCOPE_NAME, TEST_SAS_TOKEN_LIFETIME);
+
+    //assert
+    ASSERT_IS_NOT_NULL(second_token);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    free(first_token);
+    free(second_token);
+    IoTHubClient_Auth_Destroy(handle);
+}
+
 /* Codes_SRS_IoTHub_Authorization_07_013: [ if handle is NULL, IoTHubClient_Auth_Get_DeviceId shall return NULL. ] */
 TEST_FUNCTION(IoTHubClient_Auth_Get_DeviceId_handle_NULL)
 {
@@ -0,0 +1,686 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <csetjmp>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+	free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_callback_executor.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_THREAD_COUNT                   2
+#define TEST_MAX_PENDING_TASKS              4
+#define TEST_MAX_TASK_LOG                   16
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4441;
+static const COND_HANDLE TEST_TASK_AVAILABLE = (COND_HANDLE)0x4442;
+static const COND_HANDLE TEST_TASK_COMPLETED = (COND_HANDLE)0x4443;
+static const THREAD_HANDLE TEST_THREAD_HANDLE = (THREAD_HANDLE)0x4444;
+static const void* TEST_OWNER_1 = (const void*)0x4445;
+static const void* TEST_OWNER_2 = (const void*)0x4446;
+
+// The threads of the executor are not started: the tests run their function on the test thread, from the hooks of
+// ThreadAPI_Join (destroy) and of Condition_Wait on task_completed (submit, drain). When the function waits for a
+// task, it is parked by jumping back to run_executor_thread().
+static THREAD_START_FUNC g_thread_function;
+static void* g_thread_argument;
+static size_t g_condition_init_count;
+static jmp_buf g_parked_thread;
+static bool g_is_thread_running;
+
+static size_t g_task_log[TEST_MAX_TASK_LOG];
+static size_t g_task_log_count;
+static CALLBACK_EXECUTOR_HANDLE g_executor_to_submit_to;
+static int g_nested_submit_result;
+
+
+// Helpers
+
+static void run_executor_thread(void)
+{
+	if (setjmp(g_parked_thread) == 0)
+	{
+		g_is_thread_running = true;
+		(void)g_thread_function(g_thread_argument);
+	}
+
+	g_is_thread_running = false;
+}
+
+static COND_HANDLE TEST_Condition_Init(void)
+{
+	return (g_condition_init_count++ % 2 == 0) ? TEST_TASK_AVAILABLE : TEST_TASK_COMPLETED;
+}
+
+static COND_RESULT TEST_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+	(void)lock;
+	(void)timeout_milliseconds;
+
+	if (handle == TEST_TASK_AVAILABLE)
+	{
+		if (g_is_thread_running)
+		{
+			longjmp(g_parked_thread, 1);
+		}
+	}
+	else if (!g_is_thread_running)
+	{
+		run_executor_thread();
+	}
+
+	return COND_OK;
+}
+
+static THREADAPI_RESULT TEST_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+	g_thread_function = func;
+	g_thread_argument = arg;
+	*threadHandle = TEST_THREAD_HANDLE;
+	return THREADAPI_OK;
+}
+
+static THREADAPI_RESULT TEST_ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
+{
+	(void)threadHandle;
+	run_executor_thread();
+	*res = 0;
+	return THREADAPI_OK;
+}
+
+static void log_task(void* context)
+{
+	ASSERT_IS_TRUE(g_task_log_count < TEST_MAX_TASK_LOG);
+	g_task_log[g_task_log_count++] = (size_t)(uintptr_t)context;
+}
+
+static void submit_from_task(void* context)
+{
+	log_task(context);
+	g_nested_submit_result = callback_executor_submit(g_executor_to_submit_to, TEST_OWNER_1, 0, log_task, context);
+}
+
+static void register_global_mock_hooks()
+{
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+	REGISTER_GLOBAL_MOCK_HOOK(Condition_Init, TEST_Condition_Init);
+	REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, TEST_Condition_Wait);
+	REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, TEST_ThreadAPI_Create);
+	REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Join, TEST_ThreadAPI_Join);
+}
+
+static void register_global_mock_returns()
+{
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+	REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+	REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+}
+
+static void register_umock_alias_types()
+{
+	REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+	REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
+	REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+}
+
+static CALLBACK_EXECUTOR_HANDLE create_executor(size_t max_pending_tasks)
+{
+	umock_c_reset_all_calls();
+	CALLBACK_EXECUTOR_HANDLE executor = callback_executor_create(TEST_THREAD_COUNT, max_pending_tasks);
+	ASSERT_IS_NOT_NULL(executor);
+	umock_c_reset_all_calls();
+
+	return executor;
+}
+
+static void set_expected_calls_for_create(size_t thread_count)
+{
+	size_t i;
+
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(Lock_Init());
+	STRICT_EXPECTED_CALL(Condition_Init());
+	STRICT_EXPECTED_CALL(Condition_Init());
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	for (i = 0; i < thread_count; i++)
+	{
+		STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+	}
+}
+
+static void set_expected_calls_for_submit(bool is_new_lane)
+{
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	if (is_new_lane)
+	{
+		STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	}
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Condition_Post(TEST_TASK_AVAILABLE));
+}
+
+static void assert_task_log(const size_t* expected_tasks, size_t expected_count)
+{
+	size_t i;
+
+	ASSERT_ARE_EQUAL(size_t, expected_count, g_task_log_count);
+	for (i = 0; i < expected_count; i++)
+	{
+		ASSERT_ARE_EQUAL(size_t, expected_tasks[i], g_task_log[i]);
+	}
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_callback_executor_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_stdint_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_bool_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	register_umock_alias_types();
+	register_global_mock_returns();
+	register_global_mock_hooks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	g_thread_function = NULL;
+	g_thread_argument = NULL;
+	g_condition_init_count = 0;
+	g_is_thread_running = false;
+	g_task_log_count = 0;
+	g_executor_to_submit_to = NULL;
+	g_nested_submit_result = 0;
+
+	umock_c_reset_all_calls();
+	umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_001: [ If `thread_count` or `max_pending_tasks` is zero, callback_executor_create shall fail and return NULL. ]
+TEST_FUNCTION(create_zero_thread_count_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	CALLBACK_EXECUTOR_HANDLE executor = callback_executor_create(0, TEST_MAX_PENDING_TASKS);
+
+	// assert
+	ASSERT_IS_NULL(executor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_001: [ If `thread_count` or `max_pending_tasks` is zero, callback_executor_create shall fail and return NULL. ]
+TEST_FUNCTION(create_zero_max_pending_tasks_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	CALLBACK_EXECUTOR_HANDLE executor = callback_executor_create(TEST_THREAD_COUNT, 0);
+
+	// assert
+	ASSERT_IS_NULL(executor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_002: [ callback_executor_create shall create a lock, two conditions and `thread_count` threads running the tasks. ]
+TEST_FUNCTION(create_success)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	set_expected_calls_for_create(TEST_THREAD_COUNT);
+
+	// act
+	CALLBACK_EXECUTOR_HANDLE executor = callback_executor_create(TEST_THREAD_COUNT, TEST_MAX_PENDING_TASKS);
+
+	// assert
+	ASSERT_IS_NOT_NULL(executor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_003: [ If any resource fails to be created, callback_executor_create shall release the ones already created and return NULL. ]
+TEST_FUNCTION(create_negative_tests)
+{
+	// arrange
+	size_t i;
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+	umock_c_reset_all_calls();
+	set_expected_calls_for_create(TEST_THREAD_COUNT);
+	umock_c_negative_tests_snapshot();
+
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		// arrange
+		char error_msg[64];
+		umock_c_negative_tests_reset();
+		umock_c_negative_tests_fail_call(i);
+		g_condition_init_count = 0;
+
+		// act
+		CALLBACK_EXECUTOR_HANDLE executor = callback_executor_create(TEST_THREAD_COUNT, TEST_MAX_PENDING_TASKS);
+
+		// assert
+		(void)sprintf(error_msg, "On failed call %lu", (unsigned long)i);
+		ASSERT_IS_NULL_WITH_MSG(executor, error_msg);
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_004: [ callback_executor_destroy shall let the threads run the queued tasks, join them and release all the resources of the executor. ]
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_011: [ When stopping, the threads shall exit once no task is queued. ]
+TEST_FUNCTION(destroy_joins_the_threads_and_releases_the_resources)
+{
+	// arrange
+	size_t i;
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	for (i = 0; i < TEST_THREAD_COUNT; i++)
+	{
+		STRICT_EXPECTED_CALL(Condition_Post(TEST_TASK_AVAILABLE));
+	}
+	for (i = 0; i < TEST_THREAD_COUNT; i++)
+	{
+		STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+		STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+		STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+		STRICT_EXPECTED_CALL(ThreadAPI_Exit(0));
+	}
+	STRICT_EXPECTED_CALL(Condition_Deinit(TEST_TASK_COMPLETED));
+	STRICT_EXPECTED_CALL(Condition_Deinit(TEST_TASK_AVAILABLE));
+	STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+
+	// act
+	callback_executor_destroy(executor);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_004: [ callback_executor_destroy shall let the threads run the queued tasks, join them and release all the resources of the executor. ]
+TEST_FUNCTION(destroy_runs_the_queued_tasks)
+{
+	// arrange
+	static const size_t expected_tasks[] = { 1, 2 };
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_2, 0, log_task, (void*)2));
+
+	// act
+	callback_executor_destroy(executor);
+
+	// assert
+	assert_task_log(expected_tasks, 2);
+}
+
+TEST_FUNCTION(destroy_NULL_does_nothing)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	callback_executor_destroy(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_005: [ If `executor` or `task_function` is NULL, callback_executor_submit shall fail and return a non-zero value. ]
+TEST_FUNCTION(submit_NULL_executor_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	int result = callback_executor_submit(NULL, TEST_OWNER_1, 0, log_task, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_005: [ If `executor` or `task_function` is NULL, callback_executor_submit shall fail and return a non-zero value. ]
+TEST_FUNCTION(submit_NULL_task_function_fails)
+{
+	// arrange
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+
+	// act
+	int result = callback_executor_submit(executor, TEST_OWNER_1, 0, NULL, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_007: [ callback_executor_submit shall queue the task at the end of the lane identified by `owner` and `lane`, and wake up a thread if the lane was idle. ]
+TEST_FUNCTION(submit_creates_the_lane_and_wakes_up_a_thread)
+{
+	// arrange
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	set_expected_calls_for_submit(true);
+
+	// act
+	int result = callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, g_task_log_count);
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_007: [ callback_executor_submit shall queue the task at the end of the lane identified by `owner` and `lane`, and wake up a thread if the lane was idle. ]
+TEST_FUNCTION(submit_to_a_lane_with_queued_tasks_reuses_the_lane)
+{
+	// arrange
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1));
+	umock_c_reset_all_calls();
+	set_expected_calls_for_submit(false);
+
+	// act
+	int result = callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)2);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_008: [ If any step fails, callback_executor_submit shall return a non-zero value and the task shall not be run. ]
+TEST_FUNCTION(submit_negative_tests)
+{
+	// arrange
+	size_t i;
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+	umock_c_reset_all_calls();
+	set_expected_calls_for_submit(true);
+	umock_c_negative_tests_snapshot();
+
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		if (umock_c_negative_tests_can_call_fail(i))
+		{
+			// arrange
+			char error_msg[64];
+			CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+			umock_c_negative_tests_reset();
+			umock_c_negative_tests_fail_call(i);
+
+			// act
+			int result = callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1);
+
+			// assert
+			(void)sprintf(error_msg, "On failed call %lu", (unsigned long)i);
+			ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, error_msg);
+
+			// cleanup
+			callback_executor_destroy(executor);
+			ASSERT_ARE_EQUAL_WITH_MSG(size_t, 0, g_task_log_count, error_msg);
+		}
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_008: [ If any step fails, callback_executor_submit shall return a non-zero value and the task shall not be run. ]
+TEST_FUNCTION(submit_while_the_executor_is_destroyed_fails)
+{
+	// arrange
+	static const size_t expected_tasks[] = { 1 };
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	g_executor_to_submit_to = executor;
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, submit_from_task, (void*)1));
+
+	// act
+	callback_executor_destroy(executor);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, g_nested_submit_result);
+	assert_task_log(expected_tasks, 1);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_006: [ While `max_pending_tasks` tasks are queued or running, callback_executor_submit shall wait for one of them to complete. ]
+TEST_FUNCTION(submit_waits_while_the_executor_is_full)
+{
+	// arrange
+	static const size_t expected_tasks[] = { 1 };
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(1);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1));
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Condition_Wait(TEST_TASK_COMPLETED, TEST_LOCK_HANDLE, IGNORED_NUM_ARG));
+
+	// act
+	int result = callback_executor_submit(executor, TEST_OWNER_2, 0, log_task, (void*)2);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	assert_task_log(expected_tasks, 1);
+	ASSERT_IS_TRUE(strstr(umock_c_get_actual_calls(), umock_c_get_expected_calls()) == umock_c_get_actual_calls());
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_009: [ The threads shall run the tasks of a lane one at a time, in the order they were submitted, and the tasks of different lanes concurrently, without holding the lock of the executor. ]
+TEST_FUNCTION(tasks_of_a_lane_run_in_order)
+{
+	// arrange
+	static const size_t expected_tasks[] = { 1, 2, 3 };
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)2));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)3));
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Condition_Post(TEST_TASK_COMPLETED));
+
+	// act
+	run_executor_thread();
+
+	// assert
+	assert_task_log(expected_tasks, 3);
+	ASSERT_IS_TRUE(strstr(umock_c_get_actual_calls(), umock_c_get_expected_calls()) == umock_c_get_actual_calls());
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_009: [ The threads shall run the tasks of a lane one at a time, in the order they were submitted, and the tasks of different lanes concurrently, without holding the lock of the executor. ]
+TEST_FUNCTION(lanes_take_turns)
+{
+	// arrange
+	static const size_t expected_tasks[] = { 1, 3, 4, 2 };
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)2));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 1, log_task, (void*)3));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_2, 0, log_task, (void*)4));
+
+	// act
+	run_executor_thread();
+
+	// assert
+	assert_task_log(expected_tasks, 4);
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_010: [ callback_executor_drain shall return once no task of `owner` is queued or running. ]
+TEST_FUNCTION(drain_without_tasks_of_the_owner_returns)
+{
+	// arrange
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_2, 0, log_task, (void*)1));
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+	// act
+	callback_executor_drain(executor, TEST_OWNER_1);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, g_task_log_count);
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_CALLBACK_EXECUTOR_09_010: [ callback_executor_drain shall return once no task of `owner` is queued or running. ]
+TEST_FUNCTION(drain_waits_for_the_tasks_of_the_owner)
+{
+	// arrange
+	static const size_t expected_tasks[] = { 1, 2 };
+	CALLBACK_EXECUTOR_HANDLE executor = create_executor(TEST_MAX_PENDING_TASKS);
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 0, log_task, (void*)1));
+	ASSERT_ARE_EQUAL(int, 0, callback_executor_submit(executor, TEST_OWNER_1, 1, log_task, (void*)2));
+	umock_c_reset_all_calls();
+
+	// act
+	callback_executor_drain(executor, TEST_OWNER_1);
+
+	// assert
+	assert_task_log(expected_tasks, 2);
+
+	// cleanup
+	callback_executor_destroy(executor);
+}
+
+TEST_FUNCTION(drain_NULL_executor_does_nothing)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	callback_executor_drain(NULL, TEST_OWNER_1);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(iothub_client_callback_executor_ut)
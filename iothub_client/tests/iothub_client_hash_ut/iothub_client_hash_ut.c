@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#include "iothub_client_hash.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+typedef struct TEST_VECTOR_TAG
+{
+	const char* text;
+	uint32_t hash;
+} TEST_VECTOR;
+
+// Test vectors of the FNV reference implementation.
+static const TEST_VECTOR FNV1A_32_TEST_VECTORS[] =
+{
+	{ "", 0x811c9dc5 },
+	{ "a", 0xe40c292c },
+	{ "foobar", 0xbf9cf968 }
+};
+
+
+BEGIN_TEST_SUITE(iothub_client_hash_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_HASH_09_001: [hash_fnv1a shall return the 32 bit FNV-1a hash of the characters of `text` before its terminating '\0']
+TEST_FUNCTION(hash_fnv1a_test_vectors)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(FNV1A_32_TEST_VECTORS) / sizeof(FNV1A_32_TEST_VECTORS[0]); i++)
+	{
+		// act
+		uint32_t result = hash_fnv1a(FNV1A_32_TEST_VECTORS[i].text);
+
+		// assert
+		ASSERT_ARE_EQUAL(uint32_t, FNV1A_32_TEST_VECTORS[i].hash, result);
+	}
+}
+
+// Tests_SRS_IOTHUB_CLIENT_HASH_09_001: [hash_fnv1a shall return the 32 bit FNV-1a hash of the characters of `text` before its terminating '\0']
+TEST_FUNCTION(hash_fnv1a_stops_at_the_terminating_character)
+{
+	// arrange
+	const char text[] = "foobar\0device";
+
+	// act
+	uint32_t result = hash_fnv1a(text);
+
+	// assert
+	ASSERT_ARE_EQUAL(uint32_t, FNV1A_32_TEST_VECTORS[2].hash, result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_HASH_09_002: [If `text` is NULL, hash_fnv1a shall return the hash of an empty string]
+TEST_FUNCTION(hash_fnv1a_NULL_text)
+{
+	// act
+	uint32_t result = hash_fnv1a(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(uint32_t, FNV1A_32_TEST_VECTORS[0].hash, result);
+}
+
+END_TEST_SUITE(iothub_client_hash_ut)
@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#include "iothub_client_md5.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+typedef struct TEST_VECTOR_TAG
+{
+	const char* data;
+	const char* digest;
+} TEST_VECTOR;
+
+// The test suite of RFC 1321 (appendix A.5).
+static const TEST_VECTOR RFC_1321_TEST_VECTORS[] =
+{
+	{ "", "d41d8cd98f00b204e9800998ecf8427e" },
+	{ "a", "0cc175b9c0f1b6a831c399e269772661" },
+	{ "abc", "900150983cd24fb0d6963f7d28e17f72" },
+	{ "message digest", "f96b697d7cb7938d525a2f31aaf161d0" },
+	{ "abcdefghijklmnopqrstuvwxyz", "c3fcd3d76192e4007dfb496cca67e13b" },
+	{ "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "d174ab98d277d9f5a5611c2c9f419d9f" },
+	{ "12345678901234567890123456789012345678901234567890123456789012345678901234567890", "57edf4a22be3c955ac49da2e2107b67a" }
+};
+
+
+// Helpers
+
+static void digest_to_hex(const unsigned char* digest, char* hex)
+{
+	size_t i;
+
+	for (i = 0; i < IOTHUB_CLIENT_MD5_SIZE; i++)
+	{
+		(void)sprintf(hex + i * 2, "%02x", digest[i]);
+	}
+}
+
+static void assert_md5_of_repeated_character(size_t size, const char* expected_digest)
+{
+	unsigned char data[128];
+	unsigned char digest[IOTHUB_CLIENT_MD5_SIZE];
+	char hex[IOTHUB_CLIENT_MD5_SIZE * 2 + 1];
+
+	ASSERT_IS_TRUE(size <= sizeof(data));
+	memset(data, 'a', size);
+
+	ASSERT_ARE_EQUAL(int, 0, md5_compute(data, size, digest));
+	digest_to_hex(digest, hex);
+	ASSERT_ARE_EQUAL(char_ptr, expected_digest, hex);
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_md5_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MD5_09_001: [If `digest` is NULL, or `data` is NULL while `size` is not 0, md5_compute shall fail and return a non-zero value]
+TEST_FUNCTION(md5_compute_NULL_digest)
+{
+	// arrange
+	const unsigned char data[] = "abc";
+
+	// act
+	int result = md5_compute(data, 3, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MD5_09_001: [If `digest` is NULL, or `data` is NULL while `size` is not 0, md5_compute shall fail and return a non-zero value]
+TEST_FUNCTION(md5_compute_NULL_data_with_size)
+{
+	// arrange
+	unsigned char digest[IOTHUB_CLIENT_MD5_SIZE];
+
+	// act
+	int result = md5_compute(NULL, 3, digest);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MD5_09_002: [md5_compute shall write the MD5 digest of the `size` bytes of `data`, as defined by RFC 1321, to the 16 bytes of `digest` and return 0]
+TEST_FUNCTION(md5_compute_NULL_data_without_size)
+{
+	// arrange
+	unsigned char digest[IOTHUB_CLIENT_MD5_SIZE];
+	char hex[IOTHUB_CLIENT_MD5_SIZE * 2 + 1];
+
+	// act
+	int result = md5_compute(NULL, 0, digest);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	digest_to_hex(digest, hex);
+	ASSERT_ARE_EQUAL(char_ptr, RFC_1321_TEST_VECTORS[0].digest, hex);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MD5_09_002: [md5_compute shall write the MD5 digest of the `size` bytes of `data`, as defined by RFC 1321, to the 16 bytes of `digest` and return 0]
+TEST_FUNCTION(md5_compute_RFC_1321_test_suite)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(RFC_1321_TEST_VECTORS) / sizeof(RFC_1321_TEST_VECTORS[0]); i++)
+	{
+		// arrange
+		unsigned char digest[IOTHUB_CLIENT_MD5_SIZE];
+		char hex[IOTHUB_CLIENT_MD5_SIZE * 2 + 1];
+
+		// act
+		int result = md5_compute((const unsigned char*)RFC_1321_TEST_VECTORS[i].data, strlen(RFC_1321_TEST_VECTORS[i].data), digest);
+
+		// assert
+		ASSERT_ARE_EQUAL(int, 0, result);
+		digest_to_hex(digest, hex);
+		ASSERT_ARE_EQUAL(char_ptr, RFC_1321_TEST_VECTORS[i].digest, hex);
+	}
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MD5_09_002: [md5_compute shall write the MD5 digest of the `size` bytes of `data`, as defined by RFC 1321, to the 16 bytes of `digest` and return 0]
+TEST_FUNCTION(md5_compute_pads_across_a_block_boundary)
+{
+	// 55 bytes leave room for the padding in the last block, 56 and 64 do not.
+	assert_md5_of_repeated_character(55, "ef1772b6dff9a122358552954ad0df65");
+	assert_md5_of_repeated_character(56, "3b0c8ac703f828b04c6c197006d17218");
+	assert_md5_of_repeated_character(64, "014842d480b571495a4a0363793f7367");
+}
+
+END_TEST_SUITE(iothub_client_md5_ut)
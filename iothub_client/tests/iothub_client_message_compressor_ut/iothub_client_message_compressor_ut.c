@@ -0,0 +1,695 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#include <zlib.h>
+
+void* real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void* real_realloc(void* ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+void real_free(void* ptr)
+{
+	free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/map.h"
+#include "iothub_message.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_message_compressor.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_MESSAGE_HANDLE                 (IOTHUB_MESSAGE_HANDLE)0x4441
+#define TEST_COMPRESSED_MESSAGE_HANDLE      (IOTHUB_MESSAGE_HANDLE)0x4442
+#define TEST_PROPERTIES                     (MAP_HANDLE)0x4443
+#define TEST_COMPRESSED_PROPERTIES          (MAP_HANDLE)0x4444
+#define TEST_MESSAGE_ID                     "message-id"
+#define TEST_CONTENT_TYPE                   "application/json"
+#define TEST_PAYLOAD_SIZE                   2048
+#define TEST_MIN_PAYLOAD_SIZE               128
+#define TEST_GZIP_WINDOW_BITS               (15 + 16)
+#define TEST_ZLIB_WINDOW_BITS               15
+
+static const char* const TEST_PROPERTY_KEYS[] = { "sensor" };
+static const char* const TEST_PROPERTY_VALUES[] = { "thermostat" };
+static const unsigned char TEST_DICTIONARY[] = "{\"deviceId\":\"\",\"temperature\":,\"humidity\":}";
+
+// Payload of TEST_MESSAGE_HANDLE.
+static unsigned char g_payload[TEST_PAYLOAD_SIZE];
+static size_t g_payload_size;
+
+// Payload given to IoTHubMessage_CreateFromByteArray.
+static unsigned char g_compressed_payload[TEST_PAYLOAD_SIZE * 2];
+static size_t g_compressed_payload_size;
+
+
+// Helpers
+
+static IOTHUB_MESSAGE_RESULT test_IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
+{
+	(void)iotHubMessageHandle;
+	*buffer = g_payload;
+	*size = g_payload_size;
+	return IOTHUB_MESSAGE_OK;
+}
+
+static IOTHUB_MESSAGE_HANDLE test_IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
+{
+	ASSERT_IS_TRUE(size <= sizeof(g_compressed_payload));
+	(void)memcpy(g_compressed_payload, byteArray, size);
+	g_compressed_payload_size = size;
+	return TEST_COMPRESSED_MESSAGE_HANDLE;
+}
+
+static MAP_HANDLE test_IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+	return (iotHubMessageHandle == TEST_MESSAGE_HANDLE) ? TEST_PROPERTIES : TEST_COMPRESSED_PROPERTIES;
+}
+
+static MAP_RESULT test_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count)
+{
+	(void)handle;
+	*keys = TEST_PROPERTY_KEYS;
+	*values = TEST_PROPERTY_VALUES;
+	*count = 1;
+	return MAP_OK;
+}
+
+static void register_global_mock_hooks()
+{
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(realloc, real_realloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+	REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetByteArray, test_IoTHubMessage_GetByteArray);
+	REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromByteArray, test_IoTHubMessage_CreateFromByteArray);
+	REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_Properties, test_IoTHubMessage_Properties);
+	REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, test_Map_GetInternals);
+}
+
+static void register_global_mock_returns()
+{
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(realloc, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetContentType, IOTHUBMESSAGE_BYTEARRAY);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetContentEncodingSystemProperty, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetMessageId, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetCorrelationId, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetContentTypeSystemProperty, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_SetMessageId, IOTHUB_MESSAGE_OK);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_SetContentTypeSystemProperty, IOTHUB_MESSAGE_OK);
+	REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_SetContentEncodingSystemProperty, IOTHUB_MESSAGE_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_SetContentEncodingSystemProperty, IOTHUB_MESSAGE_ERROR);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_CreateFromByteArray, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(Map_AddOrUpdate, MAP_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_AddOrUpdate, MAP_ERROR);
+}
+
+// Telemetry-like JSON, which deflate shrinks several times.
+static void set_compressible_payload()
+{
+	size_t i = 0;
+
+	g_payload_size = 0;
+	while (g_payload_size < TEST_PAYLOAD_SIZE - 64)
+	{
+		g_payload_size += (size_t)sprintf((char*)g_payload + g_payload_size, "{\"deviceId\":\"dev%d\",\"temperature\":%d,\"humidity\":%d}", (int)(i % 3), (int)(20 + i % 7), (int)(40 + i % 11));
+		i++;
+	}
+}
+
+// Pseudo-random bytes, which deflate cannot shrink.
+static void set_incompressible_payload()
+{
+	uint32_t state = 12345;
+	size_t i;
+
+	for (i = 0; i < TEST_PAYLOAD_SIZE; i++)
+	{
+		state = state * 1103515245 + 12345;
+		g_payload[i] = (unsigned char)(state >> 16);
+	}
+	g_payload_size = TEST_PAYLOAD_SIZE;
+}
+
+static MESSAGE_COMPRESSOR_HANDLE create_compressor(const char* content_encoding, const unsigned char* dictionary, size_t dictionary_size)
+{
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options;
+	MESSAGE_COMPRESSOR_HANDLE compressor;
+
+	options.content_encoding = content_encoding;
+	options.min_payload_size = TEST_MIN_PAYLOAD_SIZE;
+	options.level = 0;
+	options.dictionary = dictionary;
+	options.dictionary_size = dictionary_size;
+
+	compressor = message_compressor_create(&options);
+	ASSERT_IS_NOT_NULL(compressor);
+	umock_c_reset_all_calls();
+
+	return compressor;
+}
+
+// Inflates g_compressed_payload and checks that it gives back g_payload.
+static void assert_compressed_payload_inflates_to_payload(int window_bits, const unsigned char* dictionary, size_t dictionary_size)
+{
+	unsigned char inflated[TEST_PAYLOAD_SIZE];
+	z_stream stream;
+	int result;
+
+	memset(&stream, 0, sizeof(stream));
+	ASSERT_ARE_EQUAL(int, Z_OK, inflateInit2(&stream, window_bits));
+	stream.next_in = g_compressed_payload;
+	stream.avail_in = (uInt)g_compressed_payload_size;
+	stream.next_out = inflated;
+	stream.avail_out = (uInt)sizeof(inflated);
+
+	result = inflate(&stream, Z_FINISH);
+	if (result == Z_NEED_DICT)
+	{
+		ASSERT_IS_NOT_NULL(dictionary);
+		ASSERT_ARE_EQUAL(int, Z_OK, inflateSetDictionary(&stream, dictionary, (uInt)dictionary_size));
+		result = inflate(&stream, Z_FINISH);
+	}
+
+	ASSERT_ARE_EQUAL(int, Z_STREAM_END, result);
+	ASSERT_ARE_EQUAL(size_t, g_payload_size, (size_t)stream.total_out);
+	ASSERT_ARE_EQUAL(int, 0, memcmp(inflated, g_payload, g_payload_size));
+	(void)inflateEnd(&stream);
+}
+
+static void set_expected_calls_for_compress(const char* content_encoding, bool grows_output_buffer)
+{
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+	if (grows_output_buffer)
+	{
+		STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+	}
+	STRICT_EXPECTED_CALL(IoTHubMessage_CreateFromByteArray(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageId(TEST_MESSAGE_HANDLE))
+		.SetReturn(TEST_MESSAGE_ID);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetCorrelationId(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentTypeSystemProperty(TEST_MESSAGE_HANDLE))
+		.SetReturn(TEST_CONTENT_TYPE);
+	STRICT_EXPECTED_CALL(IoTHubMessage_SetMessageId(TEST_COMPRESSED_MESSAGE_HANDLE, TEST_MESSAGE_ID));
+	STRICT_EXPECTED_CALL(IoTHubMessage_SetContentTypeSystemProperty(TEST_COMPRESSED_MESSAGE_HANDLE, TEST_CONTENT_TYPE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_SetContentEncodingSystemProperty(TEST_COMPRESSED_MESSAGE_HANDLE, content_encoding));
+	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_COMPRESSED_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(Map_GetInternals(TEST_PROPERTIES, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_COMPRESSED_PROPERTIES, TEST_PROPERTY_KEYS[0], TEST_PROPERTY_VALUES[0]));
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_message_compressor_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_stdint_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_bool_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+	REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
+	REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
+
+	register_global_mock_returns();
+	register_global_mock_hooks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	set_compressible_payload();
+	g_compressed_payload_size = 0;
+	umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_001: [If `options` or its `content_encoding` are NULL, message_compressor_create shall fail and return NULL]
+TEST_FUNCTION(create_NULL_options)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(NULL);
+
+	// assert
+	ASSERT_IS_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_002: [If `content_encoding` is neither "gzip" nor "deflate", message_compressor_create shall fail and return NULL]
+TEST_FUNCTION(create_unsupported_content_encoding)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "br", 0, 0, NULL, 0 };
+	umock_c_reset_all_calls();
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+	// assert
+	ASSERT_IS_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_003: [If `level` is not between 0 and 9, message_compressor_create shall fail and return NULL]
+TEST_FUNCTION(create_level_out_of_range)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 0, 10, NULL, 0 };
+	umock_c_reset_all_calls();
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+	// assert
+	ASSERT_IS_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_004: [If a dictionary is given with "gzip", or `dictionary` is NULL while `dictionary_size` is not 0, message_compressor_create shall fail and return NULL]
+TEST_FUNCTION(create_gzip_with_dictionary)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 0, 0, TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1 };
+	umock_c_reset_all_calls();
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+	// assert
+	ASSERT_IS_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_004: [If a dictionary is given with "gzip", or `dictionary` is NULL while `dictionary_size` is not 0, message_compressor_create shall fail and return NULL]
+TEST_FUNCTION(create_NULL_dictionary_with_size)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "deflate", 0, 0, NULL, 16 };
+	umock_c_reset_all_calls();
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+	// assert
+	ASSERT_IS_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_005: [message_compressor_create shall allocate the compressor using malloc(), and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_007: [message_compressor_create shall initialize the deflate stream using deflateInit2 with `level` (Z_DEFAULT_COMPRESSION for 0) and a gzip or zlib wrapper according to `content_encoding`, and return NULL if it fails]
+TEST_FUNCTION(create_succeeds)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", TEST_MIN_PAYLOAD_SIZE, 6, NULL, 0 };
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+	// assert
+	ASSERT_IS_NOT_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_006: [message_compressor_create shall copy the dictionary using malloc(), and return NULL if it fails]
+TEST_FUNCTION(create_copies_the_dictionary)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "deflate", TEST_MIN_PAYLOAD_SIZE, 0, TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1 };
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(malloc(sizeof(TEST_DICTIONARY) - 1));
+
+	// act
+	MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+	// assert
+	ASSERT_IS_NOT_NULL(compressor);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_005: [message_compressor_create shall allocate the compressor using malloc(), and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_006: [message_compressor_create shall copy the dictionary using malloc(), and return NULL if it fails]
+TEST_FUNCTION(create_negative_tests)
+{
+	// arrange
+	IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "deflate", TEST_MIN_PAYLOAD_SIZE, 0, TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1 };
+	size_t i;
+
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(malloc(sizeof(TEST_DICTIONARY) - 1));
+	umock_c_negative_tests_snapshot();
+
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		// arrange
+		char error_msg[64];
+
+		umock_c_negative_tests_reset();
+		umock_c_negative_tests_fail_call(i);
+
+		// act
+		MESSAGE_COMPRESSOR_HANDLE compressor = message_compressor_create(&options);
+
+		// assert
+		(void)sprintf(error_msg, "On failed call %lu", (unsigned long)i);
+		ASSERT_IS_NULL_WITH_MSG(compressor, error_msg);
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_008: [If `compressor` is NULL, message_compressor_destroy shall return]
+TEST_FUNCTION(destroy_NULL_compressor)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	message_compressor_destroy(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_009: [message_compressor_destroy shall release the deflate stream using deflateEnd, and free the dictionary, the output buffer and the compressor]
+TEST_FUNCTION(destroy_frees_the_dictionary_the_output_buffer_and_the_compressor)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("deflate", TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+	ASSERT_IS_NOT_NULL(message);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(free(compressor));
+
+	// act
+	message_compressor_destroy(compressor);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_010: [If `compressor` or `message` are NULL, message_compressor_compress shall fail and return NULL]
+TEST_FUNCTION(compress_NULL_compressor)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(NULL, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_IS_NULL(message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_010: [If `compressor` or `message` are NULL, message_compressor_compress shall fail and return NULL]
+TEST_FUNCTION(compress_NULL_message)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("gzip", NULL, 0);
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, NULL);
+
+	// assert
+	ASSERT_IS_NULL(message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_011: [If `message` has a content encoding, message_compressor_compress shall return NULL]
+TEST_FUNCTION(compress_leaves_an_encoded_message_as_it_is)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("gzip", NULL, 0);
+
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE))
+		.SetReturn("utf-8");
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_IS_NULL(message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_012: [If the payload of `message` is smaller than `min_payload_size`, message_compressor_compress shall return NULL]
+TEST_FUNCTION(compress_leaves_a_small_message_as_it_is)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("gzip", NULL, 0);
+	g_payload_size = TEST_MIN_PAYLOAD_SIZE - 1;
+
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_IS_NULL(message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_013: [message_compressor_compress shall grow its output buffer to the size returned by deflateBound using realloc, and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_014: [message_compressor_compress shall compress the payload in one call to deflate with Z_FINISH, after deflateReset and, if a dictionary was given, deflateSetDictionary, and return NULL if any of them fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_016: [message_compressor_compress shall create the new message using IoTHubMessage_CreateFromByteArray with the compressed payload, and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_017: [message_compressor_compress shall copy the message id, correlation id, content type and application properties of `message` to the new message, and set its content encoding]
+TEST_FUNCTION(compress_gzip_succeeds)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("gzip", NULL, 0);
+
+	set_expected_calls_for_compress("gzip", true);
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_ARE_EQUAL(void_ptr, TEST_COMPRESSED_MESSAGE_HANDLE, message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_IS_TRUE(g_compressed_payload_size < g_payload_size / 4);
+	assert_compressed_payload_inflates_to_payload(TEST_GZIP_WINDOW_BITS, NULL, 0);
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_014: [message_compressor_compress shall compress the payload in one call to deflate with Z_FINISH, after deflateReset and, if a dictionary was given, deflateSetDictionary, and return NULL if any of them fails]
+TEST_FUNCTION(compress_deflate_with_dictionary_succeeds)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("deflate", TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+
+	set_expected_calls_for_compress("deflate", true);
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_ARE_EQUAL(void_ptr, TEST_COMPRESSED_MESSAGE_HANDLE, message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	assert_compressed_payload_inflates_to_payload(TEST_ZLIB_WINDOW_BITS, TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_013: [message_compressor_compress shall grow its output buffer to the size returned by deflateBound using realloc, and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_014: [message_compressor_compress shall compress the payload in one call to deflate with Z_FINISH, after deflateReset and, if a dictionary was given, deflateSetDictionary, and return NULL if any of them fails]
+TEST_FUNCTION(compress_reuses_the_output_buffer_and_the_deflate_stream)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("deflate", TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+	ASSERT_IS_NOT_NULL(message_compressor_compress(compressor, TEST_MESSAGE_HANDLE));
+	umock_c_reset_all_calls();
+
+	// no realloc: the buffer of the first message is large enough
+	set_expected_calls_for_compress("deflate", false);
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_ARE_EQUAL(void_ptr, TEST_COMPRESSED_MESSAGE_HANDLE, message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	assert_compressed_payload_inflates_to_payload(TEST_ZLIB_WINDOW_BITS, TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_015: [If the compressed payload is not smaller than the payload, message_compressor_compress shall return NULL]
+TEST_FUNCTION(compress_leaves_an_incompressible_message_as_it_is)
+{
+	// arrange
+	MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("gzip", NULL, 0);
+	set_incompressible_payload();
+
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+	// act
+	IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+	// assert
+	ASSERT_IS_NULL(message);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	message_compressor_destroy(compressor);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_013: [message_compressor_compress shall grow its output buffer to the size returned by deflateBound using realloc, and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_016: [message_compressor_compress shall create the new message using IoTHubMessage_CreateFromByteArray with the compressed payload, and return NULL if it fails]
+// Tests_SRS_IOTHUB_CLIENT_MESSAGE_COMPRESSOR_09_018: [If copying the properties fails, message_compressor_compress shall destroy the new message and return NULL]
+TEST_FUNCTION(compress_negative_tests)
+{
+	// arrange
+	size_t i;
+
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+	set_expected_calls_for_compress("gzip", true);
+	umock_c_negative_tests_snapshot();
+
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		// arrange
+		char error_msg[64];
+		bool is_fallible = (i == 3 || i == 4 || i == 10 || i == 14);
+
+		if (!is_fallible)
+		{
+			continue;
+		}
+
+		// a new compressor each time, so that its output buffer always has to grow
+		MESSAGE_COMPRESSOR_HANDLE compressor = create_compressor("gzip", NULL, 0);
+
+		umock_c_negative_tests_reset();
+		umock_c_negative_tests_fail_call(i);
+
+		// act
+		IOTHUB_MESSAGE_HANDLE message = message_compressor_compress(compressor, TEST_MESSAGE_HANDLE);
+
+		// assert
+		(void)sprintf(error_msg, "On failed call %lu", (unsigned long)i);
+		ASSERT_IS_NULL_WITH_MSG(message, error_msg);
+
+		// cleanup
+		message_compressor_destroy(compressor);
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+}
+
+END_TEST_SUITE(iothub_client_message_compressor_ut)
@@ -6,12 +6,14 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #endif
 
 void* real_malloc(size_t size)
@@ -37,6 +39,7 @@ void real_free(void* ptr)
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "iothub_client_ll.h"
 #undef ENABLE_MOCKS
@@ -60,6 +63,12 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 
 #define INDEFINITE_TIME                     ((time_t)-1)
 #define TEST_OPTIONHANDLER_HANDLE           (OPTIONHANDLER_HANDLE)0x7771
+#define TEST_LOCK_HANDLE                    (LOCK_HANDLE)0x7772
+
+#define TEST_SIMULATED_CLIENT_COUNT         1000
+#define TEST_SIMULATED_DO_WORK_PER_SEC      4
+#define TEST_SIMULATED_DURATION_IN_SECS     120
+#define TEST_DECORRELATED_JITTER_MAX_WAIT   60
 
 
 static time_t TEST_current_time;
@@ -67,7 +76,7 @@ static time_t TEST_current_time;
 
 // Helpers
 static int saved_malloc_returns_count = 0;
-static void* saved_malloc_returns[20];
+static void* saved_malloc_returns[TEST_SIMULATED_CLIENT_COUNT + 20];
 
 static void* TEST_malloc(size_t size)
 {
@@ -102,6 +111,18 @@ static OPTIONHANDLER_RESULT TEST_OptionHandler_AddOption(OPTIONHANDLER_HANDLE ha
 	return TEST_OptionHandler_AddOption_result;
 }
 
+static time_t TEST_simulated_time;
+static time_t TEST_get_time(time_t* p)
+{
+	(void)p;
+	return TEST_simulated_time;
+}
+
+static double TEST_get_difftime(time_t stopTime, time_t startTime)
+{
+	return difftime(stopTime, startTime);
+}
+
 static time_t add_seconds(time_t base_time, int seconds)
 {
 	time_t new_time;
@@ -212,6 +233,8 @@ static void register_umock_alias_types()
 {
 	REGISTER_UMOCK_ALIAS_TYPE(time_t, long long);
 	REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
 	REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_RESULT, int);
 	REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
@@ -235,6 +258,17 @@ static void register_global_mock_returns()
 
 	REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_OK);
 	REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_ERROR);
+
+	REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+
+	REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+
+	REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(Unlock, LOCK_ERROR);
+
+	REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
 }
 
 
@@ -293,6 +327,9 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
 {
+	// The reconnect admission control is process-wide; make sure no test leaks it into the next.
+	(void)retry_control_set_reconnect_admission_rate(0, 0);
+
     TEST_MUTEX_RELEASE(g_testByTest);
 }
 
@@ -1158,4 +1195,310 @@ TEST_FUNCTION(Reset_success)
 	retry_control_destroy(handle);
 }
 
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_069: [If `burst_size` is 0, `retry_control_set_reconnect_admission_rate` shall fail and return non-zero]
+TEST_FUNCTION(Set_Reconnect_Admission_Rate_ZERO_burst_size)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	int result = retry_control_set_reconnect_admission_rate(10, 0);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_071: [If `Lock_Init` fails, `retry_control_set_reconnect_admission_rate` shall fail and return non-zero]
+TEST_FUNCTION(Set_Reconnect_Admission_Rate_Lock_Init_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(Lock_Init()).SetReturn(NULL);
+
+	// act
+	int result = retry_control_set_reconnect_admission_rate(10, 20);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_068: [If `reconnects_per_sec` is 0, the reconnect admission control shall be disabled, its lock destroyed using `Lock_Deinit`, and `retry_control_set_reconnect_admission_rate` shall return 0]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_070: [If the reconnect admission control is not enabled, its lock shall be created using `Lock_Init`]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_072: [`reconnects_per_sec` and `burst_size` shall be saved, and the available tokens set to `burst_size`]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_073: [If no errors occur, `retry_control_set_reconnect_admission_rate` shall return 0]
+TEST_FUNCTION(Set_Reconnect_Admission_Rate_success)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(Lock_Init());
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+	// act
+	int result1 = retry_control_set_reconnect_admission_rate(10, 20);
+	int result2 = retry_control_set_reconnect_admission_rate(5, 5);
+	int result3 = retry_control_set_reconnect_admission_rate(0, 0);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result1);
+	ASSERT_ARE_EQUAL(int, 0, result2);
+	ASSERT_ARE_EQUAL(int, 0, result3);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_067: [If `retry_action` is set to RETRY_ACTION_RETRY_NOW and the reconnect admission control denies the reconnection, `retry_action` shall be set to RETRY_ACTION_RETRY_LATER and `retry_control` shall not be updated]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_075: [The admission state shall be accessed under `Lock`; if `Lock` fails the reconnection shall be admitted]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_076: [`current_time` shall be obtained using get_time()]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_079: [If a token is available it shall be consumed and the reconnection admitted, otherwise the reconnection shall be denied]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_080: [The admission state shall be released using `Unlock`]
+TEST_FUNCTION(Should_Retry_reconnect_admission_denied)
+{
+	// arrange
+	RETRY_CONTROL_HANDLE handle1 = create_retry_control(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0);
+	RETRY_CONTROL_HANDLE handle2 = create_retry_control(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0);
+	ASSERT_ARE_EQUAL(int, 0, retry_control_set_reconnect_admission_rate(1, 1));
+
+	RETRY_ACTION retry_action1;
+	RETRY_ACTION retry_action2;
+	RETRY_ACTION retry_action3;
+
+	umock_c_reset_all_calls();
+	// handle1 consumes the only token.
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	// handle2 is denied within the same second.
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	// handle2 still has retry_count 0, so it asks for admission again right away.
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+	// act
+	int result1 = retry_control_should_retry(handle1, &retry_action1);
+	int result2 = retry_control_should_retry(handle2, &retry_action2);
+	int result3 = retry_control_should_retry(handle2, &retry_action3);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result1);
+	ASSERT_ARE_EQUAL(int, 0, result2);
+	ASSERT_ARE_EQUAL(int, 0, result3);
+	ASSERT_ARE_EQUAL(int, RETRY_ACTION_RETRY_NOW, retry_action1);
+	ASSERT_ARE_EQUAL(int, RETRY_ACTION_RETRY_LATER, retry_action2);
+	ASSERT_ARE_EQUAL(int, RETRY_ACTION_RETRY_LATER, retry_action3);
+
+	// cleanup
+	retry_control_destroy(handle1);
+	retry_control_destroy(handle2);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_077: [If get_time() fails, the reconnection shall be admitted]
+TEST_FUNCTION(Should_Retry_reconnect_admission_get_time_fails)
+{
+	// arrange
+	RETRY_CONTROL_HANDLE handle = create_retry_control(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0);
+	ASSERT_ARE_EQUAL(int, 0, retry_control_set_reconnect_admission_rate(1, 1));
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+	STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(INDEFINITE_TIME);
+	STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+
+	// act
+	RETRY_ACTION retry_action;
+	int result = retry_control_should_retry(handle, &retry_action);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(int, RETRY_ACTION_RETRY_NOW, retry_action);
+
+	// cleanup
+	retry_control_destroy(handle);
+}
+
+// Deterministic simulation: 1000 clients lose connectivity at the same instant and call
+// _should_retry from their DoWork loops. The admission control must spread the reconnections
+// so that no more than `burst_size` start in the first second and no more than `reconnects_per_sec`
+// start in any later second.
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_074: [If the reconnect admission control is disabled, the reconnection shall be admitted]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_078: [For every full second elapsed since the last refill, `reconnects_per_sec` tokens shall be added, up to `burst_size`]
+TEST_FUNCTION(Should_Retry_reconnect_admission_spreads_1000_clients)
+{
+	// arrange
+	const unsigned int reconnects_per_sec = 25;
+	const unsigned int burst_size = 50;
+	RETRY_CONTROL_HANDLE handles[TEST_SIMULATED_CLIENT_COUNT];
+	bool is_connected[TEST_SIMULATED_CLIENT_COUNT];
+	unsigned int reconnections_per_sec[TEST_SIMULATED_DURATION_IN_SECS];
+	unsigned int connected_count = 0;
+	int last_reconnection_sec = -1;
+	int i, sec, tick;
+
+	for (i = 0; i < TEST_SIMULATED_CLIENT_COUNT; i++)
+	{
+		handles[i] = create_retry_control(IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0);
+		ASSERT_IS_NOT_NULL(handles[i]);
+		is_connected[i] = false;
+	}
+	memset(reconnections_per_sec, 0, sizeof(reconnections_per_sec));
+
+	ASSERT_ARE_EQUAL(int, 0, retry_control_set_reconnect_admission_rate(reconnects_per_sec, burst_size));
+
+	REGISTER_GLOBAL_MOCK_HOOK(get_time, TEST_get_time);
+	REGISTER_GLOBAL_MOCK_HOOK(get_difftime, TEST_get_difftime);
+	TEST_simulated_time = TEST_current_time;
+
+	// act
+	for (sec = 0; sec < TEST_SIMULATED_DURATION_IN_SECS && connected_count < TEST_SIMULATED_CLIENT_COUNT; sec++)
+	{
+		for (tick = 0; tick < TEST_SIMULATED_DO_WORK_PER_SEC; tick++)
+		{
+			umock_c_reset_all_calls();
+
+			for (i = 0; i < TEST_SIMULATED_CLIENT_COUNT; i++)
+			{
+				if (!is_connected[i])
+				{
+					RETRY_ACTION retry_action;
+					ASSERT_ARE_EQUAL(int, 0, retry_control_should_retry(handles[i], &retry_action));
+
+					if (retry_action == RETRY_ACTION_RETRY_NOW)
+					{
+						is_connected[i] = true;
+						connected_count++;
+						reconnections_per_sec[sec]++;
+						last_reconnection_sec = sec;
+					}
+				}
+			}
+		}
+
+		TEST_simulated_time = add_seconds(TEST_simulated_time, 1);
+	}
+
+	// assert
+	ASSERT_ARE_EQUAL(int, TEST_SIMULATED_CLIENT_COUNT, connected_count);
+	ASSERT_ARE_EQUAL(int, burst_size, reconnections_per_sec[0]);
+
+	for (sec = 1; sec <= last_reconnection_sec; sec++)
+	{
+		ASSERT_IS_TRUE(reconnections_per_sec[sec] <= reconnects_per_sec);
+	}
+
+	ASSERT_ARE_EQUAL(int, (TEST_SIMULATED_CLIENT_COUNT - burst_size) / reconnects_per_sec, last_reconnection_sec);
+
+	// cleanup
+	REGISTER_GLOBAL_MOCK_HOOK(get_time, NULL);
+	REGISTER_GLOBAL_MOCK_HOOK(get_difftime, NULL);
+
+	for (i = 0; i < TEST_SIMULATED_CLIENT_COUNT; i++)
+	{
+		retry_control_destroy(handles[i]);
+	}
+}
+
+// Deterministic simulation (fixed seed): 1000 clients keep failing to reconnect. With decorrelated
+// jitter every wait must stay within [initial, min(cap, 3 * previous wait)], and once the first few
+// retries have passed the clients must no longer retry in lockstep.
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_064: [If `policy` is IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER, `retry_control->initial_wait_time_in_secs` shall be set to 1]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_065: [If `retry_control->policy` is IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER, `calculate_next_wait_time` shall return a random value between `retry_control->initial_wait_time_in_secs` and 3 times the previous wait time (or `initial_wait_time_in_secs` if there is none)]
+// Tests_SRS_IOTHUB_CLIENT_RETRY_CONTROL_09_066: [The IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER wait time shall not exceed DECORRELATED_JITTER_MAX_WAIT_TIME_IN_SECS (60 seconds)]
+TEST_FUNCTION(Should_Retry_DECORRELATED_JITTER_spreads_1000_clients)
+{
+	// arrange
+	RETRY_CONTROL_HANDLE handles[TEST_SIMULATED_CLIENT_COUNT];
+	int last_retry_sec[TEST_SIMULATED_CLIENT_COUNT];
+	int last_wait_in_secs[TEST_SIMULATED_CLIENT_COUNT];
+	unsigned int retries_per_sec[TEST_SIMULATED_DURATION_IN_SECS];
+	unsigned int total_retries = 0;
+	unsigned int peak_retries_after_warm_up = 0;
+	int i, sec;
+
+	srand(12345);
+
+	for (i = 0; i < TEST_SIMULATED_CLIENT_COUNT; i++)
+	{
+		handles[i] = create_retry_control(IOTHUB_CLIENT_RETRY_DECORRELATED_JITTER, 0);
+		ASSERT_IS_NOT_NULL(handles[i]);
+		last_retry_sec[i] = -1;
+		last_wait_in_secs[i] = 0;
+	}
+	memset(retries_per_sec, 0, sizeof(retries_per_sec));
+
+	REGISTER_GLOBAL_MOCK_HOOK(get_time, TEST_get_time);
+	REGISTER_GLOBAL_MOCK_HOOK(get_difftime, TEST_get_difftime);
+	TEST_simulated_time = TEST_current_time;
+
+	// act
+	for (sec = 0; sec < TEST_SIMULATED_DURATION_IN_SECS; sec++)
+	{
+		umock_c_reset_all_calls();
+
+		for (i = 0; i < TEST_SIMULATED_CLIENT_COUNT; i++)
+		{
+			RETRY_ACTION retry_action;
+			ASSERT_ARE_EQUAL(int, 0, retry_control_should_retry(handles[i], &retry_action));
+			ASSERT_ARE_NOT_EQUAL(int, RETRY_ACTION_STOP_RETRYING, retry_action);
+
+			if (retry_action == RETRY_ACTION_RETRY_NOW)
+			{
+				if (last_retry_sec[i] >= 0)
+				{
+					int wait_in_secs = sec - last_retry_sec[i];
+					int max_wait_in_secs = 3 * (last_wait_in_secs[i] > 1 ? last_wait_in_secs[i] : 1);
+
+					// assert
+					ASSERT_IS_TRUE(wait_in_secs >= 1);
+					ASSERT_IS_TRUE(wait_in_secs <= max_wait_in_secs);
+					ASSERT_IS_TRUE(wait_in_secs <= TEST_DECORRELATED_JITTER_MAX_WAIT);
+
+					last_wait_in_secs[i] = wait_in_secs;
+				}
+
+				last_retry_sec[i] = sec;
+				retries_per_sec[sec]++;
+				total_retries++;
+			}
+		}
+
+		TEST_simulated_time = add_seconds(TEST_simulated_time, 1);
+	}
+
+	for (sec = 10; sec < TEST_SIMULATED_DURATION_IN_SECS; sec++)
+	{
+		if (retries_per_sec[sec] > peak_retries_after_warm_up)
+		{
+			peak_retries_after_warm_up = retries_per_sec[sec];
+		}
+	}
+
+	// assert
+	ASSERT_ARE_EQUAL(int, TEST_SIMULATED_CLIENT_COUNT, retries_per_sec[0]);
+	ASSERT_IS_TRUE(total_retries > TEST_SIMULATED_CLIENT_COUNT);
+	ASSERT_IS_TRUE(peak_retries_after_warm_up <= TEST_SIMULATED_CLIENT_COUNT / 4);
+
+	// cleanup
+	REGISTER_GLOBAL_MOCK_HOOK(get_time, NULL);
+	REGISTER_GLOBAL_MOCK_HOOK(get_difftime, NULL);
+
+	for (i = 0; i < TEST_SIMULATED_CLIENT_COUNT; i++)
+	{
+		retry_control_destroy(handles[i]);
+	}
+}
+
 END_TEST_SUITE(iothub_client_retry_control_ut)
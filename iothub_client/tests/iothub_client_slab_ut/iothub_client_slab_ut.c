@@ -0,0 +1,545 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+	free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_slab.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_MAX_FREE_ELEMENTS              2
+
+// Stand-in for the per-message structures kept in a slab (e.g. IOTHUB_MESSAGE_LIST).
+typedef struct TEST_ELEMENT_TAG
+{
+	void* message;
+	void* context;
+	size_t retry_count;
+} TEST_ELEMENT;
+
+
+// Helpers
+
+static void register_global_mock_hooks()
+{
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+}
+
+static void register_global_mock_returns()
+{
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+}
+
+static void init_slab(SLAB* slab, size_t max_free_elements)
+{
+	slab_init(slab, sizeof(TEST_ELEMENT), max_free_elements);
+	umock_c_reset_all_calls();
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_slab_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_stdint_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_bool_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	register_global_mock_returns();
+	register_global_mock_hooks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_001: [If `slab` is NULL, slab_init shall return]
+TEST_FUNCTION(init_NULL_slab)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	slab_init(NULL, sizeof(TEST_ELEMENT), TEST_MAX_FREE_ELEMENTS);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_002: [slab_init shall save `element_size`, raised to the size of a pointer if smaller, and `max_free_elements`, with no element kept for reuse and the counters set to 0]
+TEST_FUNCTION(init_success)
+{
+	// arrange
+	SLAB slab;
+	memset(&slab, 0xAA, sizeof(slab));
+	umock_c_reset_all_calls();
+
+	// act
+	slab_init(&slab, sizeof(TEST_ELEMENT), TEST_MAX_FREE_ELEMENTS);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, sizeof(TEST_ELEMENT), slab.element_size);
+	ASSERT_ARE_EQUAL(size_t, TEST_MAX_FREE_ELEMENTS, slab.max_free_elements);
+	ASSERT_ARE_EQUAL(size_t, 0, slab.free_element_count);
+	ASSERT_IS_NULL(slab.free_elements);
+	ASSERT_ARE_EQUAL(size_t, 0, slab.allocation_count);
+	ASSERT_ARE_EQUAL(size_t, 0, slab.reuse_count);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_002: [slab_init shall save `element_size`, raised to the size of a pointer if smaller, and `max_free_elements`, with no element kept for reuse and the counters set to 0]
+TEST_FUNCTION(init_raises_small_element_size)
+{
+	// arrange
+	SLAB slab;
+
+	// act
+	slab_init(&slab, 1, TEST_MAX_FREE_ELEMENTS);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, sizeof(void*), slab.element_size);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_005: [If `slab` is NULL, slab_alloc shall fail and return NULL]
+TEST_FUNCTION(alloc_NULL_slab)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	void* element = slab_alloc(NULL);
+
+	// assert
+	ASSERT_IS_NULL(element);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_007: [Otherwise slab_alloc shall allocate `element_size` bytes using malloc() and return them, counting an allocation]
+TEST_FUNCTION(alloc_without_free_elements_mallocs)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+
+	STRICT_EXPECTED_CALL(malloc(sizeof(TEST_ELEMENT)));
+
+	// act
+	void* element = slab_alloc(&slab);
+
+	// assert
+	ASSERT_IS_NOT_NULL(element);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 1, slab.allocation_count);
+	ASSERT_ARE_EQUAL(size_t, 0, slab.reuse_count);
+
+	// cleanup
+	slab_free(&slab, element);
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_008: [If malloc() fails, slab_alloc shall fail and return NULL]
+TEST_FUNCTION(alloc_malloc_fails)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+
+	STRICT_EXPECTED_CALL(malloc(sizeof(TEST_ELEMENT)))
+		.SetReturn(NULL);
+
+	// act
+	void* element = slab_alloc(&slab);
+
+	// assert
+	ASSERT_IS_NULL(element);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, slab.allocation_count);
+
+	// cleanup
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_006: [If elements are kept for reuse, slab_alloc shall remove the one released last and return it, counting a reuse]
+TEST_FUNCTION(alloc_reuses_the_element_released_last)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+	void* element_1 = slab_alloc(&slab);
+	void* element_2 = slab_alloc(&slab);
+	slab_free(&slab, element_1);
+	slab_free(&slab, element_2);
+	umock_c_reset_all_calls();
+
+	// act
+	void* reused_1 = slab_alloc(&slab);
+	void* reused_2 = slab_alloc(&slab);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(void_ptr, element_2, reused_1);
+	ASSERT_ARE_EQUAL(void_ptr, element_1, reused_2);
+	ASSERT_ARE_EQUAL(size_t, 0, slab.free_element_count);
+	ASSERT_ARE_EQUAL(size_t, 2, slab.allocation_count);
+	ASSERT_ARE_EQUAL(size_t, 2, slab.reuse_count);
+
+	// cleanup
+	slab_free(&slab, reused_1);
+	slab_free(&slab, reused_2);
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_009: [If `slab` or `element` are NULL, slab_free shall return]
+TEST_FUNCTION(free_NULL_slab)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+	void* element = slab_alloc(&slab);
+	umock_c_reset_all_calls();
+
+	// act
+	slab_free(NULL, element);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	slab_free(&slab, element);
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_009: [If `slab` or `element` are NULL, slab_free shall return]
+TEST_FUNCTION(free_NULL_element)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+
+	// act
+	slab_free(&slab, NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, slab.free_element_count);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_010: [If fewer than `max_free_elements` elements are kept for reuse, slab_free shall keep `element`]
+TEST_FUNCTION(free_keeps_element_below_max_free_elements)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+	void* element = slab_alloc(&slab);
+	umock_c_reset_all_calls();
+
+	// act
+	slab_free(&slab, element);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 1, slab.free_element_count);
+
+	// cleanup
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_011: [Otherwise slab_free shall release `element` using free()]
+TEST_FUNCTION(free_releases_element_at_max_free_elements)
+{
+	// arrange
+	SLAB slab;
+	size_t i;
+	void* elements[TEST_MAX_FREE_ELEMENTS + 1];
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+
+	for (i = 0; i < TEST_MAX_FREE_ELEMENTS + 1; i++)
+	{
+		elements[i] = slab_alloc(&slab);
+	}
+
+	for (i = 0; i < TEST_MAX_FREE_ELEMENTS; i++)
+	{
+		slab_free(&slab, elements[i]);
+	}
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(free(elements[TEST_MAX_FREE_ELEMENTS]));
+
+	// act
+	slab_free(&slab, elements[TEST_MAX_FREE_ELEMENTS]);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, TEST_MAX_FREE_ELEMENTS, slab.free_element_count);
+
+	// cleanup
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_007: [Otherwise slab_alloc shall allocate `element_size` bytes using malloc() and return them, counting an allocation]
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_011: [Otherwise slab_free shall release `element` using free()]
+TEST_FUNCTION(zero_max_free_elements_is_malloc_and_free)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, 0);
+
+	STRICT_EXPECTED_CALL(malloc(sizeof(TEST_ELEMENT)));
+	EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(malloc(sizeof(TEST_ELEMENT)));
+	EXPECTED_CALL(free(IGNORED_PTR_ARG));
+
+	// act
+	slab_free(&slab, slab_alloc(&slab));
+	slab_free(&slab, slab_alloc(&slab));
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 2, slab.allocation_count);
+	ASSERT_ARE_EQUAL(size_t, 0, slab.reuse_count);
+
+	// cleanup
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_012: [If `slab` is NULL, slab_set_max_free_elements shall return]
+TEST_FUNCTION(set_max_free_elements_NULL_slab)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	slab_set_max_free_elements(NULL, TEST_MAX_FREE_ELEMENTS);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_013: [slab_set_max_free_elements shall save `max_free_elements` and free the elements kept for reuse beyond it]
+TEST_FUNCTION(set_max_free_elements_frees_the_excess)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+	void* element_1 = slab_alloc(&slab);
+	void* element_2 = slab_alloc(&slab);
+	slab_free(&slab, element_1);
+	slab_free(&slab, element_2);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(free(element_2));
+
+	// act
+	slab_set_max_free_elements(&slab, 1);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 1, slab.max_free_elements);
+	ASSERT_ARE_EQUAL(size_t, 1, slab.free_element_count);
+
+	// cleanup
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_013: [slab_set_max_free_elements shall save `max_free_elements` and free the elements kept for reuse beyond it]
+TEST_FUNCTION(set_max_free_elements_enables_reuse)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, 0);
+	void* element = slab_alloc(&slab);
+	umock_c_reset_all_calls();
+
+	// act
+	slab_set_max_free_elements(&slab, TEST_MAX_FREE_ELEMENTS);
+	slab_free(&slab, element);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(void_ptr, element, slab_alloc(&slab));
+
+	// cleanup
+	slab_free(&slab, element);
+	slab_deinit(&slab);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_003: [If `slab` is NULL, slab_deinit shall return]
+TEST_FUNCTION(deinit_NULL_slab)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	slab_deinit(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_004: [slab_deinit shall free all the elements kept for reuse]
+TEST_FUNCTION(deinit_frees_the_elements_kept_for_reuse)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+	void* element_1 = slab_alloc(&slab);
+	void* element_2 = slab_alloc(&slab);
+	slab_free(&slab, element_1);
+	slab_free(&slab, element_2);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(free(element_2));
+	STRICT_EXPECTED_CALL(free(element_1));
+
+	// act
+	slab_deinit(&slab);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, slab.free_element_count);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_004: [slab_deinit shall free all the elements kept for reuse]
+TEST_FUNCTION(free_after_deinit_frees_the_element)
+{
+	// arrange
+	SLAB slab;
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+	void* element = slab_alloc(&slab);
+	slab_deinit(&slab);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(free(element));
+
+	// act
+	slab_free(&slab, element);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_006: [If elements are kept for reuse, slab_alloc shall remove the one released last and return it, counting a reuse]
+// Tests_SRS_IOTHUB_CLIENT_SLAB_09_010: [If fewer than `max_free_elements` elements are kept for reuse, slab_free shall keep `element`]
+TEST_FUNCTION(steady_state_sends_do_not_allocate)
+{
+	// arrange
+	SLAB slab;
+	size_t round;
+	size_t i;
+	void* in_flight[TEST_MAX_FREE_ELEMENTS];
+	init_slab(&slab, TEST_MAX_FREE_ELEMENTS);
+
+	// First window: the elements come from malloc.
+	for (i = 0; i < TEST_MAX_FREE_ELEMENTS; i++)
+	{
+		in_flight[i] = slab_alloc(&slab);
+	}
+	for (i = 0; i < TEST_MAX_FREE_ELEMENTS; i++)
+	{
+		slab_free(&slab, in_flight[i]);
+	}
+	umock_c_reset_all_calls();
+
+	// act
+	for (round = 0; round < 100; round++)
+	{
+		for (i = 0; i < TEST_MAX_FREE_ELEMENTS; i++)
+		{
+			in_flight[i] = slab_alloc(&slab);
+			ASSERT_IS_NOT_NULL(in_flight[i]);
+		}
+		for (i = 0; i < TEST_MAX_FREE_ELEMENTS; i++)
+		{
+			slab_free(&slab, in_flight[i]);
+		}
+	}
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, TEST_MAX_FREE_ELEMENTS, slab.allocation_count);
+	ASSERT_ARE_EQUAL(size_t, 100 * TEST_MAX_FREE_ELEMENTS, slab.reuse_count);
+
+	// cleanup
+	slab_deinit(&slab);
+}
+
+END_TEST_SUITE(iothub_client_slab_ut)
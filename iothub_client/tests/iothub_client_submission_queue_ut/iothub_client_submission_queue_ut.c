@@ -0,0 +1,505 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+	free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_submission_queue.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_CAPACITY                       4
+
+typedef struct TEST_ELEMENT_TAG
+{
+	void* message;
+	void* callback;
+	uint32_t sequence;
+} TEST_ELEMENT;
+
+
+// Helpers
+
+static void register_global_mock_hooks()
+{
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+}
+
+static void register_global_mock_returns()
+{
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+}
+
+static SUBMISSION_QUEUE_HANDLE create_submission_queue(size_t capacity)
+{
+	umock_c_reset_all_calls();
+	SUBMISSION_QUEUE_HANDLE handle = submission_queue_create(sizeof(TEST_ELEMENT), capacity);
+	ASSERT_IS_NOT_NULL(handle);
+	umock_c_reset_all_calls();
+
+	return handle;
+}
+
+static TEST_ELEMENT make_element(uint32_t sequence)
+{
+	TEST_ELEMENT element;
+	element.message = (void*)(uintptr_t)(0x1000 + sequence);
+	element.callback = (void*)(uintptr_t)(0x2000 + sequence);
+	element.sequence = sequence;
+	return element;
+}
+
+static void assert_element(const TEST_ELEMENT* element, uint32_t expected_sequence)
+{
+	ASSERT_ARE_EQUAL(uint32_t, expected_sequence, element->sequence);
+	ASSERT_ARE_EQUAL(void_ptr, (void*)(uintptr_t)(0x1000 + expected_sequence), element->message);
+	ASSERT_ARE_EQUAL(void_ptr, (void*)(uintptr_t)(0x2000 + expected_sequence), element->callback);
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_submission_queue_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_stdint_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_bool_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	register_global_mock_returns();
+	register_global_mock_hooks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	umock_c_reset_all_calls();
+	umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_001: [If `element_size` or `capacity` are zero, or `capacity` cannot be rounded up to a power of two, `submission_queue_create` shall fail and return NULL]
+TEST_FUNCTION(create_zero_element_size_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	SUBMISSION_QUEUE_HANDLE handle = submission_queue_create(0, TEST_CAPACITY);
+
+	// assert
+	ASSERT_IS_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_001: [If `element_size` or `capacity` are zero, or `capacity` cannot be rounded up to a power of two, `submission_queue_create` shall fail and return NULL]
+TEST_FUNCTION(create_zero_capacity_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	SUBMISSION_QUEUE_HANDLE handle = submission_queue_create(sizeof(TEST_ELEMENT), 0);
+
+	// assert
+	ASSERT_IS_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_001: [If `element_size` or `capacity` are zero, or `capacity` cannot be rounded up to a power of two, `submission_queue_create` shall fail and return NULL]
+TEST_FUNCTION(create_capacity_not_representable_as_power_of_two_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	SUBMISSION_QUEUE_HANDLE handle = submission_queue_create(sizeof(TEST_ELEMENT), SIZE_MAX);
+
+	// assert
+	ASSERT_IS_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_002: [If the memory required for the slots overflows size_t, `submission_queue_create` shall fail and return NULL]
+TEST_FUNCTION(create_size_overflow_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	SUBMISSION_QUEUE_HANDLE handle1 = submission_queue_create(SIZE_MAX / 2, TEST_CAPACITY);
+	SUBMISSION_QUEUE_HANDLE handle2 = submission_queue_create(SIZE_MAX, 1);
+
+	// assert
+	ASSERT_IS_NULL(handle1);
+	ASSERT_IS_NULL(handle2);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_003: [`submission_queue_create` shall allocate the queue instance, its sequence numbers and its slots in a single block of memory]
+TEST_FUNCTION(create_success)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+
+	// act
+	SUBMISSION_QUEUE_HANDLE handle = submission_queue_create(sizeof(TEST_ELEMENT), TEST_CAPACITY);
+
+	// assert
+	ASSERT_IS_NOT_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_004: [If malloc fails, `submission_queue_create` shall fail and return NULL]
+TEST_FUNCTION(create_malloc_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	EXPECTED_CALL(malloc(IGNORED_NUM_ARG))
+		.SetReturn(NULL);
+
+	// act
+	SUBMISSION_QUEUE_HANDLE handle = submission_queue_create(sizeof(TEST_ELEMENT), TEST_CAPACITY);
+
+	// assert
+	ASSERT_IS_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_005: [The capacity shall be rounded up to the next power of two and the sequence number of each slot shall be initialized with its index]
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_008: [If all slots hold elements not yet popped, `submission_queue_push` shall fail and return non-zero]
+TEST_FUNCTION(push_capacity_is_rounded_up_to_power_of_two)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY - 1);
+	TEST_ELEMENT element;
+	uint32_t i;
+
+	// act
+	for (i = 0; i < TEST_CAPACITY; i++)
+	{
+		element = make_element(i);
+		ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+	}
+
+	element = make_element(TEST_CAPACITY);
+	int result = submission_queue_push(handle, &element);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_006: [If `submission_queue_handle` or `element` are NULL, `submission_queue_push` shall fail and return non-zero]
+TEST_FUNCTION(push_NULL_handle_fails)
+{
+	// arrange
+	TEST_ELEMENT element = make_element(1);
+	umock_c_reset_all_calls();
+
+	// act
+	int result = submission_queue_push(NULL, &element);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_006: [If `submission_queue_handle` or `element` are NULL, `submission_queue_push` shall fail and return non-zero]
+TEST_FUNCTION(push_NULL_element_fails)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+
+	// act
+	int result = submission_queue_push(handle, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_007: [`submission_queue_push` shall claim the next free slot without taking any lock, copy `element_size` bytes of `element` into it and return 0]
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_010: [`submission_queue_pop` shall copy the oldest element into `element`, release its slot to producers and return 0]
+TEST_FUNCTION(push_pop_preserves_order)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+	TEST_ELEMENT element;
+	uint32_t i;
+
+	for (i = 0; i < 3; i++)
+	{
+		element = make_element(i);
+		ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+	}
+
+	// The queue keeps its own copy of each element.
+	memset(&element, 0, sizeof(element));
+
+	// act
+	for (i = 0; i < 3; i++)
+	{
+		TEST_ELEMENT popped;
+		ASSERT_ARE_EQUAL(int, 0, submission_queue_pop(handle, &popped));
+
+		// assert
+		assert_element(&popped, i);
+	}
+
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_010: [`submission_queue_pop` shall copy the oldest element into `element`, release its slot to producers and return 0]
+TEST_FUNCTION(pop_releases_slot_to_producers)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+	TEST_ELEMENT element;
+	TEST_ELEMENT popped;
+	uint32_t i;
+
+	for (i = 0; i < TEST_CAPACITY; i++)
+	{
+		element = make_element(i);
+		ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+	}
+	element = make_element(TEST_CAPACITY);
+	ASSERT_ARE_NOT_EQUAL(int, 0, submission_queue_push(handle, &element));
+
+	// act
+	ASSERT_ARE_EQUAL(int, 0, submission_queue_pop(handle, &popped));
+	int result = submission_queue_push(handle, &element);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	assert_element(&popped, 0);
+
+	for (i = 1; i <= TEST_CAPACITY; i++)
+	{
+		ASSERT_ARE_EQUAL(int, 0, submission_queue_pop(handle, &popped));
+		assert_element(&popped, i);
+	}
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_007: [`submission_queue_push` shall claim the next free slot without taking any lock, copy `element_size` bytes of `element` into it and return 0]
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_010: [`submission_queue_pop` shall copy the oldest element into `element`, release its slot to producers and return 0]
+TEST_FUNCTION(push_pop_wraps_around_many_laps)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+	uint32_t pushed = 0;
+	uint32_t popped_count = 0;
+	uint32_t lap;
+
+	// act
+	for (lap = 0; lap < 100; lap++)
+	{
+		// Leave a different number of elements queued at the end of each lap so positions drift across slots.
+		uint32_t batch = (lap % TEST_CAPACITY) + 1;
+		uint32_t i;
+
+		for (i = 0; i < batch; i++)
+		{
+			TEST_ELEMENT element = make_element(pushed);
+			ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+			pushed++;
+		}
+
+		while (popped_count < pushed)
+		{
+			TEST_ELEMENT popped;
+			ASSERT_ARE_EQUAL(int, 0, submission_queue_pop(handle, &popped));
+
+			// assert
+			assert_element(&popped, popped_count);
+			popped_count++;
+		}
+	}
+
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_009: [If `submission_queue_handle` or `element` are NULL, `submission_queue_pop` shall fail and return non-zero]
+TEST_FUNCTION(pop_NULL_handle_fails)
+{
+	// arrange
+	TEST_ELEMENT element;
+	umock_c_reset_all_calls();
+
+	// act
+	int result = submission_queue_pop(NULL, &element);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_009: [If `submission_queue_handle` or `element` are NULL, `submission_queue_pop` shall fail and return non-zero]
+TEST_FUNCTION(pop_NULL_element_fails)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+	TEST_ELEMENT element = make_element(1);
+	ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+
+	// act
+	int result = submission_queue_pop(handle, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+	// The element is still there.
+	ASSERT_ARE_EQUAL(int, 0, submission_queue_pop(handle, &element));
+	assert_element(&element, 1);
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_011: [If no element is ready, `submission_queue_pop` shall return non-zero]
+TEST_FUNCTION(pop_empty_queue_fails)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+	TEST_ELEMENT element = make_element(1);
+
+	// act
+	int result1 = submission_queue_pop(handle, &element);
+	ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+	ASSERT_ARE_EQUAL(int, 0, submission_queue_pop(handle, &element));
+	int result2 = submission_queue_pop(handle, &element);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	submission_queue_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_012: [If `submission_queue_handle` is NULL, `submission_queue_destroy` shall return]
+TEST_FUNCTION(destroy_NULL_handle)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	submission_queue_destroy(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SUBMISSION_QUEUE_09_013: [`submission_queue_destroy` shall free the memory allocated for the queue; elements still queued are discarded]
+TEST_FUNCTION(destroy_success)
+{
+	// arrange
+	SUBMISSION_QUEUE_HANDLE handle = create_submission_queue(TEST_CAPACITY);
+	TEST_ELEMENT element = make_element(1);
+	ASSERT_ARE_EQUAL(int, 0, submission_queue_push(handle, &element));
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(free(handle));
+
+	// act
+	submission_queue_destroy(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(iothub_client_submission_queue_ut)
@@ -0,0 +1,613 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+	free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_tls_session_cache.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	int real_mallocAndStrcpy_s(char** destination, const char* source);
+
+	SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+	void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+	LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+	int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+	LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+	LIST_ITEM_HANDLE real_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle);
+	LIST_ITEM_HANDLE real_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE list, LIST_MATCH_FUNCTION match_function, const void* match_context);
+	const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_HOSTNAME                       "some.azure-devices.net"
+#define TEST_OTHER_HOSTNAME                 "other.azure-devices.net"
+
+static const unsigned char TEST_SESSION_TICKET_1[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+static const unsigned char TEST_SESSION_TICKET_2[] = { 0x11, 0x12, 0x13 };
+
+
+// TLS server stand-in
+//
+// Mimics what a TLS I/O adapter does with the TLS_SESSION_STORE it receives through OPTION_TLS_SESSION_STORE:
+// offers the cached session (if any) when the handshake starts, and saves the session issued by the server
+// (or discards a session the server refused to resume) when the handshake completes.
+
+typedef struct TEST_TLS_SERVER_TAG
+{
+	const unsigned char* ticket;
+	size_t ticket_size;
+	bool accepts_resumption;
+	size_t full_handshakes;
+	size_t resumed_handshakes;
+} TEST_TLS_SERVER;
+
+static TEST_TLS_SERVER g_tls_server;
+
+static void TEST_tls_adapter_connect(const TLS_SESSION_STORE* store)
+{
+	const unsigned char* session;
+	size_t session_size;
+
+	if (store->get_session(store->context, &session, &session_size) == 0 &&
+		g_tls_server.accepts_resumption &&
+		session_size == g_tls_server.ticket_size &&
+		memcmp(session, g_tls_server.ticket, session_size) == 0)
+	{
+		g_tls_server.resumed_handshakes++;
+	}
+	else
+	{
+		g_tls_server.full_handshakes++;
+
+		if (session != NULL)
+		{
+			// The server refused to resume; drop the stale session before the new one arrives.
+			store->save_session(store->context, NULL, 0);
+		}
+
+		store->save_session(store->context, g_tls_server.ticket, g_tls_server.ticket_size);
+	}
+}
+
+static void reset_tls_server(const unsigned char* ticket, size_t ticket_size)
+{
+	g_tls_server.ticket = ticket;
+	g_tls_server.ticket_size = ticket_size;
+	g_tls_server.accepts_resumption = true;
+	g_tls_server.full_handshakes = 0;
+	g_tls_server.resumed_handshakes = 0;
+}
+
+
+// Helpers
+
+static void register_umock_alias_types()
+{
+	REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
+}
+
+static void register_global_mock_hooks()
+{
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+	REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
+
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, real_singlylinkedlist_get_next_item);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, real_singlylinkedlist_find);
+	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+}
+
+static void register_global_mock_returns()
+{
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, __LINE__);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_create, NULL);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_add, NULL);
+}
+
+static TLS_SESSION_CACHE_HANDLE create_tls_session_cache()
+{
+	umock_c_reset_all_calls();
+	TLS_SESSION_CACHE_HANDLE handle = tls_session_cache_create();
+	ASSERT_IS_NOT_NULL(handle);
+
+	return handle;
+}
+
+static void set_expected_calls_for_get_store_new_entry()
+{
+	STRICT_EXPECTED_CALL(singlylinkedlist_find(IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_HOSTNAME))
+		.IgnoreArgument_list()
+		.IgnoreArgument_match_function();
+	EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_HOSTNAME))
+		.IgnoreArgument_destination();
+	STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_tls_session_cache_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_stdint_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_bool_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	register_umock_alias_types();
+	register_global_mock_returns();
+	register_global_mock_hooks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	umock_c_reset_all_calls();
+	umock_c_negative_tests_deinit();
+
+	reset_tls_server(TEST_SESSION_TICKET_1, sizeof(TEST_SESSION_TICKET_1));
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_001: [`tls_session_cache_create` shall allocate memory for the cache instance structure (a.k.a. `tls_session_cache`)]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_003: [`tls_session_cache->entries` shall be created using singlylinkedlist_create()]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_005: [If no errors occur, `tls_session_cache_create` shall return a handle to `tls_session_cache`]
+TEST_FUNCTION(create_success)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(singlylinkedlist_create());
+
+	// act
+	TLS_SESSION_CACHE_HANDLE handle = tls_session_cache_create();
+
+	// assert
+	ASSERT_IS_NOT_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_002: [If malloc fails, `tls_session_cache_create` shall fail and return NULL]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_004: [If singlylinkedlist_create() fails, `tls_session_cache_create` shall free any memory it allocated and return NULL]
+TEST_FUNCTION(create_failure_checks)
+{
+	// arrange
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+	umock_c_reset_all_calls();
+	EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(singlylinkedlist_create());
+	umock_c_negative_tests_snapshot();
+
+	size_t i;
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		// arrange
+		char error_msg[64];
+
+		umock_c_negative_tests_reset();
+		umock_c_negative_tests_fail_call(i);
+
+		// act
+		TLS_SESSION_CACHE_HANDLE handle = tls_session_cache_create();
+
+		// assert
+		sprintf(error_msg, "On failed call %zu", i);
+		ASSERT_IS_NULL_WITH_MSG(handle, error_msg);
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_006: [If `tls_session_cache_handle` or `hostname` are NULL, `tls_session_cache_get_store` shall fail and return NULL]
+TEST_FUNCTION(get_store_NULL_handle)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(NULL, TEST_HOSTNAME);
+
+	// assert
+	ASSERT_IS_NULL(store);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_006: [If `tls_session_cache_handle` or `hostname` are NULL, `tls_session_cache_get_store` shall fail and return NULL]
+TEST_FUNCTION(get_store_NULL_hostname)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	umock_c_reset_all_calls();
+
+	// act
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, NULL);
+
+	// assert
+	ASSERT_IS_NULL(store);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_007: [If an entry for `hostname` exists in `tls_session_cache->entries`, `tls_session_cache_get_store` shall return its TLS_SESSION_STORE]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_008: [Otherwise a new entry shall be allocated, with a copy of `hostname` and no session]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_010: [The new entry shall be added to `tls_session_cache->entries` using singlylinkedlist_add()]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_011: [The TLS_SESSION_STORE of the new entry shall be set with the get_session and save_session callbacks, with the entry as context, and returned]
+TEST_FUNCTION(get_store_success)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+
+	umock_c_reset_all_calls();
+	set_expected_calls_for_get_store_new_entry();
+
+	// act
+	const TLS_SESSION_STORE* store1 = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	const TLS_SESSION_STORE* store2 = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	const TLS_SESSION_STORE* store3 = tls_session_cache_get_store(handle, TEST_OTHER_HOSTNAME);
+
+	// assert
+	ASSERT_IS_NOT_NULL(store1);
+	ASSERT_IS_NOT_NULL(store1->get_session);
+	ASSERT_IS_NOT_NULL(store1->save_session);
+	ASSERT_IS_NOT_NULL(store1->context);
+	ASSERT_ARE_EQUAL(void_ptr, (void*)store1, (void*)store2);
+	ASSERT_IS_NOT_NULL(store3);
+	ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)store1, (void*)store3);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_009: [If any failure occurs, `tls_session_cache_get_store` shall free any memory it allocated and return NULL]
+TEST_FUNCTION(get_store_failure_checks)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+	umock_c_reset_all_calls();
+	set_expected_calls_for_get_store_new_entry();
+	umock_c_negative_tests_snapshot();
+
+	// singlylinkedlist_find() returning NULL is not a failure (entry not found).
+	size_t i;
+	for (i = 1; i < umock_c_negative_tests_call_count(); i++)
+	{
+		// arrange
+		char error_msg[64];
+
+		umock_c_negative_tests_reset();
+		umock_c_negative_tests_fail_call(i);
+
+		// act
+		const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+
+		// assert
+		sprintf(error_msg, "On failed call %zu", i);
+		ASSERT_IS_NULL_WITH_MSG(store, error_msg);
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_016: [If `context`, `session` or `session_size` are NULL, get_session shall fail and return non-zero]
+TEST_FUNCTION(get_session_NULL_arguments)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	const unsigned char* session;
+	size_t session_size;
+
+	// act
+	int result1 = store->get_session(NULL, &session, &session_size);
+	int result2 = store->get_session(store->context, NULL, &session_size);
+	int result3 = store->get_session(store->context, &session, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_017: [If a session is cached for the entry, get_session shall set `session` and `session_size`, increment the `hits` counter and return 0]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_018: [Otherwise get_session shall set `session` to NULL and `session_size` to 0, increment the `misses` counter and return non-zero]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_020: [Any session previously cached for the entry shall be discarded]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_022: [A copy of `session` shall be saved in the entry and the `sessions_saved` counter incremented]
+TEST_FUNCTION(get_and_save_session_success)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	const unsigned char* session;
+	size_t session_size;
+	unsigned char ticket[sizeof(TEST_SESSION_TICKET_2)];
+	TLS_SESSION_CACHE_STATISTICS statistics;
+
+	(void)memcpy(ticket, TEST_SESSION_TICKET_2, sizeof(ticket));
+
+	// act
+	int result1 = store->get_session(store->context, &session, &session_size);
+	ASSERT_IS_NULL(session);
+	ASSERT_ARE_EQUAL(size_t, 0, session_size);
+
+	store->save_session(store->context, TEST_SESSION_TICKET_1, sizeof(TEST_SESSION_TICKET_1));
+	store->save_session(store->context, ticket, sizeof(ticket));
+	(void)memset(ticket, 0, sizeof(ticket));
+
+	int result2 = store->get_session(store->context, &session, &session_size);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_EQUAL(int, 0, result2);
+	ASSERT_ARE_EQUAL(size_t, sizeof(TEST_SESSION_TICKET_2), session_size);
+	ASSERT_ARE_EQUAL(int, 0, memcmp(session, TEST_SESSION_TICKET_2, session_size));
+
+	ASSERT_ARE_EQUAL(int, 0, tls_session_cache_get_statistics(handle, &statistics));
+	ASSERT_ARE_EQUAL(size_t, 1, statistics.hits);
+	ASSERT_ARE_EQUAL(size_t, 1, statistics.misses);
+	ASSERT_ARE_EQUAL(size_t, 2, statistics.sessions_saved);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_019: [If `context` is NULL, save_session shall return]
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_021: [If `session` is NULL or `session_size` is 0, save_session shall return]
+TEST_FUNCTION(save_session_NULL_session_discards)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	const unsigned char* session;
+	size_t session_size;
+
+	store->save_session(store->context, TEST_SESSION_TICKET_1, sizeof(TEST_SESSION_TICKET_1));
+
+	// act
+	store->save_session(NULL, TEST_SESSION_TICKET_2, sizeof(TEST_SESSION_TICKET_2));
+	int result1 = store->get_session(store->context, &session, &session_size);
+
+	store->save_session(store->context, NULL, 0);
+	int result2 = store->get_session(store->context, &session, &session_size);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+	ASSERT_IS_NULL(session);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_023: [If malloc fails, save_session shall return without caching the session]
+TEST_FUNCTION(save_session_malloc_fails)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	const unsigned char* session;
+	size_t session_size;
+	TLS_SESSION_CACHE_STATISTICS statistics;
+
+	umock_c_reset_all_calls();
+	EXPECTED_CALL(malloc(IGNORED_NUM_ARG)).SetReturn(NULL);
+
+	// act
+	store->save_session(store->context, TEST_SESSION_TICKET_1, sizeof(TEST_SESSION_TICKET_1));
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, store->get_session(store->context, &session, &session_size));
+	ASSERT_ARE_EQUAL(int, 0, tls_session_cache_get_statistics(handle, &statistics));
+	ASSERT_ARE_EQUAL(size_t, 0, statistics.sessions_saved);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_012: [If `tls_session_cache_handle` or `statistics` are NULL, `tls_session_cache_get_statistics` shall fail and return non-zero]
+TEST_FUNCTION(get_statistics_NULL_arguments)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	TLS_SESSION_CACHE_STATISTICS statistics;
+
+	// act
+	int result1 = tls_session_cache_get_statistics(NULL, &statistics);
+	int result2 = tls_session_cache_get_statistics(handle, NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_014: [If `tls_session_cache_handle` is NULL, `tls_session_cache_destroy` shall return]
+TEST_FUNCTION(destroy_NULL_handle)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	tls_session_cache_destroy(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_015: [Every entry (with its cached session) shall be removed and freed, then `tls_session_cache->entries` destroyed and `tls_session_cache` freed]
+TEST_FUNCTION(destroy_success)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	const TLS_SESSION_STORE* store = tls_session_cache_get_store(handle, TEST_HOSTNAME);
+	store->save_session(store->context, TEST_SESSION_TICKET_1, sizeof(TEST_SESSION_TICKET_1));
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+	EXPECTED_CALL(free(IGNORED_PTR_ARG)); // session
+	EXPECTED_CALL(free(IGNORED_PTR_ARG)); // hostname
+	EXPECTED_CALL(free(IGNORED_PTR_ARG)); // entry
+	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+	EXPECTED_CALL(free(IGNORED_PTR_ARG)); // tls_session_cache
+
+	// act
+	tls_session_cache_destroy(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Reconnect cycles against the TLS server stand-in: the first connection does a full handshake,
+// the following ones resume, a server-side ticket rotation forces one full handshake, and every
+// reconnection after that resumes again.
+// Tests_SRS_IOTHUB_CLIENT_TLS_SESSION_CACHE_09_013: [`statistics` shall be set with the `hits`, `misses` and `sessions_saved` counters of `tls_session_cache` and the function shall return 0]
+TEST_FUNCTION(reconnects_resume_against_tls_server_stand_in)
+{
+	// arrange
+	TLS_SESSION_CACHE_HANDLE handle = create_tls_session_cache();
+	TLS_SESSION_CACHE_STATISTICS statistics;
+	int i;
+
+	// act
+	for (i = 0; i < 5; i++)
+	{
+		// Transports ask for the store every time they create a new TLS I/O.
+		TEST_tls_adapter_connect(tls_session_cache_get_store(handle, TEST_HOSTNAME));
+	}
+
+	// The server rotates its ticket keys; the cached ticket is no longer accepted.
+	g_tls_server.ticket = TEST_SESSION_TICKET_2;
+	g_tls_server.ticket_size = sizeof(TEST_SESSION_TICKET_2);
+
+	for (i = 0; i < 5; i++)
+	{
+		TEST_tls_adapter_connect(tls_session_cache_get_store(handle, TEST_HOSTNAME));
+	}
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 2, g_tls_server.full_handshakes);
+	ASSERT_ARE_EQUAL(size_t, 8, g_tls_server.resumed_handshakes);
+
+	ASSERT_ARE_EQUAL(int, 0, tls_session_cache_get_statistics(handle, &statistics));
+	ASSERT_ARE_EQUAL(size_t, 9, statistics.hits);
+	ASSERT_ARE_EQUAL(size_t, 1, statistics.misses);
+	ASSERT_ARE_EQUAL(size_t, 2, statistics.sessions_saved);
+
+	// cleanup
+	tls_session_cache_destroy(handle);
+}
+
+END_TEST_SUITE(iothub_client_tls_session_cache_ut)
@@ -60,6 +60,10 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #include "iothub_client_ll_uploadtoblob.h"
 #endif
 
+#ifdef USE_MESSAGE_COMPRESSION
+#include "iothub_client_message_compressor.h"
+#endif
+
 MOCKABLE_FUNCTION(, void, test_event_confirmation_callback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result, void*, userContextCallback);
 MOCKABLE_FUNCTION(, IOTHUBMESSAGE_DISPOSITION_RESULT, test_message_callback_async, IOTHUB_MESSAGE_HANDLE, message, void*, userContextCallback);
 MOCKABLE_FUNCTION(, void, iothub_reported_state_callback, int, status_code, void*, userContextCallback);
@@ -67,6 +71,8 @@ MOCKABLE_FUNCTION(, void, iothub_device_twin_callback, DEVICE_TWIN_UPDATE_STATE,
 MOCKABLE_FUNCTION(, int, deviceMethodCallback, const char*, method_name, const unsigned char*, payload, size_t, size, unsigned char**, response, size_t*, resp_size, void*, userContextCallback);
 MOCKABLE_FUNCTION(, int, iothub_client_inbound_device_method_callback, const char*, method_name, const unsigned char*, payload, size_t, size, METHOD_HANDLE, method_id, void*, userContextCallback);
 
+MOCKABLE_FUNCTION(, int, retry_control_set_reconnect_admission_rate, unsigned int, reconnects_per_sec, unsigned int, burst_size);
+
 MOCKABLE_FUNCTION(, STRING_HANDLE, FAKE_IoTHubTransport_GetHostname, TRANSPORT_LL_HANDLE, handle);
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, FAKE_IoTHubTransport_SetOption, TRANSPORT_LL_HANDLE, handle, const char*, optionName, const void*, value);
 MOCKABLE_FUNCTION(, TRANSPORT_LL_HANDLE, FAKE_IoTHubTransport_Create, const IOTHUBTRANSPORT_CONFIG*, config);
@@ -78,6 +84,7 @@ MOCKABLE_FUNCTION(, void, FAKE_IoTHubTransport_Unsubscribe, IOTHUB_DEVICE_HANDLE
 MOCKABLE_FUNCTION(, void, FAKE_IoTHubTransport_DoWork, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle);
 MOCKABLE_FUNCTION(, int, FAKE_IoTHubTransport_SetRetryPolicy, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_RETRY_POLICY, retryPolicy, size_t, retryTimeoutLimitInSeconds);
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, FAKE_IoTHubTransport_GetSendStatus, IOTHUB_DEVICE_HANDLE, handle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
+MOCKABLE_FUNCTION(, void, FAKE_IoTHubTransport_GetStatistics, TRANSPORT_LL_HANDLE, handle, IOTHUB_CLIENT_STATISTICS*, statistics);
 MOCKABLE_FUNCTION(, int, FAKE_IoTHubTransport_Subscribe_DeviceTwin, IOTHUB_DEVICE_HANDLE, handle);
 MOCKABLE_FUNCTION(, void, FAKE_IoTHubTransport_Unsubscribe_DeviceTwin, IOTHUB_DEVICE_HANDLE, handle);
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, FAKE_IoTHubTransport_SendMessageDisposition, MESSAGE_CALLBACK_INFO*, messageData, IOTHUBMESSAGE_DISPOSITION_RESULT, disposition);
@@ -157,6 +164,8 @@ static const char* TEST_STRING_VALUE = "Test string value";
 #define TEST_TRANSPORT_LL_HANDLE            (TRANSPORT_LL_HANDLE)0x49
 #define TEST_IOTHUB_DEVICE_HANDLE           (IOTHUB_DEVICE_HANDLE)0x50
 #define TEST_MESSAGE_HANDLE                 (IOTHUB_MESSAGE_HANDLE)0x51
+#define TEST_COMPRESSED_MESSAGE_HANDLE      (IOTHUB_MESSAGE_HANDLE)0x53
+#define TEST_MESSAGE_COMPRESSOR_HANDLE      (MESSAGE_COMPRESSOR_HANDLE)0x54
 #define TEST_TIME_VALUE                     (time_t)123456
 
 #define TEST_BUFFER_HANDLE                  (BUFFER_HANDLE)0x52
@@ -168,6 +177,7 @@ static const char* TEST_STRING_VALUE = "Test string value";
 static const char* TEST_METHOD_NAME = "method_name";
 static const char* TEST_CHAR = "TestChar";
 static tickcounter_ms_t g_current_ms = 0;
+static PDLIST_ENTRY g_waitingToSend = NULL;
 static const char* TEST_DEVICE_METHOD_RESPONSE = "{device:method, response:true}";
 
 const unsigned char TEST_REPORTED_STATE[] = { 0x01, 0x02, 0x03 };
@@ -364,7 +374,7 @@ static IOTHUB_DEVICE_HANDLE my_FAKE_IoTHubTransport_Register(TRANSPORT_LL_HANDLE
     (void)handle;
     (void)device;
     (void)iotHubClientHandle;
-    (void)waitingToSend;
+    g_waitingToSend = waitingToSend;
     return (IOTHUB_DEVICE_HANDLE)my_gballoc_malloc(1);
 }
 
@@ -536,6 +546,12 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE, void*);
 #endif // DONT_USE_UPLOADTOBLOB
 
+#ifdef USE_MESSAGE_COMPRESSION
+    REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_COMPRESSOR_HANDLE, void*);
+    REGISTER_GLOBAL_MOCK_RETURN(message_compressor_create, TEST_MESSAGE_COMPRESSOR_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_compressor_create, NULL);
+#endif // USE_MESSAGE_COMPRESSION
+
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_GetVersionString, "version 1.0");
 
     REGISTER_GLOBAL_MOCK_RETURN(FAKE_IoTHubTransport_Subscribe_DeviceTwin, 0);
@@ -1640,6 +1656,7 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_NULL_test_event_confirmation_c
 
 /*Tests_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, test_event_confirmation_callback, userContextCallback.]*/
 /*Tests_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_09_011: [ IoTHubClient_LL_SendEventAsync shall get the current time from the tickcounter and store it in the new record as the time the event was enqueued. ]*/
 TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_succeeds)
 {
     //arrange
@@ -1649,6 +1666,10 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_succeeds)
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
 
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
     STRICT_EXPECTED_CALL(IoTHubMessage_Clone(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
@@ -1763,6 +1784,96 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_fails)
     umock_c_negative_tests_deinit();
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_09_031: [ IoTHubClient_LL_SendQueuedEventAsync shall behave as IoTHubClient_LL_SendEventAsync, except that on success it shall take ownership of eventMessageHandle instead of cloning it; on failure eventMessageHandle shall be left to the caller. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendQueuedEventAsync_takes_the_message_without_cloning_it)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendQueuedEventAsync(handle, TEST_MESSAGE_HANDLE, 0, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(TEST_MESSAGE_HANDLE)); /*the message is destroyed by IoTHubClient_LL*/
+    IoTHubClient_LL_Destroy(handle);
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_031: [ IoTHubClient_LL_SendQueuedEventAsync shall behave as IoTHubClient_LL_SendEventAsync, except that on success it shall take ownership of eventMessageHandle instead of cloning it; on failure eventMessageHandle shall be left to the caller. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendQueuedEventAsync_fails_without_destroying_the_message)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1)
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendQueuedEventAsync(handle, TEST_MESSAGE_HANDLE, 0, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_032: [ IoTHubClient_LL_SendQueuedEventAsync shall store in the new record the current time minus queued_ms as the time the event was enqueued, so that the send latency and messageTimeout of the event include the time it was queued. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendQueuedEventAsync_messageTimeout_includes_the_time_the_event_was_queued)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t five = 5;
+    (void)IoTHubClient_LL_SetOption(handle, "messageTimeout", &five);
+
+    tickcounter_ms_t ten = 10;
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &ten, sizeof(ten));
+    (void)IoTHubClient_LL_SendQueuedEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, 4, test_event_confirmation_callback, (void*)TEST_DEVICEMESSAGE_HANDLE);
+    umock_c_reset_all_calls();
+
+    tickcounter_ms_t twelve = 12; /*12 > 10 - 4 (time queued by IoTHubClient) + 5 (timeout) => timeout*/
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &twelve, sizeof(twelve));
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, (void*)TEST_DEVICEMESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(TEST_DEVICEMESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+
+    //act
+    IoTHubClient_LL_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
 /*Tests_SRS_IOTHUBCLIENT_LL_25_111: [IoTHubClient_LL_SetConnectionStatusCallback shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL parameter iotHubClientHandle]*/
 TEST_FUNCTION(IoTHubClient_LL_SetConnectionStatusCallback_with_NULL_iotHubClientHandle_fails)
 {
@@ -2065,9 +2176,14 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_1_items_with_callback_succeeds)
     one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
     one->callback = eventConfirmationCallback;
     one->context = (void*)1;
+    one->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(one->entry));
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
     STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
@@ -2100,22 +2216,29 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_3_items_with_callback_succeeds)
     one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
     one->callback = eventConfirmationCallback;
     one->context = (void*)1;
+    one->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(one->entry));
 
     IOTHUB_MESSAGE_LIST* two = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
     two->messageHandle = (IOTHUB_MESSAGE_HANDLE)2;
     two->callback = eventConfirmationCallback;
     two->context = (void*)2;
+    two->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(two->entry));
 
     IOTHUB_MESSAGE_LIST* three = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
     three->messageHandle = (IOTHUB_MESSAGE_HANDLE)3;
     three->callback = eventConfirmationCallback;
     three->context = (void*)3;
+    three->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(three->entry));
 
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
     STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
@@ -2486,22 +2609,29 @@ TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_3_items_one_without_callback_suc
     one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
     one->callback = test_event_confirmation_callback;
     one->context = (void*)1;
+    one->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(one->entry));
 
     IOTHUB_MESSAGE_LIST* two = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
     two->messageHandle = (IOTHUB_MESSAGE_HANDLE)2;
     two->callback = NULL;
     two->context = NULL;
+    two->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(two->entry));
 
     IOTHUB_MESSAGE_LIST* three = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST)); /*this is SendEvent wannabe*/
     three->messageHandle = (IOTHUB_MESSAGE_HANDLE)3;
     three->callback = test_event_confirmation_callback;
     three->context = (void*)3;
+    three->has_enqueue_time = false;
     DList_InsertTailList(&temp, &(three->entry));
 
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
     STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
@@ -2904,189 +3034,475 @@ TEST_FUNCTION(IoTHubClient_LL_GetLastMessageReceiveTime_MessagesReceived_succeed
     destroy_test_message_info(testMessage);
 }
 
-/*** IoTHubClient_LL_GetSendStatus ***/
+/*** IoTHubClient_LL_GetStatistics ***/
 
-/* Tests_SRS_IOTHUBCLIENT_09_007: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL parameter] */
-TEST_FUNCTION(IoTHubClient_LL_GetSendStatus_BadHandleArgument_fails)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_016: [ IoTHubClient_LL_GetStatistics shall return IOTHUB_CLIENT_INVALID_ARG if any of the arguments is NULL. ] */
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_with_NULL_handle_fails)
 {
     // arrange
-
+    IOTHUB_CLIENT_STATISTICS statistics;
     umock_c_reset_all_calls();
 
-    IOTHUB_CLIENT_STATUS status;
-
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(NULL, &status);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(NULL, &statistics);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
-
-    // cleanup
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_IOTHUBCLIENT_09_007: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL parameter] */
-TEST_FUNCTION(IoTHubClient_LL_GetSendStatus_BadStatusArgument_fails)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_016: [ IoTHubClient_LL_GetStatistics shall return IOTHUB_CLIENT_INVALID_ARG if any of the arguments is NULL. ] */
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_with_NULL_statistics_fails)
 {
     // arrange
-
     IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     IoTHubClient_LL_Destroy(handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_09_008: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_IDLE if there is currently no items to be sent] */
-TEST_FUNCTION(IoTHubClient_GetSendStatus_NoEventToSend_Succeeds)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_017: [ IoTHubClient_LL_GetStatistics shall copy all the counters of the client in statistics. ] */
+/* Tests_SRS_IOTHUBCLIENT_LL_09_021: [ Otherwise IoTHubClient_LL_GetStatistics shall succeed and return IOTHUB_CLIENT_OK. ] */
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_on_a_new_client_returns_all_zeros)
 {
     // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
     IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)memset(&statistics, 0xFF, sizeof(statistics));
     umock_c_reset_all_calls();
 
-    IOTHUB_CLIENT_STATUS status;
-    IOTHUB_CLIENT_STATUS desire_status = IOTHUB_CLIENT_SEND_STATUS_IDLE;
-
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetSendStatus(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_handle()
-        .CopyOutArgumentBuffer_iotHubClientStatus(&desire_status, sizeof(status))
-        .SetReturn(IOTHUB_CLIENT_OK);
-
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, &status);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, &statistics);
 
     // assert
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_SEND_STATUS_IDLE, status);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.events_enqueued);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.events_confirmed);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.events_waiting_to_send);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.events_in_flight);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.messages_received);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.connections_established);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.send_latency_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.send_latency_p99_ms);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     IoTHubClient_LL_Destroy(handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_09_009: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently items to be sent] */
-TEST_FUNCTION(IoTHubClient_GetSendStatus_HasEventToSend_Succeeds)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_035: [ If the transport provides IoTHubTransport_GetStatistics, IoTHubClient_LL_GetStatistics shall call it to set the statistics kept by the transport. ] */
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_gets_the_statistics_of_the_transport)
 {
     // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    FAKE_transport_provider.IoTHubTransport_GetStatistics = FAKE_IoTHubTransport_GetStatistics;
     IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
-    IOTHUB_CLIENT_STATUS status;
-    IOTHUB_CLIENT_STATUS desire_status = IOTHUB_CLIENT_SEND_STATUS_BUSY;
-
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetSendStatus(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_handle()
-        .CopyOutArgumentBuffer_iotHubClientStatus(&desire_status, sizeof(status))
-        .SetReturn(IOTHUB_CLIENT_OK);
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetStatistics(IGNORED_PTR_ARG, &statistics))
+        .IgnoreArgument_handle();
 
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, &status);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, &statistics);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_SEND_STATUS_BUSY, status);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     IoTHubClient_LL_Destroy(handle);
+    FAKE_transport_provider.IoTHubTransport_GetStatistics = NULL;
 }
 
-/*Tests_SRS_IOTHUBCLIENT_LL_02_034: [If iotHubClientHandle is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]*/
-TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_handle_fails)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_018: [ IoTHubClient_LL_GetStatistics shall set events_waiting_to_send to the number of records in the waitingToSend list. ] */
+/* Tests_SRS_IOTHUBCLIENT_LL_09_019: [ IoTHubClient_LL_GetStatistics shall set events_in_flight to the number of enqueued events that are neither completed nor in the waitingToSend list. ] */
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_reports_waiting_and_in_flight_events)
 {
-    //arrange
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    DLIST_ENTRY inProgress;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)2);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)3);
 
-    //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(NULL, "a", "b");
+    /*the transport picks up the first event*/
+    DList_InitializeListHead(&inProgress);
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    umock_c_reset_all_calls();
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, &statistics);
 
-    ///cleanup
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(uint64_t, 3, statistics.events_enqueued);
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.events_waiting_to_send);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.events_in_flight);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_LL_SendComplete(handle, &inProgress, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+    IoTHubClient_LL_Destroy(handle);
 }
 
-/*Tests_SRS_IOTHUBCLIENT_LL_02_035: [If optionName is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.] */
-TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_optionName_fails)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_013: [ If result is IOTHUB_CLIENT_CONFIRMATION_OK and completed is not empty, IoTHubClient_LL_SendComplete shall get the current time from the tickcounter once and record the send latency of every completed event. ]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_09_014: [ IoTHubClient_LL_SendComplete shall count every completed event under the counter matching result. ]*/
+/* Tests_SRS_IOTHUBCLIENT_LL_09_020: [ If at least one send latency was recorded, IoTHubClient_LL_GetStatistics shall set the mean and the 50th, 90th, 99th and 99.9th percentiles of the send latency. ] */
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_reports_send_latency_and_completions)
 {
-    //arrange
-
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    DLIST_ENTRY inProgress;
+    tickcounter_ms_t ten = 10;
+    tickcounter_ms_t twenty = 20;
+    tickcounter_ms_t thirty = 30;
     IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+
+    /*events are enqueued at time=10, 20 and 20*/
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &ten, sizeof(ten));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &twenty, sizeof(twenty));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)2);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &twenty, sizeof(twenty));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)3);
+
+    /*the first two are confirmed at time=30 => latencies of 20 and 10 ms, the third one fails*/
+    DList_InitializeListHead(&inProgress);
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &thirty, sizeof(thirty));
+    IoTHubClient_LL_SendComplete(handle, &inProgress, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    IoTHubClient_LL_SendComplete(handle, &inProgress, IOTHUB_CLIENT_CONFIRMATION_ERROR);
     umock_c_reset_all_calls();
 
-    //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, NULL, "b");
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, &statistics);
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(uint64_t, 3, statistics.events_enqueued);
+    ASSERT_ARE_EQUAL(uint64_t, 2, statistics.events_confirmed);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.events_failed);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.events_waiting_to_send);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.events_in_flight);
+    ASSERT_ARE_EQUAL(uint64_t, 2, statistics.send_latency_count);
+    ASSERT_ARE_EQUAL(uint64_t, 10, statistics.send_latency_min_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.send_latency_max_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 15, statistics.send_latency_mean_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 11, statistics.send_latency_p50_ms); /*10 falls in the [10, 11] bucket*/
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.send_latency_p90_ms); /*[20, 23] bucket, capped to the max*/
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.send_latency_p99_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.send_latency_p999_ms);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///cleanup
+    // cleanup
     IoTHubClient_LL_Destroy(handle);
-
 }
 
-/*Tests_SRS_IOTHUBCLIENT_LL_02_036: [If value is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.] */
-TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_value_fails)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_012: [ If getting the current time fails and messages do not timeout, IoTHubClient_LL_SendEventAsync shall still enqueue the event, and no send latency shall be recorded for it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_when_tickcounter_fails_and_no_timeout_succeeds_without_latency)
 {
-    //arrange
-
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    DLIST_ENTRY inProgress;
     IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
-    //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "a", NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .SetReturn(__LINE__);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///cleanup
-    IoTHubClient_LL_Destroy(handle);
+    DList_InitializeListHead(&inProgress);
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    IoTHubClient_LL_SendComplete(handle, &inProgress, IOTHUB_CLIENT_CONFIRMATION_OK);
+    (void)IoTHubClient_LL_GetStatistics(handle, &statistics);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.events_confirmed);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.send_latency_count);
 
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
 }
 
-#ifndef DONT_USE_UPLOADTOBLOB
-/*these tests are to be run when upload to blob functionality exists*/
-
-/*Tests_SRS_IOTHUBCLIENT_LL_02_099 : [IoTHubClient_LL_SetOption shall return according to the table below]*/
-TEST_FUNCTION(IoTHubClient_LL_SetOption_all_combinations)
+/* Tests_SRS_IOTHUBCLIENT_LL_09_014: [ IoTHubClient_LL_SendComplete shall count every completed event under the counter matching result. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_counts_timed_out_events)
 {
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    tickcounter_ms_t one = 1;
+    tickcounter_ms_t ten = 10;
+    tickcounter_ms_t twelve = 12;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(handle, "messageTimeout", &one);
 
-    static struct SetOptionTriplet
-    {
-        IOTHUB_CLIENT_RESULT IoTHubClient_UploadToBlob_SetOption_return;
-        IOTHUB_CLIENT_RESULT Transport_SetOption_return;
-        IOTHUB_CLIENT_RESULT expected_return;
-    } allCombinations[] =
-    {
-        { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_OK , IOTHUB_CLIENT_OK },
-        { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR },
-        { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_OK },
-        { IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_OK , IOTHUB_CLIENT_ERROR },
-        { IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR },
-        { IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_ERROR },
-        { IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_OK , IOTHUB_CLIENT_OK },
-        { IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR },
-        { IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_INVALID_ARG }
-    };
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &ten, sizeof(ten));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)TEST_DEVICEMESSAGE_HANDLE);
 
-    //arrange
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &twelve, sizeof(twelve));
+    IoTHubClient_LL_DoWork(handle);
+    umock_c_reset_all_calls();
 
-    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, &statistics);
 
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.events_enqueued);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.events_timed_out);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.events_waiting_to_send);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.events_in_flight);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.send_latency_count);
 
-    for (size_t i = 0;i < sizeof(allCombinations) / sizeof(allCombinations[0]);i++)
-    {
-        umock_c_reset_all_calls();
-        EXPECTED_CALL(IoTHubClient_LL_UploadToBlob_SetOption(IGNORED_PTR_ARG, "a", "b"))
-            .SetReturn(allCombinations[i].IoTHubClient_UploadToBlob_SetOption_return);
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_09_015: [ IoTHubClient_LL_ConnectionStatusCallBack shall count the transitions to IOTHUB_CLIENT_CONNECTION_AUTHENTICATED and the transitions from IOTHUB_CLIENT_CONNECTION_AUTHENTICATED to IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetStatistics_counts_connection_transitions)
+{
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    IoTHubClient_LL_ConnectionStatusCallBack(handle, IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK);
+    IoTHubClient_LL_ConnectionStatusCallBack(handle, IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK);
+    IoTHubClient_LL_ConnectionStatusCallBack(handle, IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK);
+    IoTHubClient_LL_ConnectionStatusCallBack(handle, IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK);
+    IoTHubClient_LL_ConnectionStatusCallBack(handle, IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK);
+    IoTHubClient_LL_ConnectionStatusCallBack(handle, IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetStatistics(handle, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(uint64_t, 2, statistics.connections_established);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.connections_lost);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*** IoTHubClient_LL_GetSendStatus ***/
+
+/* Tests_SRS_IOTHUBCLIENT_09_007: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL parameter] */
+TEST_FUNCTION(IoTHubClient_LL_GetSendStatus_BadHandleArgument_fails)
+{
+    // arrange
+
+    umock_c_reset_all_calls();
+
+    IOTHUB_CLIENT_STATUS status;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(NULL, &status);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+}
+
+/* Tests_SRS_IOTHUBCLIENT_09_007: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_INVALID_ARG if called with NULL parameter] */
+TEST_FUNCTION(IoTHubClient_LL_GetSendStatus_BadStatusArgument_fails)
+{
+    // arrange
+
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_09_008: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_IDLE if there is currently no items to be sent] */
+TEST_FUNCTION(IoTHubClient_GetSendStatus_NoEventToSend_Succeeds)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    IOTHUB_CLIENT_STATUS status;
+    IOTHUB_CLIENT_STATUS desire_status = IOTHUB_CLIENT_SEND_STATUS_IDLE;
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetSendStatus(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_handle()
+        .CopyOutArgumentBuffer_iotHubClientStatus(&desire_status, sizeof(status))
+        .SetReturn(IOTHUB_CLIENT_OK);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, &status);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_SEND_STATUS_IDLE, status);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_09_009: [IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently items to be sent] */
+TEST_FUNCTION(IoTHubClient_GetSendStatus_HasEventToSend_Succeeds)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    IOTHUB_CLIENT_STATUS status;
+    IOTHUB_CLIENT_STATUS desire_status = IOTHUB_CLIENT_SEND_STATUS_BUSY;
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetSendStatus(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_handle()
+        .CopyOutArgumentBuffer_iotHubClientStatus(&desire_status, sizeof(status))
+        .SetReturn(IOTHUB_CLIENT_OK);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendStatus(handle, &status);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_SEND_STATUS_BUSY, status);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_034: [If iotHubClientHandle is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_handle_fails)
+{
+    //arrange
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(NULL, "a", "b");
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    ///cleanup
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_035: [If optionName is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.] */
+TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_optionName_fails)
+{
+    //arrange
+
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, NULL, "b");
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_036: [If value is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.] */
+TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_value_fails)
+{
+    //arrange
+
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "a", NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+
+}
+
+#ifndef DONT_USE_UPLOADTOBLOB
+/*these tests are to be run when upload to blob functionality exists*/
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_099 : [IoTHubClient_LL_SetOption shall return according to the table below]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_all_combinations)
+{
+
+    static struct SetOptionTriplet
+    {
+        IOTHUB_CLIENT_RESULT IoTHubClient_UploadToBlob_SetOption_return;
+        IOTHUB_CLIENT_RESULT Transport_SetOption_return;
+        IOTHUB_CLIENT_RESULT expected_return;
+    } allCombinations[] =
+    {
+        { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_OK , IOTHUB_CLIENT_OK },
+        { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR },
+        { IOTHUB_CLIENT_OK, IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_OK },
+        { IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_OK , IOTHUB_CLIENT_ERROR },
+        { IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR },
+        { IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_ERROR },
+        { IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_OK , IOTHUB_CLIENT_OK },
+        { IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_ERROR, IOTHUB_CLIENT_ERROR },
+        { IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_INVALID_ARG, IOTHUB_CLIENT_INVALID_ARG }
+    };
+
+    //arrange
+
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+
+
+    for (size_t i = 0;i < sizeof(allCombinations) / sizeof(allCombinations[0]);i++)
+    {
+        umock_c_reset_all_calls();
+        EXPECTED_CALL(IoTHubClient_LL_UploadToBlob_SetOption(IGNORED_PTR_ARG, "a", "b"))
+            .SetReturn(allCombinations[i].IoTHubClient_UploadToBlob_SetOption_return);
 
         EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, "a", "b"))
             .SetReturn(allCombinations[i].Transport_SetOption_return);
@@ -4731,4 +5147,392 @@ TEST_FUNCTION(IoTHubClient_LL_SetOption_product_info_fails_case1)
     IoTHubClient_LL_Destroy(h);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_09_034: [ "reconnect_admission" - IoTHubClient_LL_SetOption shall set the process-wide reconnect admission rate using retry_control_set_reconnect_admission_rate and return IOTHUB_CLIENT_ERROR if it fails. Value is a pointer to an IOTHUB_RECONNECT_ADMISSION_OPTIONS. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_reconnect_admission_sets_the_rate)
+{
+    //arrange
+    IOTHUB_RECONNECT_ADMISSION_OPTIONS admission_options;
+    admission_options.reconnects_per_sec = 10;
+    admission_options.burst_size = 50;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(retry_control_set_reconnect_admission_rate(10, 50));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_RECONNECT_ADMISSION, &admission_options);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_034: [ "reconnect_admission" - IoTHubClient_LL_SetOption shall set the process-wide reconnect admission rate using retry_control_set_reconnect_admission_rate and return IOTHUB_CLIENT_ERROR if it fails. Value is a pointer to an IOTHUB_RECONNECT_ADMISSION_OPTIONS. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_reconnect_admission_fails_when_setting_the_rate_fails)
+{
+    //arrange
+    IOTHUB_RECONNECT_ADMISSION_OPTIONS admission_options;
+    admission_options.reconnects_per_sec = 10;
+    admission_options.burst_size = 0;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(retry_control_set_reconnect_admission_rate(10, 0))
+        .SetReturn(__LINE__);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_RECONNECT_ADMISSION, &admission_options);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_024: [ "message_pool_size" - IoTHubClient_LL_SetOption shall set the number of IOTHUB_MESSAGE_LIST records kept for reuse using slab_set_max_free_elements, then pass the option to the transport and return IOTHUB_CLIENT_ERROR only if IoTHubTransport_SetOption returns IOTHUB_CLIENT_ERROR. Value is a pointer to a size_t. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_passes_the_option_to_the_transport)
+{
+    //arrange
+    size_t pool_size = 4;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, OPTION_MESSAGE_POOL_SIZE, &pool_size))
+        .IgnoreArgument_handle();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_POOL_SIZE, &pool_size);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_024: [ "message_pool_size" - IoTHubClient_LL_SetOption shall set the number of IOTHUB_MESSAGE_LIST records kept for reuse using slab_set_max_free_elements, then pass the option to the transport and return IOTHUB_CLIENT_ERROR only if IoTHubTransport_SetOption returns IOTHUB_CLIENT_ERROR. Value is a pointer to a size_t. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_succeeds_when_the_transport_does_not_support_it)
+{
+    //arrange
+    size_t pool_size = 4;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, OPTION_MESSAGE_POOL_SIZE, &pool_size))
+        .IgnoreArgument_handle()
+        .SetReturn(IOTHUB_CLIENT_INVALID_ARG);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_POOL_SIZE, &pool_size);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_024: [ "message_pool_size" - IoTHubClient_LL_SetOption shall set the number of IOTHUB_MESSAGE_LIST records kept for reuse using slab_set_max_free_elements, then pass the option to the transport and return IOTHUB_CLIENT_ERROR only if IoTHubTransport_SetOption returns IOTHUB_CLIENT_ERROR. Value is a pointer to a size_t. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_fails_when_the_transport_fails)
+{
+    //arrange
+    size_t pool_size = 4;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, OPTION_MESSAGE_POOL_SIZE, &pool_size))
+        .IgnoreArgument_handle()
+        .SetReturn(IOTHUB_CLIENT_ERROR);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_POOL_SIZE, &pool_size);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_023: [ IoTHubClient_LL_SendEventAsync shall get the new IOTHUB_MESSAGE_LIST record using slab_alloc, and every IOTHUB_MESSAGE_LIST record released by IoTHubClient_LL shall be returned using slab_free. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_message_pool_size_reuses_the_completed_record)
+{
+    //arrange
+    size_t pool_size = 1;
+    DLIST_ENTRY inProgress;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_POOL_SIZE, &pool_size);
+    (void)IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    DList_InitializeListHead(&inProgress);
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    IoTHubClient_LL_SendComplete(h, &inProgress, IOTHUB_CLIENT_CONFIRMATION_OK);
+    umock_c_reset_all_calls();
+
+    /*no gballoc_malloc: the record released by IoTHubClient_LL_SendComplete is reused*/
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_023: [ IoTHubClient_LL_SendEventAsync shall get the new IOTHUB_MESSAGE_LIST record using slab_alloc, and every IOTHUB_MESSAGE_LIST record released by IoTHubClient_LL shall be returned using slab_free. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_09_025: [ IoTHubClient_LL_Destroy shall free the IOTHUB_MESSAGE_LIST records kept for reuse using slab_deinit. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Destroy_frees_the_records_kept_for_reuse)
+{
+    //arrange
+    size_t pool_size = 1;
+    DLIST_ENTRY inProgress;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_POOL_SIZE, &pool_size);
+    (void)IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    DList_InitializeListHead(&inProgress);
+    DList_InsertTailList(&inProgress, DList_RemoveHeadList(g_waitingToSend));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(IGNORED_PTR_ARG));
+    /*no gballoc_free: the record is kept for reuse*/
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IoTHubClient_LL_SendComplete(h, &inProgress, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+#ifdef USE_MESSAGE_COMPRESSION
+/*Tests_SRS_IOTHUBCLIENT_LL_09_027: [ "message_compression" - IoTHubClient_LL_SetOption shall replace the message compressor by one created with message_compressor_create, or by none if the content_encoding of the options is NULL, and return IOTHUB_CLIENT_ERROR if creating it fails. Value is a pointer to an IOTHUB_MESSAGE_COMPRESSION_OPTIONS. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_compression_creates_the_compressor)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 128, 0, NULL, 0 };
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    /*the option is not passed to the transport*/
+    STRICT_EXPECTED_CALL(message_compressor_create(&options));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_027: [ "message_compression" - IoTHubClient_LL_SetOption shall replace the message compressor by one created with message_compressor_create, or by none if the content_encoding of the options is NULL, and return IOTHUB_CLIENT_ERROR if creating it fails. Value is a pointer to an IOTHUB_MESSAGE_COMPRESSION_OPTIONS. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_compression_fails_when_the_compressor_cannot_be_created)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "br", 0, 0, NULL, 0 };
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(message_compressor_create(&options))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_027: [ "message_compression" - IoTHubClient_LL_SetOption shall replace the message compressor by one created with message_compressor_create, or by none if the content_encoding of the options is NULL, and return IOTHUB_CLIENT_ERROR if creating it fails. Value is a pointer to an IOTHUB_MESSAGE_COMPRESSION_OPTIONS. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_compression_with_NULL_content_encoding_destroys_the_compressor)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "deflate", 0, 0, NULL, 0 };
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+    umock_c_reset_all_calls();
+
+    options.content_encoding = NULL;
+    STRICT_EXPECTED_CALL(message_compressor_destroy(TEST_MESSAGE_COMPRESSOR_HANDLE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_026: [ If OPTION_MESSAGE_COMPRESSION is set, IoTHubClient_LL_SendEventAsync shall get the message to send from message_compressor_compress, and clone eventMessageHandle only if it returns NULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_message_compression_queues_the_compressed_message)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 0, 0, NULL, 0 };
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    /*no IoTHubMessage_Clone: the compressed message is a copy already*/
+    STRICT_EXPECTED_CALL(message_compressor_compress(TEST_MESSAGE_COMPRESSOR_HANDLE, TEST_MESSAGE_HANDLE))
+        .SetReturn(TEST_COMPRESSED_MESSAGE_HANDLE);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_026: [ If OPTION_MESSAGE_COMPRESSION is set, IoTHubClient_LL_SendEventAsync shall get the message to send from message_compressor_compress, and clone eventMessageHandle only if it returns NULL. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_message_compression_clones_a_message_left_uncompressed)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 0, 0, NULL, 0 };
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(message_compressor_compress(TEST_MESSAGE_COMPRESSOR_HANDLE, TEST_MESSAGE_HANDLE))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_033: [ If the transport accepted OPTION_BATCHING set to true, IoTHubClient_LL_SendEventAsync shall not compress the events, because the batches carry no content encoding. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_message_compression_and_batching_does_not_compress)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 0, 0, NULL, 0 };
+    bool batching = true;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_09_033: [ If the transport accepted OPTION_BATCHING set to true, IoTHubClient_LL_SendEventAsync shall not compress the events, because the batches carry no content encoding. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_message_compression_and_batching_rejected_by_the_transport_compresses)
+{
+    //arrange
+    IOTHUB_MESSAGE_COMPRESSION_OPTIONS options = { "gzip", 0, 0, NULL, 0 };
+    bool batching = true;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_MESSAGE_COMPRESSION, &options);
+    umock_c_reset_all_calls();
+    EXPECTED_CALL(IoTHubClient_LL_UploadToBlob_SetOption(IGNORED_PTR_ARG, OPTION_BATCHING, &batching))
+        .SetReturn(IOTHUB_CLIENT_INVALID_ARG);
+    EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, OPTION_BATCHING, &batching))
+        .SetReturn(IOTHUB_CLIENT_INVALID_ARG);
+    (void)IoTHubClient_LL_SetOption(h, OPTION_BATCHING, &batching);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(message_compressor_compress(TEST_MESSAGE_COMPRESSOR_HANDLE, TEST_MESSAGE_HANDLE))
+        .SetReturn(TEST_COMPRESSED_MESSAGE_HANDLE);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(h, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+#endif // USE_MESSAGE_COMPRESSION
+
 END_TEST_SUITE(iothubclient_ll_ut)
@@ -112,6 +112,26 @@ static int my_mallocAndStrcpy_s(char** destination, const char* source)
     return 0;
 }
 
+static size_t g_properties_loader_calls;
+static int g_properties_loader_result;
+static MAP_HANDLE g_properties_loader_map;
+static void* g_properties_loader_context;
+static size_t g_properties_loader_context_destroy_calls;
+
+static int test_properties_loader(void* context, MAP_HANDLE properties)
+{
+    g_properties_loader_calls++;
+    g_properties_loader_context = context;
+    g_properties_loader_map = properties;
+    return g_properties_loader_result;
+}
+
+static void test_properties_loader_context_destroy(void* context)
+{
+    (void)context;
+    g_properties_loader_context_destroy_calls++;
+}
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -182,6 +202,12 @@ TEST_FUNCTION_INITIALIZE(method_init)
     umock_c_reset_all_calls();
 
     g_mapFilterFunc = NULL;
+
+    g_properties_loader_calls = 0;
+    g_properties_loader_result = 0;
+    g_properties_loader_map = NULL;
+    g_properties_loader_context = NULL;
+    g_properties_loader_context_destroy_calls = 0;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -755,6 +781,195 @@ TEST_FUNCTION(IoTHubMessage_Properties_with_NULL_handle_retuns_NULL)
     //cleanup
 }
 
+/*Tests_SRS_IOTHUBMESSAGE_09_012: [If iotHubMessageHandle or propertiesLoader is NULL then IoTHubMessage_SetPropertiesLoader shall return IOTHUB_MESSAGE_INVALID_ARG.]*/
+TEST_FUNCTION(IoTHubMessage_SetPropertiesLoader_with_NULL_handle_fails)
+{
+    //arrange
+
+    //act
+    IOTHUB_MESSAGE_RESULT r = IoTHubMessage_SetPropertiesLoader(NULL, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, r);
+    ASSERT_ARE_EQUAL(size_t, 0, g_properties_loader_context_destroy_calls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_012: [If iotHubMessageHandle or propertiesLoader is NULL then IoTHubMessage_SetPropertiesLoader shall return IOTHUB_MESSAGE_INVALID_ARG.]*/
+TEST_FUNCTION(IoTHubMessage_SetPropertiesLoader_with_NULL_loader_fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT r = IoTHubMessage_SetPropertiesLoader(h, NULL, test_properties_loader_context_destroy, (void*)0x42);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+    ASSERT_ARE_EQUAL(size_t, 0, g_properties_loader_context_destroy_calls);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_014: [Otherwise IoTHubMessage_SetPropertiesLoader shall store propertiesLoader, contextDestroy and context (which is then owned by the message) and return IOTHUB_MESSAGE_OK.]*/
+TEST_FUNCTION(IoTHubMessage_SetPropertiesLoader_succeeds_without_loading)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT r = IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, r);
+    ASSERT_ARE_EQUAL(size_t, 0, g_properties_loader_calls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_013: [If the message already has a pending properties loader then IoTHubMessage_SetPropertiesLoader shall return IOTHUB_MESSAGE_ERROR.]*/
+TEST_FUNCTION(IoTHubMessage_SetPropertiesLoader_with_pending_loader_fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT r = IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x43);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_015: [If a properties loader is pending, it shall be called passing its context and the properties map before the properties map is used.]*/
+/*Tests_SRS_IOTHUBMESSAGE_09_017: [Once the properties loader succeeds its context shall be released by calling `contextDestroy` (if not NULL) and the loader shall not be called again.]*/
+TEST_FUNCTION(IoTHubMessage_Properties_calls_the_pending_loader_once)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+    umock_c_reset_all_calls();
+
+    //act
+    MAP_HANDLE r1 = IoTHubMessage_Properties(h);
+    MAP_HANDLE r2 = IoTHubMessage_Properties(h);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r1);
+    ASSERT_ARE_EQUAL(void_ptr, r1, r2);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_calls);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_properties_loader_context);
+    ASSERT_ARE_EQUAL(void_ptr, r1, g_properties_loader_map);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_context_destroy_calls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_context_destroy_calls);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_016: [If the properties loader fails it shall be kept, so that the next access to the properties retries loading them.]*/
+/*Tests_SRS_IOTHUBMESSAGE_09_020: [If loading the pending properties fails, IoTHubMessage_Properties shall return NULL.]*/
+TEST_FUNCTION(IoTHubMessage_Properties_when_loader_fails_returns_NULL_and_retries)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+    umock_c_reset_all_calls();
+    g_properties_loader_result = __LINE__;
+
+    //act
+    MAP_HANDLE r1 = IoTHubMessage_Properties(h);
+    g_properties_loader_result = 0;
+    MAP_HANDLE r2 = IoTHubMessage_Properties(h);
+
+    //assert
+    ASSERT_IS_NULL(r1);
+    ASSERT_IS_NOT_NULL(r2);
+    ASSERT_ARE_EQUAL(size_t, 2, g_properties_loader_calls);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_context_destroy_calls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_018: [IoTHubMessage_Clone shall load the pending properties of iotHubMessageHandle before cloning its properties map; if loading them fails IoTHubMessage_Clone shall return NULL.]*/
+TEST_FUNCTION(IoTHubMessage_Clone_loads_the_pending_properties)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_calls);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_context_destroy_calls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(r);
+    IoTHubMessage_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_018: [IoTHubMessage_Clone shall load the pending properties of iotHubMessageHandle before cloning its properties map; if loading them fails IoTHubMessage_Clone shall return NULL.]*/
+TEST_FUNCTION(IoTHubMessage_Clone_when_loading_the_pending_properties_fails_returns_NULL)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+    umock_c_reset_all_calls();
+    g_properties_loader_result = __LINE__;
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+
+    //assert
+    ASSERT_IS_NULL(r);
+    ASSERT_ARE_EQUAL(size_t, 0, g_properties_loader_context_destroy_calls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBMESSAGE_09_019: [IoTHubMessage_Destroy shall release the context of a pending properties loader by calling `contextDestroy` (if not NULL).]*/
+TEST_FUNCTION(IoTHubMessage_Destroy_releases_the_pending_properties_loader_context)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetPropertiesLoader(h, test_properties_loader, test_properties_loader_context_destroy, (void*)0x42);
+    umock_c_reset_all_calls();
+
+    //act
+    IoTHubMessage_Destroy(h);
+
+    //assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_properties_loader_calls);
+    ASSERT_ARE_EQUAL(size_t, 1, g_properties_loader_context_destroy_calls);
+}
+
 /*Tests_SRS_IOTHUBMESSAGE_02_008: [If any parameter is NULL then IoTHubMessage_GetContentType shall return IOTHUBMESSAGE_UNKNOWN.] */
 TEST_FUNCTION(IoTHubMessage_GetContentType_with_NULL_handle_fails)
 {
@@ -80,6 +80,7 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 
 #define DEFAULT_EVENT_SEND_RETRY_LIMIT                    10
 #define DEFAULT_EVENT_SEND_TIMEOUT_SECS 600
+#define MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS      300
 
 #define UNIQUE_ID_BUFFER_SIZE                             37
 #define TEST_UNIQUE_ID                                    "A1234DE234A1234DE234A1234DE234A1234DEA1234DE234A1234DE234A1234DE234A1234DEA1234DE234A1234DE234A1234DE234A1234DE"
@@ -143,7 +144,10 @@ static SINGLYLINKEDLIST_HANDLE TEST_IN_PROGRESS_LIST;
 #define TEST_IN_PROGRESS_LIST1                            (SINGLYLINKEDLIST_HANDLE)0x4483
 #define TEST_IN_PROGRESS_LIST2                            (SINGLYLINKEDLIST_HANDLE)0x4484
 #define TEST_OPTIONHANDLER_HANDLE                         (OPTIONHANDLER_HANDLE)0x4485
-#define INDEFINITE_TIME                                   ((time_t)-1)
+#define TEST_UAMQP_MESSAGE_TEMPLATE_HANDLE                (UAMQP_MESSAGE_TEMPLATE_HANDLE)0x4486
+#define TEST_TICK_COUNTER_HANDLE                          (TICK_COUNTER_HANDLE)0x4487
+#define TEST_CURRENT_TIME_MS                              ((tickcounter_ms_t)3600000)
+#define TEST_TICK_COUNTER_MAX_MS                          ((tickcounter_ms_t)-1)
 
 static delivery_number TEST_DELIVERY_NUMBER;
 
@@ -294,6 +298,15 @@ static int TEST_messagereceiver_open(MESSAGE_RECEIVER_HANDLE message_receiver, O
 }
 
 
+static tickcounter_ms_t TEST_current_time_ms;
+static int TEST_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = TEST_current_time_ms;
+    return 0;
+}
+
+
 static TELEMETRY_MESSENGER_CONFIG g_messenger_config;
 
 static TELEMETRY_MESSENGER_CONFIG* get_messenger_config()
@@ -304,6 +317,7 @@ static TELEMETRY_MESSENGER_CONFIG* get_messenger_config()
     g_messenger_config.iothub_host_fqdn = TEST_IOTHUB_HOST_FQDN;
     g_messenger_config.on_state_changed_callback = TEST_on_state_changed_callback;
     g_messenger_config.on_state_changed_context = TEST_ON_STATE_CHANGED_CB_CONTEXT;
+    g_messenger_config.tick_counter = TEST_TICK_COUNTER_HANDLE;
     
     return &g_messenger_config;
 }
@@ -318,12 +332,12 @@ typedef struct MESSENGER_DO_WORK_EXP_CALL_PROFILE_STRUCT
 	int wait_to_send_list_length;
 	int in_progress_list_length;
 	size_t send_event_timeout_secs;
-	time_t current_time;
+	tickcounter_ms_t current_time;
 } MESSENGER_DO_WORK_EXP_CALL_PROFILE;
 
 static MESSENGER_DO_WORK_EXP_CALL_PROFILE g_do_work_profile;
 
-static MESSENGER_DO_WORK_EXP_CALL_PROFILE* get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE current_state, bool is_subscribed_for_messages, bool is_msg_rcvr_created, int wts_list_length, int ip_list_length, time_t current_time, size_t event_send_timeout_secs)
+static MESSENGER_DO_WORK_EXP_CALL_PROFILE* get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE current_state, bool is_subscribed_for_messages, bool is_msg_rcvr_created, int wts_list_length, int ip_list_length, tickcounter_ms_t current_time, size_t event_send_timeout_secs)
 {
 	memset(&g_do_work_profile, 0, sizeof(MESSENGER_DO_WORK_EXP_CALL_PROFILE));
 	g_do_work_profile.current_state = current_state;
@@ -362,8 +376,9 @@ static MESSENGER_DO_WORK_EXP_CALL_PROFILE* get_msgr_do_work_exp_call_profile(TEL
 
 static IOTHUB_MESSAGE_HANDLE saved_message_create_from_iothub_message;
 static int TEST_message_create_from_iothub_message_return;
-static int TEST_message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
+static int TEST_message_create_from_iothub_message_with_template(UAMQP_MESSAGE_TEMPLATE_HANDLE message_template, IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
 {
+    (void)message_template;
     saved_message_create_from_iothub_message = iothub_message;
 
     if (TEST_message_create_from_iothub_message_return == 0)
@@ -626,6 +641,7 @@ static void set_expected_calls_for_telemetry_messenger_create(TELEMETRY_MESSENGE
     STRICT_EXPECTED_CALL(STRING_construct(config->iothub_host_fqdn)).SetReturn(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE);
 	STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(TEST_WAIT_TO_SEND_LIST);
 	STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(TEST_IN_PROGRESS_LIST);
+	STRICT_EXPECTED_CALL(uamqp_message_template_create());
 }
 
 static void set_expected_calls_for_attach_device_client_type_to_link(LINK_HANDLE link_handle, int amqpvalue_set_map_value_result, int link_set_attach_properties_result)
@@ -897,7 +913,7 @@ static void set_expected_calls_for_on_message_send_complete()
 	EXPECTED_CALL(free(IGNORED_PTR_ARG));
 }
 
-static void set_expected_calls_for_message_do_work_send_pending_events(int number_of_events_pending, time_t current_time)
+static void set_expected_calls_for_message_do_work_send_pending_events(int number_of_events_pending)
 {
 	int i;
 	for (i = 0; i < number_of_events_pending; i++)
@@ -907,12 +923,11 @@ static void set_expected_calls_for_message_do_work_send_pending_events(int numbe
 		STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_WAIT_TO_SEND_LIST, IGNORED_PTR_ARG)).IgnoreArgument(2);
 		STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG)).IgnoreArgument(2);
 
-        STRICT_EXPECTED_CALL(message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
-            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(message_create_from_iothub_message_with_template(TEST_UAMQP_MESSAGE_TEMPLATE_HANDLE, TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(3);
 
         STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
-		STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
 
         EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG));
     }
@@ -920,25 +935,7 @@ static void set_expected_calls_for_message_do_work_send_pending_events(int numbe
 	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
 }
 
-static time_t add_seconds(time_t base_time, int seconds)
-{
-	time_t new_time;
-	struct tm *bd_new_time;
-
-	if ((bd_new_time = localtime(&base_time)) == NULL)
-	{
-		new_time = INDEFINITE_TIME;
-	}
-	else
-	{
-		bd_new_time->tm_sec += seconds;
-		new_time = mktime(bd_new_time);
-	}
-
-	return new_time;
-}
-
-static void set_expected_calls_for_process_event_send_timeouts(size_t in_progress_list_length, size_t send_event_timeout_secs, time_t current_time)
+static void set_expected_calls_for_process_event_send_timeouts(size_t in_progress_list_length)
 {
 	if (in_progress_list_length <= 0)
 	{
@@ -946,24 +943,24 @@ static void set_expected_calls_for_process_event_send_timeouts(size_t in_progres
 	}
 	else
 	{
-		time_t send_time = add_seconds(current_time, -1 * (int)send_event_timeout_secs);
-
 		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST));
 		
 		for (; in_progress_list_length > 0; in_progress_list_length--)
 		{
 			EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-			STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
-			EXPECTED_CALL(get_difftime(current_time, send_time)).SetReturn(difftime(current_time, send_time));
 			EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
 		}
-
-		EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG)).SetReturn(NULL);
 	}
 }
 
 static void set_expected_calls_for_telemetry_messenger_do_work(MESSENGER_DO_WORK_EXP_CALL_PROFILE *profile)
 {
+	if (profile->current_state == TELEMETRY_MESSENGER_STATE_STARTING || profile->current_state == TELEMETRY_MESSENGER_STATE_STARTED)
+	{
+		TEST_current_time_ms = profile->current_time;
+		STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+	}
+
 	if (profile->current_state == TELEMETRY_MESSENGER_STATE_STARTING)
 	{
 		set_expected_calls_for_message_sender_create();
@@ -979,9 +976,9 @@ static void set_expected_calls_for_telemetry_messenger_do_work(MESSENGER_DO_WORK
 			set_expected_calls_for_message_receiver_destroy();
 		}
 
-		set_expected_calls_for_process_event_send_timeouts(profile->in_progress_list_length, profile->send_event_timeout_secs, profile->current_time);
+		set_expected_calls_for_process_event_send_timeouts(profile->in_progress_list_length);
 
-		set_expected_calls_for_message_do_work_send_pending_events(profile->wait_to_send_list_length, profile->current_time);
+		set_expected_calls_for_message_do_work_send_pending_events(profile->wait_to_send_list_length);
 	}
 }
 
@@ -991,7 +988,7 @@ static void set_expected_calls_for_telemetry_messenger_destroy(TELEMETRY_MESSENG
 
 	set_expected_calls_for_telemetry_messenger_stop(wait_to_send_list_length, in_progress_list_length, destroy_message_receiver);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STOPPING, false, false, wait_to_send_list_length, in_progress_list_length, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	do_work_profile->destroy_message_sender = destroy_message_sender;
@@ -1017,6 +1014,8 @@ static void set_expected_calls_for_telemetry_messenger_destroy(TELEMETRY_MESSENG
 	STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_WAIT_TO_SEND_LIST));
 	STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_IN_PROGRESS_LIST));
 
+	STRICT_EXPECTED_CALL(uamqp_message_template_destroy(TEST_UAMQP_MESSAGE_TEMPLATE_HANDLE));
+
 	STRICT_EXPECTED_CALL(STRING_delete(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE));
 	STRICT_EXPECTED_CALL(STRING_delete(TEST_DEVICE_ID_STRING_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
@@ -1120,13 +1119,11 @@ static void crank_telemetry_messenger_do_work(TELEMETRY_MESSENGER_HANDLE handle,
 
 	if (profile->create_message_sender && saved_messagesender_create_on_message_sender_state_changed != NULL)
 	{
-		STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(profile->current_time);
 		saved_messagesender_create_on_message_sender_state_changed(saved_messagesender_create_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_IDLE);
 	}
 
 	if (profile->create_message_receiver && saved_messagereceiver_create_on_message_receiver_state_changed != NULL)
 	{
-		STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(profile->current_time);
 		saved_messagereceiver_create_on_message_receiver_state_changed(saved_messagereceiver_create_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_IDLE);
 	}
 }
@@ -1135,7 +1132,7 @@ static TELEMETRY_MESSENGER_HANDLE create_and_start_messenger2(TELEMETRY_MESSENGE
 {
 	TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger(config);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTING, false, false, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	do_work_profile->create_message_sender = true;
@@ -1196,9 +1193,10 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
-	REGISTER_UMOCK_ALIAS_TYPE(time_t, int);
+	REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(delivery_number, int);
 	REGISTER_UMOCK_ALIAS_TYPE(TELEMETRY_MESSENGER_MESSAGE_DISPOSITION_INFO, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(UAMQP_MESSAGE_TEMPLATE_HANDLE, void*);
 
     REGISTER_GLOBAL_MOCK_HOOK(malloc, TEST_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(free, TEST_free);
@@ -1206,7 +1204,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(messagesender_send, TEST_messagesender_send);
     REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_create, TEST_messagereceiver_create);
     REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_open, TEST_messagereceiver_open);
-    REGISTER_GLOBAL_MOCK_HOOK(message_create_from_iothub_message, TEST_message_create_from_iothub_message);
+    REGISTER_GLOBAL_MOCK_HOOK(message_create_from_iothub_message_with_template, TEST_message_create_from_iothub_message_with_template);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromUamqpMessage, TEST_IoTHubMessage_CreateFromUamqpMessage);
 	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, TEST_singlylinkedlist_add);
 	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, TEST_singlylinkedlist_get_head_item);
@@ -1215,6 +1213,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, TEST_singlylinkedlist_get_next_item);
 	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, TEST_singlylinkedlist_find);
 	REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_get_link_name, TEST_messagereceiver_get_link_name);
+	REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, TEST_tickcounter_get_current_ms);
 
 	REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_remove, 0);
 	REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_remove, 555);
@@ -1252,8 +1251,11 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(messagereceiver_open, 0);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(messagereceiver_open, 1);
 
-    REGISTER_GLOBAL_MOCK_RETURN(message_create_from_iothub_message, 0);
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_create_from_iothub_message, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(message_create_from_iothub_message_with_template, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_create_from_iothub_message_with_template, 1);
+
+    REGISTER_GLOBAL_MOCK_RETURN(uamqp_message_template_create, TEST_UAMQP_MESSAGE_TEMPLATE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(uamqp_message_template_create, NULL);
 
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_map, TEST_LINK_ATTACH_PROPERTIES);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_create_map, NULL);
@@ -1303,6 +1305,8 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_AddOption, OPTIONHANDLER_OK);
 	REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_AddOption, OPTIONHANDLER_ERROR);
 
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, 1);
+
 	TEST_IOTHUB_MESSAGE_LIST_HANDLE = (IOTHUB_MESSAGE_LIST*)real_malloc(sizeof(IOTHUB_MESSAGE_LIST));
 	ASSERT_IS_NOT_NULL(TEST_IOTHUB_MESSAGE_LIST_HANDLE);
 	TEST_IOTHUB_MESSAGE_LIST_HANDLE->messageHandle = TEST_IOTHUB_MESSAGE_HANDLE;
@@ -1382,6 +1386,7 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 
 	TEST_DELIVERY_NUMBER = (delivery_number)1234;
 	TEST_messagereceiver_get_link_name_link_name = TEST_MESSAGE_RECEIVER_LINK_NAME_CHAR_PTR;
+	TEST_current_time_ms = TEST_CURRENT_TIME_MS;
 }
 
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -1443,11 +1448,32 @@ TEST_FUNCTION(telemetry_messenger_create_config_NULL_iothub_host_fqdn)
     // cleanup
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_193: [If `messenger_config->tick_counter` is NULL, telemetry_messenger_create() shall return NULL]
+TEST_FUNCTION(telemetry_messenger_create_config_NULL_tick_counter)
+{
+    // arrange
+    TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+    config->tick_counter = NULL;
+
+    umock_c_reset_all_calls();
+
+    // act
+    TELEMETRY_MESSENGER_HANDLE handle = telemetry_messenger_create(config, TEST_DEVICE_ID);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, handle, NULL);
+
+    // cleanup
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_006: [telemetry_messenger_create() shall allocate memory for the messenger instance structure (aka `instance`)]  
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_194: [telemetry_messenger_create() shall save `messenger_config->tick_counter` into `instance->tick_counter`, without taking ownership of it]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_008: [telemetry_messenger_create() shall save a copy of `messenger_config->device_id` into `instance->device_id`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_010: [telemetry_messenger_create() shall save a copy of `messenger_config->iothub_host_fqdn` into `instance->iothub_host_fqdn`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_165: [`instance->wait_to_send_list` shall be set using singlylinkedlist_create()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_132: [`instance->in_progress_list` shall be set using singlylinkedlist_create()]   
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_190: [`instance->message_template` shall be set using uamqp_message_template_create()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_013: [`messenger_config->on_state_changed_callback` shall be saved into `instance->on_state_changed_callback`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_014: [`messenger_config->on_state_changed_context` shall be saved into `instance->on_state_changed_context`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_015: [If no failures occurr, telemetry_messenger_create() shall return a handle to `instance`]
@@ -1475,6 +1501,7 @@ TEST_FUNCTION(telemetry_messenger_create_success)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_011: [If STRING_construct() fails, telemetry_messenger_create() shall fail and return NULL] 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_166: [If singlylinkedlist_create() fails, telemetry_messenger_create() shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_133: [If singlylinkedlist_create() fails, telemetry_messenger_create() shall fail and return NULL]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_191: [If uamqp_message_template_create() fails, telemetry_messenger_create() shall fail and return NULL]
 TEST_FUNCTION(telemetry_messenger_create_failure_checks)
 {
     // arrange
@@ -1600,7 +1627,7 @@ TEST_FUNCTION(messenger_state_on_event_sender_state_changed_callback_OPEN)
 	TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
 	TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger(config);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTING, false, false, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	set_expected_calls_for_telemetry_messenger_do_work(do_work_profile);
@@ -1627,7 +1654,7 @@ TEST_FUNCTION(messenger_state_on_event_sender_state_changed_callback_ERROR)
     TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
     TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger(config);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTING, false, false, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	set_expected_calls_for_telemetry_messenger_do_work(do_work_profile);
 	telemetry_messenger_do_work(handle);
@@ -1732,6 +1759,7 @@ TEST_FUNCTION(telemetry_messenger_destroy_NULL_handle)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_110: [If the `instance->state` is not TELEMETRY_MESSENGER_STATE_STOPPED, telemetry_messenger_destroy() shall invoke telemetry_messenger_stop() and telemetry_messenger_do_work() once]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_111: [All elements of `instance->in_progress_list` and `instance->wait_to_send_list` shall be removed, invoking `task->on_event_send_complete_callback` for each with TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_150: [`instance->in_progress_list` and `instance->wait_to_send_list` shall be destroyed using singlylinkedlist_destroy()]  
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_192: [`instance->message_template` shall be destroyed using uamqp_message_template_destroy()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_112: [`instance->iothub_host_fqdn` shall be destroyed using STRING_delete()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_113: [`instance->device_id` shall be destroyed using STRING_delete()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_114: [telemetry_messenger_destroy() shall destroy `instance` with free()] 
@@ -1743,7 +1771,7 @@ TEST_FUNCTION(telemetry_messenger_destroy_succeeds)
 
 	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE* mdecp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, true, true, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	crank_telemetry_messenger_do_work(handle, mdecp);
 
@@ -1770,7 +1798,7 @@ TEST_FUNCTION(telemetry_messenger_destroy_FAIL_TO_ROLLBACK_EVENTS)
 
 	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE* mdecp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, true, true, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	crank_telemetry_messenger_do_work(handle, mdecp);
 
@@ -1842,7 +1870,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_not_started)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_053: [`instance->message_sender` shall be opened using messagesender_open()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_055: [Before returning, telemetry_messenger_do_work() shall release all the temporary memory it has allocated]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_153: [telemetry_messenger_do_work() shall move each event to be sent from `instance->wait_to_send_list` to `instance->in_progress_list`]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_154: [A MESSAGE_HANDLE shall be obtained out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message()]  
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_154: [A MESSAGE_HANDLE shall be obtained out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message_with_template(), passing `instance->message_template`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_157: [The MESSAGE_HANDLE shall be submitted for sending using messagesender_send(), passing `internal_on_event_send_complete_callback`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_159: [The MESSAGE_HANDLE shall be destroyed using message_destroy().] 
 TEST_FUNCTION(telemetry_messenger_do_work_send_events_success)
@@ -1854,7 +1882,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_send_events_success)
 	set_expected_calls_for_telemetry_messenger_send_async();
 	int result = telemetry_messenger_send_async(handle, TEST_IOTHUB_MESSAGE_LIST_HANDLE, TEST_on_event_send_complete, TEST_IOTHUB_CLIENT_HANDLE);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 
 	umock_c_reset_all_calls();
@@ -1891,7 +1919,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_create_message_receiver)
 
     (void)telemetry_messenger_subscribe_for_messages(handle, TEST_on_new_message_received_callback, TEST_ON_NEW_MESSAGE_RECEIVED_CB_CONTEXT);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, true, false, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	umock_c_reset_all_calls();
 	set_expected_calls_for_telemetry_messenger_do_work(do_work_profile);
@@ -2029,14 +2057,13 @@ TEST_FUNCTION(messenger_state_on_message_receiver_state_changed_callback_ERROR)
     TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
     TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger2(config, true);
 
-	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(time(NULL));
-
     // act
     ASSERT_IS_NOT_NULL(saved_messagereceiver_create_on_message_receiver_state_changed);
 
     saved_messagereceiver_create_on_message_receiver_state_changed(saved_messagereceiver_create_context, MESSAGE_RECEIVER_STATE_ERROR, MESSAGE_RECEIVER_STATE_OPEN);
 	
 	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
 	telemetry_messenger_do_work(handle);
 
     // assert
@@ -2063,7 +2090,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_destroy_message_receiver)
 
     (void)telemetry_messenger_unsubscribe_for_messages(handle);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, true, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	umock_c_reset_all_calls();
 	set_expected_calls_for_telemetry_messenger_do_work(do_work_profile);
@@ -2089,7 +2116,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_on_event_send_complete_OK)
 
 	send_events(handle, 1);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *mdwp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	crank_telemetry_messenger_do_work(handle, mdwp);
 
@@ -2122,7 +2149,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_on_event_send_complete_ERROR)
 
 	send_events(handle, 1);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *mdwp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	crank_telemetry_messenger_do_work(handle, mdwp);
 
@@ -2155,6 +2182,7 @@ TEST_FUNCTION(telemetry_messenger_do_work_send_events_message_create_from_iothub
 	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
 	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
 	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
 	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
 	EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
@@ -2162,8 +2190,8 @@ TEST_FUNCTION(telemetry_messenger_do_work_send_events_message_create_from_iothub
 		.IgnoreArgument(2);
 	STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG))
 		.IgnoreArgument(2);
-	STRICT_EXPECTED_CALL(message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
-		.IgnoreArgument(2).SetReturn(1);
+	STRICT_EXPECTED_CALL(message_create_from_iothub_message_with_template(TEST_UAMQP_MESSAGE_TEMPLATE_HANDLE, TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument(3).SetReturn(1);
 	STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
 		.IgnoreArgument_match_context()
 		.IgnoreArgument_match_function();
@@ -2203,6 +2231,8 @@ TEST_FUNCTION(telemetry_messenger_do_work_send_events_messagesender_send_fails)
 		ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
 		umock_c_reset_all_calls();
+		STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
 		// timeout checks
 		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
 		
@@ -2213,11 +2243,10 @@ TEST_FUNCTION(telemetry_messenger_do_work_send_events_messagesender_send_fails)
 			.IgnoreArgument(2);
 		STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG))
 			.IgnoreArgument(2);
-		STRICT_EXPECTED_CALL(message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
-			.IgnoreArgument(2);
+		STRICT_EXPECTED_CALL(message_create_from_iothub_message_with_template(TEST_UAMQP_MESSAGE_TEMPLATE_HANDLE, TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+			.IgnoreArgument(3);
 		STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
 			.IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4).SetReturn(1);
-		EXPECTED_CALL(get_time(NULL)).SetReturn(INDEFINITE_TIME);
 		EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG));
 		STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
 			.IgnoreArgument_match_function()
@@ -2246,6 +2275,143 @@ TEST_FUNCTION(telemetry_messenger_do_work_send_events_messagesender_send_fails)
     telemetry_messenger_destroy(handle);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_195: [If `instance->state` is TELEMETRY_MESSENGER_STATE_STARTING or TELEMETRY_MESSENGER_STATE_STARTED, telemetry_messenger_do_work() shall read the current time once from `instance->tick_counter` using tickcounter_get_current_ms()]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_196: [If tickcounter_get_current_ms() fails, `instance->state` shall be set to TELEMETRY_MESSENGER_STATE_ERROR and telemetry_messenger_do_work() shall return]
+TEST_FUNCTION(telemetry_messenger_do_work_tickcounter_get_current_ms_fails)
+{
+    // arrange
+    TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+    TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+    ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    telemetry_messenger_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_STATE_STARTED, saved_on_state_changed_callback_previous_state);
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_STATE_ERROR, saved_on_state_changed_callback_new_state);
+
+    // cleanup
+    telemetry_messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_197: [An event in `instance->in_progress_list` shall time out once the milliseconds elapsed since it was sent reach `instance->event_send_timeout_secs` times 1000, even if the tick counter wrapped around in between]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_198: [When an event times out, `task->on_event_send_complete_callback` shall be invoked with result TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT]
+TEST_FUNCTION(telemetry_messenger_do_work_event_send_timeout_succeeds)
+{
+    // arrange
+    TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+    TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+    ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+    MESSENGER_DO_WORK_EXP_CALL_PROFILE *mdwp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, TEST_CURRENT_TIME_MS, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+    crank_telemetry_messenger_do_work(handle, mdwp);
+
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = TEST_CURRENT_TIME_MS + DEFAULT_EVENT_SEND_TIMEOUT_SECS * 1000 - 1;
+    telemetry_messenger_do_work(handle);
+    ASSERT_IS_NULL(TEST_on_event_send_complete_message);
+
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = TEST_CURRENT_TIME_MS + DEFAULT_EVENT_SEND_TIMEOUT_SECS * 1000;
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    set_expected_calls_for_process_event_send_timeouts(1);
+    set_expected_calls_for_message_do_work_send_pending_events(0);
+
+    // act
+    telemetry_messenger_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, TEST_IOTHUB_MESSAGE_LIST_HANDLE, TEST_on_event_send_complete_message);
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, TEST_on_event_send_complete_result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_IOTHUB_CLIENT_HANDLE, TEST_on_event_send_complete_context);
+
+    // cleanup
+    telemetry_messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_197: [An event in `instance->in_progress_list` shall time out once the milliseconds elapsed since it was sent reach `instance->event_send_timeout_secs` times 1000, even if the tick counter wrapped around in between]
+TEST_FUNCTION(telemetry_messenger_do_work_event_send_timeout_tick_counter_wraparound)
+{
+    // arrange
+    TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+    TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+    ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+    // Event is sent 500 milliseconds before the tick counter wraps around.
+    MESSENGER_DO_WORK_EXP_CALL_PROFILE *mdwp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, TEST_TICK_COUNTER_MAX_MS - 499, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+    crank_telemetry_messenger_do_work(handle, mdwp);
+
+    // act
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = 0;
+    telemetry_messenger_do_work(handle);
+    ASSERT_IS_NULL(TEST_on_event_send_complete_message);
+
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = DEFAULT_EVENT_SEND_TIMEOUT_SECS * 1000 - 501;
+    telemetry_messenger_do_work(handle);
+    ASSERT_IS_NULL(TEST_on_event_send_complete_message);
+
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = DEFAULT_EVENT_SEND_TIMEOUT_SECS * 1000 - 500;
+    telemetry_messenger_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_IOTHUB_MESSAGE_LIST_HANDLE, TEST_on_event_send_complete_message);
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, TEST_on_event_send_complete_result);
+
+    // cleanup
+    telemetry_messenger_destroy(handle);
+}
+
+TEST_FUNCTION(telemetry_messenger_do_work_message_sender_start_timeout_tick_counter_wraparound)
+{
+    // arrange
+    TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+    TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger(config);
+
+    // messagesender starts opening 100 milliseconds before the tick counter wraps around.
+    MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTING, false, false, 0, 0, TEST_TICK_COUNTER_MAX_MS - 99, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+    umock_c_reset_all_calls();
+    set_expected_calls_for_telemetry_messenger_do_work(do_work_profile);
+    telemetry_messenger_do_work(handle);
+
+    ASSERT_IS_NOT_NULL(saved_messagesender_create_on_message_sender_state_changed);
+    saved_messagesender_create_on_message_sender_state_changed(saved_messagesender_create_context, MESSAGE_SENDER_STATE_OPENING, MESSAGE_SENDER_STATE_IDLE);
+
+    // act
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = 100;
+    telemetry_messenger_do_work(handle);
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_STATE_STARTING, saved_on_state_changed_callback_new_state);
+
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS * 1000 - 101;
+    telemetry_messenger_do_work(handle);
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_STATE_STARTING, saved_on_state_changed_callback_new_state);
+
+    umock_c_reset_all_calls();
+    TEST_current_time_ms = MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS * 1000 - 100;
+    telemetry_messenger_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_STATE_STARTING, saved_on_state_changed_callback_previous_state);
+    ASSERT_ARE_EQUAL(int, TELEMETRY_MESSENGER_STATE_ERROR, saved_on_state_changed_callback_new_state);
+
+    // cleanup
+    telemetry_messenger_destroy(handle);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_016: [If `messenger_handle` is NULL, telemetry_messenger_subscribe_for_messages() shall fail and return __FAILURE__]  
 TEST_FUNCTION(telemetry_messenger_subscribe_for_messages_NULL_handle)
 {
@@ -2484,7 +2650,7 @@ TEST_FUNCTION(telemetry_messenger_unsubscribe_for_messages_success)
     // act
     int unsubscription_result = telemetry_messenger_unsubscribe_for_messages(handle);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, true, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	crank_telemetry_messenger_do_work(handle, do_work_profile);
 
@@ -2643,7 +2809,7 @@ TEST_FUNCTION(telemetry_messenger_get_send_status_BUSY_succeeds)
 	TELEMETRY_MESSENGER_SEND_STATUS send_status_wts;
 	int result_wts = telemetry_messenger_get_send_status(handle, &send_status_wts);
 
-	time_t current_time = time(NULL);
+	tickcounter_ms_t current_time = TEST_CURRENT_TIME_MS;
 	MESSENGER_DO_WORK_EXP_CALL_PROFILE *mdwp = get_msgr_do_work_exp_call_profile(TELEMETRY_MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
 	crank_telemetry_messenger_do_work(handle, mdwp);
 
@@ -2736,6 +2902,28 @@ TEST_FUNCTION(telemetry_messenger_set_option_EVENT_SEND_TIMEOUT_SECS)
 	telemetry_messenger_destroy(handle);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_201: [If name matches MESSENGER_OPTION_MESSAGE_POOL_SIZE, `value` shall be set as the number of tasks kept for reuse using slab_set_max_free_elements()]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_172: [If no errors occur, telemetry_messenger_set_option shall return 0]
+TEST_FUNCTION(telemetry_messenger_set_option_MESSAGE_POOL_SIZE)
+{
+	// arrange
+	TELEMETRY_MESSENGER_CONFIG* config = get_messenger_config();
+	TELEMETRY_MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+	size_t value = 16;
+	umock_c_reset_all_calls();
+
+	// act
+	int result = telemetry_messenger_set_option(handle, MESSENGER_OPTION_MESSAGE_POOL_SIZE, &value);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	telemetry_messenger_destroy(handle);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_169: [If name matches MESSENGER_OPTION_SAVED_OPTIONS, `value` shall be applied using OptionHandler_FeedOptions]
 TEST_FUNCTION(telemetry_messenger_set_option_SAVED_OPTIONS)
 {
@@ -41,7 +41,6 @@ void real_free(void* ptr)
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/agenttime.h" 
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/uniqueid.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
@@ -115,7 +114,10 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_MSG_ANNOTATIONS_AMQP_VALUE                      (AMQP_VALUE)0x4491
 #define TEST_PROPERTIES_HANDLE                               (PROPERTIES_HANDLE)0x4492
 
-#define INDEFINITE_TIME                                      ((time_t)-1)
+#define TEST_TICK_COUNTER_HANDLE                             (TICK_COUNTER_HANDLE)0x4493
+#define TEST_CURRENT_TIME_MS                                 ((tickcounter_ms_t)3600000)
+#define TEST_TICK_COUNTER_MAX_MS                             ((tickcounter_ms_t)-1)
+#define DEFAULT_TWIN_OPERATION_TIMEOUT_MS                    300000
 #define DEFAULT_TWIN_SEND_LINK_SOURCE_NAME                   "twin"
 #define DEFAULT_TWIN_RECEIVE_LINK_TARGET_NAME                "twin"
 
@@ -143,11 +145,7 @@ static const char* TWIN_OPERATION_DELETE = "DELETE";
 static const unsigned char* TWIN_REPORTED_PROPERTIES = (const unsigned char*)"{ \"reportedStateProperty0\": \"reportedStateProperty0\", \"reportedStateProperty1\": \"reportedStateProperty1\" }";
 static int TWIN_REPORTED_PROPERTIES_LENGTH = 117;
 
-static time_t g_initial_time;
-static time_t g_initial_time_plus_30_secs;
-static time_t g_initial_time_plus_60_secs;
-static time_t g_initial_time_plus_90_secs;
-static time_t g_initial_time_plus_300_secs;
+static tickcounter_ms_t TEST_current_time_ms;
 
 static CONSTBUFFER TEST_CONSTBUFFER;
 
@@ -243,6 +241,23 @@ static AMQP_MESSENGER_HANDLE TEST_amqp_messenger_create(const AMQP_MESSENGER_CON
 	return TEST_amqp_messenger_create_return;
 }
 
+static ON_AMQP_MESSENGER_MESSAGE_RECEIVED TEST_amqp_messenger_subscribe_for_messages_on_message_received_callback;
+static void* TEST_amqp_messenger_subscribe_for_messages_context;
+static int TEST_amqp_messenger_subscribe_for_messages(AMQP_MESSENGER_HANDLE messenger_handle, ON_AMQP_MESSENGER_MESSAGE_RECEIVED on_message_received_callback, void* context)
+{
+	(void)messenger_handle;
+	TEST_amqp_messenger_subscribe_for_messages_on_message_received_callback = on_message_received_callback;
+	TEST_amqp_messenger_subscribe_for_messages_context = context;
+	return 0;
+}
+
+static char TEST_amqpvalue_create_string_last_value[64];
+static AMQP_VALUE TEST_amqpvalue_create_string(const char* value)
+{
+	(void)snprintf(TEST_amqpvalue_create_string_last_value, sizeof(TEST_amqpvalue_create_string_last_value), "%s", value);
+	return TEST_STRING_AMQP_VALUE;
+}
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -270,22 +285,11 @@ extern "C"
 #endif
 
 
-static time_t add_seconds(time_t base_time, int seconds)
+static int TEST_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
 {
-	time_t new_time;
-	struct tm *bd_new_time;
-
-	if ((bd_new_time = localtime(&base_time)) == NULL)
-	{
-		new_time = INDEFINITE_TIME;
-	}
-	else
-	{
-		bd_new_time->tm_sec += seconds;
-		new_time = mktime(bd_new_time);
-	}
-
-	return new_time;
+	(void)tick_counter;
+	*current_ms = TEST_current_time_ms;
+	return 0;
 }
 
 // ---------- Callbacks ---------- //
@@ -362,7 +366,7 @@ static void TEST_on_report_state_complete_callback(TWIN_REPORT_STATE_RESULT resu
 
 typedef struct DOWORK_TEST_PROFILE_TAG
 {
-	time_t current_time;
+	tickcounter_ms_t current_time;
 	TWIN_MESSENGER_STATE current_state;
 	TWIN_SUBSCRIPTION_STATE subscription_state;
 	size_t number_of_pending_patches;
@@ -373,7 +377,7 @@ typedef struct DOWORK_TEST_PROFILE_TAG
 
 static void reset_dowork_test_profile(DOWORK_TEST_PROFILE* dwtp)
 {
-	dwtp->current_time = g_initial_time;
+	dwtp->current_time = TEST_CURRENT_TIME_MS;
 	dwtp->current_state = TWIN_MESSENGER_STATE_STOPPED;
 	dwtp->subscription_state = TWIN_SUBSCRIPTION_STATE_NOT_SUBSCRIBED;
 	dwtp->number_of_pending_patches = 0;
@@ -385,30 +389,12 @@ static void reset_dowork_test_profile(DOWORK_TEST_PROFILE* dwtp)
 
 // ---------- Expected Calls ---------- //
 
-static void set_generate_unique_id_expected_calls()
-{
-	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-	STRICT_EXPECTED_CALL(UniqueId_Generate(IGNORED_PTR_ARG, UNIQUE_ID_BUFFER_SIZE));
-}
-
-static void set_generate_twin_correlation_id_expected_calls()
-{
-	set_generate_unique_id_expected_calls();
-	//STRICT_EXPECTED_CALL(strlen(IGNORED_NUM_ARG));
-	//STRICT_EXPECTED_CALL(strlen(IGNORED_NUM_ARG));
-	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-	// sprintf
-	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
-}
-
 static void set_create_link_attach_properties_expected_calls(TWIN_MESSENGER_CONFIG* config)
 {
 	STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(TEST_ATTACH_PROPERTIES);
-	set_generate_twin_correlation_id_expected_calls();
 	STRICT_EXPECTED_CALL(Map_Add(TEST_ATTACH_PROPERTIES, CLIENT_VERSION_PROPERTY_NAME, config->client_version));
 	STRICT_EXPECTED_CALL(Map_Add(TEST_ATTACH_PROPERTIES, TWIN_CORRELATION_ID_PROPERTY_NAME, IGNORED_PTR_ARG));
 	STRICT_EXPECTED_CALL(Map_Add(TEST_ATTACH_PROPERTIES, TWIN_API_VERSION_PROPERTY_NAME, TWIN_API_VERSION_NUMBER));
-	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
 }
 
 static void set_destroy_link_attach_properties_expected_calls()
@@ -425,8 +411,11 @@ static void set_expected_calls_for_twin_messenger_create(TWIN_MESSENGER_CONFIG*
 		.CopyOutArgumentBuffer(1, &config->device_id, sizeof(config->device_id));
 	STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, config->iothub_host_fqdn))
 		.CopyOutArgumentBuffer(1, &config->iothub_host_fqdn, sizeof(config->iothub_host_fqdn));
+	STRICT_EXPECTED_CALL(UniqueId_Generate(IGNORED_PTR_ARG, UNIQUE_ID_BUFFER_SIZE))
+		.CopyOutArgumentBuffer(1, TEST_UNIQUE_ID, UNIQUE_ID_BUFFER_SIZE);
 	STRICT_EXPECTED_CALL(singlylinkedlist_create());
 	STRICT_EXPECTED_CALL(singlylinkedlist_create());
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
 	set_create_link_attach_properties_expected_calls(config);
 
@@ -436,12 +425,13 @@ static void set_expected_calls_for_twin_messenger_create(TWIN_MESSENGER_CONFIG*
 	set_destroy_link_attach_properties_expected_calls();
 }
 
-static void set_twin_messenger_report_state_async_expected_calls(CONSTBUFFER_HANDLE report, time_t current_time)
+static void set_twin_messenger_report_state_async_expected_calls(CONSTBUFFER_HANDLE report, tickcounter_ms_t current_time)
 {
+	TEST_current_time_ms = current_time;
+
 	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 	STRICT_EXPECTED_CALL(CONSTBUFFER_Clone(report));
-	STRICT_EXPECTED_CALL(get_time(NULL))
-		.SetReturn(current_time);
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
 	STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 }
 
@@ -460,47 +450,30 @@ static void set_twin_messenger_retrieve_options_expected_calls()
 	STRICT_EXPECTED_CALL(amqp_messenger_retrieve_options(TEST_AMQP_MESSENGER_HANDLE));
 }
 
-static void set_process_timeouts_expected_calls(time_t current_time, size_t number_of_pending_patches, size_t number_of_expired_pending_patches, size_t number_of_pending_operations, size_t number_of_expired_pending_operations)
+// Expiration is computed by the messenger against `TEST_current_time_ms`, so callers must pick a current time consistent with the expired counts.
+static void set_process_timeouts_expected_calls(size_t number_of_expired_pending_patches, size_t number_of_expired_pending_operations)
 {
 	size_t i;
 
-	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
 	STRICT_EXPECTED_CALL(singlylinkedlist_remove_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
 	for (i = 0; i < number_of_expired_pending_patches; i++)
 	{
-		STRICT_EXPECTED_CALL(get_difftime(current_time, IGNORED_NUM_ARG)).SetReturn(10000000); // Simulate it's expired for sure.
 		STRICT_EXPECTED_CALL(CONSTBUFFER_Destroy(IGNORED_PTR_ARG));
 		STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
 	}
 
-	if (number_of_pending_patches > number_of_expired_pending_patches)
-	{
-		STRICT_EXPECTED_CALL(get_difftime(current_time, IGNORED_NUM_ARG)).SetReturn(0); // Simulate it's not expired.
-	}
-
-
 	STRICT_EXPECTED_CALL(singlylinkedlist_remove_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
 	for (i = 0; i < number_of_expired_pending_operations; i++)
 	{
-		STRICT_EXPECTED_CALL(get_difftime(current_time, IGNORED_NUM_ARG)).SetReturn(10000000); // Simulate it's expired for sure.
-		STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // correlation id
 		STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
 	}
-
-	if (number_of_pending_operations > number_of_expired_pending_operations)
-	{
-		STRICT_EXPECTED_CALL(get_difftime(current_time, IGNORED_NUM_ARG)).SetReturn(0); // Simulate it's not expired.
-	}
-
-
 }
 
 static void set_create_twin_operation_context_expected_calls()
 {
 	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-	set_generate_unique_id_expected_calls();
 }
 
 static void set_add_map_item_expected_calls(const char* name, const char* value)
@@ -588,16 +561,59 @@ static void set_create_amqp_message_for_twin_operation_expected_calls(TWIN_OPERA
 	STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
 }
 
-static void set_send_twin_operation_request_expected_calls(time_t current_time)
+static void set_send_twin_operation_request_expected_calls()
 {
 	set_create_amqp_message_for_twin_operation_expected_calls(TWIN_OPERATION_TYPE_PATCH);
-	STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG)).SetReturn(current_time);
 	STRICT_EXPECTED_CALL(amqp_messenger_send_async(TEST_AMQP_MESSENGER_HANDLE, TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 	STRICT_EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG));
 }
 
+static void set_on_amqp_message_received_for_response_expected_calls(const char** correlation_id, int* status_code)
+{
+	PROPERTIES_HANDLE properties = TEST_PROPERTIES_HANDLE;
+	AMQP_VALUE correlation_id_value = TEST_STRING_AMQP_VALUE;
+	annotations message_annotations = TEST_MSG_ANNOTATIONS_AMQP_VALUE;
+	uint32_t pair_count = 1;
+	AMQP_VALUE map_key = TEST_SYMBOL_AMQP_VALUE;
+	AMQP_VALUE map_value = TEST_MAP_AMQP_VALUE;
+	const char* map_key_name = TWIN_MESSAGE_PROPERTY_STATUS;
+	MESSAGE_BODY_TYPE body_type = MESSAGE_BODY_TYPE_NONE;
+
+	STRICT_EXPECTED_CALL(amqp_messenger_destroy_disposition_info(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(message_get_properties(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, &properties, sizeof(properties));
+	STRICT_EXPECTED_CALL(properties_get_correlation_id(TEST_PROPERTIES_HANDLE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, &correlation_id_value, sizeof(correlation_id_value));
+	STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_STRING_AMQP_VALUE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, correlation_id, sizeof(*correlation_id));
+	STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, *correlation_id))
+		.CopyOutArgumentBuffer(1, correlation_id, sizeof(*correlation_id));
+	STRICT_EXPECTED_CALL(properties_destroy(TEST_PROPERTIES_HANDLE));
+	STRICT_EXPECTED_CALL(message_get_message_annotations(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, &message_annotations, sizeof(message_annotations));
+	STRICT_EXPECTED_CALL(amqpvalue_get_map_pair_count(TEST_MSG_ANNOTATIONS_AMQP_VALUE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, &pair_count, sizeof(pair_count));
+	STRICT_EXPECTED_CALL(amqpvalue_get_map_key_value_pair(TEST_MSG_ANNOTATIONS_AMQP_VALUE, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(3, &map_key, sizeof(map_key))
+		.CopyOutArgumentBuffer(4, &map_value, sizeof(map_value));
+	STRICT_EXPECTED_CALL(amqpvalue_get_symbol(TEST_SYMBOL_AMQP_VALUE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, &map_key_name, sizeof(map_key_name));
+	STRICT_EXPECTED_CALL(amqpvalue_get_type(TEST_MAP_AMQP_VALUE))
+		.SetReturn(AMQP_TYPE_INT);
+	STRICT_EXPECTED_CALL(amqpvalue_get_int(TEST_MAP_AMQP_VALUE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, status_code, sizeof(*status_code));
+	STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_MAP_AMQP_VALUE));
+	STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_SYMBOL_AMQP_VALUE));
+	STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_MSG_ANNOTATIONS_AMQP_VALUE));
+	STRICT_EXPECTED_CALL(message_get_body_type(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+		.CopyOutArgumentBuffer(2, &body_type, sizeof(body_type));
+}
+
 static void set_twin_messenger_do_work_expected_calls(DOWORK_TEST_PROFILE* dwtp)
 {
+	TEST_current_time_ms = dwtp->current_time;
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
 	if (dwtp->current_state == TWIN_MESSENGER_STATE_STARTED)
 	{
 		STRICT_EXPECTED_CALL(singlylinkedlist_remove_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
@@ -608,7 +624,7 @@ static void set_twin_messenger_do_work_expected_calls(DOWORK_TEST_PROFILE* dwtp)
 
 			STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
-			set_send_twin_operation_request_expected_calls(dwtp->current_time);
+			set_send_twin_operation_request_expected_calls();
 
 			STRICT_EXPECTED_CALL(CONSTBUFFER_Destroy(IGNORED_PTR_ARG));
 			STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
@@ -618,7 +634,7 @@ static void set_twin_messenger_do_work_expected_calls(DOWORK_TEST_PROFILE* dwtp)
 		}
 	}
 
-	set_process_timeouts_expected_calls(dwtp->current_time, dwtp->number_of_pending_patches, dwtp->number_of_expired_pending_patches, dwtp->number_of_pending_operations, dwtp->number_of_expired_pending_operations);
+	set_process_timeouts_expected_calls(dwtp->number_of_expired_pending_patches, dwtp->number_of_expired_pending_operations);
 
 	STRICT_EXPECTED_CALL(amqp_messenger_do_work(TEST_AMQP_MESSENGER_HANDLE));
 }
@@ -634,6 +650,7 @@ static TWIN_MESSENGER_CONFIG* get_twin_messenger_config()
 	g_twin_msgr_config.iothub_host_fqdn = TEST_IOTHUB_HOST_FQDN;
 	g_twin_msgr_config.on_state_changed_callback = TEST_on_state_changed_callback;
 	g_twin_msgr_config.on_state_changed_context = TEST_ON_STATE_CHANGED_CB_CONTEXT;
+	g_twin_msgr_config.tick_counter = TEST_TICK_COUNTER_HANDLE;
 
 	return &g_twin_msgr_config;
 }
@@ -645,7 +662,7 @@ static TWIN_MESSENGER_HANDLE create_twin_messenger(TWIN_MESSENGER_CONFIG* config
 	return twin_messenger_create(config);
 }
 
-static void send_one_report_patch(TWIN_MESSENGER_HANDLE handle, time_t current_time)
+static void send_one_report_patch(TWIN_MESSENGER_HANDLE handle, tickcounter_ms_t current_time)
 {
 	const unsigned char* buffer = (unsigned char*)TWIN_REPORTED_PROPERTIES;
 	size_t size = TWIN_REPORTED_PROPERTIES_LENGTH;
@@ -696,8 +713,11 @@ static void register_global_mock_hooks()
 	REGISTER_GLOBAL_MOCK_HOOK(malloc, TEST_malloc);
 	REGISTER_GLOBAL_MOCK_HOOK(free, TEST_free);
 	REGISTER_GLOBAL_MOCK_HOOK(amqp_messenger_create, TEST_amqp_messenger_create);
+	REGISTER_GLOBAL_MOCK_HOOK(amqp_messenger_subscribe_for_messages, TEST_amqp_messenger_subscribe_for_messages);
+	REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_create_string, TEST_amqpvalue_create_string);
 	REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_Clone, real_CONSTBUFFER_Clone);
 	REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_Destroy, real_CONSTBUFFER_Destroy);
+	REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, TEST_tickcounter_get_current_ms);
 	REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_GetContent, real_CONSTBUFFER_GetContent);
 	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
 	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
@@ -719,6 +739,7 @@ static void register_global_mock_aliases()
 	REGISTER_UMOCK_ALIAS_TYPE(role, bool);
 	REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_HANDLE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(AMQP_TYPE, int);
 	REGISTER_UMOCK_ALIAS_TYPE(message_annotations, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(PROPERTIES_HANDLE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(BINARY_DATA, void*);
@@ -731,7 +752,7 @@ static void register_global_mock_aliases()
 	REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
-	REGISTER_UMOCK_ALIAS_TYPE(time_t, long long);
+	REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(MAP_FILTER_CALLBACK, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(AMQP_MESSENGER_HANDLE, void*);
@@ -828,8 +849,8 @@ static void register_global_mock_returns()
 	REGISTER_GLOBAL_MOCK_RETURN(UniqueId_Generate, UNIQUEID_OK);
 	REGISTER_GLOBAL_MOCK_FAIL_RETURN(UniqueId_Generate, UNIQUEID_ERROR);
 
-	// AgentTime
-	REGISTER_GLOBAL_MOCK_FAIL_RETURN(get_time, INDEFINITE_TIME);
+	// TickCounter
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, 1);
 }
 
 static void initialize_variables()
@@ -841,6 +862,9 @@ static void initialize_variables()
 
 	memset(&TEST_amqp_messenger_create_config, 0, sizeof(TEST_amqp_messenger_create_config));
 	TEST_amqp_messenger_create_return = TEST_AMQP_MESSENGER_HANDLE;
+	TEST_amqp_messenger_subscribe_for_messages_on_message_received_callback = NULL;
+	TEST_amqp_messenger_subscribe_for_messages_context = NULL;
+	TEST_amqpvalue_create_string_last_value[0] = '\0';
 
 	TEST_on_report_state_complete_callback_result = TWIN_REPORT_STATE_RESULT_SUCCESS;
 	TEST_on_report_state_complete_callback_reason = TWIN_REPORT_STATE_REASON_NONE;
@@ -859,6 +883,8 @@ static void initialize_variables()
 
 	TEST_CONSTBUFFER.buffer = TWIN_REPORTED_PROPERTIES;
 	TEST_CONSTBUFFER.size = TWIN_REPORTED_PROPERTIES_LENGTH;
+
+	TEST_current_time_ms = TEST_CURRENT_TIME_MS;
 }
 
 BEGIN_TEST_SUITE(iothubtr_amqp_twin_msgr_ut)
@@ -881,12 +907,6 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	register_global_mock_aliases();
 	register_global_mock_hooks();
 	register_global_mock_returns();
-
-	g_initial_time = time(NULL);
-	g_initial_time_plus_30_secs = add_seconds(g_initial_time, 30);
-	g_initial_time_plus_60_secs = add_seconds(g_initial_time, 60);
-	g_initial_time_plus_90_secs = add_seconds(g_initial_time, 90);
-	g_initial_time_plus_300_secs = add_seconds(g_initial_time, 300);
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -950,16 +970,39 @@ TEST_FUNCTION(twin_msgr_create_NULL_device_id)
 	twin_messenger_destroy(handle);
 }
 
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_117: [If `messenger_config->tick_counter` is NULL, twin_messenger_create() shall return NULL]  
+TEST_FUNCTION(twin_msgr_create_NULL_tick_counter)
+{
+	// arrange
+	TWIN_MESSENGER_CONFIG* config = get_twin_messenger_config();
+	config->tick_counter = NULL;
+
+	umock_c_reset_all_calls();
+
+	// act
+	TWIN_MESSENGER_HANDLE handle = twin_messenger_create(config);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_IS_NULL(handle);
+
+	// cleanup
+	twin_messenger_destroy(handle);
+}
+
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_003: [twin_messenger_create() shall allocate memory for the messenger instance structure (aka `twin_msgr`)]  
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_118: [twin_messenger_create() shall save `messenger_config->tick_counter` into `twin_msgr->tick_counter`, without taking ownership of it]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_005: [twin_messenger_create() shall save a copy of `messenger_config` info into `twin_msgr`]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_007: [`twin_msgr->pending_patches` shall be set using singlylinkedlist_create()]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_009: [`twin_msgr->operations` shall be set using singlylinkedlist_create()]  
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_109: [twin_messenger_create() shall generate a random prefix for the correlation-id of TWIN requests using UniqueId_Generate()]
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_113: [`twin_msgr->operations_index` shall be allocated with DEFAULT_TWIN_OPERATIONS_INDEX_SIZE empty buckets]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_011: [`twin_msgr->amqp_msgr` shall be set using amqp_messenger_create(), passing a AMQP_MESSENGER_CONFIG instance `amqp_msgr_config`]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_012: [`amqp_msgr_config->client_version` shall be set with `twin_msgr->client_version`]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_013: [`amqp_msgr_config->device_id` shall be set with `twin_msgr->device_id`]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_014: [`amqp_msgr_config->iothub_host_fqdn` shall be set with `twin_msgr->iothub_host_fqdn`]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_015: [`amqp_msgr_config` shall have "twin/" as send link target suffix and receive link source suffix]
-// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_016: [`amqp_msgr_config` shall have send and receive link attach properties set as "com.microsoft:client-version" = `twin_msgr->client_version`, "com.microsoft:channel-correlation-id" = `twin:<UUID>`, "com.microsoft:api-version" = "2016-11-14"]
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_016: [`amqp_msgr_config` shall have send and receive link attach properties set as "com.microsoft:client-version" = `twin_msgr->client_version`, "com.microsoft:channel-correlation-id" = `twin:<correlation-id>`, "com.microsoft:api-version" = "2016-11-14"]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_017: [`amqp_msgr_config` shall be set with `on_amqp_messenger_state_changed_callback` and `on_amqp_messenger_subscription_changed_callback` callbacks]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_019: [`twin_msgr->amqp_msgr` shall subscribe for AMQP messages by calling amqp_messenger_subscribe_for_messages() passing `on_amqp_message_received`]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_021: [If no failures occurr, twin_messenger_create() shall return a handle to `twin_msgr`] 
@@ -995,6 +1038,8 @@ TEST_FUNCTION(twin_msgr_create_success)
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_006: [If any `messenger_config` info fails to be copied, twin_messenger_create() shall fail and return NULL]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_008: [If singlylinkedlist_create() fails, twin_messenger_create() shall fail and return NULL]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_010: [If singlylinkedlist_create() fails, twin_messenger_create() shall fail and return NULL]  
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_110: [If UniqueId_Generate() fails, twin_messenger_create() shall fail and return NULL]
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_114: [If `twin_msgr->operations_index` fails to be allocated, twin_messenger_create() shall fail and return NULL]
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_018: [If amqp_messenger_create() fails, twin_messenger_create() shall fail and return NULL]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_020: [If amqp_messenger_subscribe_for_messages() fails, twin_messenger_create() shall fail and return NULL] 
 TEST_FUNCTION(twin_msgr_create_failure_checks)
@@ -1012,7 +1057,7 @@ TEST_FUNCTION(twin_msgr_create_failure_checks)
 	size_t i;
 	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
 	{
-		if (i == 10 || i == 14 || i == 17)
+		if (i == 14)
 		{
 			// These expected calls do not cause the API to fail.
 			continue;
@@ -1078,7 +1123,7 @@ TEST_FUNCTION(twin_msgr_report_state_async_NULL_data)
 
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_023: [twin_messenger_report_state_async() shall allocate memory for a TWIN_PATCH_OPERATION_CONTEXT structure (aka `twin_op_ctx`)]  
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_025: [`twin_op_ctx` shall have a copy of `data`]  
-// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_027: [`twin_op_ctx->time_enqueued` shall be set using get_time]    
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_027: [`twin_op_ctx->time_enqueued` shall be set using tickcounter_get_current_ms() on `twin_msgr->tick_counter`]    
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_029: [`twin_op_ctx` shall be added to `twin_msgr->pending_patches` using singlylinkedlist_add()]    
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_032: [If no failures occur, twin_messenger_report_state_async() shall return zero]  
 TEST_FUNCTION(twin_msgr_report_state_async_success)
@@ -1092,7 +1137,7 @@ TEST_FUNCTION(twin_msgr_report_state_async_success)
 	CONSTBUFFER_HANDLE report = real_CONSTBUFFER_Create(buffer, size);
 
 	umock_c_reset_all_calls();
-	set_twin_messenger_report_state_async_expected_calls(report, g_initial_time);
+	set_twin_messenger_report_state_async_expected_calls(report, TEST_CURRENT_TIME_MS);
 
 	// act
 	int result = twin_messenger_report_state_async(handle, report, TEST_on_report_state_complete_callback, NULL);
@@ -1124,7 +1169,7 @@ TEST_FUNCTION(twin_msgr_report_state_async_failure_checks)
 	CONSTBUFFER_HANDLE report = real_CONSTBUFFER_Create(buffer, size);
 
 	umock_c_reset_all_calls();
-	set_twin_messenger_report_state_async_expected_calls(report, g_initial_time);
+	set_twin_messenger_report_state_async_expected_calls(report, TEST_CURRENT_TIME_MS);
 	umock_c_negative_tests_snapshot();
 
 	// act
@@ -1221,7 +1266,7 @@ TEST_FUNCTION(twin_msgr_get_send_status_BUSY_pending_success)
 	TWIN_MESSENGER_HANDLE handle = create_twin_messenger(config);
 	TWIN_MESSENGER_SEND_STATUS send_status;
 
-	send_one_report_patch(handle, g_initial_time);
+	send_one_report_patch(handle, TEST_CURRENT_TIME_MS);
 
 	umock_c_reset_all_calls();
 	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
@@ -1246,7 +1291,7 @@ TEST_FUNCTION(twin_msgr_get_send_status_BUSY_in_progress_success)
 	TWIN_MESSENGER_HANDLE handle = create_and_start_twin_messenger(config);
 	TWIN_MESSENGER_SEND_STATUS send_status;
 
-	send_one_report_patch(handle, g_initial_time);
+	send_one_report_patch(handle, TEST_CURRENT_TIME_MS);
 
 	DOWORK_TEST_PROFILE dwtp;
 	reset_dowork_test_profile(&dwtp);
@@ -1506,11 +1551,12 @@ TEST_FUNCTION(twin_msgr_do_work_not_started_with_EXPIRED_pending_patches_success
 	TWIN_MESSENGER_CONFIG* config = get_twin_messenger_config();
 	TWIN_MESSENGER_HANDLE handle = create_twin_messenger(config);
 
-	send_one_report_patch(handle, g_initial_time);
-	send_one_report_patch(handle, g_initial_time);
+	send_one_report_patch(handle, TEST_CURRENT_TIME_MS);
+	send_one_report_patch(handle, TEST_CURRENT_TIME_MS);
 
 	DOWORK_TEST_PROFILE dwtp;
 	reset_dowork_test_profile(&dwtp);
+	dwtp.current_time = TEST_CURRENT_TIME_MS + DEFAULT_TWIN_OPERATION_TIMEOUT_MS;
 	dwtp.number_of_pending_patches = 2;
 	dwtp.number_of_expired_pending_patches = 2;
 
@@ -1546,7 +1592,7 @@ TEST_FUNCTION(twin_msgr_do_work_started_with_EXPIRED_in_progress_patches_success
 	TWIN_MESSENGER_CONFIG* config = get_twin_messenger_config();
 	TWIN_MESSENGER_HANDLE handle = create_and_start_twin_messenger(config);
 
-	send_one_report_patch(handle, g_initial_time);
+	send_one_report_patch(handle, TEST_CURRENT_TIME_MS);
 
 	DOWORK_TEST_PROFILE dwtp;
 	reset_dowork_test_profile(&dwtp);
@@ -1556,7 +1602,7 @@ TEST_FUNCTION(twin_msgr_do_work_started_with_EXPIRED_in_progress_patches_success
 	crank_twin_messenger_do_work(handle, config, &dwtp);
 
 	umock_c_reset_all_calls();
-	dwtp.current_time = g_initial_time_plus_300_secs;
+	dwtp.current_time = TEST_CURRENT_TIME_MS + DEFAULT_TWIN_OPERATION_TIMEOUT_MS;
 	dwtp.number_of_pending_patches = 0;
 	dwtp.number_of_pending_operations = 1;
 	dwtp.number_of_expired_pending_operations = 1;
@@ -1583,7 +1629,141 @@ TEST_FUNCTION(twin_msgr_do_work_started_with_EXPIRED_in_progress_patches_success
 	twin_messenger_destroy(handle);
 }
 
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_085: [If `message` is a success response for a PATCH request, the `on_report_state_complete_callback` shall be invoked if provided passing RESULT_SUCCESS and the status_code received]  
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_092: [The corresponding TWIN request shall be removed from `twin_msgr->operations` and destroyed]  
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_111: [Each TWIN request shall have a correlation-id made of `twin_msgr`'s prefix and a per-messenger counter, formatted as `<prefix>:<counter in hex>`]
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_112: [Each TWIN request queued into `twin_msgr->operations` shall also be indexed by its correlation-id]
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_115: [The TWIN request corresponding to `message` shall be looked up by correlation-id in the index of `twin_msgr->operations`]
+TEST_FUNCTION(twin_msgr_on_amqp_message_received_PATCH_responses_out_of_order_success)
+{
+	// arrange
+	TWIN_MESSENGER_CONFIG* config = get_twin_messenger_config();
+	TWIN_MESSENGER_HANDLE handle = create_and_start_twin_messenger(config);
+	CONSTBUFFER_HANDLE report = real_CONSTBUFFER_Create(TWIN_REPORTED_PROPERTIES, TWIN_REPORTED_PROPERTIES_LENGTH);
+	TWIN_MESSENGER_SEND_STATUS send_status;
+	char correlation_id1[64];
+	char correlation_id2[64];
+	const char* correlation_id;
+	int status_code;
+
+	DOWORK_TEST_PROFILE dwtp;
+	reset_dowork_test_profile(&dwtp);
+	dwtp.current_state = TWIN_MESSENGER_STATE_STARTED;
+
+	umock_c_reset_all_calls();
+	set_twin_messenger_report_state_async_expected_calls(report, TEST_CURRENT_TIME_MS);
+	(void)twin_messenger_report_state_async(handle, report, TEST_on_report_state_complete_callback, (void*)0x4501);
+	dwtp.number_of_pending_patches = 1;
+	crank_twin_messenger_do_work(handle, config, &dwtp);
+	(void)strcpy(correlation_id1, TEST_amqpvalue_create_string_last_value);
+
+	umock_c_reset_all_calls();
+	set_twin_messenger_report_state_async_expected_calls(report, TEST_CURRENT_TIME_MS);
+	(void)twin_messenger_report_state_async(handle, report, TEST_on_report_state_complete_callback, (void*)0x4502);
+	dwtp.number_of_pending_patches = 1;
+	crank_twin_messenger_do_work(handle, config, &dwtp);
+	(void)strcpy(correlation_id2, TEST_amqpvalue_create_string_last_value);
+
+	ASSERT_ARE_NOT_EQUAL(int, 0, strcmp(correlation_id1, correlation_id2));
+
+	// act
+	umock_c_reset_all_calls();
+	correlation_id = correlation_id2;
+	status_code = 204;
+	set_on_amqp_message_received_for_response_expected_calls(&correlation_id, &status_code);
+	(void)TEST_amqp_messenger_subscribe_for_messages_on_message_received_callback(TEST_MESSAGE_HANDLE, NULL, TEST_amqp_messenger_subscribe_for_messages_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, TEST_on_report_state_complete_callback_result_SUCCESS_count);
+	ASSERT_ARE_EQUAL(int, 204, TEST_on_report_state_complete_callback_status_code);
+	ASSERT_ARE_EQUAL(void_ptr, (void*)0x4502, TEST_on_report_state_complete_callback_context);
+
+	// act
+	umock_c_reset_all_calls();
+	correlation_id = correlation_id1;
+	status_code = 200;
+	set_on_amqp_message_received_for_response_expected_calls(&correlation_id, &status_code);
+	(void)TEST_amqp_messenger_subscribe_for_messages_on_message_received_callback(TEST_MESSAGE_HANDLE, NULL, TEST_amqp_messenger_subscribe_for_messages_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 2, TEST_on_report_state_complete_callback_result_SUCCESS_count);
+	ASSERT_ARE_EQUAL(size_t, 0, TEST_on_report_state_complete_callback_result_ERROR_count);
+	ASSERT_ARE_EQUAL(int, 200, TEST_on_report_state_complete_callback_status_code);
+	ASSERT_ARE_EQUAL(void_ptr, (void*)0x4501, TEST_on_report_state_complete_callback_context);
+
+	ASSERT_ARE_EQUAL(int, 0, twin_messenger_get_send_status(handle, &send_status));
+	ASSERT_ARE_EQUAL(int, TWIN_MESSENGER_SEND_STATUS_IDLE, send_status);
+
+	// cleanup
+	real_CONSTBUFFER_Destroy(report);
+	twin_messenger_destroy(handle);
+}
+
 // Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_082: [If any failure occurs while verifying/removing timed-out items `twin_msgr->state` shall be set to TWIN_MESSENGER_STATE_ERROR and user informed]  
+TEST_FUNCTION(twin_msgr_do_work_tickcounter_get_current_ms_fails)
+{
+	// arrange
+	TWIN_MESSENGER_CONFIG* config = get_twin_messenger_config();
+	TWIN_MESSENGER_HANDLE handle = create_and_start_twin_messenger(config);
+
+	send_one_report_patch(handle, TEST_CURRENT_TIME_MS);
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.SetReturn(1);
+	STRICT_EXPECTED_CALL(amqp_messenger_do_work(TEST_AMQP_MESSENGER_HANDLE));
+
+	// act
+	twin_messenger_do_work(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, TWIN_MESSENGER_STATE_ERROR, TEST_on_state_changed_callback_new_state);
+
+	// cleanup
+	twin_messenger_destroy(handle);
+}
+
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_119: [twin_messenger_do_work() shall read the current time once using tickcounter_get_current_ms() on `twin_msgr->tick_counter`, and use it for all time stamps and timeout verifications in this call]  
+// Tests_IOTHUBTRANSPORT_AMQP_TWIN_MESSENGER_09_120: [Timeouts shall be verified using the unsigned difference between the current time and the item time stamp, so the verification is not affected by the tick counter wrapping around]  
+TEST_FUNCTION(twin_msgr_do_work_EXPIRED_in_progress_patches_tick_counter_wraparound)
+{
+	// arrange
+	TWIN_MESSENGER_CONFIG* config = get_twin_messenger_config();
+	TWIN_MESSENGER_HANDLE handle = create_and_start_twin_messenger(config);
+
+	send_one_report_patch(handle, TEST_TICK_COUNTER_MAX_MS - 999);
+
+	DOWORK_TEST_PROFILE dwtp;
+	reset_dowork_test_profile(&dwtp);
+	dwtp.current_state = TWIN_MESSENGER_STATE_STARTED;
+	dwtp.current_time = TEST_TICK_COUNTER_MAX_MS - 499;
+	dwtp.number_of_pending_patches = 1;
+
+	crank_twin_messenger_do_work(handle, config, &dwtp);
+
+	// Sent at MAX-499; after the counter wraps, 300000-501 ms is still 1 ms short of the timeout.
+	dwtp.current_time = DEFAULT_TWIN_OPERATION_TIMEOUT_MS - 501;
+	crank_twin_messenger_do_work(handle, config, &dwtp);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, TEST_on_report_state_complete_callback_result_ERROR_count);
+
+	umock_c_reset_all_calls();
+	dwtp.current_time = DEFAULT_TWIN_OPERATION_TIMEOUT_MS - 500;
+	dwtp.number_of_expired_pending_operations = 1;
+	set_twin_messenger_do_work_expected_calls(&dwtp);
+
+	// act
+	twin_messenger_do_work(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 1, TEST_on_report_state_complete_callback_result_ERROR_count);
+	ASSERT_ARE_EQUAL(size_t, 1, TEST_on_report_state_complete_callback_reason_TIMEOUT_count);
+
+	// cleanup
+	twin_messenger_destroy(handle);
+}
 
 
 END_TEST_SUITE(iothubtr_amqp_twin_msgr_ut)
@@ -54,6 +54,7 @@ static int real_strcmp(const char* str1, const char* str2)
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/agenttime.h" 
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "iothub_client_authorization.h"
 #undef ENABLE_MOCKS
@@ -104,11 +105,23 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define SAS_TOKEN_TYPE                                    "servicebus.windows.net:sastoken"
 #define TEST_OPTIONHANDLER_HANDLE                         (OPTIONHANDLER_HANDLE)0x4455
 #define TEST_AUTHORIZATION_MODULE_HANDLE                  (IOTHUB_AUTHORIZATION_HANDLE)0x4456
+#define TEST_TICK_COUNTER_HANDLE                          (TICK_COUNTER_HANDLE)0x4457
+#define TEST_TICK_COUNTER_MAX_MS                          ((tickcounter_ms_t)-1)
 
 static AUTHENTICATION_CONFIG global_auth_config;
 
 // Function Hooks
 
+// The tick count is derived from the wall-clock time used by each test, shifted by an offset tests can set.
+static tickcounter_ms_t TEST_tick_counter_offset_ms;
+static tickcounter_ms_t TEST_current_time_ms;
+static int TEST_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = TEST_current_time_ms;
+    return 0;
+}
+
 static int saved_malloc_returns_count = 0;
 static void* saved_malloc_returns[20];
 
@@ -228,6 +241,7 @@ static void register_umock_alias_types()
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_AUTHORIZATION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SAS_TOKEN_STATUS, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CREDENTIAL_TYPE, int);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
 }
 
 static void register_global_mock_hooks()
@@ -236,6 +250,7 @@ static void register_global_mock_hooks()
     REGISTER_GLOBAL_MOCK_HOOK(free, TEST_free);
     REGISTER_GLOBAL_MOCK_HOOK(cbs_put_token_async, TEST_cbs_put_token_async);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_Auth_Get_SasToken, TEST_IoTHubClient_Auth_Get_SasToken);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, TEST_tickcounter_get_current_ms);
 }
 
 static void register_global_mock_returns()
@@ -251,6 +266,7 @@ static void register_global_mock_returns()
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
 
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(get_time, INDEFINITE_TIME);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, 1);
 
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_Create, NULL);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_AddOption, OPTIONHANDLER_ERROR);
@@ -264,7 +280,7 @@ typedef struct AUTHENTICATION_DO_WORK_EXPECTED_STATE_TAG
     AUTHENTICATION_STATE current_state;
     bool is_cbs_put_token_in_progress;
     bool is_sas_token_refresh_in_progress;
-    time_t current_sas_token_put_time;
+    tickcounter_ms_t current_sas_token_put_time;
     STRING_HANDLE sas_token_to_use;
     size_t sastoken_expiration_time;
     size_t sas_token_refresh_time_in_seconds;
@@ -314,6 +330,7 @@ static AUTHENTICATION_CONFIG* get_auth_config(USE_DEVICE_KEYS_OR_SAS_TOKEN_OPTIO
     global_auth_config.on_error_callback = TEST_on_error_callback;
     global_auth_config.on_error_callback_context = TEST_ON_ERROR_CALLBACK_CONTEXT;
     global_auth_config.authorization_module = TEST_AUTHORIZATION_MODULE_HANDLE;
+    global_auth_config.tick_counter = TEST_TICK_COUNTER_HANDLE;
     return &global_auth_config;
 }
 
@@ -335,6 +352,17 @@ static time_t add_seconds(time_t base_time, unsigned int seconds)
     return new_time;
 }
 
+static tickcounter_ms_t get_tick_count_ms(time_t current_time)
+{
+    return (tickcounter_ms_t)current_time * 1000 + TEST_tick_counter_offset_ms;
+}
+
+static void set_expected_calls_for_get_current_time(time_t current_time)
+{
+    TEST_current_time_ms = get_tick_count_ms(current_time);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+}
+
 static void set_expected_calls_for_authentication_create(AUTHENTICATION_CONFIG* config)
 {
     (void)config;
@@ -380,7 +408,6 @@ static void set_expected_calls_for_put_SAS_token_to_cbs(AUTHENTICATION_HANDLE ha
 
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_DEVICES_PATH_STRING_HANDLE)).SetReturn(TEST_DEVICES_PATH);
     STRICT_EXPECTED_CALL(cbs_put_token_async(TEST_CBS_HANDLE, SAS_TOKEN_TYPE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, handle));
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
 }
 
 static void set_expected_calls_for_create_and_put_sas_token(AUTHENTICATION_HANDLE handle, time_t current_time, AUTHENTICATION_DO_WORK_EXPECTED_STATE* exp_context)
@@ -400,17 +427,11 @@ static void set_expected_calls_for_authentication_do_work(AUTHENTICATION_CONFIG*
     (void)config;
     (void)handle;
 
+    set_expected_calls_for_get_current_time(current_time);
+
     if (exp_context->is_cbs_put_token_in_progress)
     {
-        if (exp_context->is_sas_token_refresh_in_progress)
-        {
-        }
-        else
-        {
-            STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
-            double actual_difftime_result = difftime(current_time, exp_context->current_sas_token_put_time);
-            STRICT_EXPECTED_CALL(get_difftime(current_time, IGNORED_NUM_ARG)).SetReturn(actual_difftime_result);
-        }
+        // Only the authentication timeout is verified, against the tick count read above.
     }
     else if (exp_context->current_state == AUTHENTICATION_STATE_STARTING)
     {
@@ -422,8 +443,6 @@ static void set_expected_calls_for_authentication_do_work(AUTHENTICATION_CONFIG*
     else if (exp_context->current_state == AUTHENTICATION_STATE_STARTED)
     {
         STRICT_EXPECTED_CALL(IoTHubClient_Auth_Get_Credential_Type(IGNORED_PTR_ARG)).SetReturn(IOTHUB_CREDENTIAL_TYPE_DEVICE_KEY);
-        STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
-        STRICT_EXPECTED_CALL(get_difftime(current_time, exp_context->current_sas_token_put_time));
     }
 }
 
@@ -454,6 +473,9 @@ static void reset_parameters()
 {
     saved_malloc_returns_count = 0;
 
+    TEST_tick_counter_offset_ms = 0;
+    TEST_current_time_ms = 0;
+
     saved_on_state_changed_callback_context = NULL;
     saved_on_state_changed_callback_previous_state = AUTHENTICATION_STATE_STOPPED;
     saved_on_state_changed_callback_new_state = AUTHENTICATION_STATE_STOPPED;
@@ -569,6 +591,25 @@ TEST_FUNCTION(authentication_create_NULL_on_state_changed_callback)
     // cleanup
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_131: [If `config->tick_counter` is NULL, authentication_create() shall fail and return NULL.]
+TEST_FUNCTION(authentication_create_NULL_tick_counter)
+{
+    // arrange
+    AUTHENTICATION_CONFIG* config = get_auth_config(USE_DEVICE_KEYS);
+    config->tick_counter = NULL;
+
+    umock_c_reset_all_calls();
+
+    // act
+    AUTHENTICATION_HANDLE handle = authentication_create(config);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_006: [authentication_create() shall allocate memory for a new authenticate state structure AUTHENTICATION_INSTANCE.]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_123: [authentication_create() shall initialize all fields of `instance` with 0 using memset().]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_008: [authentication_create() shall save a copy of `config->device_id` into the `instance->device_id`]
@@ -832,6 +873,7 @@ TEST_FUNCTION(authentication_do_work_not_started)
     AUTHENTICATION_HANDLE handle = authentication_create(config);
 
     umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
 
     // act
     authentication_do_work(handle);
@@ -1006,12 +1048,12 @@ TEST_FUNCTION(authentication_do_work_SAS_TOKEN_AUTHENTICATION_STATE_STARTING_fai
     size_t i;
     for (i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
-        if (i == 0 || i == 1 || i == 4 || i == 6 || i == 7)
+        if (i == 0 || i == 1 || i == 2 || i == 5 || i == 7)
         {
             // These expected calls do not cause the API to fail.
             continue;
         }
-        else if (i == 5)
+        else if (i == 6)
         {
             TEST_cbs_put_token_async_return = 1;
         }
@@ -1102,7 +1144,7 @@ TEST_FUNCTION(authentication_do_work_DEVICE_KEYS_AUTHENTICATION_STATE_STARTING_f
     size_t i;
     for (i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
-        if (i == 0 || i == 1 || i == 3 || i == 4 || i == 7 || i == 8 || i == 10 || i == 11 || i == 12)
+        if (i == 0 || i == 1 || i == 2 || i == 4 || i == 5 || i == 8 || i == 10 || i == 11 || i == 12)
         {
             // These expected calls do not cause the API to fail.
             continue;
@@ -1158,9 +1200,13 @@ TEST_FUNCTION(authentication_do_work_SAS_TOKEN_next_calls_no_op)
 
     umock_c_reset_all_calls();
     
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_Auth_Get_Credential_Type(IGNORED_PTR_ARG)).SetReturn(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_Auth_Get_Credential_Type(IGNORED_PTR_ARG)).SetReturn(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_Auth_Get_Credential_Type(IGNORED_PTR_ARG)).SetReturn(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_Auth_Get_Credential_Type(IGNORED_PTR_ARG)).SetReturn(IOTHUB_CREDENTIAL_TYPE_SAS_TOKEN);
 
     // act
@@ -1199,7 +1245,7 @@ TEST_FUNCTION(authentication_do_work_DEVICE_KEYS_sas_token_refresh_check)
     saved_cbs_put_token_on_operation_complete(saved_cbs_put_token_context, CBS_OPERATION_RESULT_OK, 0, "all good");
 
     exp_state->current_state = AUTHENTICATION_STATE_STARTED;
-    exp_state->current_sas_token_put_time = current_time;
+    exp_state->current_sas_token_put_time = get_tick_count_ms(current_time);
     exp_state->sas_token_refresh_time_in_seconds = DEFAULT_SAS_TOKEN_REFRESH_TIME_SECS;
 
     umock_c_reset_all_calls();
@@ -1251,7 +1297,7 @@ TEST_FUNCTION(authentication_do_work_DEVICE_KEYS_sas_token_refresh)
     ASSERT_ARE_EQUAL_WITH_MSG(int, 0, result, "authentication_set_option(AUTHENTICATION_OPTION_SAS_TOKEN_LIFETIME_SECS) failed!");
 
     exp_state->current_state = AUTHENTICATION_STATE_STARTED;
-    exp_state->current_sas_token_put_time = current_time;
+    exp_state->current_sas_token_put_time = get_tick_count_ms(current_time);
     exp_state->sas_token_refresh_time_in_seconds = 10;
     exp_state->sastoken_expiration_time = (size_t)(difftime(next_time, (time_t)0) + 123);
 
@@ -1291,7 +1337,7 @@ TEST_FUNCTION(authentication_do_work_first_auth_timeout_check)
     ASSERT_IS_NOT_NULL(saved_cbs_put_token_on_operation_complete);
 
     exp_state->is_cbs_put_token_in_progress = true;
-    exp_state->current_sas_token_put_time = current_time;
+    exp_state->current_sas_token_put_time = get_tick_count_ms(current_time);
 
     umock_c_reset_all_calls();
     set_expected_calls_for_authentication_do_work(config, handle, next_time, exp_state);
@@ -1334,7 +1380,7 @@ TEST_FUNCTION(authentication_do_work_first_auth_times_out)
     ASSERT_IS_NOT_NULL(saved_cbs_put_token_on_operation_complete);
 
     exp_state->is_cbs_put_token_in_progress = true;
-    exp_state->current_sas_token_put_time = current_time;
+    exp_state->current_sas_token_put_time = get_tick_count_ms(current_time);
 
     umock_c_reset_all_calls();
     set_expected_calls_for_authentication_do_work(config, handle, next_time, exp_state);
@@ -1353,6 +1399,92 @@ TEST_FUNCTION(authentication_do_work_first_auth_times_out)
     authentication_destroy(handle);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_135: [Timeouts shall be verified in milliseconds as the unsigned difference between the current and start tick counts, so a tick counter wraparound does not cause a spurious or missed timeout]
+TEST_FUNCTION(authentication_do_work_first_auth_times_out_tick_counter_wraparound)
+{
+    // arrange
+    AUTHENTICATION_CONFIG* config = get_auth_config(USE_DEVICE_SAS_TOKEN);
+    AUTHENTICATION_HANDLE handle = create_and_start_authentication(config);
+
+    size_t timeout_secs = 10;
+    int result = authentication_set_option(handle, AUTHENTICATION_OPTION_CBS_REQUEST_TIMEOUT_SECS, &timeout_secs);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    time_t current_time = time(NULL);
+    ASSERT_IS_TRUE_WITH_MSG(INDEFINITE_TIME != current_time, "current_time = time(NULL) failed");
+
+    // The SAS token is put half a second before the tick counter wraps around.
+    TEST_tick_counter_offset_ms = TEST_TICK_COUNTER_MAX_MS - 499 - (tickcounter_ms_t)current_time * 1000;
+
+    AUTHENTICATION_DO_WORK_EXPECTED_STATE *exp_state = get_do_work_expected_state_struct();
+    exp_state->current_state = AUTHENTICATION_STATE_STARTING;
+
+    crank_authentication_do_work(config, handle, current_time, exp_state);
+    ASSERT_IS_NOT_NULL(saved_cbs_put_token_on_operation_complete);
+
+    exp_state->is_cbs_put_token_in_progress = true;
+    exp_state->current_sas_token_put_time = get_tick_count_ms(current_time);
+
+    // One millisecond short of the timeout, past the wraparound.
+    TEST_tick_counter_offset_ms += timeout_secs * 1000 - 1;
+    crank_authentication_do_work(config, handle, current_time, exp_state);
+    ASSERT_IS_TRUE(get_tick_count_ms(current_time) < exp_state->current_sas_token_put_time);
+    ASSERT_ARE_EQUAL(int, AUTHENTICATION_STATE_STARTING, saved_on_state_changed_callback_new_state);
+
+    TEST_tick_counter_offset_ms += 1;
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_authentication_do_work(config, handle, current_time, exp_state);
+
+    // act
+    authentication_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, AUTHENTICATION_STATE_STARTING, saved_on_state_changed_callback_previous_state);
+    ASSERT_ARE_EQUAL(int, AUTHENTICATION_STATE_ERROR, saved_on_state_changed_callback_new_state);
+    ASSERT_ARE_EQUAL(int, AUTHENTICATION_ERROR_AUTH_TIMEOUT, saved_on_error_callback_error_code);
+
+    // cleanup
+    authentication_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_133: [authentication_do_work() shall read the current time once from `instance->tick_counter` using tickcounter_get_current_ms()]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_AUTH_09_134: [If tickcounter_get_current_ms() fails, the current time shall be considered unknown and no timeout shall be triggered on this call]
+TEST_FUNCTION(authentication_do_work_tickcounter_get_current_ms_fails)
+{
+    // arrange
+    AUTHENTICATION_CONFIG* config = get_auth_config(USE_DEVICE_SAS_TOKEN);
+    AUTHENTICATION_HANDLE handle = create_and_start_authentication(config);
+
+    size_t timeout_secs = 10;
+    int result = authentication_set_option(handle, AUTHENTICATION_OPTION_CBS_REQUEST_TIMEOUT_SECS, &timeout_secs);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    time_t current_time = time(NULL);
+    ASSERT_IS_TRUE_WITH_MSG(INDEFINITE_TIME != current_time, "current_time = time(NULL) failed");
+
+    AUTHENTICATION_DO_WORK_EXPECTED_STATE *exp_state = get_do_work_expected_state_struct();
+    exp_state->current_state = AUTHENTICATION_STATE_STARTING;
+
+    crank_authentication_do_work(config, handle, current_time, exp_state);
+    ASSERT_IS_NOT_NULL(saved_cbs_put_token_on_operation_complete);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG)).SetReturn(1);
+
+    // act
+    authentication_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, AUTHENTICATION_STATE_STOPPED, saved_on_state_changed_callback_previous_state);
+    ASSERT_ARE_EQUAL(int, AUTHENTICATION_STATE_STARTING, saved_on_state_changed_callback_new_state);
+
+    // cleanup
+    authentication_destroy(handle);
+}
+
 // Tests_SRSIOTHUBTRANSPORT_AMQP_AUTH_09_097: [If `authentication_handle` or `name` or `value` is NULL, authentication_set_option shall fail and return a non-zero value]
 TEST_FUNCTION(authentication_set_option_NULL_handle)
 {
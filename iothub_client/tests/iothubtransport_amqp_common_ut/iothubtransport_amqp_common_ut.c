@@ -112,6 +112,7 @@ extern "C"
 #include "iothub_client_private.h"
 #include "iothub_client_version.h"
 #include "iothub_client_retry_control.h"
+#include "iothub_client_tls_session_cache.h"
 #include "iothubtransportamqp_methods.h"
 #include "iothubtransport_amqp_connection.h"
 #include "iothubtransport_amqp_device.h"
@@ -300,6 +301,28 @@ extern "C"
         return TEST_device_subscribe_message_return;
     }
 
+    static ON_DEVICE_D2C_EVENT_SEND_COMPLETE TEST_device_send_event_async_saved_callback;
+    static void* TEST_device_send_event_async_saved_context;
+    static int TEST_device_send_event_async_return;
+    static int TEST_device_send_event_async(DEVICE_HANDLE handle, IOTHUB_MESSAGE_LIST* message, ON_DEVICE_D2C_EVENT_SEND_COMPLETE on_device_d2c_event_send_complete_callback, void* context)
+    {
+        (void)handle;
+        (void)message;
+        TEST_device_send_event_async_saved_callback = on_device_d2c_event_send_complete_callback;
+        TEST_device_send_event_async_saved_context = context;
+        return TEST_device_send_event_async_return;
+    }
+
+    static size_t TEST_IoTHubClient_LL_SendComplete_count;
+    static IOTHUB_CLIENT_CONFIRMATION_RESULT TEST_IoTHubClient_LL_SendComplete_saved_result;
+    static void TEST_IoTHubClient_LL_SendComplete(IOTHUB_CLIENT_LL_HANDLE handle, PDLIST_ENTRY completed, IOTHUB_CLIENT_CONFIRMATION_RESULT result)
+    {
+        (void)handle;
+        (void)completed;
+        TEST_IoTHubClient_LL_SendComplete_count++;
+        TEST_IoTHubClient_LL_SendComplete_saved_result = result;
+    }
+
     static IOTHUB_CLIENT_RESULT TEST_IoTHubClient_LL_GetOption(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char* optionName, void** value)
     {
         (void)iotHubClientHandle;
@@ -405,6 +428,9 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_X509_PRIVATE_KEY                      "Raphael Rabello"
 #define TEST_MESSAGE_SOURCE_CHAR_PTR               "messagereceiver_link_name"
 #define TEST_RETRY_CONTROL_HANDLE                  (RETRY_CONTROL_HANDLE)0x4276
+#define TEST_TICK_COUNTER_HANDLE                   (TICK_COUNTER_HANDLE)0x4277
+#define TEST_TLS_SESSION_CACHE_HANDLE              (TLS_SESSION_CACHE_HANDLE)0x4278
+#define TEST_TLS_SESSION_STORE                     (const TLS_SESSION_STORE*)0x4279
 
 
 static const unsigned char* TEST_DEVICE_METHOD_RESPONSE = (const unsigned char*)0x62;
@@ -417,6 +443,9 @@ static DLIST_ENTRY TEST_waitingToSend;
 
 static delivery_number TEST_MESSAGE_ID;
 
+static int TEST_xio_setoption_tls_session_store_result;
+static bool TEST_is_tls_session_store_rejected;
+
 
 // ---------- Helpers for Expected Calls ---------- //
 
@@ -440,6 +469,9 @@ static void set_expected_calls_for_Create(IOTHUBTRANSPORT_CONFIG* transport_conf
 
     STRICT_EXPECTED_CALL(singlylinkedlist_create())
         .SetReturn(TEST_REGISTERED_DEVICES_LIST);
+
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tls_session_cache_create());
 }
 
 static void set_expected_calls_for_GetSendStatus(DEVICE_SEND_STATUS send_status)
@@ -696,6 +728,21 @@ static void set_expected_calls_for_Device_DoWork(PDLIST_ENTRY wts, int wts_lengt
     STRICT_EXPECTED_CALL(device_do_work(TEST_DEVICE_HANDLE));
 }
 
+static void set_expected_calls_for_set_tls_session_store()
+{
+    // Once the TLS I/O rejects the store the transport stops offering it.
+    if (!TEST_is_tls_session_store_rejected)
+    {
+        STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
+            .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+        STRICT_EXPECTED_CALL(tls_session_cache_get_store(TEST_TLS_SESSION_CACHE_HANDLE, TEST_IOTHUB_HOST_FQDN_CHAR_PTR));
+        STRICT_EXPECTED_CALL(xio_setoption(TEST_UNDERLYING_IO_TRANSPORT, OPTION_TLS_SESSION_STORE, TEST_TLS_SESSION_STORE))
+            .SetReturn(TEST_xio_setoption_tls_session_store_result);
+
+        TEST_is_tls_session_store_rejected = (TEST_xio_setoption_tls_session_store_result != 0);
+    }
+}
+
 static void set_expected_calls_for_get_new_underlying_io_transport(bool feed_options)
 {
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
@@ -706,6 +753,8 @@ static void set_expected_calls_for_get_new_underlying_io_transport(bool feed_opt
         STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(TEST_OPTIONHANDLER_HANDLE, TEST_UNDERLYING_IO_TRANSPORT))
             .SetReturn(OPTIONHANDLER_OK);
     }
+
+    set_expected_calls_for_set_tls_session_store();
 }
 
 static void set_expected_calls_for_DoWork2(PDLIST_ENTRY wts, int wts_length, DEVICE_STATE current_device_state, bool is_tls_io_acquired, bool feed_options, bool is_using_cbs, bool is_connection_created, bool is_connection_open, int number_of_registered_devices, time_t current_time, bool subscribe_for_methods)
@@ -762,6 +811,8 @@ static void set_expected_calls_for_Destroy(int number_of_registered_devices, IOT
     STRICT_EXPECTED_CALL(amqp_connection_destroy(TEST_AMQP_CONNECTION_HANDLE));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_UNDERLYING_IO_TRANSPORT));
     STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(tls_session_cache_destroy(TEST_TLS_SESSION_CACHE_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE));
     EXPECTED_CALL(free(IGNORED_PTR_ARG));
 }
@@ -890,9 +941,11 @@ static double TEST_get_difftime(time_t t1, time_t t0)
 
 static ON_DEVICE_STATE_CHANGED TEST_device_create_saved_on_state_changed_callback;
 static void* TEST_device_create_saved_on_state_changed_context;
+static TICK_COUNTER_HANDLE TEST_device_create_saved_tick_counter;
 static DEVICE_HANDLE TEST_device_create_return;
 static DEVICE_HANDLE TEST_device_create(DEVICE_CONFIG* config)
 {
+    TEST_device_create_saved_tick_counter = config->tick_counter;
     TEST_device_create_saved_on_state_changed_callback = config->on_state_changed_callback;
     TEST_device_create_saved_on_state_changed_context = config->on_state_changed_context;
     return TEST_device_create_return;
@@ -1070,6 +1123,7 @@ static void register_umock_alias_types()
     REGISTER_UMOCK_ALIAS_TYPE(DEVICE_MESSAGE_DISPOSITION_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(DEVICE_SEND_STATUS, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONFIRMATION_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONNECTION_STATUS, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONNECTION_STATUS_REASON, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_STATUS, int);
@@ -1107,6 +1161,9 @@ static void register_umock_alias_types()
     REGISTER_UMOCK_ALIAS_TYPE(PREDICATE_FUNCTION, void*);
     REGISTER_UMOCK_ALIAS_TYPE(PROPERTIES_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(RETRY_CONTROL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TLS_SESSION_CACHE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const TLS_SESSION_STORE*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
@@ -1152,6 +1209,8 @@ static void register_global_mock_hooks()
 
     REGISTER_GLOBAL_MOCK_HOOK(device_create, TEST_device_create);
     REGISTER_GLOBAL_MOCK_HOOK(device_subscribe_message, TEST_device_subscribe_message);
+    REGISTER_GLOBAL_MOCK_HOOK(device_send_event_async, TEST_device_send_event_async);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_SendComplete, TEST_IoTHubClient_LL_SendComplete);
 
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_MessageCallback, TEST_IoTHubClient_LL_MessageCallback);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_GetOption, TEST_IoTHubClient_LL_GetOption);
@@ -1207,6 +1266,12 @@ static void register_global_mock_returns()
 
     REGISTER_GLOBAL_MOCK_RETURN(retry_control_create, TEST_RETRY_CONTROL_HANDLE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(retry_control_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(tls_session_cache_create, TEST_TLS_SESSION_CACHE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tls_session_cache_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(tls_session_cache_get_store, TEST_TLS_SESSION_STORE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tls_session_cache_get_store, NULL);
 }
 
 static void initialize_static_variables()
@@ -1230,6 +1295,7 @@ static void initialize_static_variables()
 
     TEST_device_create_saved_on_state_changed_callback = NULL;
     TEST_device_create_saved_on_state_changed_context = NULL;
+    TEST_device_create_saved_tick_counter = NULL;
     TEST_device_create_return = TEST_DEVICE_HANDLE;
 
     saved_registered_devices_list_count = 0;
@@ -1248,6 +1314,11 @@ static void initialize_test_variables()
     ASSERT_IS_TRUE_WITH_MSG(INDEFINITE_TIME != TEST_current_time, "Failed setting TEST_current_time");
 
     real_DList_InitializeListHead(&TEST_waitingToSend);
+
+    TEST_xio_setoption_tls_session_store_result = 0;
+    TEST_is_tls_session_store_rejected = false;
+    TEST_device_send_event_async_return = 0;
+    TEST_IoTHubClient_LL_SendComplete_count = 0;
 }
 
 
@@ -1975,6 +2046,79 @@ TEST_FUNCTION(GetHostName_success)
     destroy_transport(handle, NULL, NULL);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_163: [If `handle` or `statistics` are NULL, IoTHubTransport_AMQP_Common_GetStatistics shall return without changes]
+TEST_FUNCTION(GetStatistics_NULL_handle)
+{
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    memset(&statistics, 0, sizeof(statistics));
+    umock_c_reset_all_calls();
+
+    // act
+    IoTHubTransport_AMQP_Common_GetStatistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.tls_session_cache_hits);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.tls_session_cache_misses);
+
+    // cleanup
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_164: [IoTHubTransport_AMQP_Common_GetStatistics shall set `statistics->tls_session_cache_hits` and `statistics->tls_session_cache_misses` from tls_session_cache_get_statistics() on `instance->tls_session_cache`]
+TEST_FUNCTION(GetStatistics_success)
+{
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    TLS_SESSION_CACHE_STATISTICS tls_session_cache_statistics;
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    memset(&statistics, 0, sizeof(statistics));
+    tls_session_cache_statistics.hits = 3;
+    tls_session_cache_statistics.misses = 2;
+    tls_session_cache_statistics.sessions_saved = 5;
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tls_session_cache_get_statistics(TEST_TLS_SESSION_CACHE_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_statistics(&tls_session_cache_statistics, sizeof(TLS_SESSION_CACHE_STATISTICS));
+
+    // act
+    IoTHubTransport_AMQP_Common_GetStatistics(handle, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 3, statistics.tls_session_cache_hits);
+    ASSERT_ARE_EQUAL(uint64_t, 2, statistics.tls_session_cache_misses);
+
+    // cleanup
+    destroy_transport(handle, NULL, NULL);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_165: [If tls_session_cache_get_statistics() fails, IoTHubTransport_AMQP_Common_GetStatistics shall leave `statistics` unchanged]
+TEST_FUNCTION(GetStatistics_tls_session_cache_get_statistics_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    memset(&statistics, 0, sizeof(statistics));
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tls_session_cache_get_statistics(TEST_TLS_SESSION_CACHE_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    IoTHubTransport_AMQP_Common_GetStatistics(handle, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.tls_session_cache_hits);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.tls_session_cache_misses);
+
+    // cleanup
+    destroy_transport(handle, NULL, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_003: [Memory shall be allocated for the transport's internal state structure (`instance`)]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_005: [If `config->upperConfig->protocolGatewayHostName` is NULL, `instance->iothub_target_fqdn` shall be set as `config->upperConfig->iotHubName` + "." + `config->upperConfig->iotHubSuffix`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_006: [If `config->upperConfig->protocolGatewayHostName` is not NULL, `instance->iothub_target_fqdn` shall be set with a copy of it]
@@ -1982,6 +2126,8 @@ TEST_FUNCTION(GetHostName_success)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_010: [`get_io_transport` shall be saved on `instance->underlying_io_transport_provider`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_012: [If IoTHubTransport_AMQP_Common_Create succeeds it shall return a pointer to `instance`.]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_124: [`instance->connection_retry_control` shall be set using retry_control_create(), passing defaults EXPONENTIAL_BACKOFF_WITH_JITTER and 0]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_154: [`instance->tick_counter` shall be set using tickcounter_create()]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_157: [`instance->tls_session_cache` shall be set using tls_session_cache_create()]
 TEST_FUNCTION(Create_success)
 {
     // arrange
@@ -2008,6 +2154,8 @@ TEST_FUNCTION(Create_success)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_009: [If singlylinkedlist_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_011: [If IoTHubTransport_AMQP_Common_Create fails it shall free any memory it allocated]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_125: [If retry_control_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_155: [If tickcounter_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_158: [If tls_session_cache_create() fails, IoTHubTransport_AMQP_Common_Create shall fail and return NULL]
 TEST_FUNCTION(Create_failure_checks)
 {
     // arrange
@@ -2315,6 +2463,7 @@ TEST_FUNCTION(Register_failure_checks)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_069: [A copy of `config->deviceId` shall be saved into `device_state->device_id`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_071: [`amqp_device_instance->device_handle` shall be set using device_create()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_072: [The configuration for device_create shall be set according to the authentication preferred by IOTHUB_DEVICE_CONFIG]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_156: [The configuration for device_create shall use `instance->tick_counter` as the device's tick counter]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_010: [ `IoTHubTransport_AMQP_Common_Register` shall create a new iothubtransportamqp_methods instance by calling `iothubtransportamqp_methods_create` while passing to it the the fully qualified domain name and the device Id]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_074: [IoTHubTransport_AMQP_Common_Register shall add the `amqp_device_instance` to `instance->registered_devices`]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_076: [If the device is the first being registered on the transport, IoTHubTransport_AMQP_Common_Register shall save its authentication mode as the transport preferred authentication mode]
@@ -2336,6 +2485,7 @@ TEST_FUNCTION(Register_succeeds)
     // assert
     ASSERT_IS_NOT_NULL(device_handle);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, (void*)TEST_TICK_COUNTER_HANDLE, (void*)TEST_device_create_saved_tick_counter);
 
     // cleanup
     destroy_transport(handle, device_handle, NULL);
@@ -2766,6 +2916,36 @@ TEST_FUNCTION(SetOption_device_specific_failure_check)
     destroy_transport(handle, device_handle, NULL);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_102: [If `option` is a device-specific option, it shall be saved and applied to each registered device using device_set_option()]
+TEST_FUNCTION(SetOption_message_pool_size_is_applied_to_registered_devices)
+{
+    // arrange
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    ASSERT_IS_NOT_NULL(device_handle);
+
+    size_t value = 16;
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
+    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG)).SetReturn(device_handle);
+    STRICT_EXPECTED_CALL(device_set_option(TEST_DEVICE_HANDLE, DEVICE_OPTION_MESSAGE_POOL_SIZE, &value));
+    EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_AMQP_Common_SetOption(handle, OPTION_MESSAGE_POOL_SIZE, &value);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_02_007: [ If `option` is `x509certificate` and the transport preferred authentication method is not x509 then IoTHubTransport_AMQP_Common_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]
 TEST_FUNCTION(SetOption_CBS_transport_option_x509certificate)
 {
@@ -2871,6 +3051,7 @@ TEST_FUNCTION(SetOption_xio_option_success)
 
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
         .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+    set_expected_calls_for_set_tls_session_store();
     STRICT_EXPECTED_CALL(xio_setoption(TEST_UNDERLYING_IO_TRANSPORT, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(2)
         .IgnoreArgument(3)
@@ -2935,6 +3116,7 @@ TEST_FUNCTION(SetOption_xio_option_fails)
 
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
         .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+    set_expected_calls_for_set_tls_session_store();
     STRICT_EXPECTED_CALL(xio_setoption(TEST_UNDERLYING_IO_TRANSPORT, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(2)
         .IgnoreArgument(3)
@@ -3707,6 +3889,8 @@ TEST_FUNCTION(IoTHubTransport_AMQP_Common_Destroy_frees_proxy_options)
 
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_REGISTERED_DEVICES_LIST));
     STRICT_EXPECTED_CALL(retry_control_destroy(TEST_RETRY_CONTROL_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(tls_session_cache_destroy(TEST_TLS_SESSION_CACHE_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE));
     STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
@@ -3787,6 +3971,111 @@ TEST_FUNCTION(Unregister_succeeds)
     destroy_transport(handle, device_handle, NULL);
 }
 
+static void send_event_through_started_transport(TRANSPORT_LL_HANDLE handle, IOTHUB_MESSAGE_LIST* message)
+{
+    memset(message, 0, sizeof(IOTHUB_MESSAGE_LIST));
+    message->messageHandle = TEST_IOTHUB_MESSAGE_HANDLE;
+    real_DList_InsertTailList(&TEST_waitingToSend, &(message->entry));
+
+    TEST_device_send_event_async_saved_callback = NULL;
+    crank_transport(handle, &TEST_waitingToSend, 1, DEVICE_STATE_STARTED, true, true, true, true, 1, TEST_current_time, false);
+    ASSERT_IS_NOT_NULL(TEST_device_send_event_async_saved_callback);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_050: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_OK, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_OK]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_056: [`message` shall be completed by invoking IoTHubClient_LL_SendComplete passing `registered_device->iothub_client_handle`, a list containing only `message` and `iothub_send_result`]
+TEST_FUNCTION(on_event_send_complete_hands_the_event_back_to_the_LL_client)
+{
+    // arrange
+    IOTHUB_MESSAGE_LIST message;
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    crank_transport_ready_after_create(handle, &TEST_waitingToSend, 0, false, true, 1, TEST_current_time, false);
+    send_event_through_started_transport(handle, &message);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message.entry)))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
+
+    // act
+    TEST_device_send_event_async_saved_callback(&message, D2C_EVENT_SEND_COMPLETE_RESULT_OK, TEST_device_send_event_async_saved_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls()); /*neither the message nor the record are destroyed by the transport*/
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_053: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_056: [`message` shall be completed by invoking IoTHubClient_LL_SendComplete passing `registered_device->iothub_client_handle`, a list containing only `message` and `iothub_send_result`]
+TEST_FUNCTION(on_event_send_complete_with_timeout_completes_the_event_as_timed_out)
+{
+    // arrange
+    IOTHUB_MESSAGE_LIST message;
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    crank_transport_ready_after_create(handle, &TEST_waitingToSend, 0, false, true, 1, TEST_current_time, false);
+    send_event_through_started_transport(handle, &message);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message.entry)))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT))
+        .IgnoreArgument(2);
+
+    // act
+    TEST_device_send_event_async_saved_callback(&message, D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, TEST_device_send_event_async_saved_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_049: [If device_send_event_async() fails, `on_event_send_complete` shall be invoked passing EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING and return]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_052: [If result is D2C_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, `iothub_send_result` shall be set using IOTHUB_CLIENT_CONFIRMATION_ERROR]
+TEST_FUNCTION(send_pending_events_when_device_send_event_async_fails_completes_the_event_as_failed)
+{
+    // arrange
+    IOTHUB_MESSAGE_LIST message;
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    crank_transport_ready_after_create(handle, &TEST_waitingToSend, 0, false, true, 1, TEST_current_time, false);
+
+    memset(&message, 0, sizeof(IOTHUB_MESSAGE_LIST));
+    message.messageHandle = TEST_IOTHUB_MESSAGE_HANDLE;
+    real_DList_InsertTailList(&TEST_waitingToSend, &(message.entry));
+
+    TEST_device_send_event_async_return = 1;
+    umock_c_reset_all_calls();
+
+    // act
+    (void)IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, TEST_IoTHubClient_LL_SendComplete_count);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_CONFIRMATION_ERROR, (int)TEST_IoTHubClient_LL_SendComplete_saved_result);
+    ASSERT_IS_TRUE(real_DList_IsListEmpty(&TEST_waitingToSend) != 0);
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_089: [IoTHubClient_LL_MessageCallback() shall be invoked passing the client and the incoming message handles as parameters]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_091: [If IoTHubClient_LL_MessageCallback() succeeds, on_message_received_callback shall return DEVICE_MESSAGE_DISPOSITION_RESULT_NONE]
 TEST_FUNCTION(on_message_received_succeeds)
@@ -3981,6 +4270,130 @@ TEST_FUNCTION(on_amqp_connection_state_changed_CLOSED_unexpectedly)
     destroy_transport(handle, device_handle, NULL);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_159: [When a new `instance->tls_io` is created, the TLS session store for `instance->iothub_host_fqdn` shall be obtained using tls_session_cache_get_store() and set on it using xio_setoption() with OPTION_TLS_SESSION_STORE]
+TEST_FUNCTION(DoWork_sets_tls_session_store_on_every_new_tls_io)
+{
+    // arrange
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    ASSERT_IS_NOT_NULL(device_handle);
+
+    umock_c_reset_all_calls();
+
+    set_expected_calls_for_DoWork(&TEST_waitingToSend, 0, DEVICE_STATE_STOPPED, false, true, false, false, 1, TEST_current_time, false);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    TEST_amqp_connection_create_saved_on_state_changed_callback(
+        TEST_amqp_connection_create_saved_on_state_changed_context,
+        AMQP_CONNECTION_STATE_CLOSED, AMQP_CONNECTION_STATE_OPENED);
+
+    set_expected_calls_for_DoWork(&TEST_waitingToSend, 0, DEVICE_STATE_STOPPED, true, true, true, true, 1, TEST_current_time, false);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    TEST_amqp_connection_create_saved_on_state_changed_callback(
+        TEST_amqp_connection_create_saved_on_state_changed_context,
+        AMQP_CONNECTION_STATE_OPENED, AMQP_CONNECTION_STATE_CLOSED);
+
+    set_expected_calls_for_prepare_for_connection_retry(1, DEVICE_STATE_STOPPED);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // act
+    set_expected_calls_for_DoWork2(&TEST_waitingToSend, 0, DEVICE_STATE_STOPPED, false, true, true, false, false, 1, TEST_current_time, false);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(TEST_is_tls_session_store_rejected);
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_160: [If tls_session_cache_get_store() or xio_setoption() fail, it shall be ignored]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_161: [If xio_setoption() fails, the TLS session store shall not be set on subsequent TLS I/O instances]
+TEST_FUNCTION(DoWork_tls_session_store_rejected_by_tls_io)
+{
+    // arrange
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    ASSERT_IS_NOT_NULL(device_handle);
+
+    umock_c_reset_all_calls();
+    TEST_xio_setoption_tls_session_store_result = __LINE__;
+
+    set_expected_calls_for_DoWork(&TEST_waitingToSend, 0, DEVICE_STATE_STOPPED, false, true, false, false, 1, TEST_current_time, false);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    ASSERT_IS_TRUE(TEST_is_tls_session_store_rejected);
+
+    TEST_amqp_connection_create_saved_on_state_changed_callback(
+        TEST_amqp_connection_create_saved_on_state_changed_context,
+        AMQP_CONNECTION_STATE_CLOSED, AMQP_CONNECTION_STATE_OPENED);
+
+    set_expected_calls_for_DoWork(&TEST_waitingToSend, 0, DEVICE_STATE_STOPPED, true, true, true, true, 1, TEST_current_time, false);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    TEST_amqp_connection_create_saved_on_state_changed_callback(
+        TEST_amqp_connection_create_saved_on_state_changed_context,
+        AMQP_CONNECTION_STATE_OPENED, AMQP_CONNECTION_STATE_CLOSED);
+
+    set_expected_calls_for_prepare_for_connection_retry(1, DEVICE_STATE_STOPPED);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // act
+    set_expected_calls_for_DoWork2(&TEST_waitingToSend, 0, DEVICE_STATE_STOPPED, false, true, true, false, false, 1, TEST_current_time, false);
+    IoTHubTransport_AMQP_Common_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_160: [If tls_session_cache_get_store() or xio_setoption() fail, it shall be ignored]
+TEST_FUNCTION(SetOption_xio_option_tls_session_cache_get_store_fails)
+{
+    // arrange
+    initialize_test_variables();
+    TRANSPORT_LL_HANDLE handle = create_transport();
+
+    IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+    IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+    ASSERT_IS_NOT_NULL(device_handle);
+
+    bool value = true;
+
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
+        .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
+        .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
+    STRICT_EXPECTED_CALL(tls_session_cache_get_store(TEST_TLS_SESSION_CACHE_HANDLE, TEST_IOTHUB_HOST_FQDN_CHAR_PTR))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_UNDERLYING_IO_TRANSPORT, "Some XIO option name", IGNORED_PTR_ARG))
+        .IgnoreArgument(3)
+        .SetReturn(0);
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_UNDERLYING_IO_TRANSPORT))
+        .SetReturn(TEST_OPTIONHANDLER_HANDLE);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_AMQP_Common_SetOption(handle, "Some XIO option name", &value);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_transport(handle, device_handle, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_016: [If `handle` is NULL, IoTHubTransport_AMQP_Common_DoWork shall return without doing any work]
 TEST_FUNCTION(DoWork_NULL_handle)
 {
@@ -4010,7 +4423,8 @@ TEST_FUNCTION(DoWork_get_underlying_io_transport_provider_fails)
 
     umock_c_reset_all_calls();
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
-    set_expected_calls_for_get_new_underlying_io_transport(false);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE))
+        .SetReturn(TEST_IOTHUB_HOST_FQDN_CHAR_PTR);
     TEST_amqp_get_io_transport_result = NULL;
 
     // act
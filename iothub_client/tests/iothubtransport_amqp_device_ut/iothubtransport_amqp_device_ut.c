@@ -38,7 +38,6 @@ void real_free(void* ptr)
 
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/agenttime.h" 
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/uniqueid.h"
@@ -81,7 +80,9 @@ static const char* DEVICE_OPTION_SAVED_MESSENGER_OPTIONS = "saved_device_messeng
 #define DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS    60
 #define DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS    60
 
-#define INDEFINITE_TIME                                   ((time_t)-1)
+#define INDEFINITE_TIME                                   ((tickcounter_ms_t)-1)
+#define TEST_CURRENT_TIME_MS                              ((tickcounter_ms_t)3600000)
+#define TEST_TICK_COUNTER_MAX_MS                          ((tickcounter_ms_t)-1)
 #define TEST_DEVICE_ID_CHAR_PTR                           "bogus-device"
 #define TEST_PRODUCT_INFO_CHAR_PTR                        "bogus-product_info"
 #define TEST_IOTHUB_HOST_FQDN_CHAR_PTR                    "thisisabogus.azure-devices.net"
@@ -107,29 +108,17 @@ static const char* DEVICE_OPTION_SAVED_MESSENGER_OPTIONS = "saved_device_messeng
 #define TEST_ON_DEVICE_EVENT_SEND_COMPLETE_CONTEXT        (void*)0x7724
 #define TEST_IOTHUB_MESSAGE_LIST                          (IOTHUB_MESSAGE_LIST*)0x7725
 #define TEST_AUTHORIZATION_MODULE_HANDLE                  (IOTHUB_AUTHORIZATION_HANDLE)0x7726
+#define TEST_TICK_COUNTER_HANDLE                          (TICK_COUNTER_HANDLE)0x7727
 
-static time_t TEST_current_time;
+static tickcounter_ms_t TEST_current_time;
 
 #define TEST_MESSAGE_SOURCE_NAME_CHAR_PTR                 "link_name"
 static delivery_number TEST_MESSAGE_ID;
 
 // ---------- Time-related Test Helpers ---------- //
-static time_t add_seconds(time_t base_time, unsigned int seconds)
+static tickcounter_ms_t add_seconds(tickcounter_ms_t base_time, unsigned int seconds)
 {
-    time_t new_time;
-    struct tm *bd_new_time;
-
-    if ((bd_new_time = localtime(&base_time)) == NULL)
-    {
-        new_time = INDEFINITE_TIME;
-    }
-    else
-    {
-        bd_new_time->tm_sec += seconds;
-        new_time = mktime(bd_new_time);
-    }
-
-    return new_time;
+    return base_time + (tickcounter_ms_t)seconds * 1000;
 }
 
 // ---------- Test Hooks ---------- //
@@ -180,9 +169,12 @@ static int TEST_telemetry_messenger_subscribe_for_messages(TELEMETRY_MESSENGER_H
     return TEST_telemetry_messenger_subscribe_for_messages_return;
 }
 
-static double TEST_get_difftime(time_t end_time, time_t start_time)
+static tickcounter_ms_t TEST_current_time_ms;
+static int TEST_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
 {
-    return difftime(end_time, start_time);
+    (void)tick_counter;
+    *current_ms = TEST_current_time_ms;
+    return 0;
 }
 
 static ON_AUTHENTICATION_STATE_CHANGED_CALLBACK TEST_authentication_create_saved_on_authentication_changed_callback;
@@ -280,6 +272,7 @@ static DEVICE_CONFIG* get_device_config(DEVICE_AUTH_MODE auth_mode)
     TEST_device_config.on_state_changed_callback = TEST_on_state_changed_callback;
     TEST_device_config.on_state_changed_context = TEST_ON_STATE_CHANGED_CONTEXT;
     TEST_device_config.authorization_module = TEST_AUTHORIZATION_MODULE_HANDLE;
+    TEST_device_config.tick_counter = TEST_TICK_COUNTER_HANDLE;
 
     return &TEST_device_config;
 }
@@ -294,7 +287,8 @@ static void initialize_test_variables()
     TEST_on_state_changed_callback_saved_previous_state = DEVICE_STATE_STOPPED;
     TEST_on_state_changed_callback_saved_new_state = DEVICE_STATE_STOPPED;
 
-    TEST_current_time = time(NULL);
+    TEST_current_time = TEST_CURRENT_TIME_MS;
+    TEST_current_time_ms = TEST_CURRENT_TIME_MS;
 
     TEST_on_message_received_saved_message = NULL;
     TEST_on_message_received_saved_disposition_info = NULL;
@@ -349,7 +343,7 @@ static void register_umock_alias_types()
     REGISTER_UMOCK_ALIAS_TYPE(const CBS_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(const SESSION_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(time_t, long long);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(AUTHENTICATION_ERROR_CODE, int);
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_RESULT, int);
@@ -369,7 +363,7 @@ static void register_global_mock_hooks()
     REGISTER_GLOBAL_MOCK_HOOK(free, TEST_free);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, TEST_mallocAndStrcpy_s);
     REGISTER_GLOBAL_MOCK_HOOK(telemetry_messenger_subscribe_for_messages, TEST_telemetry_messenger_subscribe_for_messages);
-    REGISTER_GLOBAL_MOCK_HOOK(get_difftime, TEST_get_difftime);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, TEST_tickcounter_get_current_ms);
     REGISTER_GLOBAL_MOCK_HOOK(authentication_create, TEST_authentication_create);
 	REGISTER_GLOBAL_MOCK_HOOK(telemetry_messenger_create, TEST_telemetry_messenger_create);
 	REGISTER_GLOBAL_MOCK_HOOK(twin_messenger_create, TEST_twin_messenger_create);
@@ -388,7 +382,7 @@ static void register_global_mock_returns()
 
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
 
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(get_time, INDEFINITE_TIME);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, 1);
 
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_Create, NULL);
 
@@ -445,14 +439,10 @@ static void register_global_mock_returns()
 
 // ---------- Expected Call Helpers ---------- //
 
-static void set_expected_calls_for_is_timeout_reached(time_t current_time)
+static void set_expected_calls_for_get_current_time(tickcounter_ms_t current_time)
 {
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
-
-    if (current_time != INDEFINITE_TIME)
-    {
-        STRICT_EXPECTED_CALL(get_difftime(current_time, IGNORED_NUM_ARG)); // let the function hook calculate the actual difftime.
-    }
+    TEST_current_time_ms = current_time;
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
 }
 
 static void set_expected_calls_for_clone_device_config(DEVICE_CONFIG *config)
@@ -482,7 +472,7 @@ static void set_expected_calls_for_create_twin_messenger(DEVICE_CONFIG *config)
 	EXPECTED_CALL(twin_messenger_create(IGNORED_PTR_ARG));
 }
 
-static void set_expected_calls_for_device_create(DEVICE_CONFIG *config, time_t current_time)
+static void set_expected_calls_for_device_create(DEVICE_CONFIG *config, tickcounter_ms_t current_time)
 {
     (void)current_time;
 
@@ -500,14 +490,14 @@ static void set_expected_calls_for_device_create(DEVICE_CONFIG *config, time_t c
 	set_expected_calls_for_create_twin_messenger(config);
 }
 
-static void set_expected_calls_for_device_start_async(DEVICE_CONFIG* config, time_t current_time)
+static void set_expected_calls_for_device_start_async(DEVICE_CONFIG* config, tickcounter_ms_t current_time)
 {
     (void)config;
     (void)current_time;
     // Nothing to expect from this function.
 }
 
-static void set_expected_calls_for_device_stop(DEVICE_CONFIG* config, time_t current_time, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE messenger_state, TWIN_MESSENGER_STATE twin_msgr_state)
+static void set_expected_calls_for_device_stop(DEVICE_CONFIG* config, tickcounter_ms_t current_time, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE messenger_state, TWIN_MESSENGER_STATE twin_msgr_state)
 {
     (void)current_time;
 
@@ -527,20 +517,18 @@ static void set_expected_calls_for_device_stop(DEVICE_CONFIG* config, time_t cur
     }
 }
 
-static void set_expected_calls_for_device_do_work(DEVICE_CONFIG* config, time_t current_time, DEVICE_STATE device_state, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE msgr_state, TWIN_MESSENGER_STATE twin_msgr_state)
+static void set_expected_calls_for_device_do_work(DEVICE_CONFIG* config, tickcounter_ms_t current_time, DEVICE_STATE device_state, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE msgr_state, TWIN_MESSENGER_STATE twin_msgr_state)
 {
     if (device_state == DEVICE_STATE_STARTING)
     {
+        set_expected_calls_for_get_current_time(current_time);
+
         if (config->authentication_mode == DEVICE_AUTH_MODE_CBS)
         {
             if (auth_state == AUTHENTICATION_STATE_STOPPED)
             {
                 STRICT_EXPECTED_CALL(authentication_start(TEST_AUTHENTICATION_HANDLE, TEST_CBS_HANDLE)).SetReturn(0);
             }
-            else if (auth_state == AUTHENTICATION_STATE_STARTING)
-            {
-                set_expected_calls_for_is_timeout_reached(current_time);
-            }
         }
 
         if (config->authentication_mode == DEVICE_AUTH_MODE_X509 || auth_state == AUTHENTICATION_STATE_STARTED)
@@ -549,19 +537,11 @@ static void set_expected_calls_for_device_do_work(DEVICE_CONFIG* config, time_t
             {
                 STRICT_EXPECTED_CALL(telemetry_messenger_start(TEST_TELEMETRY_MESSENGER_HANDLE, TEST_SESSION_HANDLE));
             }
-            else if (msgr_state == TELEMETRY_MESSENGER_STATE_STARTING)
-            {
-                set_expected_calls_for_is_timeout_reached(current_time);
-            }
 
 			if (twin_msgr_state == TWIN_MESSENGER_STATE_STOPPED)
 			{
 				STRICT_EXPECTED_CALL(twin_messenger_start(TEST_TWIN_MESSENGER_HANDLE, TEST_SESSION_HANDLE));
 			}
-			else if (twin_msgr_state == TWIN_MESSENGER_STATE_STARTING)
-			{
-				set_expected_calls_for_is_timeout_reached(current_time);
-			}
         }
     }
 
@@ -584,7 +564,7 @@ static void set_expected_calls_for_device_do_work(DEVICE_CONFIG* config, time_t
 	}
 }
 
-static void set_expected_calls_for_device_destroy(DEVICE_HANDLE handle, DEVICE_CONFIG *config, time_t current_time, DEVICE_STATE device_state, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE msgr_state, TWIN_MESSENGER_STATE twin_msgr_state)
+static void set_expected_calls_for_device_destroy(DEVICE_HANDLE handle, DEVICE_CONFIG *config, tickcounter_ms_t current_time, DEVICE_STATE device_state, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE msgr_state, TWIN_MESSENGER_STATE twin_msgr_state)
 {
     if (device_state == DEVICE_STATE_STARTED || device_state == DEVICE_STATE_STARTING)
     {
@@ -646,6 +626,10 @@ static void set_expected_calls_for_device_set_option(DEVICE_HANDLE handle, DEVIC
     {
         STRICT_EXPECTED_CALL(telemetry_messenger_set_option(TEST_TELEMETRY_MESSENGER_HANDLE, MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, option_value));
     }
+    else if (strcmp(DEVICE_OPTION_MESSAGE_POOL_SIZE, option_name) == 0)
+    {
+        STRICT_EXPECTED_CALL(telemetry_messenger_set_option(TEST_TELEMETRY_MESSENGER_HANDLE, MESSENGER_OPTION_MESSAGE_POOL_SIZE, option_value));
+    }
     else if (strcmp(DEVICE_OPTION_SAVED_MESSENGER_OPTIONS, option_name) == 0)
     {
         STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)option_value, TEST_TELEMETRY_MESSENGER_HANDLE));
@@ -668,14 +652,14 @@ static void set_expected_calls_for_device_send_async(DEVICE_CONFIG *config)
 
 // ---------- set_expected*-dependent Test Helpers ---------- //
 
-static DEVICE_HANDLE create_device(DEVICE_CONFIG* config, time_t current_time)
+static DEVICE_HANDLE create_device(DEVICE_CONFIG* config, tickcounter_ms_t current_time)
 {
     umock_c_reset_all_calls();
     set_expected_calls_for_device_create(config, current_time);
     return device_create(config);
 }
 
-static DEVICE_HANDLE create_and_start_device(DEVICE_CONFIG* config, time_t current_time)
+static DEVICE_HANDLE create_and_start_device(DEVICE_CONFIG* config, tickcounter_ms_t current_time)
 {
     DEVICE_HANDLE handle = create_device(config, current_time);
 
@@ -693,16 +677,16 @@ static DEVICE_HANDLE create_and_start_device(DEVICE_CONFIG* config, time_t curre
     return handle;
 }
 
-static void crank_device_do_work(DEVICE_HANDLE handle, DEVICE_CONFIG* config, time_t current_time, DEVICE_STATE device_state, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE msgr_state, TWIN_MESSENGER_STATE twin_msgr_state)
+static void crank_device_do_work(DEVICE_HANDLE handle, DEVICE_CONFIG* config, tickcounter_ms_t current_time, DEVICE_STATE device_state, AUTHENTICATION_STATE auth_state, TELEMETRY_MESSENGER_STATE msgr_state, TWIN_MESSENGER_STATE twin_msgr_state)
 {
     umock_c_reset_all_calls();
     set_expected_calls_for_device_do_work(config, current_time, device_state, auth_state, msgr_state, twin_msgr_state);
     device_do_work(handle);
 }
 
-static void set_authentication_state(AUTHENTICATION_STATE previous_state, AUTHENTICATION_STATE new_state, time_t current_time)
+static void set_authentication_state(AUTHENTICATION_STATE previous_state, AUTHENTICATION_STATE new_state, tickcounter_ms_t current_time)
 {
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+    set_expected_calls_for_get_current_time(current_time);
 
     TEST_authentication_create_saved_on_authentication_changed_callback(
         TEST_authentication_create_saved_on_authentication_changed_context, 
@@ -710,9 +694,9 @@ static void set_authentication_state(AUTHENTICATION_STATE previous_state, AUTHEN
         new_state);
 }
 
-static void set_messenger_state(TELEMETRY_MESSENGER_STATE previous_state, TELEMETRY_MESSENGER_STATE new_state, time_t current_time)
+static void set_messenger_state(TELEMETRY_MESSENGER_STATE previous_state, TELEMETRY_MESSENGER_STATE new_state, tickcounter_ms_t current_time)
 {
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+    set_expected_calls_for_get_current_time(current_time);
 
     TEST_telemetry_messenger_create_saved_on_state_changed_callback(
         TEST_telemetry_messenger_create_saved_on_state_changed_context, 
@@ -720,9 +704,9 @@ static void set_messenger_state(TELEMETRY_MESSENGER_STATE previous_state, TELEME
         new_state);
 }
 
-static void set_twin_messenger_state(TWIN_MESSENGER_STATE previous_state, TWIN_MESSENGER_STATE new_state, time_t current_time)
+static void set_twin_messenger_state(TWIN_MESSENGER_STATE previous_state, TWIN_MESSENGER_STATE new_state, tickcounter_ms_t current_time)
 {
-	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+	set_expected_calls_for_get_current_time(current_time);
 
 	TEST_twin_messenger_create_on_state_changed_callback(
 		TEST_twin_messenger_create_on_state_changed_context,
@@ -730,7 +714,7 @@ static void set_twin_messenger_state(TWIN_MESSENGER_STATE previous_state, TWIN_M
 		new_state);
 }
 
-static DEVICE_HANDLE create_and_start_and_crank_device(DEVICE_CONFIG* config, time_t current_time)
+static DEVICE_HANDLE create_and_start_and_crank_device(DEVICE_CONFIG* config, tickcounter_ms_t current_time)
 {
     DEVICE_HANDLE handle = create_and_start_device(config, current_time);
 
@@ -847,6 +831,22 @@ TEST_FUNCTION(device_create_NULL_config_on_state_changed_callback)
     // cleanup
 }
 
+// Tests_SRS_DEVICE_09_152: [If `config->tick_counter` is NULL then device_create shall fail and return NULL]
+TEST_FUNCTION(device_create_NULL_config_tick_counter)
+{
+    // arrange
+    DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
+    config->tick_counter = NULL;
+
+    // act
+    DEVICE_HANDLE handle = device_create(config);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+
+    // cleanup
+}
+
 // Tests_SRS_DEVICE_09_002: [device_create shall allocate memory for the device instance structure]
 // Tests_SRS_DEVICE_09_004: [All `config` parameters shall be saved into `instance`]
 // Tests_SRS_DEVICE_09_006: [If `instance->authentication_mode` is DEVICE_AUTH_MODE_CBS, `instance->authentication_handle` shall be set using authentication_create()]
@@ -1702,6 +1702,67 @@ TEST_FUNCTION(device_set_option_saved_auth_options_fails)
     device_destroy(handle);
 }
 
+// Tests_SRS_DEVICE_09_156: [If `name` is DEVICE_OPTION_MESSAGE_POOL_SIZE, `value` shall be passed to telemetry_messenger_set_option as MESSENGER_OPTION_MESSAGE_POOL_SIZE]
+// Tests_SRS_DEVICE_09_092: [If no failures occur, device_set_option shall return 0]
+TEST_FUNCTION(device_set_option_MESSAGE_POOL_SIZE_succeeds)
+{
+    // arrange
+    ASSERT_IS_TRUE_WITH_MSG(INDEFINITE_TIME != TEST_current_time, "Failed setting TEST_current_time");
+
+    DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
+    DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
+
+    size_t value = 16;
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_device_set_option(handle, config, DEVICE_OPTION_MESSAGE_POOL_SIZE, &value);
+
+    // act
+    int result = device_set_option(handle, DEVICE_OPTION_MESSAGE_POOL_SIZE, &value);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    device_destroy(handle);
+}
+
+// Tests_SRS_DEVICE_09_156: [If `name` is DEVICE_OPTION_MESSAGE_POOL_SIZE, `value` shall be passed to telemetry_messenger_set_option as MESSENGER_OPTION_MESSAGE_POOL_SIZE]
+// Tests_SRS_DEVICE_09_087: [If telemetry_messenger_set_option fails, device_set_option shall return a non-zero result]
+TEST_FUNCTION(device_set_option_MESSAGE_POOL_SIZE_fails)
+{
+    // arrange
+    ASSERT_IS_TRUE_WITH_MSG(INDEFINITE_TIME != TEST_current_time, "Failed setting TEST_current_time");
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
+    DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
+
+    size_t value = 16;
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_device_set_option(handle, config, DEVICE_OPTION_MESSAGE_POOL_SIZE, &value);
+    umock_c_negative_tests_snapshot();
+
+    umock_c_negative_tests_reset();
+    umock_c_negative_tests_fail_call(0);
+
+    // act
+    int result = device_set_option(handle, DEVICE_OPTION_MESSAGE_POOL_SIZE, &value);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(handle);
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    umock_c_reset_all_calls();
+
+    device_destroy(handle);
+}
+
 // Tests_SRS_DEVICE_09_087: [If telemetry_messenger_set_option fails, device_set_option shall return a non-zero result]
 TEST_FUNCTION(device_set_option_saved_msgr_options_fails)
 {
@@ -2163,7 +2224,7 @@ TEST_FUNCTION(device_do_work_authentication_start_times_out)
     DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
     DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
 
-    time_t next_time = add_seconds(TEST_current_time, DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS + 1);
+    tickcounter_ms_t next_time = add_seconds(TEST_current_time, DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS + 1);
 
     umock_c_reset_all_calls();
     set_expected_calls_for_device_do_work(config, TEST_current_time, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STOPPED, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
@@ -2186,6 +2247,68 @@ TEST_FUNCTION(device_do_work_authentication_start_times_out)
     device_destroy(handle);
 }
 
+// Tests_SRS_DEVICE_09_153: [If the device state is DEVICE_STATE_STARTING, the current time shall be obtained once using tickcounter_get_current_ms() and used for all timeout verifications in this call]
+TEST_FUNCTION(device_do_work_authentication_start_tickcounter_get_current_ms_fails)
+{
+    // arrange
+    DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
+    DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
+
+    umock_c_reset_all_calls();
+    crank_device_do_work(handle, config, TEST_current_time, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STOPPED, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
+    set_authentication_state(AUTHENTICATION_STATE_STOPPED, AUTHENTICATION_STATE_STARTING, TEST_current_time);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(authentication_do_work(TEST_AUTHENTICATION_HANDLE));
+
+    // act
+    device_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, DEVICE_STATE_STARTING, TEST_on_state_changed_callback_saved_previous_state);
+    ASSERT_ARE_EQUAL(int, DEVICE_STATE_ERROR_AUTH, TEST_on_state_changed_callback_saved_new_state);
+
+    // cleanup
+    device_destroy(handle);
+}
+
+// Tests_SRS_DEVICE_09_154: [The time of each authentication, messenger or TWIN messenger state change shall be obtained using tickcounter_get_current_ms() on `config->tick_counter`]
+// Tests_SRS_DEVICE_09_155: [Timeouts shall be verified using the unsigned difference between the current time and the time of the last state change, so the verification is not affected by the tick counter wrapping around]
+TEST_FUNCTION(device_do_work_authentication_start_times_out_tick_counter_wraparound)
+{
+    // arrange
+    DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
+    DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
+
+    tickcounter_ms_t state_change_time = TEST_TICK_COUNTER_MAX_MS - 999;
+
+    umock_c_reset_all_calls();
+    crank_device_do_work(handle, config, state_change_time, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STOPPED, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
+    set_authentication_state(AUTHENTICATION_STATE_STOPPED, AUTHENTICATION_STATE_STARTING, state_change_time);
+
+    // 1000 ms elapse until the counter wraps; 1 ms short of the timeout.
+    crank_device_do_work(handle, config, DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS * 1000 - 1001, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STARTING, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, DEVICE_STATE_STARTING, TEST_on_state_changed_callback_saved_new_state);
+
+    umock_c_reset_all_calls();
+    set_expected_calls_for_device_do_work(config, DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS * 1000 - 1000, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STARTING, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
+
+    // act
+    device_do_work(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, DEVICE_STATE_STARTING, TEST_on_state_changed_callback_saved_previous_state);
+    ASSERT_ARE_EQUAL(int, DEVICE_STATE_ERROR_AUTH_TIMEOUT, TEST_on_state_changed_callback_saved_new_state);
+
+    // cleanup
+    device_destroy(handle);
+}
+
 // Tests_SRS_DEVICE_09_038: [If authentication state is AUTHENTICATION_STATE_ERROR and error code is AUTH_FAILED, the device state shall be updated to DEVICE_STATE_ERROR_AUTH]
 TEST_FUNCTION(device_do_work_authentication_start_AUTH_FAILED)
 {
@@ -2302,7 +2425,7 @@ TEST_FUNCTION(device_do_work_telemetry_messenger_start_timeout)
     DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
     DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
 
-    time_t next_time = add_seconds(TEST_current_time, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS + 1);
+    tickcounter_ms_t next_time = add_seconds(TEST_current_time, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS + 1);
 
     umock_c_reset_all_calls();
     crank_device_do_work(handle, config, TEST_current_time, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STOPPED, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
@@ -2346,11 +2469,11 @@ TEST_FUNCTION(device_do_work_succeeds)
     DEVICE_CONFIG* config = get_device_config(DEVICE_AUTH_MODE_CBS);
     DEVICE_HANDLE handle = create_and_start_device(config, TEST_current_time);
 
-    time_t t0 = TEST_current_time;
-    time_t t1 = add_seconds(t0, DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS - 1);
-    time_t t2 = add_seconds(t1, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS - 2);
-    time_t t3 = add_seconds(t2, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS - 1);
-    time_t t4 = add_seconds(t3, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS + 1);
+    tickcounter_ms_t t0 = TEST_current_time;
+    tickcounter_ms_t t1 = add_seconds(t0, DEFAULT_AUTH_STATE_CHANGED_TIMEOUT_SECS - 1);
+    tickcounter_ms_t t2 = add_seconds(t1, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS - 2);
+    tickcounter_ms_t t3 = add_seconds(t2, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS - 1);
+    tickcounter_ms_t t4 = add_seconds(t3, DEFAULT_MSGR_STATE_CHANGED_TIMEOUT_SECS + 1);
 
     umock_c_reset_all_calls();
     crank_device_do_work(handle, config, t0, DEVICE_STATE_STARTING, AUTHENTICATION_STATE_STOPPED, TELEMETRY_MESSENGER_STATE_STOPPED, TWIN_MESSENGER_STATE_STOPPED);
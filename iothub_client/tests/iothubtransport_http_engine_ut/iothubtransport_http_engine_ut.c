@@ -0,0 +1,1466 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdarg>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void* real_realloc(void* ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+void real_free(void* ptr)
+{
+	free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/platform.h"
+#undef ENABLE_MOCKS
+
+#include "iothubtransport_http_engine.h"
+#include "iothub_client_tls_session_cache.h"
+
+#include "real_strings.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int real_mallocAndStrcpy_s(char** destination, const char* source);
+
+// STRING_construct_sprintf and STRING_sprintf are variadic and cannot be mocked.
+STRING_HANDLE STRING_construct_sprintf(const char* format, ...)
+{
+	char buffer[1024];
+	va_list args;
+	va_start(args, format);
+	(void)vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	return real_STRING_construct(buffer);
+}
+
+int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
+{
+	char buffer[1024];
+	va_list args;
+	va_start(args, format);
+	(void)vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	return real_STRING_concat(handle, buffer);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+	char temp_str[256];
+	(void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+	ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_HOST_NAME                      "some.host.name"
+#define TEST_RELATIVE_PATH                  "/devices/d1/messages/events?api-version=2016-11-14"
+#define TEST_TICK_COUNTER_HANDLE            (TICK_COUNTER_HANDLE)0x4441
+#define TEST_OPTIONHANDLER_HANDLE           (OPTIONHANDLER_HANDLE)0x4442
+#define TEST_REQUEST_HEADERS                (HTTP_HEADERS_HANDLE)0x4443
+#define TEST_RESPONSE_HEADERS               (HTTP_HEADERS_HANDLE)0x4444
+#define TEST_TLSIO_INTERFACE                (const IO_INTERFACE_DESCRIPTION*)0x4445
+#define TEST_XIO_HANDLE_BASE                0x4500
+#define TEST_MAX_XIOS                       8
+#define TEST_REQUEST_TIMEOUT_MS             1000
+#define TEST_CONTEXT_1                      (void*)0x4601
+#define TEST_CONTEXT_2                      (void*)0x4602
+#define TEST_CONTEXT_3                      (void*)0x4603
+
+static tickcounter_ms_t g_current_ms;
+static size_t g_xio_count;
+static const char* g_request_header;
+
+typedef struct TEST_XIO_TAG
+{
+	ON_IO_OPEN_COMPLETE on_io_open_complete;
+	void* on_io_open_complete_context;
+	ON_BYTES_RECEIVED on_bytes_received;
+	void* on_bytes_received_context;
+	ON_IO_ERROR on_io_error;
+	void* on_io_error_context;
+	ON_SEND_COMPLETE on_send_complete;
+	void* on_send_complete_context;
+	char sent[1024];
+	size_t sent_size;
+	const char* bytes_on_dowork;
+} TEST_XIO;
+
+static TEST_XIO g_xios[TEST_MAX_XIOS];
+
+typedef struct TEST_RESPONSE_TAG
+{
+	size_t count;
+	void* context;
+	HTTP_ENGINE_RESULT result;
+	unsigned int status_code;
+	char content[256];
+	size_t content_size;
+} TEST_RESPONSE;
+
+static TEST_RESPONSE g_response;
+
+
+// Helpers
+
+static XIO_HANDLE get_xio_handle(size_t index)
+{
+	return (XIO_HANDLE)(uintptr_t)(TEST_XIO_HANDLE_BASE + index);
+}
+
+static TEST_XIO* get_test_xio(XIO_HANDLE xio)
+{
+	return &g_xios[(uintptr_t)xio - TEST_XIO_HANDLE_BASE];
+}
+
+static XIO_HANDLE TEST_get_io_transport(const char* fully_qualified_name)
+{
+	ASSERT_ARE_EQUAL(char_ptr, TEST_HOST_NAME, fully_qualified_name);
+	return get_xio_handle(g_xio_count++);
+}
+
+static int TEST_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+	TEST_XIO* test_xio = get_test_xio(xio);
+	test_xio->on_io_open_complete = on_io_open_complete;
+	test_xio->on_io_open_complete_context = on_io_open_complete_context;
+	test_xio->on_bytes_received = on_bytes_received;
+	test_xio->on_bytes_received_context = on_bytes_received_context;
+	test_xio->on_io_error = on_io_error;
+	test_xio->on_io_error_context = on_io_error_context;
+	return 0;
+}
+
+static int TEST_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+	TEST_XIO* test_xio = get_test_xio(xio);
+	ASSERT_IS_TRUE(size < sizeof(test_xio->sent));
+	(void)memcpy(test_xio->sent, buffer, size);
+	test_xio->sent[size] = '\0';
+	test_xio->sent_size = size;
+	test_xio->on_send_complete = on_send_complete;
+	test_xio->on_send_complete_context = callback_context;
+	return 0;
+}
+
+static void TEST_xio_dowork(XIO_HANDLE xio)
+{
+	TEST_XIO* test_xio = get_test_xio(xio);
+	const char* bytes = test_xio->bytes_on_dowork;
+
+	if (bytes != NULL)
+	{
+		test_xio->bytes_on_dowork = NULL;
+		test_xio->on_bytes_received(test_xio->on_bytes_received_context, (const unsigned char*)bytes, strlen(bytes));
+	}
+}
+
+static int TEST_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+	(void)tick_counter;
+	*current_ms = g_current_ms;
+	return 0;
+}
+
+static HTTP_HEADERS_RESULT TEST_HTTPHeaders_GetHeaderCount(HTTP_HEADERS_HANDLE handle, size_t* headerCount)
+{
+	(void)handle;
+	*headerCount = 1;
+	return HTTP_HEADERS_OK;
+}
+
+static HTTP_HEADERS_RESULT TEST_HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t index, char** destination)
+{
+	(void)handle;
+	(void)index;
+	return (real_mallocAndStrcpy_s(destination, g_request_header) == 0) ? HTTP_HEADERS_OK : HTTP_HEADERS_ERROR;
+}
+
+static void on_response(void* context, HTTP_ENGINE_RESULT result, unsigned int status_code, HTTP_HEADERS_HANDLE response_headers, const unsigned char* content, size_t content_size)
+{
+	(void)response_headers;
+	g_response.count++;
+	g_response.context = context;
+	g_response.result = result;
+	g_response.status_code = status_code;
+	ASSERT_IS_TRUE(content_size < sizeof(g_response.content));
+	if (content_size > 0)
+	{
+		(void)memcpy(g_response.content, content, content_size);
+	}
+	g_response.content[content_size] = '\0';
+	g_response.content_size = content_size;
+}
+
+static void register_global_mock_hooks()
+{
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(realloc, real_realloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+	REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
+	REGISTER_STRING_GLOBAL_MOCK_HOOK;
+	REGISTER_GLOBAL_MOCK_HOOK(xio_open, TEST_xio_open);
+	REGISTER_GLOBAL_MOCK_HOOK(xio_send, TEST_xio_send);
+	REGISTER_GLOBAL_MOCK_HOOK(xio_dowork, TEST_xio_dowork);
+	REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, TEST_tickcounter_get_current_ms);
+	REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_GetHeaderCount, TEST_HTTPHeaders_GetHeaderCount);
+	REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_GetHeader, TEST_HTTPHeaders_GetHeader);
+}
+
+static void register_global_mock_returns()
+{
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, __LINE__);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_concat, __LINE__);
+	REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, __LINE__);
+	REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Create, TEST_OPTIONHANDLER_HANDLE);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_Create, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_AddOption, OPTIONHANDLER_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_AddOption, OPTIONHANDLER_ERROR);
+	REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_ERROR);
+	REGISTER_GLOBAL_MOCK_RETURN(xio_setoption, 0);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(xio_open, __LINE__);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(xio_send, __LINE__);
+	REGISTER_GLOBAL_MOCK_RETURN(HTTPHeaders_Alloc, TEST_RESPONSE_HEADERS);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPHeaders_Alloc, NULL);
+	REGISTER_GLOBAL_MOCK_RETURN(HTTPHeaders_AddHeaderNameValuePair, HTTP_HEADERS_OK);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPHeaders_AddHeaderNameValuePair, HTTP_HEADERS_ERROR);
+	REGISTER_GLOBAL_MOCK_RETURN(platform_get_default_tlsio, TEST_TLSIO_INTERFACE);
+	REGISTER_GLOBAL_MOCK_RETURN(xio_create, get_xio_handle(0));
+}
+
+static void register_umock_alias_types()
+{
+	REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(HTTP_HEADERS_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(HTTP_HEADERS_RESULT, int);
+	REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_RESULT, int);
+	REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(const IO_INTERFACE_DESCRIPTION*, void*);
+}
+
+static HTTP_ENGINE_CONFIG get_config()
+{
+	HTTP_ENGINE_CONFIG config;
+	config.host_name = TEST_HOST_NAME;
+	config.get_io_transport = TEST_get_io_transport;
+	config.request_timeout_ms = TEST_REQUEST_TIMEOUT_MS;
+	return config;
+}
+
+static void set_expected_calls_for_http_engine_create()
+{
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_HOST_NAME))
+		.IgnoreArgument_destination();
+	STRICT_EXPECTED_CALL(tickcounter_create());
+	STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreAllArguments();
+}
+
+static void set_expected_calls_for_execute_request_async()
+{
+	// Request line and Host header (STRING_construct_sprintf), Content-Length (STRING_sprintf).
+	STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "\r\n"))
+		.IgnoreArgument_handle();
+	STRICT_EXPECTED_CALL(STRING_length(IGNORED_PTR_ARG))
+		.IgnoreArgument_handle();
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+	STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+		.IgnoreArgument_handle();
+	STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+		.IgnoreArgument_handle();
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument_current_ms();
+}
+
+static HTTP_ENGINE_HANDLE create_http_engine(size_t max_connections)
+{
+	HTTP_ENGINE_CONFIG config = get_config();
+	HTTP_ENGINE_HANDLE handle = http_engine_create(&config);
+	ASSERT_IS_NOT_NULL(handle);
+	ASSERT_ARE_EQUAL(int, 0, http_engine_set_max_connections(handle, max_connections));
+	umock_c_reset_all_calls();
+	return handle;
+}
+
+static void submit_request(HTTP_ENGINE_HANDLE handle, void* context)
+{
+	ASSERT_ARE_EQUAL(int, 0, http_engine_execute_request_async(handle, HTTPAPI_REQUEST_POST, TEST_RELATIVE_PATH, NULL, (const unsigned char*)"abc", 3, on_response, context));
+}
+
+static void submit_get_request(HTTP_ENGINE_HANDLE handle, void* context)
+{
+	ASSERT_ARE_EQUAL(int, 0, http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, context));
+}
+
+// Opens connection `xio_index` for the oldest pending request and sends it.
+static void open_connection_and_send(HTTP_ENGINE_HANDLE handle, size_t xio_index)
+{
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(size_t, xio_index + 1, g_xio_count);
+	g_xios[xio_index].on_io_open_complete(g_xios[xio_index].on_io_open_complete_context, IO_OPEN_OK);
+	http_engine_dowork(handle);
+	ASSERT_ARE_NOT_EQUAL(size_t, 0, g_xios[xio_index].sent_size);
+	umock_c_reset_all_calls();
+}
+
+static void receive_bytes(size_t xio_index, const char* bytes)
+{
+	g_xios[xio_index].on_bytes_received(g_xios[xio_index].on_bytes_received_context, (const unsigned char*)bytes, strlen(bytes));
+}
+
+
+BEGIN_TEST_SUITE(iothubtransport_http_engine_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+	TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+	g_testByTest = TEST_MUTEX_CREATE();
+	ASSERT_IS_NOT_NULL(g_testByTest);
+
+	umock_c_init(on_umock_c_error);
+
+	int result = umocktypes_charptr_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_stdint_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+	result = umocktypes_bool_register_types();
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	register_umock_alias_types();
+	register_global_mock_returns();
+	register_global_mock_hooks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+	umock_c_deinit();
+
+	TEST_MUTEX_DESTROY(g_testByTest);
+	TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+	if (TEST_MUTEX_ACQUIRE(g_testByTest))
+	{
+		ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+	}
+
+	g_current_ms = 0;
+	g_xio_count = 0;
+	g_request_header = "iothub-to: /devices/d1/messages/events";
+	(void)memset(g_xios, 0, sizeof(g_xios));
+	(void)memset(&g_response, 0, sizeof(g_response));
+
+	umock_c_reset_all_calls();
+	umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+	TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_001: [If `config` or `config->host_name` are NULL, http_engine_create() shall fail and return NULL]
+TEST_FUNCTION(create_NULL_config_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	HTTP_ENGINE_HANDLE handle = http_engine_create(NULL);
+
+	// assert
+	ASSERT_IS_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_001: [If `config` or `config->host_name` are NULL, http_engine_create() shall fail and return NULL]
+TEST_FUNCTION(create_NULL_host_name_fails)
+{
+	// arrange
+	HTTP_ENGINE_CONFIG config = get_config();
+	config.host_name = NULL;
+	umock_c_reset_all_calls();
+
+	// act
+	HTTP_ENGINE_HANDLE handle = http_engine_create(&config);
+
+	// assert
+	ASSERT_IS_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_002: [http_engine_create() shall allocate memory for the engine instance]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_006: [http_engine_create() shall copy `config->host_name` using mallocAndStrcpy_s]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_007: [http_engine_create() shall create a tick counter using tickcounter_create()]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_008: [http_engine_create() shall create an option handler using OptionHandler_Create() to hold the options of the connections]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_009: [The engine shall be created with no connections]
+TEST_FUNCTION(create_success)
+{
+	// arrange
+	HTTP_ENGINE_CONFIG config = get_config();
+	umock_c_reset_all_calls();
+	set_expected_calls_for_http_engine_create();
+
+	// act
+	HTTP_ENGINE_HANDLE handle = http_engine_create(&config);
+
+	// assert
+	ASSERT_IS_NOT_NULL(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, TEST_CONTEXT_1));
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_003: [If any failure occurs, http_engine_create() shall free any memory it allocated and return NULL]
+TEST_FUNCTION(create_failure_checks)
+{
+	// arrange
+	HTTP_ENGINE_CONFIG config = get_config();
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+	umock_c_reset_all_calls();
+	set_expected_calls_for_http_engine_create();
+	umock_c_negative_tests_snapshot();
+
+	size_t i;
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		umock_c_negative_tests_reset();
+		umock_c_negative_tests_fail_call(i);
+
+		// act
+		HTTP_ENGINE_HANDLE handle = http_engine_create(&config);
+
+		// assert
+		ASSERT_IS_NULL_WITH_MSG(handle, "Unexpected handle on negative test");
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_004: [If `config->get_io_transport` is NULL, connections shall use a TLS I/O to `config->host_name` on port 443 created with platform_get_default_tlsio()]
+TEST_FUNCTION(dowork_default_io_transport_is_tlsio)
+{
+	// arrange
+	HTTP_ENGINE_CONFIG config = get_config();
+	config.get_io_transport = NULL;
+	HTTP_ENGINE_HANDLE handle = http_engine_create(&config);
+	ASSERT_ARE_EQUAL(int, 0, http_engine_set_max_connections(handle, 1));
+	submit_request(handle, TEST_CONTEXT_1);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument_current_ms();
+	STRICT_EXPECTED_CALL(platform_get_default_tlsio());
+	STRICT_EXPECTED_CALL(xio_create(TEST_TLSIO_INTERFACE, IGNORED_PTR_ARG))
+		.IgnoreArgument_io_create_parameters();
+	STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(TEST_OPTIONHANDLER_HANDLE, get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(xio_open(get_xio_handle(0), IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreAllArguments();
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_010: [If `http_engine_handle` is NULL, http_engine_destroy() shall return]
+TEST_FUNCTION(destroy_NULL_handle)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	http_engine_destroy(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_011: [http_engine_destroy() shall complete every in-flight and pending request with HTTP_ENGINE_CANCELLED]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_012: [http_engine_destroy() shall destroy the I/O of each connection using xio_destroy()]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_013: [http_engine_destroy() shall destroy the option handler, the tick counter and free the engine]
+TEST_FUNCTION(destroy_cancels_requests_and_frees_everything)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	submit_request(handle, TEST_CONTEXT_2);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(xio_destroy(get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+	STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(free(handle));
+
+	// act
+	http_engine_destroy(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 2, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_CANCELLED, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_2, g_response.context);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_014: [If `http_engine_handle` is NULL, http_engine_set_max_connections() shall fail and return non-zero]
+TEST_FUNCTION(set_max_connections_NULL_handle_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	int result = http_engine_set_max_connections(NULL, 4);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_015: [If called from a response callback, http_engine_set_max_connections() shall fail and return non-zero]
+static HTTP_ENGINE_HANDLE g_engine_to_resize;
+static int g_resize_result;
+static void on_response_resize(void* context, HTTP_ENGINE_RESULT result, unsigned int status_code, HTTP_HEADERS_HANDLE response_headers, const unsigned char* content, size_t content_size)
+{
+	on_response(context, result, status_code, response_headers, content, content_size);
+	g_resize_result = http_engine_set_max_connections(g_engine_to_resize, 2);
+}
+
+TEST_FUNCTION(set_max_connections_from_callback_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	g_engine_to_resize = handle;
+	g_resize_result = 0;
+	ASSERT_ARE_EQUAL(int, 0, http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response_resize, TEST_CONTEXT_1));
+	open_connection_and_send(handle, 0);
+	g_xios[0].bytes_on_dowork = "HTTP/1.1 204 No Content\r\n\r\n";
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_NOT_EQUAL(int, 0, g_resize_result);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_016: [If any request is in flight, http_engine_set_max_connections() shall fail and return non-zero]
+TEST_FUNCTION(set_max_connections_with_request_in_flight_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// act
+	int result = http_engine_set_max_connections(handle, 2);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.count);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_017: [http_engine_set_max_connections() shall destroy all existing connections]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_019: [http_engine_set_max_connections() shall allocate `max_connections` closed connections]
+TEST_FUNCTION(set_max_connections_closes_idle_connections)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.1 204 No Content\r\n\r\n");
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(xio_destroy(get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+
+	// act
+	int result = http_engine_set_max_connections(handle, 4);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_018: [If `max_connections` is zero, pending requests shall be completed with HTTP_ENGINE_CANCELLED]
+TEST_FUNCTION(set_max_connections_zero_cancels_pending_requests)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	umock_c_reset_all_calls();
+
+	// act
+	int result = http_engine_set_max_connections(handle, 0);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_CANCELLED, g_response.result);
+	ASSERT_ARE_NOT_EQUAL(int, 0, http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, TEST_CONTEXT_1));
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_020: [If the allocation fails, http_engine_set_max_connections() shall fail, leave the engine with no connections and return non-zero]
+TEST_FUNCTION(set_max_connections_malloc_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(0);
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG))
+		.SetReturn(NULL);
+
+	// act
+	int result = http_engine_set_max_connections(handle, 4);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, TEST_CONTEXT_1));
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_021: [If `http_engine_handle`, `name` or `value` are NULL, http_engine_set_option() shall fail and return non-zero]
+TEST_FUNCTION(set_option_NULL_arguments_fail)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+
+	// act
+	int result1 = http_engine_set_option(NULL, "TrustedCerts", "certs");
+	int result2 = http_engine_set_option(handle, NULL, "certs");
+	int result3 = http_engine_set_option(handle, "TrustedCerts", NULL);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_022: [Only OPTION_TRUSTED_CERT, OPTION_X509_CERT, OPTION_X509_PRIVATE_KEY and OPTION_TLS_SESSION_STORE shall be supported; for any other `name` http_engine_set_option() shall fail and return non-zero]
+TEST_FUNCTION(set_option_unsupported_option_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+
+	// act
+	int result = http_engine_set_option(handle, "proxy_data", "proxy");
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_023: [The option shall be saved using OptionHandler_AddOption() and applied to every connection opened afterwards]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_025: [The option shall also be set on the I/O of each existing connection using xio_setoption()]
+TEST_FUNCTION(set_option_saves_and_applies_option)
+{
+	// arrange
+	TLS_SESSION_STORE store;
+	HTTP_ENGINE_HANDLE handle = create_http_engine(2);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_TLS_SESSION_STORE, &store));
+	STRICT_EXPECTED_CALL(xio_setoption(get_xio_handle(0), OPTION_TLS_SESSION_STORE, &store));
+
+	// act
+	int result = http_engine_set_option(handle, OPTION_TLS_SESSION_STORE, &store);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_024: [If OptionHandler_AddOption() fails, http_engine_set_option() shall fail and return non-zero]
+TEST_FUNCTION(set_option_AddOption_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "TrustedCerts", IGNORED_PTR_ARG))
+		.IgnoreArgument_value()
+		.SetReturn(OPTIONHANDLER_ERROR);
+
+	// act
+	int result = http_engine_set_option(handle, "TrustedCerts", "certs");
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_026: [If `http_engine_handle`, `relative_path` or `on_response` are NULL, or `content` is NULL and `content_size` is not zero, http_engine_execute_request_async() shall fail and return non-zero]
+TEST_FUNCTION(execute_request_async_invalid_arguments_fail)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+
+	// act
+	int result1 = http_engine_execute_request_async(NULL, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, TEST_CONTEXT_1);
+	int result2 = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, NULL, NULL, NULL, 0, on_response, TEST_CONTEXT_1);
+	int result3 = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, NULL, TEST_CONTEXT_1);
+	int result4 = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_POST, TEST_RELATIVE_PATH, NULL, NULL, 3, on_response, TEST_CONTEXT_1);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result4);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_027: [If `request_type` is not a valid HTTPAPI_REQUEST_TYPE, http_engine_execute_request_async() shall fail and return non-zero]
+TEST_FUNCTION(execute_request_async_invalid_request_type_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+
+	// act
+	int result = http_engine_execute_request_async(handle, (HTTPAPI_REQUEST_TYPE)100, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, TEST_CONTEXT_1);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_028: [If the engine has no connections, http_engine_execute_request_async() shall fail and return non-zero]
+TEST_FUNCTION(execute_request_async_no_connections_fails)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(0);
+
+	// act
+	int result = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, NULL, 0, on_response, TEST_CONTEXT_1);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_029: [The request shall be serialized at once into its request line, a Host header, the headers in `request_headers` except Host and Content-Length, a Content-Length header and `content`]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_031: [The time of submission shall be read using tickcounter_get_current_ms()]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_032: [The request shall be queued behind the pending requests and http_engine_execute_request_async() shall return 0; it is only sent by http_engine_dowork()]
+TEST_FUNCTION(execute_request_async_success)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	set_expected_calls_for_execute_request_async();
+
+	// act
+	int result = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_POST, TEST_RELATIVE_PATH, NULL, (const unsigned char*)"abc", 3, on_response, TEST_CONTEXT_1);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 0, g_xio_count);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_029: [The request shall be serialized at once into its request line, a Host header, the headers in `request_headers` except Host and Content-Length, a Content-Length header and `content`]
+TEST_FUNCTION(execute_request_async_serializes_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+
+	// act
+	int result = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_POST, TEST_RELATIVE_PATH, TEST_REQUEST_HEADERS, (const unsigned char*)"abc", 3, on_response, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr,
+		"POST " TEST_RELATIVE_PATH " HTTP/1.1\r\n"
+		"Host: " TEST_HOST_NAME "\r\n"
+		"iothub-to: /devices/d1/messages/events\r\n"
+		"Content-Length: 3\r\n"
+		"\r\n"
+		"abc", g_xios[0].sent);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_029: [The request shall be serialized at once into its request line, a Host header, the headers in `request_headers` except Host and Content-Length, a Content-Length header and `content`]
+TEST_FUNCTION(execute_request_async_skips_caller_host_header)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	g_request_header = "Host: other.host";
+
+	// act
+	int result = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_REQUEST_HEADERS, NULL, 0, on_response, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, "GET " TEST_RELATIVE_PATH " HTTP/1.1\r\nHost: " TEST_HOST_NAME "\r\n\r\n", g_xios[0].sent);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_030: [If the serialization fails, http_engine_execute_request_async() shall fail and return non-zero]
+TEST_FUNCTION(execute_request_async_failure_checks)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+	set_expected_calls_for_execute_request_async();
+	umock_c_negative_tests_snapshot();
+
+	size_t i;
+	for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+	{
+		if (umock_c_negative_tests_can_call_fail(i))
+		{
+			umock_c_negative_tests_reset();
+			umock_c_negative_tests_fail_call(i);
+
+			// act
+			int result = http_engine_execute_request_async(handle, HTTPAPI_REQUEST_POST, TEST_RELATIVE_PATH, NULL, (const unsigned char*)"abc", 3, on_response, TEST_CONTEXT_1);
+
+			// assert
+			ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, "Unexpected result on negative test");
+		}
+	}
+
+	// cleanup
+	umock_c_negative_tests_deinit();
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_033: [If `http_engine_handle` is NULL, http_engine_cancel_requests() shall return]
+TEST_FUNCTION(cancel_requests_NULL_handle)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	http_engine_cancel_requests(NULL, TEST_CONTEXT_1);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_034: [Each in-flight request submitted with `context` shall be completed with HTTP_ENGINE_CANCELLED and its connection closed]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_035: [Each pending request submitted with `context` shall be completed with HTTP_ENGINE_CANCELLED]
+TEST_FUNCTION(cancel_requests_cancels_only_matching_requests)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	submit_request(handle, TEST_CONTEXT_2);
+	submit_request(handle, TEST_CONTEXT_1);
+	umock_c_reset_all_calls();
+
+	// act
+	http_engine_cancel_requests(handle, TEST_CONTEXT_1);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 2, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_CANCELLED, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_1, g_response.context);
+
+	// The cancelled connection cannot be reused; the remaining request gets a new one.
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(size_t, 2, g_xio_count);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_036: [If `http_engine_handle` is NULL, http_engine_dowork() shall return]
+TEST_FUNCTION(dowork_NULL_handle)
+{
+	// arrange
+	umock_c_reset_all_calls();
+
+	// act
+	http_engine_dowork(NULL);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_041: [If requests remain pending, closed connections shall be opened, no more than the number of requests not yet covered by connections being opened]
+TEST_FUNCTION(dowork_opens_one_connection_per_pending_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(4);
+	submit_request(handle, TEST_CONTEXT_1);
+	submit_request(handle, TEST_CONTEXT_2);
+	umock_c_reset_all_calls();
+
+	// act
+	http_engine_dowork(handle);
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 2, g_xio_count);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_037: [http_engine_dowork() shall call xio_dowork() on the I/O of each open connection]
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_040: [Pending requests shall be sent, oldest first, on idle connections using xio_send()]
+TEST_FUNCTION(dowork_sends_pending_request_on_idle_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	http_engine_dowork(handle);
+	g_xios[0].on_io_open_complete(g_xios[0].on_io_open_complete_context, IO_OPEN_OK);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(xio_dowork(get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument_current_ms();
+	STRICT_EXPECTED_CALL(xio_send(get_xio_handle(0), IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument_buffer()
+		.IgnoreArgument_size()
+		.IgnoreArgument_on_send_complete()
+		.IgnoreArgument_callback_context();
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_040: [Pending requests shall be sent, oldest first, on idle connections using xio_send()]
+TEST_FUNCTION(dowork_reuses_keep_alive_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.1 204 No Content\r\n\r\n");
+	submit_request(handle, TEST_CONTEXT_2);
+	g_xios[0].sent_size = 0;
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_xio_count);
+	ASSERT_ARE_NOT_EQUAL(size_t, 0, g_xios[0].sent_size);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_content_length_response_completes_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	STRICT_EXPECTED_CALL(HTTPHeaders_Alloc());
+	STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(TEST_RESPONSE_HEADERS, "Content-Length", "5"));
+	STRICT_EXPECTED_CALL(realloc(NULL, IGNORED_NUM_ARG))
+		.IgnoreArgument(2);
+	STRICT_EXPECTED_CALL(HTTPHeaders_Free(TEST_RESPONSE_HEADERS));
+
+	// act
+	receive_bytes(0, "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhel");
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.count);
+	receive_bytes(0, "lo");
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_OK, g_response.result);
+	ASSERT_ARE_EQUAL(int, 200, g_response.status_code);
+	ASSERT_ARE_EQUAL(char_ptr, "hello", g_response.content);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_1, g_response.context);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_chunked_response_completes_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// act
+	receive_bytes(0, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel");
+	receive_bytes(0, "lo\r\n6;ext=1\r\n world\r\n0\r\n");
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.count);
+	receive_bytes(0, "\r\n");
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, 200, g_response.status_code);
+	ASSERT_ARE_EQUAL(char_ptr, "hello world", g_response.content);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_interim_response_is_skipped)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// act
+	receive_bytes(0, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 204 No Content\r\n\r\n");
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, 204, g_response.status_code);
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.content_size);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_connection_close_header_closes_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n");
+	submit_request(handle, TEST_CONTEXT_2);
+	umock_c_reset_all_calls();
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(size_t, 2, g_xio_count);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_response_without_length_ends_with_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.0 200 OK\r\n\r\nuntil ");
+	receive_bytes(0, "close");
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.count);
+
+	// act
+	g_xios[0].on_io_error(g_xios[0].on_io_error_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_OK, g_response.result);
+	ASSERT_ARE_EQUAL(char_ptr, "until close", g_response.content);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_stale_keep_alive_connection_retries_request_once)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.1 204 No Content\r\n\r\n");
+	submit_get_request(handle, TEST_CONTEXT_2);
+	http_engine_dowork(handle);
+
+	// act
+	g_xios[0].on_io_error(g_xios[0].on_io_error_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	open_connection_and_send(handle, 1);
+	receive_bytes(1, "HTTP/1.1 204 No Content\r\n\r\n");
+	ASSERT_ARE_EQUAL(size_t, 2, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_OK, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_2, g_response.context);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_stale_keep_alive_connection_does_not_retry_post)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.1 204 No Content\r\n\r\n");
+	submit_request(handle, TEST_CONTEXT_2);
+	http_engine_dowork(handle);
+
+	// act
+	g_xios[0].on_io_error(g_xios[0].on_io_error_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 2, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_2, g_response.context);
+	http_engine_dowork(handle);
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(size_t, 1, g_xio_count);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_error_on_new_connection_fails_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// act
+	g_xios[0].on_io_error(g_xios[0].on_io_error_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_error_after_response_started_fails_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	receive_bytes(0, "HTTP/1.1 204 No Content\r\n\r\n");
+	submit_request(handle, TEST_CONTEXT_2);
+	http_engine_dowork(handle);
+	receive_bytes(0, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc");
+
+	// act
+	g_xios[0].on_io_error(g_xios[0].on_io_error_context);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 2, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_2, g_response.context);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_invalid_status_line_fails_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// act
+	receive_bytes(0, "SIP/2.0 200 OK\r\n\r\n");
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+TEST_FUNCTION(dowork_too_large_content_length_fails_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+
+	// act
+	receive_bytes(0, "HTTP/1.1 200 OK\r\nContent-Length: 1048577\r\n\r\n");
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_038: [Connections that failed, were closed by the server or were cancelled shall have their I/O destroyed using xio_destroy()]
+TEST_FUNCTION(dowork_destroys_failed_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	g_xios[0].on_io_error(g_xios[0].on_io_error_context);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(xio_destroy(get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument_current_ms();
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_039: [Requests queued or in flight for longer than the request timeout shall be completed with HTTP_ENGINE_TIMEOUT]
+TEST_FUNCTION(dowork_pending_request_times_out)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	http_engine_dowork(handle);
+	g_current_ms = TEST_REQUEST_TIMEOUT_MS - 1;
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.count);
+	g_current_ms = TEST_REQUEST_TIMEOUT_MS;
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_TIMEOUT, g_response.result);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_039: [Requests queued or in flight for longer than the request timeout shall be completed with HTTP_ENGINE_TIMEOUT]
+TEST_FUNCTION(dowork_in_flight_request_times_out_and_closes_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	open_connection_and_send(handle, 0);
+	g_current_ms = TEST_REQUEST_TIMEOUT_MS;
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_TIMEOUT, g_response.result);
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(xio_destroy(get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument_current_ms();
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_042: [If the I/O cannot be created, configured or opened, the first pending request not covered by the other connections being opened when the connection was opened shall be completed with HTTP_ENGINE_ERROR, if it is still pending]
+TEST_FUNCTION(dowork_open_failure_fails_oldest_pending_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	submit_request(handle, TEST_CONTEXT_2);
+	http_engine_dowork(handle);
+
+	// act
+	g_xios[0].on_io_open_complete(g_xios[0].on_io_open_complete_context, IO_OPEN_ERROR);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_1, g_response.context);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_042: [If the I/O cannot be created, configured or opened, the first pending request not covered by the other connections being opened when the connection was opened shall be completed with HTTP_ENGINE_ERROR, if it is still pending]
+TEST_FUNCTION(dowork_xio_open_failure_fails_oldest_pending_request)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(1);
+	submit_request(handle, TEST_CONTEXT_1);
+	umock_c_reset_all_calls();
+
+	STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument_current_ms();
+	STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(TEST_OPTIONHANDLER_HANDLE, get_xio_handle(0)));
+	STRICT_EXPECTED_CALL(xio_open(get_xio_handle(0), IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreAllArguments()
+		.SetReturn(__LINE__);
+
+	// act
+	http_engine_dowork(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_HTTP_ENGINE_09_042: [If the I/O cannot be created, configured or opened, the first pending request not covered by the other connections being opened when the connection was opened shall be completed with HTTP_ENGINE_ERROR, if it is still pending]
+TEST_FUNCTION(dowork_open_failure_does_not_fail_a_request_sent_on_another_connection)
+{
+	// arrange
+	HTTP_ENGINE_HANDLE handle = create_http_engine(2);
+	submit_request(handle, TEST_CONTEXT_1);
+	http_engine_dowork(handle);
+	submit_request(handle, TEST_CONTEXT_2);
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(size_t, 2, g_xio_count);
+	g_xios[1].on_io_open_complete(g_xios[1].on_io_open_complete_context, IO_OPEN_OK);
+	http_engine_dowork(handle);
+	ASSERT_ARE_NOT_EQUAL(size_t, 0, g_xios[1].sent_size);
+
+	// act
+	g_xios[0].on_io_open_complete(g_xios[0].on_io_open_complete_context, IO_OPEN_ERROR);
+
+	// assert
+	ASSERT_ARE_EQUAL(size_t, 0, g_response.count);
+	http_engine_dowork(handle);
+	ASSERT_ARE_EQUAL(size_t, 3, g_xio_count);
+	g_xios[2].on_io_open_complete(g_xios[2].on_io_open_complete_context, IO_OPEN_ERROR);
+	ASSERT_ARE_EQUAL(size_t, 1, g_response.count);
+	ASSERT_ARE_EQUAL(int, HTTP_ENGINE_ERROR, g_response.result);
+	ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT_2, g_response.context);
+
+	// cleanup
+	http_engine_destroy(handle);
+}
+
+END_TEST_SUITE(iothubtransport_http_engine_ut)
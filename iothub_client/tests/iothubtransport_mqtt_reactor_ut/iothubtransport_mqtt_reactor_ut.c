@@ -0,0 +1,1130 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void* real_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/platform.h"
+#include "iothub_client_ll.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/tlsio.h"
+#include "iothubtransport_mqtt_common.h"
+#include "iothubtransport_mqtt_reactor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int real_mallocAndStrcpy_s(char** destination, const char* source);
+
+#ifdef __cplusplus
+}
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_HOST_NAME                      "some.host.name"
+#define TEST_LOOPBACK_ADDRESS               "127.0.0.1"
+#define TEST_REACTOR_LOCK                   (LOCK_HANDLE)0x4701
+#define TEST_CLIENT_LOCK                    (LOCK_HANDLE)0x4702
+#define TEST_CLIENT_HANDLE                  (IOTHUB_CLIENT_LL_HANDLE)0x4703
+#define TEST_THREAD_HANDLE                  (THREAD_HANDLE)0x4704
+#define TEST_TLSIO_INTERFACE                (const IO_INTERFACE_DESCRIPTION*)0x4705
+#define TEST_XIO_HANDLE                     (XIO_HANDLE)0x4706
+#define TEST_OPTIONHANDLER_HANDLE           (OPTIONHANDLER_HANDLE)0x4707
+#define TEST_IDLE_INTERVAL_MS               10
+#define TEST_WAIT_TIMEOUT_MS                1000
+#define TEST_MAX_SERVICES                   50
+
+static size_t g_dowork_count;
+static MQTT_TRANSPORT_IO_FACTORY g_io_factory;
+static CONCRETE_IO_HANDLE g_socket_io;
+static TLSIO_CONFIG g_tls_io_config;
+static MQTT_REACTOR_SOCKET_CONFIG g_socket_config;
+static const IO_INTERFACE_DESCRIPTION* g_socket_io_interface;
+
+typedef struct TEST_SOCKET_IO_CALLBACKS_TAG
+{
+    size_t open_complete_count;
+    IO_OPEN_RESULT open_result;
+    size_t error_count;
+    size_t send_complete_count;
+    IO_SEND_RESULT send_result;
+    char received[256];
+    size_t received_size;
+} TEST_SOCKET_IO_CALLBACKS;
+
+static TEST_SOCKET_IO_CALLBACKS g_callbacks;
+
+
+// Helpers
+
+static IOTHUB_CLIENT_RESULT TEST_IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char* optionName, const void* value)
+{
+    (void)iotHubClientHandle;
+    ASSERT_ARE_EQUAL(char_ptr, OPTION_MQTT_IO_FACTORY, optionName);
+    g_io_factory = *(const MQTT_TRANSPORT_IO_FACTORY*)value;
+    return IOTHUB_CLIENT_OK;
+}
+
+static void TEST_IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    (void)iotHubClientHandle;
+    g_dowork_count++;
+
+    if (g_socket_io != NULL)
+    {
+        g_socket_io_interface->concrete_io_dowork(g_socket_io);
+    }
+}
+
+static XIO_HANDLE TEST_xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description, const void* io_create_parameters)
+{
+    (void)io_interface_description;
+    g_tls_io_config = *(const TLSIO_CONFIG*)io_create_parameters;
+    return TEST_XIO_HANDLE;
+}
+
+static XIO_HANDLE TEST_get_io_transport(const char* fully_qualified_name, const IO_INTERFACE_DESCRIPTION* socket_io_interface, MQTT_REACTOR_SOCKET_CONFIG* socket_config)
+{
+    ASSERT_ARE_EQUAL(char_ptr, TEST_HOST_NAME, fully_qualified_name);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)mqtt_reactor_get_socketio_interface(), (void*)socket_io_interface);
+    g_socket_config = *socket_config;
+    return TEST_XIO_HANDLE;
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    g_callbacks.open_complete_count++;
+    g_callbacks.open_result = open_result;
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    ASSERT_IS_TRUE(g_callbacks.received_size + size < sizeof(g_callbacks.received));
+    (void)memcpy(g_callbacks.received + g_callbacks.received_size, buffer, size);
+    g_callbacks.received_size += size;
+    g_callbacks.received[g_callbacks.received_size] = '\0';
+}
+
+static void on_io_error(void* context)
+{
+    (void)context;
+    g_callbacks.error_count++;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    g_callbacks.send_complete_count++;
+    g_callbacks.send_result = send_result;
+}
+
+static void register_global_mock_hooks()
+{
+    REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_SetOption, TEST_IoTHubClient_LL_SetOption);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_DoWork, TEST_IoTHubClient_LL_DoWork);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_create, TEST_xio_create);
+}
+
+static void register_global_mock_returns()
+{
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(realloc, NULL);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, __LINE__);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_REACTOR_LOCK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Create, THREADAPI_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_SetOption, IOTHUB_CLIENT_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(platform_get_default_tlsio, TEST_TLSIO_INTERFACE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(xio_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Create, TEST_OPTIONHANDLER_HANDLE);
+}
+
+static void register_umock_alias_types()
+{
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_LL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const IO_INTERFACE_DESCRIPTION*, void*);
+}
+
+static MQTT_REACTOR_CONFIG get_config()
+{
+    MQTT_REACTOR_CONFIG config;
+    config.thread_count = 0;
+    config.idle_interval_ms = TEST_IDLE_INTERVAL_MS;
+    config.get_io_transport = NULL;
+    return config;
+}
+
+static MQTT_REACTOR_HANDLE create_reactor(const MQTT_REACTOR_CONFIG* config)
+{
+    MQTT_REACTOR_HANDLE reactor = mqtt_reactor_create(config);
+    ASSERT_IS_NOT_NULL(reactor);
+    return reactor;
+}
+
+// Adds the client and lets the reactor run its first service.
+static MQTT_REACTOR_CLIENT_HANDLE add_client_and_service(MQTT_REACTOR_HANDLE reactor)
+{
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, NULL);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    ASSERT_ARE_EQUAL(int, 0, mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS));
+    ASSERT_ARE_EQUAL(size_t, 1, g_dowork_count);
+    return reactor_client;
+}
+
+// Services the client until `condition` holds or TEST_MAX_SERVICES services were run.
+#define SERVICE_UNTIL(reactor, condition) \
+    { \
+        size_t service_count = 0; \
+        while (!(condition) && (service_count++ < TEST_MAX_SERVICES)) \
+        { \
+            ASSERT_ARE_EQUAL(int, 0, mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS)); \
+        } \
+        ASSERT_IS_TRUE(condition); \
+    }
+
+static int create_listener(int* port)
+{
+    struct sockaddr_in address;
+    socklen_t address_size = sizeof(address);
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_IS_TRUE(listener >= 0);
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    ASSERT_ARE_EQUAL(int, 0, bind(listener, (struct sockaddr*)&address, sizeof(address)));
+    ASSERT_ARE_EQUAL(int, 0, listen(listener, 1));
+    ASSERT_ARE_EQUAL(int, 0, getsockname(listener, (struct sockaddr*)&address, &address_size));
+    *port = ntohs(address.sin_port);
+    return listener;
+}
+
+static CONCRETE_IO_HANDLE create_socket_io(MQTT_REACTOR_CLIENT_HANDLE reactor_client, int port)
+{
+    MQTT_REACTOR_SOCKET_CONFIG socket_config;
+    socket_config.hostname = TEST_LOOPBACK_ADDRESS;
+    socket_config.port = port;
+    socket_config.reactor_client = reactor_client;
+
+    CONCRETE_IO_HANDLE socket_io = g_socket_io_interface->concrete_io_create(&socket_config);
+    ASSERT_IS_NOT_NULL(socket_io);
+    return socket_io;
+}
+
+static void open_socket_io(MQTT_REACTOR_HANDLE reactor, CONCRETE_IO_HANDLE socket_io)
+{
+    ASSERT_ARE_EQUAL(int, 0, g_socket_io_interface->concrete_io_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+    g_socket_io = socket_io;
+    SERVICE_UNTIL(reactor, g_callbacks.open_complete_count == 1);
+}
+
+BEGIN_TEST_SUITE(iothubtransport_mqtt_reactor_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    register_umock_alias_types();
+    register_global_mock_returns();
+    register_global_mock_hooks();
+
+    g_socket_io_interface = mqtt_reactor_get_socketio_interface();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    g_dowork_count = 0;
+    g_socket_io = NULL;
+    (void)memset(&g_io_factory, 0, sizeof(g_io_factory));
+    (void)memset(&g_tls_io_config, 0, sizeof(g_tls_io_config));
+    (void)memset(&g_socket_config, 0, sizeof(g_socket_config));
+    (void)memset(&g_callbacks, 0, sizeof(g_callbacks));
+
+    umock_c_reset_all_calls();
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_001: [ If `config` is NULL, mqtt_reactor_create shall fail and return NULL. ]
+TEST_FUNCTION(mqtt_reactor_create_NULL_config_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    MQTT_REACTOR_HANDLE reactor = mqtt_reactor_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(reactor);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_002: [ mqtt_reactor_create shall create an epoll instance, an eventfd used to stop the threads and a lock. ]
+TEST_FUNCTION(mqtt_reactor_create_success)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    MQTT_REACTOR_HANDLE reactor = mqtt_reactor_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(reactor);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_004: [ mqtt_reactor_create shall start `thread_count` threads, each waiting for events and servicing the clients they concern. ]
+TEST_FUNCTION(mqtt_reactor_create_starts_the_threads)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    config.thread_count = 2;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(malloc(2 * sizeof(THREAD_HANDLE)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    // act
+    MQTT_REACTOR_HANDLE reactor = mqtt_reactor_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(reactor);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_003: [ If any resource fails to be created, mqtt_reactor_create shall release the ones already created and return NULL. ]
+TEST_FUNCTION(mqtt_reactor_create_ThreadAPI_Create_fails_stops_the_started_threads)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    config.thread_count = 2;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(malloc(2 * sizeof(THREAD_HANDLE)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+
+    // act
+    MQTT_REACTOR_HANDLE reactor = mqtt_reactor_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(reactor);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_003: [ If any resource fails to be created, mqtt_reactor_create shall release the ones already created and return NULL. ]
+TEST_FUNCTION(mqtt_reactor_create_failure_checks)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    MQTT_REACTOR_CONFIG config = get_config();
+    config.thread_count = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(malloc(sizeof(THREAD_HANDLE)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    umock_c_negative_tests_snapshot();
+
+    size_t i;
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        MQTT_REACTOR_HANDLE reactor = mqtt_reactor_create(&config);
+
+        // assert
+        char error_msg[64];
+        (void)snprintf(error_msg, sizeof(error_msg), "On failed call %lu", (unsigned long)i);
+        ASSERT_IS_NULL_WITH_MSG(reactor, error_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_005: [ mqtt_reactor_destroy shall stop and join the threads, then release all the resources of the reactor. ]
+TEST_FUNCTION(mqtt_reactor_destroy_joins_the_threads_and_frees_the_reactor)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    config.thread_count = 2;
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(free(reactor));
+
+    // act
+    mqtt_reactor_destroy(reactor);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(mqtt_reactor_destroy_NULL_does_nothing)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    mqtt_reactor_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_006: [ If `reactor` or `client` is NULL, mqtt_reactor_add_client shall fail and return NULL. ]
+TEST_FUNCTION(mqtt_reactor_add_client_NULL_reactor_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(NULL, TEST_CLIENT_HANDLE, NULL);
+
+    // assert
+    ASSERT_IS_NULL(reactor_client);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_006: [ If `reactor` or `client` is NULL, mqtt_reactor_add_client shall fail and return NULL. ]
+TEST_FUNCTION(mqtt_reactor_add_client_NULL_client_fails)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    umock_c_reset_all_calls();
+
+    // act
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(reactor_client);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_007: [ mqtt_reactor_add_client shall set the `mqtt_io_factory` option of `client`, holding `lock` if it is not NULL, so that the transport opens its connections on the socket I/O of the reactor. ]
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_008: [ mqtt_reactor_add_client shall register a timerfd of the client with the epoll instance and arm it to expire at once, so that the client connects. ]
+TEST_FUNCTION(mqtt_reactor_add_client_sets_the_io_factory_and_services_the_client_at_once)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetOption(TEST_CLIENT_HANDLE, OPTION_MQTT_IO_FACTORY, IGNORED_PTR_ARG))
+        .IgnoreArgument_value();
+    STRICT_EXPECTED_CALL(Unlock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(realloc(NULL, IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+
+    // act
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, TEST_CLIENT_LOCK);
+
+    // assert
+    ASSERT_IS_NOT_NULL(reactor_client);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL((void*)g_io_factory.create_io_transport);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)reactor_client, g_io_factory.context);
+
+    ASSERT_ARE_EQUAL(int, 0, mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS));
+    ASSERT_ARE_EQUAL(size_t, 1, g_dowork_count);
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_009: [ If any step fails, mqtt_reactor_add_client shall undo the previous ones and return NULL. ]
+TEST_FUNCTION(mqtt_reactor_add_client_failure_checks)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetOption(TEST_CLIENT_HANDLE, OPTION_MQTT_IO_FACTORY, IGNORED_PTR_ARG))
+        .IgnoreArgument_value();
+    STRICT_EXPECTED_CALL(Unlock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(realloc(NULL, IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    umock_c_negative_tests_snapshot();
+
+    size_t i;
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        if (umock_c_negative_tests_can_call_fail(i))
+        {
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(i);
+
+            // act
+            MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, TEST_CLIENT_LOCK);
+
+            // assert
+            char error_msg[64];
+            (void)snprintf(error_msg, sizeof(error_msg), "On failed call %lu", (unsigned long)i);
+            ASSERT_IS_NULL_WITH_MSG(reactor_client, error_msg);
+        }
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_010: [ mqtt_reactor_remove_client shall unregister the client so that its pending and future events are ignored. ]
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_011: [ mqtt_reactor_remove_client shall wait for any ongoing service of the client to complete, then close its timerfd and release it. ]
+TEST_FUNCTION(mqtt_reactor_remove_client_ignores_the_pending_events_of_the_client)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, NULL);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(free(reactor_client));
+
+    // act
+    mqtt_reactor_remove_client(reactor_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, mqtt_reactor_dowork(reactor, TEST_IDLE_INTERVAL_MS));
+    ASSERT_ARE_EQUAL(size_t, 0, g_dowork_count);
+
+    // cleanup
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_012: [ If `reactor_client` is NULL, mqtt_reactor_wake_client shall fail and return a non-zero value. ]
+TEST_FUNCTION(mqtt_reactor_wake_client_NULL_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    int result = mqtt_reactor_wake_client(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_013: [ mqtt_reactor_wake_client shall arm the timerfd of the client to expire at once. ]
+TEST_FUNCTION(mqtt_reactor_wake_client_services_the_client_before_the_idle_interval)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    config.idle_interval_ms = 60000;
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = add_client_and_service(reactor);
+    ASSERT_ARE_EQUAL(int, 0, mqtt_reactor_dowork(reactor, 0));
+    ASSERT_ARE_EQUAL(size_t, 1, g_dowork_count);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = mqtt_reactor_wake_client(reactor_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS));
+    ASSERT_ARE_EQUAL(size_t, 2, g_dowork_count);
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_014: [ If the reactor was created with `get_io_transport`, the I/O of each new connection shall be the one it returns for the host name, the socket I/O interface and a MQTT_REACTOR_SOCKET_CONFIG with port 8883 and the client. ]
+TEST_FUNCTION(mqtt_reactor_io_factory_uses_get_io_transport)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    config.get_io_transport = TEST_get_io_transport;
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, NULL);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    // act
+    XIO_HANDLE xio = g_io_factory.create_io_transport(g_io_factory.context, TEST_HOST_NAME);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, xio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_HOST_NAME, g_socket_config.hostname);
+    ASSERT_ARE_EQUAL(int, 8883, g_socket_config.port);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)reactor_client, (void*)g_socket_config.reactor_client);
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_015: [ Otherwise it shall be a TLS I/O (platform_get_default_tlsio) to the host name on port 8883 over the socket I/O of the reactor. ]
+TEST_FUNCTION(mqtt_reactor_io_factory_creates_a_tlsio_over_the_socket_io)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, NULL);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(platform_get_default_tlsio());
+    STRICT_EXPECTED_CALL(xio_create(TEST_TLSIO_INTERFACE, IGNORED_PTR_ARG))
+        .IgnoreArgument_io_create_parameters();
+
+    // act
+    XIO_HANDLE xio = g_io_factory.create_io_transport(g_io_factory.context, TEST_HOST_NAME);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, xio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_HOST_NAME, g_tls_io_config.hostname);
+    ASSERT_ARE_EQUAL(int, 8883, g_tls_io_config.port);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)g_socket_io_interface, (void*)g_tls_io_config.underlying_io_interface);
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_015: [ Otherwise it shall be a TLS I/O (platform_get_default_tlsio) to the host name on port 8883 over the socket I/O of the reactor. ]
+TEST_FUNCTION(mqtt_reactor_io_factory_xio_create_fails_returns_NULL)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, NULL);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(platform_get_default_tlsio());
+    STRICT_EXPECTED_CALL(xio_create(TEST_TLSIO_INTERFACE, IGNORED_PTR_ARG))
+        .IgnoreArgument_io_create_parameters()
+        .SetReturn(NULL);
+
+    // act
+    XIO_HANDLE xio = g_io_factory.create_io_transport(g_io_factory.context, TEST_HOST_NAME);
+
+    // assert
+    ASSERT_IS_NULL(xio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_016: [ If `reactor` is NULL, mqtt_reactor_dowork shall fail and return a non-zero value. ]
+TEST_FUNCTION(mqtt_reactor_dowork_NULL_reactor_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    int result = mqtt_reactor_dowork(NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_017: [ mqtt_reactor_dowork shall wait up to `timeout_ms` for events and, for each, call IoTHubClient_LL_DoWork of the client it concerns, holding the lock of the client, unless it is being serviced by another thread, which shall then service it again. ]
+TEST_FUNCTION(mqtt_reactor_dowork_services_the_client_holding_its_lock)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, TEST_CLIENT_LOCK);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+
+    // act
+    int result = mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_017: [ mqtt_reactor_dowork shall wait up to `timeout_ms` for events and, for each, call IoTHubClient_LL_DoWork of the client it concerns, holding the lock of the client, unless it is being serviced by another thread, which shall then service it again. ]
+TEST_FUNCTION(mqtt_reactor_dowork_retries_locking_the_reactor_to_end_the_service)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, TEST_CLIENT_LOCK);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_CLIENT_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK))
+        .SetReturn(LOCK_ERROR);
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+
+    // act
+    int result = mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_017: [ mqtt_reactor_dowork shall wait up to `timeout_ms` for events and, for each, call IoTHubClient_LL_DoWork of the client it concerns, holding the lock of the client, unless it is being serviced by another thread, which shall then service it again. ]
+TEST_FUNCTION(mqtt_reactor_dowork_services_an_idle_client_after_the_idle_interval)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = add_client_and_service(reactor);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = mqtt_reactor_dowork(reactor, TEST_WAIT_TIMEOUT_MS);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, g_dowork_count);
+
+    // cleanup
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_017: [ mqtt_reactor_dowork shall wait up to `timeout_ms` for events and, for each, call IoTHubClient_LL_DoWork of the client it concerns, holding the lock of the client, unless it is being serviced by another thread, which shall then service it again. ]
+TEST_FUNCTION(mqtt_reactor_dowork_with_no_event_returns_after_the_timeout)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = mqtt_reactor_dowork(reactor, TEST_IDLE_INTERVAL_MS);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_dowork_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_018: [ If `io_create_parameters`, its `hostname` or its `reactor_client` is NULL, socketio_create shall fail and return NULL. ]
+TEST_FUNCTION(socketio_create_NULL_parameters_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    CONCRETE_IO_HANDLE socket_io = g_socket_io_interface->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_018: [ If `io_create_parameters`, its `hostname` or its `reactor_client` is NULL, socketio_create shall fail and return NULL. ]
+TEST_FUNCTION(socketio_create_NULL_reactor_client_fails)
+{
+    // arrange
+    MQTT_REACTOR_SOCKET_CONFIG socket_config;
+    socket_config.hostname = TEST_HOST_NAME;
+    socket_config.port = 8883;
+    socket_config.reactor_client = NULL;
+    umock_c_reset_all_calls();
+
+    // act
+    CONCRETE_IO_HANDLE socket_io = g_socket_io_interface->concrete_io_create(&socket_config);
+
+    // assert
+    ASSERT_IS_NULL(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_019: [ socketio_create shall add the socket I/O to the client, which it shall keep until it is destroyed. ]
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_020: [ socketio_destroy shall close the socket, cancel the pending sends, remove the socket I/O from its client and release the client. ]
+TEST_FUNCTION(socketio_keeps_the_client_until_it_is_destroyed)
+{
+    // arrange
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = mqtt_reactor_add_client(reactor, TEST_CLIENT_HANDLE, NULL);
+    ASSERT_IS_NOT_NULL(reactor_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_LOOPBACK_ADDRESS))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    // mqtt_reactor_remove_client, which does not free the client
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+
+    // act
+    CONCRETE_IO_HANDLE socket_io = create_socket_io(reactor_client, 8883);
+    mqtt_reactor_remove_client(reactor_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(Unlock(TEST_REACTOR_LOCK));
+    STRICT_EXPECTED_CALL(free(reactor_client));
+    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(free(socket_io));
+
+    g_socket_io_interface->concrete_io_destroy(socket_io);
+
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_021: [ socketio_open shall start a non-blocking connection and register the socket with the epoll instance; the open completes when the socket becomes writable. ]
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_023: [ socketio_send shall send the bytes at once if it can, and otherwise queue what is left to be sent when the socket becomes writable; `on_send_complete` shall be called once all the bytes are sent. ]
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_024: [ socketio_dowork shall complete a pending connection, send the queued bytes and pass the received bytes to `on_bytes_received` without blocking; if the peer closes the connection or an error occurs, it shall call `on_io_error`. ]
+TEST_FUNCTION(socketio_connects_sends_and_receives_when_the_reactor_services_the_client)
+{
+    // arrange
+    int port;
+    int listener = create_listener(&port);
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = add_client_and_service(reactor);
+    CONCRETE_IO_HANDLE socket_io = create_socket_io(reactor_client, port);
+    char server_received[4];
+
+    // act
+    open_socket_io(reactor, socket_io);
+    int server = accept(listener, NULL, NULL);
+    int send_result = g_socket_io_interface->concrete_io_send(socket_io, "abc", 3, on_send_complete, NULL);
+    ssize_t server_received_size = recv(server, server_received, 3, MSG_WAITALL);
+    ASSERT_ARE_EQUAL(int, 3, (int)send(server, "xyz", 3, 0));
+    SERVICE_UNTIL(reactor, g_callbacks.received_size == 3);
+
+    // assert
+    ASSERT_IS_TRUE(server >= 0);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, g_callbacks.open_result);
+    ASSERT_ARE_EQUAL(int, 0, send_result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_callbacks.send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, g_callbacks.send_result);
+    ASSERT_ARE_EQUAL(int, 3, (int)server_received_size);
+    ASSERT_IS_TRUE(memcmp(server_received, "abc", 3) == 0);
+    ASSERT_ARE_EQUAL(char_ptr, "xyz", g_callbacks.received);
+    ASSERT_ARE_EQUAL(size_t, 0, g_callbacks.error_count);
+
+    // cleanup
+    g_socket_io = NULL;
+    g_socket_io_interface->concrete_io_destroy(socket_io);
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+    (void)close(server);
+    (void)close(listener);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_024: [ socketio_dowork shall complete a pending connection, send the queued bytes and pass the received bytes to `on_bytes_received` without blocking; if the peer closes the connection or an error occurs, it shall call `on_io_error`. ]
+TEST_FUNCTION(socketio_peer_closing_the_connection_indicates_an_error)
+{
+    // arrange
+    int port;
+    int listener = create_listener(&port);
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = add_client_and_service(reactor);
+    CONCRETE_IO_HANDLE socket_io = create_socket_io(reactor_client, port);
+    open_socket_io(reactor, socket_io);
+    int server = accept(listener, NULL, NULL);
+    ASSERT_IS_TRUE(server >= 0);
+
+    // act
+    (void)close(server);
+    SERVICE_UNTIL(reactor, g_callbacks.error_count == 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_socket_io_interface->concrete_io_send(socket_io, "abc", 3, on_send_complete, NULL));
+
+    // cleanup
+    g_socket_io = NULL;
+    g_socket_io_interface->concrete_io_destroy(socket_io);
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+    (void)close(listener);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_021: [ socketio_open shall start a non-blocking connection and register the socket with the epoll instance; the open completes when the socket becomes writable. ]
+TEST_FUNCTION(socketio_open_refused_connection_completes_with_an_error)
+{
+    // arrange
+    int port;
+    (void)close(create_listener(&port));
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = add_client_and_service(reactor);
+    CONCRETE_IO_HANDLE socket_io = create_socket_io(reactor_client, port);
+
+    // act
+    open_socket_io(reactor, socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, g_callbacks.open_result);
+
+    // cleanup
+    g_socket_io = NULL;
+    g_socket_io_interface->concrete_io_destroy(socket_io);
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_022: [ socketio_close shall close the socket, cancel the pending sends and call `on_io_close_complete`. ]
+TEST_FUNCTION(socketio_close_closes_the_connection)
+{
+    // arrange
+    int port;
+    int listener = create_listener(&port);
+    MQTT_REACTOR_CONFIG config = get_config();
+    MQTT_REACTOR_HANDLE reactor = create_reactor(&config);
+    MQTT_REACTOR_CLIENT_HANDLE reactor_client = add_client_and_service(reactor);
+    CONCRETE_IO_HANDLE socket_io = create_socket_io(reactor_client, port);
+    open_socket_io(reactor, socket_io);
+    int server = accept(listener, NULL, NULL);
+    ASSERT_IS_TRUE(server >= 0);
+    g_socket_io = NULL;
+    char byte;
+
+    // act
+    int result = g_socket_io_interface->concrete_io_close(socket_io, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, (int)recv(server, &byte, 1, 0));
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_socket_io_interface->concrete_io_send(socket_io, "abc", 3, on_send_complete, NULL));
+
+    // cleanup
+    g_socket_io_interface->concrete_io_destroy(socket_io);
+    mqtt_reactor_remove_client(reactor_client);
+    mqtt_reactor_destroy(reactor);
+    (void)close(server);
+    (void)close(listener);
+}
+
+// Tests_SRS_IOTHUB_TRANSPORT_MQTT_REACTOR_09_025: [ socketio_setoption shall fail and return a non-zero value, since the socket I/O has no option. ]
+TEST_FUNCTION(socketio_setoption_fails)
+{
+    // arrange
+    int value = 1;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = g_socket_io_interface->concrete_io_setoption((CONCRETE_IO_HANDLE)0x1, "some_option", &value);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(iothubtransport_mqtt_reactor_ut)
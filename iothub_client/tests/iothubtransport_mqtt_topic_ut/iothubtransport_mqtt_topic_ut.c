@@ -0,0 +1,470 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+#include "iothubtransport_mqtt_topic.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static const char* TEST_C2D_TOPIC = "devices/thisIsDeviceID/messages/devicebound/%24.mid=msg%2F1&%24.to=%2Fdevices%2FthisIsDeviceID%2Fmessages%2FdeviceBound&%24.cid&iothub-ack=full&prop%20name=a%26b";
+static const char* TEST_C2D_TOPIC_PROPERTIES = "%24.mid=msg%2F1&%24.to=%2Fdevices%2FthisIsDeviceID%2Fmessages%2FdeviceBound&%24.cid&iothub-ack=full&prop%20name=a%26b";
+static const char* TEST_TWIN_RESPONSE_TOPIC = "$iothub/twin/res/204/?$rid=17&$version=3";
+static const char* TEST_TWIN_PATCH_TOPIC = "$iothub/twin/PATCH/properties/desired/?$version=5";
+static const char* TEST_METHOD_TOPIC = "$iothub/methods/POST/reboot/?$rid=a1";
+
+#define FUZZ_ITERATIONS     20000
+#define FUZZ_MAX_LENGTH     96
+
+static void assert_slice_is(const char* expected, const MQTT_TOPIC_SLICE* slice)
+{
+    ASSERT_IS_NOT_NULL(slice->value);
+    ASSERT_ARE_EQUAL(size_t, strlen(expected), slice->length);
+    ASSERT_IS_TRUE(strncmp(expected, slice->value, slice->length) == 0);
+}
+
+static void assert_slice_in_topic(const char* topic, const MQTT_TOPIC_SLICE* slice)
+{
+    size_t topic_length = strlen(topic);
+
+    if (slice->value == NULL)
+    {
+        ASSERT_ARE_EQUAL(size_t, 0, slice->length);
+    }
+    else
+    {
+        ASSERT_IS_TRUE(slice->value >= topic);
+        ASSERT_IS_TRUE(slice->value <= topic + topic_length);
+        ASSERT_IS_TRUE(slice->length <= (size_t)(topic + topic_length - slice->value));
+    }
+}
+
+static void assert_next_property_is(MQTT_TOPIC_SLICE* properties, const char* expected_name, const char* expected_value)
+{
+    MQTT_TOPIC_SLICE name;
+    MQTT_TOPIC_SLICE value;
+
+    ASSERT_ARE_EQUAL(int, 0, mqtt_topic_get_next_property(properties, &name, &value));
+    assert_slice_is(expected_name, &name);
+    if (expected_value == NULL)
+    {
+        ASSERT_IS_NULL(value.value);
+    }
+    else
+    {
+        assert_slice_is(expected_value, &value);
+    }
+}
+
+static void assert_decodes_to(const char* encoded, const char* expected)
+{
+    MQTT_TOPIC_SLICE slice;
+    char buffer[64];
+
+    slice.value = encoded;
+    slice.length = strlen(encoded);
+
+    ASSERT_ARE_EQUAL(int, 0, mqtt_topic_url_decode(&slice, buffer, sizeof(buffer)));
+    ASSERT_ARE_EQUAL(char_ptr, expected, buffer);
+}
+
+// Deterministic, so that a failing input can be reproduced from the iteration number.
+static unsigned int next_random(unsigned int* state)
+{
+    *state = (*state * 1103515245u) + 12345u;
+    return (*state >> 16) & 0x7FFF;
+}
+
+static void make_fuzz_topic(unsigned int* state, char* topic, size_t topic_size)
+{
+    static const char* prefixes[] = { "", "$iothub/twin/", "$IOTHUB/TWIN/res/", "$iothub/twin/PATCH/", "$iothub/methods/", "$iothub/methods/POST/", "devices/", "devices/d/messages/devicebound/" };
+    static const char alphabet[] = "/&=%?$.0123456789aAfFzZ rid";
+    size_t prefix_count = sizeof(prefixes) / sizeof(prefixes[0]);
+    const char* prefix = prefixes[next_random(state) % prefix_count];
+    size_t length = strlen(prefix);
+    size_t target_length = length + (next_random(state) % (FUZZ_MAX_LENGTH - length));
+
+    ASSERT_IS_TRUE(target_length < topic_size);
+    (void)memcpy(topic, prefix, length);
+    while (length < target_length)
+    {
+        topic[length++] = alphabet[next_random(state) % (sizeof(alphabet) - 1)];
+    }
+    topic[length] = '\0';
+}
+
+BEGIN_TEST_SUITE(iothubtransport_mqtt_topic_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_001: [ If `topic` or `topic_info` is NULL, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_NULL_topic_fails)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse(NULL, &topic_info);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_001: [ If `topic` or `topic_info` is NULL, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_NULL_topic_info_fails)
+{
+    // act
+    int result = mqtt_topic_parse(TEST_C2D_TOPIC, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_002: [ mqtt_topic_parse shall not allocate memory, and all the slices it returns shall point into `topic`. ] */
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_006: [ Any other topic shall be a MQTT_TOPIC_TYPE_C2D_MESSAGE, whose `properties` are what follows `devices/{device id}/messages/devicebound/`, or what follows the last '/' of a topic of another form. ] */
+TEST_FUNCTION(mqtt_topic_parse_c2d_message_succeeds)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse(TEST_C2D_TOPIC, &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_C2D_MESSAGE, topic_info.type);
+    assert_slice_is(TEST_C2D_TOPIC_PROPERTIES, &topic_info.properties);
+    ASSERT_IS_TRUE(topic_info.properties.value == TEST_C2D_TOPIC + strlen(TEST_C2D_TOPIC) - strlen(TEST_C2D_TOPIC_PROPERTIES));
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_006: [ Any other topic shall be a MQTT_TOPIC_TYPE_C2D_MESSAGE, whose `properties` are what follows `devices/{device id}/messages/devicebound/`, or what follows the last '/' of a topic of another form. ] */
+TEST_FUNCTION(mqtt_topic_parse_c2d_message_with_properties_containing_slash_succeeds)
+{
+    // arrange
+    const char* topic = "devices/thisIsDeviceID/messages/devicebound/path=a/b&x=1";
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse(topic, &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_C2D_MESSAGE, topic_info.type);
+    assert_slice_is("path=a/b&x=1", &topic_info.properties);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_006: [ Any other topic shall be a MQTT_TOPIC_TYPE_C2D_MESSAGE, whose `properties` are what follows `devices/{device id}/messages/devicebound/`, or what follows the last '/' of a topic of another form. ] */
+TEST_FUNCTION(mqtt_topic_parse_other_topic_uses_last_segment)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse("some/other/topic/a=1&b=2", &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_C2D_MESSAGE, topic_info.type);
+    assert_slice_is("a=1&b=2", &topic_info.properties);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_003: [ If `topic` starts with `$iothub/twin/` (case-insensitive) followed by the segment `PATCH`, mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_TWIN_DESIRED_PATCH. ] */
+TEST_FUNCTION(mqtt_topic_parse_twin_desired_patch_succeeds)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse(TEST_TWIN_PATCH_TOPIC, &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_TWIN_DESIRED_PATCH, topic_info.type);
+    assert_slice_is("$version=5", &topic_info.properties);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_004: [ Otherwise, for a topic starting with `$iothub/twin/`, mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_TWIN_RESPONSE, `status_code` to the number in the segment following the operation and `twin_request_id` to the number in the `$rid` property, or 0 if there is none. If the status code segment is missing, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_twin_response_succeeds)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse(TEST_TWIN_RESPONSE_TOPIC, &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_TWIN_RESPONSE, topic_info.type);
+    ASSERT_ARE_EQUAL(int, 204, topic_info.status_code);
+    ASSERT_ARE_EQUAL(size_t, 17, topic_info.twin_request_id);
+    assert_slice_is("$rid=17&$version=3", &topic_info.properties);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_004: [ Otherwise, for a topic starting with `$iothub/twin/`, mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_TWIN_RESPONSE, `status_code` to the number in the segment following the operation and `twin_request_id` to the number in the `$rid` property, or 0 if there is none. If the status code segment is missing, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_twin_response_prefix_is_case_insensitive)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse("$IOTHUB/Twin/res/200/?$rid=2", &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_TWIN_RESPONSE, topic_info.type);
+    ASSERT_ARE_EQUAL(int, 200, topic_info.status_code);
+    ASSERT_ARE_EQUAL(size_t, 2, topic_info.twin_request_id);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_004: [ Otherwise, for a topic starting with `$iothub/twin/`, mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_TWIN_RESPONSE, `status_code` to the number in the segment following the operation and `twin_request_id` to the number in the `$rid` property, or 0 if there is none. If the status code segment is missing, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_twin_response_without_status_code_fails)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result1 = mqtt_topic_parse("$iothub/twin/res", &topic_info);
+    int result2 = mqtt_topic_parse("$iothub/twin/res/", &topic_info);
+    int result3 = mqtt_topic_parse("$iothub/twin/", &topic_info);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_005: [ If `topic` starts with `$iothub/methods/` (case-insensitive), mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST, `method_name` to the segment following the HTTP verb and `request_id` to the value of the `$rid` property. If the method name or the `$rid` property is missing or empty, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_device_method_succeeds)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+
+    // act
+    int result = mqtt_topic_parse(TEST_METHOD_TOPIC, &topic_info);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST, topic_info.type);
+    assert_slice_is("reboot", &topic_info.method_name);
+    assert_slice_is("a1", &topic_info.request_id);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_005: [ If `topic` starts with `$iothub/methods/` (case-insensitive), mqtt_topic_parse shall set `type` to MQTT_TOPIC_TYPE_DEVICE_METHOD_REQUEST, `method_name` to the segment following the HTTP verb and `request_id` to the value of the `$rid` property. If the method name or the `$rid` property is missing or empty, mqtt_topic_parse shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_parse_device_method_without_name_or_request_id_fails)
+{
+    // arrange
+    const char* topics[] =
+    {
+        "$iothub/methods/POST",
+        "$iothub/methods/POST/",
+        "$iothub/methods/POST//?$rid=1",
+        "$iothub/methods/POST/reboot/",
+        "$iothub/methods/POST/reboot/?$rid=",
+        "$iothub/methods/POST/reboot/?$rid",
+        "$iothub/methods/POST/reboot/?rid=1"
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(topics) / sizeof(topics[0]); i++)
+    {
+        MQTT_TOPIC_INFO topic_info;
+
+        // act
+        int result = mqtt_topic_parse(topics[i], &topic_info);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, topics[i]);
+    }
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_007: [ If `properties`, `name` or `value` is NULL, mqtt_topic_get_next_property shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_get_next_property_NULL_arguments_fail)
+{
+    // arrange
+    MQTT_TOPIC_SLICE properties = { "a=1", 3 };
+    MQTT_TOPIC_SLICE name;
+    MQTT_TOPIC_SLICE value;
+
+    // act
+    int result1 = mqtt_topic_get_next_property(NULL, &name, &value);
+    int result2 = mqtt_topic_get_next_property(&properties, NULL, &value);
+    int result3 = mqtt_topic_get_next_property(&properties, &name, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_EQUAL(size_t, 3, properties.length);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_008: [ mqtt_topic_get_next_property shall remove the next '&'-separated pair from the front of `properties`, skipping empty pairs, and set `name` to the text before its first '=' and `value` to the text after it, or `value->value` to NULL if it has no '='. ] */
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_009: [ When `properties` has no pair left, mqtt_topic_get_next_property shall return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_get_next_property_iterates_all_pairs)
+{
+    // arrange
+    MQTT_TOPIC_INFO topic_info;
+    MQTT_TOPIC_SLICE name;
+    MQTT_TOPIC_SLICE value;
+    ASSERT_ARE_EQUAL(int, 0, mqtt_topic_parse(TEST_C2D_TOPIC, &topic_info));
+
+    // act / assert
+    assert_next_property_is(&topic_info.properties, "%24.mid", "msg%2F1");
+    assert_next_property_is(&topic_info.properties, "%24.to", "%2Fdevices%2FthisIsDeviceID%2Fmessages%2FdeviceBound");
+    assert_next_property_is(&topic_info.properties, "%24.cid", NULL);
+    assert_next_property_is(&topic_info.properties, "iothub-ack", "full");
+    assert_next_property_is(&topic_info.properties, "prop%20name", "a%26b");
+    ASSERT_ARE_NOT_EQUAL(int, 0, mqtt_topic_get_next_property(&topic_info.properties, &name, &value));
+    ASSERT_ARE_EQUAL(size_t, 0, topic_info.properties.length);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_008: [ mqtt_topic_get_next_property shall remove the next '&'-separated pair from the front of `properties`, skipping empty pairs, and set `name` to the text before its first '=' and `value` to the text after it, or `value->value` to NULL if it has no '='. ] */
+TEST_FUNCTION(mqtt_topic_get_next_property_skips_empty_pairs)
+{
+    // arrange
+    const char* text = "&&a=&=b&c=d=e&";
+    MQTT_TOPIC_SLICE properties;
+    MQTT_TOPIC_SLICE name;
+    MQTT_TOPIC_SLICE value;
+    properties.value = text;
+    properties.length = strlen(text);
+
+    // act / assert
+    assert_next_property_is(&properties, "a", "");
+    assert_next_property_is(&properties, "", "b");
+    assert_next_property_is(&properties, "c", "d=e");
+    ASSERT_ARE_NOT_EQUAL(int, 0, mqtt_topic_get_next_property(&properties, &name, &value));
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_010: [ If `encoded` or `buffer` is NULL, or `buffer_size` is 0, mqtt_topic_url_decode shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_url_decode_invalid_arguments_fail)
+{
+    // arrange
+    MQTT_TOPIC_SLICE encoded = { "a", 1 };
+    char buffer[4];
+
+    // act
+    int result1 = mqtt_topic_url_decode(NULL, buffer, sizeof(buffer));
+    int result2 = mqtt_topic_url_decode(&encoded, NULL, sizeof(buffer));
+    int result3 = mqtt_topic_url_decode(&encoded, buffer, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_011: [ mqtt_topic_url_decode shall replace each `%` followed by two hexadecimal digits by the character they encode, copy every other character as is, and NUL-terminate `buffer`. ] */
+TEST_FUNCTION(mqtt_topic_url_decode_succeeds)
+{
+    assert_decodes_to("", "");
+    assert_decodes_to("plain", "plain");
+    assert_decodes_to("%24.to", "$.to");
+    assert_decodes_to("%2Fdevices%2fd", "/devices/d");
+    assert_decodes_to("a%26b%3Dc%20d", "a&b=c d");
+    assert_decodes_to("100%", "100%");
+    assert_decodes_to("%4", "%4");
+    assert_decodes_to("%zz%4g", "%zz%4g");
+    assert_decodes_to("%%41", "%A");
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_012: [ If the decoded text and its NUL terminator do not fit in `buffer_size` bytes, mqtt_topic_url_decode shall fail and return a non-zero value. ] */
+TEST_FUNCTION(mqtt_topic_url_decode_buffer_too_small_fails)
+{
+    // arrange
+    MQTT_TOPIC_SLICE encoded = { "abc%24", 6 };
+    char buffer[5];
+
+    // act
+    int result1 = mqtt_topic_url_decode(&encoded, buffer, 4);
+    int result2 = mqtt_topic_url_decode(&encoded, buffer, 5);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_EQUAL(int, 0, result2);
+    ASSERT_ARE_EQUAL(char_ptr, "abc$", buffer);
+}
+
+/* Tests_SRS_IOTHUB_TRANSPORT_MQTT_TOPIC_09_002: [ mqtt_topic_parse shall not allocate memory, and all the slices it returns shall point into `topic`. ] */
+TEST_FUNCTION(mqtt_topic_random_topics_stay_in_bounds)
+{
+    // arrange
+    unsigned int state = 0x1234;
+    char topic[FUZZ_MAX_LENGTH + 1];
+    char decoded[FUZZ_MAX_LENGTH + 1];
+    size_t iteration;
+
+    for (iteration = 0; iteration < FUZZ_ITERATIONS; iteration++)
+    {
+        MQTT_TOPIC_INFO topic_info;
+        MQTT_TOPIC_SLICE name;
+        MQTT_TOPIC_SLICE value;
+        size_t pairs = 0;
+
+        make_fuzz_topic(&state, topic, sizeof(topic));
+
+        // act
+        if (mqtt_topic_parse(topic, &topic_info) == 0)
+        {
+            // assert
+            assert_slice_in_topic(topic, &topic_info.method_name);
+            assert_slice_in_topic(topic, &topic_info.request_id);
+            assert_slice_in_topic(topic, &topic_info.properties);
+
+            while (mqtt_topic_get_next_property(&topic_info.properties, &name, &value) == 0)
+            {
+                pairs++;
+                ASSERT_IS_TRUE_WITH_MSG(pairs <= strlen(topic), topic);
+                assert_slice_in_topic(topic, &name);
+                assert_slice_in_topic(topic, &value);
+
+                ASSERT_ARE_EQUAL_WITH_MSG(int, 0, mqtt_topic_url_decode(&name, decoded, name.length + 1), topic);
+                ASSERT_IS_TRUE_WITH_MSG(strlen(decoded) <= name.length, topic);
+                if (value.value != NULL)
+                {
+                    ASSERT_ARE_EQUAL_WITH_MSG(int, 0, mqtt_topic_url_decode(&value, decoded, value.length + 1), topic);
+                    ASSERT_IS_TRUE_WITH_MSG(strlen(decoded) <= value.length, topic);
+                }
+            }
+        }
+    }
+}
+
+END_TEST_SUITE(iothubtransport_mqtt_topic_ut)
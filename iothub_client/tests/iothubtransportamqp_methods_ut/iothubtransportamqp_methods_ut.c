@@ -432,7 +432,7 @@ static void setup_subscribe_expected_calls(void)
     STRICT_EXPECTED_CALL(STRING_delete(TEST_STRING_HANDLE));
 }
 
-static void setup_message_received_calls(void)
+static void setup_message_received_calls_with_handle_from_free_list(bool is_handle_in_free_list)
 {
     AMQP_VALUE correlation_id = (AMQP_VALUE)0x5000;
     AMQP_VALUE application_properties = (AMQP_VALUE)0x5001;
@@ -451,8 +451,10 @@ static void setup_message_received_calls(void)
         .CopyOutArgumentBuffer(2, &test_properties_handle, sizeof(test_properties_handle));
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    if (!is_handle_in_free_list)
+    {
+        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    }
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -477,6 +479,11 @@ static void setup_message_received_calls(void)
     STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
 }
 
+static void setup_message_received_calls(void)
+{
+    setup_message_received_calls_with_handle_from_free_list(false);
+}
+
 static void setup_method_respond_calls(void)
 {
     static const unsigned char response_payload[] = { 0x43 };
@@ -511,7 +518,6 @@ static void setup_method_respond_calls(void)
     STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER, TEST_RESPONSE_UAMQP_MESSAGE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_message_send_complete()
         .IgnoreArgument_callback_context();
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 }
 
 static void setup_respond_calls(int status)
@@ -548,8 +554,6 @@ static void setup_respond_calls(int status)
     STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER, TEST_RESPONSE_UAMQP_MESSAGE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_message_send_complete()
         .IgnoreArgument_callback_context();
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_value));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(response_properties_map));
@@ -728,6 +732,7 @@ TEST_FUNCTION(destroy_after_subscribe_also_destroys_links_and_the_message_receiv
 }
 
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_110: [ `iothubtransportamqp_methods_unsubscribe` shall free all tracked method handles indicated to the user via the callback `on_method_request_received` and than have not yet been completed by calls to `iothubtransportamqp_methods_respond`. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_156: [ `iothubtransportamqp_methods_destroy` shall free all tracked method handles and all method handles kept in the free list. ]*/
 TEST_FUNCTION(iothubtransportamqp_methods_destroy_frees_tracked_handles)
 {
     /// arrange
@@ -741,8 +746,7 @@ TEST_FUNCTION(iothubtransportamqp_methods_destroy_frees_tracked_handles)
     iothubtransportamqp_methods_unsubscribe(amqp_methods_handle);
     umock_c_reset_all_calls();
 
-    /* one extra free for the handle and one extra for the handle array */
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    /* one extra free for the tracked handle */
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -757,6 +761,7 @@ TEST_FUNCTION(iothubtransportamqp_methods_destroy_frees_tracked_handles)
 }
 
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_110: [ `iothubtransportamqp_methods_unsubscribe` shall free all tracked method handles indicated to the user via the callback `on_method_request_received` and than have not yet been completed by calls to `iothubtransportamqp_methods_respond`. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_156: [ `iothubtransportamqp_methods_destroy` shall free all tracked method handles and all method handles kept in the free list. ]*/
 TEST_FUNCTION(iothubtransportamqp_methods_destroy_frees_2_tracked_handles)
 {
     /// arrange
@@ -772,8 +777,7 @@ TEST_FUNCTION(iothubtransportamqp_methods_destroy_frees_2_tracked_handles)
     iothubtransportamqp_methods_unsubscribe(amqp_methods_handle);
     umock_c_reset_all_calls();
 
-    /* 2 extra frees for the handle and one extra for the handle array */
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    /* 2 extra frees for the tracked handles */
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -1335,9 +1339,9 @@ TEST_FUNCTION(iothubtransportamqp_methods_unsubscribe_after_unsubscribe_does_not
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_052: [ - `request` shall be set to the payload bytes obtained by calling `message_get_body_amqp_data_in_place`. ]*/
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_053: [ - `request_size` shall be set to the payload size obtained by calling `message_get_body_amqp_data_in_place`. ]*/
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_054: [ - `method_handle` shall be set to a newly created `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` that can be passed later as an argument to `iothubtransportamqp_methods_respond`. ]*/
-/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_112: [ Memory shall be allocated for the `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` to hold the correlation-id, so that it can be used in the `iothubtransportamqp_methods_respond` function. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_112: [ An `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` shall be taken from the free list of released handles, or allocated if the free list is empty, to hold the correlation-id, so that it can be used in the `iothubtransportamqp_methods_respond` function. ]*/
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_056: [ On success the `on_message_received` callback shall return a newly constructed delivery state obtained by calling `messaging_delivery_accepted`. ]*/
-/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_113: [ All `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` handles shall be tracked in an array of handles that shall be resized accordingly when a methopd handle is added to it. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_113: [ All `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` handles shall be tracked in an intrusive doubly linked list of outstanding handles. ]*/
 TEST_FUNCTION(when_a_message_is_received_a_new_method_request_is_indicated)
 {
     /// arrange
@@ -1482,40 +1486,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_method_handle_fails_the_message_is_
     iothubtransportamqp_methods_destroy(amqp_methods_handle);
 }
 
-/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_138: [ If resizing the tracked method handles array fails, the RELEASED outcome shall be returned and an error shall be indicated. ]*/
-TEST_FUNCTION(when_reallocating_memory_for_tracked_handles_fails_the_message_is_rejected)
-{
-    /// arrange
-    IOTHUBTRANSPORT_AMQP_METHODS_HANDLE amqp_methods_handle = iothubtransportamqp_methods_create("testhost", "testdevice");
-    AMQP_VALUE correlation_id = (AMQP_VALUE)0x5000;
-    AMQP_VALUE result;
-    umock_c_reset_all_calls();
-    setup_subscribe_expected_calls();
-    (void)iothubtransportamqp_methods_subscribe(amqp_methods_handle, TEST_SESSION_HANDLE, test_on_methods_error, (void*)0x4242, test_on_method_request_received, (void*)0x4243, test_on_methods_unsubscribed, (void*)0x4344);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(message_get_properties(TEST_UAMQP_MESSAGE, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &test_properties_handle, sizeof(test_properties_handle));
-    STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
-    STRICT_EXPECTED_CALL(messaging_delivery_released());
-    STRICT_EXPECTED_CALL(test_on_methods_error((void*)0x4242));
-    /// act
-    result = g_on_message_received(amqp_methods_handle, TEST_UAMQP_MESSAGE);
-
-    /// assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(void_ptr, TEST_DELIVERY_RELEASED, result);
-
-    /// cleanup
-    iothubtransportamqp_methods_destroy(amqp_methods_handle);
-}
-
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_122: [ If `amqpvalue_get_uuid` fails the REJECTED outcome with `amqp:decode-error` shall be returned. ]*/
 TEST_FUNCTION(when_amqpvalue_get_uuid_fails_the_message_is_rejected)
 {
@@ -1534,11 +1504,9 @@ TEST_FUNCTION(when_amqpvalue_get_uuid_fails_the_message_is_rejected)
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid))
         .SetReturn(42);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected("amqp:decode-error", IGNORED_PTR_ARG))
         .IgnoreArgument_error_description();
     STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
@@ -1578,13 +1546,11 @@ TEST_FUNCTION(when_message_get_body_amqp_data_in_place_fails_the_message_is_reje
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &binary_data, sizeof(binary_data))
         .SetReturn(42);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected("amqp:decode-error", IGNORED_PTR_ARG))
         .IgnoreArgument_error_description();
     STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
@@ -1625,7 +1591,6 @@ TEST_FUNCTION(when_message_get_application_properties_fails_the_message_is_rejec
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1633,7 +1598,6 @@ TEST_FUNCTION(when_message_get_application_properties_fails_the_message_is_rejec
     STRICT_EXPECTED_CALL(message_get_application_properties(TEST_UAMQP_MESSAGE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &application_properties, sizeof(application_properties))
         .SetReturn(42);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected("amqp:decode-error", IGNORED_PTR_ARG))
         .IgnoreArgument_error_description();
     STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
@@ -1674,7 +1638,6 @@ TEST_FUNCTION(when_amqpvalue_get_inplace_described_value_fails_the_message_is_re
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1683,7 +1646,6 @@ TEST_FUNCTION(when_amqpvalue_get_inplace_described_value_fails_the_message_is_re
         .CopyOutArgumentBuffer(2, &application_properties, sizeof(application_properties));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(application_properties))
         .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(application_properties_destroy(application_properties));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
     STRICT_EXPECTED_CALL(messaging_delivery_released());
@@ -1726,7 +1688,6 @@ TEST_FUNCTION(when_amqpvalue_create_string_fails_the_message_is_released)
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1737,7 +1698,6 @@ TEST_FUNCTION(when_amqpvalue_create_string_fails_the_message_is_released)
         .SetReturn(application_properties_map);
     STRICT_EXPECTED_CALL(amqpvalue_create_string("IoThub-methodname"))
         .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(application_properties_destroy(application_properties));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties_handle));
     STRICT_EXPECTED_CALL(messaging_delivery_released());
@@ -1781,7 +1741,6 @@ TEST_FUNCTION(when_amqpvalue_get_map_value_fails_the_message_is_rejected)
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1794,7 +1753,6 @@ TEST_FUNCTION(when_amqpvalue_get_map_value_fails_the_message_is_rejected)
         .SetReturn(test_property_key);
     STRICT_EXPECTED_CALL(amqpvalue_get_map_value(application_properties_map, test_property_key))
         .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected("amqp:decode-error", IGNORED_PTR_ARG))
         .IgnoreArgument_error_description();
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_key));
@@ -1840,7 +1798,6 @@ TEST_FUNCTION(when_amqpvalue_get_string_fails_the_message_is_rejected)
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1856,7 +1813,6 @@ TEST_FUNCTION(when_amqpvalue_get_string_fails_the_message_is_rejected)
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_property_value, IGNORED_PTR_ARG))
         .IgnoreArgument_string_value()
         .SetReturn(1);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected("amqp:decode-error", IGNORED_PTR_ARG))
         .IgnoreArgument_error_description();
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_value));
@@ -1904,7 +1860,6 @@ TEST_FUNCTION(when_messaging_delivery_accepted_fails_an_RELEASED_outcome_shall_b
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1921,7 +1876,6 @@ TEST_FUNCTION(when_messaging_delivery_accepted_fails_an_RELEASED_outcome_shall_b
         .CopyOutArgumentBuffer(2, &method_name_ptr, sizeof(method_name_ptr));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted())
         .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_value));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_key));
     STRICT_EXPECTED_CALL(application_properties_destroy(application_properties));
@@ -1969,7 +1923,6 @@ TEST_FUNCTION(when_creating_the_RELEASED_outcome_fails_an_error_is_triggered)
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -1986,7 +1939,6 @@ TEST_FUNCTION(when_creating_the_RELEASED_outcome_fails_an_error_is_triggered)
         .CopyOutArgumentBuffer(2, &method_name_ptr, sizeof(method_name_ptr));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted())
         .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_value));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_key));
     STRICT_EXPECTED_CALL(application_properties_destroy(application_properties));
@@ -2035,7 +1987,6 @@ TEST_FUNCTION(when_calling_the_method_request_received_callback_fails_then_RELEA
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -2056,7 +2007,6 @@ TEST_FUNCTION(when_calling_the_method_request_received_callback_fails_then_RELEA
         .IgnoreArgument_method_handle()
         .SetReturn(42);
     STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_DELIVERY_ACCEPTED));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected("amqp:internal-error", IGNORED_PTR_ARG))
         .IgnoreArgument_error_description();
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_property_value));
@@ -2134,7 +2084,7 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_with_NULL_response_fails)
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_067: [ The message shall be handed over to the message_sender by calling `messagesender_send` and passing as arguments: ]*/
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_068: [ - The response message handle. ]*/
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_069: [ - A send callback and its context for the `on_message_send_complete` callback. ]*/
-/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_111: [ The handle `method_handle` shall be freed (have no meaning) after `iothubtransportamqp_methods_respond` has been executed. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_111: [ The handle `method_handle` shall be released (have no meaning) after `iothubtransportamqp_methods_respond` has been executed. ]*/
 /* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_095: [ The application property map and all intermediate values shall be freed after being passed to `message_set_application_properties`. ]*/
 TEST_FUNCTION(iothubtransportamqp_methods_respond_sends_the_uAMQP_message)
 {
@@ -2181,8 +2131,6 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_sends_the_uAMQP_message)
     STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER, TEST_RESPONSE_UAMQP_MESSAGE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_message_send_complete()
         .IgnoreArgument_callback_context();
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_value));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(response_properties_map));
@@ -2293,11 +2241,10 @@ TEST_FUNCTION(when_a_failure_occurs_iothubtransportamqp_methods_respond_fails)
         .IgnoreArgument_on_message_send_complete()
         .IgnoreArgument_callback_context()
         .SetFailReturn(1);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     umock_c_negative_tests_snapshot();
 
-    for (size_t i = 0; i < umock_c_negative_tests_call_count() - 1; i++)
+    for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
         umock_c_negative_tests_reset();
         umock_c_negative_tests_fail_call(i);
@@ -2355,7 +2302,6 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_can_be_called_from_the_method_
     STRICT_EXPECTED_CALL(properties_get_correlation_id(test_properties_handle, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id, sizeof(correlation_id));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_uuid(correlation_id, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &correlation_id_uuid, sizeof(correlation_id_uuid));
     STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_UAMQP_MESSAGE, 0, IGNORED_PTR_ARG))
@@ -2396,8 +2342,6 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_can_be_called_from_the_method_
     STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER, TEST_RESPONSE_UAMQP_MESSAGE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_message_send_complete()
         .IgnoreArgument_callback_context();
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_value));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(response_properties_map));
@@ -2476,8 +2420,6 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_to_the_second_method_succeeds)
     STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER, TEST_RESPONSE_UAMQP_MESSAGE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_message_send_complete()
         .IgnoreArgument_callback_context();
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_value));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(status_property_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(response_properties_map));
@@ -2497,7 +2439,7 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_to_the_second_method_succeeds)
     iothubtransportamqp_methods_destroy(amqp_methods_handle);
 }
 
-/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the array used to track the method handles. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the list used to track the method handles. ]*/
 TEST_FUNCTION(iothubtransportamqp_methods_respond_removes_the_handle_from_the_tracked_handles)
 {
     /// arrange
@@ -2524,7 +2466,7 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_removes_the_handle_from_the_tr
     iothubtransportamqp_methods_unsubscribe(amqp_methods_handle);
     umock_c_reset_all_calls();
 
-    /* 1 extra free for the handle and one extra for the handle array */
+    /* one extra free for the tracked handle and one extra for the released handle kept in the free list */
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -2539,12 +2481,13 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_removes_the_handle_from_the_tr
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the array used to track the method handles. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the list used to track the method handles. ]*/
 TEST_FUNCTION(iothubtransportamqp_methods_respond_after_a_handle_has_been_removed_works)
 {
     /// arrange
     IOTHUBTRANSPORT_AMQP_METHODS_HANDLE amqp_methods_handle = iothubtransportamqp_methods_create("testhost", "testdevice");
     const unsigned char response_payload[] = { 0x43 };
+    int result;
 
     umock_c_reset_all_calls();
     setup_subscribe_expected_calls();
@@ -2559,15 +2502,150 @@ TEST_FUNCTION(iothubtransportamqp_methods_respond_after_a_handle_has_been_remove
     umock_c_reset_all_calls();
 
     /* setup second request */
+    setup_message_received_calls_with_handle_from_free_list(true);
+    g_on_message_received(amqp_methods_handle, TEST_UAMQP_MESSAGE);
+    setup_respond_calls(242);
+
+    /// act
+    result = iothubtransportamqp_methods_respond(g_method_handle, response_payload, sizeof(response_payload), 242);
+
+    /// assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    ///cleanup
+    iothubtransportamqp_methods_destroy(amqp_methods_handle);
+}
+
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_112: [ An `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` shall be taken from the free list of released handles, or allocated if the free list is empty, to hold the correlation-id, so that it can be used in the `iothubtransportamqp_methods_respond` function. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_155: [ A released handle shall be kept in a free list of at most 16 handles for reuse by the next method request; if the free list is full the handle shall be freed. ]*/
+TEST_FUNCTION(a_method_request_received_after_a_respond_reuses_the_released_handle)
+{
+    /// arrange
+    IOTHUBTRANSPORT_AMQP_METHODS_HANDLE amqp_methods_handle = iothubtransportamqp_methods_create("testhost", "testdevice");
+    const unsigned char response_payload[] = { 0x43 };
+    IOTHUBTRANSPORT_AMQP_METHOD_HANDLE first_method_handle;
+
+    umock_c_reset_all_calls();
+    setup_subscribe_expected_calls();
+    (void)iothubtransportamqp_methods_subscribe(amqp_methods_handle, TEST_SESSION_HANDLE, test_on_methods_error, (void*)0x4242, test_on_method_request_received, (void*)0x4243, test_on_methods_unsubscribed, (void*)0x4344);
+    umock_c_reset_all_calls();
     setup_message_received_calls();
+    g_on_message_received(amqp_methods_handle, TEST_UAMQP_MESSAGE);
+    first_method_handle = g_method_handle;
+    setup_respond_calls(242);
+    (void)iothubtransportamqp_methods_respond(first_method_handle, response_payload, sizeof(response_payload), 242);
+    umock_c_reset_all_calls();
+
+    setup_message_received_calls_with_handle_from_free_list(true);
 
     /// act
     g_on_message_received(amqp_methods_handle, TEST_UAMQP_MESSAGE);
 
     /// assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, first_method_handle, g_method_handle);
+
+    ///cleanup
+    iothubtransportamqp_methods_destroy(amqp_methods_handle);
+}
+
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_155: [ A released handle shall be kept in a free list of at most 16 handles for reuse by the next method request; if the free list is full the handle shall be freed. ]*/
+TEST_FUNCTION(when_the_free_list_is_full_a_released_handle_is_freed)
+{
+    /// arrange
+    IOTHUBTRANSPORT_AMQP_METHODS_HANDLE amqp_methods_handle = iothubtransportamqp_methods_create("testhost", "testdevice");
+    const unsigned char response_payload[] = { 0x43 };
+    IOTHUBTRANSPORT_AMQP_METHOD_HANDLE method_handles[17];
+    size_t i;
+    int result;
+
+    umock_c_reset_all_calls();
+    setup_subscribe_expected_calls();
+    (void)iothubtransportamqp_methods_subscribe(amqp_methods_handle, TEST_SESSION_HANDLE, test_on_methods_error, (void*)0x4242, test_on_method_request_received, (void*)0x4243, test_on_methods_unsubscribed, (void*)0x4344);
+    for (i = 0; i < sizeof(method_handles) / sizeof(method_handles[0]); i++)
+    {
+        umock_c_reset_all_calls();
+        setup_message_received_calls();
+        g_on_message_received(amqp_methods_handle, TEST_UAMQP_MESSAGE);
+        method_handles[i] = g_method_handle;
+    }
+    for (i = 0; i < 16; i++)
+    {
+        umock_c_reset_all_calls();
+        setup_respond_calls(242);
+        (void)iothubtransportamqp_methods_respond(method_handles[i], response_payload, sizeof(response_payload), 242);
+    }
+    umock_c_reset_all_calls();
+
+    setup_respond_calls(242);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    /// act
+    result = iothubtransportamqp_methods_respond(method_handles[16], response_payload, sizeof(response_payload), 242);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    iothubtransportamqp_methods_destroy(amqp_methods_handle);
+}
+
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_113: [ All `IOTHUBTRANSPORT_AMQP_METHOD_HANDLE` handles shall be tracked in an intrusive doubly linked list of outstanding handles. ]*/
+/* Tests_SRS_IOTHUBTRANSPORT_AMQP_METHODS_01_114: [ The handle `method_handle` shall be removed from the list used to track the method handles. ]*/
+TEST_FUNCTION(responding_to_10000_outstanding_method_requests_in_random_order_succeeds)
+{
+    /// arrange
+    IOTHUBTRANSPORT_AMQP_METHODS_HANDLE amqp_methods_handle = iothubtransportamqp_methods_create("testhost", "testdevice");
+    const unsigned char response_payload[] = { 0x43 };
+    const size_t method_request_count = 10000;
+    IOTHUBTRANSPORT_AMQP_METHOD_HANDLE* method_handles = (IOTHUBTRANSPORT_AMQP_METHOD_HANDLE*)my_gballoc_malloc(method_request_count * sizeof(IOTHUBTRANSPORT_AMQP_METHOD_HANDLE));
+    size_t i;
+
+    ASSERT_IS_NOT_NULL(method_handles);
+    umock_c_reset_all_calls();
+    setup_subscribe_expected_calls();
+    (void)iothubtransportamqp_methods_subscribe(amqp_methods_handle, TEST_SESSION_HANDLE, test_on_methods_error, (void*)0x4242, test_on_method_request_received, (void*)0x4243, test_on_methods_unsubscribed, (void*)0x4344);
+    for (i = 0; i < method_request_count; i++)
+    {
+        umock_c_reset_all_calls();
+        setup_message_received_calls();
+        g_on_message_received(amqp_methods_handle, TEST_UAMQP_MESSAGE);
+        method_handles[i] = g_method_handle;
+    }
+
+    /* shuffle so that handles are removed from the head, the tail and the middle of the tracked list */
+    srand(42);
+    for (i = method_request_count - 1; i > 0; i--)
+    {
+        size_t j = (size_t)rand() % (i + 1);
+        IOTHUBTRANSPORT_AMQP_METHOD_HANDLE temp = method_handles[i];
+        method_handles[i] = method_handles[j];
+        method_handles[j] = temp;
+    }
+
+    /// act
+    for (i = 0; i < method_request_count; i++)
+    {
+        int result;
+
+        umock_c_reset_all_calls();
+        setup_respond_calls(242);
+        if (i >= 16)
+        {
+            EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        }
+
+        result = iothubtransportamqp_methods_respond(method_handles[i], response_payload, sizeof(response_payload), 242);
+
+        /// assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
 
     ///cleanup
+    my_gballoc_free(method_handles);
     iothubtransportamqp_methods_destroy(amqp_methods_handle);
 }
 
@@ -689,6 +689,25 @@ TEST_FUNCTION(AMQP_GetHostname)
 	// cleanup
 }
 
+// Tests_SRS_IOTHUBTRANSPORTAMQP_09_021: [IoTHubTransportAMQP_GetStatistics shall get the transport statistics by calling into the IoTHubTransport_AMQP_Common_GetStatistics()]
+TEST_FUNCTION(AMQP_GetStatistics)
+{
+	// arrange
+	TRANSPORT_PROVIDER* provider = (TRANSPORT_PROVIDER*)AMQP_Protocol();
+	IOTHUB_CLIENT_STATISTICS statistics;
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(IoTHubTransport_AMQP_Common_GetStatistics(TEST_TRANSPORT_LL_HANDLE, &statistics));
+
+	// act
+	provider->IoTHubTransport_GetStatistics(TEST_TRANSPORT_LL_HANDLE, &statistics);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+}
+
 // Tests_SRS_IOTHUBTRANSPORTAMQP_09_005: [IoTHubTransportAMQP_Destroy shall destroy the TRANSPORT_LL_HANDLE by calling into the IoTHubTransport_AMQP_Common_Destroy().]
 TEST_FUNCTION(AMQP_Destroy)
 {
@@ -48,6 +48,11 @@ static void my_gballoc_free(void* ptr)
 #include "iothub_client_options.h"
 #include "iothub_client_version.h"
 #include "iothub_client_private.h"
+#include "iothub_client_tls_session_cache.h"
+#include "iothubtransport_http_engine.h"
+#include "azure_c_shared_utility/sastoken.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
 #undef ENABLE_MOCKS
 
 #include "iothubtransporthttp.h"
@@ -132,6 +137,12 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(IOTHUB_CLIENT_CONFIRMATION_RESULT, IOTHUB_CLIENT_CON
 #define TEST_PROPERTY_A_VALUE "value_of_a"
 
 #define TEST_HTTPAPIEX_HANDLE (HTTPAPIEX_HANDLE)0x343
+#define TEST_TLS_SESSION_CACHE_HANDLE (TLS_SESSION_CACHE_HANDLE)0x344
+#define TEST_TLS_SESSION_STORE (const TLS_SESSION_STORE*)0x345
+#define TEST_HTTP_ENGINE_HANDLE (HTTP_ENGINE_HANDLE)0x346
+#define TEST_TICK_COUNTER_HANDLE (TICK_COUNTER_HANDLE)0x347
+#define TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS 1000
+#define TEST_POOL_SAS_TOKEN "SharedAccessSignature sr=thisIsPoolSasToken"
 
 //static const bool thisIsTrue = true;
 //static const bool thisIsFalse = false;
@@ -491,6 +502,7 @@ static pfIoTHubTransport_Subscribe                      IoTHubTransportHttp_Subs
 static pfIoTHubTransport_Unsubscribe                    IoTHubTransportHttp_Unsubscribe;
 static pfIoTHubTransport_DoWork                         IoTHubTransportHttp_DoWork;
 static pfIoTHubTransport_GetSendStatus                  IoTHubTransportHttp_GetSendStatus;
+static pfIoTHubTransport_GetStatistics                  IoTHubTransportHttp_GetStatistics;
 
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
@@ -510,6 +522,58 @@ STRING_HANDLE my_URL_EncodeString(const char* textEncode)
     return real_STRING_construct(TEST_DEVICE_ID);
 }
 
+STRING_HANDLE my_URL_Encode(STRING_HANDLE input)
+{
+    (void)input;
+    return real_STRING_construct(TEST_DEVICE_ID);
+}
+
+STRING_HANDLE my_SASToken_CreateString(const char* key, const char* scope, const char* keyName, size_t expiry)
+{
+    (void)key;
+    (void)scope;
+    (void)keyName;
+    (void)expiry;
+    return real_STRING_construct(TEST_POOL_SAS_TOKEN);
+}
+
+static HTTP_ENGINE_GET_IO_TRANSPORT last_http_engine_get_io_transport;
+static HTTP_ENGINE_HANDLE my_http_engine_create(const HTTP_ENGINE_CONFIG* config)
+{
+    last_http_engine_get_io_transport = config->get_io_transport;
+    return TEST_HTTP_ENGINE_HANDLE;
+}
+
+static ON_HTTP_ENGINE_RESPONSE last_on_http_engine_response;
+static void* last_on_http_engine_response_context;
+static int my_http_engine_execute_request_async(HTTP_ENGINE_HANDLE http_engine_handle, HTTPAPI_REQUEST_TYPE request_type, const char* relative_path, HTTP_HEADERS_HANDLE request_headers, const unsigned char* content, size_t content_size, ON_HTTP_ENGINE_RESPONSE on_response, void* context)
+{
+    (void)http_engine_handle;
+    (void)request_type;
+    (void)relative_path;
+    (void)request_headers;
+    (void)content;
+    (void)content_size;
+    last_on_http_engine_response = on_response;
+    last_on_http_engine_response_context = context;
+    return 0;
+}
+
+static tickcounter_ms_t test_current_ms;
+static int test_tickcounter_get_current_ms_result;
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = test_current_ms;
+    return test_tickcounter_get_current_ms_result;
+}
+
+static XIO_HANDLE test_get_io_transport(const char* fully_qualified_name)
+{
+    (void)fully_qualified_name;
+    return NULL;
+}
+
 HTTPAPIEX_HANDLE my_HTTPAPIEX_Create(const char* hostName)
 {
     (void)hostName;
@@ -887,12 +951,37 @@ static void setupCreateHappyPathPerDeviceList(bool deallocateCreated)
     }
 }
 
+static void setupCreateHappyPathHttpEngine(bool deallocateCreated)
+{
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(http_engine_create(IGNORED_PTR_ARG));
+    if (deallocateCreated == true)
+    {
+        STRICT_EXPECTED_CALL(http_engine_destroy(TEST_HTTP_ENGINE_HANDLE));
+    }
+}
+
+static void setupCreateHappyPathTlsSessionCache(bool deallocateCreated)
+{
+    STRICT_EXPECTED_CALL(tls_session_cache_create());
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tls_session_cache_get_store(TEST_TLS_SESSION_CACHE_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SetOption(IGNORED_PTR_ARG, OPTION_TLS_SESSION_STORE, TEST_TLS_SESSION_STORE));
+    STRICT_EXPECTED_CALL(http_engine_set_option(TEST_HTTP_ENGINE_HANDLE, OPTION_TLS_SESSION_STORE, TEST_TLS_SESSION_STORE));
+    if (deallocateCreated == true)
+    {
+        STRICT_EXPECTED_CALL(tls_session_cache_destroy(TEST_TLS_SESSION_CACHE_HANDLE));
+    }
+}
+
 static void setupCreateHappyPath(bool deallocateCreated)
 {
     setupCreateHappyPathAlloc(deallocateCreated);
     setupCreateHappyPathHostname(deallocateCreated);
     setupCreateHappyPathApiExHandle(deallocateCreated);
     setupCreateHappyPathPerDeviceList(deallocateCreated);
+    setupCreateHappyPathHttpEngine(deallocateCreated);
+    setupCreateHappyPathTlsSessionCache(deallocateCreated);
 }
 
 static void setupUnregisterOneDevice()
@@ -1102,6 +1191,37 @@ static void setupDoWorkLoopForNextDevice(size_t next)
     STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, next));
 }
 
+static TRANSPORT_LL_HANDLE createTransportWithAdaptivePolling(IOTHUB_DEVICE_HANDLE* devHandle)
+{
+    unsigned int minIntervalMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &minIntervalMs);
+    *devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_Subscribe(*devHandle);
+    /*schedules the first GET, less than TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS later*/
+    test_current_ms = 0;
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    return handle;
+}
+
+/*runs _DoWork at `currentMs`; returns true if it issued a GET, answered with `statusCode`*/
+static bool doWorkPollsAt(TRANSPORT_LL_HANDLE handle, tickcounter_ms_t currentMs, unsigned int statusCode)
+{
+    bool result;
+    umock_c_reset_all_calls();
+    test_current_ms = currentMs;
+
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .CopyOutArgumentBuffer(7, &statusCode, sizeof(statusCode));
+
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    result = (strcmp(umock_c_get_expected_calls(), "") == 0);
+    umock_c_reset_all_calls();
+    return result;
+}
+
 BEGIN_TEST_SUITE(iothubtransporthttp_ut)
 
 TEST_SUITE_INITIALIZE(suite_init)
@@ -1136,6 +1256,12 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_SAS_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPI_REQUEST_TYPE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TLS_SESSION_CACHE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const TLS_SESSION_STORE*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HTTP_ENGINE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const HTTP_ENGINE_CONFIG*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_HTTP_ENGINE_RESPONSE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
 
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONFIRMATION_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
@@ -1178,6 +1304,25 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPAPIEX_Create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_Destroy, my_HTTPAPIEX_Destroy);
 
+    REGISTER_GLOBAL_MOCK_RETURN(tls_session_cache_create, TEST_TLS_SESSION_CACHE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tls_session_cache_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(tls_session_cache_get_store, TEST_TLS_SESSION_STORE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tls_session_cache_get_store, NULL);
+
+    REGISTER_GLOBAL_MOCK_HOOK(http_engine_create, my_http_engine_create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(http_engine_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(http_engine_set_max_connections, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(http_engine_set_max_connections, __LINE__);
+    REGISTER_GLOBAL_MOCK_RETURN(http_engine_set_option, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(http_engine_set_option, __LINE__);
+    REGISTER_GLOBAL_MOCK_HOOK(http_engine_execute_request_async, my_http_engine_execute_request_async);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(http_engine_execute_request_async, __LINE__);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, __LINE__);
+
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, real_VECTOR_create);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_destroy, real_VECTOR_destroy);
@@ -1194,6 +1339,11 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     REGISTER_GLOBAL_MOCK_HOOK(URL_EncodeString, my_URL_EncodeString);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(URL_EncodeString, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(URL_Encode, my_URL_Encode);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(URL_Encode, NULL);
+
+    REGISTER_GLOBAL_MOCK_HOOK(SASToken_CreateString, my_SASToken_CreateString);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(SASToken_CreateString, NULL);
 
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromByteArray, my_IoTHubMessage_CreateFromByteArray);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_CreateFromByteArray, NULL);
@@ -1281,6 +1431,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     IoTHubTransportHttp_Unsubscribe = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_Unsubscribe;
     IoTHubTransportHttp_DoWork = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_DoWork;
     IoTHubTransportHttp_GetSendStatus = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_GetSendStatus;
+    IoTHubTransportHttp_GetStatistics = ((TRANSPORT_PROVIDER*)HTTP_Protocol())->IoTHubTransport_GetStatistics;
 
     TEST_STRING_HANDLE = real_STRING_construct(TEST_STRING_DATA);
 }
@@ -1310,6 +1461,11 @@ TEST_FUNCTION_INITIALIZE(method_init)
     real_DList_InitializeListHead(&waitingToSend);
     real_DList_InitializeListHead(&waitingToSend2);
     last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest = NULL;
+    last_http_engine_get_io_transport = NULL;
+    last_on_http_engine_response = NULL;
+    last_on_http_engine_response_context = NULL;
+    test_current_ms = 0;
+    test_tickcounter_get_current_ms_result = 0;
 
     my_IoTHubClient_LL_MessageCallback_messageData = NULL;
     my_IoTHubClient_LL_MessageCallback_return_value = true;
@@ -1463,6 +1619,8 @@ TEST_FUNCTION(IoTHubTransportHttp_Create_happy_path_with_gwhostname)
     setupCreateHappyPathGWHostname(false);
     setupCreateHappyPathApiExHandle(false);
     setupCreateHappyPathPerDeviceList(false);
+    setupCreateHappyPathHttpEngine(false);
+    setupCreateHappyPathTlsSessionCache(false);
 
     //act
     TRANSPORT_LL_HANDLE result = IoTHubTransportHttp_Create(&TEST_GW_CONFIG);
@@ -1490,10 +1648,13 @@ TEST_FUNCTION(IoTHubTransportHttp_Create_fails)
     setupCreateHappyPathHostname(false);
     setupCreateHappyPathApiExHandle(false);
     setupCreateHappyPathPerDeviceList(false);
+    setupCreateHappyPathHttpEngine(false);
+    setupCreateHappyPathTlsSessionCache(false);
 
     umock_c_negative_tests_snapshot();
 
-    size_t calls_cannot_fail[] = { 4 };
+    // The HTTP engine and the TLS session cache are optional, failing to set them up does not fail the transport creation
+    size_t calls_cannot_fail[] = { 4, 7, 8, 9, 10, 11, 12, 13 };
 
     //act
     size_t count = umock_c_negative_tests_call_count();
@@ -1520,6 +1681,34 @@ TEST_FUNCTION(IoTHubTransportHttp_Create_fails)
     umock_c_negative_tests_deinit();
 }
 
+//Tests_SRS_TRANSPORTMULTITHTTP_09_005: [ `IoTHubTransportHttp_Create` shall create a TLS session cache by calling `tls_session_cache_create` and pass the TLS session store for the hostname, obtained with `tls_session_cache_get_store`, to `HTTPAPIEX_SetOption` as `OPTION_TLS_SESSION_STORE`. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_006: [ If creating the TLS session cache or setting the TLS session store fails, `IoTHubTransportHttp_Create` shall continue without TLS session resumption. ]
+TEST_FUNCTION(IoTHubTransportHttp_Create_succeeds_when_TLS_session_store_is_rejected)
+{
+    //arrange
+    setupCreateHappyPathAlloc(false);
+    setupCreateHappyPathHostname(false);
+    setupCreateHappyPathApiExHandle(false);
+    setupCreateHappyPathPerDeviceList(false);
+    setupCreateHappyPathHttpEngine(false);
+    STRICT_EXPECTED_CALL(tls_session_cache_create());
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tls_session_cache_get_store(TEST_TLS_SESSION_CACHE_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SetOption(IGNORED_PTR_ARG, OPTION_TLS_SESSION_STORE, TEST_TLS_SESSION_STORE))
+        .SetReturn(HTTPAPIEX_INVALID_ARG);
+    STRICT_EXPECTED_CALL(tls_session_cache_destroy(TEST_TLS_SESSION_CACHE_HANDLE));
+
+    //act
+    TRANSPORT_LL_HANDLE result = IoTHubTransportHttp_Create(&TEST_CONFIG);
+
+    //assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(result);
+}
+
 //Tests_SRS_TRANSPORTMULTITHTTP_17_012: [ IoTHubTransportHttp_Destroy shall do nothing is handle is NULL. ]
 TEST_FUNCTION(IoTHubTransportHttp_Destroy_with_NULL_handle_does_nothing)
 {
@@ -1541,7 +1730,9 @@ TEST_FUNCTION(IoTHubTransportHttp_Destroy_succeeds_NoRegistered_devices)
     STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));                                             //STRING_HANDLE hostName;
     STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));                                             //HTTPAPIEX_HANDLE httpApiExHandle;
     STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(http_engine_destroy(TEST_HTTP_ENGINE_HANDLE));
     STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tls_session_cache_destroy(TEST_TLS_SESSION_CACHE_HANDLE));
     STRICT_EXPECTED_CALL(gballoc_free(handle));
 
     //act
@@ -1561,11 +1752,13 @@ TEST_FUNCTION(IoTHubTransportHttp_Destroy_succeeds_One_Registered_device)
     STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(http_engine_destroy(TEST_HTTP_ENGINE_HANDLE));
     STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0));
     setupUnregisterOneDevice();
     STRICT_EXPECTED_CALL(gballoc_free(devHandle));
 
     STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tls_session_cache_destroy(TEST_TLS_SESSION_CACHE_HANDLE));
     STRICT_EXPECTED_CALL(gballoc_free(handle));
     STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
 
@@ -10668,6 +10861,7 @@ TEST_FUNCTION(IoTHubTransportHttp_SetOption_with_NULL_value_fails)
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_119: [ The following table translates HTTPAPIEX return codes to IOTHUB_CLIENT_RESULT return codes: ]
 //Tests_SRS_TRANSPORTMULTITHTTP_17_118: [ Otherwise, IoTHubTransport_Http shall call HTTPAPIEX_SetOption with the same parameters and return the translated code. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_024: [ Options accepted by HTTPAPIEX_SetOption shall also be passed to `http_engine_set_option`, which ignores the options it does not support. ]
 TEST_FUNCTION(IoTHubTransportHttp_SetOption_succeeds_when_HTTPAPIEX_succeeds)
 {
     //arrange
@@ -10676,6 +10870,7 @@ TEST_FUNCTION(IoTHubTransportHttp_SetOption_succeeds_when_HTTPAPIEX_succeeds)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(HTTPAPIEX_SetOption(TEST_HTTPAPIEX_HANDLE, "someOption", (void*)42));
+    STRICT_EXPECTED_CALL(http_engine_set_option(TEST_HTTP_ENGINE_HANDLE, "someOption", (void*)42));
 
     //act
     auto result = IoTHubTransportHttp_SetOption(handle, "someOption", (void*)42);
@@ -10757,173 +10952,824 @@ TEST_FUNCTION(IoTHubTransportHttp_SetOption_fails_when_HTTPAPIEX_returns_any_oth
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_096: [ If IoTHubClient_LL_MessageCallback returns IOTHUBMESSAGE_ABANDONED then _DoWork shall "abandon" the message. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_happy_path_with_empty_waitingToSend_and_1_service_message_with_abandon_succeeds)
+//Tests_SRS_TRANSPORTMULTITHTTP_09_021: ["http_connection_pool_size"] 
+//Tests_SRS_TRANSPORTMULTITHTTP_09_023: [ The pool size shall be set by calling `http_engine_set_max_connections`; if that fails (e.g. requests are in flight) IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_ERROR and keep the previous size. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_http_connection_pool_size_succeeds)
 {
     //arrange
-     
-    unsigned int statusCode200 = 200;
-    unsigned int statusCode204 = 204;
+    size_t connectionPoolSize = 4;
     TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    (void)IoTHubTransportHttp_Subscribe(devHandle);
     umock_c_reset_all_calls();
-    setupDoWorkLoopOnceForOneDevice();
-
-    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend)); /*because DoWork for event*/
-
-    STRICT_EXPECTED_CALL(get_time(NULL));
-    STRICT_EXPECTED_CALL(HTTPHeaders_Alloc()); /*because responseHeadearsHandle: a new instance of HTTP headers*/
-    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
 
-    STRICT_EXPECTED_CALL(BUFFER_new());
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(http_engine_set_max_connections(TEST_HTTP_ENGINE_HANDLE, 4));
 
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument(1); /*because relativePath is a STRING_HANDLE*/
-    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
-        IGNORED_PTR_ARG,                                    /*HTTPAPIEX_HANDLE handle,                                     */
-        HTTPAPI_REQUEST_GET,                                /*HTTPAPI_REQUEST_TYPE requestType,                            */
-        "/devices/" TEST_DEVICE_ID MESSAGE_ENDPOINT_HTTP API_VERSION,    /*const char* relativePath,                                    */
-        IGNORED_PTR_ARG,                                    /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,                */
-        NULL,                                               /*BUFFER_HANDLE requestContent,                                */
-        IGNORED_PTR_ARG,                                    /*unsigned int* statusCode,                                    */
-        IGNORED_PTR_ARG,                                    /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,               */
-        IGNORED_PTR_ARG                                     /*BUFFER_HANDLE responseContent))                              */
-        ))
-        .IgnoreArgument_requestType()
-        .CopyOutArgumentBuffer(7, &statusCode200, sizeof(statusCode200));
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
 
-    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(IGNORED_PTR_ARG, "ETag"))
-        .IgnoreArgument(1)
-        .SetReturn(TEST_ETAG_VALUE);
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    STRICT_EXPECTED_CALL(IoTHubMessage_CreateFromByteArray(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
-    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeaderCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
 
-    /*this is "abandon"*/
-    STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    currentDisposition = IOTHUBMESSAGE_ABANDONED;
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_MessageCallback(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
+//Tests_SRS_TRANSPORTMULTITHTTP_09_023: [ The pool size shall be set by calling `http_engine_set_max_connections`; if that fails (e.g. requests are in flight) IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_ERROR and keep the previous size. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_http_connection_pool_size_fails_when_http_engine_set_max_connections_fails)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(http_engine_set_max_connections(TEST_HTTP_ENGINE_HANDLE, 4))
+        .SetReturn(__LINE__);
 
-    STRICT_EXPECTED_CALL(STRING_construct_n(TEST_ETAG_VALUE_UNQUOTED, sizeof(TEST_ETAG_VALUE_UNQUOTED) - 1))
-        .ValidateArgumentBuffer(1, TEST_ETAG_VALUE_UNQUOTED, sizeof(TEST_ETAG_VALUE_UNQUOTED) - 1);
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2);
-    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/abandon" API_VERSION))
-        .IgnoreArgument(1);
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
 
-    STRICT_EXPECTED_CALL(HTTPHeaders_Alloc());
-    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetOption(IGNORED_PTR_ARG, OPTION_PRODUCT_INFO, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "User-Agent", TEST_STRING_DATA))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "Authorization", TEST_BLANK_SAS_TOKEN))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "If-Match", TEST_ETAG_VALUE))
-        .IgnoreArgument(1);
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument(1); /*because abandon relativePath is a STRING_HANDLE*/
-    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-        IGNORED_PTR_ARG,
-        IGNORED_PTR_ARG,                                    /*HTTPAPIEX_HANDLE handle,                                     */
-        HTTPAPI_REQUEST_POST,                               /*HTTPAPI_REQUEST_TYPE requestType,                            */
-        "/devices/" TEST_DEVICE_ID MESSAGE_ENDPOINT_HTTP_ETAG TEST_ETAG_VALUE_UNQUOTED "/abandon" API_VERSION,    /*const char* relativePath,                                    */
-        IGNORED_PTR_ARG,                                    /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,                */
-        NULL,                                               /*BUFFER_HANDLE requestContent,                                */
-        IGNORED_PTR_ARG,                                    /*unsigned int* statusCode,                                    */
-        NULL,                                               /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,               */
-        NULL                                                /*BUFFER_HANDLE responseContent))                              */
-        ))
-        .IgnoreArgument_requestType()
-        .CopyOutArgumentBuffer(7, &statusCode204, sizeof(statusCode204));
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
 
-    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+//Tests_SRS_TRANSPORTMULTITHTTP_09_008: [ If creating the HTTP engine fails, `IoTHubTransportHttp_Create` shall continue without a connection pool. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_022: [ If the transport has no HTTP engine, setting "http_connection_pool_size" shall fail and return IOTHUB_CLIENT_ERROR. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_http_connection_pool_size_fails_when_the_HTTP_engine_was_not_created)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    STRICT_EXPECTED_CALL(http_engine_create(IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
 
     //act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
 
     //assert
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     //cleanup
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_090: [ All the HTTP headers of the form iothub-app-name:somecontent shall be transformed in message properties {name, somecontent}. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_happy_path_with_empty_waitingToSend_and_1_service_message_with_1_property_succeeds)
+//Tests_SRS_TRANSPORTMULTITHTTP_09_007: [ `IoTHubTransportHttp_Create` shall create an HTTP engine for the hostname by calling `http_engine_create`; the engine has no connections until `OPTION_HTTP_CONNECTION_POOL_SIZE` is set. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_010: [ `IoTHubTransportHttp_CreateWithIoTransport` shall create the transport like `IoTHubTransportHttp_Create`, with the connections of the pool created by `get_io_transport`. ]
+TEST_FUNCTION(IoTHubTransportHttp_CreateWithIoTransport_happy_path)
 {
     //arrange
-     
-    unsigned int statusCode200 = 200;
-    unsigned int statusCode204 = 204;
-    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    setupCreateHappyPath(false);
 
-    (void)IoTHubTransportHttp_Subscribe(devHandle);
-    size_t nHeaders = 1;
-    umock_c_reset_all_calls();
+    //act
+    TRANSPORT_LL_HANDLE result = IoTHubTransportHttp_CreateWithIoTransport(&TEST_CONFIG, test_get_io_transport);
+
+    //assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(last_http_engine_get_io_transport == test_get_io_transport);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(result);
+}
 
+static void setupDoWorkPooledEventRequest(bool is_x509_used, bool creates_sas_token)
+{
     setupDoWorkLoopOnceForOneDevice();
 
-    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend)); /*because DoWork for event*/
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
 
-    STRICT_EXPECTED_CALL(get_time(NULL));
-    STRICT_EXPECTED_CALL(HTTPHeaders_Alloc()); /*because responseHeadearsHandle: a new instance of HTTP headers*/
-    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_1));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_Clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE_1));
+    STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
+    EXPECTED_CALL(IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
+    EXPECTED_CALL(IoTHubMessage_GetContentTypeSystemProperty(IGNORED_PTR_ARG)).SetReturn(NULL);
+    EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(IGNORED_PTR_ARG)).SetReturn(NULL);
 
-    STRICT_EXPECTED_CALL(BUFFER_new());
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    if (is_x509_used == false)
+    {
+        STRICT_EXPECTED_CALL(get_time(NULL));
+        STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG));
+        if (creates_sas_token == true)
+        {
+            STRICT_EXPECTED_CALL(URL_Encode(IGNORED_PTR_ARG));
+            STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG));
+            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/devices/"));
+            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+            STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+            STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+            STRICT_EXPECTED_CALL(SASToken_CreateString(TEST_DEVICE_KEY, IGNORED_PTR_ARG, "", 3600));
+        }
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Authorization", TEST_POOL_SAS_TOKEN));
+    }
 
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument(1); /*because relativePath is a STRING_HANDLE*/
-    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
-        IGNORED_PTR_ARG,
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); /*because relativePath*/
+    STRICT_EXPECTED_CALL(http_engine_execute_request_async(TEST_HTTP_ENGINE_HANDLE, HTTPAPI_REQUEST_POST, "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)));
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG));
+
+    STRICT_EXPECTED_CALL(http_engine_dowork(TEST_HTTP_ENGINE_HANDLE));
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_011: [ If `OPTION_HTTP_CONNECTION_POOL_SIZE` is not 0, the batched payload or the single message shall be sent with `http_engine_execute_request_async` instead of HTTPAPIEX, with the same relative path, headers and content. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_012: [ The "Authorization" header of a pooled event request shall be the device SAS token if one exists; for a device key, a SAS token for hostname + "/devices/" + URL_ENCODED(deviceId) created with `SASToken_CreateString`, valid for 1 hour and reused until less than 10 minutes are left; for x509 no header is set. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_013: [ The request shall be queued with `http_engine_execute_request_async` and the device marked as having an event request in flight; if that fails the items shall be put back in waitingToSend. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_019: [ If `OPTION_HTTP_CONNECTION_POOL_SIZE` is not 0, IoTHubTransportHttp_DoWork shall call `http_engine_dowork` after looping through the devices. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_connection_pool_with_1_event_item_unbatched_queues_the_request)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    umock_c_reset_all_calls();
+
+    setupDoWorkPooledEventRequest(false, true);
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_IS_NOT_NULL(last_on_http_engine_response);
+    ASSERT_IS_TRUE(real_DList_IsListEmpty(&waitingToSend));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_012: [ The "Authorization" header of a pooled event request shall be the device SAS token if one exists; for a device key, a SAS token for hostname + "/devices/" + URL_ENCODED(deviceId) created with `SASToken_CreateString`, valid for 1 hour and reused until less than 10 minutes are left; for x509 no header is set. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_connection_pool_and_x509_does_not_set_Authorization)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    IOTHUB_DEVICE_CONFIG myDevice;
+    myDevice.deviceId = TEST_DEVICE_ID;
+    myDevice.deviceKey = NULL;
+    myDevice.deviceSasToken = NULL;
+
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &myDevice, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    umock_c_reset_all_calls();
+
+    setupDoWorkPooledEventRequest(true, false);
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_034: [ Once `HTTPAPIEX_SetOption` accepted `OPTION_HTTP_PROXY` with a non-NULL `host_address`, events shall be sent with HTTPAPIEX whatever the value of `OPTION_HTTP_CONNECTION_POOL_SIZE`. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_connection_pool_and_proxy_sends_the_event_with_HTTPAPIEX)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    HTTP_PROXY_OPTIONS proxyOptions;
+    proxyOptions.host_address = "proxy.contoso.com";
+    proxyOptions.port = 8888;
+    proxyOptions.username = NULL;
+    proxyOptions.password = NULL;
+
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_PROXY, &proxyOptions));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_IS_NULL(last_on_http_engine_response);
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_013: [ The request shall be queued with `http_engine_execute_request_async` and the device marked as having an event request in flight; if that fails the items shall be put back in waitingToSend. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_connection_pool_keeps_the_item_when_http_engine_execute_request_async_fails)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(http_engine_execute_request_async(IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(__LINE__);
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_IS_FALSE(real_DList_IsListEmpty(&waitingToSend));
+    ASSERT_IS_TRUE(waitingToSend.Flink == &(message1.entry));
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_014: [ When the response to a pooled event request has an http status code <300, IoTHubClient_LL_SendComplete shall be called with the items of the request and IOTHUB_CLIENT_CONFIRMATION_OK. ]
+TEST_FUNCTION(IoTHubTransportHttp_connection_pool_response_with_204_calls_IoTHubClient_LL_SendComplete)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK));
+
+    //act
+    last_on_http_engine_response(last_on_http_engine_response_context, HTTP_ENGINE_OK, 204, NULL, NULL, 0);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_015: [ If a pooled event request fails, times out, is cancelled or gets an http status code >=300, its items shall be put back in waitingToSend to be retried. ]
+TEST_FUNCTION(IoTHubTransportHttp_connection_pool_response_with_500_puts_the_items_back_in_waitingToSend)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(DList_AppendTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG));
+
+    //act
+    last_on_http_engine_response(last_on_http_engine_response_context, HTTP_ENGINE_OK, 500, NULL, NULL, 0);
+
+    //assert
+    ASSERT_IS_TRUE(waitingToSend.Flink == &(message1.entry));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_012: [ The "Authorization" header of a pooled event request shall be the device SAS token if one exists; for a device key, a SAS token for hostname + "/devices/" + URL_ENCODED(deviceId) created with `SASToken_CreateString`, valid for 1 hour and reused until less than 10 minutes are left; for x509 no header is set. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_015: [ If a pooled event request fails, times out, is cancelled or gets an http status code >=300, its items shall be put back in waitingToSend to be retried. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_connection_pool_retries_a_cancelled_request_with_the_same_SAS_token)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    last_on_http_engine_response(last_on_http_engine_response_context, HTTP_ENGINE_CANCELLED, 0, NULL, NULL, 0);
+    umock_c_reset_all_calls();
+
+    setupDoWorkPooledEventRequest(false, false);
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_018: [ While an event request of the device is in flight on the connection pool, IoTHubTransportHttp_DoWork shall not send another one for that device. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_connection_pool_does_not_send_while_a_request_is_in_flight)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
+    umock_c_reset_all_calls();
+
+    setupDoWorkLoopOnceForOneDevice();
+    STRICT_EXPECTED_CALL(http_engine_dowork(TEST_HTTP_ENGINE_HANDLE));
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_IS_TRUE(waitingToSend.Flink == &(message2.entry));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_020: [ IoTHubTransportHttp_GetSendStatus shall also return IOTHUB_CLIENT_SEND_STATUS_BUSY while an event request of the device is in flight on the connection pool. ]
+TEST_FUNCTION(IoTHubTransportHttp_GetSendStatus_with_event_request_in_flight_returns_BUSY)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    IOTHUB_CLIENT_STATUS status;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, devHandle));
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_GetSendStatus(devHandle, &status);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_SEND_STATUS_BUSY, (int)status);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_016: [ If an event request of the device is in flight on the connection pool, IoTHubTransportHttp_Unregister shall cancel it by calling `http_engine_cancel_requests` before freeing the device; its items are put back in waitingToSend. ]
+TEST_FUNCTION(IoTHubTransportHttp_Unregister_with_event_request_in_flight_cancels_it)
+{
+    //arrange
+    size_t connectionPoolSize = 4;
+    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_HTTP_CONNECTION_POOL_SIZE, &connectionPoolSize);
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, devHandle));
+    STRICT_EXPECTED_CALL(http_engine_cancel_requests(TEST_HTTP_ENGINE_HANDLE, devHandle));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    setupUnregisterOneDevice();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*pool SAS token scope*/
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); /*pool SAS token*/
+    STRICT_EXPECTED_CALL(VECTOR_erase(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1));
+    STRICT_EXPECTED_CALL(gballoc_free(devHandle));
+
+    //act
+    IoTHubTransportHttp_Unregister(devHandle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_025: ["c2d_adaptive_polling_min_interval_ms"] 
+//Tests_SRS_TRANSPORTMULTITHTTP_09_032: [ Setting a non-zero "c2d_adaptive_polling_min_interval_ms" shall create the tick counter used for polling with `tickcounter_create` if it does not exist yet; if that fails IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_ERROR. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_c2d_adaptive_polling_min_interval_ms_succeeds)
+{
+    //arrange
+    unsigned int minIntervalMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    //act
+    IOTHUB_CLIENT_RESULT result1 = IoTHubTransportHttp_SetOption(handle, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &minIntervalMs);
+    IOTHUB_CLIENT_RESULT result2 = IoTHubTransportHttp_SetOption(handle, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &minIntervalMs);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result1);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_032: [ Setting a non-zero "c2d_adaptive_polling_min_interval_ms" shall create the tick counter used for polling with `tickcounter_create` if it does not exist yet; if that fails IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_ERROR. ]
+TEST_FUNCTION(IoTHubTransportHttp_SetOption_c2d_adaptive_polling_min_interval_ms_fails_when_tickcounter_create_fails)
+{
+    //arrange
+    unsigned int minIntervalMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransportHttp_SetOption(handle, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &minIntervalMs);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_033: [ IoTHubTransportHttp_Destroy shall destroy the tick counter used for adaptive polling, if any, with `tickcounter_destroy`. ]
+TEST_FUNCTION(IoTHubTransportHttp_Destroy_with_adaptive_polling_destroys_the_tick_counter)
+{
+    //arrange
+    unsigned int minIntervalMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &minIntervalMs);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    //act
+    IoTHubTransportHttp_Destroy(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_026: [ With adaptive polling, a GET shall only be issued once the current time given by `tickcounter_get_current_ms` reaches the time scheduled for the device. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_09_028: [ With adaptive polling, the first GET of a subscribed device shall be scheduled at a per-device pseudo-random offset smaller than the minimum adaptive polling interval. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_staggers_the_first_GET)
+{
+    //arrange
+    unsigned int minIntervalMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &minIntervalMs);
+    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+    (void)IoTHubTransportHttp_Subscribe(devHandle);
+    umock_c_reset_all_calls();
+
+    setupDoWorkLoopOnceForOneDevice();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend)); /*because DoWork for event*/
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); /*seeds the schedule of the device; the offset of TEST_DEVICE_1 is not 0*/
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS, 204));
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_027: [ With adaptive polling, if `tickcounter_get_current_ms` fails no GET shall be issued. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_does_not_poll_when_tickcounter_get_current_ms_fails)
+{
+    //arrange
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    test_tickcounter_get_current_ms_result = __LINE__;
+
+    //act
+    bool hasPolled = doWorkPollsAt(handle, TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS, 204);
+
+    //assert
+    ASSERT_IS_FALSE(hasPolled);
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_030: [ With adaptive polling, after a GET that received no message, or failed, the polling interval shall be the minimum adaptive polling interval the first time and double every following time, up to GetMinimumPollingTime; the next GET shall be scheduled after that interval, moved by up to a quarter of it. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_backs_off_while_no_message_is_received)
+{
+    //arrange
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    tickcounter_ms_t lastPollMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    tickcounter_ms_t intervalMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, lastPollMs, 204));
+
+    //act
+    //assert
+    for (size_t i = 0; i < 4; i++)
+    {
+        ASSERT_IS_FALSE(doWorkPollsAt(handle, lastPollMs + intervalMs - (intervalMs / 4) - 1, 204));
+        ASSERT_IS_TRUE(doWorkPollsAt(handle, lastPollMs + intervalMs + (intervalMs / 4), 204));
+        lastPollMs += intervalMs + (intervalMs / 4);
+        intervalMs *= 2;
+    }
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_030: [ With adaptive polling, after a GET that received no message, or failed, the polling interval shall be the minimum adaptive polling interval the first time and double every following time, up to GetMinimumPollingTime; the next GET shall be scheduled after that interval, moved by up to a quarter of it. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_backs_off_up_to_MinimumPollingTime)
+{
+    //arrange
+    unsigned int minimumPollingTime = 3;
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    (void)IoTHubTransportHttp_SetOption(handle, OPTION_MIN_POLLING_TIME, &minimumPollingTime);
+    tickcounter_ms_t lastPollMs = TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS;
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, lastPollMs, 204));
+
+    //act
+    //assert
+    for (size_t i = 0; i < 4; i++)
+    {
+        /*1, 2, then 3 seconds (MinimumPollingTime) between 2 GETs*/
+        tickcounter_ms_t intervalMs = (i < 2) ? (TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS << i) : minimumPollingTime * 1000;
+        ASSERT_IS_TRUE(doWorkPollsAt(handle, lastPollMs + intervalMs + (intervalMs / 4), 204));
+        lastPollMs += intervalMs + (intervalMs / 4);
+    }
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_029: [ With adaptive polling, after a GET that received a message the next GET shall be allowed on the next call to _DoWork and the polling interval shall restart from the minimum. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_polls_again_right_after_a_message)
+{
+    //arrange
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 1000, 204));
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 2250, 204));
+    ASSERT_IS_FALSE(doWorkPollsAt(handle, 3749, 204)); /*the interval is now 2 seconds*/
+
+    //act
+    //assert
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 4750, 200)); /*the message has no ETag, so it is ignored*/
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 4750, 204));
+    ASSERT_IS_FALSE(doWorkPollsAt(handle, 4750 + 749, 204));
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 4750 + 1250, 204));
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_030: [ With adaptive polling, after a GET that received no message, or failed, the polling interval shall be the minimum adaptive polling interval the first time and double every following time, up to GetMinimumPollingTime; the next GET shall be scheduled after that interval, moved by up to a quarter of it. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_backs_off_after_a_failed_GET)
+{
+    //arrange
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 1000, 500));
+
+    //act
+    bool hasPolledEarly = doWorkPollsAt(handle, 1749, 204);
+    bool hasPolledLater = doWorkPollsAt(handle, 2250, 204);
+
+    //assert
+    ASSERT_IS_FALSE(hasPolledEarly);
+    ASSERT_IS_TRUE(hasPolledLater);
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_083: [ If device is not subscribed then _DoWork shall advance to the next action. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_adaptive_polling_and_unsubscribed_device_does_not_read_the_time)
+{
+    //arrange
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    IoTHubTransportHttp_Unsubscribe(devHandle);
+    umock_c_reset_all_calls();
+
+    setupDoWorkLoopOnceForOneDevice();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend)); /*because DoWork for event*/
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_09_031: [ With adaptive polling, IoTHubTransportHttp_Subscribe shall restart the poll schedule of the device. ]
+TEST_FUNCTION(IoTHubTransportHttp_Subscribe_with_adaptive_polling_restarts_the_poll_schedule)
+{
+    //arrange
+    IOTHUB_DEVICE_HANDLE devHandle;
+    TRANSPORT_LL_HANDLE handle = createTransportWithAdaptivePolling(&devHandle);
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 1000, 204));
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 2250, 204));
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 4750, 204)); /*the interval is now 4 seconds*/
+    IoTHubTransportHttp_Unsubscribe(devHandle);
+
+    //act
+    int result = IoTHubTransportHttp_Subscribe(devHandle);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(doWorkPollsAt(handle, 4750, 204));
+    ASSERT_IS_TRUE(doWorkPollsAt(handle, 4750 + TEST_ADAPTIVE_POLLING_MIN_INTERVAL_MS, 204));
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_096: [ If IoTHubClient_LL_MessageCallback returns IOTHUBMESSAGE_ABANDONED then _DoWork shall "abandon" the message. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_happy_path_with_empty_waitingToSend_and_1_service_message_with_abandon_succeeds)
+{
+    //arrange
+     
+    unsigned int statusCode200 = 200;
+    unsigned int statusCode204 = 204;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+
+    (void)IoTHubTransportHttp_Subscribe(devHandle);
+    umock_c_reset_all_calls();
+    setupDoWorkLoopOnceForOneDevice();
+
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend)); /*because DoWork for event*/
+
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(HTTPHeaders_Alloc()); /*because responseHeadearsHandle: a new instance of HTTP headers*/
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1); /*because relativePath is a STRING_HANDLE*/
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,                                    /*HTTPAPIEX_HANDLE handle,                                     */
+        HTTPAPI_REQUEST_GET,                                /*HTTPAPI_REQUEST_TYPE requestType,                            */
+        "/devices/" TEST_DEVICE_ID MESSAGE_ENDPOINT_HTTP API_VERSION,    /*const char* relativePath,                                    */
+        IGNORED_PTR_ARG,                                    /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,                */
+        NULL,                                               /*BUFFER_HANDLE requestContent,                                */
+        IGNORED_PTR_ARG,                                    /*unsigned int* statusCode,                                    */
+        IGNORED_PTR_ARG,                                    /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,               */
+        IGNORED_PTR_ARG                                     /*BUFFER_HANDLE responseContent))                              */
+        ))
+        .IgnoreArgument_requestType()
+        .CopyOutArgumentBuffer(7, &statusCode200, sizeof(statusCode200));
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(IGNORED_PTR_ARG, "ETag"))
+        .IgnoreArgument(1)
+        .SetReturn(TEST_ETAG_VALUE);
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_CreateFromByteArray(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeaderCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    /*this is "abandon"*/
+    STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    currentDisposition = IOTHUBMESSAGE_ABANDONED;
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_MessageCallback(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(STRING_construct_n(TEST_ETAG_VALUE_UNQUOTED, sizeof(TEST_ETAG_VALUE_UNQUOTED) - 1))
+        .ValidateArgumentBuffer(1, TEST_ETAG_VALUE_UNQUOTED, sizeof(TEST_ETAG_VALUE_UNQUOTED) - 1);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "/abandon" API_VERSION))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_Alloc());
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetOption(IGNORED_PTR_ARG, OPTION_PRODUCT_INFO, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "User-Agent", TEST_STRING_DATA))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "Authorization", TEST_BLANK_SAS_TOKEN))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "If-Match", TEST_ETAG_VALUE))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1); /*because abandon relativePath is a STRING_HANDLE*/
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
+        IGNORED_PTR_ARG,
+        IGNORED_PTR_ARG,                                    /*HTTPAPIEX_HANDLE handle,                                     */
+        HTTPAPI_REQUEST_POST,                               /*HTTPAPI_REQUEST_TYPE requestType,                            */
+        "/devices/" TEST_DEVICE_ID MESSAGE_ENDPOINT_HTTP_ETAG TEST_ETAG_VALUE_UNQUOTED "/abandon" API_VERSION,    /*const char* relativePath,                                    */
+        IGNORED_PTR_ARG,                                    /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,                */
+        NULL,                                               /*BUFFER_HANDLE requestContent,                                */
+        IGNORED_PTR_ARG,                                    /*unsigned int* statusCode,                                    */
+        NULL,                                               /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,               */
+        NULL                                                /*BUFFER_HANDLE responseContent))                              */
+        ))
+        .IgnoreArgument_requestType()
+        .CopyOutArgumentBuffer(7, &statusCode204, sizeof(statusCode204));
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
+//Tests_SRS_TRANSPORTMULTITHTTP_17_090: [ All the HTTP headers of the form iothub-app-name:somecontent shall be transformed in message properties {name, somecontent}. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_happy_path_with_empty_waitingToSend_and_1_service_message_with_1_property_succeeds)
+{
+    //arrange
+     
+    unsigned int statusCode200 = 200;
+    unsigned int statusCode204 = 204;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    IOTHUB_DEVICE_HANDLE devHandle = IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+
+    (void)IoTHubTransportHttp_Subscribe(devHandle);
+    size_t nHeaders = 1;
+    umock_c_reset_all_calls();
+
+    setupDoWorkLoopOnceForOneDevice();
+
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(&waitingToSend)); /*because DoWork for event*/
+
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(HTTPHeaders_Alloc()); /*because responseHeadearsHandle: a new instance of HTTP headers*/
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1); /*because relativePath is a STRING_HANDLE*/
+    STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(
+        IGNORED_PTR_ARG,
         IGNORED_PTR_ARG,                                    /*HTTPAPIEX_HANDLE handle,                                     */
         HTTPAPI_REQUEST_GET,                                /*HTTPAPI_REQUEST_TYPE requestType,                            */
         "/devices/" TEST_DEVICE_ID MESSAGE_ENDPOINT_HTTP API_VERSION,    /*const char* relativePath,                                    */
@@ -14316,6 +15162,51 @@ TEST_FUNCTION(IoTHubTransportHttp_GetHostname_with_non_NULL_handle_succeeds)
     IoTHubTransportHttp_Destroy(handle);
 }
 
+/*Tests_SRS_TRANSPORTMULTITHTTP_09_035: [ If handle or statistics are NULL, IoTHubTransportHttp_GetStatistics shall return without changes. ]*/
+TEST_FUNCTION(IoTHubTransportHttp_GetStatistics_with_NULL_handle_returns)
+{
+    //arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    memset(&statistics, 0, sizeof(statistics));
+    umock_c_reset_all_calls();
+
+    //act
+    IoTHubTransportHttp_GetStatistics(NULL, &statistics);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.tls_session_cache_hits);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.tls_session_cache_misses);
+}
+
+/*Tests_SRS_TRANSPORTMULTITHTTP_09_036: [ If the transport has a TLS session cache, IoTHubTransportHttp_GetStatistics shall set statistics->tls_session_cache_hits and statistics->tls_session_cache_misses from tls_session_cache_get_statistics; otherwise it shall leave them unchanged. ]*/
+TEST_FUNCTION(IoTHubTransportHttp_GetStatistics_sets_tls_session_cache_statistics)
+{
+    //arrange
+    IOTHUB_CLIENT_STATISTICS statistics;
+    TLS_SESSION_CACHE_STATISTICS tlsSessionCacheStatistics;
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    memset(&statistics, 0, sizeof(statistics));
+    tlsSessionCacheStatistics.hits = 6;
+    tlsSessionCacheStatistics.misses = 2;
+    tlsSessionCacheStatistics.sessions_saved = 8;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tls_session_cache_get_statistics(TEST_TLS_SESSION_CACHE_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_statistics(&tlsSessionCacheStatistics, sizeof(TLS_SESSION_CACHE_STATISTICS));
+
+    //act
+    IoTHubTransportHttp_GetStatistics(handle, &statistics);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 6, statistics.tls_session_cache_hits);
+    ASSERT_ARE_EQUAL(uint64_t, 2, statistics.tls_session_cache_misses);
+
+    //cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
+
 /*Tests_SRS_TRANSPORTMULTITHTTP_02_004: [ IoTHubTransportHttp_Unsubscribe_DeviceTwin shall return ]*/
 TEST_FUNCTION(IoTHubTransportHttp_Unsubscribe_DeviceTwin_returns)
 {
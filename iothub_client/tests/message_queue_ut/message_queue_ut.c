@@ -1172,6 +1172,60 @@ TEST_FUNCTION(message_queue_set_max_retry_count_success)
     message_queue_destroy(mq);
 }
 
+// Tests_SRS_MESSAGE_QUEUE_09_071: [If `message_queue` is NULL, message_queue_set_max_free_items shall fail and return non-zero]
+TEST_FUNCTION(message_queue_set_max_free_items_NULL_handle)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    int result = message_queue_set_max_free_items(NULL, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+}
+
+// Tests_SRS_MESSAGE_QUEUE_09_072: [`max_free_items` shall be set on `message_queue->item_slab` using slab_set_max_free_elements(), and message_queue_set_max_free_items shall return 0]
+// Tests_SRS_MESSAGE_QUEUE_09_073: [`mq_item` shall be obtained from `message_queue->item_slab` using slab_alloc()]
+TEST_FUNCTION(message_queue_set_max_free_items_reuses_released_items)
+{
+    // arrange
+    MESSAGE_QUEUE_HANDLE mq = create_message_queue(USE_DEFAULT_CONFIG);
+    add_messages(mq, 1, TEST_current_time);
+    umock_c_reset_all_calls();
+
+    int result = message_queue_set_max_free_items(mq, 1);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // the released item is kept instead of freed
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    message_queue_remove_all(mq);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(TEST_current_time);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = message_queue_add(mq, TEST_BASE_MQ_MESSAGE_HANDLE[0], TEST_on_message_processing_completed_callback, TEST_USER_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    message_queue_destroy(mq);
+}
+
 // Tests_SRS_MESSAGE_QUEUE_09_055: [If `message_queue` is NULL, message_queue_set_max_message_processing_time_secs shall fail and return non-zero]
 TEST_FUNCTION(message_queue_set_max_message_processing_time_secs_NULL_handle)
 {
@@ -0,0 +1,327 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_client_ll.h"
+
+#include "perf_benchmarks.h"
+#include "perf_fake_hub.h"
+#include "perf_loopback_transports.h"
+#include "perf_stats.h"
+
+#define DEFAULT_MESSAGES        10000
+#define DEFAULT_ITERATIONS      1000
+#define DEFAULT_PAYLOAD_SIZE    256
+#define DEFAULT_WINDOW          64
+#define DEFAULT_DOWORK_SLEEP_US 0
+#define DEFAULT_TIMEOUT_SECS    120
+#define DEFAULT_CONNECTION_POOL_SIZE 8
+#define DEFAULT_C2D_ADAPTIVE_POLLING_MS 0
+#define DEFAULT_CALLBACK_THREADS 2
+#define DEFAULT_MESSAGE_POOL_SIZE 64
+// Without adaptive polling HTTP asks for cloud-to-device messages at most once per second (MinimumPollingTime has 1 s resolution).
+#define HTTP_MAX_C2D_ITERATIONS 10
+
+static const PERF_TRANSPORT transports[] =
+{
+#ifdef PERF_USE_MQTT
+    { "mqtt", PerfLoopbackMQTT_Protocol, perf_fake_mqtt_hub_get_interface, true, true, 0, false },
+#endif
+#ifdef PERF_USE_AMQP
+    // The fake AMQP hub has no CBS node, so devices authenticated with a key cannot connect.
+    { "amqp", PerfLoopbackAMQP_Protocol, perf_fake_amqp_hub_get_interface, true, true, 0, false },
+#endif
+#ifdef PERF_USE_HTTP
+    { "http", PerfLoopbackHTTP_Protocol, perf_fake_http_hub_get_interface, false, false, HTTP_MAX_C2D_ITERATIONS, true },
+#endif
+    { NULL, NULL, NULL, false, false, 0, false }
+};
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --transport <mqtt|amqp|http|all>     transport(s) to benchmark (default all)\n"
+        "  --benchmark <name|all>               benchmark(s) to run (default all)\n"
+        "  --messages <n>                       events sent by d2c_throughput (default %d)\n"
+        "  --iterations <n>                     round trips per latency benchmark (default %d)\n"
+        "  --payload-size <bytes>               message/method payload size (default %d)\n"
+        "  --window <n>                         events in flight in d2c_throughput (default %d)\n"
+        "  --dowork-sleep-us <us>               sleep between IoTHubClient_LL_DoWork calls (default %d)\n"
+        "  --timeout-secs <s>                   per-benchmark timeout (default %d)\n"
+        "  --connection-pool-size <n>           connections shared by multiplexed_d2c devices, 0 for none (default %d)\n"
+        "  --c2d-adaptive-polling-ms <ms>       shortest interval between two HTTP C2D polls, 0 for fixed polling (default %d)\n"
+        "  --callback-threads <n>               threads running the callbacks of d2c_with_slow_method, 0 for the worker thread (default %d)\n"
+        "  --message-pool-size <n>              per-message structures kept for reuse by each client, 0 for none (default %d)\n"
+        "  --output <file>                      also append JSON lines results to <file>\n",
+        program_name, DEFAULT_MESSAGES, DEFAULT_ITERATIONS, DEFAULT_PAYLOAD_SIZE, DEFAULT_WINDOW, DEFAULT_DOWORK_SLEEP_US, DEFAULT_TIMEOUT_SECS, DEFAULT_CONNECTION_POOL_SIZE, DEFAULT_C2D_ADAPTIVE_POLLING_MS, DEFAULT_CALLBACK_THREADS, DEFAULT_MESSAGE_POOL_SIZE);
+}
+
+static int parse_count(const char* value, size_t minimum, size_t* count)
+{
+    int result;
+    char* end;
+    unsigned long parsed = strtoul(value, &end, 10);
+
+    if (*value == '\0' || *end != '\0' || parsed < minimum)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        *count = (size_t)parsed;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void write_result(FILE* output, const PERF_TRANSPORT* transport, const char* benchmark_name, const PERF_RESULT* result, PERF_LATENCY_HANDLE latency, const PERF_PROCESS_USAGE* usage_before, const PERF_PROCESS_USAGE* usage_after)
+{
+    PERF_LATENCY_SUMMARY summary;
+    double throughput = result->elapsed_us > 0 ? (double)result->operations * 1000000.0 / (double)result->elapsed_us : 0.0;
+
+    if (perf_latency_get_summary(latency, &summary) != 0)
+    {
+        memset(&summary, 0, sizeof(summary));
+    }
+
+    (void)fprintf(output,
+        "{\"transport\":\"%s\",\"benchmark\":\"%s\",\"status\":\"%s\",\"reason\":%s%s%s,"
+        "\"operations\":%lu,\"elapsed_us\":%llu,\"throughput_per_sec\":%.1f,"
+        "\"latency_us\":{\"count\":%lu,\"min\":%llu,\"mean\":%llu,\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu},"
+        "\"cpu_user_us\":%llu,\"cpu_system_us\":%llu,\"client_thread_cpu_us\":%llu,\"client_thread_allocations\":%llu,\"max_rss_kb\":%llu,\"rss_kb\":%llu}\n",
+        transport->name, benchmark_name,
+        result->status == PERF_RESULT_OK ? "ok" : (result->status == PERF_RESULT_SKIPPED ? "skipped" : "failed"),
+        result->reason != NULL ? "\"" : "", result->reason != NULL ? result->reason : "null", result->reason != NULL ? "\"" : "",
+        (unsigned long)result->operations, (unsigned long long)result->elapsed_us, throughput,
+        (unsigned long)summary.count, (unsigned long long)summary.min_us, (unsigned long long)summary.mean_us,
+        (unsigned long long)summary.p50_us, (unsigned long long)summary.p99_us, (unsigned long long)summary.p999_us, (unsigned long long)summary.max_us,
+        (unsigned long long)(usage_after->user_cpu_us - usage_before->user_cpu_us),
+        (unsigned long long)(usage_after->system_cpu_us - usage_before->system_cpu_us),
+        (unsigned long long)(usage_after->thread_cpu_us - usage_before->thread_cpu_us),
+        (unsigned long long)(usage_after->thread_allocations - usage_before->thread_allocations),
+        (unsigned long long)usage_after->max_rss_kb, (unsigned long long)usage_after->rss_kb);
+    (void)fflush(output);
+}
+
+static int run_benchmark(const PERF_TRANSPORT* transport, const PERF_BENCHMARK* benchmark, const PERF_OPTIONS* options, FILE* output)
+{
+    int result;
+    const PERF_FAKE_HUB_INTERFACE* hub_interface = transport->get_fake_hub_interface();
+    PERF_FAKE_HUB_HANDLE hub;
+    PERF_LATENCY_HANDLE latency;
+
+    if ((latency = perf_latency_create()) == NULL)
+    {
+        LogError("Failed creating latency recorder");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((hub = hub_interface->create()) == NULL)
+        {
+            LogError("Failed starting fake %s hub", transport->name);
+            result = __LINE__;
+        }
+        else
+        {
+            PERF_RESULT benchmark_result;
+            PERF_PROCESS_USAGE usage_before;
+            PERF_PROCESS_USAGE usage_after;
+
+            memset(&benchmark_result, 0, sizeof(benchmark_result));
+            memset(&usage_before, 0, sizeof(usage_before));
+            memset(&usage_after, 0, sizeof(usage_after));
+
+            perf_loopback_set_port(hub_interface->get_port(hub));
+
+            (void)perf_get_process_usage(&usage_before);
+            benchmark->run(transport, hub_interface, hub, options, latency, &benchmark_result);
+            (void)perf_get_process_usage(&usage_after);
+
+            write_result(stdout, transport, benchmark->name, &benchmark_result, latency, &usage_before, &usage_after);
+
+            if (output != NULL)
+            {
+                write_result(output, transport, benchmark->name, &benchmark_result, latency, &usage_before, &usage_after);
+            }
+
+            result = (benchmark_result.status == PERF_RESULT_FAILED) ? __LINE__ : 0;
+
+            hub_interface->destroy(hub);
+        }
+
+        perf_latency_destroy(latency);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result = 0;
+    PERF_OPTIONS options;
+    const char* transport_filter = "all";
+    const char* benchmark_filter = "all";
+    const char* output_path = NULL;
+    size_t value;
+    int i;
+
+    options.messages = DEFAULT_MESSAGES;
+    options.iterations = DEFAULT_ITERATIONS;
+    options.payload_size = DEFAULT_PAYLOAD_SIZE;
+    options.window = DEFAULT_WINDOW;
+    options.dowork_sleep_us = DEFAULT_DOWORK_SLEEP_US;
+    options.timeout_secs = DEFAULT_TIMEOUT_SECS;
+    options.connection_pool_size = DEFAULT_CONNECTION_POOL_SIZE;
+    options.c2d_adaptive_polling_ms = DEFAULT_C2D_ADAPTIVE_POLLING_MS;
+    options.callback_threads = DEFAULT_CALLBACK_THREADS;
+    options.message_pool_size = DEFAULT_MESSAGE_POOL_SIZE;
+
+    for (i = 1; result == 0 && i < argc; i++)
+    {
+        const char* name = argv[i];
+        const char* argument = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (argument == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(name, "--transport") == 0)
+        {
+            transport_filter = argument;
+        }
+        else if (strcmp(name, "--benchmark") == 0)
+        {
+            benchmark_filter = argument;
+        }
+        else if (strcmp(name, "--output") == 0)
+        {
+            output_path = argument;
+        }
+        else if (strcmp(name, "--messages") == 0)
+        {
+            result = parse_count(argument, 1, &options.messages);
+        }
+        else if (strcmp(name, "--iterations") == 0)
+        {
+            result = parse_count(argument, 1, &options.iterations);
+        }
+        else if (strcmp(name, "--payload-size") == 0)
+        {
+            result = parse_count(argument, 0, &options.payload_size);
+        }
+        else if (strcmp(name, "--window") == 0)
+        {
+            result = parse_count(argument, 1, &options.window);
+        }
+        else if (strcmp(name, "--dowork-sleep-us") == 0)
+        {
+            if ((result = parse_count(argument, 0, &value)) == 0)
+            {
+                options.dowork_sleep_us = (unsigned int)value;
+            }
+        }
+        else if (strcmp(name, "--connection-pool-size") == 0)
+        {
+            result = parse_count(argument, 0, &options.connection_pool_size);
+        }
+        else if (strcmp(name, "--c2d-adaptive-polling-ms") == 0)
+        {
+            if ((result = parse_count(argument, 0, &value)) == 0)
+            {
+                options.c2d_adaptive_polling_ms = (unsigned int)value;
+            }
+        }
+        else if (strcmp(name, "--callback-threads") == 0)
+        {
+            result = parse_count(argument, 0, &options.callback_threads);
+        }
+        else if (strcmp(name, "--message-pool-size") == 0)
+        {
+            result = parse_count(argument, 0, &options.message_pool_size);
+        }
+        else if (strcmp(name, "--timeout-secs") == 0)
+        {
+            if ((result = parse_count(argument, 1, &value)) == 0)
+            {
+                options.timeout_secs = (unsigned int)value;
+            }
+        }
+        else
+        {
+            result = __LINE__;
+        }
+
+        i++;
+    }
+
+    if (result != 0)
+    {
+        print_usage(argv[0]);
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        FILE* output = NULL;
+
+        if (output_path != NULL && (output = fopen(output_path, "a")) == NULL)
+        {
+            (void)printf("Cannot open %s\r\n", output_path);
+            result = __LINE__;
+        }
+        else
+        {
+            size_t benchmark_count;
+            const PERF_BENCHMARK* benchmarks = perf_benchmarks_get(&benchmark_count);
+            const PERF_TRANSPORT* transport;
+            size_t runs = 0;
+
+            for (transport = transports; transport->name != NULL; transport++)
+            {
+                size_t j;
+                bool is_transport_selected = (strcmp(transport_filter, "all") == 0 || strcmp(transport_filter, transport->name) == 0);
+
+                for (j = 0; is_transport_selected && j < benchmark_count; j++)
+                {
+                    if (strcmp(benchmark_filter, "all") == 0 || strcmp(benchmark_filter, benchmarks[j].name) == 0)
+                    {
+                        if (run_benchmark(transport, &benchmarks[j], &options, output) != 0)
+                        {
+                            result = __LINE__;
+                        }
+
+                        runs++;
+                    }
+                }
+            }
+
+            if (runs == 0)
+            {
+                (void)printf("No benchmark matches --transport %s --benchmark %s\r\n", transport_filter, benchmark_filter);
+                result = __LINE__;
+            }
+
+            if (output != NULL)
+            {
+                (void)fclose(output);
+            }
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,1492 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "iothub_client.h"
+#include "iothub_client_callback_executor.h"
+#include "iothub_client_ll.h"
+#include "iothub_client_options.h"
+#include "iothub_message.h"
+#include "iothubtransport.h"
+#ifdef PERF_USE_MQTT
+#include "iothubtransport_mqtt_topic.h"
+#endif
+
+#include "perf_benchmarks.h"
+
+DEFINE_ENUM_STRINGS(PERF_RESULT_STATUS, PERF_RESULT_STATUS_VALUES);
+
+// The fake hubs accept any x509 device, which keeps SAS token generation and CBS out of the measurements.
+static const char* CONNECTION_STRING = "HostName=perf-hub.azure-devices.net;DeviceId=perf-device;x509=true";
+static const char* DEVICE_ID = "perf-device";
+static const char* METHOD_NAME = "perf";
+static const char* REPORTED_STATE_FORMAT = "{\"perf\":%lu}";
+// Threads calling IoTHubClient_SendEventAsync concurrently in d2c_enqueue_contention.
+#define ENQUEUE_PRODUCER_THREADS 16
+// Time the method handler of d2c_with_slow_method takes, and the cap on its iterations (one slow method each).
+#define SLOW_METHOD_DURATION_MS 100
+#define SLOW_METHOD_MAX_ITERATIONS 50
+// Devices of the multiplexed_d2c benchmarks share one transport; multiplexed clients cannot use x509, and the
+// fake hubs do not check the SAS tokens made from this key.
+static const char* MULTIPLEXED_HUB_NAME = "perf-hub";
+static const char* MULTIPLEXED_HUB_SUFFIX = "azure-devices.net";
+static const char* MULTIPLEXED_DEVICE_KEY = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+#define MULTIPLEXED_DEVICE_ID_FORMAT "perf-device-%lu"
+
+typedef struct BENCHMARK_CONTEXT_TAG BENCHMARK_CONTEXT;
+
+typedef struct D2C_MESSAGE_CONTEXT_TAG
+{
+    BENCHMARK_CONTEXT* context;
+    uint64_t sent_at_us;
+} D2C_MESSAGE_CONTEXT;
+
+struct BENCHMARK_CONTEXT_TAG
+{
+    const PERF_TRANSPORT* transport;
+    const PERF_FAKE_HUB_INTERFACE* hub_interface;
+    PERF_FAKE_HUB_HANDLE hub;
+    const PERF_OPTIONS* options;
+    PERF_LATENCY_HANDLE latency;
+    IOTHUB_CLIENT_LL_HANDLE client;
+    unsigned char* payload;
+
+    // Updated from the client callbacks, i.e. on the thread calling IoTHubClient_LL_DoWork.
+    size_t events_in_flight;
+    size_t events_confirmed;
+    size_t events_failed;
+    size_t c2d_messages_received;
+    size_t reported_states_completed;
+    size_t reported_states_failed;
+    bool is_connected;
+    size_t connection_losses;
+    uint64_t operation_started_at_us;
+    // Target count the current wait predicate compares against.
+    size_t expected;
+
+    // Method responses are reported on the fake hub thread.
+    LOCK_HANDLE lock;
+    size_t method_responses;
+    size_t method_failures;
+};
+
+static bool has_events_in_flight(BENCHMARK_CONTEXT* context)
+{
+    return context->events_in_flight > 0;
+}
+
+static void do_work_once(BENCHMARK_CONTEXT* context)
+{
+    IoTHubClient_LL_DoWork(context->client);
+
+    if (context->options->dowork_sleep_us > 0)
+    {
+        (void)usleep(context->options->dowork_sleep_us);
+    }
+}
+
+// Pumps the client until `is_pending` returns false; returns 0 unless the benchmark timeout expired first.
+static int do_work_while(BENCHMARK_CONTEXT* context, bool(*is_pending)(BENCHMARK_CONTEXT* context), uint64_t deadline_us)
+{
+    int result = 0;
+
+    while (is_pending(context))
+    {
+        if (perf_get_time_us() > deadline_us)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        do_work_once(context);
+    }
+
+    return result;
+}
+
+static uint64_t get_deadline(BENCHMARK_CONTEXT* context)
+{
+    return perf_get_time_us() + (uint64_t)context->options->timeout_secs * 1000000;
+}
+
+static void on_event_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT confirmation_result, void* user_context)
+{
+    D2C_MESSAGE_CONTEXT* message_context = (D2C_MESSAGE_CONTEXT*)user_context;
+    BENCHMARK_CONTEXT* context = message_context->context;
+
+    context->events_in_flight--;
+
+    if (confirmation_result == IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        context->events_confirmed++;
+
+        if (context->latency != NULL)
+        {
+            (void)perf_latency_add_sample(context->latency, perf_get_time_us() - message_context->sent_at_us);
+        }
+    }
+    else
+    {
+        context->events_failed++;
+    }
+}
+
+static int send_event_on_client(BENCHMARK_CONTEXT* context, IOTHUB_CLIENT_LL_HANDLE client, D2C_MESSAGE_CONTEXT* message_context)
+{
+    int result;
+    IOTHUB_MESSAGE_HANDLE message;
+
+    if ((message = IoTHubMessage_CreateFromByteArray(context->payload, context->options->payload_size)) == NULL)
+    {
+        LogError("Failed creating event message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_context->context = context;
+        message_context->sent_at_us = perf_get_time_us();
+
+        if (IoTHubClient_LL_SendEventAsync(client, message, on_event_confirmation, message_context) != IOTHUB_CLIENT_OK)
+        {
+            LogError("Failed sending event message");
+            result = __FAILURE__;
+        }
+        else
+        {
+            context->events_in_flight++;
+            result = 0;
+        }
+
+        // The client keeps its own copy of the message.
+        IoTHubMessage_Destroy(message);
+    }
+
+    return result;
+}
+
+static int send_event(BENCHMARK_CONTEXT* context, D2C_MESSAGE_CONTEXT* message_context)
+{
+    return send_event_on_client(context, context->client, message_context);
+}
+
+// Sends one event and waits for its confirmation; `latency` is left untouched.
+static int send_event_and_wait(BENCHMARK_CONTEXT* context, uint64_t deadline_us)
+{
+    int result;
+    D2C_MESSAGE_CONTEXT message_context;
+    PERF_LATENCY_HANDLE latency = context->latency;
+    size_t events_confirmed = context->events_confirmed;
+
+    context->latency = NULL;
+
+    if (send_event(context, &message_context) != 0 ||
+        do_work_while(context, has_events_in_flight, deadline_us) != 0 ||
+        context->events_confirmed == events_confirmed)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    context->latency = latency;
+
+    return result;
+}
+
+static void on_connection_status(IOTHUB_CLIENT_CONNECTION_STATUS status, IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason, void* user_context)
+{
+    BENCHMARK_CONTEXT* context = (BENCHMARK_CONTEXT*)user_context;
+    (void)reason;
+
+    if (status == IOTHUB_CLIENT_CONNECTION_AUTHENTICATED)
+    {
+        context->is_connected = true;
+    }
+    else
+    {
+        if (context->is_connected)
+        {
+            context->connection_losses++;
+        }
+
+        context->is_connected = false;
+    }
+}
+
+static void destroy_benchmark_context(BENCHMARK_CONTEXT* context)
+{
+    if (context->client != NULL)
+    {
+        IoTHubClient_LL_Destroy(context->client);
+        context->client = NULL;
+    }
+
+    if (context->lock != NULL)
+    {
+        (void)Lock_Deinit(context->lock);
+        context->lock = NULL;
+    }
+
+    free(context->payload);
+    context->payload = NULL;
+}
+
+// Creates a client that retries immediately, so reconnects are bounded by the SDK rather than by the retry policy.
+static int create_benchmark_context(BENCHMARK_CONTEXT* context, const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency)
+{
+    int result;
+    size_t payload_allocation_size = options->payload_size > 0 ? options->payload_size : 1;
+
+    memset(context, 0, sizeof(BENCHMARK_CONTEXT));
+    context->transport = transport;
+    context->hub_interface = hub_interface;
+    context->hub = hub;
+    context->options = options;
+    context->latency = latency;
+
+    if ((context->payload = (unsigned char*)malloc(payload_allocation_size)) == NULL ||
+        (context->lock = Lock_Init()) == NULL)
+    {
+        LogError("Failed allocating benchmark context");
+        result = __FAILURE__;
+    }
+    else if ((context->client = IoTHubClient_LL_CreateFromConnectionString(CONNECTION_STRING, transport->protocol)) == NULL)
+    {
+        LogError("Failed creating %s client", transport->name);
+        result = __FAILURE__;
+    }
+    else if (IoTHubClient_LL_SetConnectionStatusCallback(context->client, on_connection_status, context) != IOTHUB_CLIENT_OK ||
+        IoTHubClient_LL_SetRetryPolicy(context->client, IOTHUB_CLIENT_RETRY_IMMEDIATE, 0) != IOTHUB_CLIENT_OK)
+    {
+        LogError("Failed configuring %s client", transport->name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        memset(context->payload, 'x', payload_allocation_size);
+
+        if (transport->max_c2d_iterations > 0)
+        {
+            // Let the polling transport ask for cloud-to-device messages as often as it is able to.
+            unsigned int minimum_polling_time = 0;
+            (void)IoTHubClient_LL_SetOption(context->client, "MinimumPollingTime", &minimum_polling_time);
+
+            if (options->c2d_adaptive_polling_ms > 0)
+            {
+                (void)IoTHubClient_LL_SetOption(context->client, OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS, &options->c2d_adaptive_polling_ms);
+            }
+        }
+
+        if (options->message_pool_size > 0)
+        {
+            (void)IoTHubClient_LL_SetOption(context->client, OPTION_MESSAGE_POOL_SIZE, &options->message_pool_size);
+        }
+
+        result = 0;
+    }
+
+    if (result != 0)
+    {
+        destroy_benchmark_context(context);
+    }
+
+    return result;
+}
+
+// Confirms one event before measuring, so connection setup is never part of a measurement.
+static int warm_up(BENCHMARK_CONTEXT* context, PERF_RESULT* result)
+{
+    int warm_up_result;
+
+    if (send_event_and_wait(context, get_deadline(context)) != 0)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "warm-up event was not confirmed";
+        warm_up_result = __FAILURE__;
+    }
+    else
+    {
+        warm_up_result = 0;
+    }
+
+    return warm_up_result;
+}
+
+static void set_timed_out(PERF_RESULT* result)
+{
+    result->status = PERF_RESULT_FAILED;
+    result->reason = "timed out";
+}
+
+static bool is_d2c_window_pending(BENCHMARK_CONTEXT* context)
+{
+    return context->events_in_flight >= context->options->window;
+}
+
+static void run_d2c_throughput(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    BENCHMARK_CONTEXT context;
+    D2C_MESSAGE_CONTEXT* message_contexts;
+
+    if ((message_contexts = (D2C_MESSAGE_CONTEXT*)malloc(options->messages * sizeof(D2C_MESSAGE_CONTEXT))) == NULL)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "out of memory";
+    }
+    else
+    {
+        if (create_benchmark_context(&context, transport, hub_interface, hub, options, latency) != 0)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "client creation failed";
+        }
+        else
+        {
+            if (warm_up(&context, result) == 0)
+            {
+                uint64_t deadline_us = get_deadline(&context);
+                uint64_t start_us = perf_get_time_us();
+                size_t events_confirmed = context.events_confirmed;
+                size_t sent = 0;
+
+                while (result->status == PERF_RESULT_OK && sent < options->messages)
+                {
+                    if (send_event(&context, &message_contexts[sent]) != 0)
+                    {
+                        result->status = PERF_RESULT_FAILED;
+                        result->reason = "IoTHubClient_LL_SendEventAsync failed";
+                    }
+                    else
+                    {
+                        sent++;
+
+                        // Keep the window full: only pump the client once it has `window` events in flight.
+                        if (do_work_while(&context, is_d2c_window_pending, deadline_us) != 0)
+                        {
+                            set_timed_out(result);
+                        }
+                    }
+                }
+
+                if (result->status == PERF_RESULT_OK && do_work_while(&context, has_events_in_flight, deadline_us) != 0)
+                {
+                    set_timed_out(result);
+                }
+
+                result->elapsed_us = perf_get_time_us() - start_us;
+                result->operations = context.events_confirmed - events_confirmed;
+
+                if (result->status == PERF_RESULT_OK && context.events_failed > 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "some events were not confirmed";
+                }
+            }
+
+            destroy_benchmark_context(&context);
+        }
+
+        free(message_contexts);
+    }
+}
+
+static IOTHUBMESSAGE_DISPOSITION_RESULT on_c2d_message(IOTHUB_MESSAGE_HANDLE message, void* user_context)
+{
+    BENCHMARK_CONTEXT* context = (BENCHMARK_CONTEXT*)user_context;
+    const unsigned char* buffer;
+    size_t size;
+    uint64_t received_at_us = perf_get_time_us();
+
+    // The fake hub stamps each payload with the time it was queued, as a decimal string.
+    if (IoTHubMessage_GetByteArray(message, &buffer, &size) == IOTHUB_MESSAGE_OK && size > 0)
+    {
+        char timestamp[32];
+        size_t timestamp_length = size < sizeof(timestamp) - 1 ? size : sizeof(timestamp) - 1;
+        uint64_t sent_at_us;
+
+        (void)memcpy(timestamp, buffer, timestamp_length);
+        timestamp[timestamp_length] = '\0';
+        sent_at_us = (uint64_t)strtoull(timestamp, NULL, 10);
+
+        if (sent_at_us > 0 && sent_at_us <= received_at_us)
+        {
+            (void)perf_latency_add_sample(context->latency, received_at_us - sent_at_us);
+        }
+    }
+
+    context->c2d_messages_received++;
+
+    return IOTHUBMESSAGE_ACCEPTED;
+}
+
+static bool is_c2d_message_pending(BENCHMARK_CONTEXT* context)
+{
+    return context->c2d_messages_received < context->expected;
+}
+
+static void run_c2d_latency(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    BENCHMARK_CONTEXT context;
+
+    if (create_benchmark_context(&context, transport, hub_interface, hub, options, latency) != 0)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "client creation failed";
+    }
+    else
+    {
+        if (IoTHubClient_LL_SetMessageCallback(context.client, on_c2d_message, &context) != IOTHUB_CLIENT_OK)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "IoTHubClient_LL_SetMessageCallback failed";
+        }
+        else if (warm_up(&context, result) == 0)
+        {
+            size_t iterations = options->iterations;
+            uint64_t deadline_us = get_deadline(&context);
+            uint64_t start_us = perf_get_time_us();
+            size_t payload_size = options->payload_size > 32 ? options->payload_size : 32;
+            unsigned char* payload = (unsigned char*)malloc(payload_size);
+            size_t i;
+
+            if (transport->max_c2d_iterations > 0 && options->c2d_adaptive_polling_ms == 0 && iterations > transport->max_c2d_iterations)
+            {
+                iterations = transport->max_c2d_iterations;
+            }
+
+            if (payload == NULL)
+            {
+                result->status = PERF_RESULT_FAILED;
+                result->reason = "out of memory";
+            }
+
+            // One message at a time, so each sample is a one-way latency rather than a queueing delay.
+            for (i = 0; result->status == PERF_RESULT_OK && i < iterations; i++)
+            {
+                int timestamp_length;
+
+                memset(payload, ' ', payload_size);
+                timestamp_length = snprintf((char*)payload, payload_size, "%llu", (unsigned long long)perf_get_time_us());
+                payload[timestamp_length] = ' ';
+                context.expected = context.c2d_messages_received + 1;
+
+                if (hub_interface->send_c2d_message(hub, DEVICE_ID, payload, payload_size) != 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "fake hub failed sending the message";
+                }
+                else if (do_work_while(&context, is_c2d_message_pending, deadline_us) != 0)
+                {
+                    set_timed_out(result);
+                }
+            }
+
+            result->elapsed_us = perf_get_time_us() - start_us;
+            result->operations = context.c2d_messages_received;
+            free(payload);
+        }
+
+        destroy_benchmark_context(&context);
+    }
+}
+
+static void on_reported_state(int status_code, void* user_context)
+{
+    BENCHMARK_CONTEXT* context = (BENCHMARK_CONTEXT*)user_context;
+
+    if (status_code >= 200 && status_code < 300)
+    {
+        (void)perf_latency_add_sample(context->latency, perf_get_time_us() - context->operation_started_at_us);
+        context->reported_states_completed++;
+    }
+    else
+    {
+        context->reported_states_failed++;
+    }
+}
+
+static bool is_reported_state_pending(BENCHMARK_CONTEXT* context)
+{
+    return context->reported_states_completed + context->reported_states_failed < context->expected;
+}
+
+static void run_twin_round_trip(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    BENCHMARK_CONTEXT context;
+
+    if (!transport->supports_twin)
+    {
+        result->status = PERF_RESULT_SKIPPED;
+        result->reason = "transport does not support device twin";
+    }
+    else if (create_benchmark_context(&context, transport, hub_interface, hub, options, latency) != 0)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "client creation failed";
+    }
+    else
+    {
+        if (warm_up(&context, result) == 0)
+        {
+            uint64_t deadline_us = get_deadline(&context);
+            uint64_t start_us = perf_get_time_us();
+            size_t i;
+
+            for (i = 0; result->status == PERF_RESULT_OK && i < options->iterations; i++)
+            {
+                char reported_state[64];
+                int reported_state_length = snprintf(reported_state, sizeof(reported_state), REPORTED_STATE_FORMAT, (unsigned long)i);
+
+                context.expected = i + 1;
+                context.operation_started_at_us = perf_get_time_us();
+
+                if (IoTHubClient_LL_SendReportedState(context.client, (const unsigned char*)reported_state, (size_t)reported_state_length, on_reported_state, &context) != IOTHUB_CLIENT_OK)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "IoTHubClient_LL_SendReportedState failed";
+                }
+                else if (do_work_while(&context, is_reported_state_pending, deadline_us) != 0)
+                {
+                    set_timed_out(result);
+                }
+            }
+
+            result->elapsed_us = perf_get_time_us() - start_us;
+            result->operations = context.reported_states_completed;
+
+            if (result->status == PERF_RESULT_OK && context.reported_states_failed > 0)
+            {
+                result->status = PERF_RESULT_FAILED;
+                result->reason = "some reported state updates were rejected";
+            }
+        }
+
+        destroy_benchmark_context(&context);
+    }
+}
+
+static int on_device_method(const char* method_name, const unsigned char* payload, size_t size, unsigned char** response, size_t* response_size, void* user_context)
+{
+    int result;
+    (void)method_name;
+    (void)user_context;
+
+    // Echo the request back, as a typical method handler returns a payload of similar size.
+    if ((*response = (unsigned char*)malloc(size > 0 ? size : 1)) == NULL)
+    {
+        *response_size = 0;
+        result = 500;
+    }
+    else
+    {
+        if (size > 0)
+        {
+            (void)memcpy(*response, payload, size);
+        }
+
+        *response_size = size;
+        result = 200;
+    }
+
+    return result;
+}
+
+static void on_method_response(void* user_context, int status, const unsigned char* payload, size_t size)
+{
+    BENCHMARK_CONTEXT* context = (BENCHMARK_CONTEXT*)user_context;
+    uint64_t received_at_us = perf_get_time_us();
+    (void)payload;
+    (void)size;
+
+    if (Lock(context->lock) == LOCK_OK)
+    {
+        if (status == 200)
+        {
+            (void)perf_latency_add_sample(context->latency, received_at_us - context->operation_started_at_us);
+            context->method_responses++;
+        }
+        else
+        {
+            context->method_failures++;
+        }
+
+        (void)Unlock(context->lock);
+    }
+}
+
+static bool is_method_response_pending(BENCHMARK_CONTEXT* context)
+{
+    bool result = true;
+
+    if (Lock(context->lock) == LOCK_OK)
+    {
+        result = context->method_responses + context->method_failures < context->expected;
+        (void)Unlock(context->lock);
+    }
+
+    return result;
+}
+
+static void run_method_round_trip(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    BENCHMARK_CONTEXT context;
+
+    if (hub_interface->invoke_method == NULL)
+    {
+        result->status = PERF_RESULT_SKIPPED;
+        result->reason = "fake hub cannot invoke methods over this transport";
+    }
+    else if (create_benchmark_context(&context, transport, hub_interface, hub, options, latency) != 0)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "client creation failed";
+    }
+    else
+    {
+        if (IoTHubClient_LL_SetDeviceMethodCallback(context.client, on_device_method, &context) != IOTHUB_CLIENT_OK)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "IoTHubClient_LL_SetDeviceMethodCallback failed";
+        }
+        // The method subscription goes out before the warm-up event, so it is in place once that is confirmed.
+        else if (warm_up(&context, result) == 0)
+        {
+            uint64_t deadline_us = get_deadline(&context);
+            uint64_t start_us = perf_get_time_us();
+            size_t i;
+
+            for (i = 0; result->status == PERF_RESULT_OK && i < options->iterations; i++)
+            {
+                context.expected = i + 1;
+                // Published to the hub thread by the request queue lock taken in invoke_method.
+                context.operation_started_at_us = perf_get_time_us();
+
+                if (hub_interface->invoke_method(hub, DEVICE_ID, METHOD_NAME, context.payload, options->payload_size, on_method_response, &context) != 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "fake hub failed invoking the method";
+                }
+                else if (do_work_while(&context, is_method_response_pending, deadline_us) != 0)
+                {
+                    set_timed_out(result);
+                }
+            }
+
+            result->elapsed_us = perf_get_time_us() - start_us;
+            result->operations = context.method_responses;
+
+            if (result->status == PERF_RESULT_OK && context.method_failures > 0)
+            {
+                result->status = PERF_RESULT_FAILED;
+                result->reason = "some method invocations failed";
+            }
+        }
+
+        destroy_benchmark_context(&context);
+    }
+}
+
+static bool is_reconnect_pending(BENCHMARK_CONTEXT* context)
+{
+    return context->connection_losses < context->expected || !context->is_connected;
+}
+
+// Time from the hub dropping every connection to the next event being confirmed.
+static void run_reconnect(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    BENCHMARK_CONTEXT context;
+
+    if (create_benchmark_context(&context, transport, hub_interface, hub, options, latency) != 0)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "client creation failed";
+    }
+    else
+    {
+        if (warm_up(&context, result) == 0)
+        {
+            uint64_t deadline_us = get_deadline(&context);
+            uint64_t start_us = perf_get_time_us();
+            size_t i;
+
+            for (i = 0; result->status == PERF_RESULT_OK && i < options->iterations; i++)
+            {
+                uint64_t dropped_at_us;
+
+                context.expected = context.connection_losses + 1;
+
+                if (hub_interface->drop_connections(hub) != 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "fake hub failed dropping connections";
+                }
+                else
+                {
+                    dropped_at_us = perf_get_time_us();
+
+                    if ((transport->reports_connection_loss && do_work_while(&context, is_reconnect_pending, deadline_us) != 0) ||
+                        send_event_and_wait(&context, deadline_us) != 0)
+                    {
+                        set_timed_out(result);
+                    }
+                    else
+                    {
+                        (void)perf_latency_add_sample(latency, perf_get_time_us() - dropped_at_us);
+                        result->operations++;
+                    }
+                }
+            }
+
+            result->elapsed_us = perf_get_time_us() - start_us;
+        }
+
+        destroy_benchmark_context(&context);
+    }
+}
+
+typedef struct ENQUEUE_CONTEXT_TAG
+{
+    IOTHUB_CLIENT_HANDLE client;
+    const PERF_OPTIONS* options;
+    unsigned char* payload;
+
+    // Confirmations are reported on the client worker thread.
+    LOCK_HANDLE lock;
+    size_t events_confirmed;
+    size_t events_failed;
+} ENQUEUE_CONTEXT;
+
+typedef struct ENQUEUE_PRODUCER_TAG
+{
+    ENQUEUE_CONTEXT* context;
+    THREAD_HANDLE thread;
+    size_t messages;
+    // One IoTHubClient_SendEventAsync duration per message; merged into the latency recorder once the producer has been joined.
+    uint64_t* samples_us;
+    size_t sent;
+} ENQUEUE_PRODUCER;
+
+static void on_enqueued_event_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT confirmation_result, void* user_context)
+{
+    ENQUEUE_CONTEXT* context = (ENQUEUE_CONTEXT*)user_context;
+
+    if (Lock(context->lock) == LOCK_OK)
+    {
+        if (confirmation_result == IOTHUB_CLIENT_CONFIRMATION_OK)
+        {
+            context->events_confirmed++;
+        }
+        else
+        {
+            context->events_failed++;
+        }
+
+        (void)Unlock(context->lock);
+    }
+}
+
+static int send_enqueued_event(ENQUEUE_CONTEXT* context, uint64_t* duration_us)
+{
+    int result;
+    IOTHUB_MESSAGE_HANDLE message;
+
+    if ((message = IoTHubMessage_CreateFromByteArray(context->payload, context->options->payload_size)) == NULL)
+    {
+        LogError("Failed creating event message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint64_t started_at_us = perf_get_time_us();
+
+        if (IoTHubClient_SendEventAsync(context->client, message, on_enqueued_event_confirmation, context) != IOTHUB_CLIENT_OK)
+        {
+            LogError("Failed sending event message");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *duration_us = perf_get_time_us() - started_at_us;
+            result = 0;
+        }
+
+        IoTHubMessage_Destroy(message);
+    }
+
+    return result;
+}
+
+static int enqueue_producer_thread(void* argument)
+{
+    ENQUEUE_PRODUCER* producer = (ENQUEUE_PRODUCER*)argument;
+
+    while (producer->sent < producer->messages &&
+        send_enqueued_event(producer->context, &producer->samples_us[producer->sent]) == 0)
+    {
+        producer->sent++;
+    }
+
+    return 0;
+}
+
+// Waits on the calling thread while the client worker thread confirms events; returns 0 once `expected` events completed.
+static int wait_for_enqueued_events(ENQUEUE_CONTEXT* context, size_t expected, uint64_t deadline_us)
+{
+    int result = __FAILURE__;
+
+    while (perf_get_time_us() <= deadline_us)
+    {
+        bool is_complete = false;
+
+        if (Lock(context->lock) == LOCK_OK)
+        {
+            is_complete = context->events_confirmed + context->events_failed >= expected;
+            (void)Unlock(context->lock);
+        }
+
+        if (is_complete)
+        {
+            result = 0;
+            break;
+        }
+
+        ThreadAPI_Sleep(1);
+    }
+
+    return result;
+}
+
+// Time spent inside IoTHubClient_SendEventAsync by ENQUEUE_PRODUCER_THREADS threads sharing one threaded client,
+// i.e. how long producers wait behind each other and behind the client worker thread.
+static void run_d2c_enqueue_contention(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    ENQUEUE_CONTEXT context;
+    ENQUEUE_PRODUCER producers[ENQUEUE_PRODUCER_THREADS];
+    uint64_t* samples_us;
+    size_t payload_allocation_size = options->payload_size > 0 ? options->payload_size : 1;
+    (void)hub_interface;
+    (void)hub;
+
+    memset(&context, 0, sizeof(context));
+    memset(producers, 0, sizeof(producers));
+    context.options = options;
+
+    if ((samples_us = (uint64_t*)malloc(options->messages * sizeof(uint64_t))) == NULL ||
+        (context.payload = (unsigned char*)malloc(payload_allocation_size)) == NULL ||
+        (context.lock = Lock_Init()) == NULL)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "out of memory";
+    }
+    else if ((context.client = IoTHubClient_CreateFromConnectionString(CONNECTION_STRING, transport->protocol)) == NULL ||
+        IoTHubClient_SetRetryPolicy(context.client, IOTHUB_CLIENT_RETRY_IMMEDIATE, 0) != IOTHUB_CLIENT_OK)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "client creation failed";
+    }
+    else
+    {
+        uint64_t warm_up_us;
+
+        memset(context.payload, 'x', payload_allocation_size);
+
+        // Same warm-up as the other benchmarks, so connection setup is not measured.
+        if (send_enqueued_event(&context, &warm_up_us) != 0 ||
+            wait_for_enqueued_events(&context, 1, perf_get_time_us() + (uint64_t)options->timeout_secs * 1000000) != 0 ||
+            context.events_confirmed != 1)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "warm-up event was not confirmed";
+        }
+        else
+        {
+            uint64_t start_us = perf_get_time_us();
+            size_t started = 0;
+            size_t offset = 0;
+            size_t sent = 0;
+            size_t i;
+
+            for (i = 0; i < ENQUEUE_PRODUCER_THREADS; i++)
+            {
+                producers[i].context = &context;
+                producers[i].messages = options->messages / ENQUEUE_PRODUCER_THREADS + (i < options->messages % ENQUEUE_PRODUCER_THREADS ? 1 : 0);
+                producers[i].samples_us = samples_us + offset;
+                offset += producers[i].messages;
+
+                if (ThreadAPI_Create(&producers[i].thread, enqueue_producer_thread, &producers[i]) != THREADAPI_OK)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "failed starting producer threads";
+                    break;
+                }
+
+                started++;
+            }
+
+            for (i = 0; i < started; i++)
+            {
+                int thread_result;
+                size_t j;
+
+                (void)ThreadAPI_Join(producers[i].thread, &thread_result);
+
+                for (j = 0; j < producers[i].sent; j++)
+                {
+                    (void)perf_latency_add_sample(latency, producers[i].samples_us[j]);
+                }
+
+                sent += producers[i].sent;
+            }
+
+            result->elapsed_us = perf_get_time_us() - start_us;
+            result->operations = sent;
+
+            if (result->status == PERF_RESULT_OK && sent < options->messages)
+            {
+                result->status = PERF_RESULT_FAILED;
+                result->reason = "IoTHubClient_SendEventAsync failed";
+            }
+
+            // Only the enqueue is measured, but every event must still reach the hub.
+            if (wait_for_enqueued_events(&context, sent + 1, perf_get_time_us() + (uint64_t)options->timeout_secs * 1000000) != 0)
+            {
+                if (result->status == PERF_RESULT_OK)
+                {
+                    set_timed_out(result);
+                }
+            }
+            else if (result->status == PERF_RESULT_OK && context.events_failed > 0)
+            {
+                result->status = PERF_RESULT_FAILED;
+                result->reason = "some events were not confirmed";
+            }
+        }
+    }
+
+    if (context.client != NULL)
+    {
+        IoTHubClient_Destroy(context.client);
+    }
+
+    if (context.lock != NULL)
+    {
+        (void)Lock_Deinit(context.lock);
+    }
+
+    free(context.payload);
+    free(samples_us);
+}
+
+typedef struct SLOW_METHOD_CONTEXT_TAG
+{
+    IOTHUB_CLIENT_HANDLE client;
+    unsigned char* payload;
+
+    // Updated from the client callbacks and from the fake hub thread.
+    LOCK_HANDLE lock;
+    size_t methods_started;
+    size_t method_responses;
+    size_t events_confirmed;
+    size_t events_failed;
+} SLOW_METHOD_CONTEXT;
+
+static void increment_slow_method_count(SLOW_METHOD_CONTEXT* context, size_t* count)
+{
+    if (Lock(context->lock) == LOCK_OK)
+    {
+        (*count)++;
+        (void)Unlock(context->lock);
+    }
+}
+
+// Waits until `*count` (guarded by the context lock) reaches `expected`; returns 0 unless `deadline_us` passed first.
+static int wait_for_slow_method_count(SLOW_METHOD_CONTEXT* context, const size_t* count, size_t expected, uint64_t deadline_us)
+{
+    int result = __FAILURE__;
+
+    while (perf_get_time_us() <= deadline_us)
+    {
+        bool is_complete = false;
+
+        if (Lock(context->lock) == LOCK_OK)
+        {
+            is_complete = *count >= expected;
+            (void)Unlock(context->lock);
+        }
+
+        if (is_complete)
+        {
+            result = 0;
+            break;
+        }
+
+        ThreadAPI_Sleep(1);
+    }
+
+    return result;
+}
+
+static int on_slow_device_method(const char* method_name, const unsigned char* payload, size_t size, unsigned char** response, size_t* response_size, void* user_context)
+{
+    SLOW_METHOD_CONTEXT* context = (SLOW_METHOD_CONTEXT*)user_context;
+
+    increment_slow_method_count(context, &context->methods_started);
+    // Stands for a handler doing blocking I/O.
+    ThreadAPI_Sleep(SLOW_METHOD_DURATION_MS);
+
+    return on_device_method(method_name, payload, size, response, response_size, NULL);
+}
+
+static void on_slow_method_response(void* user_context, int status, const unsigned char* payload, size_t size)
+{
+    SLOW_METHOD_CONTEXT* context = (SLOW_METHOD_CONTEXT*)user_context;
+    (void)status;
+    (void)payload;
+    (void)size;
+
+    increment_slow_method_count(context, &context->method_responses);
+}
+
+static void on_slow_method_event_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT confirmation_result, void* user_context)
+{
+    SLOW_METHOD_CONTEXT* context = (SLOW_METHOD_CONTEXT*)user_context;
+
+    increment_slow_method_count(context, confirmation_result == IOTHUB_CLIENT_CONFIRMATION_OK ? &context->events_confirmed : &context->events_failed);
+}
+
+static int send_slow_method_event(SLOW_METHOD_CONTEXT* context, const PERF_OPTIONS* options, uint64_t* sent_at_us)
+{
+    int result;
+    IOTHUB_MESSAGE_HANDLE message;
+
+    if ((message = IoTHubMessage_CreateFromByteArray(context->payload, options->payload_size)) == NULL)
+    {
+        LogError("Failed creating event message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *sent_at_us = perf_get_time_us();
+
+        if (IoTHubClient_SendEventAsync(context->client, message, on_slow_method_event_confirmation, context) != IOTHUB_CLIENT_OK)
+        {
+            LogError("Failed sending event message");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        IoTHubMessage_Destroy(message);
+    }
+
+    return result;
+}
+
+// Send-to-confirmation latency of events sent while a method handler taking SLOW_METHOD_DURATION_MS runs, on one
+// threaded client. With `--callback-threads 0` the handler runs on the client worker thread, which confirms the
+// event only once the handler returns; otherwise it runs on a callback executor and the event goes through.
+static void run_d2c_with_slow_method(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    SLOW_METHOD_CONTEXT context;
+    CALLBACK_EXECUTOR_HANDLE executor = NULL;
+    size_t payload_allocation_size = options->payload_size > 0 ? options->payload_size : 1;
+    uint64_t deadline_us = perf_get_time_us() + (uint64_t)options->timeout_secs * 1000000;
+
+    memset(&context, 0, sizeof(context));
+
+    if (hub_interface->invoke_method == NULL)
+    {
+        result->status = PERF_RESULT_SKIPPED;
+        result->reason = "fake hub cannot invoke methods over this transport";
+    }
+    else if ((context.payload = (unsigned char*)malloc(payload_allocation_size)) == NULL ||
+        (context.lock = Lock_Init()) == NULL ||
+        (options->callback_threads > 0 && (executor = callback_executor_create(options->callback_threads, options->window)) == NULL))
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "out of memory";
+    }
+    else if ((context.client = IoTHubClient_CreateFromConnectionString(CONNECTION_STRING, transport->protocol)) == NULL ||
+        IoTHubClient_SetRetryPolicy(context.client, IOTHUB_CLIENT_RETRY_IMMEDIATE, 0) != IOTHUB_CLIENT_OK ||
+        (executor != NULL && IoTHubClient_SetOption(context.client, OPTION_CALLBACK_EXECUTOR, executor) != IOTHUB_CLIENT_OK) ||
+        IoTHubClient_SetDeviceMethodCallback(context.client, on_slow_device_method, &context) != IOTHUB_CLIENT_OK)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "client creation failed";
+    }
+    else
+    {
+        uint64_t sent_at_us;
+
+        memset(context.payload, 'x', payload_allocation_size);
+
+        // The method subscription goes out before the warm-up event, so it is in place once that is confirmed.
+        if (send_slow_method_event(&context, options, &sent_at_us) != 0 ||
+            wait_for_slow_method_count(&context, &context.events_confirmed, 1, deadline_us) != 0)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "warm-up event was not confirmed";
+        }
+        else
+        {
+            size_t iterations = options->iterations < SLOW_METHOD_MAX_ITERATIONS ? options->iterations : SLOW_METHOD_MAX_ITERATIONS;
+            uint64_t start_us = perf_get_time_us();
+            size_t i;
+
+            for (i = 0; result->status == PERF_RESULT_OK && i < iterations; i++)
+            {
+                // The event is sent once the handler has started, so it always has to get past a running handler.
+                if (hub_interface->invoke_method(hub, DEVICE_ID, METHOD_NAME, context.payload, options->payload_size, on_slow_method_response, &context) != 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "fake hub failed invoking the method";
+                }
+                else if (wait_for_slow_method_count(&context, &context.methods_started, i + 1, deadline_us) != 0)
+                {
+                    set_timed_out(result);
+                }
+                else if (send_slow_method_event(&context, options, &sent_at_us) != 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "IoTHubClient_SendEventAsync failed";
+                }
+                else if (wait_for_slow_method_count(&context, &context.events_confirmed, i + 2, deadline_us) != 0)
+                {
+                    set_timed_out(result);
+                }
+                else
+                {
+                    (void)perf_latency_add_sample(latency, perf_get_time_us() - sent_at_us);
+                    result->operations++;
+
+                    // The next method is invoked once this one is answered, so there is never more than one running.
+                    if (wait_for_slow_method_count(&context, &context.method_responses, i + 1, deadline_us) != 0)
+                    {
+                        set_timed_out(result);
+                    }
+                }
+            }
+
+            result->elapsed_us = perf_get_time_us() - start_us;
+        }
+    }
+
+    if (context.client != NULL)
+    {
+        IoTHubClient_Destroy(context.client);
+    }
+
+    // After the client, whose callbacks may still be queued on it.
+    if (executor != NULL)
+    {
+        callback_executor_destroy(executor);
+    }
+
+    if (context.lock != NULL)
+    {
+        (void)Lock_Deinit(context.lock);
+    }
+
+    free(context.payload);
+}
+
+typedef struct MULTIPLEXED_DEVICE_TAG
+{
+    char device_id[32];
+    IOTHUB_CLIENT_LL_HANDLE client;
+    D2C_MESSAGE_CONTEXT message_context;
+} MULTIPLEXED_DEVICE;
+
+static void destroy_multiplexed_clients(MULTIPLEXED_DEVICE* devices, size_t device_count)
+{
+    size_t i;
+
+    for (i = 0; i < device_count; i++)
+    {
+        if (devices[i].client != NULL)
+        {
+            IoTHubClient_LL_Destroy(devices[i].client);
+            devices[i].client = NULL;
+        }
+    }
+}
+
+static int create_multiplexed_clients(const PERF_TRANSPORT* transport, TRANSPORT_HANDLE transport_handle, MULTIPLEXED_DEVICE* devices, size_t device_count)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; result == 0 && i < device_count; i++)
+    {
+        IOTHUB_CLIENT_DEVICE_CONFIG device_config;
+
+        (void)snprintf(devices[i].device_id, sizeof(devices[i].device_id), MULTIPLEXED_DEVICE_ID_FORMAT, (unsigned long)i);
+        device_config.protocol = transport->protocol;
+        device_config.transportHandle = IoTHubTransport_GetLLTransport(transport_handle);
+        device_config.deviceId = devices[i].device_id;
+        device_config.deviceKey = MULTIPLEXED_DEVICE_KEY;
+        device_config.deviceSasToken = NULL;
+
+        if ((devices[i].client = IoTHubClient_LL_CreateWithTransport(&device_config)) == NULL)
+        {
+            LogError("Failed creating %s client for %s", transport->name, devices[i].device_id);
+            result = __FAILURE__;
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_multiplexed_clients(devices, device_count);
+    }
+
+    return result;
+}
+
+// Sends one event from every device, then pumps the shared transport until all are confirmed.
+static int send_multiplexed_round(BENCHMARK_CONTEXT* context, MULTIPLEXED_DEVICE* devices, size_t device_count, uint64_t deadline_us, PERF_RESULT* result)
+{
+    int round_result = 0;
+    size_t i;
+
+    for (i = 0; round_result == 0 && i < device_count; i++)
+    {
+        if (send_event_on_client(context, devices[i].client, &devices[i].message_context) != 0)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "IoTHubClient_LL_SendEventAsync failed";
+            round_result = __FAILURE__;
+        }
+    }
+
+    if (round_result == 0 && do_work_while(context, has_events_in_flight, deadline_us) != 0)
+    {
+        set_timed_out(result);
+        round_result = __FAILURE__;
+    }
+
+    return round_result;
+}
+
+// Per-device D2C latency when `device_count` devices share one transport. Every device has one event in flight
+// per round, so the samples show how much a device waits behind the others as the device count grows.
+static void run_multiplexed_d2c(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result, size_t device_count)
+{
+    BENCHMARK_CONTEXT context;
+    MULTIPLEXED_DEVICE* devices;
+    TRANSPORT_HANDLE transport_handle = NULL;
+    size_t payload_allocation_size = options->payload_size > 0 ? options->payload_size : 1;
+
+    memset(&context, 0, sizeof(BENCHMARK_CONTEXT));
+    context.transport = transport;
+    context.hub_interface = hub_interface;
+    context.hub = hub;
+    context.options = options;
+
+    if (!transport->supports_multiplexing)
+    {
+        result->status = PERF_RESULT_SKIPPED;
+        result->reason = "fake hub cannot serve multiplexed devices over this transport";
+    }
+    else if ((devices = (MULTIPLEXED_DEVICE*)calloc(device_count, sizeof(MULTIPLEXED_DEVICE))) == NULL)
+    {
+        result->status = PERF_RESULT_FAILED;
+        result->reason = "out of memory";
+    }
+    else
+    {
+        if ((context.payload = (unsigned char*)malloc(payload_allocation_size)) == NULL ||
+            (transport_handle = IoTHubTransport_Create(transport->protocol, MULTIPLEXED_HUB_NAME, MULTIPLEXED_HUB_SUFFIX)) == NULL ||
+            create_multiplexed_clients(transport, transport_handle, devices, device_count) != 0)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "client creation failed";
+        }
+        else if (options->connection_pool_size > 0 &&
+            IoTHubClient_LL_SetOption(devices[0].client, OPTION_HTTP_CONNECTION_POOL_SIZE, &options->connection_pool_size) != IOTHUB_CLIENT_OK)
+        {
+            result->status = PERF_RESULT_FAILED;
+            result->reason = "connection pool size rejected";
+        }
+        else
+        {
+            // The transport serves every registered device from one _DoWork, so pumping the first client is enough.
+            uint64_t deadline_us = get_deadline(&context);
+            size_t rounds = options->iterations / device_count > 0 ? options->iterations / device_count : 1;
+            size_t events_confirmed;
+            uint64_t start_us;
+            size_t i;
+
+            context.client = devices[0].client;
+            memset(context.payload, 'x', payload_allocation_size);
+
+            // The warm-up round opens the connections, so connection setup is never part of a measurement.
+            if (send_multiplexed_round(&context, devices, device_count, deadline_us, result) == 0)
+            {
+                context.latency = latency;
+                events_confirmed = context.events_confirmed;
+                start_us = perf_get_time_us();
+
+                for (i = 0; i < rounds; i++)
+                {
+                    if (send_multiplexed_round(&context, devices, device_count, deadline_us, result) != 0)
+                    {
+                        break;
+                    }
+                }
+
+                result->elapsed_us = perf_get_time_us() - start_us;
+                result->operations = context.events_confirmed - events_confirmed;
+            }
+
+            if (result->status == PERF_RESULT_OK && context.events_failed > 0)
+            {
+                result->status = PERF_RESULT_FAILED;
+                result->reason = "some events were not confirmed";
+            }
+        }
+
+        destroy_multiplexed_clients(devices, device_count);
+
+        if (transport_handle != NULL)
+        {
+            IoTHubTransport_Destroy(transport_handle);
+        }
+
+        free(context.payload);
+        free(devices);
+    }
+}
+
+static void run_multiplexed_d2c_1(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    run_multiplexed_d2c(transport, hub_interface, hub, options, latency, result, 1);
+}
+
+static void run_multiplexed_d2c_16(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    run_multiplexed_d2c(transport, hub_interface, hub, options, latency, result, 16);
+}
+
+static void run_multiplexed_d2c_128(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    run_multiplexed_d2c(transport, hub_interface, hub, options, latency, result, 128);
+}
+
+#ifdef PERF_USE_MQTT
+// What IoT Hub sends with a cloud-to-device message carrying a message id, a correlation id and two application properties.
+static const char* C2D_TOPIC = "devices/perf-device/messages/devicebound/%24.mid=6a1c2e7e-8f37-4c2b-9a0e-0b5d3c1e4f21&%24.cid=perf-correlation&%24.to=%2Fdevices%2Fperf-device%2Fmessages%2FdeviceBound&iothub-ack=full&temperature=21.5&location=building%2043%2Ffloor%202";
+#define TOPIC_PARSES_PER_SAMPLE 1000
+
+// Everything mqtt_notification_callback does with the topic of a cloud-to-device message, without the message itself.
+static int parse_c2d_topic(void)
+{
+    int result;
+    MQTT_TOPIC_INFO topic_info;
+
+    if (mqtt_topic_parse(C2D_TOPIC, &topic_info) != 0 || topic_info.type != MQTT_TOPIC_TYPE_C2D_MESSAGE)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        MQTT_TOPIC_SLICE name;
+        MQTT_TOPIC_SLICE value;
+        char buffer[128];
+
+        result = 0;
+        while (result == 0 && mqtt_topic_get_next_property(&topic_info.properties, &name, &value) == 0)
+        {
+            if (mqtt_topic_url_decode(&name, buffer, sizeof(buffer)) != 0 ||
+                (value.value != NULL && mqtt_topic_url_decode(&value, buffer, sizeof(buffer)) != 0))
+            {
+                result = __LINE__;
+            }
+        }
+    }
+
+    return result;
+}
+#endif
+
+static void run_c2d_topic_parse(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result)
+{
+    (void)hub_interface;
+    (void)hub;
+
+#ifdef PERF_USE_MQTT
+    if (strcmp(transport->name, "mqtt") != 0)
+    {
+        result->status = PERF_RESULT_SKIPPED;
+        result->reason = "MQTT topic parsing only";
+    }
+    else
+    {
+        uint64_t start_us = perf_get_time_us();
+        size_t i;
+
+        // Each sample is a batch, since a single parse takes less than the clock resolution.
+        for (i = 0; result->status == PERF_RESULT_OK && i < options->iterations; i++)
+        {
+            uint64_t batch_started_at_us = perf_get_time_us();
+            size_t j;
+
+            for (j = 0; result->status == PERF_RESULT_OK && j < TOPIC_PARSES_PER_SAMPLE; j++)
+            {
+                if (parse_c2d_topic() != 0)
+                {
+                    result->status = PERF_RESULT_FAILED;
+                    result->reason = "topic parsing failed";
+                }
+            }
+
+            (void)perf_latency_add_sample(latency, perf_get_time_us() - batch_started_at_us);
+        }
+
+        result->elapsed_us = perf_get_time_us() - start_us;
+        result->operations = i * TOPIC_PARSES_PER_SAMPLE;
+    }
+#else
+    (void)transport;
+    (void)options;
+    (void)latency;
+    result->status = PERF_RESULT_SKIPPED;
+    result->reason = "MQTT topic parsing only";
+#endif
+}
+
+static const PERF_BENCHMARK benchmarks[] =
+{
+    { "d2c_throughput", run_d2c_throughput },
+    { "c2d_latency", run_c2d_latency },
+    { "twin_round_trip", run_twin_round_trip },
+    { "method_round_trip", run_method_round_trip },
+    { "reconnect", run_reconnect },
+    { "d2c_enqueue_contention", run_d2c_enqueue_contention },
+    { "d2c_with_slow_method", run_d2c_with_slow_method },
+    { "multiplexed_d2c_1", run_multiplexed_d2c_1 },
+    { "multiplexed_d2c_16", run_multiplexed_d2c_16 },
+    { "multiplexed_d2c_128", run_multiplexed_d2c_128 },
+    { "c2d_topic_parse", run_c2d_topic_parse }
+};
+
+const PERF_BENCHMARK* perf_benchmarks_get(size_t* count)
+{
+    *count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    return benchmarks;
+}
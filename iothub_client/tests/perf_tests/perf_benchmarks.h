@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_BENCHMARKS_H
+#define PERF_BENCHMARKS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "iothub_client_ll.h"
+#include "perf_fake_hub.h"
+#include "perf_stats.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct PERF_OPTIONS_TAG
+{
+    // Messages sent by the throughput benchmark.
+    size_t messages;
+    // Round trips measured by each latency benchmark.
+    size_t iterations;
+    size_t payload_size;
+    // Maximum number of unconfirmed events in flight in the throughput benchmark.
+    size_t window;
+    // Sleep between two IoTHubClient_LL_DoWork calls; 0 spins, which measures the SDK rather than the scheduler.
+    unsigned int dowork_sleep_us;
+    unsigned int timeout_secs;
+    // Connections shared by the devices of the multiplexed benchmarks (OPTION_HTTP_CONNECTION_POOL_SIZE); 0 keeps
+    // the blocking single connection, as a baseline.
+    size_t connection_pool_size;
+    // Shortest interval between two C2D polls of the HTTP transport (OPTION_C2D_ADAPTIVE_POLLING_MIN_INTERVAL_MS);
+    // 0 keeps the fixed once-per-second polling, as a baseline.
+    unsigned int c2d_adaptive_polling_ms;
+    // Threads of the callback executor (OPTION_CALLBACK_EXECUTOR) running the user callbacks of d2c_with_slow_method;
+    // 0 runs them on the client worker thread, as a baseline.
+    size_t callback_threads;
+    // Released per-message structures each client keeps for reuse (OPTION_MESSAGE_POOL_SIZE); 0 allocates and frees
+    // them for every event, as a baseline.
+    size_t message_pool_size;
+} PERF_OPTIONS;
+
+typedef struct PERF_TRANSPORT_TAG
+{
+    const char* name;
+    IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol;
+    const PERF_FAKE_HUB_INTERFACE* (*get_fake_hub_interface)(void);
+    bool supports_twin;
+    // False for transports that never call the connection status callback on a dropped connection.
+    bool reports_connection_loss;
+    // Upper bound on cloud-to-device round trips for polling transports (0 means no bound).
+    size_t max_c2d_iterations;
+    // False when the fake hub cannot serve several devices sharing one transport.
+    bool supports_multiplexing;
+} PERF_TRANSPORT;
+
+#define PERF_RESULT_STATUS_VALUES \
+    PERF_RESULT_OK,               \
+    PERF_RESULT_SKIPPED,          \
+    PERF_RESULT_FAILED
+
+DEFINE_ENUM(PERF_RESULT_STATUS, PERF_RESULT_STATUS_VALUES);
+
+typedef struct PERF_RESULT_TAG
+{
+    PERF_RESULT_STATUS status;
+    // Static string explaining a skipped or failed run; NULL otherwise.
+    const char* reason;
+    size_t operations;
+    uint64_t elapsed_us;
+} PERF_RESULT;
+
+// Runs one benchmark against a fake hub that has already been created; samples go to `latency`.
+typedef void(*PERF_BENCHMARK_FUNCTION)(const PERF_TRANSPORT* transport, const PERF_FAKE_HUB_INTERFACE* hub_interface, PERF_FAKE_HUB_HANDLE hub, const PERF_OPTIONS* options, PERF_LATENCY_HANDLE latency, PERF_RESULT* result);
+
+typedef struct PERF_BENCHMARK_TAG
+{
+    const char* name;
+    PERF_BENCHMARK_FUNCTION run;
+} PERF_BENCHMARK;
+
+extern const PERF_BENCHMARK* perf_benchmarks_get(size_t* count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_BENCHMARKS_H */
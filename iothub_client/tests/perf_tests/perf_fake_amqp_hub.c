@@ -0,0 +1,917 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/message_receiver.h"
+#include "azure_uamqp_c/message_sender.h"
+#include "azure_uamqp_c/messaging.h"
+
+#include "perf_fake_hub.h"
+#include "perf_fake_hub_request.h"
+#include "perf_socket.h"
+
+// A uAMQP listener that accepts the links opened by iothubtransport_amqp_common.c for x509 devices
+// (no SASL/CBS): telemetry, cloud-to-device and twin. Twin requests are answered with status 200 and
+// a fixed twin document; device methods are not offered (they require wip_use_c2d_amqp_methods).
+
+#define MAX_CONNECTIONS                 16
+#define MAX_SESSIONS_PER_CONNECTION     4
+#define MAX_LINKS_PER_CONNECTION        16
+#define POLL_TIMEOUT_MS                 1
+#define DROP_WAIT_TIMEOUT_MS            5000
+#define SESSION_INCOMING_WINDOW         10000
+
+static const char* CONTAINER_ID = "perf-fake-amqp-hub";
+static const char* DEVICES_PATH_SEGMENT = "/devices/";
+static const char* EVENTS_ADDRESS_SUFFIX = "/messages/events";
+static const char* C2D_ADDRESS_SUFFIX = "/messages/devicebound";
+static const char* TWIN_ADDRESS_SUFFIX = "/twin";
+static const char* TWIN_STATUS_ANNOTATION = "status";
+static const char* TWIN_VERSION_ANNOTATION = "version";
+static const char* TWIN_DOCUMENT = "{\"desired\":{\"$version\":1},\"reported\":{\"$version\":1}}";
+
+typedef enum AMQP_LINK_KIND_TAG
+{
+    AMQP_LINK_KIND_UNUSED,
+    AMQP_LINK_KIND_EVENTS,
+    AMQP_LINK_KIND_C2D,
+    AMQP_LINK_KIND_TWIN,
+    AMQP_LINK_KIND_OTHER
+} AMQP_LINK_KIND;
+
+struct AMQP_CONNECTION_TAG;
+
+typedef struct AMQP_LINK_TAG
+{
+    struct AMQP_CONNECTION_TAG* connection;
+    AMQP_LINK_KIND kind;
+    char* device_id;
+    LINK_HANDLE link;
+    // Exactly one of these is set: the hub sends on links the device receives on, and vice versa.
+    MESSAGE_SENDER_HANDLE message_sender;
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+} AMQP_LINK;
+
+typedef struct AMQP_SESSION_TAG
+{
+    struct AMQP_CONNECTION_TAG* connection;
+    SESSION_HANDLE session;
+} AMQP_SESSION;
+
+typedef struct AMQP_CONNECTION_TAG
+{
+    struct FAKE_AMQP_HUB_TAG* hub;
+    int socket;
+    XIO_HANDLE io;
+    CONNECTION_HANDLE connection;
+    bool is_closed;
+    AMQP_SESSION sessions[MAX_SESSIONS_PER_CONNECTION];
+    AMQP_LINK links[MAX_LINKS_PER_CONNECTION];
+} AMQP_CONNECTION;
+
+typedef struct FAKE_AMQP_HUB_TAG
+{
+    int listen_socket;
+    int port;
+    int wakeup[2];
+    THREAD_HANDLE thread;
+    PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE requests;
+
+    // Guarded by `lock`.
+    LOCK_HANDLE lock;
+    bool is_stopping;
+    size_t d2c_message_count;
+    size_t drop_count;
+
+    // Only touched by the hub thread.
+    AMQP_CONNECTION connections[MAX_CONNECTIONS];
+    int64_t twin_version;
+} FAKE_AMQP_HUB;
+
+static bool ends_with(const char* value, const char* suffix)
+{
+    size_t value_length = strlen(value);
+    size_t suffix_length = strlen(suffix);
+
+    return value_length >= suffix_length && strcmp(value + value_length - suffix_length, suffix) == 0;
+}
+
+// Extracts the address of a link source (`is_target` false) or target; the caller frees the result.
+static char* get_terminus_address(AMQP_VALUE terminus, bool is_target)
+{
+    char* result = NULL;
+    AMQP_VALUE address_value = NULL;
+    const char* address;
+
+    if (is_target)
+    {
+        TARGET_HANDLE target;
+
+        if (amqpvalue_get_target(terminus, &target) == 0)
+        {
+            if (target_get_address(target, &address_value) == 0 && amqpvalue_get_string(address_value, &address) == 0)
+            {
+                (void)mallocAndStrcpy_s(&result, address);
+            }
+            target_destroy(target);
+        }
+    }
+    else
+    {
+        SOURCE_HANDLE source;
+
+        if (amqpvalue_get_source(terminus, &source) == 0)
+        {
+            if (source_get_address(source, &address_value) == 0 && amqpvalue_get_string(address_value, &address) == 0)
+            {
+                (void)mallocAndStrcpy_s(&result, address);
+            }
+            source_destroy(source);
+        }
+    }
+
+    return result;
+}
+
+// "amqps://<host>/devices/<device id>/..." -> "<device id>"; the caller frees the result.
+static char* get_device_id_from_address(const char* address)
+{
+    char* result = NULL;
+    const char* device_id = strstr(address, DEVICES_PATH_SEGMENT);
+
+    if (device_id != NULL)
+    {
+        size_t length;
+
+        device_id += strlen(DEVICES_PATH_SEGMENT);
+        length = strcspn(device_id, "/");
+
+        if ((result = (char*)malloc(length + 1)) != NULL)
+        {
+            (void)memcpy(result, device_id, length);
+            result[length] = '\0';
+        }
+    }
+
+    return result;
+}
+
+static AMQP_LINK* find_link(AMQP_CONNECTION* connection, AMQP_LINK_KIND kind, bool is_hub_sender, const char* device_id)
+{
+    AMQP_LINK* result = NULL;
+    size_t i;
+
+    for (i = 0; i < MAX_LINKS_PER_CONNECTION; i++)
+    {
+        AMQP_LINK* link = &connection->links[i];
+
+        if (link->kind == kind &&
+            (link->message_sender != NULL) == is_hub_sender &&
+            link->device_id != NULL && strcmp(link->device_id, device_id) == 0)
+        {
+            result = link;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    (void)context;
+
+    if (send_result != MESSAGE_SEND_OK)
+    {
+        LogError("Fake AMQP hub failed delivering message (%d)", send_result);
+    }
+}
+
+static int add_annotation(AMQP_VALUE annotations, const char* name, AMQP_VALUE value)
+{
+    int result;
+    AMQP_VALUE key = amqpvalue_create_symbol(name);
+
+    if (key == NULL || value == NULL || amqpvalue_set_map_value(annotations, key, value) != 0)
+    {
+        LogError("Failed adding message annotation '%s'", name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (key != NULL)
+    {
+        amqpvalue_destroy(key);
+    }
+
+    if (value != NULL)
+    {
+        amqpvalue_destroy(value);
+    }
+
+    return result;
+}
+
+// Answers a twin request (GET, PATCH, PUT or DELETE) on the twin link the device receives on.
+static void send_twin_response(AMQP_LINK* twin_receiver_link, MESSAGE_HANDLE request)
+{
+    AMQP_LINK* twin_sender_link = find_link(twin_receiver_link->connection, AMQP_LINK_KIND_TWIN, true, twin_receiver_link->device_id);
+    PROPERTIES_HANDLE request_properties = NULL;
+    AMQP_VALUE correlation_id = NULL;
+
+    if (twin_sender_link == NULL)
+    {
+        LogError("Twin request received before the device attached its twin receiver link (%s)", twin_receiver_link->device_id);
+    }
+    else if (message_get_properties(request, &request_properties) != 0 || request_properties == NULL ||
+        properties_get_correlation_id(request_properties, &correlation_id) != 0)
+    {
+        LogError("Twin request without correlation-id (%s)", twin_receiver_link->device_id);
+    }
+    else
+    {
+        MESSAGE_HANDLE response = message_create();
+        PROPERTIES_HANDLE response_properties = properties_create();
+        AMQP_VALUE annotations = amqpvalue_create_map();
+        BINARY_DATA body;
+
+        body.bytes = (const unsigned char*)TWIN_DOCUMENT;
+        body.length = strlen(TWIN_DOCUMENT);
+
+        if (response == NULL || response_properties == NULL || annotations == NULL ||
+            properties_set_correlation_id(response_properties, correlation_id) != 0 ||
+            message_set_properties(response, response_properties) != 0 ||
+            add_annotation(annotations, TWIN_STATUS_ANNOTATION, amqpvalue_create_int(200)) != 0 ||
+            add_annotation(annotations, TWIN_VERSION_ANNOTATION, amqpvalue_create_long(++twin_receiver_link->connection->hub->twin_version)) != 0 ||
+            message_set_message_annotations(response, annotations) != 0 ||
+            message_add_body_amqp_data(response, body) != 0 ||
+            messagesender_send(twin_sender_link->message_sender, response, on_message_send_complete, NULL) != 0)
+        {
+            LogError("Failed sending twin response (%s)", twin_receiver_link->device_id);
+        }
+
+        if (annotations != NULL)
+        {
+            amqpvalue_destroy(annotations);
+        }
+
+        if (response_properties != NULL)
+        {
+            properties_destroy(response_properties);
+        }
+
+        if (response != NULL)
+        {
+            message_destroy(response);
+        }
+    }
+
+    if (request_properties != NULL)
+    {
+        properties_destroy(request_properties);
+    }
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    AMQP_LINK* link = (AMQP_LINK*)context;
+
+    if (link->kind == AMQP_LINK_KIND_EVENTS)
+    {
+        FAKE_AMQP_HUB* hub = link->connection->hub;
+
+        if (Lock(hub->lock) == LOCK_OK)
+        {
+            hub->d2c_message_count++;
+            (void)Unlock(hub->lock);
+        }
+    }
+    else if (link->kind == AMQP_LINK_KIND_TWIN)
+    {
+        send_twin_response(link, message);
+    }
+
+    return messaging_delivery_accepted();
+}
+
+static void destroy_link(AMQP_LINK* link)
+{
+    if (link->message_sender != NULL)
+    {
+        messagesender_destroy(link->message_sender);
+        link->message_sender = NULL;
+    }
+
+    if (link->message_receiver != NULL)
+    {
+        messagereceiver_destroy(link->message_receiver);
+        link->message_receiver = NULL;
+    }
+
+    if (link->link != NULL)
+    {
+        link_destroy(link->link);
+        link->link = NULL;
+    }
+
+    free(link->device_id);
+    link->device_id = NULL;
+    link->kind = AMQP_LINK_KIND_UNUSED;
+}
+
+static bool on_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    bool result;
+    AMQP_SESSION* session = (AMQP_SESSION*)context;
+    AMQP_CONNECTION* connection = session->connection;
+    // `role` is the role of the device's end of the link.
+    bool is_device_sender = (role == role_sender);
+    AMQP_LINK* link = NULL;
+    char* address;
+    size_t i;
+
+    for (i = 0; i < MAX_LINKS_PER_CONNECTION; i++)
+    {
+        if (connection->links[i].kind == AMQP_LINK_KIND_UNUSED)
+        {
+            link = &connection->links[i];
+            break;
+        }
+    }
+
+    if (link == NULL)
+    {
+        LogError("Too many links on fake AMQP hub connection (%s)", name);
+        result = false;
+    }
+    else if ((address = get_terminus_address(is_device_sender ? target : source, is_device_sender)) == NULL)
+    {
+        LogError("Link attached without an address (%s)", name);
+        result = false;
+    }
+    else
+    {
+        link->connection = connection;
+        link->device_id = get_device_id_from_address(address);
+        link->kind =
+            ends_with(address, EVENTS_ADDRESS_SUFFIX) ? AMQP_LINK_KIND_EVENTS :
+            ends_with(address, C2D_ADDRESS_SUFFIX) ? AMQP_LINK_KIND_C2D :
+            ends_with(address, TWIN_ADDRESS_SUFFIX) ? AMQP_LINK_KIND_TWIN :
+            AMQP_LINK_KIND_OTHER;
+
+        if ((link->link = link_create_from_endpoint(session->session, new_link_endpoint, name, role, source, target)) == NULL)
+        {
+            LogError("Failed creating link from endpoint (%s)", address);
+            result = false;
+        }
+        else if (is_device_sender)
+        {
+            if (link_set_rcv_settle_mode(link->link, receiver_settle_mode_first) != 0 ||
+                (link->message_receiver = messagereceiver_create(link->link, NULL, NULL)) == NULL ||
+                messagereceiver_open(link->message_receiver, on_message_received, link) != 0)
+            {
+                LogError("Failed opening message receiver (%s)", address);
+                result = false;
+            }
+            else
+            {
+                result = true;
+            }
+        }
+        else
+        {
+            if ((link->message_sender = messagesender_create(link->link, NULL, NULL)) == NULL ||
+                messagesender_open(link->message_sender) != 0)
+            {
+                LogError("Failed opening message sender (%s)", address);
+                result = false;
+            }
+            else
+            {
+                result = true;
+            }
+        }
+
+        if (!result)
+        {
+            destroy_link(link);
+        }
+
+        free(address);
+    }
+
+    return result;
+}
+
+static bool on_new_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    bool result;
+    AMQP_CONNECTION* connection = (AMQP_CONNECTION*)context;
+    AMQP_SESSION* session = NULL;
+    size_t i;
+
+    for (i = 0; i < MAX_SESSIONS_PER_CONNECTION; i++)
+    {
+        if (connection->sessions[i].session == NULL)
+        {
+            session = &connection->sessions[i];
+            break;
+        }
+    }
+
+    if (session == NULL)
+    {
+        LogError("Too many sessions on fake AMQP hub connection");
+        result = false;
+    }
+    else
+    {
+        session->connection = connection;
+
+        if ((session->session = session_create_from_endpoint(connection->connection, new_endpoint, on_link_attached, session)) == NULL)
+        {
+            LogError("Failed creating session from endpoint");
+            result = false;
+        }
+        else if (session_set_incoming_window(session->session, SESSION_INCOMING_WINDOW) != 0 ||
+            session_begin(session->session) != 0)
+        {
+            LogError("Failed beginning session");
+            session_destroy(session->session);
+            session->session = NULL;
+            result = false;
+        }
+        else
+        {
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static void on_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    (void)previous_connection_state;
+
+    if (new_connection_state == CONNECTION_STATE_END ||
+        new_connection_state == CONNECTION_STATE_ERROR ||
+        new_connection_state == CONNECTION_STATE_DISCARDING)
+    {
+        ((AMQP_CONNECTION*)context)->is_closed = true;
+    }
+}
+
+static void on_connection_io_error(void* context)
+{
+    ((AMQP_CONNECTION*)context)->is_closed = true;
+}
+
+static void destroy_connection(AMQP_CONNECTION* connection)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_LINKS_PER_CONNECTION; i++)
+    {
+        destroy_link(&connection->links[i]);
+    }
+
+    for (i = 0; i < MAX_SESSIONS_PER_CONNECTION; i++)
+    {
+        if (connection->sessions[i].session != NULL)
+        {
+            session_destroy(connection->sessions[i].session);
+            connection->sessions[i].session = NULL;
+        }
+    }
+
+    if (connection->connection != NULL)
+    {
+        connection_destroy(connection->connection);
+        connection->connection = NULL;
+    }
+
+    // Destroying the socket I/O closes the accepted socket.
+    if (connection->io != NULL)
+    {
+        xio_destroy(connection->io);
+        connection->io = NULL;
+    }
+    else
+    {
+        perf_socket_close(connection->socket);
+    }
+
+    connection->socket = -1;
+    connection->is_closed = false;
+}
+
+static void accept_connections(FAKE_AMQP_HUB* hub)
+{
+    int accepted_socket;
+
+    while ((accepted_socket = perf_socket_accept(hub->listen_socket)) != -1)
+    {
+        AMQP_CONNECTION* connection = NULL;
+        size_t i;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket == -1)
+            {
+                connection = &hub->connections[i];
+                break;
+            }
+        }
+
+        if (connection == NULL)
+        {
+            LogError("Too many connections to the fake AMQP hub");
+            perf_socket_close(accepted_socket);
+        }
+        else
+        {
+            SOCKETIO_CONFIG socketio_config;
+
+            socketio_config.hostname = NULL;
+            socketio_config.port = 0;
+            socketio_config.accepted_socket = &accepted_socket;
+
+            connection->hub = hub;
+            connection->socket = accepted_socket;
+
+            if ((connection->io = xio_create(socketio_get_interface_description(), &socketio_config)) == NULL ||
+                (connection->connection = connection_create2(connection->io, NULL, CONTAINER_ID, on_new_endpoint, connection, on_connection_state_changed, connection, on_connection_io_error, connection)) == NULL ||
+                connection_listen(connection->connection) != 0)
+            {
+                LogError("Failed setting up AMQP connection for accepted socket");
+                destroy_connection(connection);
+            }
+        }
+    }
+}
+
+static void send_c2d_message(FAKE_AMQP_HUB* hub, PERF_FAKE_HUB_REQUEST* request)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        AMQP_LINK* link;
+
+        if (hub->connections[i].socket != -1 &&
+            (link = find_link(&hub->connections[i], AMQP_LINK_KIND_C2D, true, request->device_id)) != NULL)
+        {
+            MESSAGE_HANDLE message;
+            BINARY_DATA body;
+
+            body.bytes = request->payload;
+            body.length = request->size;
+
+            if ((message = message_create()) == NULL ||
+                message_add_body_amqp_data(message, body) != 0 ||
+                messagesender_send(link->message_sender, message, on_message_send_complete, NULL) != 0)
+            {
+                LogError("Failed sending cloud-to-device message to %s", request->device_id);
+            }
+
+            if (message != NULL)
+            {
+                message_destroy(message);
+            }
+        }
+    }
+}
+
+static void process_requests(FAKE_AMQP_HUB* hub)
+{
+    PERF_FAKE_HUB_REQUEST* request;
+
+    while ((request = perf_fake_hub_request_queue_pop(hub->requests)) != NULL)
+    {
+        if (request->type == PERF_FAKE_HUB_REQUEST_SEND_C2D)
+        {
+            send_c2d_message(hub, request);
+        }
+        else if (request->type == PERF_FAKE_HUB_REQUEST_DROP_CONNECTIONS)
+        {
+            size_t i;
+
+            for (i = 0; i < MAX_CONNECTIONS; i++)
+            {
+                if (hub->connections[i].socket != -1)
+                {
+                    destroy_connection(&hub->connections[i]);
+                }
+            }
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->drop_count++;
+                (void)Unlock(hub->lock);
+            }
+        }
+
+        perf_fake_hub_request_destroy(request);
+    }
+}
+
+static bool is_stopping(FAKE_AMQP_HUB* hub)
+{
+    bool result = true;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->is_stopping;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+static int fake_amqp_hub_thread(void* context)
+{
+    FAKE_AMQP_HUB* hub = (FAKE_AMQP_HUB*)context;
+
+    while (!is_stopping(hub))
+    {
+        struct pollfd poll_fds[MAX_CONNECTIONS + 2];
+        nfds_t poll_fd_count = 2;
+        nfds_t i;
+
+        poll_fds[0].fd = hub->wakeup[0];
+        poll_fds[0].events = POLLIN;
+        poll_fds[0].revents = 0;
+        poll_fds[1].fd = hub->listen_socket;
+        poll_fds[1].events = POLLIN;
+        poll_fds[1].revents = 0;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket != -1)
+            {
+                poll_fds[poll_fd_count].fd = hub->connections[i].socket;
+                poll_fds[poll_fd_count].events = POLLIN;
+                poll_fds[poll_fd_count].revents = 0;
+                poll_fd_count++;
+            }
+        }
+
+        // uAMQP I/O is driven by connection_dowork(); poll() only avoids spinning while the links are idle.
+        (void)poll(poll_fds, poll_fd_count, POLL_TIMEOUT_MS);
+
+        if (poll_fds[0].revents != 0)
+        {
+            perf_socket_drain_wakeup(hub->wakeup);
+        }
+
+        if (poll_fds[1].revents != 0)
+        {
+            accept_connections(hub);
+        }
+
+        process_requests(hub);
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            AMQP_CONNECTION* connection = &hub->connections[i];
+
+            if (connection->socket != -1)
+            {
+                connection_dowork(connection->connection);
+
+                if (connection->is_closed)
+                {
+                    destroy_connection(connection);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void fake_amqp_hub_destroy(PERF_FAKE_HUB_HANDLE handle)
+{
+    FAKE_AMQP_HUB* hub = (FAKE_AMQP_HUB*)handle;
+
+    if (hub != NULL)
+    {
+        size_t i;
+
+        if (hub->thread != NULL)
+        {
+            int thread_result;
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->is_stopping = true;
+                (void)Unlock(hub->lock);
+            }
+
+            perf_socket_signal_wakeup(hub->wakeup);
+            (void)ThreadAPI_Join(hub->thread, &thread_result);
+        }
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket != -1)
+            {
+                destroy_connection(&hub->connections[i]);
+            }
+        }
+
+        perf_fake_hub_request_queue_destroy(hub->requests);
+        perf_socket_close(hub->listen_socket);
+
+        if (hub->wakeup[0] != -1)
+        {
+            perf_socket_destroy_wakeup(hub->wakeup);
+        }
+
+        if (hub->lock != NULL)
+        {
+            (void)Lock_Deinit(hub->lock);
+        }
+
+        free(hub);
+    }
+}
+
+static PERF_FAKE_HUB_HANDLE fake_amqp_hub_create(void)
+{
+    FAKE_AMQP_HUB* result;
+
+    if ((result = (FAKE_AMQP_HUB*)malloc(sizeof(FAKE_AMQP_HUB))) == NULL)
+    {
+        LogError("Failed allocating fake AMQP hub");
+    }
+    else
+    {
+        size_t i;
+
+        memset(result, 0, sizeof(FAKE_AMQP_HUB));
+        result->listen_socket = -1;
+        result->wakeup[0] = -1;
+        result->wakeup[1] = -1;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            result->connections[i].socket = -1;
+        }
+
+        if ((result->lock = Lock_Init()) == NULL ||
+            (result->requests = perf_fake_hub_request_queue_create()) == NULL ||
+            perf_socket_create_wakeup(result->wakeup) != 0 ||
+            (result->listen_socket = perf_socket_listen(&result->port)) == -1)
+        {
+            LogError("Failed initializing fake AMQP hub");
+            fake_amqp_hub_destroy(result);
+            result = NULL;
+        }
+        else if (ThreadAPI_Create(&result->thread, fake_amqp_hub_thread, result) != THREADAPI_OK)
+        {
+            LogError("Failed starting fake AMQP hub thread");
+            result->thread = NULL;
+            fake_amqp_hub_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int fake_amqp_hub_get_port(PERF_FAKE_HUB_HANDLE handle)
+{
+    return ((FAKE_AMQP_HUB*)handle)->port;
+}
+
+static size_t fake_amqp_hub_get_d2c_message_count(PERF_FAKE_HUB_HANDLE handle)
+{
+    FAKE_AMQP_HUB* hub = (FAKE_AMQP_HUB*)handle;
+    size_t result = 0;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->d2c_message_count;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+static int queue_request(FAKE_AMQP_HUB* hub, PERF_FAKE_HUB_REQUEST* request)
+{
+    int result;
+
+    if (request == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else if (perf_fake_hub_request_queue_push(hub->requests, request) != 0)
+    {
+        perf_fake_hub_request_destroy(request);
+        result = __FAILURE__;
+    }
+    else
+    {
+        perf_socket_signal_wakeup(hub->wakeup);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int fake_amqp_hub_send_c2d_message(PERF_FAKE_HUB_HANDLE handle, const char* device_id, const unsigned char* payload, size_t size)
+{
+    return queue_request((FAKE_AMQP_HUB*)handle, perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_SEND_C2D, device_id, NULL, payload, size));
+}
+
+static size_t get_drop_count(FAKE_AMQP_HUB* hub)
+{
+    size_t result = 0;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->drop_count;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+// Returns once the hub thread has closed every connection, so callers can time the recovery from that point.
+static int fake_amqp_hub_drop_connections(PERF_FAKE_HUB_HANDLE handle)
+{
+    int result;
+    FAKE_AMQP_HUB* hub = (FAKE_AMQP_HUB*)handle;
+    size_t initial_drop_count = get_drop_count(hub);
+
+    if (queue_request(hub, perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_DROP_CONNECTIONS, NULL, NULL, NULL, 0)) != 0)
+    {
+        LogError("Failed queueing connection drop");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned int waited_ms = 0;
+
+        while (get_drop_count(hub) == initial_drop_count && waited_ms < DROP_WAIT_TIMEOUT_MS)
+        {
+            ThreadAPI_Sleep(1);
+            waited_ms++;
+        }
+
+        if (waited_ms >= DROP_WAIT_TIMEOUT_MS)
+        {
+            LogError("Timed out waiting for connections to be dropped");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static const PERF_FAKE_HUB_INTERFACE fake_amqp_hub_interface =
+{
+    fake_amqp_hub_create,
+    fake_amqp_hub_destroy,
+    fake_amqp_hub_get_port,
+    fake_amqp_hub_get_d2c_message_count,
+    fake_amqp_hub_send_c2d_message,
+    NULL,
+    fake_amqp_hub_drop_connections
+};
+
+const PERF_FAKE_HUB_INTERFACE* perf_fake_amqp_hub_get_interface(void)
+{
+    return &fake_amqp_hub_interface;
+}
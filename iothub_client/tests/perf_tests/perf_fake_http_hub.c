@@ -0,0 +1,726 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+
+#include "perf_fake_hub.h"
+#include "perf_fake_hub_request.h"
+#include "perf_socket.h"
+
+// A minimal HTTP/1.1 server answering the requests made by iothubtransporthttp.c (events and devicebound
+// endpoints). Connections are kept alive; TLS and the Authorization header are not checked.
+// Cloud-to-device messages are handed out on the next GET of the devicebound endpoint, one per request.
+
+#define MAX_CONNECTIONS                 16
+#define POLL_TIMEOUT_MS                 100
+#define DROP_WAIT_TIMEOUT_MS            5000
+#define RECEIVE_CHUNK_SIZE              4096
+#define RESPONSE_HEADER_BUFFER_SIZE     512
+
+static const char* HEADER_TERMINATOR = "\r\n\r\n";
+static const char* CONTENT_LENGTH_HEADER = "Content-Length:";
+static const char* CONTENT_TYPE_HEADER = "Content-Type:";
+static const char* BATCH_CONTENT_TYPE = "application/vnd.microsoft.iothub.json";
+static const char* BATCH_ITEM_MARKER = "\"body\"";
+static const char* DEVICES_PATH_PREFIX = "/devices/";
+static const char* EVENTS_PATH_SEGMENT = "/messages/events";
+static const char* DEVICEBOUND_PATH_SEGMENT = "/messages/devicebound";
+
+typedef struct HTTP_CONNECTION_TAG
+{
+    int socket;
+    unsigned char* receive_buffer;
+    size_t receive_buffer_size;
+    size_t received;
+} HTTP_CONNECTION;
+
+typedef struct FAKE_HTTP_HUB_TAG
+{
+    int listen_socket;
+    int port;
+    int wakeup[2];
+    THREAD_HANDLE thread;
+    PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE requests;
+
+    // Guarded by `lock`.
+    LOCK_HANDLE lock;
+    bool is_stopping;
+    size_t d2c_message_count;
+    size_t drop_count;
+
+    // Only touched by the hub thread.
+    HTTP_CONNECTION connections[MAX_CONNECTIONS];
+    SINGLYLINKEDLIST_HANDLE pending_c2d_messages;
+    unsigned long next_etag;
+} FAKE_HTTP_HUB;
+
+static void close_connection(HTTP_CONNECTION* connection)
+{
+    if (connection->socket != -1)
+    {
+        (void)shutdown(connection->socket, SHUT_RDWR);
+        perf_socket_close(connection->socket);
+        connection->socket = -1;
+    }
+
+    free(connection->receive_buffer);
+    connection->receive_buffer = NULL;
+    connection->receive_buffer_size = 0;
+    connection->received = 0;
+}
+
+static const char* find_bytes(const unsigned char* buffer, size_t size, const char* pattern)
+{
+    const char* result = NULL;
+    size_t pattern_length = strlen(pattern);
+    size_t i;
+
+    for (i = 0; i + pattern_length <= size; i++)
+    {
+        if (memcmp(buffer + i, pattern, pattern_length) == 0)
+        {
+            result = (const char*)buffer + i;
+            break;
+        }
+    }
+
+    return result;
+}
+
+// Returns the value of header `name` (case-insensitive) within the header block, or NULL.
+static const char* find_header_value(const char* headers, size_t headers_size, const char* name)
+{
+    const char* result = NULL;
+    const char* line = headers;
+    const char* end = headers + headers_size;
+    size_t name_length = strlen(name);
+
+    while (line < end)
+    {
+        const char* line_end = find_bytes((const unsigned char*)line, (size_t)(end - line), "\r\n");
+
+        if (line_end == NULL)
+        {
+            line_end = end;
+        }
+
+        if ((size_t)(line_end - line) > name_length && strncasecmp(line, name, name_length) == 0)
+        {
+            result = line + name_length;
+            while (*result == ' ')
+            {
+                result++;
+            }
+            break;
+        }
+
+        line = line_end + 2;
+    }
+
+    return result;
+}
+
+static size_t count_batch_items(const unsigned char* body, size_t size)
+{
+    size_t result = 0;
+    const char* item;
+
+    while ((item = find_bytes(body, size, BATCH_ITEM_MARKER)) != NULL)
+    {
+        size_t offset = (size_t)((const unsigned char*)item - body) + strlen(BATCH_ITEM_MARKER);
+        body += offset;
+        size -= offset;
+        result++;
+    }
+
+    return result;
+}
+
+static int send_response(HTTP_CONNECTION* connection, int status_code, const char* reason, const char* extra_headers, const unsigned char* body, size_t body_size)
+{
+    int result;
+    char header[RESPONSE_HEADER_BUFFER_SIZE];
+    int header_length = snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\n%sContent-Length: %lu\r\n\r\n",
+        status_code, reason, (extra_headers == NULL) ? "" : extra_headers, (unsigned long)body_size);
+
+    if (header_length < 0 || (size_t)header_length >= sizeof(header))
+    {
+        LogError("HTTP response header too long");
+        result = __FAILURE__;
+    }
+    else if (perf_socket_send_all(connection->socket, (const unsigned char*)header, (size_t)header_length) != 0 ||
+        (body_size > 0 && perf_socket_send_all(connection->socket, body, body_size) != 0))
+    {
+        LogError("Failed sending HTTP response");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static bool is_device_path(const char* path, size_t path_length, const char* device_id)
+{
+    size_t prefix_length = strlen(DEVICES_PATH_PREFIX);
+    size_t device_id_length = strlen(device_id);
+
+    return path_length > prefix_length + device_id_length &&
+        memcmp(path, DEVICES_PATH_PREFIX, prefix_length) == 0 &&
+        memcmp(path + prefix_length, device_id, device_id_length) == 0 &&
+        path[prefix_length + device_id_length] == '/';
+}
+
+static bool find_c2d_message_for_path(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const PERF_FAKE_HUB_REQUEST* request = (const PERF_FAKE_HUB_REQUEST*)singlylinkedlist_item_get_value(list_item);
+    const char* path = (const char*)match_context;
+
+    return is_device_path(path, strcspn(path, " ?"), request->device_id);
+}
+
+static int process_get_devicebound(FAKE_HTTP_HUB* hub, HTTP_CONNECTION* connection, const char* path)
+{
+    int result;
+    LIST_ITEM_HANDLE list_item = singlylinkedlist_find(hub->pending_c2d_messages, find_c2d_message_for_path, path);
+
+    if (list_item == NULL)
+    {
+        result = send_response(connection, 204, "No Content", NULL, NULL, 0);
+    }
+    else
+    {
+        PERF_FAKE_HUB_REQUEST* request = (PERF_FAKE_HUB_REQUEST*)singlylinkedlist_item_get_value(list_item);
+        char headers[128];
+        unsigned long etag = hub->next_etag++;
+
+        (void)snprintf(headers, sizeof(headers), "ETag: \"%lu\"\r\niothub-messageid: perf-%lu\r\n", etag, etag);
+        result = send_response(connection, 200, "OK", headers, request->payload, request->size);
+
+        (void)singlylinkedlist_remove(hub->pending_c2d_messages, list_item);
+        perf_fake_hub_request_destroy(request);
+    }
+
+    return result;
+}
+
+static int process_request(FAKE_HTTP_HUB* hub, HTTP_CONNECTION* connection, const char* headers, size_t headers_size, const unsigned char* body, size_t body_size)
+{
+    int result;
+    const char* path = strchr(headers, ' ');
+
+    if (path == NULL || (size_t)(path - headers) >= headers_size)
+    {
+        LogError("Malformed HTTP request line");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t method_length = (size_t)(path - headers);
+        size_t path_length;
+
+        path++;
+        path_length = strcspn(path, " ?");
+
+        if (method_length == 4 && strncmp(headers, "POST", 4) == 0 && find_bytes((const unsigned char*)path, path_length, EVENTS_PATH_SEGMENT) != NULL)
+        {
+            const char* content_type = find_header_value(headers, headers_size, CONTENT_TYPE_HEADER);
+            size_t message_count = 1;
+
+            if (content_type != NULL && strncmp(content_type, BATCH_CONTENT_TYPE, strlen(BATCH_CONTENT_TYPE)) == 0)
+            {
+                message_count = count_batch_items(body, body_size);
+            }
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->d2c_message_count += message_count;
+                (void)Unlock(hub->lock);
+            }
+
+            result = send_response(connection, 204, "No Content", NULL, NULL, 0);
+        }
+        else if (method_length == 3 && strncmp(headers, "GET", 3) == 0 && find_bytes((const unsigned char*)path, path_length, DEVICEBOUND_PATH_SEGMENT) != NULL)
+        {
+            result = process_get_devicebound(hub, connection, path);
+        }
+        else if (find_bytes((const unsigned char*)path, path_length, DEVICEBOUND_PATH_SEGMENT) != NULL)
+        {
+            // Complete (DELETE), reject (DELETE ...&reject) or abandon (POST .../abandon) of a cloud-to-device message.
+            result = send_response(connection, 204, "No Content", NULL, NULL, 0);
+        }
+        else
+        {
+            LogError("Unexpected HTTP request (%.*s)", (int)(method_length + 1 + path_length), headers);
+            result = send_response(connection, 404, "Not Found", NULL, NULL, 0);
+        }
+    }
+
+    return result;
+}
+
+static int receive_from_connection(FAKE_HTTP_HUB* hub, HTTP_CONNECTION* connection)
+{
+    int result = 0;
+
+    while (result == 0)
+    {
+        ssize_t received;
+
+        // One spare byte keeps the header block NUL-terminated for the string functions above.
+        if (connection->receive_buffer_size - connection->received < RECEIVE_CHUNK_SIZE + 1)
+        {
+            unsigned char* new_buffer = (unsigned char*)realloc(connection->receive_buffer, connection->receive_buffer_size + RECEIVE_CHUNK_SIZE + 1);
+
+            if (new_buffer == NULL)
+            {
+                LogError("Failed growing HTTP receive buffer");
+                result = __FAILURE__;
+                break;
+            }
+
+            connection->receive_buffer = new_buffer;
+            connection->receive_buffer_size += RECEIVE_CHUNK_SIZE + 1;
+        }
+
+        received = recv(connection->socket, connection->receive_buffer + connection->received, connection->receive_buffer_size - connection->received - 1, 0);
+
+        if (received == 0)
+        {
+            result = __FAILURE__;
+        }
+        else if (received < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                result = __FAILURE__;
+            }
+            break;
+        }
+        else
+        {
+            size_t consumed = 0;
+
+            connection->received += (size_t)received;
+
+            while (result == 0)
+            {
+                unsigned char* request = connection->receive_buffer + consumed;
+                size_t available = connection->received - consumed;
+                const char* header_end = find_bytes(request, available, HEADER_TERMINATOR);
+
+                if (header_end == NULL)
+                {
+                    break;
+                }
+                else
+                {
+                    size_t headers_size = (size_t)((const unsigned char*)header_end - request) + strlen(HEADER_TERMINATOR);
+                    const char* content_length;
+                    size_t body_size;
+                    char saved_byte;
+
+                    // Terminate the header block in place while it is parsed.
+                    saved_byte = (char)request[headers_size];
+                    request[headers_size] = '\0';
+
+                    content_length = find_header_value((const char*)request, headers_size, CONTENT_LENGTH_HEADER);
+                    body_size = (content_length == NULL) ? 0 : (size_t)strtoul(content_length, NULL, 10);
+
+                    if (available < headers_size + body_size)
+                    {
+                        request[headers_size] = (unsigned char)saved_byte;
+                        break;
+                    }
+                    else
+                    {
+                        request[headers_size] = (unsigned char)saved_byte;
+                        result = process_request(hub, connection, (const char*)request, headers_size, request + headers_size, body_size);
+                        consumed += headers_size + body_size;
+                    }
+                }
+            }
+
+            if (consumed > 0)
+            {
+                (void)memmove(connection->receive_buffer, connection->receive_buffer + consumed, connection->received - consumed);
+                connection->received -= consumed;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void accept_connections(FAKE_HTTP_HUB* hub)
+{
+    int accepted_socket;
+
+    while ((accepted_socket = perf_socket_accept(hub->listen_socket)) != -1)
+    {
+        size_t i;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket == -1)
+            {
+                hub->connections[i].socket = accepted_socket;
+                break;
+            }
+        }
+
+        if (i == MAX_CONNECTIONS)
+        {
+            LogError("Too many connections to the fake HTTP hub");
+            perf_socket_close(accepted_socket);
+        }
+    }
+}
+
+static void process_requests(FAKE_HTTP_HUB* hub)
+{
+    PERF_FAKE_HUB_REQUEST* request;
+
+    while ((request = perf_fake_hub_request_queue_pop(hub->requests)) != NULL)
+    {
+        if (request->type == PERF_FAKE_HUB_REQUEST_SEND_C2D)
+        {
+            if (singlylinkedlist_add(hub->pending_c2d_messages, request) == NULL)
+            {
+                LogError("Failed queueing cloud-to-device message for %s", request->device_id);
+                perf_fake_hub_request_destroy(request);
+            }
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < MAX_CONNECTIONS; i++)
+            {
+                close_connection(&hub->connections[i]);
+            }
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->drop_count++;
+                (void)Unlock(hub->lock);
+            }
+
+            perf_fake_hub_request_destroy(request);
+        }
+    }
+}
+
+static bool is_stopping(FAKE_HTTP_HUB* hub)
+{
+    bool result = true;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->is_stopping;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+static int fake_http_hub_thread(void* context)
+{
+    FAKE_HTTP_HUB* hub = (FAKE_HTTP_HUB*)context;
+
+    while (!is_stopping(hub))
+    {
+        struct pollfd poll_fds[MAX_CONNECTIONS + 2];
+        size_t connection_index[MAX_CONNECTIONS + 2];
+        nfds_t poll_fd_count = 2;
+        nfds_t i;
+
+        poll_fds[0].fd = hub->wakeup[0];
+        poll_fds[0].events = POLLIN;
+        poll_fds[1].fd = hub->listen_socket;
+        poll_fds[1].events = POLLIN;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket != -1)
+            {
+                poll_fds[poll_fd_count].fd = hub->connections[i].socket;
+                poll_fds[poll_fd_count].events = POLLIN;
+                connection_index[poll_fd_count] = i;
+                poll_fd_count++;
+            }
+        }
+
+        for (i = 0; i < poll_fd_count; i++)
+        {
+            poll_fds[i].revents = 0;
+        }
+
+        // Requests are applied before reading so a queued cloud-to-device message is visible to the next GET.
+        if (poll(poll_fds, poll_fd_count, POLL_TIMEOUT_MS) > 0)
+        {
+            if (poll_fds[0].revents != 0)
+            {
+                perf_socket_drain_wakeup(hub->wakeup);
+            }
+
+            process_requests(hub);
+
+            if (poll_fds[1].revents != 0)
+            {
+                accept_connections(hub);
+            }
+
+            for (i = 2; i < poll_fd_count; i++)
+            {
+                HTTP_CONNECTION* connection = &hub->connections[connection_index[i]];
+
+                if (poll_fds[i].revents != 0 && connection->socket != -1)
+                {
+                    if (receive_from_connection(hub, connection) != 0)
+                    {
+                        close_connection(connection);
+                    }
+                }
+            }
+        }
+        else
+        {
+            process_requests(hub);
+        }
+    }
+
+    return 0;
+}
+
+static void fake_http_hub_destroy(PERF_FAKE_HUB_HANDLE handle)
+{
+    FAKE_HTTP_HUB* hub = (FAKE_HTTP_HUB*)handle;
+
+    if (hub != NULL)
+    {
+        size_t i;
+
+        if (hub->thread != NULL)
+        {
+            int thread_result;
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->is_stopping = true;
+                (void)Unlock(hub->lock);
+            }
+
+            perf_socket_signal_wakeup(hub->wakeup);
+            (void)ThreadAPI_Join(hub->thread, &thread_result);
+        }
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            close_connection(&hub->connections[i]);
+        }
+
+        if (hub->pending_c2d_messages != NULL)
+        {
+            LIST_ITEM_HANDLE list_item;
+
+            while ((list_item = singlylinkedlist_get_head_item(hub->pending_c2d_messages)) != NULL)
+            {
+                perf_fake_hub_request_destroy((PERF_FAKE_HUB_REQUEST*)singlylinkedlist_item_get_value(list_item));
+                (void)singlylinkedlist_remove(hub->pending_c2d_messages, list_item);
+            }
+
+            singlylinkedlist_destroy(hub->pending_c2d_messages);
+        }
+
+        perf_fake_hub_request_queue_destroy(hub->requests);
+        perf_socket_close(hub->listen_socket);
+
+        if (hub->wakeup[0] != -1)
+        {
+            perf_socket_destroy_wakeup(hub->wakeup);
+        }
+
+        if (hub->lock != NULL)
+        {
+            (void)Lock_Deinit(hub->lock);
+        }
+
+        free(hub);
+    }
+}
+
+static PERF_FAKE_HUB_HANDLE fake_http_hub_create(void)
+{
+    FAKE_HTTP_HUB* result;
+
+    if ((result = (FAKE_HTTP_HUB*)malloc(sizeof(FAKE_HTTP_HUB))) == NULL)
+    {
+        LogError("Failed allocating fake HTTP hub");
+    }
+    else
+    {
+        size_t i;
+
+        memset(result, 0, sizeof(FAKE_HTTP_HUB));
+        result->listen_socket = -1;
+        result->wakeup[0] = -1;
+        result->wakeup[1] = -1;
+        result->next_etag = 1;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            result->connections[i].socket = -1;
+        }
+
+        if ((result->lock = Lock_Init()) == NULL ||
+            (result->requests = perf_fake_hub_request_queue_create()) == NULL ||
+            (result->pending_c2d_messages = singlylinkedlist_create()) == NULL ||
+            perf_socket_create_wakeup(result->wakeup) != 0 ||
+            (result->listen_socket = perf_socket_listen(&result->port)) == -1)
+        {
+            LogError("Failed initializing fake HTTP hub");
+            fake_http_hub_destroy(result);
+            result = NULL;
+        }
+        else if (ThreadAPI_Create(&result->thread, fake_http_hub_thread, result) != THREADAPI_OK)
+        {
+            LogError("Failed starting fake HTTP hub thread");
+            result->thread = NULL;
+            fake_http_hub_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int fake_http_hub_get_port(PERF_FAKE_HUB_HANDLE handle)
+{
+    return ((FAKE_HTTP_HUB*)handle)->port;
+}
+
+static size_t fake_http_hub_get_d2c_message_count(PERF_FAKE_HUB_HANDLE handle)
+{
+    FAKE_HTTP_HUB* hub = (FAKE_HTTP_HUB*)handle;
+    size_t result = 0;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->d2c_message_count;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+static int queue_request(FAKE_HTTP_HUB* hub, PERF_FAKE_HUB_REQUEST* request)
+{
+    int result;
+
+    if (request == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else if (perf_fake_hub_request_queue_push(hub->requests, request) != 0)
+    {
+        perf_fake_hub_request_destroy(request);
+        result = __FAILURE__;
+    }
+    else
+    {
+        perf_socket_signal_wakeup(hub->wakeup);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int fake_http_hub_send_c2d_message(PERF_FAKE_HUB_HANDLE handle, const char* device_id, const unsigned char* payload, size_t size)
+{
+    return queue_request((FAKE_HTTP_HUB*)handle, perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_SEND_C2D, device_id, NULL, payload, size));
+}
+
+static size_t get_drop_count(FAKE_HTTP_HUB* hub)
+{
+    size_t result = 0;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->drop_count;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+// Returns once the hub thread has closed every connection, so callers can time the recovery from that point.
+static int fake_http_hub_drop_connections(PERF_FAKE_HUB_HANDLE handle)
+{
+    int result;
+    FAKE_HTTP_HUB* hub = (FAKE_HTTP_HUB*)handle;
+    size_t initial_drop_count = get_drop_count(hub);
+
+    if (queue_request(hub, perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_DROP_CONNECTIONS, NULL, NULL, NULL, 0)) != 0)
+    {
+        LogError("Failed queueing connection drop");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned int waited_ms = 0;
+
+        while (get_drop_count(hub) == initial_drop_count && waited_ms < DROP_WAIT_TIMEOUT_MS)
+        {
+            ThreadAPI_Sleep(1);
+            waited_ms++;
+        }
+
+        if (waited_ms >= DROP_WAIT_TIMEOUT_MS)
+        {
+            LogError("Timed out waiting for connections to be dropped");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+// Device methods and twin are not available over HTTP.
+static const PERF_FAKE_HUB_INTERFACE fake_http_hub_interface =
+{
+    fake_http_hub_create,
+    fake_http_hub_destroy,
+    fake_http_hub_get_port,
+    fake_http_hub_get_d2c_message_count,
+    fake_http_hub_send_c2d_message,
+    NULL,
+    fake_http_hub_drop_connections
+};
+
+const PERF_FAKE_HUB_INTERFACE* perf_fake_http_hub_get_interface(void)
+{
+    return &fake_http_hub_interface;
+}
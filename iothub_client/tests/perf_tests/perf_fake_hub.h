@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_FAKE_HUB_H
+#define PERF_FAKE_HUB_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// An in-process stand-in for the IoT Hub service side of one protocol. Each fake hub listens on an
+// ephemeral loopback port and runs its own worker thread, so the client under test is driven exactly
+// as it would be against a remote hub. All functions below are safe to call from the benchmark thread.
+typedef void* PERF_FAKE_HUB_HANDLE;
+
+// Invoked on the fake hub thread when the device answers a method request.
+typedef void(*PERF_ON_METHOD_RESPONSE)(void* context, int status, const unsigned char* payload, size_t size);
+
+typedef PERF_FAKE_HUB_HANDLE(*pfPerfFakeHub_Create)(void);
+typedef void(*pfPerfFakeHub_Destroy)(PERF_FAKE_HUB_HANDLE handle);
+typedef int(*pfPerfFakeHub_GetPort)(PERF_FAKE_HUB_HANDLE handle);
+typedef size_t(*pfPerfFakeHub_GetD2CMessageCount)(PERF_FAKE_HUB_HANDLE handle);
+typedef int(*pfPerfFakeHub_SendC2DMessage)(PERF_FAKE_HUB_HANDLE handle, const char* device_id, const unsigned char* payload, size_t size);
+typedef int(*pfPerfFakeHub_InvokeMethod)(PERF_FAKE_HUB_HANDLE handle, const char* device_id, const char* method_name, const unsigned char* payload, size_t size, PERF_ON_METHOD_RESPONSE on_method_response, void* context);
+typedef int(*pfPerfFakeHub_DropConnections)(PERF_FAKE_HUB_HANDLE handle);
+
+// Operations a protocol cannot carry (e.g. methods over HTTP) are left NULL and the matching benchmarks are skipped.
+typedef struct PERF_FAKE_HUB_INTERFACE_TAG
+{
+    pfPerfFakeHub_Create create;
+    pfPerfFakeHub_Destroy destroy;
+    pfPerfFakeHub_GetPort get_port;
+    pfPerfFakeHub_GetD2CMessageCount get_d2c_message_count;
+    pfPerfFakeHub_SendC2DMessage send_c2d_message;
+    pfPerfFakeHub_InvokeMethod invoke_method;
+    pfPerfFakeHub_DropConnections drop_connections;
+} PERF_FAKE_HUB_INTERFACE;
+
+extern const PERF_FAKE_HUB_INTERFACE* perf_fake_mqtt_hub_get_interface(void);
+extern const PERF_FAKE_HUB_INTERFACE* perf_fake_amqp_hub_get_interface(void);
+extern const PERF_FAKE_HUB_INTERFACE* perf_fake_http_hub_get_interface(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_FAKE_HUB_H */
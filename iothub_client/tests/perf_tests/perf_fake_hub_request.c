@@ -0,0 +1,185 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+
+#include "perf_fake_hub_request.h"
+
+DEFINE_ENUM_STRINGS(PERF_FAKE_HUB_REQUEST_TYPE, PERF_FAKE_HUB_REQUEST_TYPE_VALUES);
+
+typedef struct PERF_FAKE_HUB_REQUEST_QUEUE_TAG
+{
+    LOCK_HANDLE lock;
+    SINGLYLINKEDLIST_HANDLE requests;
+} PERF_FAKE_HUB_REQUEST_QUEUE;
+
+PERF_FAKE_HUB_REQUEST* perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_TYPE type, const char* device_id, const char* method_name, const unsigned char* payload, size_t size)
+{
+    PERF_FAKE_HUB_REQUEST* result;
+
+    if ((result = (PERF_FAKE_HUB_REQUEST*)malloc(sizeof(PERF_FAKE_HUB_REQUEST))) == NULL)
+    {
+        LogError("Failed allocating fake hub request (%s)", ENUM_TO_STRING(PERF_FAKE_HUB_REQUEST_TYPE, type));
+    }
+    else
+    {
+        memset(result, 0, sizeof(PERF_FAKE_HUB_REQUEST));
+        result->type = type;
+
+        if (device_id != NULL && mallocAndStrcpy_s(&result->device_id, device_id) != 0)
+        {
+            LogError("Failed copying device id of fake hub request");
+            perf_fake_hub_request_destroy(result);
+            result = NULL;
+        }
+        else if (method_name != NULL && mallocAndStrcpy_s(&result->method_name, method_name) != 0)
+        {
+            LogError("Failed copying method name of fake hub request");
+            perf_fake_hub_request_destroy(result);
+            result = NULL;
+        }
+        else if (payload != NULL && size > 0)
+        {
+            if ((result->payload = (unsigned char*)malloc(size)) == NULL)
+            {
+                LogError("Failed copying payload of fake hub request");
+                perf_fake_hub_request_destroy(result);
+                result = NULL;
+            }
+            else
+            {
+                (void)memcpy(result->payload, payload, size);
+                result->size = size;
+            }
+        }
+    }
+
+    return result;
+}
+
+void perf_fake_hub_request_destroy(PERF_FAKE_HUB_REQUEST* request)
+{
+    if (request != NULL)
+    {
+        free(request->device_id);
+        free(request->method_name);
+        free(request->payload);
+        free(request);
+    }
+}
+
+PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE perf_fake_hub_request_queue_create(void)
+{
+    PERF_FAKE_HUB_REQUEST_QUEUE* result;
+
+    if ((result = (PERF_FAKE_HUB_REQUEST_QUEUE*)malloc(sizeof(PERF_FAKE_HUB_REQUEST_QUEUE))) == NULL)
+    {
+        LogError("Failed allocating fake hub request queue");
+    }
+    else if ((result->lock = Lock_Init()) == NULL)
+    {
+        LogError("Failed creating fake hub request queue lock");
+        free(result);
+        result = NULL;
+    }
+    else if ((result->requests = singlylinkedlist_create()) == NULL)
+    {
+        LogError("Failed creating fake hub request list");
+        (void)Lock_Deinit(result->lock);
+        free(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+int perf_fake_hub_request_queue_push(PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE queue, PERF_FAKE_HUB_REQUEST* request)
+{
+    int result;
+
+    if (queue == NULL || request == NULL)
+    {
+        LogError("Invalid argument (queue=%p, request=%p)", queue, request);
+        result = __FAILURE__;
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Failed locking fake hub request queue");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (singlylinkedlist_add(queue->requests, request) == NULL)
+        {
+            LogError("Failed queueing fake hub request (%s)", ENUM_TO_STRING(PERF_FAKE_HUB_REQUEST_TYPE, request->type));
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        (void)Unlock(queue->lock);
+    }
+
+    return result;
+}
+
+PERF_FAKE_HUB_REQUEST* perf_fake_hub_request_queue_pop(PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE queue)
+{
+    PERF_FAKE_HUB_REQUEST* result;
+
+    if (queue == NULL)
+    {
+        LogError("Invalid argument (queue is NULL)");
+        result = NULL;
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Failed locking fake hub request queue");
+        result = NULL;
+    }
+    else
+    {
+        LIST_ITEM_HANDLE head = singlylinkedlist_get_head_item(queue->requests);
+
+        if (head == NULL)
+        {
+            result = NULL;
+        }
+        else
+        {
+            result = (PERF_FAKE_HUB_REQUEST*)singlylinkedlist_item_get_value(head);
+            (void)singlylinkedlist_remove(queue->requests, head);
+        }
+
+        (void)Unlock(queue->lock);
+    }
+
+    return result;
+}
+
+void perf_fake_hub_request_queue_destroy(PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE queue)
+{
+    if (queue != NULL)
+    {
+        PERF_FAKE_HUB_REQUEST* request;
+
+        while ((request = perf_fake_hub_request_queue_pop(queue)) != NULL)
+        {
+            perf_fake_hub_request_destroy(request);
+        }
+
+        singlylinkedlist_destroy(queue->requests);
+        (void)Lock_Deinit(queue->lock);
+        free(queue);
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_FAKE_HUB_REQUEST_H
+#define PERF_FAKE_HUB_REQUEST_H
+
+#include <stddef.h>
+#include "azure_c_shared_utility/macro_utils.h"
+#include "perf_fake_hub.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Work handed from the benchmark thread to a fake hub thread.
+#define PERF_FAKE_HUB_REQUEST_TYPE_VALUES \
+    PERF_FAKE_HUB_REQUEST_SEND_C2D,       \
+    PERF_FAKE_HUB_REQUEST_INVOKE_METHOD,  \
+    PERF_FAKE_HUB_REQUEST_DROP_CONNECTIONS
+
+DEFINE_ENUM(PERF_FAKE_HUB_REQUEST_TYPE, PERF_FAKE_HUB_REQUEST_TYPE_VALUES);
+
+typedef struct PERF_FAKE_HUB_REQUEST_TAG
+{
+    PERF_FAKE_HUB_REQUEST_TYPE type;
+    char* device_id;
+    char* method_name;
+    unsigned char* payload;
+    size_t size;
+    PERF_ON_METHOD_RESPONSE on_method_response;
+    void* on_method_response_context;
+} PERF_FAKE_HUB_REQUEST;
+
+typedef struct PERF_FAKE_HUB_REQUEST_QUEUE_TAG* PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE;
+
+// `device_id`, `method_name` and `payload` are copied and may be NULL.
+extern PERF_FAKE_HUB_REQUEST* perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_TYPE type, const char* device_id, const char* method_name, const unsigned char* payload, size_t size);
+extern void perf_fake_hub_request_destroy(PERF_FAKE_HUB_REQUEST* request);
+
+// Thread-safe FIFO of requests; the queue owns requests pushed into it until they are popped.
+extern PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE perf_fake_hub_request_queue_create(void);
+extern int perf_fake_hub_request_queue_push(PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE queue, PERF_FAKE_HUB_REQUEST* request);
+// Returns NULL when the queue is empty.
+extern PERF_FAKE_HUB_REQUEST* perf_fake_hub_request_queue_pop(PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE queue);
+extern void perf_fake_hub_request_queue_destroy(PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_FAKE_HUB_REQUEST_H */
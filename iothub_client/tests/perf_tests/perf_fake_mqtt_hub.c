@@ -0,0 +1,1063 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+
+#include "perf_fake_hub.h"
+#include "perf_fake_hub_request.h"
+#include "perf_socket.h"
+
+// A minimal MQTT 3.1.1 broker that speaks the IoT Hub topic conventions used by iothubtransport_mqtt_common.c.
+// Authentication is not verified (the benchmarks connect as x509 devices) and there is no TLS.
+
+#define MAX_CONNECTIONS                 16
+#define POLL_TIMEOUT_MS                 100
+#define DROP_WAIT_TIMEOUT_MS            5000
+#define RECEIVE_CHUNK_SIZE              4096
+#define MAX_REMAINING_LENGTH_BYTES      4
+#define REQUEST_ID_BUFFER_SIZE          32
+
+#define MQTT_PACKET_TYPE_MASK           0xF0
+#define MQTT_CONNECT                    0x10
+#define MQTT_CONNACK                    0x20
+#define MQTT_PUBLISH                    0x30
+#define MQTT_PUBACK                     0x40
+#define MQTT_SUBSCRIBE                  0x80
+#define MQTT_SUBACK                     0x90
+#define MQTT_UNSUBSCRIBE                0xA0
+#define MQTT_UNSUBACK                   0xB0
+#define MQTT_PINGREQ                    0xC0
+#define MQTT_PINGRESP                   0xD0
+#define MQTT_DISCONNECT                 0xE0
+
+#define MQTT_QOS_AT_MOST_ONCE           0
+#define MQTT_QOS_AT_LEAST_ONCE          1
+
+static const char* DEVICE_EVENTS_TOPIC_SEGMENT = "/messages/events";
+static const char* C2D_TOPIC_FORMAT = "devices/%s/messages/devicebound/";
+static const char* TWIN_TOPIC_PREFIX = "$iothub/twin/";
+static const char* TWIN_GET_TOPIC_PREFIX = "$iothub/twin/GET/";
+static const char* TWIN_PATCH_REPORTED_TOPIC_PREFIX = "$iothub/twin/PATCH/properties/reported/";
+static const char* TWIN_GET_RESPONSE_TOPIC_FORMAT = "$iothub/twin/res/200/?$rid=%s";
+static const char* TWIN_PATCH_RESPONSE_TOPIC_FORMAT = "$iothub/twin/res/204/?$rid=%s&$version=%lu";
+static const char* METHOD_REQUEST_TOPIC_FORMAT = "$iothub/methods/POST/%s/?$rid=%x";
+static const char* METHOD_RESPONSE_TOPIC_PREFIX = "$iothub/methods/res/";
+static const char* REQUEST_ID_PROPERTY = "$rid=";
+static const char* TWIN_DOCUMENT = "{\"desired\":{\"$version\":1},\"reported\":{\"$version\":1}}";
+
+typedef struct MQTT_CONNECTION_TAG
+{
+    int socket;
+    char* device_id;
+    unsigned char* receive_buffer;
+    size_t receive_buffer_size;
+    size_t received;
+    uint16_t next_packet_id;
+} MQTT_CONNECTION;
+
+typedef struct PENDING_METHOD_TAG
+{
+    unsigned int request_id;
+    PERF_ON_METHOD_RESPONSE on_method_response;
+    void* context;
+} PENDING_METHOD;
+
+typedef struct FAKE_MQTT_HUB_TAG
+{
+    int listen_socket;
+    int port;
+    int wakeup[2];
+    THREAD_HANDLE thread;
+    PERF_FAKE_HUB_REQUEST_QUEUE_HANDLE requests;
+
+    // Guarded by `lock`.
+    LOCK_HANDLE lock;
+    bool is_stopping;
+    size_t d2c_message_count;
+    size_t drop_count;
+
+    // Only touched by the hub thread.
+    MQTT_CONNECTION connections[MAX_CONNECTIONS];
+    SINGLYLINKEDLIST_HANDLE pending_methods;
+    unsigned int next_method_request_id;
+    unsigned long twin_version;
+} FAKE_MQTT_HUB;
+
+static uint16_t read_uint16(const unsigned char* buffer)
+{
+    return (uint16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static size_t encode_remaining_length(unsigned char* buffer, size_t length)
+{
+    size_t index = 0;
+
+    do
+    {
+        unsigned char encoded_byte = (unsigned char)(length % 128);
+        length /= 128;
+        if (length > 0)
+        {
+            encoded_byte |= 0x80;
+        }
+        buffer[index++] = encoded_byte;
+    } while (length > 0 && index < MAX_REMAINING_LENGTH_BYTES);
+
+    return index;
+}
+
+// Returns 1 and sets `length`/`header_size` if the fixed header is complete, 0 if more bytes are needed, -1 if malformed.
+static int decode_fixed_header(const unsigned char* buffer, size_t size, size_t* length, size_t* header_size)
+{
+    int result = 0;
+    size_t multiplier = 1;
+    size_t index = 1;
+
+    *length = 0;
+
+    while (index < size)
+    {
+        unsigned char encoded_byte = buffer[index];
+        *length += (encoded_byte & 0x7F) * multiplier;
+        multiplier *= 128;
+        index++;
+
+        if ((encoded_byte & 0x80) == 0)
+        {
+            *header_size = index;
+            result = 1;
+            break;
+        }
+        else if (index > MAX_REMAINING_LENGTH_BYTES)
+        {
+            result = -1;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int send_packet(MQTT_CONNECTION* connection, unsigned char header, const unsigned char* variable_part, size_t variable_part_size, const unsigned char* payload, size_t payload_size)
+{
+    int result;
+    size_t remaining_length = variable_part_size + payload_size;
+    unsigned char* packet;
+
+    if ((packet = (unsigned char*)malloc(1 + MAX_REMAINING_LENGTH_BYTES + remaining_length)) == NULL)
+    {
+        LogError("Failed allocating MQTT packet (%lu bytes)", (unsigned long)remaining_length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t packet_size = 1;
+
+        packet[0] = header;
+        packet_size += encode_remaining_length(packet + 1, remaining_length);
+
+        if (variable_part_size > 0)
+        {
+            (void)memcpy(packet + packet_size, variable_part, variable_part_size);
+            packet_size += variable_part_size;
+        }
+
+        if (payload_size > 0)
+        {
+            (void)memcpy(packet + packet_size, payload, payload_size);
+            packet_size += payload_size;
+        }
+
+        result = perf_socket_send_all(connection->socket, packet, packet_size);
+
+        free(packet);
+    }
+
+    return result;
+}
+
+static int send_packet_id_ack(MQTT_CONNECTION* connection, unsigned char header, uint16_t packet_id)
+{
+    unsigned char variable_part[2];
+
+    variable_part[0] = (unsigned char)(packet_id >> 8);
+    variable_part[1] = (unsigned char)(packet_id & 0xFF);
+
+    return send_packet(connection, header, variable_part, sizeof(variable_part), NULL, 0);
+}
+
+static int send_publish(MQTT_CONNECTION* connection, const char* topic, int qos, const unsigned char* payload, size_t payload_size)
+{
+    int result;
+    size_t topic_length = strlen(topic);
+    unsigned char* variable_part;
+
+    if ((variable_part = (unsigned char*)malloc(2 + topic_length + 2)) == NULL)
+    {
+        LogError("Failed allocating PUBLISH variable header (%s)", topic);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t variable_part_size = 2 + topic_length;
+
+        variable_part[0] = (unsigned char)(topic_length >> 8);
+        variable_part[1] = (unsigned char)(topic_length & 0xFF);
+        (void)memcpy(variable_part + 2, topic, topic_length);
+
+        if (qos > MQTT_QOS_AT_MOST_ONCE)
+        {
+            uint16_t packet_id = connection->next_packet_id++;
+
+            if (connection->next_packet_id == 0)
+            {
+                connection->next_packet_id = 1;
+            }
+
+            variable_part[variable_part_size++] = (unsigned char)(packet_id >> 8);
+            variable_part[variable_part_size++] = (unsigned char)(packet_id & 0xFF);
+        }
+
+        result = send_packet(connection, (unsigned char)(MQTT_PUBLISH | (qos << 1)), variable_part, variable_part_size, payload, payload_size);
+
+        free(variable_part);
+    }
+
+    return result;
+}
+
+static void close_connection(MQTT_CONNECTION* connection)
+{
+    if (connection->socket != -1)
+    {
+        (void)shutdown(connection->socket, SHUT_RDWR);
+        perf_socket_close(connection->socket);
+        connection->socket = -1;
+    }
+
+    free(connection->device_id);
+    connection->device_id = NULL;
+    free(connection->receive_buffer);
+    connection->receive_buffer = NULL;
+    connection->receive_buffer_size = 0;
+    connection->received = 0;
+}
+
+// Copies the `$rid=` value of `topic` (up to the next '&') into `request_id`.
+static int get_request_id(const char* topic, char* request_id, size_t request_id_size)
+{
+    int result;
+    const char* value = strstr(topic, REQUEST_ID_PROPERTY);
+
+    if (value == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t length;
+
+        value += strlen(REQUEST_ID_PROPERTY);
+        length = strcspn(value, "&");
+
+        if (length == 0 || length >= request_id_size)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memcpy(request_id, value, length);
+            request_id[length] = '\0';
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int process_connect(MQTT_CONNECTION* connection, const unsigned char* body, size_t size)
+{
+    int result;
+    // protocol name (2 + 4 bytes "MQTT"), level (1), flags (1), keep alive (2), then the client identifier.
+    size_t index;
+
+    if (size < 2 || (index = 2 + (size_t)read_uint16(body) + 4) + 2 > size)
+    {
+        LogError("Malformed CONNECT packet");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t client_id_length = read_uint16(body + index);
+
+        if (index + 2 + client_id_length > size ||
+            (connection->device_id = (char*)malloc(client_id_length + 1)) == NULL)
+        {
+            LogError("Failed reading CONNECT client identifier");
+            result = __FAILURE__;
+        }
+        else
+        {
+            static const unsigned char connack[] = { 0x00, 0x00 };
+
+            (void)memcpy(connection->device_id, body + index + 2, client_id_length);
+            connection->device_id[client_id_length] = '\0';
+
+            result = send_packet(connection, MQTT_CONNACK, connack, sizeof(connack), NULL, 0);
+        }
+    }
+
+    return result;
+}
+
+static bool find_pending_method(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const PENDING_METHOD* pending_method = (const PENDING_METHOD*)singlylinkedlist_item_get_value(list_item);
+    return pending_method->request_id == *(const unsigned int*)match_context;
+}
+
+static void process_method_response(FAKE_MQTT_HUB* hub, const char* topic, const unsigned char* payload, size_t payload_size)
+{
+    const char* request_id_value = strstr(topic, REQUEST_ID_PROPERTY);
+
+    if (request_id_value == NULL)
+    {
+        LogError("Method response without request id (%s)", topic);
+    }
+    else
+    {
+        unsigned int request_id = (unsigned int)strtoul(request_id_value + strlen(REQUEST_ID_PROPERTY), NULL, 16);
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_find(hub->pending_methods, find_pending_method, &request_id);
+
+        if (list_item == NULL)
+        {
+            LogError("Method response for unknown request id %x", request_id);
+        }
+        else
+        {
+            PENDING_METHOD* pending_method = (PENDING_METHOD*)singlylinkedlist_item_get_value(list_item);
+            int status = atoi(topic + strlen(METHOD_RESPONSE_TOPIC_PREFIX));
+
+            (void)singlylinkedlist_remove(hub->pending_methods, list_item);
+
+            if (pending_method->on_method_response != NULL)
+            {
+                pending_method->on_method_response(pending_method->context, status, payload, payload_size);
+            }
+
+            free(pending_method);
+        }
+    }
+}
+
+static int process_twin_request(FAKE_MQTT_HUB* hub, MQTT_CONNECTION* connection, const char* topic)
+{
+    int result;
+    char request_id[REQUEST_ID_BUFFER_SIZE];
+    char response_topic[128];
+
+    if (get_request_id(topic, request_id, sizeof(request_id)) != 0)
+    {
+        LogError("Twin request without request id (%s)", topic);
+        result = __FAILURE__;
+    }
+    else if (strncmp(topic, TWIN_GET_TOPIC_PREFIX, strlen(TWIN_GET_TOPIC_PREFIX)) == 0)
+    {
+        (void)snprintf(response_topic, sizeof(response_topic), TWIN_GET_RESPONSE_TOPIC_FORMAT, request_id);
+        result = send_publish(connection, response_topic, MQTT_QOS_AT_MOST_ONCE, (const unsigned char*)TWIN_DOCUMENT, strlen(TWIN_DOCUMENT));
+    }
+    else if (strncmp(topic, TWIN_PATCH_REPORTED_TOPIC_PREFIX, strlen(TWIN_PATCH_REPORTED_TOPIC_PREFIX)) == 0)
+    {
+        (void)snprintf(response_topic, sizeof(response_topic), TWIN_PATCH_RESPONSE_TOPIC_FORMAT, request_id, ++hub->twin_version);
+        result = send_publish(connection, response_topic, MQTT_QOS_AT_MOST_ONCE, NULL, 0);
+    }
+    else
+    {
+        LogError("Unsupported twin request (%s)", topic);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int process_publish(FAKE_MQTT_HUB* hub, MQTT_CONNECTION* connection, unsigned char flags, const unsigned char* body, size_t size)
+{
+    int result;
+    int qos = (flags >> 1) & 0x03;
+    size_t topic_length;
+    size_t index;
+
+    if (size < 2 || (index = 2 + (topic_length = read_uint16(body))) > size || (qos > MQTT_QOS_AT_MOST_ONCE && index + 2 > size))
+    {
+        LogError("Malformed PUBLISH packet");
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* topic;
+
+        if ((topic = (char*)malloc(topic_length + 1)) == NULL)
+        {
+            LogError("Failed allocating PUBLISH topic");
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint16_t packet_id = 0;
+
+            (void)memcpy(topic, body + 2, topic_length);
+            topic[topic_length] = '\0';
+
+            if (qos > MQTT_QOS_AT_MOST_ONCE)
+            {
+                packet_id = read_uint16(body + index);
+                index += 2;
+            }
+
+            if (strstr(topic, DEVICE_EVENTS_TOPIC_SEGMENT) != NULL)
+            {
+                if (Lock(hub->lock) == LOCK_OK)
+                {
+                    hub->d2c_message_count++;
+                    (void)Unlock(hub->lock);
+                }
+                result = 0;
+            }
+            else if (strncmp(topic, METHOD_RESPONSE_TOPIC_PREFIX, strlen(METHOD_RESPONSE_TOPIC_PREFIX)) == 0)
+            {
+                process_method_response(hub, topic, body + index, size - index);
+                result = 0;
+            }
+            else if (strncmp(topic, TWIN_TOPIC_PREFIX, strlen(TWIN_TOPIC_PREFIX)) == 0)
+            {
+                result = process_twin_request(hub, connection, topic);
+            }
+            else
+            {
+                LogError("PUBLISH on unexpected topic (%s)", topic);
+                result = 0;
+            }
+
+            if (result == 0 && qos > MQTT_QOS_AT_MOST_ONCE)
+            {
+                result = send_packet_id_ack(connection, MQTT_PUBACK, packet_id);
+            }
+
+            free(topic);
+        }
+    }
+
+    return result;
+}
+
+static int process_subscribe(MQTT_CONNECTION* connection, const unsigned char* body, size_t size)
+{
+    int result;
+
+    if (size < 2)
+    {
+        LogError("Malformed SUBSCRIBE packet");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char* suback;
+
+        if ((suback = (unsigned char*)malloc(size)) == NULL)
+        {
+            LogError("Failed allocating SUBACK");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t suback_size = 2;
+            size_t index = 2;
+
+            // Packet identifier, then one granted QoS per topic filter (the hub grants at most QoS 1).
+            suback[0] = body[0];
+            suback[1] = body[1];
+            result = 0;
+
+            while (index + 2 < size)
+            {
+                size_t filter_length = read_uint16(body + index);
+                unsigned char requested_qos;
+
+                index += 2 + filter_length;
+                if (index >= size)
+                {
+                    LogError("Malformed SUBSCRIBE topic filter");
+                    result = __FAILURE__;
+                    break;
+                }
+
+                requested_qos = body[index++] & 0x03;
+                suback[suback_size++] = (requested_qos > MQTT_QOS_AT_LEAST_ONCE) ? MQTT_QOS_AT_LEAST_ONCE : requested_qos;
+            }
+
+            if (result == 0)
+            {
+                result = send_packet(connection, MQTT_SUBACK, suback, suback_size, NULL, 0);
+            }
+
+            free(suback);
+        }
+    }
+
+    return result;
+}
+
+static int process_packet(FAKE_MQTT_HUB* hub, MQTT_CONNECTION* connection, unsigned char header, const unsigned char* body, size_t size)
+{
+    int result;
+
+    switch (header & MQTT_PACKET_TYPE_MASK)
+    {
+        case MQTT_CONNECT:
+            result = process_connect(connection, body, size);
+            break;
+        case MQTT_PUBLISH:
+            result = process_publish(hub, connection, (unsigned char)(header & 0x0F), body, size);
+            break;
+        case MQTT_PUBACK:
+            // Acknowledgement of a cloud-to-device message.
+            result = 0;
+            break;
+        case MQTT_SUBSCRIBE:
+            result = process_subscribe(connection, body, size);
+            break;
+        case MQTT_UNSUBSCRIBE:
+            result = (size < 2) ? __FAILURE__ : send_packet_id_ack(connection, MQTT_UNSUBACK, read_uint16(body));
+            break;
+        case MQTT_PINGREQ:
+            result = send_packet(connection, MQTT_PINGRESP, NULL, 0, NULL, 0);
+            break;
+        case MQTT_DISCONNECT:
+            result = __FAILURE__;
+            break;
+        default:
+            LogError("Unexpected MQTT packet type 0x%x", header);
+            result = __FAILURE__;
+            break;
+    }
+
+    return result;
+}
+
+static int receive_from_connection(FAKE_MQTT_HUB* hub, MQTT_CONNECTION* connection)
+{
+    int result = 0;
+
+    while (result == 0)
+    {
+        ssize_t received;
+
+        if (connection->receive_buffer_size - connection->received < RECEIVE_CHUNK_SIZE)
+        {
+            unsigned char* new_buffer = (unsigned char*)realloc(connection->receive_buffer, connection->receive_buffer_size + RECEIVE_CHUNK_SIZE);
+
+            if (new_buffer == NULL)
+            {
+                LogError("Failed growing MQTT receive buffer");
+                result = __FAILURE__;
+                break;
+            }
+
+            connection->receive_buffer = new_buffer;
+            connection->receive_buffer_size += RECEIVE_CHUNK_SIZE;
+        }
+
+        received = recv(connection->socket, connection->receive_buffer + connection->received, connection->receive_buffer_size - connection->received, 0);
+
+        if (received == 0)
+        {
+            result = __FAILURE__;
+        }
+        else if (received < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                result = __FAILURE__;
+            }
+            break;
+        }
+        else
+        {
+            size_t consumed = 0;
+
+            connection->received += (size_t)received;
+
+            while (result == 0)
+            {
+                size_t remaining_length;
+                size_t header_size;
+                int decode_result = decode_fixed_header(connection->receive_buffer + consumed, connection->received - consumed, &remaining_length, &header_size);
+
+                if (decode_result < 0)
+                {
+                    LogError("Malformed MQTT fixed header");
+                    result = __FAILURE__;
+                }
+                else if (decode_result == 0 || connection->received - consumed < header_size + remaining_length)
+                {
+                    break;
+                }
+                else
+                {
+                    result = process_packet(hub, connection, connection->receive_buffer[consumed], connection->receive_buffer + consumed + header_size, remaining_length);
+                    consumed += header_size + remaining_length;
+                }
+            }
+
+            if (consumed > 0 && connection->socket != -1)
+            {
+                (void)memmove(connection->receive_buffer, connection->receive_buffer + consumed, connection->received - consumed);
+                connection->received -= consumed;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void accept_connections(FAKE_MQTT_HUB* hub)
+{
+    int accepted_socket;
+
+    while ((accepted_socket = perf_socket_accept(hub->listen_socket)) != -1)
+    {
+        size_t i;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket == -1)
+            {
+                hub->connections[i].socket = accepted_socket;
+                hub->connections[i].next_packet_id = 1;
+                break;
+            }
+        }
+
+        if (i == MAX_CONNECTIONS)
+        {
+            LogError("Too many connections to the fake MQTT hub");
+            perf_socket_close(accepted_socket);
+        }
+    }
+}
+
+static void send_c2d_message(FAKE_MQTT_HUB* hub, PERF_FAKE_HUB_REQUEST* request)
+{
+    char topic[256];
+    size_t i;
+
+    (void)snprintf(topic, sizeof(topic), C2D_TOPIC_FORMAT, request->device_id);
+
+    for (i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        MQTT_CONNECTION* connection = &hub->connections[i];
+
+        if (connection->socket != -1 && connection->device_id != NULL && strcmp(connection->device_id, request->device_id) == 0)
+        {
+            if (send_publish(connection, topic, MQTT_QOS_AT_LEAST_ONCE, request->payload, request->size) != 0)
+            {
+                close_connection(connection);
+            }
+        }
+    }
+}
+
+static void invoke_method(FAKE_MQTT_HUB* hub, PERF_FAKE_HUB_REQUEST* request)
+{
+    PENDING_METHOD* pending_method;
+
+    if ((pending_method = (PENDING_METHOD*)malloc(sizeof(PENDING_METHOD))) == NULL)
+    {
+        LogError("Failed allocating pending method (%s)", request->method_name);
+    }
+    else
+    {
+        char topic[256];
+        size_t i;
+
+        pending_method->request_id = hub->next_method_request_id++;
+        pending_method->on_method_response = request->on_method_response;
+        pending_method->context = request->on_method_response_context;
+
+        if (singlylinkedlist_add(hub->pending_methods, pending_method) == NULL)
+        {
+            LogError("Failed tracking pending method (%s)", request->method_name);
+            free(pending_method);
+        }
+        else
+        {
+            (void)snprintf(topic, sizeof(topic), METHOD_REQUEST_TOPIC_FORMAT, request->method_name, pending_method->request_id);
+
+            for (i = 0; i < MAX_CONNECTIONS; i++)
+            {
+                MQTT_CONNECTION* connection = &hub->connections[i];
+
+                if (connection->socket != -1 && connection->device_id != NULL && strcmp(connection->device_id, request->device_id) == 0)
+                {
+                    if (send_publish(connection, topic, MQTT_QOS_AT_MOST_ONCE, request->payload, request->size) != 0)
+                    {
+                        close_connection(connection);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void process_requests(FAKE_MQTT_HUB* hub)
+{
+    PERF_FAKE_HUB_REQUEST* request;
+
+    while ((request = perf_fake_hub_request_queue_pop(hub->requests)) != NULL)
+    {
+        if (request->type == PERF_FAKE_HUB_REQUEST_SEND_C2D)
+        {
+            send_c2d_message(hub, request);
+        }
+        else if (request->type == PERF_FAKE_HUB_REQUEST_INVOKE_METHOD)
+        {
+            invoke_method(hub, request);
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < MAX_CONNECTIONS; i++)
+            {
+                close_connection(&hub->connections[i]);
+            }
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->drop_count++;
+                (void)Unlock(hub->lock);
+            }
+        }
+
+        perf_fake_hub_request_destroy(request);
+    }
+}
+
+static bool is_stopping(FAKE_MQTT_HUB* hub)
+{
+    bool result = true;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->is_stopping;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+static int fake_mqtt_hub_thread(void* context)
+{
+    FAKE_MQTT_HUB* hub = (FAKE_MQTT_HUB*)context;
+
+    while (!is_stopping(hub))
+    {
+        struct pollfd poll_fds[MAX_CONNECTIONS + 2];
+        size_t connection_index[MAX_CONNECTIONS + 2];
+        nfds_t poll_fd_count = 2;
+        nfds_t i;
+
+        poll_fds[0].fd = hub->wakeup[0];
+        poll_fds[0].events = POLLIN;
+        poll_fds[1].fd = hub->listen_socket;
+        poll_fds[1].events = POLLIN;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            if (hub->connections[i].socket != -1)
+            {
+                poll_fds[poll_fd_count].fd = hub->connections[i].socket;
+                poll_fds[poll_fd_count].events = POLLIN;
+                connection_index[poll_fd_count] = i;
+                poll_fd_count++;
+            }
+        }
+
+        for (i = 0; i < poll_fd_count; i++)
+        {
+            poll_fds[i].revents = 0;
+        }
+
+        if (poll(poll_fds, poll_fd_count, POLL_TIMEOUT_MS) > 0)
+        {
+            if (poll_fds[0].revents != 0)
+            {
+                perf_socket_drain_wakeup(hub->wakeup);
+            }
+
+            if (poll_fds[1].revents != 0)
+            {
+                accept_connections(hub);
+            }
+
+            for (i = 2; i < poll_fd_count; i++)
+            {
+                if (poll_fds[i].revents != 0)
+                {
+                    MQTT_CONNECTION* connection = &hub->connections[connection_index[i]];
+
+                    if (receive_from_connection(hub, connection) != 0)
+                    {
+                        close_connection(connection);
+                    }
+                }
+            }
+        }
+
+        process_requests(hub);
+    }
+
+    return 0;
+}
+
+static void fake_mqtt_hub_destroy(PERF_FAKE_HUB_HANDLE handle)
+{
+    FAKE_MQTT_HUB* hub = (FAKE_MQTT_HUB*)handle;
+
+    if (hub != NULL)
+    {
+        size_t i;
+
+        if (hub->thread != NULL)
+        {
+            int thread_result;
+
+            if (Lock(hub->lock) == LOCK_OK)
+            {
+                hub->is_stopping = true;
+                (void)Unlock(hub->lock);
+            }
+
+            perf_socket_signal_wakeup(hub->wakeup);
+            (void)ThreadAPI_Join(hub->thread, &thread_result);
+        }
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            close_connection(&hub->connections[i]);
+        }
+
+        if (hub->pending_methods != NULL)
+        {
+            LIST_ITEM_HANDLE list_item;
+
+            while ((list_item = singlylinkedlist_get_head_item(hub->pending_methods)) != NULL)
+            {
+                free((void*)singlylinkedlist_item_get_value(list_item));
+                (void)singlylinkedlist_remove(hub->pending_methods, list_item);
+            }
+
+            singlylinkedlist_destroy(hub->pending_methods);
+        }
+
+        perf_fake_hub_request_queue_destroy(hub->requests);
+        perf_socket_close(hub->listen_socket);
+
+        if (hub->wakeup[0] != -1)
+        {
+            perf_socket_destroy_wakeup(hub->wakeup);
+        }
+
+        if (hub->lock != NULL)
+        {
+            (void)Lock_Deinit(hub->lock);
+        }
+
+        free(hub);
+    }
+}
+
+static PERF_FAKE_HUB_HANDLE fake_mqtt_hub_create(void)
+{
+    FAKE_MQTT_HUB* result;
+
+    if ((result = (FAKE_MQTT_HUB*)malloc(sizeof(FAKE_MQTT_HUB))) == NULL)
+    {
+        LogError("Failed allocating fake MQTT hub");
+    }
+    else
+    {
+        size_t i;
+
+        memset(result, 0, sizeof(FAKE_MQTT_HUB));
+        result->listen_socket = -1;
+        result->wakeup[0] = -1;
+        result->wakeup[1] = -1;
+        result->next_method_request_id = 1;
+
+        for (i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            result->connections[i].socket = -1;
+        }
+
+        if ((result->lock = Lock_Init()) == NULL ||
+            (result->requests = perf_fake_hub_request_queue_create()) == NULL ||
+            (result->pending_methods = singlylinkedlist_create()) == NULL ||
+            perf_socket_create_wakeup(result->wakeup) != 0 ||
+            (result->listen_socket = perf_socket_listen(&result->port)) == -1)
+        {
+            LogError("Failed initializing fake MQTT hub");
+            fake_mqtt_hub_destroy(result);
+            result = NULL;
+        }
+        else if (ThreadAPI_Create(&result->thread, fake_mqtt_hub_thread, result) != THREADAPI_OK)
+        {
+            LogError("Failed starting fake MQTT hub thread");
+            result->thread = NULL;
+            fake_mqtt_hub_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int fake_mqtt_hub_get_port(PERF_FAKE_HUB_HANDLE handle)
+{
+    return ((FAKE_MQTT_HUB*)handle)->port;
+}
+
+static size_t fake_mqtt_hub_get_d2c_message_count(PERF_FAKE_HUB_HANDLE handle)
+{
+    FAKE_MQTT_HUB* hub = (FAKE_MQTT_HUB*)handle;
+    size_t result = 0;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->d2c_message_count;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+static int queue_request(FAKE_MQTT_HUB* hub, PERF_FAKE_HUB_REQUEST* request)
+{
+    int result;
+
+    if (request == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else if (perf_fake_hub_request_queue_push(hub->requests, request) != 0)
+    {
+        perf_fake_hub_request_destroy(request);
+        result = __FAILURE__;
+    }
+    else
+    {
+        perf_socket_signal_wakeup(hub->wakeup);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int fake_mqtt_hub_send_c2d_message(PERF_FAKE_HUB_HANDLE handle, const char* device_id, const unsigned char* payload, size_t size)
+{
+    return queue_request((FAKE_MQTT_HUB*)handle, perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_SEND_C2D, device_id, NULL, payload, size));
+}
+
+static int fake_mqtt_hub_invoke_method(PERF_FAKE_HUB_HANDLE handle, const char* device_id, const char* method_name, const unsigned char* payload, size_t size, PERF_ON_METHOD_RESPONSE on_method_response, void* context)
+{
+    PERF_FAKE_HUB_REQUEST* request = perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_INVOKE_METHOD, device_id, method_name, payload, size);
+
+    if (request != NULL)
+    {
+        request->on_method_response = on_method_response;
+        request->on_method_response_context = context;
+    }
+
+    return queue_request((FAKE_MQTT_HUB*)handle, request);
+}
+
+static size_t get_drop_count(FAKE_MQTT_HUB* hub)
+{
+    size_t result = 0;
+
+    if (Lock(hub->lock) == LOCK_OK)
+    {
+        result = hub->drop_count;
+        (void)Unlock(hub->lock);
+    }
+
+    return result;
+}
+
+// Returns once the hub thread has closed every connection, so callers can time the recovery from that point.
+static int fake_mqtt_hub_drop_connections(PERF_FAKE_HUB_HANDLE handle)
+{
+    int result;
+    FAKE_MQTT_HUB* hub = (FAKE_MQTT_HUB*)handle;
+    size_t initial_drop_count = get_drop_count(hub);
+
+    if (queue_request(hub, perf_fake_hub_request_create(PERF_FAKE_HUB_REQUEST_DROP_CONNECTIONS, NULL, NULL, NULL, 0)) != 0)
+    {
+        LogError("Failed queueing connection drop");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned int waited_ms = 0;
+
+        while (get_drop_count(hub) == initial_drop_count && waited_ms < DROP_WAIT_TIMEOUT_MS)
+        {
+            ThreadAPI_Sleep(1);
+            waited_ms++;
+        }
+
+        if (waited_ms >= DROP_WAIT_TIMEOUT_MS)
+        {
+            LogError("Timed out waiting for connections to be dropped");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static const PERF_FAKE_HUB_INTERFACE fake_mqtt_hub_interface =
+{
+    fake_mqtt_hub_create,
+    fake_mqtt_hub_destroy,
+    fake_mqtt_hub_get_port,
+    fake_mqtt_hub_get_d2c_message_count,
+    fake_mqtt_hub_send_c2d_message,
+    fake_mqtt_hub_invoke_method,
+    fake_mqtt_hub_drop_connections
+};
+
+const PERF_FAKE_HUB_INTERFACE* perf_fake_mqtt_hub_get_interface(void)
+{
+    return &fake_mqtt_hub_interface;
+}
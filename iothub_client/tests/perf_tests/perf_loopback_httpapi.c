@@ -0,0 +1,459 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Link-time replacement for the platform HTTPAPI (httpapi_compact/curl/winhttp) used by the perf tests:
+// plain HTTP/1.1 over a kept-alive loopback socket to the fake HTTP hub, whatever host name the
+// transport asks for. Options are refused, which the HTTP transport treats as "not supported".
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/httpapi.h"
+
+#include "perf_loopback_transports.h"
+#include "perf_socket.h"
+
+#define RESPONSE_TIMEOUT_MS     30000
+#define RECEIVE_CHUNK_SIZE      4096
+
+static const char* HEADER_TERMINATOR = "\r\n\r\n";
+static const char* CONTENT_LENGTH_HEADER_NAME = "Content-Length";
+
+typedef struct HTTP_HANDLE_DATA_TAG
+{
+    int socket;
+    char* host_name;
+} HTTP_HANDLE_DATA;
+
+static const char* get_request_method(HTTPAPI_REQUEST_TYPE request_type)
+{
+    const char* result;
+
+    switch (request_type)
+    {
+    case HTTPAPI_REQUEST_GET:
+        result = "GET";
+        break;
+    case HTTPAPI_REQUEST_POST:
+        result = "POST";
+        break;
+    case HTTPAPI_REQUEST_PUT:
+        result = "PUT";
+        break;
+    case HTTPAPI_REQUEST_DELETE:
+        result = "DELETE";
+        break;
+    case HTTPAPI_REQUEST_PATCH:
+        result = "PATCH";
+        break;
+    case HTTPAPI_REQUEST_HEAD:
+        result = "HEAD";
+        break;
+    default:
+        result = NULL;
+        break;
+    }
+
+    return result;
+}
+
+static int ensure_connected(HTTP_HANDLE_DATA* http)
+{
+    int result;
+
+    if (http->socket != -1)
+    {
+        result = 0;
+    }
+    else if ((http->socket = perf_socket_connect(perf_loopback_get_port())) == -1)
+    {
+        LogError("Failed connecting to loopback port %d", perf_loopback_get_port());
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+// The fake hub closes its connections when a benchmark drops them; reconnect on the next request.
+static void disconnect(HTTP_HANDLE_DATA* http)
+{
+    if (http->socket != -1)
+    {
+        perf_socket_close(http->socket);
+        http->socket = -1;
+    }
+}
+
+static STRING_HANDLE build_request_head(HTTP_HANDLE_DATA* http, const char* method, const char* relative_path, HTTP_HEADERS_HANDLE request_headers, size_t content_length)
+{
+    STRING_HANDLE result;
+    size_t header_count = 0;
+    bool has_content_length = false;
+    bool is_ok = true;
+    size_t i;
+
+    if ((result = STRING_construct_sprintf("%s %s HTTP/1.1\r\nHost: %s\r\n", method, relative_path, http->host_name)) == NULL)
+    {
+        LogError("Failed building request line");
+    }
+    else
+    {
+        if (request_headers != NULL && HTTPHeaders_GetHeaderCount(request_headers, &header_count) != HTTP_HEADERS_OK)
+        {
+            LogError("Failed getting request header count");
+            is_ok = false;
+        }
+
+        for (i = 0; is_ok && i < header_count; i++)
+        {
+            char* header;
+
+            if (HTTPHeaders_GetHeader(request_headers, i, &header) != HTTP_HEADERS_OK)
+            {
+                LogError("Failed getting request header %lu", (unsigned long)i);
+                is_ok = false;
+            }
+            else
+            {
+                if (strncasecmp(header, CONTENT_LENGTH_HEADER_NAME, strlen(CONTENT_LENGTH_HEADER_NAME)) == 0)
+                {
+                    has_content_length = true;
+                }
+
+                is_ok = (STRING_concat(result, header) == 0 && STRING_concat(result, "\r\n") == 0);
+                free(header);
+            }
+        }
+
+        if (is_ok && !has_content_length)
+        {
+            char content_length_header[64];
+
+            (void)snprintf(content_length_header, sizeof(content_length_header), "%s: %lu\r\n", CONTENT_LENGTH_HEADER_NAME, (unsigned long)content_length);
+            is_ok = (STRING_concat(result, content_length_header) == 0);
+        }
+
+        if (!is_ok || STRING_concat(result, "\r\n") != 0)
+        {
+            LogError("Failed building request headers");
+            STRING_delete(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int receive_more(HTTP_HANDLE_DATA* http, unsigned char** buffer, size_t* buffer_size, size_t* received)
+{
+    int result;
+    unsigned char* new_buffer;
+
+    if (*received == *buffer_size &&
+        (new_buffer = (unsigned char*)realloc(*buffer, *buffer_size + RECEIVE_CHUNK_SIZE)) == NULL)
+    {
+        LogError("Failed growing response buffer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        ssize_t bytes_received;
+
+        if (*received == *buffer_size)
+        {
+            *buffer = new_buffer;
+            *buffer_size += RECEIVE_CHUNK_SIZE;
+        }
+
+        if (perf_socket_wait_readable(http->socket, RESPONSE_TIMEOUT_MS) != 1)
+        {
+            LogError("Timed out waiting for loopback HTTP response");
+            result = __FAILURE__;
+        }
+        else if ((bytes_received = recv(http->socket, *buffer + *received, *buffer_size - *received, 0)) > 0)
+        {
+            *received += (size_t)bytes_received;
+            result = 0;
+        }
+        else if (bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            result = 0;
+        }
+        else
+        {
+            // Peer closed the connection (e.g. a dropped connection) or the socket failed.
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+// Splits "Name: value" header lines into `response_headers` and returns the Content-Length (0 if absent).
+static int parse_response_head(char* head, unsigned int* status_code, HTTP_HEADERS_HANDLE response_headers, size_t* content_length)
+{
+    int result;
+    char* line_end;
+    unsigned int status;
+
+    *content_length = 0;
+
+    if (sscanf(head, "HTTP/1.%*c %u", &status) != 1 || (line_end = strstr(head, "\r\n")) == NULL)
+    {
+        LogError("Malformed loopback HTTP status line");
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* line = line_end + 2;
+
+        result = 0;
+
+        while (result == 0 && *line != '\0' && (line_end = strstr(line, "\r\n")) != NULL)
+        {
+            char* separator;
+
+            *line_end = '\0';
+
+            if ((separator = strchr(line, ':')) != NULL)
+            {
+                char* value = separator + 1;
+
+                *separator = '\0';
+
+                while (*value == ' ')
+                {
+                    value++;
+                }
+
+                if (strcasecmp(line, CONTENT_LENGTH_HEADER_NAME) == 0)
+                {
+                    *content_length = (size_t)strtoul(value, NULL, 10);
+                }
+
+                if (response_headers != NULL && HTTPHeaders_AddHeaderNameValuePair(response_headers, line, value) != HTTP_HEADERS_OK)
+                {
+                    LogError("Failed adding response header %s", line);
+                    result = __FAILURE__;
+                }
+            }
+
+            line = line_end + 2;
+        }
+
+        if (status_code != NULL)
+        {
+            *status_code = status;
+        }
+    }
+
+    return result;
+}
+
+static HTTPAPI_RESULT receive_response(HTTP_HANDLE_DATA* http, HTTPAPI_REQUEST_TYPE request_type, unsigned int* status_code, HTTP_HEADERS_HANDLE response_headers, BUFFER_HANDLE response_content)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    unsigned char* buffer = NULL;
+    size_t buffer_size = 0;
+    size_t received = 0;
+    size_t head_size = 0;
+    size_t content_length = 0;
+
+    // Headers first...
+    while (result == HTTPAPI_OK && head_size == 0)
+    {
+        if (receive_more(http, &buffer, &buffer_size, &received) != 0)
+        {
+            result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
+        }
+        else if (received >= strlen(HEADER_TERMINATOR))
+        {
+            size_t i;
+
+            for (i = 0; i + strlen(HEADER_TERMINATOR) <= received; i++)
+            {
+                if (memcmp(buffer + i, HEADER_TERMINATOR, strlen(HEADER_TERMINATOR)) == 0)
+                {
+                    head_size = i + strlen(HEADER_TERMINATOR);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (result == HTTPAPI_OK)
+    {
+        char* head = (char*)malloc(head_size + 1);
+
+        if (head == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+        }
+        else
+        {
+            (void)memcpy(head, buffer, head_size);
+            head[head_size] = '\0';
+
+            if (parse_response_head(head, status_code, response_headers, &content_length) != 0)
+            {
+                result = HTTPAPI_HTTP_HEADERS_FAILED;
+            }
+
+            free(head);
+        }
+    }
+
+    if (request_type == HTTPAPI_REQUEST_HEAD)
+    {
+        content_length = 0;
+    }
+
+    // ...then the body.
+    while (result == HTTPAPI_OK && received < head_size + content_length)
+    {
+        if (receive_more(http, &buffer, &buffer_size, &received) != 0)
+        {
+            result = HTTPAPI_READ_DATA_FAILED;
+        }
+    }
+
+    if (result == HTTPAPI_OK && response_content != NULL &&
+        BUFFER_build(response_content, content_length > 0 ? buffer + head_size : NULL, content_length) != 0)
+    {
+        LogError("Failed copying response content");
+        result = HTTPAPI_ALLOC_FAILED;
+    }
+
+    free(buffer);
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_Init(void)
+{
+    return HTTPAPI_OK;
+}
+
+void HTTPAPI_Deinit(void)
+{
+}
+
+HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+{
+    HTTP_HANDLE_DATA* result;
+
+    if (hostName == NULL)
+    {
+        LogError("Invalid argument (hostName is NULL)");
+        result = NULL;
+    }
+    else if ((result = (HTTP_HANDLE_DATA*)malloc(sizeof(HTTP_HANDLE_DATA))) == NULL)
+    {
+        LogError("Failed allocating loopback HTTP connection");
+    }
+    else
+    {
+        result->socket = -1;
+
+        if (mallocAndStrcpy_s(&result->host_name, hostName) != 0)
+        {
+            LogError("Failed copying host name");
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return (HTTP_HANDLE)result;
+}
+
+void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
+{
+    HTTP_HANDLE_DATA* http = (HTTP_HANDLE_DATA*)handle;
+
+    if (http != NULL)
+    {
+        disconnect(http);
+        free(http->host_name);
+        free(http);
+    }
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+    HTTP_HANDLE_DATA* http = (HTTP_HANDLE_DATA*)handle;
+    const char* method = get_request_method(requestType);
+    STRING_HANDLE request_head;
+
+    if (http == NULL || relativePath == NULL || method == NULL || (content == NULL && contentLength > 0))
+    {
+        LogError("Invalid argument (handle=%p, relativePath=%p, requestType=%d)", handle, relativePath, (int)requestType);
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else if ((request_head = build_request_head(http, method, relativePath, httpHeadersHandle, contentLength)) == NULL)
+    {
+        result = HTTPAPI_STRING_PROCESSING_ERROR;
+    }
+    else
+    {
+        if (ensure_connected(http) != 0)
+        {
+            result = HTTPAPI_OPEN_REQUEST_FAILED;
+        }
+        else if (perf_socket_send_all(http->socket, (const unsigned char*)STRING_c_str(request_head), STRING_length(request_head)) != 0 ||
+            (contentLength > 0 && perf_socket_send_all(http->socket, content, contentLength) != 0))
+        {
+            LogError("Failed sending loopback HTTP request");
+            result = HTTPAPI_SEND_REQUEST_FAILED;
+        }
+        else
+        {
+            result = receive_response(http, requestType, statusCode, responseHeadersHandle, responseContent);
+        }
+
+        if (result != HTTPAPI_OK)
+        {
+            disconnect(http);
+        }
+
+        STRING_delete(request_head);
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
+{
+    (void)handle;
+    (void)value;
+    LogInfo("Loopback HTTPAPI ignores option %s", optionName);
+    return HTTPAPI_INVALID_ARG;
+}
+
+HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, const void** savedValue)
+{
+    (void)optionName;
+    (void)value;
+    (void)savedValue;
+    return HTTPAPI_INVALID_ARG;
+}
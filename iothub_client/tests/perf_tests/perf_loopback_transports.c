@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+
+#include "perf_loopback_transports.h"
+
+#ifdef PERF_USE_MQTT
+#include "iothubtransportmqtt.h"
+#include "iothubtransport_mqtt_common.h"
+#endif
+
+#ifdef PERF_USE_AMQP
+#include "iothubtransportamqp.h"
+#include "iothubtransport_amqp_common.h"
+#endif
+
+#ifdef PERF_USE_HTTP
+#include "iothubtransporthttp.h"
+#endif
+
+static const char* LOOPBACK_ADDRESS = "127.0.0.1";
+
+static int loopback_port;
+
+void perf_loopback_set_port(int port)
+{
+    loopback_port = port;
+}
+
+int perf_loopback_get_port(void)
+{
+    return loopback_port;
+}
+
+static XIO_HANDLE create_loopback_io(void)
+{
+    XIO_HANDLE result;
+    SOCKETIO_CONFIG socketio_config;
+
+    socketio_config.hostname = LOOPBACK_ADDRESS;
+    socketio_config.port = loopback_port;
+    socketio_config.accepted_socket = NULL;
+
+    if ((result = xio_create(socketio_get_interface_description(), &socketio_config)) == NULL)
+    {
+        LogError("Failed creating loopback socket I/O (port %d)", loopback_port);
+    }
+
+    return result;
+}
+
+#ifdef PERF_USE_MQTT
+static TRANSPORT_PROVIDER loopback_mqtt_provider;
+
+static XIO_HANDLE get_mqtt_loopback_io(const char* fully_qualified_name, const MQTT_TRANSPORT_PROXY_OPTIONS* mqtt_transport_proxy_options)
+{
+    (void)fully_qualified_name;
+    (void)mqtt_transport_proxy_options;
+    return create_loopback_io();
+}
+
+static TRANSPORT_LL_HANDLE loopback_mqtt_create(const IOTHUBTRANSPORT_CONFIG* config)
+{
+    return IoTHubTransport_MQTT_Common_Create(config, get_mqtt_loopback_io);
+}
+
+const TRANSPORT_PROVIDER* PerfLoopbackMQTT_Protocol(void)
+{
+    // Everything but the I/O factory is the stock MQTT transport.
+    loopback_mqtt_provider = *MQTT_Protocol();
+    loopback_mqtt_provider.IoTHubTransport_Create = loopback_mqtt_create;
+    return &loopback_mqtt_provider;
+}
+#endif
+
+#ifdef PERF_USE_AMQP
+static TRANSPORT_PROVIDER loopback_amqp_provider;
+
+static XIO_HANDLE get_amqp_loopback_io(const char* target_fqdn, const AMQP_TRANSPORT_PROXY_OPTIONS* amqp_transport_proxy_options)
+{
+    (void)target_fqdn;
+    (void)amqp_transport_proxy_options;
+    return create_loopback_io();
+}
+
+static TRANSPORT_LL_HANDLE loopback_amqp_create(const IOTHUBTRANSPORT_CONFIG* config)
+{
+    return IoTHubTransport_AMQP_Common_Create(config, get_amqp_loopback_io);
+}
+
+const TRANSPORT_PROVIDER* PerfLoopbackAMQP_Protocol(void)
+{
+    loopback_amqp_provider = *AMQP_Protocol();
+    loopback_amqp_provider.IoTHubTransport_Create = loopback_amqp_create;
+    return &loopback_amqp_provider;
+}
+#endif
+
+#ifdef PERF_USE_HTTP
+static TRANSPORT_PROVIDER loopback_http_provider;
+
+static XIO_HANDLE get_http_loopback_io(const char* fully_qualified_name)
+{
+    (void)fully_qualified_name;
+    return create_loopback_io();
+}
+
+static TRANSPORT_LL_HANDLE loopback_http_create(const IOTHUBTRANSPORT_CONFIG* config)
+{
+    return IoTHubTransportHttp_CreateWithIoTransport(config, get_http_loopback_io);
+}
+
+const TRANSPORT_PROVIDER* PerfLoopbackHTTP_Protocol(void)
+{
+    // Only the connection pool uses the I/O factory.
+    loopback_http_provider = *HTTP_Protocol();
+    loopback_http_provider.IoTHubTransport_Create = loopback_http_create;
+    return &loopback_http_provider;
+}
+#endif
@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_LOOPBACK_TRANSPORTS_H
+#define PERF_LOOPBACK_TRANSPORTS_H
+
+#include "iothub_transport_ll.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Transport providers identical to MQTT_Protocol/AMQP_Protocol/HTTP_Protocol except that they connect over
+// plain sockets to 127.0.0.1:<port> instead of TLS to the hub host name. The blocking HTTP requests go
+// through the loopback HTTPAPI in perf_loopback_httpapi.c, which honours the same port.
+
+// Sets the fake hub port used by every loopback connection created after the call.
+extern void perf_loopback_set_port(int port);
+extern int perf_loopback_get_port(void);
+
+#ifdef PERF_USE_MQTT
+extern const TRANSPORT_PROVIDER* PerfLoopbackMQTT_Protocol(void);
+#endif
+
+#ifdef PERF_USE_AMQP
+extern const TRANSPORT_PROVIDER* PerfLoopbackAMQP_Protocol(void);
+#endif
+
+#ifdef PERF_USE_HTTP
+extern const TRANSPORT_PROVIDER* PerfLoopbackHTTP_Protocol(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_LOOPBACK_TRANSPORTS_H */
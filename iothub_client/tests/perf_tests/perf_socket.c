@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "perf_socket.h"
+
+#define SEND_WAIT_TIMEOUT_MS 5000
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static int set_non_blocking(int socket)
+{
+    int result;
+    int flags = fcntl(socket, F_GETFL, 0);
+
+    if (flags == -1 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1)
+    {
+        LogError("Failed setting socket %d as non-blocking (errno=%d)", socket, errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int set_no_delay(int socket)
+{
+    int enable = 1;
+    int result;
+
+    if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)) != 0)
+    {
+        LogError("Failed setting TCP_NODELAY on socket %d (errno=%d)", socket, errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int perf_socket_listen(int* port)
+{
+    int result;
+    int listen_socket;
+
+    if ((listen_socket = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+    {
+        LogError("Failed creating listen socket (errno=%d)", errno);
+        result = -1;
+    }
+    else
+    {
+        struct sockaddr_in address;
+        socklen_t address_length = sizeof(address);
+        int reuse = 1;
+
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+
+        if (setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+            listen(listen_socket, SOMAXCONN) != 0 ||
+            getsockname(listen_socket, (struct sockaddr*)&address, &address_length) != 0 ||
+            set_non_blocking(listen_socket) != 0)
+        {
+            LogError("Failed listening on the loopback interface (errno=%d)", errno);
+            (void)close(listen_socket);
+            result = -1;
+        }
+        else
+        {
+            *port = ntohs(address.sin_port);
+            result = listen_socket;
+        }
+    }
+
+    return result;
+}
+
+int perf_socket_accept(int listen_socket)
+{
+    int result;
+    int accepted_socket = accept(listen_socket, NULL, NULL);
+
+    if (accepted_socket == -1)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            LogError("Failed accepting connection (errno=%d)", errno);
+        }
+        result = -1;
+    }
+    else if (set_non_blocking(accepted_socket) != 0 || set_no_delay(accepted_socket) != 0)
+    {
+        (void)close(accepted_socket);
+        result = -1;
+    }
+    else
+    {
+        result = accepted_socket;
+    }
+
+    return result;
+}
+
+int perf_socket_connect(int port)
+{
+    int result;
+    int client_socket;
+
+    if ((client_socket = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+    {
+        LogError("Failed creating client socket (errno=%d)", errno);
+        result = -1;
+    }
+    else
+    {
+        struct sockaddr_in address;
+
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((uint16_t)port);
+
+        if (connect(client_socket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+            set_non_blocking(client_socket) != 0 ||
+            set_no_delay(client_socket) != 0)
+        {
+            LogError("Failed connecting to 127.0.0.1:%d (errno=%d)", port, errno);
+            (void)close(client_socket);
+            result = -1;
+        }
+        else
+        {
+            result = client_socket;
+        }
+    }
+
+    return result;
+}
+
+int perf_socket_send_all(int socket, const unsigned char* buffer, size_t size)
+{
+    int result = 0;
+
+    while (size > 0)
+    {
+        ssize_t sent = send(socket, buffer, size, MSG_NOSIGNAL);
+
+        if (sent > 0)
+        {
+            buffer += sent;
+            size -= (size_t)sent;
+        }
+        else if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd poll_fd;
+            poll_fd.fd = socket;
+            poll_fd.events = POLLOUT;
+            poll_fd.revents = 0;
+
+            if (poll(&poll_fd, 1, SEND_WAIT_TIMEOUT_MS) <= 0)
+            {
+                LogError("Timed out waiting for socket %d to become writable", socket);
+                result = __FAILURE__;
+                break;
+            }
+        }
+        else if (sent == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            LogError("Failed sending on socket %d (errno=%d)", socket, errno);
+            result = __FAILURE__;
+            break;
+        }
+    }
+
+    return result;
+}
+
+int perf_socket_wait_readable(int socket, int timeout_ms)
+{
+    int result;
+    struct pollfd poll_fd;
+
+    poll_fd.fd = socket;
+    poll_fd.events = POLLIN;
+    poll_fd.revents = 0;
+
+    if ((result = poll(&poll_fd, 1, timeout_ms)) > 0)
+    {
+        result = 1;
+    }
+
+    return result;
+}
+
+void perf_socket_close(int socket)
+{
+    if (socket != -1)
+    {
+        (void)close(socket);
+    }
+}
+
+int perf_socket_create_wakeup(int wakeup[2])
+{
+    int result;
+
+    if (pipe(wakeup) != 0)
+    {
+        LogError("Failed creating wakeup pipe (errno=%d)", errno);
+        result = __FAILURE__;
+    }
+    else if (set_non_blocking(wakeup[0]) != 0 || set_non_blocking(wakeup[1]) != 0)
+    {
+        perf_socket_destroy_wakeup(wakeup);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+void perf_socket_signal_wakeup(int wakeup[2])
+{
+    unsigned char signal = 1;
+
+    if (write(wakeup[1], &signal, 1) != 1)
+    {
+        // A full pipe already guarantees a wakeup, so a failed write is not an error.
+    }
+}
+
+void perf_socket_drain_wakeup(int wakeup[2])
+{
+    unsigned char buffer[64];
+
+    while (read(wakeup[0], buffer, sizeof(buffer)) > 0)
+    {
+    }
+}
+
+void perf_socket_destroy_wakeup(int wakeup[2])
+{
+    (void)close(wakeup[0]);
+    (void)close(wakeup[1]);
+    wakeup[0] = -1;
+    wakeup[1] = -1;
+}
@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_SOCKET_H
+#define PERF_SOCKET_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Minimal loopback socket helpers shared by the fake endpoints. All sockets returned are non-blocking.
+
+// Listens on 127.0.0.1 on an ephemeral port; returns the socket (and sets `port`) or -1 on failure.
+extern int perf_socket_listen(int* port);
+// Accepts one pending connection (TCP_NODELAY set); returns -1 if there is none.
+extern int perf_socket_accept(int listen_socket);
+// Connects to 127.0.0.1:`port` (TCP_NODELAY set); returns the socket or -1 on failure.
+extern int perf_socket_connect(int port);
+// Sends the whole buffer, waiting for the socket to become writable if needed. Returns 0 on success.
+extern int perf_socket_send_all(int socket, const unsigned char* buffer, size_t size);
+// Waits up to `timeout_ms` for the socket to become readable. Returns 1 if readable, 0 on timeout, -1 on error.
+extern int perf_socket_wait_readable(int socket, int timeout_ms);
+extern void perf_socket_close(int socket);
+
+// Self-pipe used to wake up an endpoint thread blocked in poll() when a request is queued.
+extern int perf_socket_create_wakeup(int wakeup[2]);
+extern void perf_socket_signal_wakeup(int wakeup[2]);
+extern void perf_socket_drain_wakeup(int wakeup[2]);
+extern void perf_socket_destroy_wakeup(int wakeup[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_SOCKET_H */
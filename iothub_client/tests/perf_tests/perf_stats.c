@@ -0,0 +1,270 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/vector.h"
+
+#include "perf_stats.h"
+
+typedef struct PERF_LATENCY_TAG
+{
+    VECTOR_HANDLE samples;
+} PERF_LATENCY;
+
+#ifdef PERF_COUNT_ALLOCATIONS
+// The executable is linked with --wrap for these functions, so every allocation of the SDK and of the harness goes
+// through the wrappers below and is counted on the thread that makes it.
+extern void* __real_malloc(size_t size);
+extern void* __real_calloc(size_t count, size_t size);
+extern void* __real_realloc(void* ptr, size_t size);
+
+static __thread uint64_t thread_allocation_count;
+
+void* __wrap_malloc(size_t size)
+{
+    thread_allocation_count++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    thread_allocation_count++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    thread_allocation_count++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static uint64_t timespec_to_us(const struct timespec* value)
+{
+    return (uint64_t)value->tv_sec * 1000000 + (uint64_t)value->tv_nsec / 1000;
+}
+
+static uint64_t timeval_to_us(const struct timeval* value)
+{
+    return (uint64_t)value->tv_sec * 1000000 + (uint64_t)value->tv_usec;
+}
+
+static int compare_samples(const void* left, const void* right)
+{
+    uint64_t left_value = *(const uint64_t*)left;
+    uint64_t right_value = *(const uint64_t*)right;
+
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+// Nearest-rank percentile over sorted samples; `per_mille` is the percentile times 10 (e.g. 999 for p99.9).
+static uint64_t get_percentile(const uint64_t* sorted_samples, size_t count, size_t per_mille)
+{
+    size_t rank = (count * per_mille + 999) / 1000;
+
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    return sorted_samples[rank - 1];
+}
+
+uint64_t perf_get_time_us(void)
+{
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    {
+        LogError("clock_gettime(CLOCK_MONOTONIC) failed");
+        now.tv_sec = 0;
+        now.tv_nsec = 0;
+    }
+
+    return timespec_to_us(&now);
+}
+
+PERF_LATENCY_HANDLE perf_latency_create(void)
+{
+    PERF_LATENCY* result;
+
+    if ((result = (PERF_LATENCY*)malloc(sizeof(PERF_LATENCY))) == NULL)
+    {
+        LogError("Failed allocating latency recorder");
+    }
+    else if ((result->samples = VECTOR_create(sizeof(uint64_t))) == NULL)
+    {
+        LogError("Failed creating latency samples vector");
+        free(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+int perf_latency_add_sample(PERF_LATENCY_HANDLE latency, uint64_t sample_us)
+{
+    int result;
+
+    if (latency == NULL)
+    {
+        LogError("Invalid argument (latency is NULL)");
+        result = __FAILURE__;
+    }
+    else if (VECTOR_push_back(latency->samples, &sample_us, 1) != 0)
+    {
+        LogError("Failed storing latency sample");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+size_t perf_latency_get_count(PERF_LATENCY_HANDLE latency)
+{
+    return (latency == NULL) ? 0 : VECTOR_size(latency->samples);
+}
+
+int perf_latency_get_summary(PERF_LATENCY_HANDLE latency, PERF_LATENCY_SUMMARY* summary)
+{
+    int result;
+
+    if (latency == NULL || summary == NULL)
+    {
+        LogError("Invalid argument (latency=%p, summary=%p)", latency, summary);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t count = VECTOR_size(latency->samples);
+
+        memset(summary, 0, sizeof(PERF_LATENCY_SUMMARY));
+
+        if (count == 0)
+        {
+            result = 0;
+        }
+        else
+        {
+            uint64_t* sorted_samples;
+
+            if ((sorted_samples = (uint64_t*)malloc(count * sizeof(uint64_t))) == NULL)
+            {
+                LogError("Failed allocating %lu latency samples", (unsigned long)count);
+                result = __FAILURE__;
+            }
+            else
+            {
+                uint64_t total = 0;
+                size_t i;
+
+                (void)memcpy(sorted_samples, VECTOR_front(latency->samples), count * sizeof(uint64_t));
+                qsort(sorted_samples, count, sizeof(uint64_t), compare_samples);
+
+                for (i = 0; i < count; i++)
+                {
+                    total += sorted_samples[i];
+                }
+
+                summary->count = count;
+                summary->min_us = sorted_samples[0];
+                summary->max_us = sorted_samples[count - 1];
+                summary->mean_us = total / count;
+                summary->p50_us = get_percentile(sorted_samples, count, 500);
+                summary->p99_us = get_percentile(sorted_samples, count, 990);
+                summary->p999_us = get_percentile(sorted_samples, count, 999);
+
+                free(sorted_samples);
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+void perf_latency_destroy(PERF_LATENCY_HANDLE latency)
+{
+    if (latency != NULL)
+    {
+        VECTOR_destroy(latency->samples);
+        free(latency);
+    }
+}
+
+int perf_get_process_usage(PERF_PROCESS_USAGE* usage)
+{
+    int result;
+    struct rusage process_usage;
+    struct timespec thread_cpu;
+
+    if (usage == NULL)
+    {
+        LogError("Invalid argument (usage is NULL)");
+        result = __FAILURE__;
+    }
+    else if (getrusage(RUSAGE_SELF, &process_usage) != 0)
+    {
+        LogError("getrusage failed");
+        result = __FAILURE__;
+    }
+    else if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread_cpu) != 0)
+    {
+        LogError("clock_gettime(CLOCK_THREAD_CPUTIME_ID) failed");
+        result = __FAILURE__;
+    }
+    else
+    {
+        usage->user_cpu_us = timeval_to_us(&process_usage.ru_utime);
+        usage->system_cpu_us = timeval_to_us(&process_usage.ru_stime);
+        usage->thread_cpu_us = timespec_to_us(&thread_cpu);
+#ifdef __APPLE__
+        // ru_maxrss is reported in bytes on macOS and in kilobytes elsewhere.
+        usage->max_rss_kb = (uint64_t)process_usage.ru_maxrss / 1024;
+#else
+        usage->max_rss_kb = (uint64_t)process_usage.ru_maxrss;
+#endif
+        usage->rss_kb = usage->max_rss_kb;
+#ifdef PERF_COUNT_ALLOCATIONS
+        usage->thread_allocations = thread_allocation_count;
+#else
+        usage->thread_allocations = 0;
+#endif
+
+#ifdef __linux__
+        {
+            FILE* statm = fopen("/proc/self/statm", "r");
+
+            if (statm != NULL)
+            {
+                unsigned long total_pages;
+                unsigned long resident_pages;
+
+                if (fscanf(statm, "%lu %lu", &total_pages, &resident_pages) == 2)
+                {
+                    usage->rss_kb = (uint64_t)resident_pages * (uint64_t)sysconf(_SC_PAGESIZE) / 1024;
+                }
+
+                (void)fclose(statm);
+            }
+        }
+#endif
+        result = 0;
+    }
+
+    return result;
+}
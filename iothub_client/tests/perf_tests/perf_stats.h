@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct PERF_LATENCY_SUMMARY_TAG
+{
+    size_t count;
+    uint64_t min_us;
+    uint64_t max_us;
+    uint64_t mean_us;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t p999_us;
+} PERF_LATENCY_SUMMARY;
+
+typedef struct PERF_PROCESS_USAGE_TAG
+{
+    // CPU consumed by the whole process (client, fake endpoint and harness).
+    uint64_t user_cpu_us;
+    uint64_t system_cpu_us;
+    // CPU consumed by the calling thread only, i.e. the thread driving IoTHubClient_LL_DoWork.
+    uint64_t thread_cpu_us;
+    uint64_t max_rss_kb;
+    // Current resident set size; equals max_rss_kb where the platform does not expose it.
+    uint64_t rss_kb;
+    // malloc, calloc and realloc calls made by the calling thread; 0 where they are not counted (see
+    // PERF_COUNT_ALLOCATIONS in CMakeLists.txt).
+    uint64_t thread_allocations;
+} PERF_PROCESS_USAGE;
+
+typedef struct PERF_LATENCY_TAG* PERF_LATENCY_HANDLE;
+
+// Monotonic clock with microsecond resolution; only differences between two readings are meaningful.
+extern uint64_t perf_get_time_us(void);
+
+extern PERF_LATENCY_HANDLE perf_latency_create(void);
+extern int perf_latency_add_sample(PERF_LATENCY_HANDLE latency, uint64_t sample_us);
+extern size_t perf_latency_get_count(PERF_LATENCY_HANDLE latency);
+// Percentiles use the nearest-rank method over all samples recorded (no bucketing).
+extern int perf_latency_get_summary(PERF_LATENCY_HANDLE latency, PERF_LATENCY_SUMMARY* summary);
+extern void perf_latency_destroy(PERF_LATENCY_HANDLE latency);
+
+extern int perf_get_process_usage(PERF_PROCESS_USAGE* usage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_STATS_H */
@@ -59,6 +59,8 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_MAP_HANDLE (MAP_HANDLE)0x103
 #define TEST_AMQP_VALUE (AMQP_VALUE)0x104
 #define TEST_PROPERTIES_HANDLE (PROPERTIES_HANDLE)0x107
+#define TEST_TEMPLATE_MAP_HANDLE (MAP_HANDLE)0x108
+#define TEST_TEMPLATE_AMQP_VALUE (AMQP_VALUE)0x109
 
 static char** TEST_MAP_KEYS;
 static char** TEST_MAP_VALUES;
@@ -94,6 +96,19 @@ int test_properties_get_correlation_id(PROPERTIES_HANDLE properties, AMQP_VALUE*
     return saved_properties_get_correlation_id_return;
 }
 
+static IOTHUB_MESSAGE_PROPERTIES_LOADER saved_properties_loader;
+static IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY saved_properties_loader_context_destroy;
+static void* saved_properties_loader_context;
+
+IOTHUB_MESSAGE_RESULT test_IoTHubMessage_SetPropertiesLoader(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, IOTHUB_MESSAGE_PROPERTIES_LOADER propertiesLoader, IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY contextDestroy, void* context)
+{
+    (void)iotHubMessageHandle;
+    saved_properties_loader = propertiesLoader;
+    saved_properties_loader_context_destroy = contextDestroy;
+    saved_properties_loader_context = context;
+    return IOTHUB_MESSAGE_OK;
+}
+
 int test_amqpvalue_get_string(AMQP_VALUE value, const char** string_value)
 {
     saved_amqpvalue_get_string_value = value;
@@ -196,6 +211,37 @@ static void set_exp_calls_for_addApplicationPropertiesTouAMQPMessage(size_t numb
     }
 }
 
+static void set_exp_calls_for_string_message_with_properties(void)
+{
+    BINARY_DATA test_binary_data;
+    test_binary_data.bytes = (const unsigned char*)TEST_STRING;
+    test_binary_data.length = strlen(TEST_STRING);
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(IOTHUBMESSAGE_STRING);
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetString(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_STRING);
+    STRICT_EXPECTED_CALL(message_create()).SetReturn(TEST_MESSAGE_HANDLE);
+    STRICT_EXPECTED_CALL(message_add_body_amqp_data(TEST_MESSAGE_HANDLE, test_binary_data))
+        .IgnoreArgument(2).SetReturn(0);
+    set_exp_calls_for_addPropertiesTouAMQPMessage(true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+}
+
+static void set_exp_calls_for_template_cache_hit(size_t number_of_app_properties, int message_set_application_properties_result)
+{
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4)
+        .CopyOutArgumentBuffer_keys(&TEST_MAP_KEYS, sizeof(char**))
+        .CopyOutArgumentBuffer_values(&TEST_MAP_VALUES, sizeof(char**))
+        .CopyOutArgumentBuffer_count(&number_of_app_properties, sizeof(size_t));
+    STRICT_EXPECTED_CALL(Map_GetInternals(TEST_TEMPLATE_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4)
+        .CopyOutArgumentBuffer_keys(&TEST_MAP_KEYS, sizeof(char**))
+        .CopyOutArgumentBuffer_values(&TEST_MAP_VALUES, sizeof(char**))
+        .CopyOutArgumentBuffer_count(&number_of_app_properties, sizeof(size_t));
+    STRICT_EXPECTED_CALL(message_set_application_properties(TEST_MESSAGE_HANDLE, TEST_TEMPLATE_AMQP_VALUE))
+        .SetReturn(message_set_application_properties_result);
+}
+
 static void set_exp_calls_for_message_create_from_iothub_message(
     size_t number_of_app_properties, 
     IOTHUBMESSAGE_CONTENT_TYPE msg_content_type, 
@@ -231,7 +277,6 @@ static void set_exp_calls_for_message_create_from_iothub_message(
 }
 
 static void set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(
-    size_t number_of_properties, 
     bool has_message_id, 
     bool has_correlation_id, 
     bool has_properties, 
@@ -304,35 +349,16 @@ static void set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(
     STRICT_EXPECTED_CALL(properties_destroy(TEST_PROPERTIES_HANDLE));
 
     // readApplicationPropertiesFromuAMQPMessage
-    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_MAP_HANDLE);
-
     if (has_properties)
     {
         STRICT_EXPECTED_CALL(message_get_application_properties(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG))
             .IgnoreArgument(2)
             .CopyOutArgumentBuffer_application_properties(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE));
         STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(TEST_AMQP_VALUE));
-        STRICT_EXPECTED_CALL(amqpvalue_get_map_pair_count(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .CopyOutArgumentBuffer_pair_count((uint32_t *)&number_of_properties, sizeof(uint32_t));
-
-        size_t i;
-        for (i = 0; i < number_of_properties; i++)
-        {
-            STRICT_EXPECTED_CALL(amqpvalue_get_map_key_value_pair(TEST_AMQP_VALUE, (uint32_t)i, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-                .IgnoreArgument_key().IgnoreArgument_value()
-                .CopyOutArgumentBuffer_key(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE))
-                .CopyOutArgumentBuffer_value(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE));
-            STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
-                .IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_KEYS[i], sizeof(char*));
-            STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
-                .IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_VALUES[i], sizeof(char*));
-            STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_MAP_HANDLE, TEST_MAP_KEYS[i], TEST_MAP_VALUES[i]));
-            STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
-            STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
-        }
-
-        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+        STRICT_EXPECTED_CALL(amqpvalue_get_type(TEST_AMQP_VALUE)).SetReturn(AMQP_TYPE_MAP);
+        STRICT_EXPECTED_CALL(IoTHubMessage_SetPropertiesLoader(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_AMQP_VALUE))
+            .IgnoreArgument_propertiesLoader()
+            .IgnoreArgument_contextDestroy();
     }
     else
     {
@@ -340,6 +366,31 @@ static void set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(
     }
 }
 
+static void set_exp_calls_for_loading_application_properties(size_t number_of_properties)
+{
+    size_t i;
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(TEST_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_pair_count(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .CopyOutArgumentBuffer_pair_count((uint32_t *)&number_of_properties, sizeof(uint32_t));
+
+    for (i = 0; i < number_of_properties; i++)
+    {
+        STRICT_EXPECTED_CALL(amqpvalue_get_map_key_value_pair(TEST_AMQP_VALUE, (uint32_t)i, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_key().IgnoreArgument_value()
+            .CopyOutArgumentBuffer_key(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE))
+            .CopyOutArgumentBuffer_value(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE));
+        STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
+            .IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_KEYS[i], sizeof(char*));
+        STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
+            .IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_VALUES[i], sizeof(char*));
+        STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_MAP_HANDLE, TEST_MAP_KEYS[i], TEST_MAP_VALUES[i]));
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+    }
+}
+
 
 BEGIN_TEST_SUITE(uamqp_messaging_ut)
 
@@ -366,10 +417,17 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_TYPE, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_PROPERTIES_LOADER, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_PROPERTIES_LOADER_CONTEXT_DESTROY, void*);
 
     REGISTER_GLOBAL_MOCK_HOOK(properties_get_message_id, test_properties_get_message_id);
     REGISTER_GLOBAL_MOCK_HOOK(properties_get_correlation_id, test_properties_get_correlation_id);
     REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_get_string, test_amqpvalue_get_string);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetPropertiesLoader, test_IoTHubMessage_SetPropertiesLoader);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_SetPropertiesLoader, IOTHUB_MESSAGE_ERROR);
 
     REGISTER_GLOBAL_MOCK_RETURN(message_get_properties, 0);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_get_properties, 1);
@@ -393,6 +451,8 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_Properties, NULL);
 
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_GetInternals, MAP_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Map_Clone, TEST_TEMPLATE_MAP_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_Clone, NULL);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_create_map, NULL);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_set_map_value, 1);
 
@@ -412,6 +472,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_inplace_described_value, TEST_AMQP_VALUE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_inplace_described_value, NULL);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_type, AMQP_TYPE_LIST);
 
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_map_key_value_pair, 0);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_map_key_value_pair, 1);
@@ -777,24 +838,15 @@ TEST_FUNCTION(message_create_from_iothub_message_STRING_return_errors_fails)
 // Tests_SRS_UAMQP_MESSAGING_09_022: [The correlation-id value shall be retrieved from the AMQP_VALUE as char* by calling amqpvalue_get_string.]
 // Tests_SRS_UAMQP_MESSAGING_09_024: [The correlation-id property shall be set on the IOTHUB_MESSAGE_HANDLE by calling IoTHubMessage_SetCorrelationId, passing the value read from the uAMQP message.]
 // Tests_SRS_UAMQP_MESSAGING_09_026: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message properties (obtained with message_get_properties()) by calling properties_destroy().]
-// Tests_SRS_UAMQP_MESSAGING_09_027: [The IOTHUB_MESSAGE_HANDLE properties shall be retrieved using IoTHubMessage_Properties.]
 // Tests_SRS_UAMQP_MESSAGING_09_029: [The uAMQP message application properties shall be retrieved using message_get_application_properties.]
-// Tests_SRS_UAMQP_MESSAGING_09_032: [The actual uAMQP message application properties should be extracted from the result of message_get_application_properties using amqpvalue_get_inplace_described_value.]
-// Tests_SRS_UAMQP_MESSAGING_09_034: [The number of items in the uAMQP message application properties shall be obtained using amqpvalue_get_map_pair_count.]
-// Tests_SRS_UAMQP_MESSAGING_09_036: [IoTHubMessage_CreateFromuAMQPMessage() shall iterate through each uAMQP application property and add it to IOTHUB_MESSAGE_HANDLE properties.]
-// Tests_SRS_UAMQP_MESSAGING_09_037: [The uAMQP application property name and value shall be obtained using amqpvalue_get_map_key_value_pair.]
-// Tests_SRS_UAMQP_MESSAGING_09_039: [The uAMQP application property name shall be extracted as string using amqpvalue_get_string.]
-// Tests_SRS_UAMQP_MESSAGING_09_041: [The uAMQP application property value shall be extracted as string using amqpvalue_get_string.]
-// Tests_SRS_UAMQP_MESSAGING_09_043: [The application property name and value shall be added to IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate.]
-// Tests_SRS_UAMQP_MESSAGING_09_045: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property name and value (obtained with amqpvalue_get_string) by calling amqpvalue_destroy().]
-// Tests_SRS_UAMQP_MESSAGING_09_046: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property (obtained with message_get_application_properties) by calling amqpvalue_destroy().]
+// Tests_SRS_UAMQP_MESSAGING_09_112: [The application properties shall not be decoded by IoTHubMessage_CreateFromuAMQPMessage(); they shall be handed over to the IOTHUB_MESSAGE_HANDLE using IoTHubMessage_SetPropertiesLoader, so that they are only decoded when the IOTHUB_MESSAGE_HANDLE properties are first accessed.]
 // Tests_SRS_UAMQP_MESSAGING_09_100: [If the uamqp message contains property `content-type`, it shall be set on IOTHUB_MESSAGE_HANDLE]
 // Tests_SRS_UAMQP_MESSAGING_09_103: [If the uAMQP message contains property `content-encoding`, it shall be set on IOTHUB_MESSAGE_HANDLE]
 TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_success)
 {
     // arrange
     umock_c_reset_all_calls();
-    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(1, true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
 
     // act
     IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
@@ -813,7 +865,7 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_message_id_success)
 {
     // arrange
     umock_c_reset_all_calls();
-    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(1, false, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(false, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
 
     // act
     IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
@@ -832,7 +884,7 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_correlation_id_success)
 {
     // arrange
     umock_c_reset_all_calls();
-    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(1, true, false, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, false, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
 
     // act
     IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
@@ -856,14 +908,9 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_correlation_id_success)
 // Tests_SRS_UAMQP_MESSAGING_09_019: [If properties_get_correlation_id() fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_023: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_025: [If IoTHubMessage_SetCorrelationId fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_028: [If IoTHubMessage_Properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_030: [If message_get_application_properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_033: [If amqpvalue_get_inplace_described_value fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_035: [If amqpvalue_get_map_pair_count fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_038: [If amqpvalue_get_map_key_value_pair fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_040: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_042: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_044: [If Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+// Tests_SRS_UAMQP_MESSAGING_09_123: [IoTHubMessage_CreateFromuAMQPMessage() shall check that the application properties (extracted using amqpvalue_get_inplace_described_value) are a map using amqpvalue_get_type, without decoding them; otherwise it shall destroy the application properties and fail.]
+// Tests_SRS_UAMQP_MESSAGING_09_113: [If IoTHubMessage_SetPropertiesLoader fails, IoTHubMessage_CreateFromuAMQPMessage() shall destroy the application properties and fail.]
 // Tests_SRS_UAMQP_MESSAGING_09_101: [If retrieving the `content-type` property from uAMQP message fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_102: [If setting the `content-type` property on IOTHUB_MESSAGE_HANDLE fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_104: [If retrieving the `content-encoding` property from uAMQP message fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
@@ -875,7 +922,7 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_error_returns_fails)
 
 
     umock_c_reset_all_calls();
-    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(1, true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
     umock_c_negative_tests_snapshot();
 
     // act
@@ -888,7 +935,7 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_error_returns_fails)
         umock_c_negative_tests_fail_call(i);
 
         // act
-        if (i == 4 || i == 5 || i == 8 || i == 9 || i == 12 || i == 14 || i == 16 || i == 25 || i == 26 || i == 27)
+        if (i == 4 || i == 5 || i == 8 || i == 9 || i == 12 || i == 14 || i == 16)
         {
             continue; // these lines have functions that do not return anything (void).
         }
@@ -911,7 +958,7 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_app_properties_success)
 {
     // arrange
     umock_c_reset_all_calls();
-    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(0, true, true, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, true, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
 
     // act
     IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
@@ -925,4 +972,365 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_app_properties_success)
     // cleanup
 }
 
+// Tests_SRS_UAMQP_MESSAGING_09_032: [The actual uAMQP message application properties should be extracted from the result of message_get_application_properties using amqpvalue_get_inplace_described_value.]
+// Tests_SRS_UAMQP_MESSAGING_09_034: [The number of items in the uAMQP message application properties shall be obtained using amqpvalue_get_map_pair_count.]
+// Tests_SRS_UAMQP_MESSAGING_09_036: [Loading the application properties shall iterate through each uAMQP application property and add it to IOTHUB_MESSAGE_HANDLE properties.]
+// Tests_SRS_UAMQP_MESSAGING_09_037: [The uAMQP application property name and value shall be obtained using amqpvalue_get_map_key_value_pair.]
+// Tests_SRS_UAMQP_MESSAGING_09_039: [The uAMQP application property name shall be extracted as string using amqpvalue_get_string.]
+// Tests_SRS_UAMQP_MESSAGING_09_041: [The uAMQP application property value shall be extracted as string using amqpvalue_get_string.]
+// Tests_SRS_UAMQP_MESSAGING_09_043: [The application property name and value shall be added to IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate.]
+// Tests_SRS_UAMQP_MESSAGING_09_045: [The uAMQP message property name and value (obtained with amqpvalue_get_map_key_value_pair) shall be destroyed by calling amqpvalue_destroy().]
+TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_properties_loader_success)
+{
+    // arrange
+    IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
+    umock_c_reset_all_calls();
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    (void)IoTHubMessage_CreateFromUamqpMessage(TEST_MESSAGE_HANDLE, &iothub_client_message);
+    umock_c_reset_all_calls();
+
+    set_exp_calls_for_loading_application_properties(2);
+
+    // act
+    int result = saved_properties_loader(saved_properties_loader_context, TEST_MAP_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, result, 0);
+
+    // cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_033: [If amqpvalue_get_inplace_described_value fails, loading the application properties shall fail.]
+// Tests_SRS_UAMQP_MESSAGING_09_035: [If amqpvalue_get_map_pair_count fails, loading the application properties shall fail.]
+// Tests_SRS_UAMQP_MESSAGING_09_038: [If amqpvalue_get_map_key_value_pair fails, loading the application properties shall fail.]
+// Tests_SRS_UAMQP_MESSAGING_09_040: [If amqpvalue_get_string fails, loading the application properties shall fail.]
+// Tests_SRS_UAMQP_MESSAGING_09_042: [If amqpvalue_get_string fails, loading the application properties shall fail.]
+// Tests_SRS_UAMQP_MESSAGING_09_044: [If Map_AddOrUpdate fails, loading the application properties shall fail.]
+TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_properties_loader_error_returns_fails)
+{
+    // arrange
+    IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
+    umock_c_reset_all_calls();
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    (void)IoTHubMessage_CreateFromUamqpMessage(TEST_MESSAGE_HANDLE, &iothub_client_message);
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+    umock_c_reset_all_calls();
+    set_exp_calls_for_loading_application_properties(1);
+    umock_c_negative_tests_snapshot();
+
+    // act
+    for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        // arrange
+        char error_msg[64];
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        if (i == 6 || i == 7)
+        {
+            continue; // these lines have functions that do not return anything (void).
+        }
+
+        int result = saved_properties_loader(saved_properties_loader_context, TEST_MAP_HANDLE);
+
+        sprintf(error_msg, "On failed call %zu", i);
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, result, 0, error_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_reset();
+    umock_c_negative_tests_deinit();
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_046: [The uAMQP message application properties (obtained with message_get_application_properties) shall be destroyed by calling amqpvalue_destroy() once they are loaded or the IOTHUB_MESSAGE_HANDLE is destroyed.]
+TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_properties_loader_context_destroy_destroys_the_application_properties)
+{
+    // arrange
+    IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
+    umock_c_reset_all_calls();
+    set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(true, true, true, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+    (void)IoTHubMessage_CreateFromUamqpMessage(TEST_MESSAGE_HANDLE, &iothub_client_message);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+
+    // act
+    saved_properties_loader_context_destroy(saved_properties_loader_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
+static void set_exp_calls_for_message_create_from_iothub_message_with_template(size_t number_of_app_properties, bool has_cached_properties, size_t number_of_cached_properties, bool Map_Clone_succeeds)
+{
+    set_exp_calls_for_string_message_with_properties();
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4)
+        .CopyOutArgumentBuffer_keys(&TEST_MAP_KEYS, sizeof(char**))
+        .CopyOutArgumentBuffer_values(&TEST_MAP_VALUES, sizeof(char**))
+        .CopyOutArgumentBuffer_count(&number_of_app_properties, sizeof(size_t));
+
+    if (has_cached_properties)
+    {
+        STRICT_EXPECTED_CALL(Map_GetInternals(TEST_TEMPLATE_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4)
+            .CopyOutArgumentBuffer_keys(&TEST_MAP_KEYS, sizeof(char**))
+            .CopyOutArgumentBuffer_values(&TEST_MAP_VALUES, sizeof(char**))
+            .CopyOutArgumentBuffer_count(&number_of_cached_properties, sizeof(size_t));
+    }
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_map()).SetReturn(TEST_TEMPLATE_AMQP_VALUE);
+
+    size_t i;
+    for (i = 0; i < number_of_app_properties; i++)
+    {
+        STRICT_EXPECTED_CALL(amqpvalue_create_string(TEST_MAP_KEYS[i]));
+        STRICT_EXPECTED_CALL(amqpvalue_create_string(TEST_MAP_VALUES[i]));
+        STRICT_EXPECTED_CALL(amqpvalue_set_map_value(TEST_TEMPLATE_AMQP_VALUE, TEST_AMQP_VALUE, TEST_AMQP_VALUE));
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+    }
+
+    STRICT_EXPECTED_CALL(message_set_application_properties(TEST_MESSAGE_HANDLE, TEST_TEMPLATE_AMQP_VALUE));
+
+    if (!Map_Clone_succeeds)
+    {
+        STRICT_EXPECTED_CALL(Map_Clone(TEST_MAP_HANDLE)).SetReturn(NULL);
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_TEMPLATE_AMQP_VALUE));
+    }
+    else if (has_cached_properties)
+    {
+        STRICT_EXPECTED_CALL(Map_Clone(TEST_MAP_HANDLE));
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_TEMPLATE_AMQP_VALUE));
+        STRICT_EXPECTED_CALL(Map_Destroy(TEST_TEMPLATE_MAP_HANDLE));
+    }
+    else
+    {
+        STRICT_EXPECTED_CALL(Map_Clone(TEST_MAP_HANDLE));
+    }
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_114: [uamqp_message_template_create() shall allocate memory for the template and return its handle, with no application properties cached.]
+TEST_FUNCTION(uamqp_message_template_create_success)
+{
+    // arrange
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
+
+    // act
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(message_template);
+
+    // cleanup
+    uamqp_message_template_destroy(message_template);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_115: [If malloc() fails, uamqp_message_template_create() shall return NULL.]
+TEST_FUNCTION(uamqp_message_template_create_malloc_fails)
+{
+    // arrange
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG)).SetReturn(NULL);
+
+    // act
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(message_template);
+
+    // cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_116: [If message_template is NULL, uamqp_message_template_destroy() shall return.]
+TEST_FUNCTION(uamqp_message_template_destroy_NULL_handle)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    uamqp_message_template_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_117: [uamqp_message_template_destroy() shall destroy the cached application properties (using amqpvalue_destroy() and Map_Destroy()) and free the template.]
+TEST_FUNCTION(uamqp_message_template_destroy_with_cached_properties)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(2, false, 0, true);
+    ASSERT_ARE_EQUAL(int, 0, message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message));
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_TEMPLATE_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(Map_Destroy(TEST_TEMPLATE_MAP_HANDLE));
+    STRICT_EXPECTED_CALL(free(message_template));
+
+    // act
+    uamqp_message_template_destroy(message_template);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_118: [If message_template is NULL, message_create_from_iothub_message_with_template() shall fail and return.]
+TEST_FUNCTION(message_create_from_iothub_message_with_template_NULL_template)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = message_create_from_iothub_message_with_template(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, result, 0);
+    ASSERT_IS_NULL(uamqp_message);
+
+    // cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_121: [After a uAMQP application properties map is encoded, it shall be stored in the template together with a copy of the IOTHUB_MESSAGE_HANDLE properties obtained with Map_Clone, replacing (and destroying) the previously stored ones.]
+TEST_FUNCTION(message_create_from_iothub_message_with_template_first_message_caches_properties)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(2, false, 0, true);
+
+    // act
+    int result = message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, result, 0);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)uamqp_message, (void*)TEST_MESSAGE_HANDLE);
+
+    // cleanup
+    uamqp_message_template_destroy(message_template);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_119: [If a template is used and the IOTHUB_MESSAGE_HANDLE properties have the same keys and values (in the same order) as the ones the template application properties map was encoded from, that map shall be set on the uAMQP message by calling message_set_application_properties() and no new uAMQP values shall be created.]
+TEST_FUNCTION(message_create_from_iothub_message_with_template_same_properties_reuses_the_encoded_map)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(2, false, 0, true);
+    ASSERT_ARE_EQUAL(int, 0, message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message));
+
+    umock_c_reset_all_calls();
+    set_exp_calls_for_string_message_with_properties();
+    set_exp_calls_for_template_cache_hit(2, 0);
+
+    // act
+    int result = message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, result, 0);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)uamqp_message, (void*)TEST_MESSAGE_HANDLE);
+
+    // cleanup
+    uamqp_message_template_destroy(message_template);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_121: [After a uAMQP application properties map is encoded, it shall be stored in the template together with a copy of the IOTHUB_MESSAGE_HANDLE properties obtained with Map_Clone, replacing (and destroying) the previously stored ones.]
+TEST_FUNCTION(message_create_from_iothub_message_with_template_different_properties_replaces_the_encoded_map)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(1, false, 0, true);
+    ASSERT_ARE_EQUAL(int, 0, message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message));
+
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(2, true, 1, true);
+
+    // act
+    int result = message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, result, 0);
+
+    // cleanup
+    uamqp_message_template_destroy(message_template);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_122: [If Map_Clone fails, the template shall be left unchanged, the encoded map shall be destroyed and message_create_from_iothub_message_with_template() shall not fail.]
+TEST_FUNCTION(message_create_from_iothub_message_with_template_Map_Clone_fails)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(2, false, 0, false);
+
+    // act
+    int result = message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, result, 0);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)uamqp_message, (void*)TEST_MESSAGE_HANDLE);
+
+    // cleanup
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(free(message_template));
+    uamqp_message_template_destroy(message_template);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_UAMQP_MESSAGING_09_120: [If message_set_application_properties() fails, message_create_from_iothub_message_with_template() shall fail and return immediately.]
+TEST_FUNCTION(message_create_from_iothub_message_with_template_set_cached_properties_fails)
+{
+    // arrange
+    MESSAGE_HANDLE uamqp_message = NULL;
+    UAMQP_MESSAGE_TEMPLATE_HANDLE message_template = uamqp_message_template_create();
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_from_iothub_message_with_template(2, false, 0, true);
+    ASSERT_ARE_EQUAL(int, 0, message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message));
+
+    uamqp_message = NULL;
+    umock_c_reset_all_calls();
+    set_exp_calls_for_string_message_with_properties();
+    set_exp_calls_for_template_cache_hit(2, 1);
+    STRICT_EXPECTED_CALL(message_destroy(TEST_MESSAGE_HANDLE));
+
+    // act
+    int result = message_create_from_iothub_message_with_template(message_template, TEST_IOTHUB_MESSAGE_HANDLE, &uamqp_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, result, 0);
+    ASSERT_IS_NULL(uamqp_message);
+
+    // cleanup
+    uamqp_message_template_destroy(message_template);
+}
+
 END_TEST_SUITE(uamqp_messaging_ut)
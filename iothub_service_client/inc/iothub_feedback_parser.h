@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// This file is under development and it is subject to change
+
+#ifndef IOTHUB_FEEDBACK_PARSER_H
+#define IOTHUB_FEEDBACK_PARSER_H
+
+#include <stddef.h>
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "iothub_messaging_ll.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#else
+#endif
+
+#define FEEDBACK_PARSER_RESULT_VALUES    \
+    FEEDBACK_PARSER_RECORD,              \
+    FEEDBACK_PARSER_END,                 \
+    FEEDBACK_PARSER_ERROR                \
+
+DEFINE_ENUM(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RESULT_VALUES);
+
+typedef struct FEEDBACK_PARSER_TAG* FEEDBACK_PARSER_HANDLE;
+
+/** @brief	Creates a parser of the JSON array of feedback records sent by IoT Hub on the feedback link.
+*
+*			The parser reads the records one at a time, without building the JSON document, and decodes
+*			their strings into a buffer that it keeps and reuses from one record (and one feedback message)
+*			to the next.
+*
+* @return	A non-NULL @c FEEDBACK_PARSER_HANDLE value, or @c NULL on failure.
+*/
+MOCKABLE_FUNCTION(, FEEDBACK_PARSER_HANDLE, feedback_parser_create);
+
+/** @brief	Frees the parser and its buffer.
+*
+* @param	parser	The handle created by a call to the create function.
+*/
+MOCKABLE_FUNCTION(, void, feedback_parser_destroy, FEEDBACK_PARSER_HANDLE, parser);
+
+/** @brief	Starts parsing the body of a feedback message. The body is not copied and must remain valid until the last record is read.
+*
+* @param	parser	The handle created by a call to the create function.
+* @param	json	The body of the feedback message, a JSON array of records (not necessarily null terminated).
+* @param	size	The size of @p json.
+*
+* @return	0 if @p json starts with a JSON array, a non-zero value otherwise.
+*/
+MOCKABLE_FUNCTION(, int, feedback_parser_begin, FEEDBACK_PARSER_HANDLE, parser, const unsigned char*, json, size_t, size);
+
+/** @brief	Reads the next record of the feedback message.
+*
+* @param	parser	The handle created by a call to the create function.
+* @param	record	Receives the record. Its strings point to the buffer of the parser and are valid until the next call
+*					to feedback_parser_get_next_record, feedback_parser_begin or feedback_parser_destroy.
+*
+* @return	FEEDBACK_PARSER_RECORD if @p record was read, FEEDBACK_PARSER_END at the end of the array, and
+*			FEEDBACK_PARSER_ERROR if the JSON is not valid (the records read before remain valid).
+*/
+MOCKABLE_FUNCTION(, FEEDBACK_PARSER_RESULT, feedback_parser_get_next_record, FEEDBACK_PARSER_HANDLE, parser, IOTHUB_SERVICE_FEEDBACK_RECORD*, record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTHUB_FEEDBACK_PARSER_H
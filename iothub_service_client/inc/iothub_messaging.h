@@ -90,6 +90,24 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_SendAsync, IOTHUB_M
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_SetFeedbackMessageCallback, IOTHUB_MESSAGING_CLIENT_HANDLE, messagingClientHandle, IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK, feedbackMessageReceivedCallback, void*, userContextCallback);
 
+/**
+* @brief	This API specifies a callback to be called with each feedback record, as it is parsed,
+*			instead of a batch holding all the records of a feedback message.
+*
+* @param	messagingClientHandle		        The handle created by a call to the create function.
+* @param	feedbackRecordReceivedCallback	    The callback specified by the user to be called with each feedback record.
+*									            The record is only valid during the call.
+*
+* @param	userContextCallback		            User specified context that will be provided to the
+* 									            callback. This can be @c NULL.
+*
+*			@b NOTE: The application behavior is undefined if the user calls
+*			the ::IoTHubMessaging_Destroy or IoTHubMessaging_Close function from within any callback.
+*
+* @return	IOTHUB_MESSAGING_OK upon success or an error code upon failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_SetFeedbackRecordCallback, IOTHUB_MESSAGING_CLIENT_HANDLE, messagingClientHandle, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, feedbackRecordReceivedCallback, void*, userContextCallback);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,700 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_feedback_parser.h"
+
+#define FEEDBACK_PARSER_INITIAL_STORAGE_SIZE 256
+
+#define FEEDBACK_PARSER_STATE_VALUES    \
+    FEEDBACK_PARSER_STATE_IDLE,         \
+    FEEDBACK_PARSER_STATE_FIRST_RECORD, \
+    FEEDBACK_PARSER_STATE_NEXT_RECORD,  \
+    FEEDBACK_PARSER_STATE_ENDED,        \
+    FEEDBACK_PARSER_STATE_FAILED
+
+DEFINE_ENUM(FEEDBACK_PARSER_STATE, FEEDBACK_PARSER_STATE_VALUES);
+
+/*the members of a record that are kept, in the order of FEEDBACK_RECORD_KEYS*/
+#define FEEDBACK_RECORD_MEMBER_DEVICE_ID 0
+#define FEEDBACK_RECORD_MEMBER_DEVICE_GENERATION_ID 1
+#define FEEDBACK_RECORD_MEMBER_DESCRIPTION 2
+#define FEEDBACK_RECORD_MEMBER_ENQUEUED_TIME_UTC 3
+#define FEEDBACK_RECORD_MEMBER_ORIGINAL_MESSAGE_ID 4
+#define FEEDBACK_RECORD_MEMBER_COUNT 5
+#define FEEDBACK_RECORD_MEMBER_NONE FEEDBACK_RECORD_MEMBER_COUNT
+
+#define NO_VALUE SIZE_MAX
+#define INVALID_CODE_POINT 0xFFFFFFFF
+
+static const char* FEEDBACK_RECORD_KEYS[FEEDBACK_RECORD_MEMBER_COUNT] =
+{
+    "deviceId",
+    "deviceGenerationId",
+    "description",
+    "enqueuedTimeUtc",
+    "originalMessageId"
+};
+
+typedef struct FEEDBACK_PARSER_TAG
+{
+    FEEDBACK_PARSER_STATE state;
+    const unsigned char* json;
+    size_t size;
+    size_t position;
+
+    /*the decoded strings of the current record; kept from one record to the next so that parsing does not allocate once it is large enough*/
+    char* storage;
+    size_t storageSize;
+    size_t storageUsed;
+} FEEDBACK_PARSER;
+
+static int is_whitespace(unsigned char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+static void skip_whitespace(FEEDBACK_PARSER* parser)
+{
+    while ((parser->position < parser->size) && is_whitespace(parser->json[parser->position]))
+    {
+        parser->position++;
+    }
+}
+
+/*skips the whitespace, then consumes c; returns 0 if c was found*/
+static int expect_character(FEEDBACK_PARSER* parser, unsigned char c)
+{
+    int result;
+
+    skip_whitespace(parser);
+    if ((parser->position < parser->size) && (parser->json[parser->position] == c))
+    {
+        parser->position++;
+        result = 0;
+    }
+    else
+    {
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static int peek_character(FEEDBACK_PARSER* parser, unsigned char c)
+{
+    skip_whitespace(parser);
+    return (parser->position < parser->size) && (parser->json[parser->position] == c);
+}
+
+static int ensure_storage(FEEDBACK_PARSER* parser, size_t needed)
+{
+    int result;
+
+    if (needed <= parser->storageSize)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newSize = (parser->storageSize == 0) ? FEEDBACK_PARSER_INITIAL_STORAGE_SIZE : parser->storageSize;
+        char* newStorage;
+
+        while (newSize < needed)
+        {
+            newSize *= 2;
+        }
+
+        if ((newStorage = (char*)realloc(parser->storage, newSize)) == NULL)
+        {
+            LogError("Failed growing the feedback record buffer to %lu bytes", (unsigned long)newSize);
+            result = __FAILURE__;
+        }
+        else
+        {
+            parser->storage = newStorage;
+            parser->storageSize = newSize;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int read_hex4(FEEDBACK_PARSER* parser, uint32_t* value)
+{
+    int result;
+
+    if (parser->size - parser->position < 4)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        *value = 0;
+        result = 0;
+        for (i = 0; (i < 4) && (result == 0); i++)
+        {
+            unsigned char c = parser->json[parser->position + i];
+            uint32_t digit;
+
+            if ((c >= '0') && (c <= '9'))
+            {
+                digit = c - '0';
+            }
+            else if ((c >= 'a') && (c <= 'f'))
+            {
+                digit = c - 'a' + 10;
+            }
+            else if ((c >= 'A') && (c <= 'F'))
+            {
+                digit = c - 'A' + 10;
+            }
+            else
+            {
+                digit = 0;
+                result = __FAILURE__;
+            }
+            *value = (*value << 4) | digit;
+        }
+        parser->position += 4;
+    }
+
+    return result;
+}
+
+/*decodes a \uXXXX escape (the "\u" already consumed), combining a surrogate pair, to UTF-8; returns the number of bytes written or 0 on failure*/
+static size_t decode_unicode_escape(FEEDBACK_PARSER* parser, char* output)
+{
+    size_t result;
+    uint32_t codePoint;
+
+    if (read_hex4(parser, &codePoint) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        if ((codePoint >= 0xD800) && (codePoint <= 0xDBFF))
+        {
+            uint32_t lowSurrogate;
+
+            if ((parser->size - parser->position < 2) ||
+                (parser->json[parser->position] != '\\') ||
+                (parser->json[parser->position + 1] != 'u'))
+            {
+                codePoint = INVALID_CODE_POINT;
+            }
+            else
+            {
+                parser->position += 2;
+                if ((read_hex4(parser, &lowSurrogate) != 0) || (lowSurrogate < 0xDC00) || (lowSurrogate > 0xDFFF))
+                {
+                    codePoint = INVALID_CODE_POINT;
+                }
+                else
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                }
+            }
+        }
+        else if ((codePoint >= 0xDC00) && (codePoint <= 0xDFFF))
+        {
+            codePoint = INVALID_CODE_POINT;
+        }
+
+        if (codePoint == INVALID_CODE_POINT)
+        {
+            result = 0;
+        }
+        else if (codePoint < 0x80)
+        {
+            output[0] = (char)codePoint;
+            result = 1;
+        }
+        else if (codePoint < 0x800)
+        {
+            output[0] = (char)(0xC0 | (codePoint >> 6));
+            output[1] = (char)(0x80 | (codePoint & 0x3F));
+            result = 2;
+        }
+        else if (codePoint < 0x10000)
+        {
+            output[0] = (char)(0xE0 | (codePoint >> 12));
+            output[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            output[2] = (char)(0x80 | (codePoint & 0x3F));
+            result = 3;
+        }
+        else
+        {
+            output[0] = (char)(0xF0 | (codePoint >> 18));
+            output[1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+            output[2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            output[3] = (char)(0x80 | (codePoint & 0x3F));
+            result = 4;
+        }
+    }
+
+    return result;
+}
+
+/*reads the string starting at the current position (on its opening quote) and appends it, decoded and null terminated, to the storage; returns its offset in the storage or NO_VALUE on failure*/
+static size_t read_string(FEEDBACK_PARSER* parser)
+{
+    size_t result;
+    size_t end = parser->position + 1;
+
+    /*a decoded string is never longer than its JSON representation, so this is the most the storage needs*/
+    while ((end < parser->size) && (parser->json[end] != '"'))
+    {
+        end += (parser->json[end] == '\\') ? 2 : 1;
+    }
+
+    if (end >= parser->size)
+    {
+        LogError("Unterminated string in feedback message");
+        result = NO_VALUE;
+    }
+    else if (ensure_storage(parser, parser->storageUsed + (end - parser->position)) != 0)
+    {
+        result = NO_VALUE;
+    }
+    else
+    {
+        char* output = parser->storage + parser->storageUsed;
+        size_t length = 0;
+        int isValid = 1;
+
+        parser->position++;
+        while (isValid && (parser->position < end))
+        {
+            unsigned char c = parser->json[parser->position++];
+
+            if (c < 0x20)
+            {
+                isValid = 0;
+            }
+            else if (c != '\\')
+            {
+                output[length++] = (char)c;
+            }
+            else
+            {
+                c = parser->json[parser->position++];
+                switch (c)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    output[length++] = (char)c;
+                    break;
+                case 'b':
+                    output[length++] = '\b';
+                    break;
+                case 'f':
+                    output[length++] = '\f';
+                    break;
+                case 'n':
+                    output[length++] = '\n';
+                    break;
+                case 'r':
+                    output[length++] = '\r';
+                    break;
+                case 't':
+                    output[length++] = '\t';
+                    break;
+                case 'u':
+                {
+                    size_t written = decode_unicode_escape(parser, output + length);
+                    if (written == 0)
+                    {
+                        isValid = 0;
+                    }
+                    length += written;
+                    break;
+                }
+                default:
+                    isValid = 0;
+                    break;
+                }
+            }
+        }
+
+        if (!isValid || (parser->position != end))
+        {
+            LogError("Invalid string in feedback message");
+            result = NO_VALUE;
+        }
+        else
+        {
+            output[length] = '\0';
+            parser->position = end + 1;
+            result = parser->storageUsed;
+            parser->storageUsed += length + 1;
+        }
+    }
+
+    return result;
+}
+
+/*skips a value that is not kept: a string, a number, a literal, or an object or array whatever it contains*/
+static int skip_value(FEEDBACK_PARSER* parser)
+{
+    int result;
+    size_t depth = 0;
+
+    skip_whitespace(parser);
+    result = 0;
+    do
+    {
+        unsigned char c;
+
+        if (parser->position >= parser->size)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        c = parser->json[parser->position];
+        if (c == '"')
+        {
+            /*strings are skipped by reading them into the storage, then dropping them*/
+            size_t storageUsed = parser->storageUsed;
+            if (read_string(parser) == NO_VALUE)
+            {
+                result = __FAILURE__;
+            }
+            parser->storageUsed = storageUsed;
+        }
+        else if ((c == '{') || (c == '['))
+        {
+            depth++;
+            parser->position++;
+        }
+        else if ((c == '}') || (c == ']'))
+        {
+            if (depth == 0)
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                depth--;
+                parser->position++;
+            }
+        }
+        else if ((c == ',') || (c == ':') || is_whitespace(c))
+        {
+            if (depth == 0)
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                parser->position++;
+            }
+        }
+        else
+        {
+            /*numbers, true, false and null*/
+            size_t start = parser->position;
+            while ((parser->position < parser->size) &&
+                (isalnum(parser->json[parser->position]) || (parser->json[parser->position] == '+') || (parser->json[parser->position] == '-') || (parser->json[parser->position] == '.')))
+            {
+                parser->position++;
+            }
+
+            if (parser->position == start)
+            {
+                result = __FAILURE__;
+            }
+        }
+    } while ((result == 0) && (depth > 0));
+
+    return result;
+}
+
+static int get_member_index(const char* key)
+{
+    int result;
+
+    for (result = 0; result < FEEDBACK_RECORD_MEMBER_COUNT; result++)
+    {
+        if (strcmp(key, FEEDBACK_RECORD_KEYS[result]) == 0)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int is_equal_ignoring_case(const char* s1, const char* s2)
+{
+    while ((*s1 != '\0') && (tolower((unsigned char)*s1) == tolower((unsigned char)*s2)))
+    {
+        s1++;
+        s2++;
+    }
+
+    return tolower((unsigned char)*s1) == tolower((unsigned char)*s2);
+}
+
+static IOTHUB_FEEDBACK_STATUS_CODE get_status_code(const char* description)
+{
+    IOTHUB_FEEDBACK_STATUS_CODE result;
+
+    if (description == NULL)
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
+    }
+    else if (is_equal_ignoring_case(description, "success"))
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS;
+    }
+    else if (is_equal_ignoring_case(description, "expired"))
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_EXPIRED;
+    }
+    else if (is_equal_ignoring_case(description, "deliverycountexceeded"))
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_DELIVER_COUNT_EXCEEDED;
+    }
+    else if (is_equal_ignoring_case(description, "rejected"))
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_REJECTED;
+    }
+    else
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
+    }
+
+    return result;
+}
+
+static int read_record(FEEDBACK_PARSER* parser, IOTHUB_SERVICE_FEEDBACK_RECORD* record)
+{
+    int result;
+    size_t values[FEEDBACK_RECORD_MEMBER_COUNT];
+    int i;
+
+    for (i = 0; i < FEEDBACK_RECORD_MEMBER_COUNT; i++)
+    {
+        values[i] = NO_VALUE;
+    }
+    parser->storageUsed = 0;
+
+    if (expect_character(parser, '{') != 0)
+    {
+        LogError("Feedback record is not a JSON object");
+        result = __FAILURE__;
+    }
+    else if (peek_character(parser, '}'))
+    {
+        parser->position++;
+        result = 0;
+    }
+    else
+    {
+        result = 0;
+        do
+        {
+            size_t key;
+            int member;
+
+            if (!peek_character(parser, '"') || ((key = read_string(parser)) == NO_VALUE))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                member = get_member_index(parser->storage + key);
+                parser->storageUsed = key; /*the key is not kept*/
+
+                if (expect_character(parser, ':') != 0)
+                {
+                    result = __FAILURE__;
+                }
+                else if ((member != FEEDBACK_RECORD_MEMBER_NONE) && peek_character(parser, '"'))
+                {
+                    if ((values[member] = read_string(parser)) == NO_VALUE)
+                    {
+                        result = __FAILURE__;
+                    }
+                }
+                else if (skip_value(parser) != 0)
+                {
+                    result = __FAILURE__;
+                }
+                else if (member != FEEDBACK_RECORD_MEMBER_NONE)
+                {
+                    /*a member that is not a string is treated as missing*/
+                    values[member] = NO_VALUE;
+                }
+            }
+        } while ((result == 0) && (expect_character(parser, ',') == 0));
+
+        if ((result == 0) && (expect_character(parser, '}') != 0))
+        {
+            result = __FAILURE__;
+        }
+
+        if (result != 0)
+        {
+            LogError("Invalid feedback record at offset %lu", (unsigned long)parser->position);
+        }
+    }
+
+    if (result == 0)
+    {
+        record->deviceId = (values[FEEDBACK_RECORD_MEMBER_DEVICE_ID] == NO_VALUE) ? NULL : parser->storage + values[FEEDBACK_RECORD_MEMBER_DEVICE_ID];
+        record->generationId = (values[FEEDBACK_RECORD_MEMBER_DEVICE_GENERATION_ID] == NO_VALUE) ? NULL : parser->storage + values[FEEDBACK_RECORD_MEMBER_DEVICE_GENERATION_ID];
+        record->description = (values[FEEDBACK_RECORD_MEMBER_DESCRIPTION] == NO_VALUE) ? NULL : parser->storage + values[FEEDBACK_RECORD_MEMBER_DESCRIPTION];
+        record->enqueuedTimeUtc = (values[FEEDBACK_RECORD_MEMBER_ENQUEUED_TIME_UTC] == NO_VALUE) ? NULL : parser->storage + values[FEEDBACK_RECORD_MEMBER_ENQUEUED_TIME_UTC];
+        record->originalMessageId = (values[FEEDBACK_RECORD_MEMBER_ORIGINAL_MESSAGE_ID] == NO_VALUE) ? NULL : parser->storage + values[FEEDBACK_RECORD_MEMBER_ORIGINAL_MESSAGE_ID];
+        record->correlationId = "";
+        record->statusCode = get_status_code(record->description);
+    }
+
+    return result;
+}
+
+FEEDBACK_PARSER_HANDLE feedback_parser_create(void)
+{
+    FEEDBACK_PARSER* result;
+
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_001: [ feedback_parser_create shall allocate the parser using malloc, with no buffer, and return NULL if it fails ] */
+    if ((result = (FEEDBACK_PARSER*)malloc(sizeof(FEEDBACK_PARSER))) == NULL)
+    {
+        LogError("Failed allocating the feedback parser");
+    }
+    else
+    {
+        memset(result, 0, sizeof(FEEDBACK_PARSER));
+        result->state = FEEDBACK_PARSER_STATE_IDLE;
+    }
+
+    return result;
+}
+
+void feedback_parser_destroy(FEEDBACK_PARSER_HANDLE parser)
+{
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_002: [ If parser is NULL, feedback_parser_destroy shall return ] */
+    if (parser == NULL)
+    {
+        LogError("Invalid argument (parser is NULL)");
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_003: [ feedback_parser_destroy shall free the buffer of the decoded strings and the parser ] */
+        free(parser->storage);
+        free(parser);
+    }
+}
+
+int feedback_parser_begin(FEEDBACK_PARSER_HANDLE parser, const unsigned char* json, size_t size)
+{
+    int result;
+
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_004: [ If parser or json are NULL, feedback_parser_begin shall fail and return a non-zero value ] */
+    if ((parser == NULL) || (json == NULL))
+    {
+        LogError("Invalid argument (parser=%p, json=%p)", parser, json);
+        result = __FAILURE__;
+    }
+    else
+    {
+        parser->json = json;
+        parser->size = size;
+        parser->position = 0;
+
+        /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_005: [ If json, after any whitespace, does not start with a JSON array, feedback_parser_begin shall fail and return a non-zero value ] */
+        if (expect_character(parser, '[') != 0)
+        {
+            LogError("Feedback message is not a JSON array");
+            parser->state = FEEDBACK_PARSER_STATE_FAILED;
+            result = __FAILURE__;
+        }
+        else
+        {
+            parser->state = FEEDBACK_PARSER_STATE_FIRST_RECORD;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+FEEDBACK_PARSER_RESULT feedback_parser_get_next_record(FEEDBACK_PARSER_HANDLE parser, IOTHUB_SERVICE_FEEDBACK_RECORD* record)
+{
+    FEEDBACK_PARSER_RESULT result;
+
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_006: [ If parser or record are NULL, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    if ((parser == NULL) || (record == NULL))
+    {
+        LogError("Invalid argument (parser=%p, record=%p)", parser, record);
+        result = FEEDBACK_PARSER_ERROR;
+    }
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_007: [ If feedback_parser_begin did not succeed, or a previous record was not valid, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    else if ((parser->state == FEEDBACK_PARSER_STATE_IDLE) || (parser->state == FEEDBACK_PARSER_STATE_FAILED))
+    {
+        result = FEEDBACK_PARSER_ERROR;
+    }
+    else if (parser->state == FEEDBACK_PARSER_STATE_ENDED)
+    {
+        result = FEEDBACK_PARSER_END;
+    }
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_008: [ At the end of the array feedback_parser_get_next_record shall return FEEDBACK_PARSER_END, or FEEDBACK_PARSER_ERROR if anything but whitespace or null characters follows it ] */
+    else if (peek_character(parser, ']'))
+    {
+        parser->position++;
+        skip_whitespace(parser);
+        while ((parser->position < parser->size) && (parser->json[parser->position] == '\0'))
+        {
+            parser->position++;
+        }
+
+        if (parser->position != parser->size)
+        {
+            LogError("Unexpected data after the feedback records");
+            parser->state = FEEDBACK_PARSER_STATE_FAILED;
+            result = FEEDBACK_PARSER_ERROR;
+        }
+        else
+        {
+            parser->state = FEEDBACK_PARSER_STATE_ENDED;
+            result = FEEDBACK_PARSER_END;
+        }
+    }
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_009: [ Records shall be JSON objects separated by commas, otherwise feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    else if ((parser->state == FEEDBACK_PARSER_STATE_NEXT_RECORD) && (expect_character(parser, ',') != 0))
+    {
+        LogError("Missing separator between feedback records");
+        parser->state = FEEDBACK_PARSER_STATE_FAILED;
+        result = FEEDBACK_PARSER_ERROR;
+    }
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_010: [ feedback_parser_get_next_record shall decode the string values of the members deviceId, deviceGenerationId, description, enqueuedTimeUtc and originalMessageId of the record into the buffer of the parser and point the fields of record to them, setting NULL for the members missing or not strings; other members shall be skipped ] */
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_011: [ feedback_parser_get_next_record shall grow the buffer using realloc when a record does not fit, and return FEEDBACK_PARSER_ERROR if it fails ] */
+    /*Codes_SRS_IOTHUB_FEEDBACK_PARSER_09_012: [ feedback_parser_get_next_record shall set the correlationId of record to "" and its statusCode from the description, compared ignoring case to "success", "expired", "deliverycountexceeded" and "rejected", or IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN ] */
+    else if (read_record(parser, record) != 0)
+    {
+        parser->state = FEEDBACK_PARSER_STATE_FAILED;
+        result = FEEDBACK_PARSER_ERROR;
+    }
+    else
+    {
+        parser->state = FEEDBACK_PARSER_STATE_NEXT_RECORD;
+        result = FEEDBACK_PARSER_RECORD;
+    }
+
+    return result;
+}
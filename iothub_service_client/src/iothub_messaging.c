@@ -278,6 +278,39 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_SetFeedbackMessageCallback(IOTHUB_MESSAG
     return result;
 }
 
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_SetFeedbackRecordCallback(IOTHUB_MESSAGING_CLIENT_HANDLE messagingClientHandle, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK feedbackRecordReceivedCallback, void* userContextCallback)
+{
+    IOTHUB_MESSAGING_RESULT result;
+
+    if (messagingClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBMESSAGING_09_001: [ If messagingClientHandle is NULL, IoTHubMessaging_SetFeedbackRecordCallback shall return IOTHUB_MESSAGING_INVALID_ARG. ]*/
+        LogError("NULL messagingClientHandle");
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_MESSAGING_CLIENT_INSTANCE* iotHubMessagingClientInstance = (IOTHUB_MESSAGING_CLIENT_INSTANCE*)messagingClientHandle;
+
+        /*Codes_SRS_IOTHUBMESSAGING_09_002: [ IoTHubMessaging_SetFeedbackRecordCallback shall be made thread-safe by using the lock created in IoTHubMessaging_Create. ]*/
+        if (Lock(iotHubMessagingClientInstance->LockHandle) != LOCK_OK)
+        {
+            /*Codes_SRS_IOTHUBMESSAGING_09_003: [ If acquiring the lock fails, IoTHubMessaging_SetFeedbackRecordCallback shall return IOTHUB_MESSAGING_ERROR. ]*/
+            LogError("Could not acquire lock");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGING_09_004: [ IoTHubMessaging_SetFeedbackRecordCallback shall call IoTHubMessaging_LL_SetFeedbackRecordCallback, while passing the IOTHUB_MESSAGING_HANDLE handle created by IoTHubMessaging_Create, feedbackRecordReceivedCallback and userContextCallback, and return its result. ]*/
+            result = IoTHubMessaging_LL_SetFeedbackRecordCallback(messagingClientHandle->IoTHubMessagingHandle, feedbackRecordReceivedCallback, userContextCallback);
+
+            (void)Unlock(iotHubMessagingClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_MESSAGING_RESULT IoTHubMessaging_SendAsync(IOTHUB_MESSAGING_CLIENT_HANDLE messagingClientHandle, const char* deviceId, IOTHUB_MESSAGE_HANDLE message, IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback, void* userContextCallback)
 {
     IOTHUB_MESSAGING_RESULT result;
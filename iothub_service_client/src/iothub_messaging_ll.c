@@ -23,6 +23,7 @@
 #include "parson.h"
 
 #include "iothub_messaging_ll.h"
+#include "iothub_feedback_parser.h"
 #include "iothub_sc_version.h"
 
 typedef struct CALLBACK_DATA_TAG
@@ -33,6 +34,8 @@ typedef struct CALLBACK_DATA_TAG
     void* openUserContext;
     void* sendUserContext;
     void* feedbackUserContext;
+    IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK feedbackRecordCallback;
+    void* feedbackRecordUserContext;
 } CALLBACK_DATA;
 
 typedef struct IOTHUB_MESSAGING_TAG
@@ -59,6 +62,7 @@ typedef struct IOTHUB_MESSAGING_TAG
     MESSAGE_RECEIVER_STATE message_receiver_state;
 
     CALLBACK_DATA* callback_data;
+    FEEDBACK_PARSER_HANDLE feedback_parser;
 } IOTHUB_MESSAGING;
 
 
@@ -639,6 +643,51 @@ static void IoTHubMessaging_LL_SendMessageComplete(void* context, IOTHUB_MESSAGI
     }
 }
 
+static AMQP_VALUE receiveFeedbackRecords(IOTHUB_MESSAGING* messagingData, MESSAGE_HANDLE message)
+{
+    AMQP_VALUE result;
+    BINARY_DATA binary_data;
+
+    /*Codes_SRS_IOTHUBMESSAGING_09_004: [ IoTHubMessaging_LL_FeedbackMessageReceived shall get the body of the message by calling message_get_body_amqp_data_in_place and start parsing it by calling feedback_parser_begin ] */
+    if (message_get_body_amqp_data_in_place(message, 0, &binary_data) != 0)
+    {
+        /*Codes_SRS_IOTHUBMESSAGING_09_007: [ If getting the body, feedback_parser_begin or feedback_parser_get_next_record fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_rejected ] */
+        LogError("Cannot get message data");
+        result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed reading message body");
+    }
+    else if (feedback_parser_begin(messagingData->feedback_parser, binary_data.bytes, binary_data.length) != 0)
+    {
+        /*Codes_SRS_IOTHUBMESSAGING_09_007: [ If getting the body, feedback_parser_begin or feedback_parser_get_next_record fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_rejected ] */
+        LogError("Feedback message is not a JSON array");
+        result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to read feedback records");
+    }
+    else
+    {
+        IOTHUB_SERVICE_FEEDBACK_RECORD feedbackRecord;
+        FEEDBACK_PARSER_RESULT parserResult;
+
+        /*Codes_SRS_IOTHUBMESSAGING_09_005: [ IoTHubMessaging_LL_FeedbackMessageReceived shall call feedback_parser_get_next_record until it returns FEEDBACK_PARSER_END, calling the IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK with each record as soon as it is read ] */
+        while ((parserResult = feedback_parser_get_next_record(messagingData->feedback_parser, &feedbackRecord)) == FEEDBACK_PARSER_RECORD)
+        {
+            (messagingData->callback_data->feedbackRecordCallback)(messagingData->callback_data->feedbackRecordUserContext, &feedbackRecord);
+        }
+
+        if (parserResult != FEEDBACK_PARSER_END)
+        {
+            /*Codes_SRS_IOTHUBMESSAGING_09_007: [ If getting the body, feedback_parser_begin or feedback_parser_get_next_record fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_rejected ] */
+            LogError("Failed to read feedback records");
+            result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to read feedback records");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGING_09_006: [ After the last record IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_accepted ] */
+            result = messaging_delivery_accepted();
+        }
+    }
+
+    return result;
+}
+
 static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context, MESSAGE_HANDLE message)
 {
     AMQP_VALUE result;
@@ -648,6 +697,11 @@ static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context
     {
         result = messaging_delivery_accepted();
     }
+    /*Codes_SRS_IOTHUBMESSAGING_09_003: [ If a feedback record callback is set, IoTHubMessaging_LL_FeedbackMessageReceived shall stream the records to it instead of building an IOTHUB_SERVICE_FEEDBACK_BATCH ] */
+    else if (((IOTHUB_MESSAGING*)context)->callback_data->feedbackRecordCallback != NULL)
+    {
+        result = receiveFeedbackRecords((IOTHUB_MESSAGING*)context, message);
+    }
     else
     {
         IOTHUB_MESSAGING* messagingData = (IOTHUB_MESSAGING*)context;
@@ -934,8 +988,11 @@ IOTHUB_MESSAGING_HANDLE IoTHubMessaging_LL_Create(IOTHUB_SERVICE_CLIENT_AUTH_HAN
                 callback_data->openUserContext = NULL;
                 callback_data->sendUserContext = NULL;
                 callback_data->feedbackUserContext = NULL;
+                callback_data->feedbackRecordCallback = NULL;
+                callback_data->feedbackRecordUserContext = NULL;
 
                 result->callback_data = callback_data;
+                result->feedback_parser = NULL;
                 result->isOpened = false;
             }
         }
@@ -951,6 +1008,10 @@ void IoTHubMessaging_LL_Destroy(IOTHUB_MESSAGING_HANDLE messagingHandle)
         /*Codes_SRS_IOTHUBMESSAGING_12_006: [ If the messagingHandle input parameter is not NULL IoTHubMessaging_LL_Destroy shall free all resources (memory) allocated by IoTHubMessaging_LL_Create ] */
         IOTHUB_MESSAGING* messHandle = (IOTHUB_MESSAGING*)messagingHandle;
 
+        if (messHandle->feedback_parser != NULL)
+        {
+            feedback_parser_destroy(messHandle->feedback_parser);
+        }
         free(messHandle->callback_data);
         free(messHandle->hostname);
         free(messHandle->iothubName);
@@ -1405,6 +1466,33 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackMessageCallback(IOTHUB_MES
     return result;
 }
 
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackRecordCallback(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK feedbackRecordReceivedCallback, void* userContextCallback)
+{
+    IOTHUB_MESSAGING_RESULT result;
+
+    /*Codes_SRS_IOTHUBMESSAGING_09_001: [ If messagingHandle is NULL, IoTHubMessaging_LL_SetFeedbackRecordCallback shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    if (messagingHandle == NULL)
+    {
+        LogError("Input parameter cannot be NULL");
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    /*Codes_SRS_IOTHUBMESSAGING_09_002: [ The first time a non-NULL callback is set, IoTHubMessaging_LL_SetFeedbackRecordCallback shall create the parser by calling feedback_parser_create, and return IOTHUB_MESSAGING_ERROR if it fails ] */
+    else if ((feedbackRecordReceivedCallback != NULL) && (messagingHandle->feedback_parser == NULL) &&
+        ((messagingHandle->feedback_parser = feedback_parser_create()) == NULL))
+    {
+        LogError("Failed creating the feedback parser");
+        result = IOTHUB_MESSAGING_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGING_09_008: [ IoTHubMessaging_LL_SetFeedbackRecordCallback shall save feedbackRecordReceivedCallback and userContextCallback and return IOTHUB_MESSAGING_OK ] */
+        messagingHandle->callback_data->feedbackRecordCallback = feedbackRecordReceivedCallback;
+        messagingHandle->callback_data->feedbackRecordUserContext = userContextCallback;
+        result = IOTHUB_MESSAGING_OK;
+    }
+    return result;
+}
+
 IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagingHandle, const char* deviceId, IOTHUB_MESSAGE_HANDLE message, IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback, void* userContextCallback)
 {
     IOTHUB_MESSAGING_RESULT result;
@@ -0,0 +1,538 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_feedback_parser.h"
+
+TEST_DEFINE_ENUM_TYPE(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RESULT_VALUES);
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static const char* TEST_FEEDBACK_RECORD =
+    "{\"originalMessageId\":\"0f2a8ccd-b1fd-4d7c-a2fc-3ad6fa6d9bd1\","
+    "\"description\":\"Success\","
+    "\"deviceGenerationId\":\"635880305279287549\","
+    "\"deviceId\":\"myDevice\","
+    "\"enqueuedTimeUtc\":\"2017-01-10T21:42:17.6394758Z\"}";
+
+static FEEDBACK_PARSER_HANDLE create_parser_and_begin(const char* json)
+{
+    FEEDBACK_PARSER_HANDLE result = feedback_parser_create();
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, feedback_parser_begin(result, (const unsigned char*)json, strlen(json)));
+    umock_c_reset_all_calls();
+    return result;
+}
+
+BEGIN_TEST_SUITE(iothub_feedback_parser_ut)
+
+    TEST_SUITE_INITIALIZE(TestClassInitialize)
+    {
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        umock_c_init(on_umock_c_error);
+
+        int result = umocktypes_charptr_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        umock_c_deinit();
+        TEST_MUTEX_DESTROY(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+        }
+
+        umock_c_reset_all_calls();
+    }
+
+    TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_001: [ feedback_parser_create shall allocate the parser using malloc, with no buffer, and return NULL if it fails ] */
+    TEST_FUNCTION(feedback_parser_create_happy_path)
+    {
+        // arrange
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        // act
+        FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+
+        // assert
+        ASSERT_IS_NOT_NULL(parser);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_001: [ feedback_parser_create shall allocate the parser using malloc, with no buffer, and return NULL if it fails ] */
+    TEST_FUNCTION(feedback_parser_create_malloc_fails)
+    {
+        // arrange
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1)
+            .SetReturn(NULL);
+
+        // act
+        FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+
+        // assert
+        ASSERT_IS_NULL(parser);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_002: [ If parser is NULL, feedback_parser_destroy shall return ] */
+    TEST_FUNCTION(feedback_parser_destroy_NULL_parser)
+    {
+        // act
+        feedback_parser_destroy(NULL);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_003: [ feedback_parser_destroy shall free the buffer of the decoded strings and the parser ] */
+    TEST_FUNCTION(feedback_parser_destroy_frees_the_buffer_and_the_parser)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[{\"deviceId\":\"myDevice\"}]");
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(parser));
+
+        // act
+        feedback_parser_destroy(parser);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_004: [ If parser or json are NULL, feedback_parser_begin shall fail and return a non-zero value ] */
+    TEST_FUNCTION(feedback_parser_begin_NULL_parser)
+    {
+        // act
+        int result = feedback_parser_begin(NULL, (const unsigned char*)"[]", 2);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_004: [ If parser or json are NULL, feedback_parser_begin shall fail and return a non-zero value ] */
+    TEST_FUNCTION(feedback_parser_begin_NULL_json)
+    {
+        // arrange
+        FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+
+        // act
+        int result = feedback_parser_begin(parser, NULL, 2);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_005: [ If json, after any whitespace, does not start with a JSON array, feedback_parser_begin shall fail and return a non-zero value ] */
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_007: [ If feedback_parser_begin did not succeed, or a previous record was not valid, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_begin_fails_if_json_is_not_an_array)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+        const char* json = TEST_FEEDBACK_RECORD;
+
+        // act
+        int result = feedback_parser_begin(parser, (const unsigned char*)json, strlen(json));
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, feedback_parser_get_next_record(parser, &record));
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_006: [ If parser or record are NULL, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_NULL_parser)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(NULL, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_006: [ If parser or record are NULL, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_NULL_record)
+    {
+        // arrange
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[]");
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, NULL);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_007: [ If feedback_parser_begin did not succeed, or a previous record was not valid, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_without_begin)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_008: [ At the end of the array feedback_parser_get_next_record shall return FEEDBACK_PARSER_END, or FEEDBACK_PARSER_ERROR if anything but whitespace or null characters follows it ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_empty_array)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        const unsigned char json[] = " [ ]\r\n";
+        FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+        ASSERT_ARE_EQUAL(int, 0, feedback_parser_begin(parser, json, sizeof(json)));
+        umock_c_reset_all_calls();
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_END, result);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_END, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_008: [ At the end of the array feedback_parser_get_next_record shall return FEEDBACK_PARSER_END, or FEEDBACK_PARSER_ERROR if anything but whitespace or null characters follows it ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_data_after_the_array)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[] []");
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_010: [ feedback_parser_get_next_record shall decode the string values of the members deviceId, deviceGenerationId, description, enqueuedTimeUtc and originalMessageId of the record into the buffer of the parser and point the fields of record to them, setting NULL for the members missing or not strings; other members shall be skipped ] */
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_011: [ feedback_parser_get_next_record shall grow the buffer using realloc when a record does not fit, and return FEEDBACK_PARSER_ERROR if it fails ] */
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_012: [ feedback_parser_get_next_record shall set the correlationId of record to "" and its statusCode from the description, compared ignoring case to "success", "expired", "deliverycountexceeded" and "rejected", or IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_happy_path)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        char json[512];
+        (void)sprintf(json, "[%s]", TEST_FEEDBACK_RECORD);
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin(json);
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument(2);
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, result);
+        ASSERT_ARE_EQUAL(char_ptr, "myDevice", record.deviceId);
+        ASSERT_ARE_EQUAL(char_ptr, "635880305279287549", record.generationId);
+        ASSERT_ARE_EQUAL(char_ptr, "Success", record.description);
+        ASSERT_ARE_EQUAL(char_ptr, "2017-01-10T21:42:17.6394758Z", record.enqueuedTimeUtc);
+        ASSERT_ARE_EQUAL(char_ptr, "0f2a8ccd-b1fd-4d7c-a2fc-3ad6fa6d9bd1", record.originalMessageId);
+        ASSERT_ARE_EQUAL(char_ptr, "", record.correlationId);
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS, record.statusCode);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_END, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_009: [ Records shall be JSON objects separated by commas, otherwise feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_012: [ feedback_parser_get_next_record shall set the correlationId of record to "" and its statusCode from the description, compared ignoring case to "success", "expired", "deliverycountexceeded" and "rejected", or IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_maps_the_status_codes)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin(
+            "[{\"description\":\"sUcCeSs\"}, {\"description\":\"Expired\"}, {\"description\":\"DeliveryCountExceeded\"},"
+            " {\"description\":\"Rejected\"}, {\"description\":\"Purged\"}, {}]");
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS, record.statusCode);
+        ASSERT_ARE_EQUAL(char_ptr, "sUcCeSs", record.description);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_EXPIRED, record.statusCode);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_DELIVER_COUNT_EXCEEDED, record.statusCode);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_REJECTED, record.statusCode);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN, record.statusCode);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN, record.statusCode);
+        ASSERT_IS_NULL(record.description);
+        ASSERT_IS_NULL(record.deviceId);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_END, feedback_parser_get_next_record(parser, &record));
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_010: [ feedback_parser_get_next_record shall decode the string values of the members deviceId, deviceGenerationId, description, enqueuedTimeUtc and originalMessageId of the record into the buffer of the parser and point the fields of record to them, setting NULL for the members missing or not strings; other members shall be skipped ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_skips_other_members)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin(
+            "[{\"statusCode\":\"Success\", \"extra\": {\"a\": [1, -2.5e3, {\"deviceId\": \"]\"}], \"b\": null}, \"deviceId\": \"myDevice\", \"flag\": true,"
+            " \"description\": 42, \"originalMessageId\": [\"id\"]}]");
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, result);
+        ASSERT_ARE_EQUAL(char_ptr, "myDevice", record.deviceId);
+        ASSERT_IS_NULL(record.description);
+        ASSERT_IS_NULL(record.originalMessageId);
+        ASSERT_IS_NULL(record.generationId);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_END, feedback_parser_get_next_record(parser, &record));
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_010: [ feedback_parser_get_next_record shall decode the string values of the members deviceId, deviceGenerationId, description, enqueuedTimeUtc and originalMessageId of the record into the buffer of the parser and point the fields of record to them, setting NULL for the members missing or not strings; other members shall be skipped ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_decodes_escapes)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[{\"deviceId\":\"a\\\"b\\\\c\\/d\\te\\u00e9\\ud83d\\ude00\"}]");
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, result);
+        ASSERT_ARE_EQUAL(char_ptr, "a\"b\\c/d\te\xC3\xA9\xF0\x9F\x98\x80", record.deviceId);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_010: [ feedback_parser_get_next_record shall decode the string values of the members deviceId, deviceGenerationId, description, enqueuedTimeUtc and originalMessageId of the record into the buffer of the parser and point the fields of record to them, setting NULL for the members missing or not strings; other members shall be skipped ] */
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_007: [ If feedback_parser_begin did not succeed, or a previous record was not valid, feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_lone_surrogate)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[{\"deviceId\":\"a\\ud83d\"}, {\"deviceId\":\"b\"}]");
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, feedback_parser_get_next_record(parser, &record));
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_009: [ Records shall be JSON objects separated by commas, otherwise feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_missing_separator)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[{\"deviceId\":\"a\"} {\"deviceId\":\"b\"}]");
+
+        // act
+        FEEDBACK_PARSER_RESULT result1 = feedback_parser_get_next_record(parser, &record);
+        FEEDBACK_PARSER_RESULT result2 = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, result1);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result2);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_009: [ Records shall be JSON objects separated by commas, otherwise feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_record_is_not_an_object)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[\"myDevice\"]");
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_009: [ Records shall be JSON objects separated by commas, otherwise feedback_parser_get_next_record shall return FEEDBACK_PARSER_ERROR ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_truncated_message)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[{\"deviceId\":\"a\"}, {\"deviceId\":\"b");
+
+        // act
+        FEEDBACK_PARSER_RESULT result1 = feedback_parser_get_next_record(parser, &record);
+        FEEDBACK_PARSER_RESULT result2 = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, result1);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result2);
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_011: [ feedback_parser_get_next_record shall grow the buffer using realloc when a record does not fit, and return FEEDBACK_PARSER_ERROR if it fails ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_realloc_fails)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin("[{\"deviceId\":\"a\"}]");
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(NULL);
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    /*Tests_SRS_IOTHUB_FEEDBACK_PARSER_09_011: [ feedback_parser_get_next_record shall grow the buffer using realloc when a record does not fit, and return FEEDBACK_PARSER_ERROR if it fails ] */
+    TEST_FUNCTION(feedback_parser_get_next_record_reuses_the_buffer_across_messages)
+    {
+        // arrange
+        IOTHUB_SERVICE_FEEDBACK_RECORD record;
+        char json[512];
+        (void)sprintf(json, "[%s, %s]", TEST_FEEDBACK_RECORD, TEST_FEEDBACK_RECORD);
+        FEEDBACK_PARSER_HANDLE parser = create_parser_and_begin(json);
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_END, feedback_parser_get_next_record(parser, &record));
+        ASSERT_ARE_EQUAL(int, 0, feedback_parser_begin(parser, (const unsigned char*)json, strlen(json)));
+        umock_c_reset_all_calls();
+
+        // act
+        FEEDBACK_PARSER_RESULT result = feedback_parser_get_next_record(parser, &record);
+
+        // assert
+        ASSERT_ARE_EQUAL(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RECORD, result);
+        ASSERT_ARE_EQUAL(char_ptr, "myDevice", record.deviceId);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        feedback_parser_destroy(parser);
+    }
+
+    END_TEST_SUITE(iothub_feedback_parser_ut)
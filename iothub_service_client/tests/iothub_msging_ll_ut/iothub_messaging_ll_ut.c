@@ -53,6 +53,12 @@ MOCKABLE_FUNCTION(, void, json_value_free, JSON_Value *, value);
 
 #include "iothub_messaging_ll.h"
 
+#define ENABLE_MOCKS
+#include "iothub_feedback_parser.h"
+#undef ENABLE_MOCKS
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RESULT_VALUES);
+
 TEST_DEFINE_ENUM_TYPE(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_RESULT_VALUES);
 
@@ -61,6 +67,7 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_RESULT_VAL
 MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, void*, context);
 MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_SEND_COMPLETE_CALLBACK, void*, context, IOTHUB_MESSAGING_RESULT, messagingResult);
 MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK, void*, context, IOTHUB_SERVICE_FEEDBACK_BATCH*, feedbackBatch);
+MOCKABLE_FUNCTION(, void, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, void*, context, const IOTHUB_SERVICE_FEEDBACK_RECORD*, feedbackRecord);
 #undef ENABLE_MOCKS
 
 
@@ -385,6 +392,8 @@ typedef struct TEST_CALLBACK_TAG
     void* openUserContext;
     void* sendUserContext;
     void* feedbackUserContext;
+    IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK feedbackRecordCallback;
+    void* feedbackRecordUserContext;
 } TEST_CALLBACK;
 
 typedef struct TEST_IOTHUB_MESSAGING_TAG
@@ -411,6 +420,7 @@ typedef struct TEST_IOTHUB_MESSAGING_TAG
     MESSAGE_RECEIVER_STATE message_receiver_state;
 
     TEST_CALLBACK* callback_data;
+    FEEDBACK_PARSER_HANDLE feedback_parser;
 } TEST_IOTHUB_MESSAGING;
 
 static void* TEST_VOID_PTR = (void*)0x5454;
@@ -446,6 +456,7 @@ static JSON_Status TEST_JSON_STATUS = 0;
 static AMQP_VALUE TEST_AMQP_MAP = ((AMQP_VALUE)0x6258);
 static MAP_HANDLE TEST_MAP_HANDLE = (MAP_HANDLE)0x103;
 static IOTHUB_MESSAGE_HANDLE TEST_IOTHUB_MESSAGE_HANDLE = (IOTHUB_MESSAGE_HANDLE)0x4242;
+static FEEDBACK_PARSER_HANDLE TEST_FEEDBACK_PARSER_HANDLE = (FEEDBACK_PARSER_HANDLE)0x6464;
 
 BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
 
@@ -502,6 +513,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
         REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(receiver_settle_mode, uint8_t);
+        REGISTER_UMOCK_ALIAS_TYPE(FEEDBACK_PARSER_HANDLE, void*);
+        REGISTER_TYPE(FEEDBACK_PARSER_RESULT, FEEDBACK_PARSER_RESULT);
         
 
         REGISTER_GLOBAL_MOCK_HOOK(STRING_construct, my_STRING_construct);
@@ -677,6 +690,15 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         
         REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetCorrelationId, TEST_CONST_CHAR_PTR);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_GetCorrelationId, NULL);
+
+        REGISTER_GLOBAL_MOCK_RETURN(feedback_parser_create, TEST_FEEDBACK_PARSER_HANDLE);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(feedback_parser_create, NULL);
+
+        REGISTER_GLOBAL_MOCK_RETURN(feedback_parser_begin, 0);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(feedback_parser_begin, 1);
+
+        REGISTER_GLOBAL_MOCK_RETURN(feedback_parser_get_next_record, FEEDBACK_PARSER_END);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(feedback_parser_get_next_record, FEEDBACK_PARSER_ERROR);
 }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -707,6 +729,9 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         TEST_IOTHUB_MESSAGING_DATA.keyName = TEST_SHAREDACCESSKEYNAME;
         TEST_IOTHUB_MESSAGING_DATA.sharedAccessKey = TEST_SHAREDACCESSKEY;
         TEST_IOTHUB_MESSAGING_DATA.isOpened = false;
+        TEST_IOTHUB_MESSAGING_DATA.feedback_parser = NULL;
+        TEST_CALLBACK_DATA.feedbackRecordCallback = NULL;
+        TEST_CALLBACK_DATA.feedbackRecordUserContext = NULL;
 
         onMessageSenderStateChangedCallback = NULL;
         onMessageReceiverStateChangedCallback = NULL;
@@ -956,6 +981,38 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
+    /*Tests_SRS_IOTHUBMESSAGING_12_006: [ If the messagingHandle input parameter is not NULL IoTHubMessaging_LL_Destroy shall free all resources (memory) allocated by IoTHubMessaging_LL_Create ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_Destroy_destroys_the_feedback_parser)
+    {
+        // arrange
+        IOTHUB_MESSAGING_HANDLE handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_SetFeedbackRecordCallback(handle, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, TEST_VOID_PTR);
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(feedback_parser_destroy(TEST_FEEDBACK_PARSER_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        // act
+        IoTHubMessaging_LL_Destroy(handle);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     /*Tests_SRS_IOTHUBMESSAGING_12_007: [ If the messagingHandle input parameter is NULL IoTHubMessaging_LL_Open shall return IOTHUB_MESSAGING_INVALID_ARG ] */
     TEST_FUNCTION(IoTHubMessaging_LL_Open_return_IOTHUB_MESSAGING_INVALID_ARG_if_input_parameter_messagingHandle_is_NULL)
     {
@@ -1727,6 +1784,71 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
     }
 
+    /*Tests_SRS_IOTHUBMESSAGING_09_001: [ If messagingHandle is NULL, IoTHubMessaging_LL_SetFeedbackRecordCallback shall return IOTHUB_MESSAGING_INVALID_ARG ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_return_IOTHUB_MESSAGING_INVALID_ARG_if_input_parameter_messagingHandle_is_NULL)
+    {
+        ///arrange
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(NULL, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_09_002: [ The first time a non-NULL callback is set, IoTHubMessaging_LL_SetFeedbackRecordCallback shall create the parser by calling feedback_parser_create, and return IOTHUB_MESSAGING_ERROR if it fails ] */
+    /*Tests_SRS_IOTHUBMESSAGING_09_008: [ IoTHubMessaging_LL_SetFeedbackRecordCallback shall save feedbackRecordReceivedCallback and userContextCallback and return IOTHUB_MESSAGING_OK ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_happy_path)
+    {
+        ///arrange
+        STRICT_EXPECTED_CALL(feedback_parser_create());
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(TEST_IOTHUB_MESSAGING_HANDLE, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_IS_TRUE(TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK == TEST_IOTHUB_MESSAGING_DATA.callback_data->feedbackRecordCallback);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_VOID_PTR, TEST_IOTHUB_MESSAGING_DATA.callback_data->feedbackRecordUserContext);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_FEEDBACK_PARSER_HANDLE, TEST_IOTHUB_MESSAGING_DATA.feedback_parser);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_09_002: [ The first time a non-NULL callback is set, IoTHubMessaging_LL_SetFeedbackRecordCallback shall create the parser by calling feedback_parser_create, and return IOTHUB_MESSAGING_ERROR if it fails ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_reuses_the_parser)
+    {
+        ///arrange
+        (void)IoTHubMessaging_LL_SetFeedbackRecordCallback(TEST_IOTHUB_MESSAGING_HANDLE, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, TEST_VOID_PTR);
+        umock_c_reset_all_calls();
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(TEST_IOTHUB_MESSAGING_HANDLE, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(void_ptr, NULL, TEST_IOTHUB_MESSAGING_DATA.callback_data->feedbackRecordUserContext);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_FEEDBACK_PARSER_HANDLE, TEST_IOTHUB_MESSAGING_DATA.feedback_parser);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_09_002: [ The first time a non-NULL callback is set, IoTHubMessaging_LL_SetFeedbackRecordCallback shall create the parser by calling feedback_parser_create, and return IOTHUB_MESSAGING_ERROR if it fails ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_return_IOTHUB_MESSAGING_ERROR_if_feedback_parser_create_fails)
+    {
+        ///arrange
+        STRICT_EXPECTED_CALL(feedback_parser_create())
+            .SetReturn(NULL);
+
+        ///act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(TEST_IOTHUB_MESSAGING_HANDLE, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, TEST_VOID_PTR);
+
+        ///assert
+        ASSERT_IS_NULL(TEST_IOTHUB_MESSAGING_DATA.callback_data->feedbackRecordCallback);
+        ASSERT_IS_NULL(TEST_IOTHUB_MESSAGING_DATA.feedback_parser);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     /*Tests_SRS_IOTHUBMESSAGING_12_045: [ IoTHubMessaging_LL_DoWork shall verify if uAMQP transport has been initialized and if it is not then return immediately ] */
     TEST_FUNCTION(IoTHubMessaging_LL_DoWork_return_if_input_parameter_messagingHandle_is_NULL)
     {
@@ -2705,4 +2827,111 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         IoTHubMessaging_LL_Close(iothub_messaging_handle);
         IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
     }
+
+    /*Tests_SRS_IOTHUBMESSAGING_09_003: [ If a feedback record callback is set, IoTHubMessaging_LL_FeedbackMessageReceived shall stream the records to it instead of building an IOTHUB_SERVICE_FEEDBACK_BATCH ] */
+    /*Tests_SRS_IOTHUBMESSAGING_09_004: [ IoTHubMessaging_LL_FeedbackMessageReceived shall get the body of the message by calling message_get_body_amqp_data_in_place and start parsing it by calling feedback_parser_begin ] */
+    /*Tests_SRS_IOTHUBMESSAGING_09_005: [ IoTHubMessaging_LL_FeedbackMessageReceived shall call feedback_parser_get_next_record until it returns FEEDBACK_PARSER_END, calling the IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK with each record as soon as it is read ] */
+    /*Tests_SRS_IOTHUBMESSAGING_09_006: [ After the last record IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_accepted ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_streams_the_records_to_the_record_callback)
+    {
+        ///arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        (void)IoTHubMessaging_LL_SetFeedbackMessageCallback(iothub_messaging_handle, TEST_FUNC_IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK, (void*)1);
+        (void)IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)2);
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_MESSAGE_HANDLE, 0, IGNORED_PTR_ARG))
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(feedback_parser_begin(TEST_FEEDBACK_PARSER_HANDLE, NULL, 1));
+        STRICT_EXPECTED_CALL(feedback_parser_get_next_record(TEST_FEEDBACK_PARSER_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(FEEDBACK_PARSER_RECORD);
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK((void*)2, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(feedback_parser_get_next_record(TEST_FEEDBACK_PARSER_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(FEEDBACK_PARSER_RECORD);
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK((void*)2, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(feedback_parser_get_next_record(TEST_FEEDBACK_PARSER_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(FEEDBACK_PARSER_END);
+        STRICT_EXPECTED_CALL(messaging_delivery_accepted());
+
+        ///act
+        AMQP_VALUE amqp_result = onMessageReceivedCallback((void*)iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(void_ptr, TEST_AMQP_VALUE, amqp_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubMessaging_LL_Close(iothub_messaging_handle);
+        IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_09_007: [ If getting the body, feedback_parser_begin or feedback_parser_get_next_record fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_rejected ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_rejects_the_message_if_a_record_is_not_valid)
+    {
+        ///arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        (void)IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)2);
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_MESSAGE_HANDLE, 0, IGNORED_PTR_ARG))
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(feedback_parser_begin(TEST_FEEDBACK_PARSER_HANDLE, NULL, 1));
+        STRICT_EXPECTED_CALL(feedback_parser_get_next_record(TEST_FEEDBACK_PARSER_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(FEEDBACK_PARSER_RECORD);
+        STRICT_EXPECTED_CALL(TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK((void*)2, IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(feedback_parser_get_next_record(TEST_FEEDBACK_PARSER_HANDLE, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(FEEDBACK_PARSER_ERROR);
+        STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        ///act
+        (void)onMessageReceivedCallback((void*)iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubMessaging_LL_Close(iothub_messaging_handle);
+        IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGING_09_007: [ If getting the body, feedback_parser_begin or feedback_parser_get_next_record fails, IoTHubMessaging_LL_FeedbackMessageReceived shall return delivery_rejected ] */
+    TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_rejects_the_message_if_feedback_parser_begin_fails)
+    {
+        ///arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = IoTHubMessaging_LL_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        (void)IoTHubMessaging_LL_Open(iothub_messaging_handle, TEST_FUNC_IOTHUB_OPEN_COMPLETE_CALLBACK, (void*)1);
+        (void)IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, TEST_FUNC_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)2);
+
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(TEST_MESSAGE_HANDLE, 0, IGNORED_PTR_ARG))
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(feedback_parser_begin(TEST_FEEDBACK_PARSER_HANDLE, NULL, 1))
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        ///act
+        (void)onMessageReceivedCallback((void*)iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubMessaging_LL_Close(iothub_messaging_handle);
+        IoTHubMessaging_LL_Destroy(iothub_messaging_handle);
+    }
     END_TEST_SUITE(iothub_messaging_ll_ut)
@@ -87,6 +87,7 @@ static IOTHUB_MESSAGING_HANDLE TEST_IOTHUB_MESSAGING_HANDLE = (IOTHUB_MESSAGING_
 static IOTHUB_MESSAGING_RESULT TEST_IOTHUB_MESSAGING_RESULT = (IOTHUB_MESSAGING_RESULT)0x6767;
 static IOTHUB_OPEN_COMPLETE_CALLBACK TEST_IOTHUB_OPEN_COMPLETE_CALLBACK;
 static IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK TEST_IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK;
+static IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK TEST_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK;
 static IOTHUB_SEND_COMPLETE_CALLBACK TEST_IOTHUB_SEND_COMPLETE_CALLBACK;
 
 typedef struct TEST_IOTHUB_MESSAGING_CLIENT_INSTANCE_TAG
@@ -163,6 +164,14 @@ static IOTHUB_MESSAGING_RESULT my_IoTHubMessaging_LL_SetFeedbackMessageCallback(
     return IOTHUB_MESSAGING_OK;
 }
 
+static IOTHUB_MESSAGING_RESULT my_IoTHubMessaging_LL_SetFeedbackRecordCallback(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK feedbackRecordReceivedCallback, void* userContextCallback)
+{
+    (void)messagingHandle;
+    (void)feedbackRecordReceivedCallback;
+    (void)userContextCallback;
+    return IOTHUB_MESSAGING_OK;
+}
+
 
 BEGIN_TEST_SUITE(iothub_messaging_ut)
 
@@ -187,6 +196,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_OPEN_COMPLETE_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_SEND_COMPLETE_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
@@ -227,6 +237,8 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessaging_LL_SetFeedbackMessageCallback, my_IoTHubMessaging_LL_SetFeedbackMessageCallback);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessaging_LL_SetFeedbackMessageCallback, IOTHUB_MESSAGING_ERROR);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessaging_LL_SetFeedbackRecordCallback, my_IoTHubMessaging_LL_SetFeedbackRecordCallback);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessaging_LL_SetFeedbackRecordCallback, IOTHUB_MESSAGING_ERROR);
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -607,6 +619,69 @@ TEST_FUNCTION(IoTHubMessaging_SetFeedbackMessageCallback_Lock_fails)
     free(messagingClientHandle);
 }
 
+/*Tests_SRS_IOTHUBMESSAGING_09_001: [ If messagingClientHandle is NULL, IoTHubMessaging_SetFeedbackRecordCallback shall return IOTHUB_MESSAGING_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubMessaging_SetFeedbackRecordCallback_return_IOTHUB_MESSAGING_INVALID_ARG_if_input_parameter_messagingClientHandle_is_NULL)
+{
+    ///arrange
+
+    ///act
+    IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_SetFeedbackRecordCallback(NULL, TEST_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)0x4242);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+}
+
+/*Tests_SRS_IOTHUBMESSAGING_09_002: [ IoTHubMessaging_SetFeedbackRecordCallback shall be made thread-safe by using the lock created in IoTHubMessaging_Create. ]*/
+/*Tests_SRS_IOTHUBMESSAGING_09_004: [ IoTHubMessaging_SetFeedbackRecordCallback shall call IoTHubMessaging_LL_SetFeedbackRecordCallback, while passing the IOTHUB_MESSAGING_HANDLE handle created by IoTHubMessaging_Create, feedbackRecordReceivedCallback and userContextCallback, and return its result. ]*/
+TEST_FUNCTION(IoTHubMessaging_SetFeedbackRecordCallback_happy_path)
+{
+    // arrange
+    IOTHUB_MESSAGING_CLIENT_HANDLE messagingClientHandle = IoTHubMessaging_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+    TEST_IOTHUB_MESSAGING_CLIENT_INSTANCE* messagingClientInstance = (TEST_IOTHUB_MESSAGING_CLIENT_INSTANCE*)messagingClientHandle;
+    messagingClientInstance->IoTHubMessagingHandle = (IOTHUB_MESSAGING_HANDLE)0X3333;
+
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessaging_LL_SetFeedbackRecordCallback((IOTHUB_MESSAGING_HANDLE)0X3333, TEST_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)0x4242));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    // act
+    IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_SetFeedbackRecordCallback(messagingClientHandle, TEST_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free(messagingClientHandle);
+}
+
+/*Tests_SRS_IOTHUBMESSAGING_09_003: [ If acquiring the lock fails, IoTHubMessaging_SetFeedbackRecordCallback shall return IOTHUB_MESSAGING_ERROR. ]*/
+TEST_FUNCTION(IoTHubMessaging_SetFeedbackRecordCallback_Lock_fails)
+{
+    // arrange
+    IOTHUB_MESSAGING_CLIENT_HANDLE messagingClientHandle = IoTHubMessaging_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_SetFeedbackRecordCallback(messagingClientHandle, TEST_IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free(messagingClientHandle);
+}
+
 /*Tests_SRS_IOTHUBMESSAGING_12_033: [ If messagingClientHandle is NULL, IoTHubMessaging_SendAsync shall return IOTHUB_MESSAGING_INVALID_ARG. ]*/
 TEST_FUNCTION(IoTHubMessaging_SendAsync_return_IOTHUB_MESSAGING_INVALID_ARG_if_input_parameter_messagingClientHandle_is_NULL)
 {
@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CBORENCODER_H
+#define CBORENCODER_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+
+#ifdef __cplusplus
+#include "cstddef"
+extern "C" {
+#else
+#include "stddef.h"
+#endif
+
+#include "multitree.h"
+
+#define CBOR_ENCODER_RESULT_VALUES           \
+CBOR_ENCODER_OK,                             \
+CBOR_ENCODER_INVALID_ARG,                    \
+CBOR_ENCODER_MULTITREE_ERROR,                \
+CBOR_ENCODER_AGENT_DATA_TYPES_ERROR,         \
+CBOR_ENCODER_ERROR
+
+DEFINE_ENUM(CBOR_ENCODER_RESULT, CBOR_ENCODER_RESULT_VALUES);
+
+#define CBOR_ENCODER_CONTENT_TYPE "application/cbor"
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*the leaves of treeHandle are const AGENT_DATA_TYPE*. When keys is not NULL, every node name found in keys is encoded as its (unsigned integer) index in keys instead of as a text string*/
+MOCKABLE_FUNCTION(, CBOR_ENCODER_RESULT, CBOREncoder_EncodeTree, MULTITREE_HANDLE, treeHandle, const char* const*, keys, size_t, keyCount, unsigned char**, destination, size_t*, destinationSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CBORENCODER_H */
@@ -183,6 +183,11 @@ MOCKABLE_FUNCTION(, void, CodeFirst_DestroyDevice, void*, device);
 extern CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t* destinationSize, size_t numProperties, ...);
 extern CODEFIRST_RESULT CodeFirst_SendAsyncReported(unsigned char** destination, size_t* destinationSize, size_t numReportedProperties, ...);
 
+/*serializes only the reported properties of device that changed since the last acknowledged delta. *destination is NULL when nothing changed*/
+MOCKABLE_FUNCTION(, CODEFIRST_RESULT, CodeFirst_SendAsyncReportedDelta, unsigned char**, destination, size_t*, destinationSize, void*, device);
+/*to be called when the service answered (isAcknowledged = true) or failed the delta produced by CodeFirst_SendAsyncReportedDelta*/
+MOCKABLE_FUNCTION(, CODEFIRST_RESULT, CodeFirst_CompleteReportedDelta, void*, device, bool, isAcknowledged);
+
 MOCKABLE_FUNCTION(, CODEFIRST_RESULT, CodeFirst_IngestDesiredProperties, void*, device, const char*, jsonPayload, bool, parseDesiredNode);
 
 MOCKABLE_FUNCTION(, AGENT_DATA_TYPE_TYPE, CodeFirst_GetPrimitiveType, const char*, typeName);
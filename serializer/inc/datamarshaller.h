@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include "agenttypesystem.h"
 #include "schema.h"
+#include "multitree.h"
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/vector.h"
 #ifdef __cplusplus
@@ -25,7 +26,8 @@ DATA_MARSHALLER_JSON_ENCODER_ERROR,             \
 DATA_MARSHALLER_ERROR,                          \
 DATA_MARSHALLER_AGENT_DATA_TYPES_ERROR,         \
 DATA_MARSHALLER_MULTITREE_ERROR,                \
-DATA_MARSHALLER_ONLY_ONE_VALUE_ALLOWED          \
+DATA_MARSHALLER_ONLY_ONE_VALUE_ALLOWED,         \
+DATA_MARSHALLER_CBOR_ENCODER_ERROR              \
 
 DEFINE_ENUM(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_RESULT_VALUES);
 
@@ -36,6 +38,24 @@ typedef struct DATA_MARSHALLER_VALUE_TAG
 } DATA_MARSHALLER_VALUE;
 
 typedef struct DATA_MARSHALLER_HANDLE_DATA_TAG* DATA_MARSHALLER_HANDLE;
+
+/*an optional dictionary of names. Encoders that support it (CBOR) replace every name found in keys by its index in keys*/
+typedef struct DATA_MARSHALLER_KEY_DICTIONARY_TAG
+{
+    const char* const* keys;
+    size_t keyCount;
+} DATA_MARSHALLER_KEY_DICTIONARY;
+
+/*produces in *destination (allocated with malloc) the encoding of a tree whose leaves are const AGENT_DATA_TYPE*. keyDictionary can be NULL*/
+typedef DATA_MARSHALLER_RESULT(*DATA_MARSHALLER_ENCODE_TREE_FUNC)(MULTITREE_HANDLE treeHandle, const DATA_MARSHALLER_KEY_DICTIONARY* keyDictionary, unsigned char** destination, size_t* destinationSize);
+
+/*contentType and contentEncoding are the values of the message system properties that describe the payload, contentEncoding can be NULL*/
+typedef struct DATA_MARSHALLER_ENCODER_TAG
+{
+    const char* contentType;
+    const char* contentEncoding;
+    DATA_MARSHALLER_ENCODE_TREE_FUNC encodeTree;
+} DATA_MARSHALLER_ENCODER;
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 MOCKABLE_FUNCTION(,DATA_MARSHALLER_HANDLE, DataMarshaller_Create, SCHEMA_MODEL_TYPE_HANDLE, modelHandle, bool, includePropertyPath);
@@ -44,6 +64,12 @@ MOCKABLE_FUNCTION(,DATA_MARSHALLER_RESULT, DataMarshaller_SendData, DATA_MARSHAL
 
 MOCKABLE_FUNCTION(, DATA_MARSHALLER_RESULT, DataMarshaller_SendData_ReportedProperties, DATA_MARSHALLER_HANDLE, dataMarshallerHandle, VECTOR_HANDLE, values, unsigned char**, destination, size_t*, destinationSize);
 
+MOCKABLE_FUNCTION(, const DATA_MARSHALLER_ENCODER*, DataMarshaller_GetJSONEncoder);
+MOCKABLE_FUNCTION(, const DATA_MARSHALLER_ENCODER*, DataMarshaller_GetCBOREncoder);
+MOCKABLE_FUNCTION(, void, DataMarshaller_SetDefaultEncoder, const DATA_MARSHALLER_ENCODER*, encoder);
+MOCKABLE_FUNCTION(, void, DataMarshaller_SetDefaultKeyDictionary, const DATA_MARSHALLER_KEY_DICTIONARY*, keyDictionary);
+MOCKABLE_FUNCTION(, const DATA_MARSHALLER_ENCODER*, DataMarshaller_GetEncoder, DATA_MARSHALLER_HANDLE, dataMarshallerHandle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*64 bit FNV-1a of the first size bytes of data. Used by the schema name indexes and by the reported properties shadow of codefirst; it is not a cryptographic hash*/
+MOCKABLE_FUNCTION(, uint64_t, FNV1a_Hash, const char*, data, size_t, size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FNV1A_H */
@@ -5,6 +5,7 @@
 #define JSONDECODER_H
 
 #include "multitree.h"
+#include "azure_c_shared_utility/macro_utils.h"
 
 #ifdef __cplusplus
 #include <cstddef>
@@ -13,17 +14,38 @@ extern "C" {
 #include <stddef.h>
 #endif
 
-typedef enum JSON_DECODER_RESULT_TAG
+#define JSON_DECODER_RESULT_VALUES \
+    JSON_DECODER_OK, \
+    JSON_DECODER_INVALID_ARG, \
+    JSON_DECODER_PARSE_ERROR, \
+    JSON_DECODER_MULTITREE_FAILED, \
+    JSON_DECODER_ERROR, \
+    JSON_DECODER_ABORTED
+
+DEFINE_ENUM(JSON_DECODER_RESULT, JSON_DECODER_RESULT_VALUES)
+
+typedef enum JSON_DECODER_EVENT_RESULT_TAG
+{
+    JSON_DECODER_EVENT_CONTINUE,
+    JSON_DECODER_EVENT_SKIP_CHILDREN, /*only meaningful for onBeginObject: the children and the matching onEndObject are not reported*/
+    JSON_DECODER_EVENT_ABORT
+} JSON_DECODER_EVENT_RESULT;
+
+/*name is the member name (or the array index as string for array elements). value is the raw JSON token (strings keep their quotes)*/
+typedef JSON_DECODER_EVENT_RESULT(*JSON_DECODER_ON_BEGIN_OBJECT)(void* context, const char* name);
+typedef JSON_DECODER_EVENT_RESULT(*JSON_DECODER_ON_END_OBJECT)(void* context, const char* name);
+typedef JSON_DECODER_EVENT_RESULT(*JSON_DECODER_ON_VALUE)(void* context, const char* name, const char* value);
+
+typedef struct JSON_DECODER_EVENTS_TAG
 {
-    JSON_DECODER_OK,
-    JSON_DECODER_INVALID_ARG,
-    JSON_DECODER_PARSE_ERROR,
-    JSON_DECODER_MULTITREE_FAILED,
-    JSON_DECODER_ERROR
-} JSON_DECODER_RESULT;
+    JSON_DECODER_ON_BEGIN_OBJECT onBeginObject;
+    JSON_DECODER_ON_END_OBJECT onEndObject;
+    JSON_DECODER_ON_VALUE onValue;
+} JSON_DECODER_EVENTS;
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_JSON_To_MultiTree, char*, json, MULTITREE_HANDLE*, multiTreeHandle);
+MOCKABLE_FUNCTION(, JSON_DECODER_RESULT, JSONDecoder_JSON_To_Events, char*, json, const JSON_DECODER_EVENTS*, events, void*, context);
 
 #ifdef __cplusplus
 }
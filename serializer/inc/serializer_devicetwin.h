@@ -12,6 +12,7 @@
 #include "parson.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/vector.h"
+#include "azure_c_shared_utility/lock.h"
 #include "methodreturn.h"
 
 static void serializer_ingest(DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size, void* userContextCallback)
@@ -133,10 +134,34 @@ typedef struct IOTHUB_CLIENT_HANDLE_VARIANT_TAG
     IOTHUB_CLIENT_HANDLE_VALUE iothubClientHandleValue;
 } IOTHUB_CLIENT_HANDLE_VARIANT;
 
+/*status given to the reported state callbacks of updates that did not change any reported property (nothing is sent to the service) - same as the service answers to a PATCH*/
+#define SERIALIZER_DEVICETWIN_REPORTED_STATE_UNCHANGED_STATUS_CODE 204
+/*status given to the reported state callbacks of updates that could not be sent*/
+#define SERIALIZER_DEVICETWIN_REPORTED_STATE_ERROR_STATUS_CODE 500
+
+typedef struct SERIALIZER_DEVICETWIN_REPORTED_CALLBACK_TAG
+{
+    IOTHUB_CLIENT_REPORTED_STATE_CALLBACK reportedStateCallback;
+    void* context;
+} SERIALIZER_DEVICETWIN_REPORTED_CALLBACK;
+
+/*at most 1 PATCH per device is in flight. The updates requested while a PATCH is in flight are coalesced in the next PATCH*/
+typedef struct SERIALIZER_DEVICETWIN_REPORTED_STATE_TAG
+{
+    IOTHUB_CLIENT_HANDLE_VARIANT iothubClientHandleVariant;
+    void* device;
+    LOCK_HANDLE lock; /*the acknowledgement comes on the IoTHubClient thread for the convenience layer*/
+    VECTOR_HANDLE callbacks; /*contains SERIALIZER_DEVICETWIN_REPORTED_CALLBACK. The first nCallbacksInFlight are waiting for the PATCH in flight, the rest for the next PATCH*/
+    size_t nCallbacksInFlight;
+    bool isPatchInFlight;
+    bool isDeviceDestroyed; /*when the device is destroyed while a PATCH is in flight, the acknowledgement frees this structure*/
+} SERIALIZER_DEVICETWIN_REPORTED_STATE;
+
 typedef struct SERIALIZER_DEVICETWIN_PROTOHANDLE_TAG /*it is called "PROTOHANDLE" because it is a primitive type of handle*/
 {
     IOTHUB_CLIENT_HANDLE_VARIANT iothubClientHandleVariant;
     void* deviceAssigned;
+    SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState;
 } SERIALIZER_DEVICETWIN_PROTOHANDLE;
  
 static VECTOR_HANDLE g_allProtoHandles=NULL; /*contains SERIALIZER_DEVICETWIN_PROTOHANDLE*/
@@ -172,6 +197,211 @@ static int lazilyAddProtohandle(const SERIALIZER_DEVICETWIN_PROTOHANDLE* protoHa
     return result;
 }
 
+static SERIALIZER_DEVICETWIN_REPORTED_STATE* createReportedState(const IOTHUB_CLIENT_HANDLE_VARIANT* iothubClientHandleVariant, void* device)
+{
+    SERIALIZER_DEVICETWIN_REPORTED_STATE* result = (SERIALIZER_DEVICETWIN_REPORTED_STATE*)malloc(sizeof(SERIALIZER_DEVICETWIN_REPORTED_STATE));
+    if (result == NULL)
+    {
+        LogError("failure in malloc");
+        /*return as is*/
+    }
+    else if ((result->lock = Lock_Init()) == NULL)
+    {
+        LogError("failure in Lock_Init");
+        free(result);
+        result = NULL;
+    }
+    else if ((result->callbacks = VECTOR_create(sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK))) == NULL)
+    {
+        LogError("failure in VECTOR_create");
+        (void)Lock_Deinit(result->lock);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->iothubClientHandleVariant = *iothubClientHandleVariant;
+        result->device = device;
+        result->nCallbacksInFlight = 0;
+        result->isPatchInFlight = false;
+        result->isDeviceDestroyed = false;
+    }
+    return result;
+}
+
+static void destroyReportedState(SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState)
+{
+    VECTOR_destroy(reportedState->callbacks);
+    (void)Lock_Deinit(reportedState->lock);
+    free(reportedState);
+}
+
+/*moves the first count callbacks out of reportedState->callbacks, so they can be called after the lock is released*/
+static SERIALIZER_DEVICETWIN_REPORTED_CALLBACK* takeReportedStateCallbacks(SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState, size_t count)
+{
+    SERIALIZER_DEVICETWIN_REPORTED_CALLBACK* result;
+    if (count == 0)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = (SERIALIZER_DEVICETWIN_REPORTED_CALLBACK*)malloc(count * sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK));
+        if (result == NULL)
+        {
+            LogError("failure in malloc, %zu reported state callbacks will not be called", count);
+        }
+        else
+        {
+            (void)memcpy(result, VECTOR_front(reportedState->callbacks), count * sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK));
+        }
+        VECTOR_erase(reportedState->callbacks, VECTOR_front(reportedState->callbacks), count);
+    }
+    return result;
+}
+
+static void callReportedStateCallbacks(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK* callbacks, size_t count, int status_code)
+{
+    if (callbacks != NULL)
+    {
+        size_t i;
+        for (i = 0; i < count; i++)
+        {
+            if (callbacks[i].reportedStateCallback != NULL)
+            {
+                callbacks[i].reportedStateCallback(status_code, callbacks[i].context);
+            }
+        }
+        free(callbacks);
+    }
+}
+
+static void serializer_reportedStateCallback(int status_code, void* userContextCallback);
+
+/*sends the reported properties that changed since the last acknowledged PATCH. Called with reportedState->lock held and no PATCH in flight*/
+/*on success, either a PATCH is in flight covering all the callbacks or *isUnchanged is true and nothing has been sent*/
+static int sendReportedStateDelta(SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState, bool* isUnchanged)
+{
+    int result;
+    unsigned char* buffer;
+    size_t bufferSize;
+
+    *isUnchanged = false;
+
+    /*Codes_SRS_SERIALIZERDEVICETWIN_02_029: [ IoTHubDeviceTwin_SendReportedState_Impl shall call CodeFirst_SendAsyncReportedDelta. ]*/
+    if (CodeFirst_SendAsyncReportedDelta(&buffer, &bufferSize, reportedState->device) != CODEFIRST_OK)
+    {
+        LogError("Failed serializing reported state");
+        result = __FAILURE__;
+    }
+    else if (buffer == NULL)
+    {
+        /*Codes_SRS_SERIALIZERDEVICETWIN_02_035: [ If no reported property changed since the last acknowledged PATCH then IoTHubDeviceTwin_SendReportedState_Impl shall not send anything, shall call deviceTwinCallback with status 204 and return IOTHUB_CLIENT_OK. ]*/
+        *isUnchanged = true;
+        result = 0;
+    }
+    else
+    {
+        IOTHUB_CLIENT_RESULT sendResult;
+        /*Codes_SRS_SERIALIZERDEVICETWIN_02_031: [ IoTHubDeviceTwin_SendReportedState_Impl shall use IoTHubClient_SendReportedState/IoTHubClient_LL_SendReportedState to send the serialized reported state. ]*/
+        switch (reportedState->iothubClientHandleVariant.iothubClientHandleType)
+        {
+            case IOTHUB_CLIENT_CONVENIENCE_HANDLE_TYPE:
+            {
+                sendResult = IoTHubClient_SendReportedState(reportedState->iothubClientHandleVariant.iothubClientHandleValue.iothubClientHandle, buffer, bufferSize, serializer_reportedStateCallback, reportedState);
+                break;
+            }
+            case IOTHUB_CLIENT_LL_HANDLE_TYPE:
+            {
+                sendResult = IoTHubClient_LL_SendReportedState(reportedState->iothubClientHandleVariant.iothubClientHandleValue.iothubClientLLHandle, buffer, bufferSize, serializer_reportedStateCallback, reportedState);
+                break;
+            }
+            default:
+            {
+                LogError("INTERNAL ERROR: unexpected value for enum (%d)", (int)reportedState->iothubClientHandleVariant.iothubClientHandleType);
+                sendResult = IOTHUB_CLIENT_ERROR;
+                break;
+            }
+        }
+
+        if (sendResult != IOTHUB_CLIENT_OK)
+        {
+            LogError("Failure sending data");
+            (void)CodeFirst_CompleteReportedDelta(reportedState->device, false);
+            result = __FAILURE__;
+        }
+        else
+        {
+            reportedState->isPatchInFlight = true;
+            reportedState->nCallbacksInFlight = VECTOR_size(reportedState->callbacks);
+            result = 0;
+        }
+        free(buffer);
+    }
+    return result;
+}
+
+/*the acknowledgement of a PATCH sent by sendReportedStateDelta*/
+static void serializer_reportedStateCallback(int status_code, void* userContextCallback)
+{
+    SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = (SERIALIZER_DEVICETWIN_REPORTED_STATE*)userContextCallback;
+    if (Lock(reportedState->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+    }
+    else
+    {
+        bool isDeviceDestroyed = reportedState->isDeviceDestroyed;
+        size_t nAcknowledged = reportedState->nCallbacksInFlight;
+        SERIALIZER_DEVICETWIN_REPORTED_CALLBACK* acknowledged = takeReportedStateCallbacks(reportedState, nAcknowledged);
+        size_t nUnsent = 0;
+        SERIALIZER_DEVICETWIN_REPORTED_CALLBACK* unsent = NULL;
+        int unsentStatusCode = SERIALIZER_DEVICETWIN_REPORTED_STATE_ERROR_STATUS_CODE;
+
+        reportedState->isPatchInFlight = false;
+        reportedState->nCallbacksInFlight = 0;
+
+        if (!isDeviceDestroyed)
+        {
+            /*Codes_SRS_SERIALIZERDEVICETWIN_02_036: [ When the PATCH is acknowledged, serializer_reportedStateCallback shall call CodeFirst_CompleteReportedDelta, which commits the shadow of the reported state only if status_code is 2xx. ]*/
+            (void)CodeFirst_CompleteReportedDelta(reportedState->device, (status_code >= 200) && (status_code < 300));
+
+            /*Codes_SRS_SERIALIZERDEVICETWIN_02_037: [ If updates were requested while the PATCH was in flight, serializer_reportedStateCallback shall send all of them in one new PATCH. ]*/
+            if (VECTOR_size(reportedState->callbacks) > 0)
+            {
+                bool isUnchanged;
+                if (sendReportedStateDelta(reportedState, &isUnchanged) != 0)
+                {
+                    /*Codes_SRS_SERIALIZERDEVICETWIN_02_038: [ If sending the new PATCH fails then serializer_reportedStateCallback shall call the callbacks of the coalesced updates with status 500. ]*/
+                    LogError("failure sending the coalesced reported state");
+                    nUnsent = VECTOR_size(reportedState->callbacks);
+                    unsent = takeReportedStateCallbacks(reportedState, nUnsent);
+                }
+                else if (isUnchanged)
+                {
+                    nUnsent = VECTOR_size(reportedState->callbacks);
+                    unsent = takeReportedStateCallbacks(reportedState, nUnsent);
+                    unsentStatusCode = SERIALIZER_DEVICETWIN_REPORTED_STATE_UNCHANGED_STATUS_CODE;
+                }
+                else
+                {
+                    /*all the waiting callbacks are now in flight*/
+                }
+            }
+        }
+        (void)Unlock(reportedState->lock);
+
+        /*Codes_SRS_SERIALIZERDEVICETWIN_02_039: [ serializer_reportedStateCallback shall call the callbacks of all the updates covered by the acknowledged PATCH with status_code, outside of the lock. ]*/
+        callReportedStateCallbacks(acknowledged, nAcknowledged, status_code);
+        callReportedStateCallbacks(unsent, nUnsent, unsentStatusCode);
+
+        if (isDeviceDestroyed)
+        {
+            destroyReportedState(reportedState);
+        }
+    }
+}
+
 static IOTHUB_CLIENT_RESULT Generic_IoTHubClient_SetCallbacks(const SERIALIZER_DEVICETWIN_PROTOHANDLE* protoHandle, IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK deviceTwinCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -252,6 +482,14 @@ static void* IoTHubDeviceTwinCreate_Impl(const char* name, size_t sizeOfName, SE
                 LogError("failure in CodeFirst_CreateDevice");
                 /*return as is*/
             }
+            /*Codes_SRS_SERIALIZERDEVICETWIN_02_034: [ IoTHubDeviceTwinCreate_Impl shall create the state used to coalesce the reported state updates of the device. ]*/
+            else if ((protoHandle->reportedState = createReportedState(&protoHandle->iothubClientHandleVariant, result)) == NULL)
+            {
+                /*Codes_SRS_SERIALIZERDEVICETWIN_02_014: [ Otherwise, IoTHubDeviceTwinCreate_Impl shall fail and return NULL. ]*/
+                LogError("failure in createReportedState");
+                CodeFirst_DestroyDevice(result);
+                result = NULL;
+            }
             else
             {
                 protoHandle->deviceAssigned = result;
@@ -259,6 +497,7 @@ static void* IoTHubDeviceTwinCreate_Impl(const char* name, size_t sizeOfName, SE
                 {
                     /*Codes_SRS_SERIALIZERDEVICETWIN_02_014: [ Otherwise, IoTHubDeviceTwinCreate_Impl shall fail and return NULL. ]*/
                     LogError("failure in Generic_IoTHubClient_SetCallbacks");
+                    destroyReportedState(protoHandle->reportedState);
                     CodeFirst_DestroyDevice(result);
                     result = NULL;
                 }
@@ -277,6 +516,7 @@ static void* IoTHubDeviceTwinCreate_Impl(const char* name, size_t sizeOfName, SE
                             /*just log the error*/
                             LogError("failure in Generic_IoTHubClient_SetCallbacks");
                         }
+                        destroyReportedState(protoHandle->reportedState);
                         CodeFirst_DestroyDevice(result);
                         result = NULL;
                     }
@@ -349,6 +589,26 @@ static void IoTHubDeviceTwin_Destroy_Impl(void* model)
                 LogError("INTERNAL ERROR");
             }
             }/*switch*/
+
+            /*Codes_SRS_SERIALIZERDEVICETWIN_02_040: [ IoTHubDeviceTwin_Destroy_Impl shall free the reported state coalescing state, unless a PATCH is in flight, in which case it shall be freed when the PATCH is acknowledged. ]*/
+            SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = protoHandle->reportedState;
+            bool isPatchInFlight;
+            if (Lock(reportedState->lock) != LOCK_OK)
+            {
+                LogError("failure in Lock");
+                isPatchInFlight = false;
+            }
+            else
+            {
+                isPatchInFlight = reportedState->isPatchInFlight;
+                reportedState->isDeviceDestroyed = true;
+                (void)Unlock(reportedState->lock);
+            }
+
+            if (!isPatchInFlight)
+            {
+                destroyReportedState(reportedState);
+            }
         }
 
         /*Codes_SRS_SERIALIZERDEVICETWIN_02_017: [ IoTHubDeviceTwin_Destroy_Impl shall call CodeFirst_DestroyDevice. ]*/
@@ -368,65 +628,70 @@ static void IoTHubDeviceTwin_Destroy_Impl(void* model)
 
 /*the below function sends the reported state of a model previously created by IoTHubDeviceTwin_Create*/
 /*this function serves both the _LL and the convenience layer because of protohandles*/
+/*only the reported properties that changed since the last acknowledged PATCH are sent. While a PATCH is in flight, the updates are coalesced into the next PATCH*/
 static IOTHUB_CLIENT_RESULT IoTHubDeviceTwin_SendReportedState_Impl(void* model, IOTHUB_CLIENT_REPORTED_STATE_CALLBACK deviceTwinCallback, void* context)
 {
-    unsigned char*buffer;
-    size_t bufferSize;
-
     IOTHUB_CLIENT_RESULT result;
 
-    if (SERIALIZE_REPORTED_PROPERTIES_FROM_POINTERS(&buffer, &bufferSize, model) != CODEFIRST_OK)
+    /*Codes_SRS_SERIALIZERDEVICETWIN_02_030: [ IoTHubDeviceTwin_SendReportedState_Impl shall find model in the list of devices. ]*/
+    SERIALIZER_DEVICETWIN_PROTOHANDLE* protoHandle = (SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model);
+    if (protoHandle == NULL)
     {
-        LogError("Failed serializing reported state");
+        /*Codes_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+        LogError("failure in VECTOR_find_if [not found]");
         result = IOTHUB_CLIENT_ERROR;
     }
     else
     {
-        SERIALIZER_DEVICETWIN_PROTOHANDLE* protoHandle = (SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model);
-        if (protoHandle == NULL)
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = protoHandle->reportedState;
+        if (Lock(reportedState->lock) != LOCK_OK)
         {
-            LogError("failure in VECTOR_find_if [not found]");
+            /*Codes_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            LogError("failure in Lock");
             result = IOTHUB_CLIENT_ERROR;
         }
         else
         {
-            switch (protoHandle->iothubClientHandleVariant.iothubClientHandleType)
+            SERIALIZER_DEVICETWIN_REPORTED_CALLBACK callback;
+            bool isUnchanged = false;
+            callback.reportedStateCallback = deviceTwinCallback;
+            callback.context = context;
+
+            if (VECTOR_push_back(reportedState->callbacks, &callback, 1) != 0)
             {
-                case IOTHUB_CLIENT_CONVENIENCE_HANDLE_TYPE:
-                {
-                    if (IoTHubClient_SendReportedState(protoHandle->iothubClientHandleVariant.iothubClientHandleValue.iothubClientHandle, buffer, bufferSize, deviceTwinCallback, context) != IOTHUB_CLIENT_OK)
-                    {
-                        LogError("Failure sending data");
-                        result = IOTHUB_CLIENT_ERROR;
-                    }
-                    else
-                    {
-                        result = IOTHUB_CLIENT_OK;
-                    }
-                    break;
-                }
-                case IOTHUB_CLIENT_LL_HANDLE_TYPE:
-                {
-                    if (IoTHubClient_LL_SendReportedState(protoHandle->iothubClientHandleVariant.iothubClientHandleValue.iothubClientLLHandle, buffer, bufferSize, deviceTwinCallback, context) != IOTHUB_CLIENT_OK)
-                    {
-                        LogError("Failure sending data");
-                        result = IOTHUB_CLIENT_ERROR;
-                    }
-                    else
-                    {
-                        result = IOTHUB_CLIENT_OK;
-                    }
-                    break;
-                }
-                default:
+                /*Codes_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                LogError("failure in VECTOR_push_back");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (reportedState->isPatchInFlight)
+            {
+                /*Codes_SRS_SERIALIZERDEVICETWIN_02_041: [ If a PATCH is in flight then IoTHubDeviceTwin_SendReportedState_Impl shall only record deviceTwinCallback and context and return IOTHUB_CLIENT_OK; the update is sent in the PATCH that follows the acknowledgement of the one in flight. ]*/
+                result = IOTHUB_CLIENT_OK;
+            }
+            else if (sendReportedStateDelta(reportedState, &isUnchanged) != 0)
+            {
+                /*Codes_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                LogError("failure in sendReportedStateDelta");
+                VECTOR_erase(reportedState->callbacks, VECTOR_back(reportedState->callbacks), 1);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (isUnchanged)
                 {
-                    LogError("INTERNAL ERROR: unexpected value for enum (%d)", (int)protoHandle->iothubClientHandleVariant.iothubClientHandleType);
-                    result = IOTHUB_CLIENT_ERROR;
-                    break;
+                    VECTOR_erase(reportedState->callbacks, VECTOR_back(reportedState->callbacks), 1);
                 }
+                /*Codes_SRS_SERIALIZERDEVICETWIN_02_032: [ IoTHubDeviceTwin_SendReportedState_Impl shall succeed and return IOTHUB_CLIENT_OK when all operations complete successfully. ]*/
+                result = IOTHUB_CLIENT_OK;
+            }
+            (void)Unlock(reportedState->lock);
+
+            /*Codes_SRS_SERIALIZERDEVICETWIN_02_035: [ If no reported property changed since the last acknowledged PATCH then IoTHubDeviceTwin_SendReportedState_Impl shall not send anything, shall call deviceTwinCallback with status 204 and return IOTHUB_CLIENT_OK. ]*/
+            if (isUnchanged && (deviceTwinCallback != NULL))
+            {
+                deviceTwinCallback(SERIALIZER_DEVICETWIN_REPORTED_STATE_UNCHANGED_STATUS_CODE, context);
             }
         }
-        free(buffer);
     }
     return result;
 }
@@ -0,0 +1,451 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+
+#include <stdint.h>
+#include <string.h>
+#include "cborencoder.h"
+#include "agenttypesystem.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+DEFINE_ENUM_STRINGS(CBOR_ENCODER_RESULT, CBOR_ENCODER_RESULT_VALUES);
+
+/*CBOR major types (RFC 7049, section 2.1)*/
+#define CBOR_MAJOR_TYPE_UNSIGNED_INTEGER 0
+#define CBOR_MAJOR_TYPE_NEGATIVE_INTEGER 1
+#define CBOR_MAJOR_TYPE_BYTE_STRING      2
+#define CBOR_MAJOR_TYPE_TEXT_STRING      3
+#define CBOR_MAJOR_TYPE_MAP              5
+
+#define CBOR_FALSE             0xF4
+#define CBOR_TRUE              0xF5
+#define CBOR_NULL              0xF6
+#define CBOR_SINGLE_PRECISION  0xFA
+#define CBOR_DOUBLE_PRECISION  0xFB
+
+#define CBOR_WRITER_INITIAL_CAPACITY 64
+
+typedef struct CBOR_WRITER_TAG
+{
+    unsigned char* buffer;
+    size_t size;
+    size_t capacity;
+} CBOR_WRITER;
+
+static int CBORWriter_Reserve(CBOR_WRITER* writer, size_t extraSize)
+{
+    int result;
+    if (writer->size + extraSize <= writer->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newCapacity = (writer->capacity == 0) ? CBOR_WRITER_INITIAL_CAPACITY : writer->capacity;
+        while (newCapacity < writer->size + extraSize)
+        {
+            newCapacity *= 2;
+        }
+
+        unsigned char* newBuffer = (unsigned char*)realloc(writer->buffer, newCapacity);
+        if (newBuffer == NULL)
+        {
+            LogError("failure growing the CBOR output to %zu bytes", newCapacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            writer->buffer = newBuffer;
+            writer->capacity = newCapacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static int CBORWriter_WriteBytes(CBOR_WRITER* writer, const unsigned char* bytes, size_t size)
+{
+    int result;
+    if (CBORWriter_Reserve(writer, size) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (size > 0)
+        {
+            (void)memcpy(writer->buffer + writer->size, bytes, size);
+            writer->size += size;
+        }
+        result = 0;
+    }
+    return result;
+}
+
+/*writes the initial byte of a data item and its argument in the shortest form possible*/
+static int CBORWriter_WriteHead(CBOR_WRITER* writer, unsigned char majorType, uint64_t argument)
+{
+    unsigned char head[9];
+    size_t headSize;
+    unsigned char initialByte = (unsigned char)(majorType << 5);
+
+    if (argument < 24)
+    {
+        head[0] = (unsigned char)(initialByte | argument);
+        headSize = 1;
+    }
+    else if (argument <= UINT8_MAX)
+    {
+        head[0] = initialByte | 24;
+        headSize = 2;
+    }
+    else if (argument <= UINT16_MAX)
+    {
+        head[0] = initialByte | 25;
+        headSize = 3;
+    }
+    else if (argument <= UINT32_MAX)
+    {
+        head[0] = initialByte | 26;
+        headSize = 5;
+    }
+    else
+    {
+        head[0] = initialByte | 27;
+        headSize = 9;
+    }
+
+    /*the argument follows the initial byte in network byte order*/
+    for (size_t i = 1; i < headSize; i++)
+    {
+        head[i] = (unsigned char)(argument >> (8 * (headSize - 1 - i)));
+    }
+
+    return CBORWriter_WriteBytes(writer, head, headSize);
+}
+
+static int CBORWriter_WriteSignedInteger(CBOR_WRITER* writer, int64_t value)
+{
+    int result;
+    if (value >= 0)
+    {
+        result = CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)value);
+    }
+    else
+    {
+        /*negative integers are encoded as -1 - value, which cannot overflow even for INT64_MIN*/
+        result = CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_NEGATIVE_INTEGER, (uint64_t)(-(value + 1)));
+    }
+    return result;
+}
+
+static int CBORWriter_WriteTextString(CBOR_WRITER* writer, const char* text, size_t length)
+{
+    int result;
+    if (CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_TEXT_STRING, length) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = CBORWriter_WriteBytes(writer, (const unsigned char*)text, length);
+    }
+    return result;
+}
+
+static int CBORWriter_WriteSimple(CBOR_WRITER* writer, unsigned char value)
+{
+    return CBORWriter_WriteBytes(writer, &value, 1);
+}
+
+static int CBORWriter_WriteFloat(CBOR_WRITER* writer, float value)
+{
+    unsigned char encoded[5];
+    uint32_t bits;
+    (void)memcpy(&bits, &value, sizeof(bits));
+    encoded[0] = CBOR_SINGLE_PRECISION;
+    for (size_t i = 0; i < 4; i++)
+    {
+        encoded[1 + i] = (unsigned char)(bits >> (8 * (3 - i)));
+    }
+    return CBORWriter_WriteBytes(writer, encoded, sizeof(encoded));
+}
+
+static int CBORWriter_WriteDouble(CBOR_WRITER* writer, double value)
+{
+    unsigned char encoded[9];
+    uint64_t bits;
+    (void)memcpy(&bits, &value, sizeof(bits));
+    encoded[0] = CBOR_DOUBLE_PRECISION;
+    for (size_t i = 0; i < 8; i++)
+    {
+        encoded[1 + i] = (unsigned char)(bits >> (8 * (7 - i)));
+    }
+    return CBORWriter_WriteBytes(writer, encoded, sizeof(encoded));
+}
+
+static int WriteKey(CBOR_WRITER* writer, const char* name, const char* const* keys, size_t keyCount)
+{
+    int result;
+    size_t i;
+
+    /*Codes_SRS_CBOR_ENCODER_02_006: [ If keys is not NULL and the name of a node or of a struct member is found in keys then CBOREncoder_EncodeTree shall encode the name as the unsigned integer index of the name in keys. ]*/
+    for (i = 0; (keys != NULL) && (i < keyCount); i++)
+    {
+        if ((keys[i] != NULL) && (strcmp(keys[i], name) == 0))
+        {
+            break;
+        }
+    }
+
+    if ((keys != NULL) && (i < keyCount))
+    {
+        result = CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, i);
+    }
+    else
+    {
+        /*Codes_SRS_CBOR_ENCODER_02_007: [ Otherwise the name shall be encoded as a CBOR text string. ]*/
+        result = CBORWriter_WriteTextString(writer, name, strlen(name));
+    }
+    return result;
+}
+
+static CBOR_ENCODER_RESULT WriteAgentDataType(CBOR_WRITER* writer, const AGENT_DATA_TYPE* value, const char* const* keys, size_t keyCount)
+{
+    CBOR_ENCODER_RESULT result;
+
+    /*Codes_SRS_CBOR_ENCODER_02_008: [ CBOREncoder_EncodeTree shall encode the value of every leaf according to its AGENT_DATA_TYPE_TYPE: booleans as CBOR simple values, integers as CBOR integers, EDM_SINGLE and EDM_DOUBLE as single and double precision floats, strings as text strings, EDM_BINARY as byte strings, EDM_NULL_TYPE as CBOR null and structs as CBOR maps. ]*/
+    switch (value->type)
+    {
+        case EDM_BOOLEAN_TYPE:
+        {
+            result = (CBORWriter_WriteSimple(writer, (value->value.edmBoolean.value == EDM_TRUE) ? CBOR_TRUE : CBOR_FALSE) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_BYTE_TYPE:
+        {
+            result = (CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, value->value.edmByte.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_SBYTE_TYPE:
+        {
+            result = (CBORWriter_WriteSignedInteger(writer, value->value.edmSbyte.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_INT16_TYPE:
+        {
+            result = (CBORWriter_WriteSignedInteger(writer, value->value.edmInt16.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_INT32_TYPE:
+        {
+            result = (CBORWriter_WriteSignedInteger(writer, value->value.edmInt32.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_INT64_TYPE:
+        {
+            result = (CBORWriter_WriteSignedInteger(writer, value->value.edmInt64.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_SINGLE_TYPE:
+        {
+            result = (CBORWriter_WriteFloat(writer, value->value.edmSingle.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_DOUBLE_TYPE:
+        {
+            result = (CBORWriter_WriteDouble(writer, value->value.edmDouble.value) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_STRING_TYPE:
+        {
+            result = (CBORWriter_WriteTextString(writer, value->value.edmString.chars, value->value.edmString.length) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_STRING_NO_QUOTES_TYPE:
+        {
+            result = (CBORWriter_WriteTextString(writer, value->value.edmStringNoQuotes.chars, value->value.edmStringNoQuotes.length) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_BINARY_TYPE:
+        {
+            result = ((CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_BYTE_STRING, value->value.edmBinary.size) == 0) &&
+                (CBORWriter_WriteBytes(writer, value->value.edmBinary.data, value->value.edmBinary.size) == 0)) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_NULL_TYPE:
+        {
+            result = (CBORWriter_WriteSimple(writer, CBOR_NULL) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+            break;
+        }
+        case EDM_COMPLEX_TYPE_TYPE:
+        {
+            size_t i;
+            if (CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_MAP, value->value.edmComplexType.nMembers) != 0)
+            {
+                result = CBOR_ENCODER_ERROR;
+            }
+            else
+            {
+                result = CBOR_ENCODER_OK;
+                for (i = 0; (i < value->value.edmComplexType.nMembers) && (result == CBOR_ENCODER_OK); i++)
+                {
+                    if (WriteKey(writer, value->value.edmComplexType.fields[i].fieldName, keys, keyCount) != 0)
+                    {
+                        result = CBOR_ENCODER_ERROR;
+                    }
+                    else
+                    {
+                        result = WriteAgentDataType(writer, value->value.edmComplexType.fields[i].value, keys, keyCount);
+                    }
+                }
+            }
+            break;
+        }
+        default:
+        {
+            /*Codes_SRS_CBOR_ENCODER_02_009: [ Values of any other type (dates, GUIDs, decimals, geography etc) shall be converted by AgentDataTypes_ToString and encoded as a text string without the enclosing JSON quotes. ]*/
+            STRING_HANDLE asString = STRING_new();
+            if (asString == NULL)
+            {
+                LogError("failure in STRING_new");
+                result = CBOR_ENCODER_ERROR;
+            }
+            else
+            {
+                if (AgentDataTypes_ToString(asString, value) != AGENT_DATA_TYPES_OK)
+                {
+                    LogError("failure in AgentDataTypes_ToString");
+                    result = CBOR_ENCODER_AGENT_DATA_TYPES_ERROR;
+                }
+                else
+                {
+                    const char* text = STRING_c_str(asString);
+                    size_t length = strlen(text);
+                    if ((length >= 2) && (text[0] == '"') && (text[length - 1] == '"'))
+                    {
+                        text++;
+                        length -= 2;
+                    }
+                    result = (CBORWriter_WriteTextString(writer, text, length) == 0) ? CBOR_ENCODER_OK : CBOR_ENCODER_ERROR;
+                }
+                STRING_delete(asString);
+            }
+            break;
+        }
+    }
+
+    if (result != CBOR_ENCODER_OK)
+    {
+        LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+    }
+    return result;
+}
+
+static CBOR_ENCODER_RESULT WriteTree(CBOR_WRITER* writer, MULTITREE_HANDLE treeHandle, const char* const* keys, size_t keyCount)
+{
+    CBOR_ENCODER_RESULT result;
+    size_t childCount;
+
+    if (MultiTree_GetChildCount(treeHandle, &childCount) != MULTITREE_OK)
+    {
+        result = CBOR_ENCODER_MULTITREE_ERROR;
+        LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+    }
+    /*Codes_SRS_CBOR_ENCODER_02_004: [ Every node of the tree shall be encoded as a CBOR map having as many pairs as the node has children. ]*/
+    else if (CBORWriter_WriteHead(writer, CBOR_MAJOR_TYPE_MAP, childCount) != 0)
+    {
+        result = CBOR_ENCODER_ERROR;
+        LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+    }
+    else
+    {
+        STRING_HANDLE name = STRING_new();
+        if (name == NULL)
+        {
+            result = CBOR_ENCODER_ERROR;
+            LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+        }
+        else
+        {
+            size_t i;
+            result = CBOR_ENCODER_OK;
+            for (i = 0; (i < childCount) && (result == CBOR_ENCODER_OK); i++)
+            {
+                MULTITREE_HANDLE childTreeHandle;
+                size_t innerChildCount;
+                if ((STRING_empty(name) != 0) ||
+                    (MultiTree_GetChild(treeHandle, i, &childTreeHandle) != MULTITREE_OK) ||
+                    (MultiTree_GetName(childTreeHandle, name) != MULTITREE_OK) ||
+                    (MultiTree_GetChildCount(childTreeHandle, &innerChildCount) != MULTITREE_OK))
+                {
+                    result = CBOR_ENCODER_MULTITREE_ERROR;
+                    LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+                }
+                /*Codes_SRS_CBOR_ENCODER_02_005: [ The key of every pair shall be the name of the child node and the value shall be either the encoding of the child node (if it has children) or the encoding of its value. ]*/
+                else if (WriteKey(writer, STRING_c_str(name), keys, keyCount) != 0)
+                {
+                    result = CBOR_ENCODER_ERROR;
+                    LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+                }
+                else if (innerChildCount > 0)
+                {
+                    result = WriteTree(writer, childTreeHandle, keys, keyCount);
+                }
+                else
+                {
+                    const void* value;
+                    if (MultiTree_GetValue(childTreeHandle, &value) != MULTITREE_OK)
+                    {
+                        result = CBOR_ENCODER_MULTITREE_ERROR;
+                        LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+                    }
+                    else
+                    {
+                        result = WriteAgentDataType(writer, (const AGENT_DATA_TYPE*)value, keys, keyCount);
+                    }
+                }
+            }
+            STRING_delete(name);
+        }
+    }
+
+    return result;
+}
+
+CBOR_ENCODER_RESULT CBOREncoder_EncodeTree(MULTITREE_HANDLE treeHandle, const char* const* keys, size_t keyCount, unsigned char** destination, size_t* destinationSize)
+{
+    CBOR_ENCODER_RESULT result;
+
+    /*Codes_SRS_CBOR_ENCODER_02_001: [ If treeHandle, destination or destinationSize is NULL then CBOREncoder_EncodeTree shall fail and return CBOR_ENCODER_INVALID_ARG. ]*/
+    if ((treeHandle == NULL) ||
+        (destination == NULL) ||
+        (destinationSize == NULL))
+    {
+        result = CBOR_ENCODER_INVALID_ARG;
+        LogError("invalid argument MULTITREE_HANDLE treeHandle=%p, unsigned char** destination=%p, size_t* destinationSize=%p", treeHandle, destination, destinationSize);
+    }
+    else
+    {
+        CBOR_WRITER writer = { NULL, 0, 0 };
+
+        if ((result = WriteTree(&writer, treeHandle, keys, keyCount)) != CBOR_ENCODER_OK)
+        {
+            /*Codes_SRS_CBOR_ENCODER_02_003: [ If any failure occurs, CBOREncoder_EncodeTree shall fail, free any memory it allocated and return a value different from CBOR_ENCODER_OK. ]*/
+            LogError("(result = %s)", ENUM_TO_STRING(CBOR_ENCODER_RESULT, result));
+            free(writer.buffer);
+        }
+        else
+        {
+            /*Codes_SRS_CBOR_ENCODER_02_002: [ On success CBOREncoder_EncodeTree shall set *destination to a newly allocated buffer holding the CBOR encoding of the tree, *destinationSize to its size and return CBOR_ENCODER_OK. ]*/
+            *destination = writer.buffer;
+            *destinationSize = writer.size;
+        }
+    }
+
+    return result;
+}
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdarg.h>
+#include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 
 #include "codefirst.h"
@@ -10,8 +11,10 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include <stddef.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "iotdevice.h"
+#include "fnv1a.h"
 
 DEFINE_ENUM_STRINGS(CODEFIRST_RESULT, CODEFIRST_RESULT_VALUES)
 DEFINE_ENUM_STRINGS(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_RESULT_VALUES)
@@ -26,8 +29,20 @@ typedef struct DEVICE_HEADER_DATA_TAG
     SCHEMA_MODEL_TYPE_HANDLE ModelHandle;
     size_t DataSize;
     unsigned char* data;
+    struct REPORTED_PROPERTY_SHADOW_TAG* reportedShadow; /*lazily built by CodeFirst_SendAsyncReportedDelta*/
+    size_t reportedShadowCount;
 } DEVICE_HEADER_DATA;
 
+/*what the service is known to have (acknowledged) and what is on its way (in flight) for one reported property of a device*/
+typedef struct REPORTED_PROPERTY_SHADOW_TAG
+{
+    const REFLECTED_SOMETHING* reportedProperty;
+    bool isAcknowledged;
+    uint64_t acknowledgedHash;
+    bool isInFlight;
+    uint64_t inFlightHash;
+} REPORTED_PROPERTY_SHADOW;
+
 #define COUNT_OF(A) (sizeof(A) / sizeof((A)[0]))
 
 /*design considerations for lazy init of CodeFirst:
@@ -159,6 +174,7 @@ static void DestroyDevice(DEVICE_HEADER_DATA* deviceHeader)
     /* Codes_SRS_CODEFIRST_99_087:[In order to release the device handle, CodeFirst_DestroyDevice shall call Device_Destroy.] */
     
     Device_Destroy(deviceHeader->DeviceHandle);
+    free(deviceHeader->reportedShadow);
     free(deviceHeader->data);
     free(deviceHeader);
 }
@@ -914,6 +930,9 @@ void* CodeFirst_CreateDevice(SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DAT
             {
                 DEVICE_HEADER_DATA** newDevices;
 
+                deviceHeader->reportedShadow = NULL;
+                deviceHeader->reportedShadowCount = 0;
+
                 initializeDesiredProperties(model, deviceHeader->data);
 
                 if (Device_Create(model, CodeFirst_InvokeAction, deviceHeader, CodeFirst_InvokeMethod, deviceHeader, 
@@ -1523,6 +1542,243 @@ CODEFIRST_RESULT CodeFirst_SendAsyncReported(unsigned char** destination, size_t
     return result;
 }
 
+/*builds (once per device) the list of reported properties that CodeFirst_SendAsyncReportedDelta keeps track of*/
+static int EnsureReportedShadow(DEVICE_HEADER_DATA* deviceHeader)
+{
+    int result;
+    if (deviceHeader->reportedShadow != NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        const char* modelName = Schema_GetModelName(deviceHeader->ModelHandle);
+        const REFLECTED_SOMETHING* something;
+        size_t nReportedProperties = 0;
+
+        for (something = deviceHeader->ReflectedData->reflectedData; something != NULL; something = something->next)
+        {
+            if ((something->type == REFLECTION_REPORTED_PROPERTY_TYPE) &&
+                (strcmp(something->what.reportedProperty.modelName, modelName) == 0))
+            {
+                nReportedProperties++;
+            }
+        }
+
+        if (nReportedProperties == 0)
+        {
+            LogError("model %s has no reported properties", modelName);
+            result = __FAILURE__;
+        }
+        else if ((deviceHeader->reportedShadow = (REPORTED_PROPERTY_SHADOW*)malloc(nReportedProperties * sizeof(REPORTED_PROPERTY_SHADOW))) == NULL)
+        {
+            LogError("failure in malloc");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i = 0;
+            for (something = deviceHeader->ReflectedData->reflectedData; something != NULL; something = something->next)
+            {
+                if ((something->type == REFLECTION_REPORTED_PROPERTY_TYPE) &&
+                    (strcmp(something->what.reportedProperty.modelName, modelName) == 0))
+                {
+                    deviceHeader->reportedShadow[i].reportedProperty = something;
+                    deviceHeader->reportedShadow[i].isAcknowledged = false;
+                    deviceHeader->reportedShadow[i].acknowledgedHash = 0;
+                    deviceHeader->reportedShadow[i].isInFlight = false;
+                    deviceHeader->reportedShadow[i].inFlightHash = 0;
+                    i++;
+                }
+            }
+            deviceHeader->reportedShadowCount = nReportedProperties;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*64 bit FNV-1a of the JSON text of the value - two values that serialize the same are the same as far as the service is concerned*/
+static int HashAgentDataType(const AGENT_DATA_TYPE* agentDataType, uint64_t* hash)
+{
+    int result;
+    STRING_HANDLE asString = STRING_new();
+    if (asString == NULL)
+    {
+        LogError("failure in STRING_new");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (AgentDataTypes_ToString(asString, agentDataType) != AGENT_DATA_TYPES_OK)
+        {
+            LogError("failure in AgentDataTypes_ToString");
+            result = __FAILURE__;
+        }
+        else
+        {
+            const char* text = STRING_c_str(asString);
+            *hash = FNV1a_Hash(text, strlen(text));
+            result = 0;
+        }
+        STRING_delete(asString);
+    }
+    return result;
+}
+
+static void ForgetReportedDeltaInFlight(DEVICE_HEADER_DATA* deviceHeader)
+{
+    size_t i;
+    for (i = 0; i < deviceHeader->reportedShadowCount; i++)
+    {
+        deviceHeader->reportedShadow[i].isInFlight = false;
+    }
+}
+
+CODEFIRST_RESULT CodeFirst_SendAsyncReportedDelta(unsigned char** destination, size_t* destinationSize, void* device)
+{
+    CODEFIRST_RESULT result;
+    DEVICE_HEADER_DATA* deviceHeader;
+
+    /*Codes_SRS_CODEFIRST_02_065: [ If destination, destinationSize or device is NULL then CodeFirst_SendAsyncReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    if ((destination == NULL) || (destinationSize == NULL) || (device == NULL))
+    {
+        result = CODEFIRST_INVALID_ARG;
+        LogError("invalid argument unsigned char** destination=%p, size_t* destinationSize=%p, void* device=%p", destination, destinationSize, device);
+    }
+    /*Codes_SRS_CODEFIRST_02_066: [ If device is not a complete model instance created by CodeFirst_CreateDevice then CodeFirst_SendAsyncReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    else if (((deviceHeader = FindDevice(device)) == NULL) || (deviceHeader->data != (unsigned char*)device))
+    {
+        result = CODEFIRST_INVALID_ARG;
+        LOG_CODEFIRST_ERROR;
+    }
+    else if (EnsureReportedShadow(deviceHeader) != 0)
+    {
+        /*Codes_SRS_CODEFIRST_02_072: [ If any error occurs, CodeFirst_SendAsyncReportedDelta shall fail, consider no reported property in flight and return a value different from CODEFIRST_OK. ]*/
+        result = CODEFIRST_ERROR;
+        LOG_CODEFIRST_ERROR;
+    }
+    else
+    {
+        REPORTED_PROPERTIES_TRANSACTION_HANDLE transaction = NULL;
+        unsigned char* deviceAddress = (unsigned char*)deviceHeader->data;
+        size_t i;
+
+        result = CODEFIRST_OK;
+        ForgetReportedDeltaInFlight(deviceHeader);
+
+        for (i = 0; (i < deviceHeader->reportedShadowCount) && (result == CODEFIRST_OK); i++)
+        {
+            REPORTED_PROPERTY_SHADOW* shadow = &(deviceHeader->reportedShadow[i]);
+            AGENT_DATA_TYPE agentDataType;
+            uint64_t hash;
+
+            /*Codes_SRS_CODEFIRST_02_067: [ CodeFirst_SendAsyncReportedDelta shall convert every reported property of the device to AGENT_DATA_TYPE and compute a hash of its JSON representation. ]*/
+            if (shadow->reportedProperty->what.reportedProperty.Create_AGENT_DATA_TYPE_from_Ptr(deviceAddress + shadow->reportedProperty->what.reportedProperty.offset, &agentDataType) != AGENT_DATA_TYPES_OK)
+            {
+                result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
+                LOG_CODEFIRST_ERROR;
+            }
+            else
+            {
+                if (HashAgentDataType(&agentDataType, &hash) != 0)
+                {
+                    result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
+                    LOG_CODEFIRST_ERROR;
+                }
+                /*Codes_SRS_CODEFIRST_02_068: [ CodeFirst_SendAsyncReportedDelta shall skip the reported properties whose hash is the same as the hash of the last acknowledged value. ]*/
+                else if (shadow->isAcknowledged && (shadow->acknowledgedHash == hash))
+                {
+                    /*unchanged, the service already has it*/
+                }
+                /*Codes_SRS_CODEFIRST_02_069: [ CodeFirst_SendAsyncReportedDelta shall publish all the other reported properties in one transaction created by Device_CreateTransaction_ReportedProperties and committed by Device_CommitTransaction_ReportedProperties, and shall remember their hashes as in flight. ]*/
+                else if ((transaction == NULL) &&
+                    ((transaction = Device_CreateTransaction_ReportedProperties(deviceHeader->DeviceHandle)) == NULL))
+                {
+                    result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+                    LOG_CODEFIRST_ERROR;
+                }
+                else if (Device_PublishTransacted_ReportedProperty(transaction, shadow->reportedProperty->what.reportedProperty.name, &agentDataType) != DEVICE_OK)
+                {
+                    result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+                    LOG_CODEFIRST_ERROR;
+                }
+                else
+                {
+                    shadow->isInFlight = true;
+                    shadow->inFlightHash = hash;
+                }
+                Destroy_AGENT_DATA_TYPE(&agentDataType);
+            }
+        }
+
+        if (result != CODEFIRST_OK)
+        {
+            /*Codes_SRS_CODEFIRST_02_072: [ If any error occurs, CodeFirst_SendAsyncReportedDelta shall fail, consider no reported property in flight and return a value different from CODEFIRST_OK. ]*/
+            ForgetReportedDeltaInFlight(deviceHeader);
+        }
+        else if (transaction == NULL)
+        {
+            /*Codes_SRS_CODEFIRST_02_070: [ If no reported property changed then CodeFirst_SendAsyncReportedDelta shall set *destination to NULL, *destinationSize to 0 and return CODEFIRST_OK. ]*/
+            *destination = NULL;
+            *destinationSize = 0;
+        }
+        else if (Device_CommitTransaction_ReportedProperties(transaction, destination, destinationSize) != DEVICE_OK)
+        {
+            /*Codes_SRS_CODEFIRST_02_072: [ If any error occurs, CodeFirst_SendAsyncReportedDelta shall fail, consider no reported property in flight and return a value different from CODEFIRST_OK. ]*/
+            result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+            LOG_CODEFIRST_ERROR;
+            ForgetReportedDeltaInFlight(deviceHeader);
+        }
+        else
+        {
+            /*Codes_SRS_CODEFIRST_02_071: [ Otherwise CodeFirst_SendAsyncReportedDelta shall return CODEFIRST_OK. ]*/
+        }
+
+        if (transaction != NULL)
+        {
+            Device_DestroyTransaction_ReportedProperties(transaction);
+        }
+    }
+    return result;
+}
+
+CODEFIRST_RESULT CodeFirst_CompleteReportedDelta(void* device, bool isAcknowledged)
+{
+    CODEFIRST_RESULT result;
+    DEVICE_HEADER_DATA* deviceHeader;
+
+    /*Codes_SRS_CODEFIRST_02_073: [ If device is NULL or it is not a complete model instance created by CodeFirst_CreateDevice then CodeFirst_CompleteReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    if ((device == NULL) ||
+        ((deviceHeader = FindDevice(device)) == NULL) ||
+        (deviceHeader->data != (unsigned char*)device))
+    {
+        result = CODEFIRST_INVALID_ARG;
+        LogError("invalid argument void* device=%p", device);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < deviceHeader->reportedShadowCount; i++)
+        {
+            REPORTED_PROPERTY_SHADOW* shadow = &(deviceHeader->reportedShadow[i]);
+            if (shadow->isInFlight)
+            {
+                /*Codes_SRS_CODEFIRST_02_074: [ If isAcknowledged is true then CodeFirst_CompleteReportedDelta shall make the hashes in flight the last acknowledged hashes. ]*/
+                if (isAcknowledged)
+                {
+                    shadow->isAcknowledged = true;
+                    shadow->acknowledgedHash = shadow->inFlightHash;
+                }
+                /*Codes_SRS_CODEFIRST_02_075: [ CodeFirst_CompleteReportedDelta shall consider no reported property in flight and return CODEFIRST_OK. ]*/
+                shadow->isInFlight = false;
+            }
+        }
+        result = CODEFIRST_OK;
+    }
+    return result;
+}
+
 EXECUTE_COMMAND_RESULT CodeFirst_ExecuteCommand(void* device, const char* command)
 {
     EXECUTE_COMMAND_RESULT result;
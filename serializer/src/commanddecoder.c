@@ -6,6 +6,7 @@
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include "commanddecoder.h"
 #include "multitree.h"
@@ -14,6 +15,7 @@
 #include "schema.h"
 #include "codefirst.h"
 #include "jsondecoder.h"
+#include "azure_c_shared_utility/vector.h"
 
 DEFINE_ENUM_STRINGS(COMMANDDECODER_RESULT, COMMANDDECODER_RESULT_VALUES);
 
@@ -940,43 +942,465 @@ static EXECUTE_COMMAND_RESULT DecodeDesiredProperties(void* startAddress, COMMAN
     return validateModel_vs_Multitree(startAddress, handle->ModelHandle, desiredPropertiesTree, 0 )?EXECUTE_COMMAND_SUCCESS:EXECUTE_COMMAND_FAILED;
 }
 
-/* Raw JSON has properties we don't need; potentially nodes other than "desired" for full TWIN as well as a $version we don't pass to callees */
-static bool RemoveUnneededTwinProperties(MULTITREE_HANDLE initialParsedTree, bool parseDesiredNode, MULTITREE_HANDLE *desiredPropertiesTree)
+/* Raw JSON has properties we don't need: a $version we don't pass to callees */
+static bool RemoveUnneededTwinProperties(MULTITREE_HANDLE initialParsedTree, MULTITREE_HANDLE *desiredPropertiesTree)
 {
-    MULTITREE_HANDLE updateTree;
     bool result;
 
-    if (parseDesiredNode)
+    /*Codes_COMMAND_DECODER_02_015: [ Remove '$version' string from node, if it is present.  It not being present is not an error ]*/
+    MULTITREE_RESULT deleteChildResult = MultiTree_DeleteChild(initialParsedTree, "$version");
+    if ((deleteChildResult == MULTITREE_OK) || (deleteChildResult == MULTITREE_CHILD_NOT_FOUND))
     {
+        *desiredPropertiesTree = initialParsedTree;
+        result = true;
+    }
+    else
+    {
+        *desiredPropertiesTree = NULL;
+        result = false;
+    }
+
+    return result;
+}
+
+/*a full TWIN is not turned into a MULTITREE: it carries the "reported" part and the metadata of the TWIN, which can be much larger than*/
+/*the "desired" part. JSONDecoder_JSON_To_Events walks the payload once and the callbacks below match every member of "desired" against*/
+/*the model as they go, everything else is skipped without being materialized. Only struct typed desired properties are collected into*/
+/*a (small) MULTITREE, because all their members have to be known before the AGENT_DATA_TYPE can be built.*/
+/*The decoded values are staged and only written to the device once all of "desired" has been ingested, so a TWIN that fails changes nothing*/
+typedef struct DESIRED_PROPERTIES_FRAME_TAG
+{
+    SCHEMA_MODEL_TYPE_HANDLE modelHandle; /*the model whose members are being ingested, NULL while collecting a struct*/
+    size_t offset; /*offset of the model in the device memory area*/
+    MULTITREE_HANDLE structNode; /*while collecting a struct, the node that receives the members*/
+    SCHEMA_DESIRED_PROPERTY_HANDLE structDesiredProperty; /*only set on the frame that started collecting the struct*/
+} DESIRED_PROPERTIES_FRAME;
+
+typedef struct DESIRED_PROPERTY_UPDATE_TAG
+{
+    size_t offset; /*offset of the model in the device memory area*/
+    SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle; /*NULL when the update is the pfOnDesiredProperty of a model in model*/
+    AGENT_DATA_TYPE value;
+    pfOnDesiredProperty onDesiredProperty;
+} DESIRED_PROPERTY_UPDATE;
+
+typedef struct DESIRED_PROPERTIES_INGEST_CONTEXT_TAG
+{
+    void* startAddress;
+    SCHEMA_MODEL_TYPE_HANDLE modelHandle;
+    VECTOR_HANDLE frames; /*holds DESIRED_PROPERTIES_FRAME, the top of the stack is the object currently being parsed*/
+    VECTOR_HANDLE updates; /*holds DESIRED_PROPERTY_UPDATE, in the order of the JSON*/
+    bool desiredNodeFound;
+    size_t nFailed;
+} DESIRED_PROPERTIES_INGEST_CONTEXT;
+
+/*struct members point into the (cloned) JSON payload, which outlives the tree*/
+static void NoFreeFunction(void* value)
+{
+    (void)value;
+}
+
+static int NoCloneFunction(void** destination, const void* source)
+{
+    *destination = (void*)source;
+    return 0;
+}
+
+static int IngestDesiredProperty(void* startAddress, size_t offset, SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle, AGENT_DATA_TYPE* value)
+{
+    int result;
+    /*Codes_SRS_COMMAND_DECODER_02_008: [ The desired property shall be constructed in memory by calling pfDesiredPropertyFromAGENT_DATA_TYPE. ]*/
+    pfDesiredPropertyFromAGENT_DATA_TYPE leFunction = Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(desiredPropertyHandle);
+    if (leFunction(value, (char*)startAddress + offset + Schema_GetModelDesiredProperty_offset(desiredPropertyHandle)) != 0)
+    {
+        LogError("failure in a function that converts from AGENT_DATA_TYPE to C data");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_COMMAND_DECODER_02_013: [ If the desired property has a non-NULL pfOnDesiredProperty then it shall be called. ]*/
+        pfOnDesiredProperty onDesiredProperty = Schema_GetModelDesiredProperty_pfOnDesiredProperty(desiredPropertyHandle);
+        if (onDesiredProperty != NULL)
+        {
+            onDesiredProperty((char*)startAddress + offset);
+        }
+        result = 0;
+    }
+    return result;
+}
+
+/*takes ownership of value, even when it fails*/
+static int StageDesiredProperty(DESIRED_PROPERTIES_INGEST_CONTEXT* ingestContext, size_t offset, SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle, AGENT_DATA_TYPE* value)
+{
+    int result;
+    DESIRED_PROPERTY_UPDATE update;
+    update.offset = offset;
+    update.desiredPropertyHandle = desiredPropertyHandle;
+    update.value = *value;
+    update.onDesiredProperty = NULL;
+    if (VECTOR_push_back(ingestContext->updates, &update, 1) != 0)
+    {
+        LogError("failure in VECTOR_push_back");
+        Destroy_AGENT_DATA_TYPE(value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static int IngestDesiredPropertyFromString(DESIRED_PROPERTIES_INGEST_CONTEXT* ingestContext, DESIRED_PROPERTIES_FRAME* frame, SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle, const char* value)
+{
+    int result;
+    AGENT_DATA_TYPE output;
+    /*Codes_SRS_COMMAND_DECODER_02_029: [ The members of desired shall be matched against the model as in the MULTITREE case (desired properties, models in model and $version). ]*/
+    AGENT_DATA_TYPE_TYPE primitiveType = CodeFirst_GetPrimitiveType(Schema_GetModelDesiredPropertyType(desiredPropertyHandle));
+    if (primitiveType == EDM_NO_TYPE)
+    {
+        LogError("a struct desired property cannot be ingested from the scalar value %s", value);
+        result = __FAILURE__;
+    }
+    else if (CreateAgentDataType_From_String(value, primitiveType, &output) != AGENT_DATA_TYPES_OK)
+    {
+        LogError("failed parsing value %s", value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = StageDesiredProperty(ingestContext, frame->offset, desiredPropertyHandle, &output);
+    }
+    return result;
+}
+
+static int IngestDesiredPropertyFromStruct(DESIRED_PROPERTIES_INGEST_CONTEXT* ingestContext, DESIRED_PROPERTIES_FRAME* frame, SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle, MULTITREE_HANDLE structTree)
+{
+    int result;
+    AGENT_DATA_TYPE output;
+    /*Codes_SRS_COMMAND_DECODER_02_027: [ The members of a struct typed desired property shall be collected in a MULTITREE and converted to an AGENT_DATA_TYPE when the JSON object ends. ]*/
+    if (DecodeValueFromNode(Schema_GetSchemaForModelType(frame->modelHandle), &output, structTree, Schema_GetModelDesiredPropertyType(desiredPropertyHandle)) != 0)
+    {
+        LogError("failure in DecodeValueFromNode");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = StageDesiredProperty(ingestContext, frame->offset, desiredPropertyHandle, &output);
+    }
+    return result;
+}
+
+static JSON_DECODER_EVENT_RESULT DesiredProperties_OnBeginObject(void* context, const char* name)
+{
+    JSON_DECODER_EVENT_RESULT result;
+    DESIRED_PROPERTIES_INGEST_CONTEXT* ingestContext = (DESIRED_PROPERTIES_INGEST_CONTEXT*)context;
+    DESIRED_PROPERTIES_FRAME newFrame;
+    bool pushNewFrame = false;
+
+    newFrame.structNode = NULL;
+    newFrame.structDesiredProperty = NULL;
+
+    if (VECTOR_size(ingestContext->frames) == 0)
+    {
+        /*a member of the root of the full TWIN*/
         /*Codes_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, parse only the `desired` part of JSON tree ]*/
-        if (MultiTree_GetChildByName(initialParsedTree, "desired", &updateTree) != MULTITREE_OK)
+        if (strcmp(name, "desired") == 0)
         {
-            LogError("Unable to find 'desired' in tree");
-            return false;
+            ingestContext->desiredNodeFound = true;
+            newFrame.modelHandle = ingestContext->modelHandle;
+            newFrame.offset = 0;
+            pushNewFrame = true;
+            result = JSON_DECODER_EVENT_CONTINUE;
+        }
+        else
+        {
+            /*Codes_SRS_COMMAND_DECODER_02_026: [ Members of the JSON that are not ingested (including everything outside of desired) shall be skipped without being materialized. ]*/
+            result = JSON_DECODER_EVENT_SKIP_CHILDREN;
         }
     }
     else
     {
-        // Tree already starts on node we want so just use it.
-        updateTree = initialParsedTree;
+        DESIRED_PROPERTIES_FRAME* frame = (DESIRED_PROPERTIES_FRAME*)VECTOR_back(ingestContext->frames);
+        if (frame->modelHandle == NULL)
+        {
+            /*a member of a struct that is itself a struct*/
+            newFrame.modelHandle = NULL;
+            newFrame.offset = frame->offset;
+            if (MultiTree_AddChild(frame->structNode, name, &newFrame.structNode) != MULTITREE_OK)
+            {
+                LogError("failure in MultiTree_AddChild");
+                result = JSON_DECODER_EVENT_ABORT;
+            }
+            else
+            {
+                pushNewFrame = true;
+                result = JSON_DECODER_EVENT_CONTINUE;
+            }
+        }
+        else
+        {
+            SCHEMA_MODEL_ELEMENT elementType = Schema_GetModelElementByName(frame->modelHandle, name);
+            if (elementType.elementType == SCHEMA_MODEL_IN_MODEL)
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_029: [ The members of desired shall be matched against the model as in the MULTITREE case (desired properties, models in model and $version). ]*/
+                newFrame.modelHandle = elementType.elementHandle.modelHandle;
+                newFrame.offset = frame->offset + Schema_GetModelModelByName_Offset(frame->modelHandle, name);
+                pushNewFrame = true;
+                result = JSON_DECODER_EVENT_CONTINUE;
+            }
+            else if (
+                (elementType.elementType == SCHEMA_DESIRED_PROPERTY) &&
+                (CodeFirst_GetPrimitiveType(Schema_GetModelDesiredPropertyType(elementType.elementHandle.desiredPropertyHandle)) == EDM_NO_TYPE)
+                )
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_027: [ The members of a struct typed desired property shall be collected in a MULTITREE and converted to an AGENT_DATA_TYPE when the JSON object ends. ]*/
+                newFrame.modelHandle = NULL;
+                newFrame.offset = frame->offset;
+                newFrame.structNode = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+                newFrame.structDesiredProperty = elementType.elementHandle.desiredPropertyHandle;
+                if (newFrame.structNode == NULL)
+                {
+                    LogError("failure in MultiTree_Create");
+                    result = JSON_DECODER_EVENT_ABORT;
+                }
+                else
+                {
+                    pushNewFrame = true;
+                    result = JSON_DECODER_EVENT_CONTINUE;
+                }
+            }
+            else
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_026: [ Members of the JSON that are not ingested (including everything outside of desired) shall be skipped without being materialized. ]*/
+                LogError("cannot ingest %s as a WITH_DESIRED_PROPERTY object", name);
+                ingestContext->nFailed++;
+                result = JSON_DECODER_EVENT_SKIP_CHILDREN;
+            }
+        }
     }
 
-    /*Codes_COMMAND_DECODER_02_015: [ Remove '$version' string from node, if it is present.  It not being present is not an error ]*/
-    MULTITREE_RESULT deleteChildResult = MultiTree_DeleteChild(updateTree, "$version");
-    if ((deleteChildResult == MULTITREE_OK) || (deleteChildResult == MULTITREE_CHILD_NOT_FOUND))
+    if (pushNewFrame && (VECTOR_push_back(ingestContext->frames, &newFrame, 1) != 0))
     {
-        *desiredPropertiesTree = updateTree;
-        result = true;
+        LogError("failure in VECTOR_push_back");
+        if (newFrame.structDesiredProperty != NULL)
+        {
+            MultiTree_Destroy(newFrame.structNode);
+        }
+        result = JSON_DECODER_EVENT_ABORT;
+    }
+
+    return result;
+}
+
+static JSON_DECODER_EVENT_RESULT DesiredProperties_OnEndObject(void* context, const char* name)
+{
+    DESIRED_PROPERTIES_INGEST_CONTEXT* ingestContext = (DESIRED_PROPERTIES_INGEST_CONTEXT*)context;
+    DESIRED_PROPERTIES_FRAME* parent;
+    DESIRED_PROPERTIES_FRAME* top = (DESIRED_PROPERTIES_FRAME*)VECTOR_back(ingestContext->frames);
+    DESIRED_PROPERTIES_FRAME frame = *top;
+
+    VECTOR_erase(ingestContext->frames, top, 1);
+    parent = (VECTOR_size(ingestContext->frames) == 0) ? NULL : (DESIRED_PROPERTIES_FRAME*)VECTOR_back(ingestContext->frames);
+
+    if (frame.modelHandle != NULL)
+    {
+        if (parent != NULL)
+        {
+            /*if the model in model so happened to be a WITH_DESIRED_PROPERTY... (only those has non_NULL pfOnDesiredProperty) */
+            /*it is called after the desired properties of the model in model, like all of them once "desired" has been ingested*/
+            pfOnDesiredProperty onDesiredProperty = Schema_GetModelModelByName_OnDesiredProperty(parent->modelHandle, name);
+            if (onDesiredProperty != NULL)
+            {
+                DESIRED_PROPERTY_UPDATE update;
+                update.offset = parent->offset;
+                update.desiredPropertyHandle = NULL;
+                update.onDesiredProperty = onDesiredProperty;
+                if (VECTOR_push_back(ingestContext->updates, &update, 1) != 0)
+                {
+                    LogError("failure in VECTOR_push_back");
+                    ingestContext->nFailed++;
+                }
+            }
+        }
+        else
+        {
+            /*end of the "desired" node*/
+        }
+    }
+    else if (frame.structDesiredProperty != NULL)
+    {
+        /*all the members of the struct have been collected*/
+        if (IngestDesiredPropertyFromStruct(ingestContext, parent, frame.structDesiredProperty, frame.structNode) != 0)
+        {
+            ingestContext->nFailed++;
+        }
+        MultiTree_Destroy(frame.structNode);
     }
     else
     {
-        *desiredPropertiesTree = NULL;
-        result = false;
+        /*end of a struct nested in a struct, nothing to do until the outer struct ends*/
+    }
+
+    return JSON_DECODER_EVENT_CONTINUE;
+}
+
+static JSON_DECODER_EVENT_RESULT DesiredProperties_OnValue(void* context, const char* name, const char* value)
+{
+    JSON_DECODER_EVENT_RESULT result;
+    DESIRED_PROPERTIES_INGEST_CONTEXT* ingestContext = (DESIRED_PROPERTIES_INGEST_CONTEXT*)context;
+    size_t nFrames = VECTOR_size(ingestContext->frames);
+
+    if (nFrames == 0)
+    {
+        /*a scalar at the root of the full TWIN (such as $version), not part of the desired properties*/
+        result = JSON_DECODER_EVENT_CONTINUE;
+    }
+    else
+    {
+        DESIRED_PROPERTIES_FRAME* frame = (DESIRED_PROPERTIES_FRAME*)VECTOR_back(ingestContext->frames);
+        if (frame->modelHandle == NULL)
+        {
+            MULTITREE_HANDLE child;
+            if (
+                (MultiTree_AddChild(frame->structNode, name, &child) != MULTITREE_OK) ||
+                (MultiTree_SetValue(child, (void*)value) != MULTITREE_OK)
+                )
+            {
+                LogError("failure collecting struct member %s", name);
+                result = JSON_DECODER_EVENT_ABORT;
+            }
+            else
+            {
+                result = JSON_DECODER_EVENT_CONTINUE;
+            }
+        }
+        else if ((nFrames == 1) && (strcmp(name, "$version") == 0))
+        {
+            /*Codes_SRS_COMMAND_DECODER_02_015: [ Remove '$version' string from node, if it is present.  It not being present is not an error ]*/
+            result = JSON_DECODER_EVENT_CONTINUE;
+        }
+        else
+        {
+            SCHEMA_MODEL_ELEMENT elementType = Schema_GetModelElementByName(frame->modelHandle, name);
+            if (elementType.elementType != SCHEMA_DESIRED_PROPERTY)
+            {
+                LogError("cannot ingest name %s (not a WITH_DESIRED_PROPERTY)", name);
+                ingestContext->nFailed++;
+            }
+            else if (IngestDesiredPropertyFromString(ingestContext, frame, elementType.elementHandle.desiredPropertyHandle, value) != 0)
+            {
+                ingestContext->nFailed++;
+            }
+            else
+            {
+                /*all is fine*/
+            }
+            result = JSON_DECODER_EVENT_CONTINUE;
+        }
     }
 
     return result;
 }
 
+static const JSON_DECODER_EVENTS DesiredPropertiesEvents =
+{
+    DesiredProperties_OnBeginObject,
+    DesiredProperties_OnEndObject,
+    DesiredProperties_OnValue
+};
+
+static EXECUTE_COMMAND_RESULT IngestFullTwin(void* startAddress, COMMAND_DECODER_HANDLE_DATA* handle, char* json)
+{
+    EXECUTE_COMMAND_RESULT result;
+    DESIRED_PROPERTIES_INGEST_CONTEXT ingestContext;
+    ingestContext.startAddress = startAddress;
+    ingestContext.modelHandle = handle->ModelHandle;
+    ingestContext.desiredNodeFound = false;
+    ingestContext.nFailed = 0;
+
+    if ((ingestContext.frames = VECTOR_create(sizeof(DESIRED_PROPERTIES_FRAME))) == NULL)
+    {
+        LogError("failure in VECTOR_create");
+        result = EXECUTE_COMMAND_ERROR;
+    }
+    else
+    {
+        size_t i;
+        if ((ingestContext.updates = VECTOR_create(sizeof(DESIRED_PROPERTY_UPDATE))) == NULL)
+        {
+            LogError("failure in VECTOR_create");
+            result = EXECUTE_COMMAND_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_COMMAND_DECODER_02_028: [ If removedDesiredNode is TRUE, CommandDecoder_IngestDesiredProperties shall decode the clone of jsonPayload with JSONDecoder_JSON_To_Events instead of creating a MULTITREE. ]*/
+            if (JSONDecoder_JSON_To_Events(json, &DesiredPropertiesEvents, &ingestContext) != JSON_DECODER_OK)
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_031: [ If the JSON does not have a desired object, or if decoding it fails, then CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+                LogError("Decoding JSON failed");
+                result = EXECUTE_COMMAND_ERROR;
+            }
+            else if (!ingestContext.desiredNodeFound)
+            {
+                LogError("Unable to find 'desired' in JSON");
+                result = EXECUTE_COMMAND_ERROR;
+            }
+            else if (ingestContext.nFailed != 0)
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_011: [ Otherwise CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_FAILED. ]*/
+                LogError("not all constituents of the JSON have been ingested, none have been applied");
+                result = EXECUTE_COMMAND_FAILED;
+            }
+            else
+            {
+                /*Codes_SRS_COMMAND_DECODER_02_030: [ The desired properties shall be constructed in memory and the pfOnDesiredProperty callbacks shall be called only after the JSON has been decoded and only if all the members of desired could be ingested, so that a TWIN that fails does not change the device. ]*/
+                /*Codes_SRS_COMMAND_DECODER_02_010: [ If the complete MULTITREE has been parsed then CommandDecoder_IngestDesiredProperties shall succeed and return EXECUTE_COMMAND_SUCCESS. ]*/
+                result = EXECUTE_COMMAND_SUCCESS;
+                for (i = 0; i < VECTOR_size(ingestContext.updates); i++)
+                {
+                    DESIRED_PROPERTY_UPDATE* update = (DESIRED_PROPERTY_UPDATE*)VECTOR_element(ingestContext.updates, i);
+                    if (update->desiredPropertyHandle == NULL)
+                    {
+                        /*Codes_SRS_COMMAND_DECODER_02_012: [ If the child model in model has a non-NULL pfOnDesiredProperty then pfOnDesiredProperty shall be called. ]*/
+                        update->onDesiredProperty((char*)startAddress + update->offset);
+                    }
+                    else if (IngestDesiredProperty(startAddress, update->offset, update->desiredPropertyHandle, &update->value) != 0)
+                    {
+                        result = EXECUTE_COMMAND_FAILED;
+                    }
+                    else
+                    {
+                        /*all is fine*/
+                    }
+                }
+            }
+
+            for (i = 0; i < VECTOR_size(ingestContext.updates); i++)
+            {
+                DESIRED_PROPERTY_UPDATE* update = (DESIRED_PROPERTY_UPDATE*)VECTOR_element(ingestContext.updates, i);
+                if (update->desiredPropertyHandle != NULL)
+                {
+                    Destroy_AGENT_DATA_TYPE(&update->value);
+                }
+            }
+            VECTOR_destroy(ingestContext.updates);
+        }
+
+        /*a decoding failure can leave partially collected structs behind*/
+        for (i = 0; i < VECTOR_size(ingestContext.frames); i++)
+        {
+            DESIRED_PROPERTIES_FRAME* frame = (DESIRED_PROPERTIES_FRAME*)VECTOR_element(ingestContext.frames, i);
+            if (frame->structDesiredProperty != NULL)
+            {
+                MultiTree_Destroy(frame->structNode);
+            }
+        }
+        VECTOR_destroy(ingestContext.frames);
+    }
+    return result;
+}
+
 EXECUTE_COMMAND_RESULT CommandDecoder_IngestDesiredProperties(void* startAddress, COMMAND_DECODER_HANDLE handle, const char* jsonPayload, bool parseDesiredNode)
 {
     EXECUTE_COMMAND_RESULT result;
@@ -1004,31 +1428,39 @@ EXECUTE_COMMAND_RESULT CommandDecoder_IngestDesiredProperties(void* startAddress
         }
         else
         {
-            /*Codes_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall create a MULTITREE_HANDLE ouf of the clone of desiredProperties. ]*/
-            MULTITREE_HANDLE initialParsedTree;
-            MULTITREE_HANDLE desiredPropertiesTree;
+            COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance = (COMMAND_DECODER_HANDLE_DATA*)handle;
 
-            if (JSONDecoder_JSON_To_MultiTree(copy, &initialParsedTree) != JSON_DECODER_OK)
+            if (parseDesiredNode)
             {
-                LogError("Decoding JSON to a multi tree failed");
-                result = EXECUTE_COMMAND_ERROR;
+                /*Codes_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, parse only the `desired` part of JSON tree ]*/
+                result = IngestFullTwin(startAddress, commandDecoderInstance, copy);
             }
             else
             {
-                if (RemoveUnneededTwinProperties(initialParsedTree, parseDesiredNode, &desiredPropertiesTree) == false)
+                /*Codes_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall create a MULTITREE_HANDLE ouf of the clone of desiredProperties. ]*/
+                MULTITREE_HANDLE initialParsedTree;
+                MULTITREE_HANDLE desiredPropertiesTree;
+
+                if (JSONDecoder_JSON_To_MultiTree(copy, &initialParsedTree) != JSON_DECODER_OK)
                 {
-                    LogError("Removing unneeded twin properties failed");
+                    LogError("Decoding JSON to a multi tree failed");
                     result = EXECUTE_COMMAND_ERROR;
                 }
                 else
                 {
-                    COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance = (COMMAND_DECODER_HANDLE_DATA*)handle;
-
-                    /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall parse the MULTITREEE recursively. ]*/
-                    result = DecodeDesiredProperties(startAddress, commandDecoderInstance, desiredPropertiesTree);
+                    if (RemoveUnneededTwinProperties(initialParsedTree, &desiredPropertiesTree) == false)
+                    {
+                        LogError("Removing unneeded twin properties failed");
+                        result = EXECUTE_COMMAND_ERROR;
+                    }
+                    else
+                    {
+                        /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall parse the MULTITREEE recursively. ]*/
+                        result = DecodeDesiredProperties(startAddress, commandDecoderInstance, desiredPropertiesTree);
 
-                    // Do NOT free desiredPropertiesTree.  It is only a pointer into initialParsedTree.
-                    MultiTree_Destroy(initialParsedTree);
+                        // Do NOT free desiredPropertiesTree.  It is only a pointer into initialParsedTree.
+                        MultiTree_Destroy(initialParsedTree);
+                    }
                 }
             }
             free(copy);
@@ -9,6 +9,7 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "schema.h"
 #include "jsonencoder.h"
+#include "cborencoder.h"
 #include "agenttypesystem.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "parson.h"
@@ -23,8 +24,91 @@ typedef struct DATA_MARSHALLER_HANDLE_DATA_TAG
 {
     SCHEMA_MODEL_TYPE_HANDLE ModelHandle;
     bool IncludePropertyPath;
+    const DATA_MARSHALLER_ENCODER* Encoder;
+    const DATA_MARSHALLER_KEY_DICTIONARY* KeyDictionary;
 } DATA_MARSHALLER_HANDLE_DATA;
 
+static DATA_MARSHALLER_RESULT EncodeTreeAsJSON(MULTITREE_HANDLE treeHandle, const DATA_MARSHALLER_KEY_DICTIONARY* keyDictionary, unsigned char** destination, size_t* destinationSize)
+{
+    DATA_MARSHALLER_RESULT result;
+    STRING_HANDLE payload = STRING_new();
+    (void)keyDictionary; /*names are always written in full in JSON*/
+    if (payload == NULL)
+    {
+        result = DATA_MARSHALLER_ERROR;
+        LOG_DATA_MARSHALLER_ERROR
+    }
+    else
+    {
+        if (JSONEncoder_EncodeTree(treeHandle, payload, (JSON_ENCODER_TOSTRING_FUNC)AgentDataTypes_ToString) != JSON_ENCODER_OK)
+        {
+            /* Codes_SRS_DATA_MARSHALLER_99_027:[ DATA_MARSHALLER_JSON_ENCODER_ERROR shall be returned when JSONEncoder returns an error code.] */
+            result = DATA_MARSHALLER_JSON_ENCODER_ERROR;
+            LOG_DATA_MARSHALLER_ERROR
+        }
+        else
+        {
+            /*Codes_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
+            size_t resultSize = STRING_length(payload);
+            unsigned char* temp = malloc(resultSize);
+            if (temp == NULL)
+            {
+                /*Codes_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
+                result = DATA_MARSHALLER_ERROR;
+                LOG_DATA_MARSHALLER_ERROR;
+            }
+            else
+            {
+                (void)memcpy(temp, STRING_c_str(payload), resultSize);
+                *destination = temp;
+                *destinationSize = resultSize;
+                result = DATA_MARSHALLER_OK;
+            }
+        }
+        STRING_delete(payload);
+    }
+    return result;
+}
+
+static DATA_MARSHALLER_RESULT EncodeTreeAsCBOR(MULTITREE_HANDLE treeHandle, const DATA_MARSHALLER_KEY_DICTIONARY* keyDictionary, unsigned char** destination, size_t* destinationSize)
+{
+    DATA_MARSHALLER_RESULT result;
+    /*Codes_SRS_DATA_MARSHALLER_02_029: [ The CBOR encoder shall call CBOREncoder_EncodeTree passing the keys of the key dictionary in effect (if any). ]*/
+    if (CBOREncoder_EncodeTree(treeHandle,
+        (keyDictionary == NULL) ? NULL : keyDictionary->keys,
+        (keyDictionary == NULL) ? 0 : keyDictionary->keyCount,
+        destination, destinationSize) != CBOR_ENCODER_OK)
+    {
+        /*Codes_SRS_DATA_MARSHALLER_02_030: [ If CBOREncoder_EncodeTree fails then DataMarshaller_SendData shall fail and return DATA_MARSHALLER_CBOR_ENCODER_ERROR. ]*/
+        result = DATA_MARSHALLER_CBOR_ENCODER_ERROR;
+        LOG_DATA_MARSHALLER_ERROR
+    }
+    else
+    {
+        result = DATA_MARSHALLER_OK;
+    }
+    return result;
+}
+
+/*Codes_SRS_DATA_MARSHALLER_02_022: [ DataMarshaller_GetJSONEncoder shall return an encoder having the content type "application/json", the content encoding "utf-8" and encoding the tree with JSONEncoder_EncodeTree. ]*/
+static const DATA_MARSHALLER_ENCODER g_jsonEncoder =
+{
+    "application/json",
+    "utf-8",
+    EncodeTreeAsJSON
+};
+
+/*Codes_SRS_DATA_MARSHALLER_02_023: [ DataMarshaller_GetCBOREncoder shall return an encoder having the content type "application/cbor", no content encoding and encoding the tree with CBOREncoder_EncodeTree. ]*/
+static const DATA_MARSHALLER_ENCODER g_cborEncoder =
+{
+    CBOR_ENCODER_CONTENT_TYPE,
+    NULL,
+    EncodeTreeAsCBOR
+};
+
+static const DATA_MARSHALLER_ENCODER* g_defaultEncoder = &g_jsonEncoder;
+static const DATA_MARSHALLER_KEY_DICTIONARY* g_defaultKeyDictionary = NULL;
+
 static int NoCloneFunction(void** destination, const void* source)
 {
     *destination = (void*)source;
@@ -58,6 +142,9 @@ DATA_MARSHALLER_HANDLE DataMarshaller_Create(SCHEMA_MODEL_TYPE_HANDLE modelHandl
         /*Codes_SRS_DATA_MARSHALLER_99_018:[ DataMarshaller_Create shall create a new DataMarshaller instance and on success it shall return a non NULL handle.]*/
         result->ModelHandle = modelHandle;
         result->IncludePropertyPath = includePropertyPath;
+        /*Codes_SRS_DATA_MARSHALLER_02_026: [ DataMarshaller_Create shall use the default encoder and the default key dictionary in effect at the time of the call. ]*/
+        result->Encoder = g_defaultEncoder;
+        result->KeyDictionary = g_defaultKeyDictionary;
     }
     return result;
 }
@@ -172,41 +259,8 @@ DATA_MARSHALLER_RESULT DataMarshaller_SendData(DATA_MARSHALLER_HANDLE dataMarsha
 
                 if (j == valueCount)
                 {
-                    STRING_HANDLE payload = STRING_new();
-                    if (payload == NULL)
-                    {
-                        result = DATA_MARSHALLER_ERROR;
-                        LOG_DATA_MARSHALLER_ERROR
-                    }
-                    else
-                    {
-                        if (JSONEncoder_EncodeTree(treeHandle, payload, (JSON_ENCODER_TOSTRING_FUNC)AgentDataTypes_ToString) != JSON_ENCODER_OK)
-                        {
-                            /* Codes_SRS_DATA_MARSHALLER_99_027:[ DATA_MARSHALLER_JSON_ENCODER_ERROR shall be returned when JSONEncoder returns an error code.] */
-                            result = DATA_MARSHALLER_JSON_ENCODER_ERROR;
-                            LOG_DATA_MARSHALLER_ERROR
-                        }
-                        else
-                        {
-                            /*Codes_SRS_DATAMARSHALLER_02_007: [DataMarshaller_SendData shall copy in the output parameters *destination, *destinationSize the content and the content length of the encoded JSON tree.] */
-                            size_t resultSize = STRING_length(payload);
-                            unsigned char* temp = malloc(resultSize);
-                            if (temp == NULL)
-                            {
-                                /*Codes_SRS_DATA_MARSHALLER_99_015:[ DATA_MARSHALLER_ERROR shall be returned in all the other error cases not explicitly defined here.]*/
-                                result = DATA_MARSHALLER_ERROR;
-                                LOG_DATA_MARSHALLER_ERROR;
-                            }
-                            else
-                            {
-                                (void)memcpy(temp, STRING_c_str(payload), resultSize);
-                                *destination = temp;
-                                *destinationSize = resultSize;
-                                result = DATA_MARSHALLER_OK;
-                            }
-                        }
-                        STRING_delete(payload);
-                    }
+                    /*Codes_SRS_DATA_MARSHALLER_02_027: [ DataMarshaller_SendData shall produce destination and destinationSize by calling the encodeTree function of the encoder of the instance. ]*/
+                    result = dataMarshallerInstance->Encoder->encodeTree(treeHandle, dataMarshallerInstance->KeyDictionary, destination, destinationSize);
                 } /* if (j==valueCount)*/
                 MultiTree_Destroy(treeHandle);
             } /* MultiTree_Create */
@@ -363,4 +417,43 @@ DATA_MARSHALLER_RESULT DataMarshaller_SendData_ReportedProperties(DATA_MARSHALLE
     }
     return result;
 }
- 
\ No newline at end of file
+ 
+
+const DATA_MARSHALLER_ENCODER* DataMarshaller_GetJSONEncoder(void)
+{
+    return &g_jsonEncoder;
+}
+
+const DATA_MARSHALLER_ENCODER* DataMarshaller_GetCBOREncoder(void)
+{
+    return &g_cborEncoder;
+}
+
+void DataMarshaller_SetDefaultEncoder(const DATA_MARSHALLER_ENCODER* encoder)
+{
+    /*Codes_SRS_DATA_MARSHALLER_02_024: [ DataMarshaller_SetDefaultEncoder shall set the encoder used by any new instance of DataMarshaller. If encoder is NULL or has a NULL encodeTree then the JSON encoder shall be used. ]*/
+    g_defaultEncoder = ((encoder == NULL) || (encoder->encodeTree == NULL)) ? &g_jsonEncoder : encoder;
+}
+
+void DataMarshaller_SetDefaultKeyDictionary(const DATA_MARSHALLER_KEY_DICTIONARY* keyDictionary)
+{
+    /*Codes_SRS_DATA_MARSHALLER_02_025: [ DataMarshaller_SetDefaultKeyDictionary shall set the key dictionary used by any new instance of DataMarshaller. A NULL keyDictionary or one without keys disables the dictionary. ]*/
+    g_defaultKeyDictionary = ((keyDictionary == NULL) || (keyDictionary->keys == NULL) || (keyDictionary->keyCount == 0)) ? NULL : keyDictionary;
+}
+
+const DATA_MARSHALLER_ENCODER* DataMarshaller_GetEncoder(DATA_MARSHALLER_HANDLE dataMarshallerHandle)
+{
+    const DATA_MARSHALLER_ENCODER* result;
+    if (dataMarshallerHandle == NULL)
+    {
+        /*Codes_SRS_DATA_MARSHALLER_02_028: [ If dataMarshallerHandle is NULL then DataMarshaller_GetEncoder shall return NULL. ]*/
+        LogError("invalid argument DATA_MARSHALLER_HANDLE dataMarshallerHandle=%p", dataMarshallerHandle);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_DATA_MARSHALLER_02_031: [ Otherwise DataMarshaller_GetEncoder shall return the encoder used by the instance. ]*/
+        result = ((DATA_MARSHALLER_HANDLE_DATA*)dataMarshallerHandle)->Encoder;
+    }
+    return result;
+}
@@ -0,0 +1,28 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fnv1a.h"
+
+#define FNV1A_64_OFFSET_BASIS 14695981039346656037ULL
+#define FNV1A_64_PRIME 1099511628211ULL
+
+uint64_t FNV1a_Hash(const char* data, size_t size)
+{
+    /*Codes_SRS_FNV1A_02_001: [ FNV1a_Hash shall return the 64 bit FNV-1a hash of the first size bytes of data. ]*/
+    uint64_t result = FNV1A_64_OFFSET_BASIS;
+
+    /*Codes_SRS_FNV1A_02_002: [ If data is NULL then FNV1a_Hash shall return the hash of zero bytes. ]*/
+    if (data != NULL)
+    {
+        size_t i;
+        for (i = 0; i < size; i++)
+        {
+            result ^= (unsigned char)data[i];
+            result *= FNV1A_64_PRIME;
+        }
+    }
+
+    return result;
+}
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #define IsWhiteSpace(A) (((A) == 0x20) || ((A) == 0x09) || ((A) == 0x0A) || ((A) == 0x0D))
 
@@ -609,3 +610,286 @@ JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char* json, MULTITREE_HANDLE*
 
     return result;
 }
+
+typedef struct EVENT_PARSER_STATE_TAG
+{
+    PARSER_STATE parserState;
+    const JSON_DECODER_EVENTS* events;
+    void* context;
+} EVENT_PARSER_STATE;
+
+static JSON_DECODER_RESULT EventParseObject(EVENT_PARSER_STATE* eventParserState, bool emitEvents);
+static JSON_DECODER_RESULT EventParseArray(EVENT_PARSER_STATE* eventParserState, bool emitEvents);
+
+/*parses the value of a member (or of an array element) called "name" and reports it. nextChar receives the first non-whitespace character after the value*/
+static JSON_DECODER_RESULT EventParseMemberValue(EVENT_PARSER_STATE* eventParserState, const char* name, bool emitEvents, char* nextChar)
+{
+    JSON_DECODER_RESULT result;
+    PARSER_STATE* parserState = &eventParserState->parserState;
+
+    SkipWhiteSpaces(parserState);
+
+    if ((*(parserState->json) == '{') || (*(parserState->json) == '['))
+    {
+        bool emitChildren = emitEvents;
+        result = JSON_DECODER_OK;
+
+        if (emitEvents)
+        {
+            /*Codes_SRS_JSON_DECODER_02_005: [ When an object or an array starts, JSONDecoder_JSON_To_Events shall call onBeginObject passing the member name (or the array index as string). ]*/
+            JSON_DECODER_EVENT_RESULT eventResult = eventParserState->events->onBeginObject(eventParserState->context, name);
+            if (eventResult == JSON_DECODER_EVENT_SKIP_CHILDREN)
+            {
+                /*Codes_SRS_JSON_DECODER_02_006: [ If onBeginObject returns JSON_DECODER_EVENT_SKIP_CHILDREN then JSONDecoder_JSON_To_Events shall validate the children without reporting them and without reporting the matching onEndObject. ]*/
+                emitChildren = false;
+            }
+            else if (eventResult != JSON_DECODER_EVENT_CONTINUE)
+            {
+                /*Codes_SRS_JSON_DECODER_02_009: [ If any callback returns JSON_DECODER_EVENT_ABORT then JSONDecoder_JSON_To_Events shall stop and return JSON_DECODER_ABORTED. ]*/
+                result = JSON_DECODER_ABORTED;
+            }
+        }
+
+        if (result == JSON_DECODER_OK)
+        {
+            result = (*(parserState->json) == '{') ? EventParseObject(eventParserState, emitChildren) : EventParseArray(eventParserState, emitChildren);
+            if ((result == JSON_DECODER_OK) && emitChildren)
+            {
+                /*Codes_SRS_JSON_DECODER_02_007: [ When an object or an array ends, JSONDecoder_JSON_To_Events shall call onEndObject passing the same name as onBeginObject. ]*/
+                if (eventParserState->events->onEndObject(eventParserState->context, name) != JSON_DECODER_EVENT_CONTINUE)
+                {
+                    /*Codes_SRS_JSON_DECODER_02_009: [ If any callback returns JSON_DECODER_EVENT_ABORT then JSONDecoder_JSON_To_Events shall stop and return JSON_DECODER_ABORTED. ]*/
+                    result = JSON_DECODER_ABORTED;
+                }
+            }
+        }
+
+        if (result == JSON_DECODER_OK)
+        {
+            SkipWhiteSpaces(parserState);
+            *nextChar = *(parserState->json);
+        }
+    }
+    else
+    {
+        char* valueBegin;
+        char* valueEnd;
+
+        /*objects and arrays have been handled above, so ParseValue only sees scalars here*/
+        result = ParseValue(parserState, NULL, &valueBegin);
+        if (result == JSON_DECODER_OK)
+        {
+            valueEnd = parserState->json;
+            SkipWhiteSpaces(parserState);
+            *nextChar = *(parserState->json);
+            *valueEnd = 0;
+
+            /*Codes_SRS_JSON_DECODER_02_008: [ For every scalar value JSONDecoder_JSON_To_Events shall call onValue passing the member name and the value as it appears in the JSON. ]*/
+            if (emitEvents &&
+                (eventParserState->events->onValue(eventParserState->context, name, valueBegin) != JSON_DECODER_EVENT_CONTINUE))
+            {
+                /*Codes_SRS_JSON_DECODER_02_009: [ If any callback returns JSON_DECODER_EVENT_ABORT then JSONDecoder_JSON_To_Events shall stop and return JSON_DECODER_ABORTED. ]*/
+                result = JSON_DECODER_ABORTED;
+            }
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT EventParseObject(EVENT_PARSER_STATE* eventParserState, bool emitEvents)
+{
+    PARSER_STATE* parserState = &eventParserState->parserState;
+    JSON_DECODER_RESULT result = ParseOpenCurly(parserState);
+    if (result == JSON_DECODER_OK)
+    {
+        char jsonChar;
+
+        SkipWhiteSpaces(parserState);
+
+        jsonChar = *(parserState->json);
+        while ((jsonChar != '}') && (jsonChar != '\0'))
+        {
+            char* memberNameBegin;
+
+            SkipWhiteSpaces(parserState);
+
+            /* Codes_SRS_JSON_DECODER_99_022:[ A name is a string.] */
+            result = ParseString(parserState, &memberNameBegin);
+            if (result != JSON_DECODER_OK)
+            {
+                break;
+            }
+            *(parserState->json - 1) = 0;
+
+            result = ParseColon(parserState);
+            if (result != JSON_DECODER_OK)
+            {
+                break;
+            }
+
+            result = EventParseMemberValue(eventParserState, memberNameBegin + 1, emitEvents, &jsonChar);
+            if (result != JSON_DECODER_OK)
+            {
+                break;
+            }
+
+            /* Codes_SRS_JSON_DECODER_99_024:[ A single comma separates a value from a following name.] */
+            if (jsonChar == ',')
+            {
+                parserState->json++;
+            }
+        }
+
+        if (result != JSON_DECODER_OK)
+        {
+            /* already have error */
+        }
+        else
+        {
+            if (jsonChar != '}')
+            {
+                /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+            else
+            {
+                parserState->json++;
+            }
+        }
+    }
+
+    return result;
+}
+
+static JSON_DECODER_RESULT EventParseArray(EVENT_PARSER_STATE* eventParserState, bool emitEvents)
+{
+    JSON_DECODER_RESULT result;
+    PARSER_STATE* parserState = &eventParserState->parserState;
+
+    SkipWhiteSpaces(parserState);
+
+    /* Codes_SRS_JSON_DECODER_99_026:[ An array structure is represented as square brackets surrounding zero or more values (or elements).] */
+    if (*(parserState->json) != '[')
+    {
+        /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+        result = JSON_DECODER_PARSE_ERROR;
+    }
+    else
+    {
+        char jsonChar;
+        int arrayIndex = 0;
+        result = JSON_DECODER_OK;
+
+        parserState->json++;
+
+        SkipWhiteSpaces(parserState);
+
+        jsonChar = *parserState->json;
+        while ((jsonChar != ']') && (jsonChar != '\0'))
+        {
+            char arrayIndexStr[22];
+
+            /* Codes_SRS_JSON_DECODER_02_010: [ For array elements the name reported to the callbacks shall be the string representation of the array index. ]*/
+            if (sprintf(arrayIndexStr, "%d", arrayIndex++) < 0)
+            {
+                result = JSON_DECODER_ERROR;
+                break;
+            }
+
+            result = EventParseMemberValue(eventParserState, arrayIndexStr, emitEvents, &jsonChar);
+            if (result != JSON_DECODER_OK)
+            {
+                break;
+            }
+
+            /* Codes_SRS_JSON_DECODER_99_027:[ Elements are separated by commas.] */
+            if (jsonChar == ',')
+            {
+                parserState->json++;
+            }
+            else if (jsonChar != ']')
+            {
+                /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+                result = JSON_DECODER_PARSE_ERROR;
+                break;
+            }
+        }
+
+        if (result != JSON_DECODER_OK)
+        {
+            /* already have error */
+        }
+        else
+        {
+            if (jsonChar != ']')
+            {
+                /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+            else
+            {
+                parserState->json++;
+            }
+        }
+    }
+
+    return result;
+}
+
+JSON_DECODER_RESULT JSONDecoder_JSON_To_Events(char* json, const JSON_DECODER_EVENTS* events, void* context)
+{
+    JSON_DECODER_RESULT result;
+
+    if ((json == NULL) ||
+        (events == NULL) ||
+        (events->onBeginObject == NULL) ||
+        (events->onEndObject == NULL) ||
+        (events->onValue == NULL))
+    {
+        /*Codes_SRS_JSON_DECODER_02_001: [ If json, events or any of the callbacks in events is NULL then JSONDecoder_JSON_To_Events shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+        result = JSON_DECODER_INVALID_ARG;
+    }
+    else
+    {
+        EVENT_PARSER_STATE eventParserState;
+        eventParserState.parserState.json = json;
+        eventParserState.events = events;
+        eventParserState.context = context;
+
+        SkipWhiteSpaces(&eventParserState.parserState);
+
+        /*Codes_SRS_JSON_DECODER_02_002: [ JSONDecoder_JSON_To_Events shall parse json in a single pass, in place, without building a MULTITREE. ]*/
+        /*Codes_SRS_JSON_DECODER_02_003: [ The members of the top level object (or array) shall be reported without a surrounding onBeginObject/onEndObject pair. ]*/
+        if (*json == '\0')
+        {
+            /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+        else if (*(eventParserState.parserState.json) == '{')
+        {
+            result = EventParseObject(&eventParserState, true);
+        }
+        else if (*(eventParserState.parserState.json) == '[')
+        {
+            result = EventParseArray(&eventParserState, true);
+        }
+        else
+        {
+            /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+            result = JSON_DECODER_PARSE_ERROR;
+        }
+
+        if (result == JSON_DECODER_OK)
+        {
+            SkipWhiteSpaces(&eventParserState.parserState);
+            if (*(eventParserState.parserState.json) != '\0')
+            {
+                /* Codes_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+                result = JSON_DECODER_PARSE_ERROR;
+            }
+        }
+    }
+
+    return result;
+}
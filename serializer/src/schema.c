@@ -2,9 +2,11 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 
 #include "schema.h"
+#include "fnv1a.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/vector.h"
@@ -12,6 +14,24 @@
 
 DEFINE_ENUM_STRINGS(SCHEMA_RESULT, SCHEMA_RESULT_VALUES);
 
+/*a SCHEMA_NAME_INDEX maps names to positions in the collection that owns the named elements (array or VECTOR).
+The names are not copied, they belong to the indexed elements. Positions are given in insertion order, so they always match the position of the element in its collection.*/
+typedef struct SCHEMA_NAME_INDEX_ENTRY_TAG
+{
+    size_t hash;
+    const char* name; /*NULL for a free slot*/
+    size_t position;
+} SCHEMA_NAME_INDEX_ENTRY;
+
+typedef struct SCHEMA_NAME_INDEX_TAG
+{
+    SCHEMA_NAME_INDEX_ENTRY* entries; /*open addressing, linear probing*/
+    size_t capacity; /*0 or a power of 2*/
+    size_t count;
+} SCHEMA_NAME_INDEX;
+
+#define SCHEMA_NAME_INDEX_INITIAL_CAPACITY 8
+
 typedef struct SCHEMA_PROPERTY_HANDLE_DATA_TAG
 {
     const char* PropertyName;
@@ -81,6 +101,12 @@ typedef struct SCHEMA_MODEL_TYPE_HANDLE_DATA_TAG
     size_t ActionCount;
     VECTOR_HANDLE models;
     size_t DeviceCount;
+    SCHEMA_NAME_INDEX propertiesIndex; /*indexes Properties*/
+    SCHEMA_NAME_INDEX reportedPropertiesIndex; /*indexes reportedProperties*/
+    SCHEMA_NAME_INDEX desiredPropertiesIndex; /*indexes desiredProperties*/
+    SCHEMA_NAME_INDEX actionsIndex; /*indexes Actions*/
+    SCHEMA_NAME_INDEX methodsIndex; /*indexes methods*/
+    SCHEMA_NAME_INDEX modelsIndex; /*indexes models*/
 } SCHEMA_MODEL_TYPE_HANDLE_DATA;
 
 typedef struct SCHEMA_STRUCT_TYPE_HANDLE_DATA_TAG
@@ -88,6 +114,7 @@ typedef struct SCHEMA_STRUCT_TYPE_HANDLE_DATA_TAG
     const char* Name;
     SCHEMA_PROPERTY_HANDLE* Properties;
     size_t PropertyCount;
+    SCHEMA_NAME_INDEX propertiesIndex; /*indexes Properties*/
 } SCHEMA_STRUCT_TYPE_HANDLE_DATA;
 
 typedef struct SCHEMA_HANDLE_DATA_TAG
@@ -98,10 +125,131 @@ typedef struct SCHEMA_HANDLE_DATA_TAG
     size_t ModelTypeCount;
     SCHEMA_STRUCT_TYPE_HANDLE* StructTypes;
     size_t StructTypeCount;
+    SCHEMA_NAME_INDEX modelTypesIndex; /*indexes ModelTypes*/
+    SCHEMA_NAME_INDEX structTypesIndex; /*indexes StructTypes*/
 } SCHEMA_HANDLE_DATA;
 
 static VECTOR_HANDLE g_schemas = NULL;
 
+#ifdef SCHEMA_COUNT_NAME_COMPARISONS
+/*counts the name comparisons done by the name indexes; only built for the unit tests*/
+size_t schema_name_comparison_count = 0;
+#define COUNT_NAME_COMPARISON() (schema_name_comparison_count++)
+#else
+#define COUNT_NAME_COMPARISON()
+#endif
+
+static void NameIndex_Init(SCHEMA_NAME_INDEX* index)
+{
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+static void NameIndex_Deinit(SCHEMA_NAME_INDEX* index)
+{
+    free(index->entries);
+    NameIndex_Init(index);
+}
+
+static void NameIndex_Place(SCHEMA_NAME_INDEX_ENTRY* entries, size_t capacity, size_t hash, const char* name, size_t position)
+{
+    size_t slot = hash & (capacity - 1);
+    while (entries[slot].name != NULL)
+    {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    entries[slot].hash = hash;
+    entries[slot].name = name;
+    entries[slot].position = position;
+}
+
+/*makes room for one more name, so that the NameIndex_Add that follows cannot fail*/
+static int NameIndex_Reserve(SCHEMA_NAME_INDEX* index)
+{
+    int result;
+    /*the load factor is kept at 1/2 or less*/
+    if ((index->count + 1) * 2 <= index->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newCapacity = (index->capacity == 0) ? SCHEMA_NAME_INDEX_INITIAL_CAPACITY : (index->capacity * 2);
+        SCHEMA_NAME_INDEX_ENTRY* newEntries = (SCHEMA_NAME_INDEX_ENTRY*)malloc(sizeof(SCHEMA_NAME_INDEX_ENTRY) * newCapacity);
+        if (newEntries == NULL)
+        {
+            LogError("unable to malloc");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < newCapacity; i++)
+            {
+                newEntries[i].name = NULL;
+            }
+
+            for (i = 0; i < index->capacity; i++)
+            {
+                if (index->entries[i].name != NULL)
+                {
+                    NameIndex_Place(newEntries, newCapacity, index->entries[i].hash, index->entries[i].name, index->entries[i].position);
+                }
+            }
+
+            free(index->entries);
+            index->entries = newEntries;
+            index->capacity = newCapacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*undoes a NameIndex_Reserve that was not followed by a NameIndex_Add, an index that has no names does not keep its table*/
+static void NameIndex_Unreserve(SCHEMA_NAME_INDEX* index)
+{
+    if (index->count == 0)
+    {
+        NameIndex_Deinit(index);
+    }
+}
+
+/*name shall be owned by the element just appended to the indexed collection, NameIndex_Reserve shall have been called before*/
+static void NameIndex_Add(SCHEMA_NAME_INDEX* index, const char* name)
+{
+    NameIndex_Place(index->entries, index->capacity, (size_t)FNV1a_Hash(name, strlen(name)), name, index->count);
+    index->count++;
+}
+
+/*name does not need to be '\0' terminated (path segments are not), only the first nameLength characters are looked at*/
+static bool NameIndex_Find(const SCHEMA_NAME_INDEX* index, const char* name, size_t nameLength, size_t* position)
+{
+    bool result = false;
+    if (index->count > 0)
+    {
+        size_t hash = (size_t)FNV1a_Hash(name, nameLength);
+        size_t slot = hash & (index->capacity - 1);
+        while (index->entries[slot].name != NULL)
+        {
+            if (index->entries[slot].hash == hash)
+            {
+                COUNT_NAME_COMPARISON();
+                if ((strncmp(index->entries[slot].name, name, nameLength) == 0) &&
+                    (index->entries[slot].name[nameLength] == '\0'))
+                {
+                    *position = index->entries[slot].position;
+                    result = true;
+                    break;
+                }
+            }
+            slot = (slot + 1) & (index->capacity - 1);
+        }
+    }
+    return result;
+}
+
 static void DestroyProperty(SCHEMA_PROPERTY_HANDLE propertyHandle)
 {
     SCHEMA_PROPERTY_HANDLE_DATA* propertyType = (SCHEMA_PROPERTY_HANDLE_DATA*)propertyHandle;
@@ -184,6 +332,7 @@ static void DestroyStruct(SCHEMA_STRUCT_TYPE_HANDLE structTypeHandle)
             DestroyProperty(structType->Properties[i]);
         }
         free(structType->Properties);
+        NameIndex_Deinit(&structType->propertiesIndex);
 
         free((void*)structType->Name);
 
@@ -244,6 +393,13 @@ static void DestroyModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle)
     VECTOR_destroy(modelType->models);
 
     free(modelType->Actions);
+
+    NameIndex_Deinit(&modelType->propertiesIndex);
+    NameIndex_Deinit(&modelType->reportedPropertiesIndex);
+    NameIndex_Deinit(&modelType->desiredPropertiesIndex);
+    NameIndex_Deinit(&modelType->actionsIndex);
+    NameIndex_Deinit(&modelType->methodsIndex);
+    NameIndex_Deinit(&modelType->modelsIndex);
     free(modelType);
 }
 
@@ -264,18 +420,15 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
         size_t i;
 
         /* Codes_SRS_SCHEMA_99_015:[The property name shall be unique per model, if the same property name is added twice to a model, SCHEMA_DUPLICATE_ELEMENT shall be returned.] */
-        for (i = 0; i < modelType->PropertyCount; i++)
+        if (NameIndex_Find(&modelType->propertiesIndex, name, strlen(name), &i))
         {
-            SCHEMA_PROPERTY_HANDLE_DATA* property = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-            if (strcmp(property->PropertyName, name) == 0)
-            {
-                break;
-            }
+            result = SCHEMA_DUPLICATE_ELEMENT;
+            LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
-
-        if (i < modelType->PropertyCount)
+        else if (NameIndex_Reserve(&modelType->propertiesIndex) != 0)
         {
-            result = SCHEMA_DUPLICATE_ELEMENT;
+            /* Codes_SRS_SCHEMA_99_014:[On any other error, Schema_AddModelProperty shall return SCHEMA_ERROR.] */
+            result = SCHEMA_ERROR;
             LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
         else
@@ -284,6 +437,7 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
             if (newProperties == NULL)
             {
                 /* Codes_SRS_SCHEMA_99_014:[On any other error, Schema_AddModelProperty shall return SCHEMA_ERROR.] */
+                NameIndex_Unreserve(&modelType->propertiesIndex);
                 result = SCHEMA_ERROR;
                 LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
             }
@@ -319,6 +473,7 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
                     {
                         modelType->Properties[modelType->PropertyCount] = (SCHEMA_PROPERTY_HANDLE)newProperty;
                         modelType->PropertyCount++;
+                        NameIndex_Add(&modelType->propertiesIndex, newProperty->PropertyName);
 
                         /* Codes_SRS_SCHEMA_99_012:[On success, Schema_AddModelProperty shall return SCHEMA_OK.] */
                         result = SCHEMA_OK;
@@ -328,7 +483,9 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
                 /* If possible, reduce the memory of over allocation */
                 if (result != SCHEMA_OK)
                 {
-                    SCHEMA_PROPERTY_HANDLE* oldProperties = (SCHEMA_PROPERTY_HANDLE*)realloc(modelType->Properties, sizeof(SCHEMA_PROPERTY_HANDLE) * modelType->PropertyCount);
+                    SCHEMA_PROPERTY_HANDLE* oldProperties;
+                    NameIndex_Unreserve(&modelType->propertiesIndex);
+                    oldProperties = (SCHEMA_PROPERTY_HANDLE*)realloc(modelType->Properties, sizeof(SCHEMA_PROPERTY_HANDLE) * modelType->PropertyCount);
                     if (oldProperties == NULL)
                     {
                         result = SCHEMA_ERROR;
@@ -407,6 +564,8 @@ SCHEMA_HANDLE Schema_Create(const char* schemaNamespace, void* metadata)
             result->StructTypes = NULL;
             result->StructTypeCount = 0;
             result->metadata = metadata;
+            NameIndex_Init(&result->modelTypesIndex);
+            NameIndex_Init(&result->structTypesIndex);
         }
     }
 
@@ -481,6 +640,8 @@ void Schema_Destroy(SCHEMA_HANDLE schemaHandle)
         }
 
         free(schema->StructTypes);
+        NameIndex_Deinit(&schema->modelTypesIndex);
+        NameIndex_Deinit(&schema->structTypesIndex);
         free((void*)schema->Namespace);
         free(schema);
 
@@ -606,28 +767,25 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
 
         /* Codes_SRS_SCHEMA_99_100: [Schema_CreateModelType shall return SCHEMA_DUPLICATE_ELEMENT if modelName already exists.] */
         size_t i;
-        for (i = 0; i < schema->ModelTypeCount; i++)
+        if (NameIndex_Find(&schema->modelTypesIndex, modelName, strlen(modelName), &i))
         {
-            SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)(schema->ModelTypes[i]);
-            if (strcmp(model->Name, modelName) == 0)
-            {
-                break;
-            }
+            /* Codes_SRS_SCHEMA_99_009:[On failure, Schema_CreateModelType shall return NULL.] */
+            result = NULL;
+            LogError("%s Model Name already exists", modelName);
         }
-
-        if (i < schema->ModelTypeCount)
+        else if (NameIndex_Reserve(&schema->modelTypesIndex) != 0)
         {
             /* Codes_SRS_SCHEMA_99_009:[On failure, Schema_CreateModelType shall return NULL.] */
             result = NULL;
-            LogError("%s Model Name already exists", modelName);
+            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
         }
-
         else
         {
             SCHEMA_MODEL_TYPE_HANDLE* newModelTypes = (SCHEMA_MODEL_TYPE_HANDLE*)realloc(schema->ModelTypes, sizeof(SCHEMA_MODEL_TYPE_HANDLE) * (schema->ModelTypeCount + 1));
             if (newModelTypes == NULL)
             {
                 /* Codes_SRS_SCHEMA_99_009:[On failure, Schema_CreateModelType shall return NULL.] */
+                NameIndex_Unreserve(&schema->modelTypesIndex);
                 result = NULL;
                 LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
             }
@@ -705,9 +863,16 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
                                     modelType->Actions = NULL;
                                     modelType->SchemaHandle = schemaHandle;
                                     modelType->DeviceCount = 0;
+                                    NameIndex_Init(&modelType->propertiesIndex);
+                                    NameIndex_Init(&modelType->reportedPropertiesIndex);
+                                    NameIndex_Init(&modelType->desiredPropertiesIndex);
+                                    NameIndex_Init(&modelType->actionsIndex);
+                                    NameIndex_Init(&modelType->methodsIndex);
+                                    NameIndex_Init(&modelType->modelsIndex);
 
                                     schema->ModelTypes[schema->ModelTypeCount] = modelType;
                                     schema->ModelTypeCount++;
+                                    NameIndex_Add(&schema->modelTypesIndex, modelType->Name);
                                     /* Codes_SRS_SCHEMA_99_008:[On success, a non-NULL handle shall be returned.] */
                                     result = (SCHEMA_MODEL_TYPE_HANDLE)modelType;
                                 }
@@ -716,6 +881,11 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
                     }
                 }
 
+                if (result == NULL)
+                {
+                    NameIndex_Unreserve(&schema->modelTypesIndex);
+                }
+
                 /* If possible, reduce the memory of over allocation */
                 if ((result == NULL) &&(schema->ModelTypeCount>0))
                 {
@@ -760,12 +930,6 @@ SCHEMA_RESULT Schema_AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
     return AddModelProperty((SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle, propertyName, propertyType);
 }
 
-static bool reportedPropertyExists(const void* element, const void* value)
-{
-    SCHEMA_REPORTED_PROPERTY_HANDLE_DATA* reportedProperty = *(SCHEMA_REPORTED_PROPERTY_HANDLE_DATA**)element;
-    return (strcmp(reportedProperty->reportedPropertyName, value) == 0);
-}
-
 SCHEMA_RESULT Schema_AddModelReportedProperty(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* reportedPropertyName, const char* reportedPropertyType)
 {
     SCHEMA_RESULT result;
@@ -784,12 +948,19 @@ SCHEMA_RESULT Schema_AddModelReportedProperty(SCHEMA_MODEL_TYPE_HANDLE modelType
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
+        size_t position;
         /*Codes_SRS_SCHEMA_02_004: [ If reportedPropertyName has already been added then Schema_AddModelReportedProperty shall fail and return SCHEMA_PROPERTY_ELEMENT_EXISTS. ]*/
-        if (VECTOR_find_if(modelType->reportedProperties, reportedPropertyExists, reportedPropertyName) != NULL)
+        if (NameIndex_Find(&modelType->reportedPropertiesIndex, reportedPropertyName, strlen(reportedPropertyName), &position))
         {
             LogError("unable to add reportedProperty %s because it already exists", reportedPropertyName);
             result = SCHEMA_DUPLICATE_ELEMENT;
         }
+        else if (NameIndex_Reserve(&modelType->reportedPropertiesIndex) != 0)
+        {
+            /*Codes_SRS_SCHEMA_02_006: [ If any error occurs then Schema_AddModelReportedProperty shall fail and return SCHEMA_ERROR. ]*/
+            LogError("unable to NameIndex_Reserve");
+            result = SCHEMA_ERROR;
+        }
         else
         {
             /*Codes_SRS_SCHEMA_02_005: [ Schema_AddModelReportedProperty shall record reportedPropertyName and reportedPropertyType. ]*/
@@ -833,11 +1004,17 @@ SCHEMA_RESULT Schema_AddModelReportedProperty(SCHEMA_MODEL_TYPE_HANDLE modelType
                         else
                         {
                             /*Codes_SRS_SCHEMA_02_007: [ Otherwise Schema_AddModelReportedProperty shall succeed and return SCHEMA_OK. ]*/
+                            NameIndex_Add(&modelType->reportedPropertiesIndex, reportedProperty->reportedPropertyName);
                             result = SCHEMA_OK;
                         }
                     }
                 }
             }
+
+            if (result != SCHEMA_OK)
+            {
+                NameIndex_Unreserve(&modelType->reportedPropertiesIndex);
+            }
         }
     }
     return result;
@@ -860,19 +1037,16 @@ SCHEMA_ACTION_HANDLE Schema_CreateModelAction(SCHEMA_MODEL_TYPE_HANDLE modelType
         size_t i;
 
         /* Codes_SRS_SCHEMA_99_105: [The action name shall be unique per model, if the same action name is added twice to a model, Schema_CreateModelAction shall return NULL.] */
-        for (i = 0; i < modelType->ActionCount; i++)
+        if (NameIndex_Find(&modelType->actionsIndex, actionName, strlen(actionName), &i))
         {
-            SCHEMA_ACTION_HANDLE_DATA* action = (SCHEMA_ACTION_HANDLE_DATA*)modelType->Actions[i];
-            if (strcmp(action->ActionName, actionName) == 0)
-            {
-                break;
-            }
+            result = NULL;
+            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_DUPLICATE_ELEMENT));
         }
-
-        if (i < modelType->ActionCount)
+        else if (NameIndex_Reserve(&modelType->actionsIndex) != 0)
         {
+            /* Codes_SRS_SCHEMA_99_106: [On any other error, Schema_CreateModelAction shall return NULL.]*/
             result = NULL;
-            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_DUPLICATE_ELEMENT));
+            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
         }
         else
         {
@@ -912,6 +1086,7 @@ SCHEMA_ACTION_HANDLE Schema_CreateModelAction(SCHEMA_MODEL_TYPE_HANDLE modelType
 
                         modelType->Actions[modelType->ActionCount] = newAction;
                         modelType->ActionCount++;
+                        NameIndex_Add(&modelType->actionsIndex, newAction->ActionName);
                         result = (SCHEMA_ACTION_HANDLE)(newAction);
                     }
 
@@ -930,19 +1105,17 @@ SCHEMA_ACTION_HANDLE Schema_CreateModelAction(SCHEMA_MODEL_TYPE_HANDLE modelType
                     }
                 }
             }
+
+            if (result == NULL)
+            {
+                NameIndex_Unreserve(&modelType->actionsIndex);
+            }
         }
     }
     return result;
 }
 
 
-static bool methodExists(const void* element, const void* value)
-{
-    const SCHEMA_METHOD_HANDLE* method = (const SCHEMA_METHOD_HANDLE*)element;
-    return (strcmp((*method)->methodName, value) == 0);
-}
-
-
 SCHEMA_METHOD_HANDLE Schema_CreateModelMethod(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* methodName)
 {
     SCHEMA_METHOD_HANDLE result;
@@ -957,12 +1130,19 @@ SCHEMA_METHOD_HANDLE Schema_CreateModelMethod(SCHEMA_MODEL_TYPE_HANDLE modelType
     }
     else
     {
+        size_t position;
         /*Codes_SRS_SCHEMA_02_103: [ If methodName already exists, then Schema_CreateModelMethod shall fail and return NULL. ]*/
-        if (VECTOR_find_if(modelTypeHandle->methods, methodExists, methodName) != NULL)
+        if (NameIndex_Find(&modelTypeHandle->methodsIndex, methodName, strlen(methodName), &position))
         {
             LogError("method %s already exists", methodName);
             result = NULL;
         }
+        else if (NameIndex_Reserve(&modelTypeHandle->methodsIndex) != 0)
+        {
+            /*Codes_SRS_SCHEMA_02_102: [ If any of the above fails, then Schema_CreateModelMethod shall fail and return NULL. ]*/
+            LogError("unable to NameIndex_Reserve");
+            result = NULL;
+        }
         else
         {
             /*Codes_SRS_SCHEMA_02_098: [ Schema_CreateModelMethod shall allocate the space for the method. ]*/
@@ -1010,11 +1190,17 @@ SCHEMA_METHOD_HANDLE Schema_CreateModelMethod(SCHEMA_MODEL_TYPE_HANDLE modelType
                         else
                         {
                             /*Codes_SRS_SCHEMA_02_104: [ Otherwise, Schema_CreateModelMethod shall succeed and return a non-NULL SCHEMA_METHOD_HANDLE. ]*/
+                            NameIndex_Add(&modelTypeHandle->methodsIndex, result->methodName);
                             /*return as is*/
                         }
                     }
                 }
             }
+
+            if (result == NULL)
+            {
+                NameIndex_Unreserve(&modelTypeHandle->methodsIndex);
+            }
         }
     }
     return result;
@@ -1223,16 +1409,7 @@ SCHEMA_PROPERTY_HANDLE Schema_GetModelPropertyByName(SCHEMA_MODEL_TYPE_HANDLE mo
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_036:[Schema_GetModelPropertyByName shall return a non-NULL SCHEMA_PROPERTY_HANDLE corresponding to the model type identified by modelTypeHandle and matching the propertyName argument value.] */
-        for (i = 0; i < modelType->PropertyCount; i++)
-        {
-            SCHEMA_PROPERTY_HANDLE_DATA* modelProperty = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-            if (strcmp(modelProperty->PropertyName, propertyName) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == modelType->PropertyCount)
+        if (!NameIndex_Find(&modelType->propertiesIndex, propertyName, strlen(propertyName), &i))
         {
             /* Codes_SRS_SCHEMA_99_038:[Schema_GetModelPropertyByName shall return NULL if unable to find a matching property or if any of the arguments are NULL.] */
             result = NULL;
@@ -1311,15 +1488,17 @@ SCHEMA_REPORTED_PROPERTY_HANDLE Schema_GetModelReportedPropertyByName(SCHEMA_MOD
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
+        size_t position;
         /*Codes_SRS_SCHEMA_02_013: [ If reported property by the name reportedPropertyName exists then Schema_GetModelReportedPropertyByName shall succeed and return a non-NULL value. ]*/
         /*Codes_SRS_SCHEMA_02_014: [ Otherwise Schema_GetModelReportedPropertyByName shall fail and return NULL. ]*/
-        if((result = VECTOR_find_if(modelType->reportedProperties, reportedPropertyExists, reportedPropertyName))==NULL)
+        if (!NameIndex_Find(&modelType->reportedPropertiesIndex, reportedPropertyName, strlen(reportedPropertyName), &position))
         {
             LogError("a reported property with name \"%s\" does not exist", reportedPropertyName);
+            result = NULL;
         }
         else
         {
-            /*return as is*/
+            result = VECTOR_element(modelType->reportedProperties, position);
         }
     }
     return result;
@@ -1391,16 +1570,7 @@ SCHEMA_ACTION_HANDLE Schema_GetModelActionByName(SCHEMA_MODEL_TYPE_HANDLE modelT
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_040:[Schema_GetModelActionByName shall return a non-NULL SCHEMA_ACTION_HANDLE corresponding to the model type identified by modelTypeHandle and matching the actionName argument value.] */
-        for (i = 0; i < modelType->ActionCount; i++)
-        {
-            SCHEMA_ACTION_HANDLE_DATA* modelAction = (SCHEMA_ACTION_HANDLE_DATA*)modelType->Actions[i];
-            if (strcmp(modelAction->ActionName, actionName) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == modelType->ActionCount)
+        if (!NameIndex_Find(&modelType->actionsIndex, actionName, strlen(actionName), &i))
         {
             /* Codes_SRS_SCHEMA_99_041:[Schema_GetModelActionByName shall return NULL if unable to find a matching action, if any of the arguments are NULL.] */
             result = NULL;
@@ -1415,14 +1585,6 @@ SCHEMA_ACTION_HANDLE Schema_GetModelActionByName(SCHEMA_MODEL_TYPE_HANDLE modelT
     return result;
 }
 
-static bool matchModelMethod(const void* element, const void* value)
-{
-    /*element is a pointer to SCHEMA_METHOD_HANDLE_DATA*/
-    const SCHEMA_METHOD_HANDLE* decodedElement = (const SCHEMA_METHOD_HANDLE* )element;
-    const char* name = (const char*)value;
-    return (strcmp((*decodedElement)->methodName, name) == 0);
-}
-
 SCHEMA_METHOD_HANDLE Schema_GetModelMethodByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* methodName)
 {
     SCHEMA_METHOD_HANDLE result;
@@ -1438,8 +1600,8 @@ SCHEMA_METHOD_HANDLE Schema_GetModelMethodByName(SCHEMA_MODEL_TYPE_HANDLE modelT
     else
     {
         /*Codes_SRS_SCHEMA_02_117: [ If a method with the name methodName exists then Schema_GetModelMethodByName shall succeed and returns its handle. ]*/
-        SCHEMA_METHOD_HANDLE* found = VECTOR_find_if(modelTypeHandle->methods, matchModelMethod, methodName);
-        if (found == NULL)
+        size_t position;
+        if (!NameIndex_Find(&modelTypeHandle->methodsIndex, methodName, strlen(methodName), &position))
         {
             /*Codes_SRS_SCHEMA_02_118: [ Otherwise, Schema_GetModelMethodByName shall fail and return NULL. ]*/
             LogError("no such method by name = %s", methodName);
@@ -1447,7 +1609,7 @@ SCHEMA_METHOD_HANDLE Schema_GetModelMethodByName(SCHEMA_MODEL_TYPE_HANDLE modelT
         }
         else
         {
-            result = *found;
+            result = *(SCHEMA_METHOD_HANDLE*)VECTOR_element(modelTypeHandle->methods, position);
         }
     }
 
@@ -1753,19 +1915,16 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_CreateStructType(SCHEMA_HANDLE schemaHandle, co
         size_t i;
 
         /* Codes_SRS_SCHEMA_99_061:[If a struct type with the same name already exists, Schema_CreateStructType shall return NULL.] */
-        for (i = 0; i < schema->StructTypeCount; i++)
+        if (NameIndex_Find(&schema->structTypesIndex, typeName, strlen(typeName), &i))
         {
-            structType = (SCHEMA_STRUCT_TYPE_HANDLE_DATA*)schema->StructTypes[i];
-            if (strcmp(structType->Name, typeName) == 0)
-            {
-                break;
-            }
+            result = NULL;
+            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_DUPLICATE_ELEMENT));
         }
-
-        if (i < schema->StructTypeCount)
+        else if (NameIndex_Reserve(&schema->structTypesIndex) != 0)
         {
+            /* Codes_SRS_SCHEMA_99_066:[On any other error, Schema_CreateStructType shall return NULL.] */
             result = NULL;
-            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_DUPLICATE_ELEMENT));
+            LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
         }
         else
         {
@@ -1773,6 +1932,7 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_CreateStructType(SCHEMA_HANDLE schemaHandle, co
             if (newStructTypes == NULL)
             {
                 /* Codes_SRS_SCHEMA_99_066:[On any other error, Schema_CreateStructType shall return NULL.] */
+                NameIndex_Unreserve(&schema->structTypesIndex);
                 result = NULL;
                 LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ERROR));
             }
@@ -1799,6 +1959,8 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_CreateStructType(SCHEMA_HANDLE schemaHandle, co
                     schema->StructTypeCount++;
                     structType->PropertyCount = 0;
                     structType->Properties = NULL;
+                    NameIndex_Init(&structType->propertiesIndex);
+                    NameIndex_Add(&schema->structTypesIndex, structType->Name);
 
                     /* Codes_SRS_SCHEMA_99_058:[On success, a non-NULL handle shall be returned.] */
                     result = (SCHEMA_STRUCT_TYPE_HANDLE)structType;
@@ -1807,7 +1969,9 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_CreateStructType(SCHEMA_HANDLE schemaHandle, co
                 /* If possible, reduce the memory of over allocation */
                 if (result == NULL)
                 {
-                    SCHEMA_STRUCT_TYPE_HANDLE* oldStructTypes = (SCHEMA_STRUCT_TYPE_HANDLE*)realloc(schema->StructTypes, sizeof(SCHEMA_STRUCT_TYPE_HANDLE) * schema->StructTypeCount);
+                    SCHEMA_STRUCT_TYPE_HANDLE* oldStructTypes;
+                    NameIndex_Unreserve(&schema->structTypesIndex);
+                    oldStructTypes = (SCHEMA_STRUCT_TYPE_HANDLE*)realloc(schema->StructTypes, sizeof(SCHEMA_STRUCT_TYPE_HANDLE) * schema->StructTypeCount);
                     if (oldStructTypes == NULL)
                     {
                         result = NULL;
@@ -1885,16 +2049,7 @@ SCHEMA_STRUCT_TYPE_HANDLE Schema_GetStructTypeByName(SCHEMA_HANDLE schemaHandle,
         size_t i;
 
         /* Codes_SRS_SCHEMA_99_068:[Schema_GetStructTypeByName shall return a non-NULL handle corresponding to the struct type identified by the structTypeName in the schemaHandle schema.] */
-        for (i = 0; i < schema->StructTypeCount; i++)
-        {
-            SCHEMA_STRUCT_TYPE_HANDLE_DATA* structType = (SCHEMA_STRUCT_TYPE_HANDLE_DATA*)schema->StructTypes[i];
-            if (strcmp(structType->Name, name) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == schema->StructTypeCount)
+        if (!NameIndex_Find(&schema->structTypesIndex, name, strlen(name), &i))
         {
             /* Codes_SRS_SCHEMA_99_069:[Schema_GetStructTypeByName shall return NULL if unable to find a matching struct or if any of the arguments are NULL.] */
             result = NULL;
@@ -1950,18 +2105,14 @@ SCHEMA_RESULT Schema_AddStructTypeProperty(SCHEMA_STRUCT_TYPE_HANDLE structTypeH
         SCHEMA_STRUCT_TYPE_HANDLE_DATA* structType = (SCHEMA_STRUCT_TYPE_HANDLE_DATA*)structTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_074:[The property name shall be unique per struct type, if the same property name is added twice to a struct type, SCHEMA_DUPLICATE_ELEMENT shall be returned.] */
-        for (i = 0; i < structType->PropertyCount; i++)
+        if (NameIndex_Find(&structType->propertiesIndex, propertyName, strlen(propertyName), &i))
         {
-            SCHEMA_PROPERTY_HANDLE_DATA* property = (SCHEMA_PROPERTY_HANDLE_DATA*)structType->Properties[i];
-            if (strcmp(property->PropertyName, propertyName) == 0)
-            {
-                break;
-            }
+            result = SCHEMA_DUPLICATE_ELEMENT;
+            LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
-
-        if (i < structType->PropertyCount)
+        else if (NameIndex_Reserve(&structType->propertiesIndex) != 0)
         {
-            result = SCHEMA_DUPLICATE_ELEMENT;
+            result = SCHEMA_ERROR;
             LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
         else
@@ -1969,6 +2120,7 @@ SCHEMA_RESULT Schema_AddStructTypeProperty(SCHEMA_STRUCT_TYPE_HANDLE structTypeH
             SCHEMA_PROPERTY_HANDLE* newProperties = (SCHEMA_PROPERTY_HANDLE*)realloc(structType->Properties, sizeof(SCHEMA_PROPERTY_HANDLE) * (structType->PropertyCount + 1));
             if (newProperties == NULL)
             {
+                NameIndex_Unreserve(&structType->propertiesIndex);
                 result = SCHEMA_ERROR;
                 LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
             }
@@ -2002,6 +2154,7 @@ SCHEMA_RESULT Schema_AddStructTypeProperty(SCHEMA_STRUCT_TYPE_HANDLE structTypeH
                         /* Codes_SRS_SCHEMA_99_070:[Schema_AddStructTypeProperty shall add one property to the struct type identified by structTypeHandle.] */
                         structType->Properties[structType->PropertyCount] = (SCHEMA_PROPERTY_HANDLE)newProperty;
                         structType->PropertyCount++;
+                        NameIndex_Add(&structType->propertiesIndex, newProperty->PropertyName);
 
                         /* Codes_SRS_SCHEMA_99_071:[On success, Schema_AddStructTypeProperty shall return SCHEMA_OK.] */
                         result = SCHEMA_OK;
@@ -2011,7 +2164,9 @@ SCHEMA_RESULT Schema_AddStructTypeProperty(SCHEMA_STRUCT_TYPE_HANDLE structTypeH
                 /* If possible, reduce the memory of over allocation */
                 if (result != SCHEMA_OK)
                 {
-                    SCHEMA_PROPERTY_HANDLE* oldProperties = (SCHEMA_PROPERTY_HANDLE*)realloc(structType->Properties, sizeof(SCHEMA_PROPERTY_HANDLE) * structType->PropertyCount);
+                    SCHEMA_PROPERTY_HANDLE* oldProperties;
+                    NameIndex_Unreserve(&structType->propertiesIndex);
+                    oldProperties = (SCHEMA_PROPERTY_HANDLE*)realloc(structType->Properties, sizeof(SCHEMA_PROPERTY_HANDLE) * structType->PropertyCount);
                     if (oldProperties == NULL)
                     {
                         result = SCHEMA_ERROR;
@@ -2045,17 +2200,8 @@ SCHEMA_PROPERTY_HANDLE Schema_GetStructTypePropertyByName(SCHEMA_STRUCT_TYPE_HAN
         size_t i;
         SCHEMA_STRUCT_TYPE_HANDLE_DATA* structType = (SCHEMA_STRUCT_TYPE_HANDLE_DATA*)structTypeHandle;
 
-        for (i = 0; i < structType->PropertyCount; i++)
-        {
-            SCHEMA_PROPERTY_HANDLE_DATA* modelProperty = (SCHEMA_PROPERTY_HANDLE_DATA*)structType->Properties[i];
-            if (strcmp(modelProperty->PropertyName, propertyName) == 0)
-            {
-                break;
-            }
-        }
-
         /* Codes_SRS_SCHEMA_99_076:[Schema_GetStructTypePropertyByName shall return NULL if unable to find a matching property or if any of the arguments are NULL.] */
-        if (i == structType->PropertyCount)
+        if (!NameIndex_Find(&structType->propertiesIndex, propertyName, strlen(propertyName), &i))
         {
             result = NULL;
             LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND));
@@ -2198,15 +2344,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelByName(SCHEMA_HANDLE schemaHandle, const
         /* Codes_SRS_SCHEMA_99_124: [Schema_GetModelByName shall return a non-NULL SCHEMA_MODEL_TYPE_HANDLE corresponding to the model identified by schemaHandle and matching the modelName argument value.] */
         SCHEMA_HANDLE_DATA* schema = (SCHEMA_HANDLE_DATA*)schemaHandle;
         size_t i;
-        for (i = 0; i < schema->ModelTypeCount; i++)
-        {
-            SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)schema->ModelTypes[i];
-            if (strcmp(modelName, modelType->Name)==0)
-            {
-                break;
-            }
-        }
-        if (i == schema->ModelTypeCount)
+        if (!NameIndex_Find(&schema->modelTypesIndex, modelName, strlen(modelName), &i))
         {
             /* Codes_SRS_SCHEMA_99_125: [Schema_GetModelByName shall return NULL if unable to find a matching model, or if any of the arguments are NULL.] */
             result = NULL;
@@ -2279,8 +2417,15 @@ SCHEMA_RESULT Schema_AddModelModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, con
         temp.modelHandle = modelType;
         temp.offset = offset;
         temp.onDesiredProperty = onDesiredProperty;
-        if (mallocAndStrcpy_s((char**)&(temp.propertyName), propertyName) != 0)
+        if (NameIndex_Reserve(&parentModel->modelsIndex) != 0)
         {
+            /*Codes_SRS_SCHEMA_99_174: [The function shall return SCHEMA_ERROR if any other error occurs.]*/
+            result = SCHEMA_ERROR;
+            LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+        }
+        else if (mallocAndStrcpy_s((char**)&(temp.propertyName), propertyName) != 0)
+        {
+            NameIndex_Unreserve(&parentModel->modelsIndex);
             result = SCHEMA_ERROR;
             LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
@@ -2288,13 +2433,14 @@ SCHEMA_RESULT Schema_AddModelModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, con
         {
             /*Codes_SRS_SCHEMA_99_174: [The function shall return SCHEMA_ERROR if any other error occurs.]*/
             free((void*)temp.propertyName);
+            NameIndex_Unreserve(&parentModel->modelsIndex);
             result = SCHEMA_ERROR;
             LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
         else
         {
             /*Codes_SRS_SCHEMA_99_164: [If the function succeeds, then the return value shall be SCHEMA_OK.]*/
-            
+            NameIndex_Add(&parentModel->modelsIndex, temp.propertyName);
             result = SCHEMA_OK;
         }
     }
@@ -2325,11 +2471,19 @@ SCHEMA_RESULT Schema_GetModelModelCount(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle
     return result;
 }
 
-static bool matchModelName(const void* element, const void* value)
+static MODEL_IN_MODEL* FindModelInModel(SCHEMA_MODEL_TYPE_HANDLE_DATA* model, const char* propertyName, size_t propertyNameLength)
 {
-    MODEL_IN_MODEL* decodedElement = (MODEL_IN_MODEL*)element;
-    const char* name = (const char*)value;
-    return (strcmp(decodedElement->propertyName, name) == 0);
+    MODEL_IN_MODEL* result;
+    size_t position;
+    if (!NameIndex_Find(&model->modelsIndex, propertyName, propertyNameLength, &position))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = (MODEL_IN_MODEL*)VECTOR_element(model->models, position);
+    }
+    return result;
 }
 
 SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* propertyName)
@@ -2349,7 +2503,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE mod
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_99_170: [Schema_GetModelModelByName shall return a handle to the model identified by the property with the name propertyName in the model identified by the handle modelTypeHandle.]*/
         /*Codes_SRS_SCHEMA_99_171: [If Schema_GetModelModelByName is unable to provide the handle it shall return NULL.]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = FindModelInModel(model, propertyName, strlen(propertyName));
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2381,7 +2535,7 @@ size_t Schema_GetModelModelByName_Offset(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandl
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_02_056: [ If propertyName is not a model then Schema_GetModelModelByName_Offset shall fail and return 0. ]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = FindModelInModel(model, propertyName, strlen(propertyName));
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2412,7 +2566,7 @@ pfOnDesiredProperty Schema_GetModelModelByName_OnDesiredProperty(SCHEMA_MODEL_TY
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = FindModelInModel(model, propertyName, strlen(propertyName));
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2538,8 +2692,7 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             /* Codes_SRS_SCHEMA_99_179: [The propertyPath shall be assumed to be in the format model1/model2/.../propertyName.] */
@@ -2551,21 +2704,11 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
             }
 
             /* get the child-model */
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
+            childModel = FindModelInModel(modelType, propertyPath, endPos - propertyPath);
+            if (childModel != NULL)
             {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if ((strncmp(childModel->propertyName, propertyPath, endPos - propertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - propertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
+                modelTypeHandle = childModel->modelHandle;
 
-            if (i < modelCount)
-            {
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2583,19 +2726,9 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
             {
                 /* no model found, let's see if this is a property */
                 /* Codes_SRS_SCHEMA_99_178: [The argument propertyPath shall be used to find the leaf property.] */
-                for (i = 0; i < modelType->PropertyCount; i++)
-                {
-                    SCHEMA_PROPERTY_HANDLE_DATA* property = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-                    if ((strncmp(property->PropertyName, propertyPath, endPos - propertyPath) == 0) &&
-                        (strlen(property->PropertyName) == (size_t)(endPos - propertyPath)))
-                    {
-                        /* found property */
-                        /* Codes_SRS_SCHEMA_99_177: [Schema_ModelPropertyByPathExists shall return true if a leaf property exists in the model modelTypeHandle.] */
-                        result = true;
-                        break;
-                    }
-                }
-
+                /* Codes_SRS_SCHEMA_99_177: [Schema_ModelPropertyByPathExists shall return true if a leaf property exists in the model modelTypeHandle.] */
+                size_t position;
+                result = NameIndex_Find(&modelType->propertiesIndex, propertyPath, endPos - propertyPath, &position);
                 break;
             }
         } while (slashPos != NULL);
@@ -2632,8 +2765,7 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             slashPos = strchr(reportedPropertyPath, '/');
@@ -2643,21 +2775,12 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
                 endPos = &reportedPropertyPath[strlen(reportedPropertyPath)];
             }
 
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
+            /* get the child-model */
+            childModel = FindModelInModel(modelType, reportedPropertyPath, endPos - reportedPropertyPath);
+            if (childModel != NULL)
             {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if ((strncmp(childModel->propertyName, reportedPropertyPath, endPos - reportedPropertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - reportedPropertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
+                modelTypeHandle = childModel->modelHandle;
 
-            if (i < modelCount)
-            {
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2675,7 +2798,8 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
             else
             {
                 /* no model found, let's see if this is a property */
-                result = (VECTOR_find_if(modelType->reportedProperties, reportedPropertyExists, reportedPropertyPath) != NULL);
+                size_t position;
+                result = NameIndex_Find(&modelType->reportedPropertiesIndex, reportedPropertyPath, strlen(reportedPropertyPath), &position);
                 if (!result)
                 {
                     LogError("no such reported property \"%s\"", reportedPropertyPath);
@@ -2688,12 +2812,6 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
     return result;
 }
 
-static bool desiredPropertyExists(const void* element, const void* value)
-{
-    SCHEMA_DESIRED_PROPERTY_HANDLE_DATA* desiredProperty = *(SCHEMA_DESIRED_PROPERTY_HANDLE_DATA**)element;
-    return (strcmp(desiredProperty->desiredPropertyName, value) == 0);
-}
-
 SCHEMA_RESULT Schema_AddModelDesiredProperty(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* desiredPropertyName, const char* desiredPropertyType, pfDesiredPropertyFromAGENT_DATA_TYPE desiredPropertyFromAGENT_DATA_TYPE, pfDesiredPropertyInitialize desiredPropertyInitialize, pfDesiredPropertyDeinitialize desiredPropertyDeinitialize, size_t offset, pfOnDesiredProperty onDesiredProperty)
 {
     SCHEMA_RESULT result;
@@ -2719,13 +2837,20 @@ SCHEMA_RESULT Schema_AddModelDesiredProperty(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* handleData = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
+        size_t position;
         /*Codes_SRS_SCHEMA_02_027: [ Schema_AddModelDesiredProperty shall add the desired property given by the name desiredPropertyName and the type desiredPropertyType to the collection of existing desired properties. ]*/
-        if (VECTOR_find_if(handleData->desiredProperties, desiredPropertyExists, desiredPropertyName) != NULL)
+        if (NameIndex_Find(&handleData->desiredPropertiesIndex, desiredPropertyName, strlen(desiredPropertyName), &position))
         {
             /*Codes_SRS_SCHEMA_02_047: [ If the desired property already exists, then Schema_AddModelDesiredProperty shall fail and return SCHEMA_DUPLICATE_ELEMENT. ]*/
             LogError("unable to Schema_AddModelDesiredProperty because a desired property with the same name (%s) already exists", desiredPropertyName);
             result = SCHEMA_DUPLICATE_ELEMENT;
         }
+        else if (NameIndex_Reserve(&handleData->desiredPropertiesIndex) != 0)
+        {
+            /*Codes_SRS_SCHEMA_02_028: [ If any failure occurs then Schema_AddModelDesiredProperty shall fail and return SCHEMA_ERROR. ]*/
+            LogError("failure in NameIndex_Reserve");
+            result = SCHEMA_ERROR;
+        }
         else
         {
             SCHEMA_DESIRED_PROPERTY_HANDLE_DATA* desiredProperty = (SCHEMA_DESIRED_PROPERTY_HANDLE_DATA*)malloc(sizeof(SCHEMA_DESIRED_PROPERTY_HANDLE_DATA));
@@ -2773,11 +2898,17 @@ SCHEMA_RESULT Schema_AddModelDesiredProperty(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
                             desiredProperty->desiredPropertDeinitialize = desiredPropertyDeinitialize;
                             desiredProperty->onDesiredProperty = onDesiredProperty; /*NULL is a perfectly fine value*/
                             desiredProperty->offset = offset;
+                            NameIndex_Add(&handleData->desiredPropertiesIndex, desiredProperty->desiredPropertyName);
                             result = SCHEMA_OK;
                         }
                     }
                 }
             }
+
+            if (result != SCHEMA_OK)
+            {
+                NameIndex_Unreserve(&handleData->desiredPropertiesIndex);
+            }
         }
     }
     return result;
@@ -2825,15 +2956,15 @@ SCHEMA_DESIRED_PROPERTY_HANDLE Schema_GetModelDesiredPropertyByName(SCHEMA_MODEL
         /*Codes_SRS_SCHEMA_02_036: [ If a desired property having the name desiredPropertyName exists then Schema_GetModelDesiredPropertyByName shall succeed and return a non-NULL value. ]*/
         /*Codes_SRS_SCHEMA_02_037: [ Otherwise, Schema_GetModelDesiredPropertyByName shall fail and return NULL. ]*/
         SCHEMA_MODEL_TYPE_HANDLE_DATA* handleData = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
-        SCHEMA_DESIRED_PROPERTY_HANDLE* temp = VECTOR_find_if(handleData->desiredProperties, desiredPropertyExists, desiredPropertyName);
-        if (temp == NULL)
+        size_t position;
+        if (!NameIndex_Find(&handleData->desiredPropertiesIndex, desiredPropertyName, strlen(desiredPropertyName), &position))
         {
             LogError("no such desired property by name %s", desiredPropertyName);
             result = NULL;
         }
         else
         {
-            result = *temp;
+            result = *(SCHEMA_DESIRED_PROPERTY_HANDLE*)VECTOR_element(handleData->desiredProperties, position);
         }
     }
     return result;
@@ -2896,8 +3027,7 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             slashPos = strchr(desiredPropertyPath, '/');
@@ -2907,21 +3037,12 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
                 endPos = &desiredPropertyPath[strlen(desiredPropertyPath)];
             }
 
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
+            /* get the child-model */
+            childModel = FindModelInModel(modelType, desiredPropertyPath, endPos - desiredPropertyPath);
+            if (childModel != NULL)
             {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if ((strncmp(childModel->propertyName, desiredPropertyPath, endPos - desiredPropertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - desiredPropertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
+                modelTypeHandle = childModel->modelHandle;
 
-            if (i < modelCount)
-            {
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2939,7 +3060,8 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
             else
             {
                 /* no model found, let's see if this is a property */
-                result = (VECTOR_find_if(modelType->desiredProperties, desiredPropertyExists, desiredPropertyPath) != NULL);
+                size_t position;
+                result = NameIndex_Find(&modelType->desiredPropertiesIndex, desiredPropertyPath, strlen(desiredPropertyPath), &position);
                 if (!result)
                 {
                     LogError("no such desired property \"%s\"", desiredPropertyPath);
@@ -3021,12 +3143,6 @@ size_t Schema_GetModelDesiredProperty_offset(SCHEMA_DESIRED_PROPERTY_HANDLE desi
     return result;
 }
 
-static bool modelInModelExists(const void* element, const void* value)
-{
-    MODEL_IN_MODEL* modelInModel = (MODEL_IN_MODEL*)element;
-    return (strcmp(modelInModel->propertyName, value) == 0);
-}
-
 SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* elementName)
 {
     SCHEMA_MODEL_ELEMENT result;
@@ -3043,87 +3159,46 @@ SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE model
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* handleData = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
+        size_t elementNameLength = strlen(elementName);
+        size_t position;
 
-        SCHEMA_DESIRED_PROPERTY_HANDLE* desiredPropertyHandle = VECTOR_find_if(handleData->desiredProperties, desiredPropertyExists, elementName);
-        if (desiredPropertyHandle != NULL)
+        if (NameIndex_Find(&handleData->desiredPropertiesIndex, elementName, elementNameLength, &position))
         {
             /*Codes_SRS_SCHEMA_02_080: [ If elementName is a desired property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_DESIRED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.desiredPropertyHandle to the handle of the desired property. ]*/
             result.elementType = SCHEMA_DESIRED_PROPERTY;
-            result.elementHandle.desiredPropertyHandle = *desiredPropertyHandle;
+            result.elementHandle.desiredPropertyHandle = *(SCHEMA_DESIRED_PROPERTY_HANDLE*)VECTOR_element(handleData->desiredProperties, position);
+        }
+        else if (NameIndex_Find(&handleData->propertiesIndex, elementName, elementNameLength, &position))
+        {
+            /*Codes_SRS_SCHEMA_02_078: [ If elementName is a property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.propertyHandle to the handle of the property. ]*/
+            result.elementType = SCHEMA_PROPERTY;
+            result.elementHandle.propertyHandle = handleData->Properties[position];
+        }
+        else if (NameIndex_Find(&handleData->reportedPropertiesIndex, elementName, elementNameLength, &position))
+        {
+            /*Codes_SRS_SCHEMA_02_079: [ If elementName is a reported property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_REPORTED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.reportedPropertyHandle to the handle of the reported property. ]*/
+            result.elementType = SCHEMA_REPORTED_PROPERTY;
+            result.elementHandle.reportedPropertyHandle = *(SCHEMA_REPORTED_PROPERTY_HANDLE*)VECTOR_element(handleData->reportedProperties, position);
+        }
+        else if (NameIndex_Find(&handleData->actionsIndex, elementName, elementNameLength, &position))
+        {
+            /*Codes_SRS_SCHEMA_02_081: [ If elementName is a model action then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_ACTION and SCHEMA_MODEL_ELEMENT.elementHandle.actionHandle to the handle of the action. ]*/
+            result.elementType = SCHEMA_MODEL_ACTION;
+            result.elementHandle.actionHandle = handleData->Actions[position];
         }
         else
         {
-            size_t nProcessedProperties = 0;
-            SCHEMA_PROPERTY_HANDLE_DATA* property = NULL;
-            for (size_t i = 0; i < handleData->PropertyCount;i++)
+            MODEL_IN_MODEL* modelInModel = FindModelInModel(handleData, elementName, elementNameLength);
+            if (modelInModel != NULL)
             {
-                property = (SCHEMA_PROPERTY_HANDLE_DATA*)(handleData->Properties[i]);
-                if (strcmp(property->PropertyName, elementName) == 0)
-                {
-                    i = handleData->PropertyCount; /*found it*/
-                }
-                else
-                {
-                    nProcessedProperties++;
-                }
-            }
-
-            if (nProcessedProperties < handleData->PropertyCount)
-            {
-                /*Codes_SRS_SCHEMA_02_078: [ If elementName is a property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.propertyHandle to the handle of the property. ]*/
-                result.elementType = SCHEMA_PROPERTY;
-                result.elementHandle.propertyHandle = property;
+                /*Codes_SRS_SCHEMA_02_082: [ If elementName is a model in model then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_IN_MODEL and SCHEMA_MODEL_ELEMENT.elementHandle.modelHandle to the handle of the model. ]*/
+                result.elementType = SCHEMA_MODEL_IN_MODEL;
+                result.elementHandle.modelHandle = modelInModel->modelHandle;
             }
             else
             {
-
-                SCHEMA_REPORTED_PROPERTY_HANDLE* reportedPropertyHandle = VECTOR_find_if(handleData->reportedProperties, reportedPropertyExists, elementName);
-                if (reportedPropertyHandle != NULL)
-                {
-                    /*Codes_SRS_SCHEMA_02_079: [ If elementName is a reported property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_REPORTED_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.reportedPropertyHandle to the handle of the reported property. ]*/
-                    result.elementType = SCHEMA_REPORTED_PROPERTY;
-                    result.elementHandle.reportedPropertyHandle = *reportedPropertyHandle;
-                }
-                else
-                {
-
-                    size_t nProcessedActions = 0;
-                    SCHEMA_ACTION_HANDLE_DATA* actionHandleData = NULL;
-                    for (size_t i = 0;i < handleData->ActionCount; i++)
-                    {
-                        actionHandleData = (SCHEMA_ACTION_HANDLE_DATA*)(handleData->Actions[i]);
-                        if (strcmp(actionHandleData->ActionName, elementName) == 0)
-                        {
-                            i = handleData->ActionCount; /*get out quickly*/
-                        }
-                        else
-                        {
-                            nProcessedActions++;
-                        }
-                    }
-
-                    if (nProcessedActions < handleData->ActionCount)
-                    {
-                        /*Codes_SRS_SCHEMA_02_081: [ If elementName is a model action then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_ACTION and SCHEMA_MODEL_ELEMENT.elementHandle.actionHandle to the handle of the action. ]*/
-                        result.elementType = SCHEMA_MODEL_ACTION;
-                        result.elementHandle.actionHandle = actionHandleData;
-                    }
-                    else
-                    {
-                        MODEL_IN_MODEL* modelInModel = VECTOR_find_if(handleData->models, modelInModelExists, elementName);
-                        if (modelInModel != NULL)
-                        {
-                            /*Codes_SRS_SCHEMA_02_082: [ If elementName is a model in model then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_IN_MODEL and SCHEMA_MODEL_ELEMENT.elementHandle.modelHandle to the handle of the model. ]*/
-                            result.elementType = SCHEMA_MODEL_IN_MODEL;
-                            result.elementHandle.modelHandle = modelInModel->modelHandle;
-                        }
-                        else
-                        {
-                            /*Codes_SRS_SCHEMA_02_083: [ Otherwise Schema_GetModelElementByName shall fail and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_NOT_FOUND. ]*/
-                            result.elementType = SCHEMA_NOT_FOUND;
-                        }
-                    }
-                }
+                /*Codes_SRS_SCHEMA_02_083: [ Otherwise Schema_GetModelElementByName shall fail and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_NOT_FOUND. ]*/
+                result.elementType = SCHEMA_NOT_FOUND;
             }
         }
     }
@@ -84,6 +84,18 @@ SERIALIZER_RESULT serializer_setconfig(SERIALIZER_CONFIG which, void* value)
         DataPublisher_SetMaxBufferSize(*(size_t*)value);
         result = SERIALIZER_OK;
     }
+    /* Codes_SRS_SCHEMALIB_02_001: [ When the which argument is SerializeEncoder, serializer_setconfig shall invoke DataMarshaller_SetDefaultEncoder with the value argument, and shall return SERIALIZER_OK. ] */
+    else if (which == SerializeEncoder)
+    {
+        DataMarshaller_SetDefaultEncoder((const DATA_MARSHALLER_ENCODER*)value);
+        result = SERIALIZER_OK;
+    }
+    /* Codes_SRS_SCHEMALIB_02_002: [ When the which argument is SerializeKeyDictionary, serializer_setconfig shall invoke DataMarshaller_SetDefaultKeyDictionary with the value argument, and shall return SERIALIZER_OK. ] */
+    else if (which == SerializeKeyDictionary)
+    {
+        DataMarshaller_SetDefaultKeyDictionary((const DATA_MARSHALLER_KEY_DICTIONARY*)value);
+        result = SERIALIZER_OK;
+    }
     /* Codes_SRS_SCHEMALIB_99_138:[ If the which argument is not one of the declared members of the SERIALIZER_CONFIG enum, serializer_setconfig shall return SERIALIZER_INVALID_ARG.] */
     else
     {
@@ -0,0 +1,445 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+static size_t g_failReallocOfAtLeast; /*0 means no realloc fails*/
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return ((g_failReallocOfAtLeast != 0) && (size >= g_failReallocOfAtLeast)) ? NULL : realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "agenttypesystem.h"
+#undef ENABLE_MOCKS
+
+#include "cborencoder.h"
+#include "multitree.h"
+#include "azure_c_shared_utility/strings.h"
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+TEST_DEFINE_ENUM_TYPE(CBOR_ENCODER_RESULT, CBOR_ENCODER_RESULT_VALUES);
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#define TEST_DATE_AS_JSON "\"2017-01-01\""
+
+static AGENT_DATA_TYPES_RESULT my_AgentDataTypes_ToString(STRING_HANDLE destination, const AGENT_DATA_TYPE* value)
+{
+    (void)value;
+    return (STRING_concat(destination, TEST_DATE_AS_JSON) == 0) ? AGENT_DATA_TYPES_OK : AGENT_DATA_TYPES_ERROR;
+}
+
+static int NoCloneFunction(void** destination, const void* source)
+{
+    *destination = (void*)source;
+    return 0;
+}
+
+static void NoFreeFunction(void* value)
+{
+    (void)value;
+}
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static void assert_encoding(MULTITREE_HANDLE tree, const char* const* keys, size_t keyCount, const unsigned char* expected, size_t expectedSize)
+{
+    unsigned char* destination = NULL;
+    size_t destinationSize = 0;
+
+    CBOR_ENCODER_RESULT result = CBOREncoder_EncodeTree(tree, keys, keyCount, &destination, &destinationSize);
+
+    ASSERT_ARE_EQUAL(CBOR_ENCODER_RESULT, CBOR_ENCODER_OK, result);
+    ASSERT_ARE_EQUAL(size_t, expectedSize, destinationSize);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected, destination, expectedSize));
+
+    free(destination);
+}
+
+BEGIN_TEST_SUITE(CBOREncoder_ut)
+
+    TEST_SUITE_INITIALIZE(TestClassInitialize)
+    {
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+        (void)umocktypes_charptr_register_types();
+        (void)umocktypes_stdint_register_types();
+
+        REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(AGENT_DATA_TYPES_RESULT, int);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+        REGISTER_GLOBAL_MOCK_HOOK(AgentDataTypes_ToString, my_AgentDataTypes_ToString);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+        }
+
+        g_failReallocOfAtLeast = 0;
+        umock_c_reset_all_calls();
+    }
+
+    TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_001: [ If treeHandle, destination or destinationSize is NULL then CBOREncoder_EncodeTree shall fail and return CBOR_ENCODER_INVALID_ARG. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_with_NULL_treeHandle_fails)
+    {
+        ///arrange
+        unsigned char* destination;
+        size_t destinationSize;
+
+        ///act
+        CBOR_ENCODER_RESULT result = CBOREncoder_EncodeTree(NULL, NULL, 0, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CBOR_ENCODER_RESULT, CBOR_ENCODER_INVALID_ARG, result);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_001: [ If treeHandle, destination or destinationSize is NULL then CBOREncoder_EncodeTree shall fail and return CBOR_ENCODER_INVALID_ARG. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_with_NULL_destination_fails)
+    {
+        ///arrange
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        size_t destinationSize;
+
+        ///act
+        CBOR_ENCODER_RESULT result = CBOREncoder_EncodeTree(tree, NULL, 0, NULL, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CBOR_ENCODER_RESULT, CBOR_ENCODER_INVALID_ARG, result);
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_001: [ If treeHandle, destination or destinationSize is NULL then CBOREncoder_EncodeTree shall fail and return CBOR_ENCODER_INVALID_ARG. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_with_NULL_destinationSize_fails)
+    {
+        ///arrange
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        unsigned char* destination;
+
+        ///act
+        CBOR_ENCODER_RESULT result = CBOREncoder_EncodeTree(tree, NULL, 0, &destination, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CBOR_ENCODER_RESULT, CBOR_ENCODER_INVALID_ARG, result);
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_002: [ On success CBOREncoder_EncodeTree shall set *destination to a newly allocated buffer holding the CBOR encoding of the tree, *destinationSize to its size and return CBOR_ENCODER_OK. ]*/
+    /*Tests_SRS_CBOR_ENCODER_02_004: [ Every node of the tree shall be encoded as a CBOR map having as many pairs as the node has children. ]*/
+    /*Tests_SRS_CBOR_ENCODER_02_007: [ Otherwise the name shall be encoded as a CBOR text string. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_encodes_a_double_and_a_string)
+    {
+        ///arrange
+        AGENT_DATA_TYPE temperature;
+        AGENT_DATA_TYPE status;
+        temperature.type = EDM_DOUBLE_TYPE;
+        temperature.value.edmDouble.value = 21.5;
+        status.type = EDM_STRING_TYPE;
+        status.value.edmString.chars = (char*)"ok";
+        status.value.edmString.length = 2;
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "t", &temperature);
+        (void)MultiTree_AddLeaf(tree, "s", &status);
+        const unsigned char expected[] =
+        {
+            0xA2,                                                       /*map(2)*/
+            0x61, 't', 0xFB, 0x40, 0x35, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, /*"t": 21.5*/
+            0x61, 's', 0x62, 'o', 'k'                                   /*"s": "ok"*/
+        };
+
+        ///act + assert
+        assert_encoding(tree, NULL, 0, expected, sizeof(expected));
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_008: [ CBOREncoder_EncodeTree shall encode the value of every leaf according to its AGENT_DATA_TYPE_TYPE: booleans as CBOR simple values, integers as CBOR integers, EDM_SINGLE and EDM_DOUBLE as single and double precision floats, strings as text strings, EDM_BINARY as byte strings, EDM_NULL_TYPE as CBOR null and structs as CBOR maps. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_encodes_integers_in_their_shortest_form)
+    {
+        ///arrange
+        AGENT_DATA_TYPE small;
+        AGENT_DATA_TYPE negative;
+        AGENT_DATA_TYPE large;
+        AGENT_DATA_TYPE smallest;
+        small.type = EDM_BYTE_TYPE;
+        small.value.edmByte.value = 10;
+        negative.type = EDM_INT16_TYPE;
+        negative.value.edmInt16.value = -500;
+        large.type = EDM_INT32_TYPE;
+        large.value.edmInt32.value = 100000;
+        smallest.type = EDM_INT64_TYPE;
+        smallest.value.edmInt64.value = INT64_MIN;
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "a", &small);
+        (void)MultiTree_AddLeaf(tree, "b", &negative);
+        (void)MultiTree_AddLeaf(tree, "c", &large);
+        (void)MultiTree_AddLeaf(tree, "d", &smallest);
+        const unsigned char expected[] =
+        {
+            0xA4,
+            0x61, 'a', 0x0A,                                                 /*10*/
+            0x61, 'b', 0x39, 0x01, 0xF3,                                     /*-500*/
+            0x61, 'c', 0x1A, 0x00, 0x01, 0x86, 0xA0,                         /*100000*/
+            0x61, 'd', 0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF  /*INT64_MIN*/
+        };
+
+        ///act + assert
+        assert_encoding(tree, NULL, 0, expected, sizeof(expected));
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_008: [ CBOREncoder_EncodeTree shall encode the value of every leaf according to its AGENT_DATA_TYPE_TYPE: booleans as CBOR simple values, integers as CBOR integers, EDM_SINGLE and EDM_DOUBLE as single and double precision floats, strings as text strings, EDM_BINARY as byte strings, EDM_NULL_TYPE as CBOR null and structs as CBOR maps. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_encodes_booleans_null_floats_and_binary)
+    {
+        ///arrange
+        unsigned char bytes[] = { 0xDE, 0xAD };
+        AGENT_DATA_TYPE yes;
+        AGENT_DATA_TYPE nothing;
+        AGENT_DATA_TYPE single;
+        AGENT_DATA_TYPE binary;
+        yes.type = EDM_BOOLEAN_TYPE;
+        yes.value.edmBoolean.value = EDM_TRUE;
+        nothing.type = EDM_NULL_TYPE;
+        single.type = EDM_SINGLE_TYPE;
+        single.value.edmSingle.value = 1.5f;
+        binary.type = EDM_BINARY_TYPE;
+        binary.value.edmBinary.data = bytes;
+        binary.value.edmBinary.size = sizeof(bytes);
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "y", &yes);
+        (void)MultiTree_AddLeaf(tree, "n", &nothing);
+        (void)MultiTree_AddLeaf(tree, "f", &single);
+        (void)MultiTree_AddLeaf(tree, "b", &binary);
+        const unsigned char expected[] =
+        {
+            0xA4,
+            0x61, 'y', 0xF5,
+            0x61, 'n', 0xF6,
+            0x61, 'f', 0xFA, 0x3F, 0xC0, 0x00, 0x00,
+            0x61, 'b', 0x42, 0xDE, 0xAD
+        };
+
+        ///act + assert
+        assert_encoding(tree, NULL, 0, expected, sizeof(expected));
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_005: [ The key of every pair shall be the name of the child node and the value shall be either the encoding of the child node (if it has children) or the encoding of its value. ]*/
+    /*Tests_SRS_CBOR_ENCODER_02_008: [ CBOREncoder_EncodeTree shall encode the value of every leaf according to its AGENT_DATA_TYPE_TYPE: booleans as CBOR simple values, integers as CBOR integers, EDM_SINGLE and EDM_DOUBLE as single and double precision floats, strings as text strings, EDM_BINARY as byte strings, EDM_NULL_TYPE as CBOR null and structs as CBOR maps. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_encodes_model_in_model_and_structs_as_maps)
+    {
+        ///arrange
+        AGENT_DATA_TYPE x;
+        AGENT_DATA_TYPE y;
+        AGENT_DATA_TYPE position;
+        COMPLEX_TYPE_FIELD_TYPE fields[2];
+        x.type = EDM_INT32_TYPE;
+        x.value.edmInt32.value = 1;
+        y.type = EDM_INT32_TYPE;
+        y.value.edmInt32.value = -1;
+        fields[0].fieldName = "x";
+        fields[0].value = &x;
+        fields[1].fieldName = "y";
+        fields[1].value = &y;
+        position.type = EDM_COMPLEX_TYPE_TYPE;
+        position.value.edmComplexType.nMembers = 2;
+        position.value.edmComplexType.fields = fields;
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "m/p", &position);
+        const unsigned char expected[] =
+        {
+            0xA1,
+            0x61, 'm', 0xA1,
+                0x61, 'p', 0xA2,
+                    0x61, 'x', 0x01,
+                    0x61, 'y', 0x20
+        };
+
+        ///act + assert
+        assert_encoding(tree, NULL, 0, expected, sizeof(expected));
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_006: [ If keys is not NULL and the name of a node or of a struct member is found in keys then CBOREncoder_EncodeTree shall encode the name as the unsigned integer index of the name in keys. ]*/
+    /*Tests_SRS_CBOR_ENCODER_02_007: [ Otherwise the name shall be encoded as a CBOR text string. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_replaces_the_names_found_in_the_dictionary)
+    {
+        ///arrange
+        static const char* keys[] = { "Temperature", "x" };
+        AGENT_DATA_TYPE temperature;
+        AGENT_DATA_TYPE x;
+        AGENT_DATA_TYPE position;
+        COMPLEX_TYPE_FIELD_TYPE field;
+        temperature.type = EDM_INT32_TYPE;
+        temperature.value.edmInt32.value = 20;
+        x.type = EDM_INT32_TYPE;
+        x.value.edmInt32.value = 2;
+        field.fieldName = "x";
+        field.value = &x;
+        position.type = EDM_COMPLEX_TYPE_TYPE;
+        position.value.edmComplexType.nMembers = 1;
+        position.value.edmComplexType.fields = &field;
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "Temperature", &temperature);
+        (void)MultiTree_AddLeaf(tree, "p", &position);
+        const unsigned char expected[] =
+        {
+            0xA2,
+            0x00, 0x14,                   /*0: 20*/
+            0x61, 'p', 0xA1, 0x01, 0x02   /*"p": {1: 2}*/
+        };
+
+        ///act + assert
+        assert_encoding(tree, keys, sizeof(keys) / sizeof(keys[0]), expected, sizeof(expected));
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_009: [ Values of any other type (dates, GUIDs, decimals, geography etc) shall be converted by AgentDataTypes_ToString and encoded as a text string without the enclosing JSON quotes. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_encodes_other_types_as_text)
+    {
+        ///arrange
+        AGENT_DATA_TYPE date;
+        date.type = EDM_DATE_TYPE;
+        date.value.edmDate.year = 2017;
+        date.value.edmDate.month = 1;
+        date.value.edmDate.day = 1;
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "d", &date);
+        const unsigned char expected[] =
+        {
+            0xA1,
+            0x61, 'd', 0x6A, '2', '0', '1', '7', '-', '0', '1', '-', '0', '1'
+        };
+
+        STRICT_EXPECTED_CALL(AgentDataTypes_ToString(IGNORED_PTR_ARG, &date))
+            .IgnoreArgument_destination();
+
+        ///act + assert
+        assert_encoding(tree, NULL, 0, expected, sizeof(expected));
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_003: [ If any failure occurs, CBOREncoder_EncodeTree shall fail, free any memory it allocated and return a value different from CBOR_ENCODER_OK. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_when_AgentDataTypes_ToString_fails_it_fails)
+    {
+        ///arrange
+        AGENT_DATA_TYPE date;
+        date.type = EDM_DATE_TYPE;
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "d", &date);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+
+        STRICT_EXPECTED_CALL(AgentDataTypes_ToString(IGNORED_PTR_ARG, &date))
+            .IgnoreArgument_destination()
+            .SetReturn(AGENT_DATA_TYPES_ERROR);
+
+        ///act
+        CBOR_ENCODER_RESULT result = CBOREncoder_EncodeTree(tree, NULL, 0, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CBOR_ENCODER_RESULT, CBOR_ENCODER_AGENT_DATA_TYPES_ERROR, result);
+        ASSERT_IS_NULL(destination);
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+    /*Tests_SRS_CBOR_ENCODER_02_003: [ If any failure occurs, CBOREncoder_EncodeTree shall fail, free any memory it allocated and return a value different from CBOR_ENCODER_OK. ]*/
+    TEST_FUNCTION(CBOREncoder_EncodeTree_when_growing_the_output_fails_it_fails)
+    {
+        ///arrange
+        char longText[200];
+        AGENT_DATA_TYPE text;
+        (void)memset(longText, 'a', sizeof(longText));
+        text.type = EDM_STRING_TYPE;
+        text.value.edmString.chars = longText;
+        text.value.edmString.length = sizeof(longText);
+        MULTITREE_HANDLE tree = MultiTree_Create(NoCloneFunction, NoFreeFunction);
+        (void)MultiTree_AddLeaf(tree, "t", &text);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+        g_failReallocOfAtLeast = 128; /*the first 64 bytes can be allocated, the string does not fit in them*/
+
+        ///act
+        CBOR_ENCODER_RESULT result = CBOREncoder_EncodeTree(tree, NULL, 0, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CBOR_ENCODER_RESULT, CBOR_ENCODER_ERROR, result);
+        ASSERT_IS_NULL(destination);
+
+        ///cleanup
+        MultiTree_Destroy(tree);
+    }
+
+END_TEST_SUITE(CBOREncoder_ut)
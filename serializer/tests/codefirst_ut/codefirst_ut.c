@@ -422,7 +422,8 @@ static int EDM_BINARY_Compare(EDM_BINARY e, EDM_BINARY fe)
 
 static AGENT_DATA_TYPES_RESULT my_Create_AGENT_DATA_TYPE_from_DOUBLE(AGENT_DATA_TYPE* agentData, double v)
 {
-    (void)v;
+    agentData->type = EDM_DOUBLE_TYPE;
+    agentData->value.edmDouble.value = v;
     Create_AGENT_DATA_TYPE_from_DOUBLE_agentData = agentData;
     return AGENT_DATA_TYPES_OK;
 }
@@ -496,11 +497,31 @@ static void my_Destroy_AGENT_DATA_TYPE(AGENT_DATA_TYPE* agentData)
 
 static AGENT_DATA_TYPES_RESULT my_Create_AGENT_DATA_TYPE_from_SINT32(AGENT_DATA_TYPE* agentData, int32_t v)
 {
-    (void)(v);
+    agentData->type = EDM_INT32_TYPE;
+    agentData->value.edmInt32.value = v;
     Create_AGENT_DATA_TYPE_from_SINT32_agentData = agentData;
     return AGENT_DATA_TYPES_OK;
 }
 
+/*only knows the types the reported properties of SimpleDevice_Model have*/
+static AGENT_DATA_TYPES_RESULT my_AgentDataTypes_ToString(STRING_HANDLE destination, const AGENT_DATA_TYPE* value)
+{
+    char temp[64];
+    if (value->type == EDM_DOUBLE_TYPE)
+    {
+        (void)sprintf(temp, "%f", value->value.edmDouble.value);
+    }
+    else if (value->type == EDM_INT32_TYPE)
+    {
+        (void)sprintf(temp, "%" PRId32, value->value.edmInt32.value);
+    }
+    else
+    {
+        temp[0] = '\0';
+    }
+    return (real_STRING_concat(destination, temp) == 0) ? AGENT_DATA_TYPES_OK : AGENT_DATA_TYPES_ERROR;
+}
+
 static void* toBeCleaned = NULL; /*this variable exists because bad semantics in _CancelTransaction/EndTransaction.*/
 static TRANSACTION_HANDLE my_Device_StartTransaction(DEVICE_HANDLE deviceHandle)
 {
@@ -806,6 +827,9 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         
         REGISTER_GLOBAL_MOCK_HOOK(Schema_GetModelDesiredPropertyCount, my_Schema_GetModelDesiredPropertyCount);
         REGISTER_GLOBAL_MOCK_HOOK(Schema_GetModelModelCount, my_Schema_GetModelModelCount);
+
+        REGISTER_GLOBAL_MOCK_HOOK(AgentDataTypes_ToString, my_AgentDataTypes_ToString);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(AgentDataTypes_ToString, AGENT_DATA_TYPES_ERROR);
         
         
     }
@@ -3863,6 +3887,328 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         CodeFirst_Deinit();
     }
 
+    /*Tests_SRS_CODEFIRST_02_065: [ If destination, destinationSize or device is NULL then CodeFirst_SendAsyncReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_with_NULL_device_fails)
+    {
+        ///arrange
+        unsigned char* destination;
+        size_t destinationSize;
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_CODEFIRST_02_065: [ If destination, destinationSize or device is NULL then CodeFirst_SendAsyncReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_with_NULL_destination_fails)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        size_t destinationSize;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        umock_c_reset_all_calls();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(NULL, &destinationSize, device);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_066: [ If device is not a complete model instance created by CodeFirst_CreateDevice then CodeFirst_SendAsyncReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_with_a_reported_property_instead_of_device_fails)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        unsigned char* destination;
+        size_t destinationSize;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        umock_c_reset_all_calls();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, &device->new_reported_this_is_double);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    static void CodeFirst_SendAsyncReportedDelta_hash_inert_path(void)
+    {
+        STRICT_EXPECTED_CALL(STRING_new());
+        STRICT_EXPECTED_CALL(AgentDataTypes_ToString(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_destination()
+            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+    }
+
+    static void CodeFirst_SendAsyncReportedDelta_all_inert_path(void)
+    {
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
+
+        STRICT_EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 5.5))
+            .IgnoreArgument_agentData();
+        CodeFirst_SendAsyncReportedDelta_hash_inert_path();
+        STRICT_EXPECTED_CALL(Device_CreateTransaction_ReportedProperties(TEST_DEVICE_HANDLE));
+        STRICT_EXPECTED_CALL(Device_PublishTransacted_ReportedProperty(IGNORED_PTR_ARG, "new_reported_this_is_double", IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument_data();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        STRICT_EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, -5))
+            .IgnoreArgument_agentData();
+        CodeFirst_SendAsyncReportedDelta_hash_inert_path();
+        STRICT_EXPECTED_CALL(Device_PublishTransacted_ReportedProperty(IGNORED_PTR_ARG, "new_reported_this_is_int", IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument_data();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        STRICT_EXPECTED_CALL(Device_CommitTransaction_ReportedProperties(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+
+        STRICT_EXPECTED_CALL(Device_DestroyTransaction_ReportedProperties(IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_067: [ CodeFirst_SendAsyncReportedDelta shall convert every reported property of the device to AGENT_DATA_TYPE and compute a hash of its JSON representation. ]*/
+    /*Tests_SRS_CODEFIRST_02_069: [ CodeFirst_SendAsyncReportedDelta shall publish all the other reported properties in one transaction created by Device_CreateTransaction_ReportedProperties and committed by Device_CommitTransaction_ReportedProperties, and shall remember their hashes as in flight. ]*/
+    /*Tests_SRS_CODEFIRST_02_071: [ Otherwise CodeFirst_SendAsyncReportedDelta shall return CODEFIRST_OK. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_the_first_time_sends_all_reported_properties)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        umock_c_reset_all_calls();
+
+        device->new_reported_this_is_double = 5.5;
+        device->new_reported_this_is_int = -5;
+
+        CodeFirst_SendAsyncReportedDelta_all_inert_path();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_072: [ If any error occurs, CodeFirst_SendAsyncReportedDelta shall fail, consider no reported property in flight and return a value different from CODEFIRST_OK. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_unhappy_paths)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        (void)umock_c_negative_tests_init();
+        umock_c_reset_all_calls();
+
+        device->new_reported_this_is_double = 5.5;
+        device->new_reported_this_is_int = -5;
+
+        CodeFirst_SendAsyncReportedDelta_all_inert_path();
+
+        umock_c_negative_tests_snapshot();
+
+        size_t calls_that_cannot_fail[] =
+        {
+            0, /*Schema_GetModelName*/
+            4, /*STRING_c_str*/
+            5, /*STRING_delete*/
+            8, /*Destroy_AGENT_DATA_TYPE*/
+            12, /*STRING_c_str*/
+            13, /*STRING_delete*/
+            15, /*Destroy_AGENT_DATA_TYPE*/
+            17, /*Device_DestroyTransaction_ReportedProperties*/
+        };
+
+        for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
+        {
+            size_t j;
+            for (j = 0; j < sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]); j++) /*not running the tests that cannot fail*/
+            {
+                if (calls_that_cannot_fail[j] == i)
+                    break;
+            }
+
+            if (j == sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
+            {
+                umock_c_negative_tests_reset();
+                umock_c_negative_tests_fail_call(i);
+                char temp_str[128];
+                sprintf(temp_str, "On failed call %zu", i);
+
+                ///act
+                CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+
+                ///assert
+                ASSERT_ARE_NOT_EQUAL_WITH_MSG(CODEFIRST_RESULT, CODEFIRST_OK, result, temp_str);
+            }
+        }
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        umock_c_negative_tests_deinit();
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_068: [ CodeFirst_SendAsyncReportedDelta shall skip the reported properties whose hash is the same as the hash of the last acknowledged value. ]*/
+    /*Tests_SRS_CODEFIRST_02_074: [ If isAcknowledged is true then CodeFirst_CompleteReportedDelta shall make the hashes in flight the last acknowledged hashes. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_after_acknowledge_sends_only_the_changed_reported_properties)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        device->new_reported_this_is_double = 5.5;
+        device->new_reported_this_is_int = -5;
+        (void)CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+        (void)CodeFirst_CompleteReportedDelta(device, true);
+        umock_c_reset_all_calls();
+
+        device->new_reported_this_is_int = 7;
+
+        STRICT_EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 5.5))
+            .IgnoreArgument_agentData();
+        CodeFirst_SendAsyncReportedDelta_hash_inert_path();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        STRICT_EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, 7))
+            .IgnoreArgument_agentData();
+        CodeFirst_SendAsyncReportedDelta_hash_inert_path();
+        STRICT_EXPECTED_CALL(Device_CreateTransaction_ReportedProperties(TEST_DEVICE_HANDLE));
+        STRICT_EXPECTED_CALL(Device_PublishTransacted_ReportedProperty(IGNORED_PTR_ARG, "new_reported_this_is_int", IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument_data();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        STRICT_EXPECTED_CALL(Device_CommitTransaction_ReportedProperties(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+
+        STRICT_EXPECTED_CALL(Device_DestroyTransaction_ReportedProperties(IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_070: [ If no reported property changed then CodeFirst_SendAsyncReportedDelta shall set *destination to NULL, *destinationSize to 0 and return CODEFIRST_OK. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_when_nothing_changed_sets_destination_to_NULL)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        device->new_reported_this_is_double = 5.5;
+        device->new_reported_this_is_int = -5;
+        (void)CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+        (void)CodeFirst_CompleteReportedDelta(device, true);
+        umock_c_reset_all_calls();
+
+        destination = (unsigned char*)&destinationSize; /*anything not NULL*/
+        destinationSize = 1;
+
+        STRICT_EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 5.5))
+            .IgnoreArgument_agentData();
+        CodeFirst_SendAsyncReportedDelta_hash_inert_path();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        STRICT_EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, -5))
+            .IgnoreArgument_agentData();
+        CodeFirst_SendAsyncReportedDelta_hash_inert_path();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_IS_NULL(destination);
+        ASSERT_ARE_EQUAL(size_t, 0, destinationSize);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_075: [ CodeFirst_CompleteReportedDelta shall consider no reported property in flight and return CODEFIRST_OK. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsyncReportedDelta_after_not_acknowledged_sends_all_again)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        unsigned char* destination = NULL;
+        size_t destinationSize = 0;
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        device->new_reported_this_is_double = 5.5;
+        device->new_reported_this_is_int = -5;
+        (void)CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+        umock_c_reset_all_calls();
+
+        ///act
+        CODEFIRST_RESULT result1 = CodeFirst_CompleteReportedDelta(device, false);
+        CODEFIRST_RESULT result2 = CodeFirst_SendAsyncReportedDelta(&destination, &destinationSize, device);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result1);
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result2);
+        ASSERT_IS_TRUE(strstr(umock_c_get_actual_calls(), "new_reported_this_is_double") != NULL);
+        ASSERT_IS_TRUE(strstr(umock_c_get_actual_calls(), "new_reported_this_is_int") != NULL);
+
+        ///cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_02_073: [ If device is NULL or it is not a complete model instance created by CodeFirst_CreateDevice then CodeFirst_CompleteReportedDelta shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    TEST_FUNCTION(CodeFirst_CompleteReportedDelta_with_NULL_device_fails)
+    {
+        ///arrange
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_CompleteReportedDelta(NULL, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     /*Tests_SRS_CODEFIRST_02_030: [ If argument device is NULL then CodeFirst_IngestDesiredProperties shall fail and return CODEFIRST_INVALID_ARG. ]*/
     TEST_FUNCTION(CodeFirst_IngestDesiredProperties_with_NULL_device_fails)
     {
@@ -194,6 +194,72 @@ static JSON_DECODER_RESULT my_JSONDecoder_JSON_To_MultiTree(char* json, MULTITRE
     return JSON_DECODER_OK;
 }
 
+/*JSONDecoder_JSON_To_Events is mocked, the hook below replays the events of the JSON used by the test*/
+typedef enum TEST_JSON_EVENT_TYPE_TAG
+{
+    TEST_JSON_BEGIN_OBJECT,
+    TEST_JSON_END_OBJECT,
+    TEST_JSON_VALUE
+} TEST_JSON_EVENT_TYPE;
+
+typedef struct TEST_JSON_EVENT_TAG
+{
+    TEST_JSON_EVENT_TYPE type;
+    const char* name;
+    const char* value;
+} TEST_JSON_EVENT;
+
+static const TEST_JSON_EVENT* g_testJsonEvents;
+static size_t g_nTestJsonEvents;
+
+static JSON_DECODER_RESULT my_JSONDecoder_JSON_To_Events(char* json, const JSON_DECODER_EVENTS* events, void* context)
+{
+    JSON_DECODER_RESULT result = JSON_DECODER_OK;
+    size_t skipDepth = 0;
+    (void)json;
+    for (size_t i = 0; (i < g_nTestJsonEvents) && (result == JSON_DECODER_OK); i++)
+    {
+        const TEST_JSON_EVENT* e = &g_testJsonEvents[i];
+        JSON_DECODER_EVENT_RESULT eventResult = JSON_DECODER_EVENT_CONTINUE;
+        if (skipDepth > 0)
+        {
+            if (e->type == TEST_JSON_BEGIN_OBJECT)
+            {
+                skipDepth++;
+            }
+            else if (e->type == TEST_JSON_END_OBJECT)
+            {
+                skipDepth--;
+            }
+        }
+        else if (e->type == TEST_JSON_BEGIN_OBJECT)
+        {
+            eventResult = events->onBeginObject(context, e->name);
+            if (eventResult == JSON_DECODER_EVENT_SKIP_CHILDREN)
+            {
+                skipDepth = 1;
+                eventResult = JSON_DECODER_EVENT_CONTINUE;
+            }
+        }
+        else if (e->type == TEST_JSON_END_OBJECT)
+        {
+            eventResult = events->onEndObject(context, e->name);
+        }
+        else
+        {
+            eventResult = events->onValue(context, e->name, e->value);
+        }
+
+        if (eventResult != JSON_DECODER_EVENT_CONTINUE)
+        {
+            result = JSON_DECODER_ABORTED;
+        }
+    }
+    return result;
+}
+
+#define SET_TEST_JSON_EVENTS(events) g_testJsonEvents = (events); g_nTestJsonEvents = sizeof(events) / sizeof((events)[0]);
+
 static void my_MultiTree_Destroy(MULTITREE_HANDLE treeHandle)
 {
     (void)(treeHandle);
@@ -318,6 +384,7 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         REGISTER_UMOCK_ALIAS_TYPE(SCHEMA_DESIRED_PROPERTY_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(pfDesiredPropertyFromAGENT_DATA_TYPE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(pfOnDesiredProperty, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(const JSON_DECODER_EVENTS*, void*);
         REGISTER_UMOCK_ALIAS_TYPE(SCHEMA_METHOD_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(SCHEMA_METHOD_ARGUMENT_HANDLE, void*);
         
@@ -339,6 +406,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
         REGISTER_GLOBAL_MOCK_HOOK(JSONDecoder_JSON_To_MultiTree, my_JSONDecoder_JSON_To_MultiTree);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_JSON_To_MultiTree, JSON_DECODER_ERROR);
+        REGISTER_GLOBAL_MOCK_HOOK(JSONDecoder_JSON_To_Events, my_JSONDecoder_JSON_To_Events);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(JSONDecoder_JSON_To_Events, JSON_DECODER_PARSE_ERROR);
         REGISTER_GLOBAL_MOCK_HOOK(MultiTree_Destroy, my_MultiTree_Destroy);
         
         REGISTER_GLOBAL_MOCK_HOOK(Create_AGENT_DATA_TYPE_from_Members, my_Create_AGENT_DATA_TYPE_from_Members);
@@ -3447,6 +3516,317 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
     }
     
+    static const TEST_JSON_EVENT full_twin_events[] =
+    {
+        { TEST_JSON_BEGIN_OBJECT, "desired", NULL },
+        { TEST_JSON_VALUE, "int_field", "3" },
+        { TEST_JSON_VALUE, "$version", "4" },
+        { TEST_JSON_END_OBJECT, "desired", NULL },
+        { TEST_JSON_BEGIN_OBJECT, "reported", NULL },
+        { TEST_JSON_VALUE, "int_field", "5" },
+        { TEST_JSON_END_OBJECT, "reported", NULL },
+        { TEST_JSON_VALUE, "$version", "7" }
+    };
+
+    static void CommandDecoder_IngestDesiredProperties_full_twin_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, bool desiredPropertyHasCallback)
+    {
+        SET_TEST_JSON_EVENTS(full_twin_events);
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .IgnoreArgument_destination();
+
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_Events(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_json()
+            .IgnoreArgument_events()
+            .IgnoreArgument_context();
+
+        /*decoding "desired"*/
+
+        STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "int_field"))
+            .SetReturn(Schema_GetModelElementByName_desiredProperty_int_field);
+
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredPropertyType(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn("int");
+
+        STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+            .SetReturn(EDM_INT32_TYPE);
+
+        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData()
+            .SetReturn(AGENT_DATA_TYPES_OK);
+
+        /*applying "desired" once the JSON has been decoded*/
+
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(int_pfDesiredPropertyFromAGENT_DATA_TYPE);
+
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_offset(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(2);
+
+        STRICT_EXPECTED_CALL(int_pfDesiredPropertyFromAGENT_DATA_TYPE(IGNORED_PTR_ARG, (unsigned char*)deviceMemoryArea + 2))
+            .IgnoreArgument_source();
+
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfOnDesiredProperty(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(desiredPropertyHasCallback ? onDesiredPropertySimpleProperty : NULL);
+
+        if (desiredPropertyHasCallback)
+        {
+            STRICT_EXPECTED_CALL(onDesiredPropertySimpleProperty(deviceMemoryArea));
+        }
+
+        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData();
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_014: [ If parseDesiredNode is TRUE, parse only the `desired` part of JSON tree ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_015: [ Remove '$version' string from node, if it is present.  It not being present is not an error ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_026: [ Members of the JSON that are not ingested (including everything outside of desired) shall be skipped without being materialized. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_028: [ If removedDesiredNode is TRUE, CommandDecoder_IngestDesiredProperties shall decode the clone of jsonPayload with JSONDecoder_JSON_To_Events instead of creating a MULTITREE. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_029: [ The members of desired shall be matched against the model as in the MULTITREE case (desired properties, models in model and $version). ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_030: [ The desired properties shall be constructed in memory and the pfOnDesiredProperty callbacks shall be called only after the JSON has been decoded and only if all the members of desired could be ingested, so that a TWIN that fails does not change the device. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_full_twin_happy_path)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"desired\":{\"int_field\":3,\"$version\":4},\"reported\":{\"int_field\":5},\"$version\":7}";
+
+        CommandDecoder_IngestDesiredProperties_full_twin_inert_path(deviceMemoryArea, desiredPropertiesJSON, true);
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_011: [ Otherwise CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_FAILED. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_031: [ If the JSON does not have a desired object, or if decoding it fails, then CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_full_twin_unhappy_paths)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"desired\":{\"int_field\":3,\"$version\":4},\"reported\":{\"int_field\":5},\"$version\":7}";
+        (void)umock_c_negative_tests_init();
+        umock_c_reset_all_calls();
+
+        CommandDecoder_IngestDesiredProperties_full_twin_inert_path(deviceMemoryArea, desiredPropertiesJSON, false);
+
+        umock_c_negative_tests_snapshot();
+
+        size_t calls_that_cannot_fail[] =
+        {
+            3, /*Schema_GetModelDesiredPropertyType*/
+            4, /*CodeFirst_GetPrimitiveType*/
+            6, /*Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE*/
+            7, /*Schema_GetModelDesiredProperty_offset*/
+            9, /*Schema_GetModelDesiredProperty_pfOnDesiredProperty*/
+            10, /*Destroy_AGENT_DATA_TYPE*/
+            11 /*gballoc_free*/
+        };
+
+        for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
+        {
+            size_t j;
+            umock_c_negative_tests_reset();
+
+            for (j = 0;j<sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++) /*not running the tests that cannot fail*/
+            {
+                if (calls_that_cannot_fail[j] == i)
+                    break;
+            }
+
+            if (j == sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
+            {
+
+                umock_c_negative_tests_fail_call(i);
+                char temp_str[128];
+                sprintf(temp_str, "On failed call %zu", i);
+
+                ///act
+                EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+                ///assert
+                ASSERT_ARE_NOT_EQUAL_WITH_MSG(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result, temp_str);
+            }
+        }
+
+        umock_c_negative_tests_deinit();
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_012: [ If the child model in model has a non-NULL pfOnDesiredProperty then pfOnDesiredProperty shall be called. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_030: [ The desired properties shall be constructed in memory and the pfOnDesiredProperty callbacks shall be called only after the JSON has been decoded and only if all the members of desired could be ingested, so that a TWIN that fails does not change the device. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_full_twin_with_model_in_model_calls_onDesiredProperty_happy_path)
+    {
+        ///arrange
+        static const TEST_JSON_EVENT model_in_model_events[] =
+        {
+            { TEST_JSON_BEGIN_OBJECT, "desired", NULL },
+            { TEST_JSON_BEGIN_OBJECT, "modelInModel", NULL },
+            { TEST_JSON_VALUE, "int_field", "3" },
+            { TEST_JSON_END_OBJECT, "modelInModel", NULL },
+            { TEST_JSON_END_OBJECT, "desired", NULL }
+        };
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"desired\":{\"modelInModel\":{\"int_field\":3}}}";
+        SET_TEST_JSON_EVENTS(model_in_model_events);
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_Events(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_json()
+            .IgnoreArgument_events()
+            .IgnoreArgument_context();
+
+        /*decoding "desired"*/
+        STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "modelInModel"))
+            .SetReturn(Schema_GetModelElementByName_modelInModel);
+        STRICT_EXPECTED_CALL(Schema_GetModelModelByName_Offset(TEST_MODEL_HANDLE, "modelInModel"))
+            .SetReturn(10);
+        STRICT_EXPECTED_CALL(Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE_MODEL_IN_MODEL, "int_field"))
+            .SetReturn(Schema_GetModelElementByName_desiredProperty_int_field);
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredPropertyType(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn("int");
+        STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+            .SetReturn(EDM_INT32_TYPE);
+        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData()
+            .SetReturn(AGENT_DATA_TYPES_OK);
+        STRICT_EXPECTED_CALL(Schema_GetModelModelByName_OnDesiredProperty(TEST_MODEL_HANDLE, "modelInModel"))
+            .SetReturn(onDesiredPropertyModelInModel);
+
+        /*applying "desired": the model in model is notified after its desired properties*/
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(int_pfDesiredPropertyFromAGENT_DATA_TYPE);
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_offset(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(2);
+        STRICT_EXPECTED_CALL(int_pfDesiredPropertyFromAGENT_DATA_TYPE(IGNORED_PTR_ARG, (unsigned char*)deviceMemoryArea + 12)) /*notice here the new offset (2+10)*/
+            .IgnoreArgument_source();
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredProperty_pfOnDesiredProperty(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn(onDesiredPropertySimpleProperty);
+        STRICT_EXPECTED_CALL(onDesiredPropertySimpleProperty((unsigned char*)deviceMemoryArea + 10));
+        STRICT_EXPECTED_CALL(onDesiredPropertyModelInModel(deviceMemoryArea));
+        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_026: [ Members of the JSON that are not ingested (including everything outside of desired) shall be skipped without being materialized. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_030: [ The desired properties shall be constructed in memory and the pfOnDesiredProperty callbacks shall be called only after the JSON has been decoded and only if all the members of desired could be ingested, so that a TWIN that fails does not change the device. ]*/
+    /*Tests_SRS_COMMAND_DECODER_02_011: [ Otherwise CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_FAILED. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_full_twin_with_unknown_member_applies_nothing)
+    {
+        ///arrange
+        static const TEST_JSON_EVENT unknown_member_events[] =
+        {
+            { TEST_JSON_BEGIN_OBJECT, "desired", NULL },
+            { TEST_JSON_VALUE, "int_field", "3" },
+            { TEST_JSON_BEGIN_OBJECT, "unknown", NULL },
+            { TEST_JSON_VALUE, "a", "1" },
+            { TEST_JSON_END_OBJECT, "unknown", NULL },
+            { TEST_JSON_END_OBJECT, "desired", NULL }
+        };
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"desired\":{\"int_field\":3,\"unknown\":{\"a\":1}}}";
+        SET_TEST_JSON_EVENTS(unknown_member_events);
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_Events(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_json()
+            .IgnoreArgument_events()
+            .IgnoreArgument_context();
+        STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "int_field"))
+            .SetReturn(Schema_GetModelElementByName_desiredProperty_int_field);
+        STRICT_EXPECTED_CALL(Schema_GetModelDesiredPropertyType(TEST_DESIRED_PROPERTY_HANDLE_INT_FIELD))
+            .SetReturn("int");
+        STRICT_EXPECTED_CALL(CodeFirst_GetPrimitiveType("int"))
+            .SetReturn(EDM_INT32_TYPE);
+        STRICT_EXPECTED_CALL(CreateAgentDataType_From_String("3", EDM_INT32_TYPE, IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData()
+            .SetReturn(AGENT_DATA_TYPES_OK);
+        STRICT_EXPECTED_CALL(Schema_GetModelElementByName(TEST_MODEL_HANDLE, "unknown"))
+            .SetReturn(Schema_GetModelElementByName_notFound);
+        /*int_field has been decoded, but it is not written to the device*/
+        STRICT_EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG))
+            .IgnoreArgument_agentData();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_FAILED, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_02_031: [ If the JSON does not have a desired object, or if decoding it fails, then CommandDecoder_IngestDesiredProperties shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_full_twin_without_desired_fails)
+    {
+        ///arrange
+        static const TEST_JSON_EVENT no_desired_events[] =
+        {
+            { TEST_JSON_BEGIN_OBJECT, "reported", NULL },
+            { TEST_JSON_VALUE, "int_field", "5" },
+            { TEST_JSON_END_OBJECT, "reported", NULL }
+        };
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"reported\":{\"int_field\":5}}";
+        SET_TEST_JSON_EVENTS(no_desired_events);
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_Events(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_json()
+            .IgnoreArgument_events()
+            .IgnoreArgument_context();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
     /*Tests_SRS_COMMAND_DECODER_02_014: [ If handle is NULL then CommandDecoder_ExecuteMethod shall fail and return NULL. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_NULL_handle_fails)
     {
@@ -30,6 +30,7 @@ static void my_gballoc_free(void* s)
 
 #define ENABLE_MOCKS
 #include "jsonencoder.h"
+#include "cborencoder.h"
 #include "multitree.h"
 #include "schema.h"
 #include "azure_c_shared_utility/optimize_size.h"
@@ -132,6 +133,9 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(MULTITREE_RESULT, MULTITREE_RESULT_VALUES);
 TEST_DEFINE_ENUM_TYPE(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT_VALUES);
 
+TEST_DEFINE_ENUM_TYPE(CBOR_ENCODER_RESULT, CBOR_ENCODER_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(CBOR_ENCODER_RESULT, CBOR_ENCODER_RESULT_VALUES);
+
 #define DEFAULT_PROPERTY_NAME_2 "blahBlah"
 
 static MULTITREE_HANDLE my_MultiTree_Create(MULTITREE_CLONE_FUNCTION cloneFunction, MULTITREE_FREE_FUNCTION freeFunction)
@@ -163,6 +167,17 @@ static AGENT_DATA_TYPES_RESULT my_AgentDataTypes_ToString(STRING_HANDLE destinat
     return AGENT_DATA_TYPES_OK;
 }
 
+static CBOR_ENCODER_RESULT my_CBOREncoder_EncodeTree(MULTITREE_HANDLE treeHandle, const char* const* keys, size_t keyCount, unsigned char** destination, size_t* destinationSize)
+{
+    (void)treeHandle;
+    (void)keys;
+    (void)keyCount;
+    *destination = (unsigned char*)my_gballoc_malloc(1);
+    **destination = 0xA0; /*empty CBOR map*/
+    *destinationSize = 1;
+    return CBOR_ENCODER_OK;
+}
+
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
     char temp_str[256];
@@ -206,9 +221,12 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         REGISTER_UMOCK_ALIAS_TYPE(MULTITREE_RESULT, int);
         REGISTER_UMOCK_ALIAS_TYPE(DATA_MARSHALLER_RESULT, int);
         REGISTER_UMOCK_ALIAS_TYPE(JSON_ENCODER_RESULT, int);
+        REGISTER_UMOCK_ALIAS_TYPE(CBOR_ENCODER_RESULT, int);
             
         REGISTER_GLOBAL_MOCK_HOOK(MultiTree_Create, my_MultiTree_Create);
         REGISTER_GLOBAL_MOCK_HOOK(MultiTree_Destroy, my_MultiTree_Destroy);
+        REGISTER_GLOBAL_MOCK_HOOK(CBOREncoder_EncodeTree, my_CBOREncoder_EncodeTree);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(CBOREncoder_EncodeTree, CBOR_ENCODER_ERROR);
 
         REGISTER_STRING_GLOBAL_MOCK_HOOK;
 
@@ -271,6 +289,8 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
 
     TEST_FUNCTION_CLEANUP(TestMethodCleanup)
     {
+        DataMarshaller_SetDefaultEncoder(NULL);
+        DataMarshaller_SetDefaultKeyDictionary(NULL);
         TEST_MUTEX_RELEASE(g_testByTest);
     }
 
@@ -1020,6 +1040,201 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DataMarshaller_Destroy(handle);
     }
 
+    /*Tests_SRS_DATA_MARSHALLER_02_022: [ DataMarshaller_GetJSONEncoder shall return an encoder having the content type "application/json", the content encoding "utf-8" and encoding the tree with JSONEncoder_EncodeTree. ]*/
+    TEST_FUNCTION(DataMarshaller_GetJSONEncoder_returns_the_JSON_content_type)
+    {
+        ///act
+        const DATA_MARSHALLER_ENCODER* encoder = DataMarshaller_GetJSONEncoder();
+
+        ///assert
+        ASSERT_IS_NOT_NULL(encoder);
+        ASSERT_ARE_EQUAL(char_ptr, "application/json", encoder->contentType);
+        ASSERT_ARE_EQUAL(char_ptr, "utf-8", encoder->contentEncoding);
+        ASSERT_IS_NOT_NULL(encoder->encodeTree);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_023: [ DataMarshaller_GetCBOREncoder shall return an encoder having the content type "application/cbor", no content encoding and encoding the tree with CBOREncoder_EncodeTree. ]*/
+    TEST_FUNCTION(DataMarshaller_GetCBOREncoder_returns_the_CBOR_content_type)
+    {
+        ///act
+        const DATA_MARSHALLER_ENCODER* encoder = DataMarshaller_GetCBOREncoder();
+
+        ///assert
+        ASSERT_IS_NOT_NULL(encoder);
+        ASSERT_ARE_EQUAL(char_ptr, "application/cbor", encoder->contentType);
+        ASSERT_IS_NULL(encoder->contentEncoding);
+        ASSERT_IS_NOT_NULL(encoder->encodeTree);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_028: [ If dataMarshallerHandle is NULL then DataMarshaller_GetEncoder shall return NULL. ]*/
+    TEST_FUNCTION(DataMarshaller_GetEncoder_with_NULL_handle_returns_NULL)
+    {
+        ///act
+        const DATA_MARSHALLER_ENCODER* encoder = DataMarshaller_GetEncoder(NULL);
+
+        ///assert
+        ASSERT_IS_NULL(encoder);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_026: [ DataMarshaller_Create shall use the default encoder and the default key dictionary in effect at the time of the call. ]*/
+    /*Tests_SRS_DATA_MARSHALLER_02_031: [ Otherwise DataMarshaller_GetEncoder shall return the encoder used by the instance. ]*/
+    TEST_FUNCTION(DataMarshaller_Create_uses_JSON_by_default)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+
+        ///act
+        const DATA_MARSHALLER_ENCODER* encoder = DataMarshaller_GetEncoder(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(void_ptr, (void_ptr)DataMarshaller_GetJSONEncoder(), (void_ptr)encoder);
+
+        ///cleanup
+        DataMarshaller_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_024: [ DataMarshaller_SetDefaultEncoder shall set the encoder used by any new instance of DataMarshaller. If encoder is NULL or has a NULL encodeTree then the JSON encoder shall be used. ]*/
+    /*Tests_SRS_DATA_MARSHALLER_02_026: [ DataMarshaller_Create shall use the default encoder and the default key dictionary in effect at the time of the call. ]*/
+    TEST_FUNCTION(DataMarshaller_SetDefaultEncoder_only_affects_instances_created_afterwards)
+    {
+        ///arrange
+        DATA_MARSHALLER_HANDLE jsonHandle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+        DataMarshaller_SetDefaultEncoder(DataMarshaller_GetCBOREncoder());
+        DATA_MARSHALLER_HANDLE cborHandle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+
+        ///act
+        const DATA_MARSHALLER_ENCODER* jsonEncoder = DataMarshaller_GetEncoder(jsonHandle);
+        const DATA_MARSHALLER_ENCODER* cborEncoder = DataMarshaller_GetEncoder(cborHandle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(void_ptr, (void_ptr)DataMarshaller_GetJSONEncoder(), (void_ptr)jsonEncoder);
+        ASSERT_ARE_EQUAL(void_ptr, (void_ptr)DataMarshaller_GetCBOREncoder(), (void_ptr)cborEncoder);
+
+        ///cleanup
+        DataMarshaller_Destroy(jsonHandle);
+        DataMarshaller_Destroy(cborHandle);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_024: [ DataMarshaller_SetDefaultEncoder shall set the encoder used by any new instance of DataMarshaller. If encoder is NULL or has a NULL encodeTree then the JSON encoder shall be used. ]*/
+    TEST_FUNCTION(DataMarshaller_SetDefaultEncoder_with_an_encoder_without_encodeTree_uses_JSON)
+    {
+        ///arrange
+        DATA_MARSHALLER_ENCODER incomplete = { "application/x-nothing", NULL, NULL };
+        DataMarshaller_SetDefaultEncoder(&incomplete);
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, false);
+
+        ///act
+        const DATA_MARSHALLER_ENCODER* encoder = DataMarshaller_GetEncoder(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(void_ptr, (void_ptr)DataMarshaller_GetJSONEncoder(), (void_ptr)encoder);
+
+        ///cleanup
+        DataMarshaller_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_027: [ DataMarshaller_SendData shall produce destination and destinationSize by calling the encodeTree function of the encoder of the instance. ]*/
+    /*Tests_SRS_DATA_MARSHALLER_02_029: [ The CBOR encoder shall call CBOREncoder_EncodeTree passing the keys of the key dictionary in effect (if any). ]*/
+    TEST_FUNCTION(DataMarshaller_SendData_with_the_CBOR_encoder_succeeds)
+    {
+        ///arrange
+        static const char* keys[] = { DEFAULT_PROPERTY_NAME, DEFAULT_PROPERTY_NAME_2 };
+        static const DATA_MARSHALLER_KEY_DICTIONARY keyDictionary = { keys, 2 };
+        DataMarshaller_SetDefaultEncoder(DataMarshaller_GetCBOREncoder());
+        DataMarshaller_SetDefaultKeyDictionary(&keyDictionary);
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &intValid } };
+
+        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME_2, &intValid))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(CBOREncoder_EncodeTree(IGNORED_PTR_ARG, keys, 2, &destination, &destinationSize))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle();
+
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 2, value, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 1, destinationSize);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        free(destination);
+        DataMarshaller_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_025: [ DataMarshaller_SetDefaultKeyDictionary shall set the key dictionary used by any new instance of DataMarshaller. A NULL keyDictionary or one without keys disables the dictionary. ]*/
+    TEST_FUNCTION(DataMarshaller_SendData_with_the_CBOR_encoder_and_an_empty_key_dictionary_passes_no_keys)
+    {
+        ///arrange
+        static const DATA_MARSHALLER_KEY_DICTIONARY emptyKeyDictionary = { NULL, 0 };
+        DataMarshaller_SetDefaultEncoder(DataMarshaller_GetCBOREncoder());
+        DataMarshaller_SetDefaultKeyDictionary(&emptyKeyDictionary);
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid } };
+
+        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(CBOREncoder_EncodeTree(IGNORED_PTR_ARG, NULL, 0, &destination, &destinationSize))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle();
+
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 1, value, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        free(destination);
+        DataMarshaller_Destroy(handle);
+    }
+
+    /*Tests_SRS_DATA_MARSHALLER_02_030: [ If CBOREncoder_EncodeTree fails then DataMarshaller_SendData shall fail and return DATA_MARSHALLER_CBOR_ENCODER_ERROR. ]*/
+    TEST_FUNCTION(DataMarshaller_SendData_when_CBOREncoder_EncodeTree_fails_it_fails)
+    {
+        ///arrange
+        DataMarshaller_SetDefaultEncoder(DataMarshaller_GetCBOREncoder());
+        DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+        DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid } };
+
+        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(CBOREncoder_EncodeTree(IGNORED_PTR_ARG, NULL, 0, &destination, &destinationSize))
+            .IgnoreArgument_treeHandle()
+            .SetReturn(CBOR_ENCODER_ERROR);
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle();
+
+        ///act
+        DATA_MARSHALLER_RESULT result = DataMarshaller_SendData(handle, 1, value, &destination, &destinationSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DATA_MARSHALLER_RESULT, DATA_MARSHALLER_CBOR_ENCODER_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        DataMarshaller_Destroy(handle);
+    }
+
     /*Tests_SRS_DATA_MARSHALLER_02_021: [ If argument dataMarshallerHandle is NULL then DataMarshaller_SendData_ReportedProperties shall fail and return DATA_MARSHALLER_INVALID_ARG. ]*/
     TEST_FUNCTION(DataMarshaller_SendData_ReportedProperties_with_NULL_dataMarshallerHandle_fails)
     {
@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_stdint.h"
+
+#include "fnv1a.h"
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+typedef struct TEST_VECTOR_TAG
+{
+    const char* data;
+    uint64_t hash;
+} TEST_VECTOR;
+
+/*test vectors of the FNV reference implementation*/
+static const TEST_VECTOR FNV1A_64_TEST_VECTORS[] =
+{
+    { "", 0xcbf29ce484222325ULL },
+    { "a", 0xaf63dc4c8601ec8cULL },
+    { "foobar", 0x85944171f73967e8ULL }
+};
+
+BEGIN_TEST_SUITE(FNV1a_ut)
+
+    TEST_SUITE_INITIALIZE(TestClassInitialize)
+    {
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+        (void)umocktypes_stdint_register_types();
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+        }
+
+        umock_c_reset_all_calls();
+    }
+
+    TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    /*Tests_SRS_FNV1A_02_001: [ FNV1a_Hash shall return the 64 bit FNV-1a hash of the first size bytes of data. ]*/
+    TEST_FUNCTION(FNV1a_Hash_test_vectors)
+    {
+        size_t i;
+        for (i = 0; i < sizeof(FNV1A_64_TEST_VECTORS) / sizeof(FNV1A_64_TEST_VECTORS[0]); i++)
+        {
+            ///act
+            uint64_t result = FNV1a_Hash(FNV1A_64_TEST_VECTORS[i].data, strlen(FNV1A_64_TEST_VECTORS[i].data));
+
+            ///assert
+            ASSERT_ARE_EQUAL(uint64_t, FNV1A_64_TEST_VECTORS[i].hash, result);
+        }
+    }
+
+    /*Tests_SRS_FNV1A_02_001: [ FNV1a_Hash shall return the 64 bit FNV-1a hash of the first size bytes of data. ]*/
+    TEST_FUNCTION(FNV1a_Hash_hashes_only_size_bytes)
+    {
+        ///arrange
+        const char data[] = "foobarbaz";
+
+        ///act
+        uint64_t result = FNV1a_Hash(data, 6);
+
+        ///assert
+        ASSERT_ARE_EQUAL(uint64_t, FNV1A_64_TEST_VECTORS[2].hash, result);
+    }
+
+    /*Tests_SRS_FNV1A_02_002: [ If data is NULL then FNV1a_Hash shall return the hash of zero bytes. ]*/
+    TEST_FUNCTION(FNV1a_Hash_with_NULL_data_returns_the_hash_of_zero_bytes)
+    {
+        ///act
+        uint64_t result = FNV1a_Hash(NULL, 3);
+
+        ///assert
+        ASSERT_ARE_EQUAL(uint64_t, FNV1A_64_TEST_VECTORS[0].hash, result);
+    }
+
+END_TEST_SUITE(FNV1a_ut)
@@ -2,6 +2,8 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <cstdlib>
+#include <cstring>
+#include <string>
 #include "testrunnerswitcher.h"
 #include "micromock.h"
 #include "micromockcharstararenullterminatedstrings.h"
@@ -42,7 +44,37 @@ MICROMOCK_ENUM_TO_STRING(JSON_DECODER_RESULT_TAG,
     L"JSON_DECODER_INVALID_ARG",
     L"JSON_DECODER_PARSE_ERROR",
     L"JSON_DECODER_MULTITREE_FAILED",
-    L"JSON_DECODER_ERROR");
+    L"JSON_DECODER_ERROR",
+    L"JSON_DECODER_ABORTED");
+
+/*the events reported by JSONDecoder_JSON_To_Events are recorded as text, one per line*/
+static std::string recordedEvents;
+static const char* skipObjectName;
+static const char* abortOnName;
+
+static JSON_DECODER_EVENT_RESULT recordOnBeginObject(void* context, const char* name)
+{
+    (void)context;
+    recordedEvents += std::string("begin ") + name + "\n";
+    return ((skipObjectName != NULL) && (strcmp(skipObjectName, name) == 0)) ? JSON_DECODER_EVENT_SKIP_CHILDREN :
+        ((abortOnName != NULL) && (strcmp(abortOnName, name) == 0)) ? JSON_DECODER_EVENT_ABORT : JSON_DECODER_EVENT_CONTINUE;
+}
+
+static JSON_DECODER_EVENT_RESULT recordOnEndObject(void* context, const char* name)
+{
+    (void)context;
+    recordedEvents += std::string("end ") + name + "\n";
+    return JSON_DECODER_EVENT_CONTINUE;
+}
+
+static JSON_DECODER_EVENT_RESULT recordOnValue(void* context, const char* name, const char* value)
+{
+    (void)context;
+    recordedEvents += std::string("value ") + name + "=" + value + "\n";
+    return ((abortOnName != NULL) && (strcmp(abortOnName, name) == 0)) ? JSON_DECODER_EVENT_ABORT : JSON_DECODER_EVENT_CONTINUE;
+}
+
+static const JSON_DECODER_EVENTS recordEvents = { recordOnBeginObject, recordOnEndObject, recordOnValue };
 
 static MICROMOCK_MUTEX_HANDLE g_testByTest;
 
@@ -58,6 +90,13 @@ TEST_SUITE_INITIALIZE(BeforeSuite)
     ASSERT_IS_NOT_NULL(g_testByTest);
 }
 
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    recordedEvents.clear();
+    skipObjectName = NULL;
+    abortOnName = NULL;
+}
+
 TEST_SUITE_CLEANUP(TestClassCleanup)
 {
     MicroMockDestroyMutex(g_testByTest);
@@ -2589,4 +2628,145 @@ TEST_FUNCTION(JSONDecoder_When_String_Has_Several_Escaped_Chars_Decoding_Succeed
     TestSpecialCharacter_Success(json);
 }
 
+/*Tests_SRS_JSON_DECODER_02_001: [ If json, events or any of the callbacks in events is NULL then JSONDecoder_JSON_To_Events shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_with_NULL_json_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(NULL, &recordEvents, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+}
+
+/*Tests_SRS_JSON_DECODER_02_001: [ If json, events or any of the callbacks in events is NULL then JSONDecoder_JSON_To_Events shall fail and return JSON_DECODER_INVALID_ARG. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_with_NULL_onValue_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{\"a\":1}";
+    JSON_DECODER_EVENTS events = { recordOnBeginObject, recordOnEndObject, NULL };
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &events, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_INVALID_ARG, result);
+}
+
+/*Tests_SRS_JSON_DECODER_02_002: [ JSONDecoder_JSON_To_Events shall parse json in a single pass, in place, without building a MULTITREE. ]*/
+/*Tests_SRS_JSON_DECODER_02_003: [ The members of the top level object (or array) shall be reported without a surrounding onBeginObject/onEndObject pair. ]*/
+/*Tests_SRS_JSON_DECODER_02_005: [ When an object or an array starts, JSONDecoder_JSON_To_Events shall call onBeginObject passing the member name (or the array index as string). ]*/
+/*Tests_SRS_JSON_DECODER_02_007: [ When an object or an array ends, JSONDecoder_JSON_To_Events shall call onEndObject passing the same name as onBeginObject. ]*/
+/*Tests_SRS_JSON_DECODER_02_008: [ For every scalar value JSONDecoder_JSON_To_Events shall call onValue passing the member name and the value as it appears in the JSON. ]*/
+/*Tests_SRS_JSON_DECODER_02_010: [ For array elements the name reported to the callbacks shall be the string representation of the array index. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_reports_nested_objects_and_arrays)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{ \"a\" : 1, \"s\":\"x y\", \"o\":{\"p\":[true, {\"q\":null}]} }";
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &recordEvents, NULL);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr,
+        "value a=1\n"
+        "value s=\"x y\"\n"
+        "begin o\n"
+        "begin p\n"
+        "value 0=true\n"
+        "begin 1\n"
+        "value q=null\n"
+        "end 1\n"
+        "end p\n"
+        "end o\n", recordedEvents.c_str());
+}
+
+/*Tests_SRS_JSON_DECODER_02_006: [ If onBeginObject returns JSON_DECODER_EVENT_SKIP_CHILDREN then JSONDecoder_JSON_To_Events shall validate the children without reporting them and without reporting the matching onEndObject. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_skips_children_when_asked)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{\"reported\":{\"a\":{\"b\":[1,2]}},\"desired\":{\"c\":2}}";
+    skipObjectName = "reported";
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &recordEvents, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr,
+        "begin reported\n"
+        "begin desired\n"
+        "value c=2\n"
+        "end desired\n", recordedEvents.c_str());
+}
+
+/*Tests_SRS_JSON_DECODER_02_006: [ If onBeginObject returns JSON_DECODER_EVENT_SKIP_CHILDREN then JSONDecoder_JSON_To_Events shall validate the children without reporting them and without reporting the matching onEndObject. ]*/
+/*Tests_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_validates_skipped_children)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{\"reported\":{\"a\":[1,}}";
+    skipObjectName = "reported";
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &recordEvents, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
+/*Tests_SRS_JSON_DECODER_02_009: [ If any callback returns JSON_DECODER_EVENT_ABORT then JSONDecoder_JSON_To_Events shall stop and return JSON_DECODER_ABORTED. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_stops_when_a_callback_aborts)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{\"a\":1,\"b\":2,\"c\":3}";
+    abortOnName = "b";
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &recordEvents, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_ABORTED, result);
+    ASSERT_ARE_EQUAL(char_ptr,
+        "value a=1\n"
+        "value b=2\n", recordedEvents.c_str());
+}
+
+/*Tests_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_with_trailing_characters_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "{\"a\":1} x";
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &recordEvents, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
+/*Tests_SRS_JSON_DECODER_02_004: [ If parsing the JSON fails due to the JSON string being malformed, JSONDecoder_JSON_To_Events shall return JSON_DECODER_PARSE_ERROR. ]*/
+TEST_FUNCTION(JSONDecoder_JSON_To_Events_with_empty_string_fails)
+{
+    ///arrange
+    CJSONDecoderMocks mocks;
+    char json[] = "";
+
+    ///act
+    JSON_DECODER_RESULT result = JSONDecoder_JSON_To_Events(json, &recordEvents, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(JSON_DECODER_RESULT_TAG, JSON_DECODER_PARSE_ERROR, result);
+}
+
 END_TEST_SUITE(JSONDecoder_ut)
@@ -82,6 +82,13 @@ void my_gballoc_free(void * t)
 #include "testrunnerswitcher.h"
 #include "schema.h"
 
+/*defined by schema.c, built with SCHEMA_COUNT_NAME_COMPARISONS*/
+#ifdef __cplusplus
+extern "C" size_t schema_name_comparison_count;
+#else
+extern size_t schema_name_comparison_count;
+#endif
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -478,6 +485,9 @@ BEGIN_TEST_SUITE(Schema_ut)
 
     void Schema_CreateModelType_With_Valid_Arguments_inert_path(void)
     {
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is the name index of the models*/
+            .IgnoreArgument_size();
+
         STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
             .IgnoreArgument_ptr()
             .IgnoreArgument_size();
@@ -1209,6 +1219,39 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    TEST_FUNCTION(Schema_GetModelByName_does_not_compare_every_model_name)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE lastModel = NULL;
+        char modelName[32];
+        for (size_t i = 0; i < 100; i++)
+        {
+            (void)sprintf(modelName, "ModelName%zu", i);
+            lastModel = Schema_CreateModelType(schemaHandle, modelName);
+        }
+        for (size_t i = 0; i < 100; i++)
+        {
+            (void)sprintf(modelName, "Property%zu", i);
+            (void)Schema_AddModelProperty(lastModel, modelName, "int");
+        }
+        size_t comparisonsBefore = schema_name_comparison_count;
+
+        // act
+        SCHEMA_MODEL_TYPE_HANDLE result = Schema_GetModelByName(schemaHandle, "ModelName99");
+        SCHEMA_PROPERTY_HANDLE property = Schema_GetModelPropertyByName(lastModel, "Property99");
+        SCHEMA_MODEL_TYPE_HANDLE notFound = Schema_GetModelByName(schemaHandle, "ModelName100");
+
+        // assert
+        ASSERT_ARE_EQUAL(void_ptr, lastModel, result);
+        ASSERT_IS_NOT_NULL(property);
+        ASSERT_IS_NULL(notFound);
+        ASSERT_IS_TRUE(schema_name_comparison_count - comparisonsBefore <= 3);
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
     /* Schema_GetModelByIndex */
 
     /* Tests_SRS_SCHEMA_99_128: [Schema_GetModelByIndex shall return NULL if the index specified is outside the valid range or if schemaHandle argument is NULL.] */
@@ -4093,10 +4136,6 @@ BEGIN_TEST_SUITE(Schema_ut)
         
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, reportedPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_RESULT result = Schema_AddModelReportedProperty(modelType, reportedPropertyName, "int"); /*added the second time*/
 
@@ -4110,9 +4149,8 @@ BEGIN_TEST_SUITE(Schema_ut)
 
     void Schema_AddModelReportedProperty_inert_path(const char* reportedPropertyName, const char* reportedPropertyType)
     {
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, reportedPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is the name index of the reported properties*/
+            .IgnoreArgument_size();
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
         STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, reportedPropertyName))
@@ -4162,35 +4200,19 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_AddModelReportedProperty_inert_path(reportedPropertyName, reportedPropertyType);
         umock_c_negative_tests_snapshot();
 
-        size_t calls_that_cannot_fail[] =
-        {
-            0 /*VECTOR_find_if*/
-        };
-
         for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
-            size_t j;
             umock_c_negative_tests_reset();
 
-            for (j = 0;j<sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++) /*not running the tests that cannot fail*/
-            {
-                if (calls_that_cannot_fail[j] == i)
-                    break;
-            }
-
-            if (j == sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
-            {
-
-                umock_c_negative_tests_fail_call(i);
-                char temp_str[128];
-                sprintf(temp_str, "On failed call %zu", i);
+            umock_c_negative_tests_fail_call(i);
+            char temp_str[128];
+            sprintf(temp_str, "On failed call %zu", i);
 
-                ///act
-                SCHEMA_RESULT result = Schema_AddModelReportedProperty(modelType, reportedPropertyName, reportedPropertyType);
+            ///act
+            SCHEMA_RESULT result = Schema_AddModelReportedProperty(modelType, reportedPropertyName, reportedPropertyType);
 
-                ///assert
-                ASSERT_ARE_EQUAL_WITH_MSG(SCHEMA_RESULT, SCHEMA_ERROR, result, temp_str);
-            }
+            ///assert
+            ASSERT_ARE_EQUAL_WITH_MSG(SCHEMA_RESULT, SCHEMA_ERROR, result, temp_str);
         }
 
         ///clean
@@ -4320,9 +4342,8 @@ BEGIN_TEST_SUITE(Schema_ut)
         (void)Schema_AddModelReportedProperty(modelType, "a", "b");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
+        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
+            .IgnoreArgument_handle();
 
         ///act
         SCHEMA_REPORTED_PROPERTY_HANDLE result = Schema_GetModelReportedPropertyByName(modelType, "a");
@@ -4343,10 +4364,6 @@ BEGIN_TEST_SUITE(Schema_ut)
         (void)Schema_AddModelReportedProperty(modelType, "a", "b");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_REPORTED_PROPERTY_HANDLE result = Schema_GetModelReportedPropertyByName(modelType, "it_wasn_t_me");
 
@@ -4689,9 +4706,8 @@ BEGIN_TEST_SUITE(Schema_ut)
     static void Schema_AddModelDesiredProperty_inert_path(const char* desiredPropertyName, const char* desiredPropertyType)
     {
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is the name index of the desired properties*/
+            .IgnoreArgument_size();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
@@ -4747,35 +4763,19 @@ BEGIN_TEST_SUITE(Schema_ut)
 
         umock_c_negative_tests_snapshot();
 
-        size_t calls_that_cannot_fail[] =
-        {
-            0 /*VECTOR_find_if*/
-        };
-
         for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
-            size_t j;
             umock_c_negative_tests_reset();
 
-            for (j = 0;j<sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++) /*not running the tests that cannot fail*/
-            {
-                if (calls_that_cannot_fail[j] == i)
-                    break;
-            }
-
-            if (j == sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
-            {
-
-                umock_c_negative_tests_fail_call(i);
-                char temp_str[128];
-                sprintf(temp_str, "On failed call %zu", i);
+            umock_c_negative_tests_fail_call(i);
+            char temp_str[128];
+            sprintf(temp_str, "On failed call %zu", i);
 
-                ///act
-                SCHEMA_RESULT result = Schema_AddModelDesiredProperty(modelType, desiredPropertyName, desiredPropertyType, g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
+            ///act
+            SCHEMA_RESULT result = Schema_AddModelDesiredProperty(modelType, desiredPropertyName, desiredPropertyType, g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
 
-                ///assert
-                ASSERT_ARE_EQUAL_WITH_MSG(SCHEMA_RESULT, SCHEMA_ERROR, result, temp_str);
-            }
+            ///assert
+            ASSERT_ARE_EQUAL_WITH_MSG(SCHEMA_RESULT, SCHEMA_ERROR, result, temp_str);
         }
 
         ///clean
@@ -4794,11 +4794,6 @@ BEGIN_TEST_SUITE(Schema_ut)
         (void)Schema_AddModelDesiredProperty(modelType, name, type, g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
         umock_c_reset_all_calls();
 
-
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, name))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_RESULT result = Schema_AddModelDesiredProperty(modelType, name, type, g_pfDesiredPropertyFromAGENT_DATA_TYPE, g_pfDesiredPropertyInitialize, g_pfDesiredPropertyDeinitialize, 0, NULL);
 
@@ -4964,10 +4959,6 @@ BEGIN_TEST_SUITE(Schema_ut)
         umock_c_reset_all_calls();
         const char* desiredPropertyName = "a";
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, desiredPropertyName); /*doesn't exist because no desired properties*/
 
@@ -4989,10 +4980,6 @@ BEGIN_TEST_SUITE(Schema_ut)
         umock_c_reset_all_calls();
         const char* desiredPropertyName = "c"; /*only "a" exists*/
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
-
         ///act
         SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, desiredPropertyName);
 
@@ -5014,9 +5001,8 @@ BEGIN_TEST_SUITE(Schema_ut)
         umock_c_reset_all_calls();
         const char* desiredPropertyName = "a"; /*only "a" exists*/
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, desiredPropertyName))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred();
+        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
+            .IgnoreArgument_handle();
 
         ///act
         SCHEMA_DESIRED_PROPERTY_HANDLE result = Schema_GetModelDesiredPropertyByName(modelType, desiredPropertyName);
@@ -5953,11 +5939,6 @@ BEGIN_TEST_SUITE(Schema_ut)
         (void)Schema_CreateModelMethod(model, "method");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred()
-            .IgnoreArgument_value();
-
         ///act
         SCHEMA_METHOD_HANDLE methodHandle = Schema_CreateModelMethod(model, "method");
 
@@ -5971,10 +5952,8 @@ BEGIN_TEST_SUITE(Schema_ut)
 
     static void Schema_CreateModelMethod_inert_path(void)
     {
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred()
-            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is the name index of the methods*/
+            .IgnoreArgument_size();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
@@ -6027,19 +6006,14 @@ BEGIN_TEST_SUITE(Schema_ut)
 
         for (size_t i = 0;i < umock_c_negative_tests_call_count(); i++)
         {
-            if (
-                (i != 0)
-                )
-            {
-                umock_c_negative_tests_reset();
-                umock_c_negative_tests_fail_call(i);
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(i);
 
-                ///act
-                SCHEMA_METHOD_HANDLE methodHandle = Schema_CreateModelMethod(model, "method");
+            ///act
+            SCHEMA_METHOD_HANDLE methodHandle = Schema_CreateModelMethod(model, "method");
 
-                ///assert
-                ASSERT_IS_NULL(methodHandle);
-            }
+            ///assert
+            ASSERT_IS_NULL(methodHandle);
         }
 
         ///cleanup
@@ -6246,10 +6220,8 @@ BEGIN_TEST_SUITE(Schema_ut)
 
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred()
-            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
+            .IgnoreArgument_handle();
 
         ///act
         SCHEMA_METHOD_HANDLE methodHandle = Schema_GetModelMethodByName(model, "method");
@@ -6272,11 +6244,6 @@ BEGIN_TEST_SUITE(Schema_ut)
 
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_find_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_pred()
-            .IgnoreArgument_value();
-
         ///act
         SCHEMA_METHOD_HANDLE methodHandle = Schema_GetModelMethodByName(model, "NO WAY THIS EXISTS!");
 
@@ -366,6 +366,12 @@ public:
     MOCK_STATIC_METHOD_1(, void, DataMarshaller_SetMaxBufferSize, size_t, bytes)
     MOCK_VOID_METHOD_END()
 
+    MOCK_STATIC_METHOD_1(, void, DataMarshaller_SetDefaultEncoder, const DATA_MARSHALLER_ENCODER*, encoder)
+    MOCK_VOID_METHOD_END()
+
+    MOCK_STATIC_METHOD_1(, void, DataMarshaller_SetDefaultKeyDictionary, const DATA_MARSHALLER_KEY_DICTIONARY*, keyDictionary)
+    MOCK_VOID_METHOD_END()
+
     /* DataPublisher mocks */
     MOCK_STATIC_METHOD_1(, void, DataPublisher_SetMaxBufferSize, size_t, bytes)
     MOCK_VOID_METHOD_END()
@@ -403,6 +409,8 @@ DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubSchemaClientMocks, , AGENT_DATA_TYPES_RESULT
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubSchemaClientMocks, , AGENT_DATA_TYPES_RESULT, Create_AGENT_DATA_TYPE_from_EDM_BINARY, AGENT_DATA_TYPE*, agentData, EDM_BINARY, v);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubSchemaClientMocks, , void, BufferProcess_SetRetryInterval, uint64_t, milliseconds);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubSchemaClientMocks, , void, DataMarshaller_SetMaxBufferSize, size_t, bytes);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubSchemaClientMocks, , void, DataMarshaller_SetDefaultEncoder, const DATA_MARSHALLER_ENCODER*, encoder);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubSchemaClientMocks, , void, DataMarshaller_SetDefaultKeyDictionary, const DATA_MARSHALLER_KEY_DICTIONARY*, keyDictionary);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubSchemaClientMocks, , void, DataPublisher_SetMaxBufferSize, size_t, bytes);
 
 DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubSchemaClientMocks, , int, mallocAndStrcpy_s, char**, destination, const char*, source);
@@ -646,4 +654,37 @@ BEGIN_TEST_SUITE(serializer_ut)
             ASSERT_ARE_EQUAL(SERIALIZER_RESULT, SERIALIZER_OK, result);
         }
 
+        /* Tests_SRS_SCHEMALIB_02_001: [ When the which argument is SerializeEncoder, serializer_setconfig shall invoke DataMarshaller_SetDefaultEncoder with the value argument, and shall return SERIALIZER_OK. ] */
+        TEST_FUNCTION(serializer_setconfig_passes_the_encoder_to_the_data_marshaller)
+        {
+            // arrange
+            CNiceCallComparer<CIoTHubSchemaClientMocks> mocks;
+            DATA_MARSHALLER_ENCODER encoder = { "application/cbor", NULL, NULL };
+
+            STRICT_EXPECTED_CALL(mocks, DataMarshaller_SetDefaultEncoder(&encoder));
+
+            // act
+            SERIALIZER_RESULT result = serializer_setconfig(SerializeEncoder, &encoder);
+
+            // assert
+            ASSERT_ARE_EQUAL(SERIALIZER_RESULT, SERIALIZER_OK, result);
+        }
+
+        /* Tests_SRS_SCHEMALIB_02_002: [ When the which argument is SerializeKeyDictionary, serializer_setconfig shall invoke DataMarshaller_SetDefaultKeyDictionary with the value argument, and shall return SERIALIZER_OK. ] */
+        TEST_FUNCTION(serializer_setconfig_passes_the_key_dictionary_to_the_data_marshaller)
+        {
+            // arrange
+            CNiceCallComparer<CIoTHubSchemaClientMocks> mocks;
+            const char* keys[] = { "Temperature", "Humidity" };
+            DATA_MARSHALLER_KEY_DICTIONARY keyDictionary = { keys, 2 };
+
+            STRICT_EXPECTED_CALL(mocks, DataMarshaller_SetDefaultKeyDictionary(&keyDictionary));
+
+            // act
+            SERIALIZER_RESULT result = serializer_setconfig(SerializeKeyDictionary, &keyDictionary);
+
+            // assert
+            ASSERT_ARE_EQUAL(SERIALIZER_RESULT, SERIALIZER_OK, result);
+        }
+
 END_TEST_SUITE(serializer_ut)
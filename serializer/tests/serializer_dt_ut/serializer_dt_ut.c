@@ -52,6 +52,7 @@ static void my_gballoc_free(void* s)
 #include "iothub_client.h"
 #include "iothub_client_ll.h"
 #include "azure_c_shared_utility/vector.h"
+#include "azure_c_shared_utility/lock.h"
 #include "parson.h"
 #ifdef __cplusplus
 extern "C"
@@ -168,6 +169,7 @@ MOCKABLE_FUNCTION(, void, on_desired_property_double15, void*, v);
 #define TEST_JSON_OBJECT_GET_VALUE ((JSON_Value *)0xEF)
 #define TEST_JSON_SERIALIZE_TO_STRING ((char*)("a"))
 #define TEST_METHODRETURN_HANDLE ((METHODRETURN_HANDLE)0x555)
+#define TEST_LOCK_HANDLE ((LOCK_HANDLE)0x556)
 
 ///poor version of mocking
 static CODEFIRST_RESULT  g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_OK;
@@ -196,6 +198,25 @@ CODEFIRST_RESULT CodeFirst_SendAsyncReported(unsigned char** destination, size_t
     }
     return result;
 }
+static bool g_CodeFirst_SendAsyncReportedDelta_isUnchanged;
+static CODEFIRST_RESULT my_CodeFirst_SendAsyncReportedDelta(unsigned char** destination, size_t* destinationSize, void* device)
+{
+    (void)device;
+    if (g_CodeFirst_SendAsyncReportedDelta_isUnchanged)
+    {
+        *destination = NULL;
+        *destinationSize = 0;
+    }
+    else
+    {
+        *destination = (unsigned char*)my_gballoc_malloc(2);
+        (*destination)[0] = (unsigned char)'3';
+        (*destination)[1] = '\0';
+        *destinationSize = 2;
+    }
+    return CODEFIRST_OK;
+}
+
 static IOTHUB_CLIENT_RESULT my_IoTHubClient_SetDeviceTwinCallback(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK deviceTwinCallback, void* userContextCallback)
 {
     (void)iotHubClientHandle;
@@ -222,10 +243,14 @@ static char* my_json_serialize_to_string(const JSON_Value *value)
 }
 
 /*callback called by the devicet win to indicate a succesful transmission of reported state*/
+static size_t g_reportedStateCallback_calls;
+static int g_reportedStateCallback_status_code;
+static void* g_reportedStateCallback_context;
 static void reportedStateCallback(int status_code, void* userContextCallback)
 {
-    (void)status_code;
-    (void)userContextCallback;
+    g_reportedStateCallback_calls++;
+    g_reportedStateCallback_status_code = status_code;
+    g_reportedStateCallback_context = userContextCallback;
 }
 
 static const METHODRETURN_DATA data1 = { 10, NULL };
@@ -260,6 +285,11 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_REPORTED_STATE_CALLBACK, void*);
         
         REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+        REGISTER_UMOCK_ALIAS_TYPE(CODEFIRST_RESULT, int);
+        REGISTER_UMOCK_ALIAS_TYPE(unsigned char**, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(size_t*, void*);
         
         REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_SetDeviceTwinCallback, my_IoTHubClient_SetDeviceTwinCallback);
         REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_SetDeviceTwinCallback, my_IoTHubClient_LL_SetDeviceTwinCallback);
@@ -270,6 +300,13 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_CreateDevice, TEST_DEVICE_HANDLE, NULL);
         REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_IngestDesiredProperties, CODEFIRST_OK, CODEFIRST_ERROR);
         REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_ExecuteMethod, TEST_METHODRETURN_HANDLE, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(CodeFirst_SendAsyncReportedDelta, my_CodeFirst_SendAsyncReportedDelta);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(CodeFirst_SendAsyncReportedDelta, CODEFIRST_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_CompleteReportedDelta, CODEFIRST_OK, CODEFIRST_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock_Init, TEST_LOCK_HANDLE, NULL);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock_Deinit, LOCK_OK, LOCK_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock, LOCK_OK, LOCK_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURNS(Unlock, LOCK_OK, LOCK_ERROR);
         REGISTER_GLOBAL_MOCK_RETURNS(IoTHubClient_SendReportedState, IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR);
         REGISTER_GLOBAL_MOCK_RETURNS(IoTHubClient_LL_SendReportedState, IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR);
         
@@ -329,6 +366,10 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
 
         umock_c_reset_all_calls();
 
+        g_CodeFirst_SendAsyncReportedDelta_isUnchanged = false;
+        g_reportedStateCallback_calls = 0;
+        g_reportedStateCallback_status_code = 0;
+        g_reportedStateCallback_context = NULL;
     }
 
     TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -342,6 +383,9 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         STRICT_EXPECTED_CALL(Schema_GetMetadata(TEST_SCHEMA_HANDLE));
         STRICT_EXPECTED_CALL(Schema_GetModelByName(TEST_SCHEMA_HANDLE, "basicModel_WithData15"));
         STRICT_EXPECTED_CALL(CodeFirst_CreateDevice(TEST_SCHEMA_MODEL_TYPE_HANDLE, &ALL_REFLECTED(basic15), sizeof(basicModel_WithData15), true));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(SERIALIZER_DEVICETWIN_REPORTED_STATE)));
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(VECTOR_create(sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK)));
         STRICT_EXPECTED_CALL(IoTHubClient_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_HANDLE, serializer_ingest, TEST_DEVICE_HANDLE));
         STRICT_EXPECTED_CALL(IoTHubClient_SetDeviceMethodCallback(TEST_IOTHUB_CLIENT_HANDLE, deviceMethodCallback, TEST_DEVICE_HANDLE));
         STRICT_EXPECTED_CALL(VECTOR_create(sizeof(SERIALIZER_DEVICETWIN_PROTOHANDLE)));
@@ -355,6 +399,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_010: [ IoTHubDeviceTwinCreate_Impl shall call CodeFirst_CreateDevice. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_011: [ IoTHubDeviceTwinCreate_Impl shall set the device twin callback. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_027: [ IoTHubDeviceTwinCreate_Impl shall set the device method callback ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_034: [ IoTHubDeviceTwinCreate_Impl shall create the state used to coalesce the reported state updates of the device. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_012: [ IoTHubDeviceTwinCreate_Impl shall record the pair of (device, IoTHubClient(_LL)). ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_013: [ If all operations complete successfully then IoTHubDeviceTwinCreate_Impl shall succeeds and return a non-NULL value. ]*/
     TEST_FUNCTION(IoTHubDeviceTwin_CreatebasicModel_WithData15_happy_path)
@@ -420,6 +465,9 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         STRICT_EXPECTED_CALL(Schema_GetMetadata(TEST_SCHEMA_HANDLE));
         STRICT_EXPECTED_CALL(Schema_GetModelByName(TEST_SCHEMA_HANDLE, "basicModel_WithData15"));
         STRICT_EXPECTED_CALL(CodeFirst_CreateDevice(TEST_SCHEMA_MODEL_TYPE_HANDLE, &ALL_REFLECTED(basic15), sizeof(basicModel_WithData15), true));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(SERIALIZER_DEVICETWIN_REPORTED_STATE)));
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(VECTOR_create(sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK)));
         STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_LL_HANDLE, serializer_ingest, TEST_DEVICE_HANDLE));
         STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceMethodCallback(TEST_IOTHUB_CLIENT_LL_HANDLE, deviceMethodCallback, TEST_DEVICE_HANDLE));
         STRICT_EXPECTED_CALL(VECTOR_create(sizeof(SERIALIZER_DEVICETWIN_PROTOHANDLE)));
@@ -433,6 +481,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_010: [ IoTHubDeviceTwinCreate_Impl shall call CodeFirst_CreateDevice. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_011: [ IoTHubDeviceTwinCreate_Impl shall set the device twin callback. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_027: [ IoTHubDeviceTwinCreate_Impl shall set the device method callback ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_034: [ IoTHubDeviceTwinCreate_Impl shall create the state used to coalesce the reported state updates of the device. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_012: [ IoTHubDeviceTwinCreate_Impl shall record the pair of (device, IoTHubClient(_LL)). ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_013: [ If all operations complete successfully then IoTHubDeviceTwinCreate_Impl shall succeeds and return a non-NULL value. ]*/
     TEST_FUNCTION(IoTHubDeviceTwin_LL_CreatebasicModel_WithData15_happy_path)
@@ -640,6 +689,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
 
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_015: [ IoTHubDeviceTwin_Destroy_Impl shall locate the saved handle belonging to model. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_016: [ IoTHubDeviceTwin_Destroy_Impl shall set the devicetwin callback to NULL. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_040: [ IoTHubDeviceTwin_Destroy_Impl shall free the reported state coalescing state, unless a PATCH is in flight, in which case it shall be freed when the PATCH is acknowledged. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_017: [ IoTHubDeviceTwin_Destroy_Impl shall call CodeFirst_DestroyDevice. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_018: [ IoTHubDeviceTwin_Destroy_Impl shall remove the IoTHubClient_Handle and the device handle from the recorded set. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_019: [ If the recorded set of IoTHubClient handles is zero size, then the set shall be destroyed. ]*/
@@ -654,6 +704,13 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         STRICT_EXPECTED_CALL(VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model));
         STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_LL_HANDLE, NULL, NULL));
         STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceMethodCallback(TEST_IOTHUB_CLIENT_LL_HANDLE, NULL, NULL));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
         STRICT_EXPECTED_CALL(CodeFirst_DestroyDevice(model));
         STRICT_EXPECTED_CALL(VECTOR_erase(g_allProtoHandles, IGNORED_PTR_ARG, 1))
             .IgnoreArgument_elements();
@@ -673,6 +730,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_015: [ IoTHubDeviceTwin_Destroy_Impl shall locate the saved handle belonging to model. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_016: [ IoTHubDeviceTwin_Destroy_Impl shall set the devicetwin callback to NULL. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_028: [ IoTHubDeviceTwin_Destroy_Impl shall set the method callback to NULL. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_040: [ IoTHubDeviceTwin_Destroy_Impl shall free the reported state coalescing state, unless a PATCH is in flight, in which case it shall be freed when the PATCH is acknowledged. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_017: [ IoTHubDeviceTwin_Destroy_Impl shall call CodeFirst_DestroyDevice. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_018: [ IoTHubDeviceTwin_Destroy_Impl shall remove the IoTHubClient_Handle and the device handle from the recorded set. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_019: [ If the recorded set of IoTHubClient handles is zero size, then the set shall be destroyed. ]*/
@@ -687,6 +745,13 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         STRICT_EXPECTED_CALL(VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model));
         STRICT_EXPECTED_CALL(IoTHubClient_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_HANDLE, NULL, NULL));
         STRICT_EXPECTED_CALL(IoTHubClient_SetDeviceMethodCallback(TEST_IOTHUB_CLIENT_HANDLE, NULL, NULL));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
         STRICT_EXPECTED_CALL(CodeFirst_DestroyDevice(model));
         STRICT_EXPECTED_CALL(VECTOR_erase(g_allProtoHandles, IGNORED_PTR_ARG, 1))
             .IgnoreArgument_elements();
@@ -791,17 +856,25 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
 
     static void IoTHubDeviceTwin_SendReportedState_Impl_inert_path(void* model)
     {
-        //STRICT_EXPECTED_CALL(CodeFirst_SendAsyncReported) - this function cannot be mocked because it has ... arguments, therefore the poor version mock is used
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2));
         STRICT_EXPECTED_CALL(VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model));
-        STRICT_EXPECTED_CALL(IoTHubClient_SendReportedState(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, 2, reportedStateCallback, (void*)1))
-            .IgnoreArgument_reportedState();
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(CodeFirst_SendAsyncReportedDelta(IGNORED_PTR_ARG, IGNORED_PTR_ARG, model))
+            .IgnoreArgument_destination()
+            .IgnoreArgument_destinationSize();
+        STRICT_EXPECTED_CALL(IoTHubClient_SendReportedState(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, 2, serializer_reportedStateCallback, IGNORED_PTR_ARG))
+            .IgnoreArgument_reportedState()
+            .IgnoreArgument_userContextCallback();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument_ptr();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
     }
 
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_029: [ IoTHubDeviceTwin_SendReportedState_Impl shall call CodeFirst_SendAsyncReported. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_029: [ IoTHubDeviceTwin_SendReportedState_Impl shall call CodeFirst_SendAsyncReportedDelta. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_030: [ IoTHubDeviceTwin_SendReportedState_Impl shall find model in the list of devices. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_031: [ IoTHubDeviceTwin_SendReportedState_Impl shall use IoTHubClient_SendReportedState/IoTHubClient_LL_SendReportedState to send the serialized reported state. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_032: [ IoTHubDeviceTwin_SendReportedState_Impl shall succeed and return IOTHUB_CLIENT_OK when all operations complete successfully. ]*/
@@ -809,12 +882,10 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
     {
         ///arrange
         (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
-        IoTHubDeviceTwin_CreatebasicModel_WithData15_inertPath();
         basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
         umock_c_reset_all_calls();
 
-        g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_OK;
-
         IoTHubDeviceTwin_SendReportedState_Impl_inert_path(model);
 
         ///act
@@ -823,36 +894,35 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
         ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, r);
+        ASSERT_ARE_EQUAL(size_t, 0, g_reportedStateCallback_calls);
 
         ///clean
+        serializer_reportedStateCallback(200, reportedState);
         IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
     }
 
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-    TEST_FUNCTION(IoTHubDeviceTwin_SendReportedState_Impl_unhappy_paths_1)
+    TEST_FUNCTION(IoTHubDeviceTwin_SendReportedState_Impl_unhappy_paths)
     {
         ///arrange
         (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
-        IoTHubDeviceTwin_CreatebasicModel_WithData15_inertPath();
         basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
         umock_c_reset_all_calls();
         umock_c_negative_tests_init();
 
-        g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_OK;
-
         IoTHubDeviceTwin_SendReportedState_Impl_inert_path(model);
 
         umock_c_negative_tests_snapshot();
 
-        umock_c_negative_tests_snapshot();
-
         for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
             umock_c_negative_tests_reset();
             umock_c_negative_tests_fail_call(i);
 
             if (
-                (i != 3) /*gballoc_free*/
+                (i != 5) && /*VECTOR_size*/
+                (i != 6) && /*gballoc_free*/
+                (i != 7) /*Unlock*/
                 )
             {
                 ///act
@@ -862,30 +932,6 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
                 ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, r);
             }
         }
-        
-
-        ///clean
-        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
-        umock_c_negative_tests_deinit();
-    }
-
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-    TEST_FUNCTION(IoTHubDeviceTwin_SendReportedState_Impl_unhappy_paths_2) /*this test only exists because CodeFirst_SendAsyncReported does not have a mock from umock_c*/
-    {
-        ///arrange
-        (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
-        IoTHubDeviceTwin_CreatebasicModel_WithData15_inertPath();
-        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
-
-        IoTHubDeviceTwin_SendReportedState_Impl_inert_path(model);
-        g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_ERROR;
-
-        ///act
-        IOTHUB_CLIENT_RESULT r = IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
-
-        ///assert
-        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, r);
-
 
         ///clean
         IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
@@ -894,17 +940,25 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
 
     static void IoTHubDeviceTwin_LL_SendReportedState_Impl_inert_path(void* model)
     {
-        //STRICT_EXPECTED_CALL(CodeFirst_SendAsyncReported) - this function cannot be mocked because it has ... arguments, therefore the poor version mock is used
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2));
         STRICT_EXPECTED_CALL(VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model));
-        STRICT_EXPECTED_CALL(IoTHubClient_LL_SendReportedState(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, 2, reportedStateCallback, (void*)1))
-            .IgnoreArgument_reportedState();
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(CodeFirst_SendAsyncReportedDelta(IGNORED_PTR_ARG, IGNORED_PTR_ARG, model))
+            .IgnoreArgument_destination()
+            .IgnoreArgument_destinationSize();
+        STRICT_EXPECTED_CALL(IoTHubClient_LL_SendReportedState(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, 2, serializer_reportedStateCallback, IGNORED_PTR_ARG))
+            .IgnoreArgument_reportedState()
+            .IgnoreArgument_userContextCallback();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument_ptr();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
     }
 
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_029: [ IoTHubDeviceTwin_SendReportedState_Impl shall call CodeFirst_SendAsyncReported. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_029: [ IoTHubDeviceTwin_SendReportedState_Impl shall call CodeFirst_SendAsyncReportedDelta. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_030: [ IoTHubDeviceTwin_SendReportedState_Impl shall find model in the list of devices. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_031: [ IoTHubDeviceTwin_SendReportedState_Impl shall use IoTHubClient_SendReportedState/IoTHubClient_LL_SendReportedState to send the serialized reported state. ]*/
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_032: [ IoTHubDeviceTwin_SendReportedState_Impl shall succeed and return IOTHUB_CLIENT_OK when all operations complete successfully. ]*/
@@ -912,12 +966,10 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
     {
         ///arrange
         (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
-        IoTHubDeviceTwin_CreatebasicModel_WithData15_inertPath();
         basicModel_WithData15* model = IoTHubDeviceTwin_LL_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_LL_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
         umock_c_reset_all_calls();
 
-        g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_OK;
-
         IoTHubDeviceTwin_LL_SendReportedState_Impl_inert_path(model);
 
         ///act
@@ -926,36 +978,35 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
         ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, r);
+        ASSERT_ARE_EQUAL(size_t, 0, g_reportedStateCallback_calls);
 
         ///clean
+        serializer_reportedStateCallback(200, reportedState);
         IoTHubDeviceTwin_LL_DestroybasicModel_WithData15(model);
     }
 
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-    TEST_FUNCTION(IoTHubDeviceTwin_LL_SendReportedState_Impl_unhappy_paths_1)
+    TEST_FUNCTION(IoTHubDeviceTwin_LL_SendReportedState_Impl_unhappy_paths)
     {
         ///arrange
         (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
-        IoTHubDeviceTwin_CreatebasicModel_WithData15_inertPath();
         basicModel_WithData15* model = IoTHubDeviceTwin_LL_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_LL_HANDLE);
         umock_c_reset_all_calls();
         umock_c_negative_tests_init();
 
-        g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_OK;
-
         IoTHubDeviceTwin_LL_SendReportedState_Impl_inert_path(model);
 
         umock_c_negative_tests_snapshot();
 
-        umock_c_negative_tests_snapshot();
-
         for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
             umock_c_negative_tests_reset();
             umock_c_negative_tests_fail_call(i);
 
             if (
-                (i != 3) /*gballoc_free*/
+                (i != 5) && /*VECTOR_size*/
+                (i != 6) && /*gballoc_free*/
+                (i != 7) /*Unlock*/
                 )
             {
                 ///act
@@ -966,35 +1017,242 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
             }
         }
 
-
         ///clean
         IoTHubDeviceTwin_LL_DestroybasicModel_WithData15(model);
         umock_c_negative_tests_deinit();
     }
 
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_033: [ Otherwise, IoTHubDeviceTwin_SendReportedState_Impl shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-    TEST_FUNCTION(IoTHubDeviceTwin_LL_SendReportedState_Impl_unhappy_paths_2) /*this test only exists because CodeFirst_SendAsyncReported does not have a mock from umock_c*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_035: [ If no reported property changed since the last acknowledged PATCH then IoTHubDeviceTwin_SendReportedState_Impl shall not send anything, shall call deviceTwinCallback with status 204 and return IOTHUB_CLIENT_OK. ]*/
+    TEST_FUNCTION(IoTHubDeviceTwin_SendReportedState_Impl_with_unchanged_reported_state_calls_back_with_204)
     {
         ///arrange
         (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
-        IoTHubDeviceTwin_CreatebasicModel_WithData15_inertPath();
-        basicModel_WithData15* model = IoTHubDeviceTwin_LL_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_LL_HANDLE);
+        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        umock_c_reset_all_calls();
 
-        IoTHubDeviceTwin_LL_SendReportedState_Impl_inert_path(model);
-        g_CodeFirst_SendAsyncReported_shall_return = CODEFIRST_ERROR;
+        g_CodeFirst_SendAsyncReportedDelta_isUnchanged = true;
+        STRICT_EXPECTED_CALL(VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(CodeFirst_SendAsyncReportedDelta(IGNORED_PTR_ARG, IGNORED_PTR_ARG, model))
+            .IgnoreArgument_destination()
+            .IgnoreArgument_destinationSize();
+        STRICT_EXPECTED_CALL(VECTOR_back(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_erase(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
 
         ///act
         IOTHUB_CLIENT_RESULT r = IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
 
         ///assert
-        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, r);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, r);
+        ASSERT_ARE_EQUAL(size_t, 1, g_reportedStateCallback_calls);
+        ASSERT_ARE_EQUAL(int, 204, g_reportedStateCallback_status_code);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)1, g_reportedStateCallback_context);
 
+        ///clean
+        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
+    }
+
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_041: [ If a PATCH is in flight then IoTHubDeviceTwin_SendReportedState_Impl shall only record deviceTwinCallback and context and return IOTHUB_CLIENT_OK; the update is sent in the PATCH that follows the acknowledgement of the one in flight. ]*/
+    TEST_FUNCTION(IoTHubDeviceTwin_SendReportedState_Impl_while_PATCH_in_flight_only_records_the_callback)
+    {
+        ///arrange
+        (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
+        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        IOTHUB_CLIENT_RESULT r1 = IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)2);
+        IOTHUB_CLIENT_RESULT r2 = IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)3);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, r1);
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, r2);
+        ASSERT_ARE_EQUAL(size_t, 0, g_reportedStateCallback_calls);
+        ASSERT_ARE_EQUAL(size_t, 3, real_VECTOR_size(reportedState->callbacks));
 
         ///clean
-        IoTHubDeviceTwin_LL_DestroybasicModel_WithData15(model);
-        umock_c_negative_tests_deinit();
+        serializer_reportedStateCallback(200, reportedState); /*sends the coalesced PATCH*/
+        serializer_reportedStateCallback(200, reportedState);
+        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
     }
 
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_036: [ When the PATCH is acknowledged, serializer_reportedStateCallback shall call CodeFirst_CompleteReportedDelta, which commits the shadow of the reported state only if status_code is 2xx. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_037: [ If updates were requested while the PATCH was in flight, serializer_reportedStateCallback shall send all of them in one new PATCH. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_039: [ serializer_reportedStateCallback shall call the callbacks of all the updates covered by the acknowledged PATCH with status_code, outside of the lock. ]*/
+    TEST_FUNCTION(serializer_reportedStateCallback_sends_the_coalesced_PATCH)
+    {
+        ///arrange
+        (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
+        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)2);
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)3);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK)));
+        STRICT_EXPECTED_CALL(VECTOR_front(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_front(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_erase(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(CodeFirst_CompleteReportedDelta(model, true));
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(CodeFirst_SendAsyncReportedDelta(IGNORED_PTR_ARG, IGNORED_PTR_ARG, model))
+            .IgnoreArgument_destination()
+            .IgnoreArgument_destinationSize();
+        STRICT_EXPECTED_CALL(IoTHubClient_SendReportedState(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, 2, serializer_reportedStateCallback, reportedState))
+            .IgnoreArgument_reportedState();
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        serializer_reportedStateCallback(200, reportedState);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, g_reportedStateCallback_calls);
+        ASSERT_ARE_EQUAL(int, 200, g_reportedStateCallback_status_code);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)1, g_reportedStateCallback_context);
+        ASSERT_IS_TRUE(reportedState->isPatchInFlight);
+        ASSERT_ARE_EQUAL(size_t, 2, reportedState->nCallbacksInFlight);
+
+        ///clean
+        serializer_reportedStateCallback(200, reportedState);
+        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
+    }
+
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_036: [ When the PATCH is acknowledged, serializer_reportedStateCallback shall call CodeFirst_CompleteReportedDelta, which commits the shadow of the reported state only if status_code is 2xx. ]*/
+    TEST_FUNCTION(serializer_reportedStateCallback_with_non_2xx_status_code_does_not_commit_the_shadow)
+    {
+        ///arrange
+        (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
+        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK)));
+        STRICT_EXPECTED_CALL(VECTOR_front(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_front(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_erase(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(CodeFirst_CompleteReportedDelta(model, false));
+        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
 
+        ///act
+        serializer_reportedStateCallback(412, reportedState);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, g_reportedStateCallback_calls);
+        ASSERT_ARE_EQUAL(int, 412, g_reportedStateCallback_status_code);
+        ASSERT_IS_FALSE(reportedState->isPatchInFlight);
+
+        ///clean
+        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
+    }
+
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_038: [ If sending the new PATCH fails then serializer_reportedStateCallback shall call the callbacks of the coalesced updates with status 500. ]*/
+    TEST_FUNCTION(serializer_reportedStateCallback_when_sending_the_coalesced_PATCH_fails_calls_back_with_500)
+    {
+        ///arrange
+        (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
+        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)2);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(IoTHubClient_SendReportedState(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, 2, serializer_reportedStateCallback, reportedState))
+            .IgnoreArgument_reportedState()
+            .SetReturn(IOTHUB_CLIENT_ERROR);
+        STRICT_EXPECTED_CALL(CodeFirst_CompleteReportedDelta(model, false));
+
+        ///act
+        serializer_reportedStateCallback(200, reportedState);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 2, g_reportedStateCallback_calls);
+        ASSERT_ARE_EQUAL(int, 500, g_reportedStateCallback_status_code);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)2, g_reportedStateCallback_context);
+        ASSERT_IS_FALSE(reportedState->isPatchInFlight);
+        ASSERT_ARE_EQUAL(size_t, 0, real_VECTOR_size(reportedState->callbacks));
+
+        ///clean
+        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
+    }
+
+    /*Tests_SRS_SERIALIZERDEVICETWIN_02_040: [ IoTHubDeviceTwin_Destroy_Impl shall free the reported state coalescing state, unless a PATCH is in flight, in which case it shall be freed when the PATCH is acknowledged. ]*/
+    TEST_FUNCTION(serializer_reportedStateCallback_after_destroy_frees_the_reported_state)
+    {
+        ///arrange
+        (void)SERIALIZER_REGISTER_NAMESPACE(basic15);
+        basicModel_WithData15* model = IoTHubDeviceTwin_CreatebasicModel_WithData15(TEST_IOTHUB_CLIENT_HANDLE);
+        SERIALIZER_DEVICETWIN_REPORTED_STATE* reportedState = ((SERIALIZER_DEVICETWIN_PROTOHANDLE*)VECTOR_find_if(g_allProtoHandles, protoHandleHasDeviceStartAddress, model))->reportedState;
+        (void)IoTHubDeviceTwin_SendReportedState_Impl(model, reportedStateCallback, (void*)1);
+        IoTHubDeviceTwin_DestroybasicModel_WithData15(model);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(SERIALIZER_DEVICETWIN_REPORTED_CALLBACK)));
+        STRICT_EXPECTED_CALL(VECTOR_front(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_front(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(VECTOR_erase(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+        STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(reportedState));
+
+        ///act
+        serializer_reportedStateCallback(200, reportedState);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, g_reportedStateCallback_calls);
+
+        ///clean
+    }
 
 END_TEST_SUITE(serializer_dt_ut)